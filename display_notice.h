@@ -0,0 +1,72 @@
+// ============================================
+// VOLT AI Watch - Display Notices
+// A few lines of text on whichever display the board has
+// ============================================
+
+#ifndef DISPLAY_NOTICE_H
+#define DISPLAY_NOTICE_H
+
+// The modules (power_management.h, watchdog.h, ota_update.h) show
+// short notices on the sketch's global `display`: an
+// Adafruit_SSD1306 (restored_code/full_featured.ino) or a TFT_eSPI
+// (the HU-087's ST7789). The two libraries clear, push and power
+// off differently; the overloads below pick the calls from what the
+// display type has, at compile time. No runtime check, and neither
+// library needs the other. Declare `display` before including the
+// modules.
+
+// Clear: clearDisplay() where there is one (SSD1306), else fill
+template <typename D>
+auto noticeClear(D& d, int) -> decltype(d.clearDisplay(), void()) {
+    d.clearDisplay();
+}
+
+template <typename D>
+auto noticeClear(D& d, long) -> decltype(d.fillScreen(0), void()) {
+    d.fillScreen(0);
+}
+
+// Push: a buffered display (SSD1306) sends its buffer; a TFT draws
+// as it goes
+template <typename D>
+auto noticePush(D& d, int) -> decltype(d.display(), void()) {
+    d.display();
+}
+
+template <typename D>
+void noticePush(D&, long) {}
+
+// Panel off: SSD1306 DISPLAYOFF; ST7789 DISPOFF then SLPIN
+template <typename D>
+auto noticeOff(D& d, int) -> decltype(d.ssd1306_command(0xAE), void()) {
+    d.ssd1306_command(0xAE);
+}
+
+template <typename D>
+auto noticeOff(D& d, long) -> decltype(d.writecommand(0x28), void()) {
+    d.writecommand(0x28);
+    d.writecommand(0x10);
+}
+
+// Replaces what is shown with lines, from the top left
+template <typename D>
+void showNotice(D& d, const char* const* lines, int count) {
+    noticeClear(d, 0);
+    d.setCursor(0, 0);
+    for (int i = 0; i < count; i++) {
+        d.println(lines[i]);
+    }
+    noticePush(d, 0);
+}
+
+template <typename D, int N>
+void showNotice(D& d, const char* const (&lines)[N]) {
+    showNotice(d, lines, N);
+}
+
+template <typename D>
+void displayOff(D& d) {
+    noticeOff(d, 0);
+}
+
+#endif // DISPLAY_NOTICE_H
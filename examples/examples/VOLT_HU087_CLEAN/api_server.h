@@ -0,0 +1,839 @@
+/*
+ * ============================================
+ * API Server - Event-Driven HTTP/1.1
+ * ============================================
+ *
+ * Handles:
+ * - One listening socket and a fixed pool of
+ *   connections, all non-blocking, driven by
+ *   poll(): wait for readiness, accept, read,
+ *   dispatch, write what the socket will take
+ * - Keep-alive and pipelined requests
+ * - Five kinds of response body:
+ *   - send(): short text, copied once
+ *   - sendStatic(): a constant, sent straight
+ *     from where it lives (zero copy)
+ *   - stream(): chunked, produced piece by
+ *     piece as the socket drains (JSON lists,
+ *     sample dumps of any length)
+ *   - snapshot(): a Print writer run once into
+ *     a shared preallocated buffer, so one
+ *     consistent copy is sent however slowly
+ *     the client reads
+ *   - events(): a stream that stays open and
+ *     idles until wake() says there is more
+ *     (server-sent events, event_hub.h)
+ * - Limits instead of stalls: a full pool
+ *   answers 503, slow or idle clients are cut
+ *   off, oversized heads get 431
+ * - Counters for GET /api/metrics (metrics.h)
+ *
+ * No String and no allocation per request:
+ * buffers are reserved by begin(). On the ESP32
+ * startTask() runs poll() on its own task, so a
+ * client never holds up loop() and a turn never
+ * holds up a client. Handlers therefore run on
+ * that task: they may only read state that is
+ * safe to read from another core.
+ *
+ * ============================================
+ */
+
+#ifndef API_SERVER_H
+#define API_SERVER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "volt_hal.h"
+#include "metrics.h"
+
+// ============================================
+// REQUESTS AND RESPONSES
+// ============================================
+
+struct ApiRequest {
+    const char* method;
+    const char* path;
+    const char* query;           // After '?', "" if none
+    const char* body;            // Not terminated
+    size_t bodyLength;
+
+    // Query parameter, %-decoded into out. False if absent.
+    bool arg(const char* name, char* out, size_t cap) const {
+        size_t nameLen = strlen(name);
+        const char* p = query;
+        while (*p) {
+            const char* end = strchr(p, '&');
+            if (!end) end = p + strlen(p);
+            const char* eq = (const char*)memchr(p, '=', end - p);
+            size_t keyLen = eq ? (size_t)(eq - p) : (size_t)(end - p);
+            if (keyLen == nameLen && memcmp(p, name, nameLen) == 0) {
+                decode(eq ? eq + 1 : end, end, out, cap);
+                return true;
+            }
+            p = *end ? end + 1 : end;
+        }
+        return false;
+    }
+
+    long argInt(const char* name, long fallback) const {
+        char v[16];
+        if (!arg(name, v, sizeof(v)) || !v[0]) return fallback;
+        return strtol(v, nullptr, 10);
+    }
+
+private:
+    static int hex(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    static void decode(const char* p, const char* end, char* out, size_t cap) {
+        size_t n = 0;
+        while (p < end && n + 1 < cap) {
+            if (*p == '%' && end - p >= 3 && hex(p[1]) >= 0 && hex(p[2]) >= 0) {
+                out[n++] = (char)(hex(p[1]) * 16 + hex(p[2]));
+                p += 3;
+            } else {
+                out[n++] = *p == '+' ? ' ' : *p;
+                p++;
+            }
+        }
+        if (cap) out[n] = '\0';
+    }
+};
+
+// Print into a fixed region; remembers if anything did not fit
+class ApiChunk : public Print {
+private:
+    uint8_t* buf;
+    size_t cap;
+    size_t len;
+    bool over;
+
+public:
+    ApiChunk(uint8_t* b, size_t c) : buf(b), cap(c), len(0), over(false) {}
+
+    size_t write(uint8_t b) override {
+        return write(&b, 1);
+    }
+
+    size_t write(const uint8_t* data, size_t size) override {
+        if (size > cap - len) {
+            over = true;
+            size = cap - len;
+        }
+        memcpy(buf + len, data, size);
+        len += size;
+        return size;
+    }
+
+    size_t length() const { return len; }
+    size_t room() const { return cap - len; }
+    bool overflowed() const { return over; }
+};
+
+// Writes the next pieces of a streamed body while out.room()
+// allows, advancing cursor (0 on the first call). Each piece must
+// fit in ApiServer::STREAM_CHUNK. Returns true when the body is
+// complete.
+typedef bool (*ApiStreamFn)(ApiChunk& out, uint32_t& cursor, void* ctx);
+
+// Writes a whole body at once (snapshot())
+typedef void (*ApiWriterFn)(Print& out, void* ctx);
+
+// Called once when a stream's connection goes away, however it ends
+typedef void (*ApiCloseFn)(uint32_t cursor, void* ctx);
+
+class ApiResponse {
+public:
+    enum Kind {
+        NONE = 0,
+        TEXT,
+        STATIC,
+        STREAM,
+        SNAPSHOT
+    };
+
+    Kind kind;
+    int status;
+    const char* type;
+    char* text;                  // TEXT: copied into the connection's buffer
+    size_t textCap;
+    const uint8_t* body;         // STATIC
+    size_t length;
+    ApiStreamFn streamFn;
+    ApiWriterFn writerFn;
+    ApiCloseFn closeFn;
+    void* ctx;
+    uint32_t cursor;
+    bool longLived;
+
+    // scratch: where send() copies to (set by the server)
+    ApiResponse(char* scratch = nullptr, size_t scratchCap = 0)
+        : kind(NONE), status(500), type("text/plain"), text(scratch), textCap(scratchCap),
+          body(nullptr), length(0), streamFn(nullptr), writerFn(nullptr), closeFn(nullptr),
+          ctx(nullptr), cursor(0), longLived(false) {}
+
+    // Short text (up to ApiServer::TEXT_MAX), copied: a stack
+    // buffer is fine. Longer text answers 500.
+    void send(int code, const char* contentType, const char* t) {
+        size_t len = strlen(t);
+        kind = TEXT;
+        status = code;
+        type = contentType;
+        length = len;
+        if (text && len <= textCap) memcpy(text, t, len);
+    }
+
+    // data must outlive the response (a literal or a constant)
+    void sendStatic(int code, const char* contentType, const void* data, size_t len) {
+        kind = STATIC;
+        status = code;
+        type = contentType;
+        body = (const uint8_t*)data;
+        length = len;
+    }
+
+    void stream(int code, const char* contentType, ApiStreamFn fn, void* c) {
+        kind = STREAM;
+        status = code;
+        type = contentType;
+        streamFn = fn;
+        ctx = c;
+    }
+
+    // text/event-stream that stays open: fn returns false with
+    // nothing written while idle, and is called again after
+    // ApiServer::wake(). The connection closes when fn returns true.
+    void events(ApiStreamFn fn, void* c, uint32_t startCursor, ApiCloseFn onClose) {
+        stream(200, "text/event-stream", fn, c);
+        cursor = startCursor;
+        closeFn = onClose;
+        longLived = true;
+    }
+
+    void snapshot(int code, const char* contentType, ApiWriterFn fn, void* c) {
+        kind = SNAPSHOT;
+        status = code;
+        type = contentType;
+        writerFn = fn;
+        ctx = c;
+    }
+};
+
+typedef void (*ApiHandler)(const ApiRequest& req, ApiResponse& res, void* ctx);
+
+// ============================================
+// SERVER
+// ============================================
+
+class ApiServer {
+public:
+    static const int MAX_CONNECTIONS = 8;
+    static const int MAX_ROUTES = 16;
+    static const size_t IN_SIZE = 1024;         // Request head and body
+    static const size_t OUT_SIZE = 1536;        // Response head + text, or one chunk
+    static const size_t STREAM_CHUNK = 1024;
+    static const size_t TEXT_MAX = 768;
+    static const size_t DEFAULT_SNAPSHOT = 49152;     // A full Chrome trace fits
+    static const size_t SNAPSHOT_INTERNAL = 16384;
+    static const uint32_t HEAD_TIMEOUT_MS = 3000;   // To finish sending a request
+    static const uint32_t IDLE_TIMEOUT_MS = 5000;   // Keep-alive with nothing to do
+    static const uint32_t WRITE_TIMEOUT_MS = 10000; // Client not reading
+
+private:
+    enum ConnState {
+        FREE = 0,
+        READING,
+        WRITING
+    };
+
+    struct Connection {
+        int fd;
+        uint8_t state;
+        bool keepAlive;
+        bool holdsSnapshot;
+        bool streamDone;
+        bool longLived;          // events(): no keep-alive, no idle limit
+        bool waiting;            // Stream has nothing to send until wake()
+        unsigned long since;     // Last progress
+        uint32_t startUs;        // Request parsed
+        size_t inLen;
+        size_t consumed;         // Bytes of in[] the current request used
+        size_t outLen;
+        size_t outSent;
+        const uint8_t* body;
+        size_t bodyLen;
+        size_t bodySent;
+        ApiStreamFn streamFn;
+        ApiCloseFn closeFn;
+        void* ctx;
+        uint32_t cursor;
+        char in[IN_SIZE + 1];
+        uint8_t out[OUT_SIZE];
+    };
+
+    struct Route {
+        const char* method;
+        const char* path;
+        ApiHandler handler;
+        void* ctx;
+    };
+
+    Connection* conns;
+    uint8_t* snapshotBuf;
+    size_t snapshotCap;
+    bool snapshotBusy;
+    int listenFd;
+    int wakeFd;
+    Route routes[MAX_ROUTES];
+    int routeCount;
+
+    MetricCounter requests;
+    MetricCounter rejected;
+    MetricCounter timeouts;
+    MetricGauge connections;
+    MetricHistogram responseUs;
+
+    static const uint32_t* responseBuckets() {
+        static const uint32_t b[] = { 250, 500, 1000, 2500, 5000, 10000, 25000, 50000,
+                                      100000, 250000, 1000000 };
+        return b;
+    }
+
+    static const char* reason(int status) {
+        switch (status) {
+            case 200: return "OK";
+            case 202: return "Accepted";
+            case 204: return "No Content";
+            case 400: return "Bad Request";
+            case 404: return "Not Found";
+            case 405: return "Method Not Allowed";
+            case 409: return "Conflict";
+            case 413: return "Payload Too Large";
+            case 431: return "Request Header Fields Too Large";
+            case 503: return "Service Unavailable";
+            default: return status < 400 ? "OK" : "Error";
+        }
+    }
+
+    int activeCount() const {
+        int n = 0;
+        for (int i = 0; i < MAX_CONNECTIONS; i++) {
+            if (conns[i].state != FREE) n++;
+        }
+        return n;
+    }
+
+    void endStream(Connection& c) {
+        if (c.closeFn) {
+            c.closeFn(c.cursor, c.ctx);
+            c.closeFn = nullptr;
+        }
+    }
+
+    void closeConn(Connection& c) {
+        endStream(c);
+        if (c.holdsSnapshot) {
+            snapshotBusy = false;
+            c.holdsSnapshot = false;
+        }
+        halTcpClose(c.fd);
+        c.fd = -1;
+        c.state = FREE;
+    }
+
+    void startReading(Connection& c) {
+        c.state = READING;
+        c.outLen = c.outSent = 0;
+        c.body = nullptr;
+        c.bodyLen = c.bodySent = 0;
+        c.streamFn = nullptr;
+        c.closeFn = nullptr;
+        c.streamDone = true;
+        c.longLived = false;
+        c.waiting = false;
+        c.since = halMillis();
+    }
+
+    // The head stays below the text that send() left at the end
+    void writeHead(Connection& c, int status, const char* type, long contentLength) {
+        ApiChunk out(c.out, OUT_SIZE - TEXT_MAX);
+        char line[64];
+        snprintf(line, sizeof(line), "HTTP/1.1 %d %s\r\n", status, reason(status));
+        out.print(line);
+        out.print("Content-Type: ");
+        out.print(type);
+        if (contentLength >= 0) {
+            snprintf(line, sizeof(line), "\r\nContent-Length: %ld", contentLength);
+            out.print(line);
+        } else {
+            out.print("\r\nTransfer-Encoding: chunked");
+        }
+        if (status == 503) out.print("\r\nRetry-After: 1");
+        out.print("\r\nCache-Control: no-store\r\nAccess-Control-Allow-Origin: *\r\nConnection: ");
+        out.print(c.keepAlive ? "keep-alive\r\n\r\n" : "close\r\n\r\n");
+        c.outLen = out.length();
+        c.outSent = 0;
+    }
+
+    // text may already be in c.out (send()), hence memmove
+    void respondText(Connection& c, int status, const char* type, const char* text, size_t len) {
+        if (len > TEXT_MAX) {
+            status = 500;
+            text = "{\"error\":\"response too large\"}";
+            len = strlen(text);
+        }
+        writeHead(c, status, type, (long)len);
+        memmove(c.out + c.outLen, text, len);
+        c.outLen += len;
+    }
+
+    void respondText(Connection& c, int status, const char* type, const char* text) {
+        respondText(c, status, type, text, strlen(text));
+    }
+
+    // One snapshot at a time: a second one waits (503, retry)
+    // until the first client has its copy
+    void startSnapshot(Connection& c, const ApiResponse& res) {
+        if (snapshotBusy || !snapshotBuf) {
+            respondText(c, 503, "application/json", "{\"error\":\"busy\"}");
+            return;
+        }
+        ApiChunk out(snapshotBuf, snapshotCap);
+        res.writerFn(out, res.ctx);
+        if (out.overflowed()) {
+            respondText(c, 500, "application/json", "{\"error\":\"response too large\"}");
+            return;
+        }
+        snapshotBusy = true;
+        c.holdsSnapshot = true;
+        writeHead(c, res.status, res.type, (long)out.length());
+        c.body = snapshotBuf;
+        c.bodyLen = out.length();
+    }
+
+    // A route, 404 or 405
+    void dispatch(Connection& c, const ApiRequest& req) {
+        ApiResponse res((char*)c.out + OUT_SIZE - TEXT_MAX, TEXT_MAX);
+        bool pathFound = false;
+        for (int i = 0; i < routeCount; i++) {
+            if (strcmp(routes[i].path, req.path) != 0) continue;
+            pathFound = true;
+            if (strcmp(routes[i].method, req.method) == 0) {
+                routes[i].handler(req, res, routes[i].ctx);
+                break;
+            }
+        }
+        if (res.kind == ApiResponse::NONE) {
+            if (pathFound) {
+                res.send(405, "application/json", "{\"error\":\"method not allowed\"}");
+            } else {
+                res.send(404, "application/json", "{\"error\":\"not found\"}");
+            }
+        }
+
+        switch (res.kind) {
+            case ApiResponse::STATIC:
+                writeHead(c, res.status, res.type, (long)res.length);
+                c.body = res.body;
+                c.bodyLen = res.length;
+                break;
+            case ApiResponse::STREAM:
+                if (res.longLived) c.keepAlive = false;
+                writeHead(c, res.status, res.type, -1);
+                c.streamFn = res.streamFn;
+                c.closeFn = res.closeFn;
+                c.ctx = res.ctx;
+                c.cursor = res.cursor;
+                c.longLived = res.longLived;
+                c.streamDone = false;
+                break;
+            case ApiResponse::SNAPSHOT:
+                startSnapshot(c, res);
+                break;
+            default:
+                respondText(c, res.status, res.type, res.text, res.length);
+                break;
+        }
+    }
+
+    // Parses one complete request from c.in if there is one.
+    // Returns false while more bytes are needed.
+    bool parse(Connection& c) {
+        c.in[c.inLen] = '\0';
+        char* end = strstr(c.in, "\r\n\r\n");
+        if (!end) {
+            if (c.inLen == IN_SIZE) {
+                c.keepAlive = false;
+                respondText(c, 431, "application/json", "{\"error\":\"request head too large\"}");
+                c.consumed = c.inLen;
+                c.state = WRITING;
+                return true;
+            }
+            return false;
+        }
+        size_t headLen = end + 4 - c.in;
+
+        // Request line: METHOD SP target SP version
+        char* method = c.in;
+        char* sp1 = strchr(method, ' ');
+        char* sp2 = sp1 ? strchr(sp1 + 1, ' ') : nullptr;
+        char* eol = strstr(method, "\r\n");
+        if (!sp1 || !sp2 || sp2 > eol) {
+            c.keepAlive = false;
+            respondText(c, 400, "application/json", "{\"error\":\"bad request\"}");
+            c.consumed = c.inLen;
+            c.state = WRITING;
+            return true;
+        }
+        *sp1 = '\0';
+        *sp2 = '\0';
+        char* target = sp1 + 1;
+        c.keepAlive = strncmp(sp2 + 1, "HTTP/1.1", 8) == 0;
+
+        long contentLength = 0;
+        for (char* h = eol + 2; h < end; ) {
+            char* next = strstr(h, "\r\n");
+            *next = '\0';
+            if (strncasecmp(h, "Content-Length:", 15) == 0) {
+                contentLength = strtol(h + 15, nullptr, 10);
+            } else if (strncasecmp(h, "Connection:", 11) == 0) {
+                const char* v = h + 11;
+                while (*v == ' ') v++;
+                if (strncasecmp(v, "close", 5) == 0) c.keepAlive = false;
+                if (strncasecmp(v, "keep-alive", 10) == 0) c.keepAlive = true;
+            }
+            h = next + 2;
+        }
+        if (contentLength < 0 || headLen + (size_t)contentLength > IN_SIZE) {
+            c.keepAlive = false;
+            respondText(c, 413, "application/json", "{\"error\":\"body too large\"}");
+            c.consumed = c.inLen;
+            c.state = WRITING;
+            return true;
+        }
+        if (c.inLen < headLen + (size_t)contentLength) {
+            // Undo the cuts; parsed again when the body is in
+            *sp1 = ' ';
+            *sp2 = ' ';
+            for (char* h = eol; h <= end; h++) {
+                if (*h == '\0') *h = '\r';
+            }
+            return false;
+        }
+
+        ApiRequest req;
+        req.method = method;
+        char* q = strchr(target, '?');
+        if (q) *q = '\0';
+        req.path = target;
+        req.query = q ? q + 1 : "";
+        req.body = c.in + headLen;
+        req.bodyLength = (size_t)contentLength;
+        c.consumed = headLen + (size_t)contentLength;
+        c.startUs = (uint32_t)halMicros();
+        c.state = WRITING;
+        dispatch(c, req);
+        return true;
+    }
+
+    // Moves a finished connection on: next pipelined request,
+    // waiting for one, or closed
+    void finish(Connection& c) {
+        requests.inc();
+        if (!c.longLived) responseUs.observe((uint32_t)halMicros() - c.startUs);
+        endStream(c);
+        if (c.holdsSnapshot) {
+            snapshotBusy = false;
+            c.holdsSnapshot = false;
+        }
+        if (!c.keepAlive) {
+            closeConn(c);
+            return;
+        }
+        size_t left = c.inLen - c.consumed;
+        memmove(c.in, c.in + c.consumed, left);
+        c.inLen = left;
+        c.consumed = 0;
+        startReading(c);
+        if (left > 0 && parse(c)) {
+            pump(c);
+        }
+    }
+
+    // Sends as much as the socket takes: head, body, stream chunks
+    void pump(Connection& c) {
+        while (c.state == WRITING) {
+            if (c.outSent < c.outLen) {
+                int n = halTcpSend(c.fd, c.out + c.outSent, c.outLen - c.outSent);
+                if (n < 0) {
+                    closeConn(c);
+                    return;
+                }
+                if (n == 0) return;
+                c.outSent += n;
+                c.since = halMillis();
+                continue;
+            }
+            if (c.bodySent < c.bodyLen) {
+                int n = halTcpSend(c.fd, c.body + c.bodySent, c.bodyLen - c.bodySent);
+                if (n < 0) {
+                    closeConn(c);
+                    return;
+                }
+                if (n == 0) return;
+                c.bodySent += n;
+                c.since = halMillis();
+                continue;
+            }
+            if (!c.streamDone) {
+                // "xxxx\r\n" + data + "\r\n" (+ "0\r\n\r\n" at the end)
+                ApiChunk data(c.out + 6, STREAM_CHUNK);
+                c.streamDone = c.streamFn(data, c.cursor, c.ctx);
+                if (data.overflowed()) {
+                    halLog("API: Stream piece over %u bytes, connection dropped\n", (unsigned)STREAM_CHUNK);
+                    closeConn(c);
+                    return;
+                }
+                size_t len = data.length();
+                c.outLen = 0;
+                c.outSent = 0;
+                if (len > 0) {
+                    char size[8];
+                    snprintf(size, sizeof(size), "%04x\r\n", (unsigned)len);
+                    memcpy(c.out, size, 6);
+                    memcpy(c.out + 6 + len, "\r\n", 2);
+                    c.outLen = 6 + len + 2;
+                } else if (!c.streamDone) {
+                    c.waiting = true;    // Nothing ready yet
+                    return;
+                }
+                c.waiting = false;
+                if (c.streamDone) {
+                    if (len == 0) {
+                        memcpy(c.out, "0\r\n\r\n", 5);
+                        c.outLen = 5;
+                    } else {
+                        memcpy(c.out + c.outLen, "0\r\n\r\n", 5);
+                        c.outLen += 5;
+                    }
+                }
+                continue;
+            }
+            finish(c);
+            return;
+        }
+    }
+
+    void readFrom(Connection& c) {
+        while (c.state == READING && c.inLen < IN_SIZE) {
+            int n = halTcpRecv(c.fd, c.in + c.inLen, IN_SIZE - c.inLen);
+            if (n < 0) {
+                closeConn(c);
+                return;
+            }
+            if (n == 0) break;
+            if (c.inLen == 0) c.since = halMillis();     // Head timer starts with its first byte
+            c.inLen += n;
+        }
+        if (c.state == READING && parse(c)) {
+            pump(c);
+        }
+    }
+
+    void acceptAll() {
+        for (;;) {
+            int fd = halTcpAccept(listenFd);
+            if (fd < 0) return;
+            Connection* c = nullptr;
+            for (int i = 0; i < MAX_CONNECTIONS && !c; i++) {
+                if (conns[i].state == FREE) c = &conns[i];
+            }
+            if (!c) {
+                // Full: a short answer that always fits the socket buffer
+                static const char BUSY[] =
+                    "HTTP/1.1 503 Service Unavailable\r\nContent-Type: application/json\r\n"
+                    "Content-Length: 16\r\nRetry-After: 1\r\nConnection: close\r\n\r\n{\"error\":\"busy\"}";
+                halTcpSend(fd, BUSY, sizeof(BUSY) - 1);
+                halTcpClose(fd);
+                rejected.inc();
+                continue;
+            }
+            c->fd = fd;
+            c->inLen = 0;
+            c->consumed = 0;
+            c->holdsSnapshot = false;
+            startReading(*c);
+        }
+    }
+
+    void expire(unsigned long now) {
+        for (int i = 0; i < MAX_CONNECTIONS; i++) {
+            Connection& c = conns[i];
+            if (c.state == FREE) continue;
+            if (c.waiting) continue;     // An open event stream, idle
+            uint32_t limit = c.state == WRITING ? WRITE_TIMEOUT_MS
+                           : c.inLen > 0 ? HEAD_TIMEOUT_MS : IDLE_TIMEOUT_MS;
+            if (now - c.since > limit) {
+                if (c.state != READING || c.inLen > 0) timeouts.inc();
+                closeConn(c);
+            }
+        }
+    }
+
+#ifdef ARDUINO
+    static void taskMain(void* arg) {
+        ApiServer* self = (ApiServer*)arg;
+        for (;;) {
+            self->poll(50);
+        }
+    }
+#endif
+
+public:
+    ApiServer()
+        : conns(nullptr), snapshotBuf(nullptr), snapshotCap(0), snapshotBusy(false), listenFd(-1),
+          wakeFd(-1), routeCount(0),
+          requests("volt_api_requests_total", "Device API responses sent"),
+          rejected("volt_api_rejected_total", "Connections turned away with 503 (pool full)"),
+          timeouts("volt_api_timeouts_total", "Connections closed for a slow or silent client"),
+          connections("volt_api_connections", "Open device API connections"),
+          responseUs("volt_api_response_us", "Request parsed to last byte sent",
+                     responseBuckets(), 11) {}
+
+    ~ApiServer() {
+        end();
+        if (conns) halHeapFree(conns);
+        if (snapshotBuf) halHeapFree(snapshotBuf);
+    }
+
+    // Register before begin() / startTask()
+    bool on(const char* method, const char* path, ApiHandler handler, void* ctx = nullptr) {
+        if (routeCount == MAX_ROUTES) return false;
+        routes[routeCount++] = { method, path, handler, ctx };
+        return true;
+    }
+
+    // Reserves the pool and the snapshot buffer (PSRAM first), then
+    // listens. Port 0 takes any free port (tests).
+    bool begin(uint16_t port, size_t snapshotBytes = DEFAULT_SNAPSHOT) {
+        if (listenFd >= 0) return true;
+        if (!conns) {
+            size_t bytes = sizeof(Connection) * MAX_CONNECTIONS;
+            conns = (Connection*)halHeapAlloc(bytes, HAL_HEAP_SPIRAM);
+            if (!conns) conns = (Connection*)halHeapAlloc(bytes, HAL_HEAP_INTERNAL);
+            if (!conns) {
+                halLog("API: No memory for %d connections\n", MAX_CONNECTIONS);
+                return false;
+            }
+            for (int i = 0; i < MAX_CONNECTIONS; i++) {
+                conns[i].fd = -1;
+                conns[i].state = FREE;
+            }
+        }
+        if (!snapshotBuf && snapshotBytes > 0) {
+            // Without PSRAM a smaller one: big snapshots answer 500
+            snapshotCap = snapshotBytes;
+            snapshotBuf = (uint8_t*)halHeapAlloc(snapshotCap, HAL_HEAP_SPIRAM);
+            if (!snapshotBuf) {
+                snapshotCap = snapshotBytes < SNAPSHOT_INTERNAL ? snapshotBytes : SNAPSHOT_INTERNAL;
+                snapshotBuf = (uint8_t*)halHeapAlloc(snapshotCap, HAL_HEAP_INTERNAL);
+            }
+            if (!snapshotBuf) snapshotCap = 0;
+        }
+        listenFd = halTcpListen(port, MAX_CONNECTIONS);
+        if (listenFd < 0) {
+            halLog("API: Could not listen on port %u\n", (unsigned)port);
+            return false;
+        }
+        wakeFd = halWakeOpen();          // Without it events wait for the next poll
+
+        halLog("API: Listening on port %u (%d connections)\n", (unsigned)getPort(), MAX_CONNECTIONS);
+        return true;
+    }
+
+    void end() {
+        if (listenFd < 0) return;
+        for (int i = 0; i < MAX_CONNECTIONS; i++) {
+            if (conns[i].state != FREE) closeConn(conns[i]);
+        }
+        halTcpClose(listenFd);
+        listenFd = -1;
+        if (wakeFd >= 0) halTcpClose(wakeFd);
+        wakeFd = -1;
+    }
+
+    void registerMetrics(MetricsRegistry& registry) {
+        registry.add(&requests);
+        registry.add(&rejected);
+        registry.add(&timeouts);
+        registry.add(&connections);
+        registry.add(&responseUs);
+    }
+
+#ifdef ARDUINO
+    // poll() forever on its own task (core 0 by default, with WiFi)
+    bool startTask(int core = 0, uint32_t stackBytes = 6144, int priority = 2) {
+        return xTaskCreatePinnedToCore(taskMain, "api", stackBytes, this, priority, nullptr, core) == pdPASS;
+    }
+#endif
+
+    // Ends the current (or next) wait in poll() early. Safe from
+    // any task: event publishers call it.
+    void wake() {
+        if (wakeFd >= 0) halWakeSignal(wakeFd);
+    }
+
+    // One round: waits up to timeoutMs for a socket to be ready,
+    // then does everything that can be done without blocking
+    void poll(uint32_t timeoutMs) {
+        if (listenFd < 0) return;
+        int fds[MAX_CONNECTIONS + 2];
+        bool wantWrite[MAX_CONNECTIONS + 2];
+        fds[0] = listenFd;
+        wantWrite[0] = false;
+        fds[1] = wakeFd;
+        wantWrite[1] = false;
+        for (int i = 0; i < MAX_CONNECTIONS; i++) {
+            // Idle event streams are only watched for the peer leaving
+            fds[i + 2] = conns[i].state == FREE ? -1 : conns[i].fd;
+            wantWrite[i + 2] = conns[i].state == WRITING && !conns[i].waiting;
+        }
+        halTcpWait(fds, wantWrite, MAX_CONNECTIONS + 2, timeoutMs);
+        if (wakeFd >= 0) halWakeDrain(wakeFd);
+
+        acceptAll();
+        for (int i = 0; i < MAX_CONNECTIONS; i++) {
+            Connection& c = conns[i];
+            if (c.state == READING) {
+                readFrom(c);
+            } else if (c.state == WRITING) {
+                // Anything an event client sends is ignored; -1 is it leaving
+                if (c.waiting && halTcpRecv(c.fd, c.in, IN_SIZE) < 0) {
+                    closeConn(c);
+                    continue;
+                }
+                pump(c);
+            }
+        }
+        expire(halMillis());
+        connections.set(activeCount());
+    }
+
+    uint16_t getPort() const { return listenFd >= 0 ? halTcpLocalPort(listenFd) : 0; }
+    int getActive() const { return conns ? activeCount() : 0; }
+    uint32_t getRequests() const { return requests.get(); }
+    uint32_t getRejected() const { return rejected.get(); }
+    uint32_t getTimeouts() const { return timeouts.get(); }
+    const MetricHistogram& getResponseTimes() const { return responseUs; }
+};
+
+#endif // API_SERVER_H
@@ -0,0 +1,590 @@
+/*
+ * ============================================
+ * App State - What VOLT Is Doing
+ * ============================================
+ *
+ * Handles:
+ * - The app's states: idle, a voice turn
+ *   (listening, thinking, speaking), joke,
+ *   breathing, Dad's message, WiFi setup, an
+ *   SOS hold and short notices ("Didn't hear
+ *   you")
+ * - Which screen to draw, what to record, say
+ *   or ask for next, as commands
+ * - Timed steps without delay(): a step shows
+ *   its screen, says its line (when online) and
+ *   holds for a while after the line ends
+ * - Events that don't fit the state (a late
+ *   reply, presses mid-turn) are ignored and
+ *   counted
+ *
+ * Pure state machine, like button_input.h: feed
+ * it an event and the time, then carry out the
+ * commands it returns (app_tasks.h routes them
+ * to the UI, audio and network tasks). No
+ * hardware access and no blocking, so every
+ * path runs in host tests on a virtual clock.
+ *
+ * Text in events and commands is not copied:
+ * replies live in the engine's turn arena until
+ * CMD_END_TURN, everything else is static.
+ *
+ * ============================================
+ */
+
+#ifndef APP_STATE_H
+#define APP_STATE_H
+
+#include <stdint.h>
+#include "volt_hal.h"
+
+enum AppStateId {
+    APP_IDLE,
+    APP_LISTENING,
+    APP_THINKING,
+    APP_SPEAKING,
+    APP_JOKE,
+    APP_BREATHING,
+    APP_MESSAGE,             // Dad's message
+    APP_NOTICE,              // A line on screen for a moment, then idle
+    APP_SETUP,               // WiFi setup access point
+    APP_SOS,                 // "Hold for SOS...", then the alert
+    APP_STATE_COUNT
+};
+
+enum AppEventType {
+    EV_NONE,
+    EV_TICK,                 // Time passed (every UI pass)
+    EV_PRESSES,              // a = press count
+    EV_LONG_PRESS,
+    EV_LOW_BATTERY,          // a = percent
+    EV_NET_STATUS,           // a = connected, b = realtime session ready
+    EV_RECORDED,
+    EV_TRANSCRIBED,          // text, "" if nothing was heard
+    EV_REPLY,                // text, "" if the request failed
+    EV_SPOKEN,
+    EV_STREAMED,             // Realtime: a = mic sent and reply requested
+    EV_PLAYED,               // Realtime: a = reply played
+    EV_AP_STARTED,           // a = access point up
+    EV_BUTTON_EDGE,          // a = pressed, b = ms; for app_tasks.h, not the machine
+    EV_SOS_WARNING,          // Button still held (button_gestures.h)
+    EV_SOS_CANCEL,           // Released after the warning
+    EV_SOS                   // Held long enough
+};
+
+struct AppEvent {
+    uint8_t type;
+    int32_t a;
+    int32_t b;
+    const char* text;
+};
+
+enum AppCommandType {
+    // UI task
+    CMD_SHOW_IDLE,
+    CMD_SHOW_TEXT,           // text, a = AppTone
+    CMD_SHOW_JOKE,           // text
+    CMD_SHOW_REPLY,          // text; nullptr: the Realtime transcript as it streams
+    CMD_SHOW_BREATHE,        // a = 0 in, 1 hold, 2 out
+    CMD_SHOW_GREAT_JOB,
+    CMD_SHOW_LOVE,
+    CMD_SHOW_NEED_WIFI,
+    CMD_SHOW_SETUP,
+    CMD_LED,                 // a = on
+    // Audio task
+    CMD_RECORD,
+    CMD_SPEAK,               // text
+    CMD_STREAM_MIC,          // a = ms (Realtime API)
+    CMD_PLAY_RESPONSE,
+    // Network task
+    CMD_TRANSCRIBE,
+    CMD_CHAT,                // text
+    CMD_END_TURN,            // Frees the turn's replies
+    CMD_START_AP,
+    CMD_RESTART,
+    CMD_CHECK_NET,           // Reconnect if needed, answer EV_NET_STATUS
+    CMD_SOS,                 // Raise the alert (device API "sos" event)
+    CMD_COUNT
+};
+
+// Colors, named for what they mean; the UI picks the pixels
+enum AppTone {
+    TONE_PLAIN,
+    TONE_INFO,
+    TONE_GOOD,
+    TONE_WARN,
+    TONE_ERROR,
+    TONE_FUN
+};
+
+struct AppCommand {
+    uint8_t type;
+    int32_t a;
+    const char* text;
+};
+
+// Features that can be turned off in the config
+enum AppFeature {
+    FEATURE_VOICE = 0x01,
+    FEATURE_JOKES = 0x02,
+    FEATURE_BREATHING = 0x04,
+    FEATURE_LOVE = 0x08,
+    FEATURE_WIFI_SETUP = 0x10,
+    FEATURE_SOS = 0x20
+};
+
+struct AppConfig {
+    uint8_t features;
+    uint32_t recordMs;       // Realtime mic stream length
+    const char* loveMessage;
+};
+
+class AppStateMachine {
+public:
+    static const int MAX_COMMANDS = 6;
+    static const int BREATH_CYCLES = 3;
+    static const unsigned long NOTICE_MS = 2000;
+    static const unsigned long NEED_WIFI_MS = 6000;
+    static const unsigned long UNKNOWN_MS = 1000;
+    static const unsigned long JOKE_INTRO_MS = 1000;
+    static const unsigned long JOKE_HOLD_MS = 3000;
+    static const unsigned long BREATHE_INTRO_MS = 1500;
+    static const unsigned long GREAT_JOB_MS = 2000;
+    static const unsigned long LOVE_HOLD_MS = 3000;
+    static const unsigned long SETUP_MS = 300000;     // Access point stays up 5 minutes
+    static const unsigned long RESTART_MS = 2000;
+    static const unsigned long SOS_MS = 5000;
+
+private:
+    AppConfig config;
+    AppStateId state;
+    bool online;
+    bool realtimeReady;
+    bool turnOpen;           // The engine holds replies until CMD_END_TURN
+    bool lowBattery;         // Warning waits for idle
+    bool stateChanged;
+
+    // The current timed step
+    bool speaking;           // Waiting for EV_SPOKEN before holding
+    unsigned long holdMs;
+    unsigned long deadline;  // 0 = none
+    int step;                // Breathing phase, joke / setup stage
+
+    AppCommand cmds[MAX_COMMANDS];
+    int cmdCount;
+    uint32_t ignored;
+
+    void emit(uint8_t type, int32_t a = 0, const char* text = nullptr) {
+        if (cmdCount < MAX_COMMANDS) {
+            cmds[cmdCount++] = { type, a, text };
+        }
+    }
+
+    void enter(AppStateId s) {
+        if (s != state) stateChanged = true;
+        state = s;
+        speaking = false;
+        deadline = 0;
+        step = 0;
+    }
+
+    // Says line (online only) and then holds for ms; offline the
+    // hold starts now
+    void hold(const char* line, unsigned long ms, unsigned long now) {
+        holdMs = ms;
+        if (line && online) {
+            speaking = true;
+            deadline = 0;
+            emit(CMD_SPEAK, 0, line);
+        } else {
+            speaking = false;
+            deadline = now + ms;
+            if (deadline == 0) deadline = 1;
+        }
+    }
+
+    void toIdle(unsigned long now) {
+        if (turnOpen) {
+            emit(CMD_END_TURN);
+            turnOpen = false;
+        }
+        if (lowBattery) {
+            lowBattery = false;
+            notice("Low Battery!", TONE_ERROR, NOTICE_MS, now);
+            return;
+        }
+        enter(APP_IDLE);
+        emit(CMD_SHOW_IDLE);
+    }
+
+    void notice(const char* text, AppTone tone, unsigned long ms, unsigned long now) {
+        enter(APP_NOTICE);
+        emit(CMD_SHOW_TEXT, tone, text);
+        hold(nullptr, ms, now);
+    }
+
+    void startTalk(unsigned long now) {
+        if (!online) {
+            enter(APP_NOTICE);
+            emit(CMD_SHOW_NEED_WIFI);
+            hold(nullptr, NEED_WIFI_MS, now);
+            return;
+        }
+        enter(APP_LISTENING);
+        emit(CMD_SHOW_TEXT, TONE_INFO, "Listening...");
+        emit(CMD_LED, 1);
+        if (realtimeReady) {
+            emit(CMD_STREAM_MIC, (int32_t)config.recordMs);
+        } else {
+            turnOpen = true;
+            emit(CMD_RECORD);
+        }
+    }
+
+    void startJoke(unsigned long now) {
+        enter(APP_JOKE);
+        emit(CMD_SHOW_TEXT, TONE_FUN, "Joke Time!");
+        if (online) {
+            turnOpen = true;
+            emit(CMD_CHAT, 0, jokePrompt());    // Answers EV_REPLY
+        } else {
+            hold(nullptr, JOKE_INTRO_MS, now);  // Then an offline joke
+        }
+    }
+
+    void showJoke(const char* joke, unsigned long now) {
+        if (!joke || joke[0] == '\0') {
+            joke = offlineJoke();
+        }
+        step = 1;
+        emit(CMD_SHOW_JOKE, 0, joke);
+        hold(joke, JOKE_HOLD_MS, now);
+    }
+
+    void startBreathing(unsigned long now) {
+        enter(APP_BREATHING);
+        emit(CMD_SHOW_TEXT, TONE_INFO, "Let's Breathe");
+        hold("Let's breathe together, Stone. Follow along.", BREATHE_INTRO_MS, now);
+    }
+
+    // step 0 is the intro, then in / hold / out per cycle, then
+    // "Great job"
+    void nextBreath(unsigned long now) {
+        static const char* const lines[] = {
+            "Breathe in... 1, 2, 3, 4",
+            "Hold... 1, 2, 3, 4",
+            "Breathe out... 1, 2, 3, 4, 5, 6"
+        };
+        int s = ++step;
+        if (s <= BREATH_CYCLES * 3) {
+            int phase = (s - 1) % 3;
+            if (phase == 0) halLog("Breathing: Cycle %d/%d\n", (s - 1) / 3 + 1, BREATH_CYCLES);
+            emit(CMD_SHOW_BREATHE, phase);
+            hold(lines[phase], breathMs(phase), now);
+        } else if (s == BREATH_CYCLES * 3 + 1) {
+            emit(CMD_SHOW_GREAT_JOB);
+            hold("Great job, Stone! You did amazing!", GREAT_JOB_MS, now);
+        } else {
+            halLog("Feature: Breathing exercise complete\n");
+            toIdle(now);
+        }
+    }
+
+    void startLove(unsigned long now) {
+        enter(APP_MESSAGE);
+        emit(CMD_SHOW_LOVE);
+        hold(config.loveMessage, LOVE_HOLD_MS, now);
+    }
+
+    void startSetup() {
+        enter(APP_SETUP);
+        emit(CMD_SHOW_SETUP);
+        emit(CMD_START_AP);                     // Answers EV_AP_STARTED
+    }
+
+    void leaveSetup(unsigned long now) {
+        halLog("AP Mode: Exiting\n");
+        step = 2;
+        emit(CMD_SHOW_TEXT, TONE_WARN, "Restarting...");
+        hold(nullptr, RESTART_MS, now);
+    }
+
+    void sendSos(unsigned long now) {
+        halLog("Button: SOS hold\n");
+        enter(APP_SOS);
+        step = 1;
+        emit(CMD_LED, 0);                       // In case a turn was listening
+        emit(CMD_SHOW_TEXT, TONE_ERROR, "SOS Sent!");
+        emit(CMD_SOS);
+        hold(nullptr, SOS_MS, now);
+    }
+
+    void onButton(uint8_t type, int count, unsigned long now) {
+        if (state == APP_IDLE) {
+            if (type == EV_PRESSES) onPresses(count, now);
+            else if (config.features & FEATURE_LOVE) startLove(now);
+        } else if (state == APP_SETUP && step == 1) {
+            leaveSetup(now);
+        } else {
+            ignored++;                          // Busy: one thing at a time
+        }
+    }
+
+    void onPresses(int count, unsigned long now) {
+        halLog("Button: Executing action for %d presses\n", count);
+        uint8_t f = config.features;
+        if (count == 1 && (f & FEATURE_VOICE)) {
+            startTalk(now);
+        } else if (count == 2 && (f & FEATURE_JOKES)) {
+            startJoke(now);
+        } else if (count == 3 && (f & FEATURE_BREATHING)) {
+            startBreathing(now);
+        } else if (count == 5 && (f & FEATURE_WIFI_SETUP)) {
+            startSetup();
+        } else if (count == 1 || count == 2 || count == 3 || count == 5) {
+            toIdle(now);                        // Feature turned off
+        } else {
+            halLog("Button: Unknown pattern (%d presses)\n", count);
+            notice("Unknown pattern", TONE_WARN, UNKNOWN_MS, now);
+        }
+    }
+
+    // The hold of the current step is over
+    void onDeadline(unsigned long now) {
+        switch (state) {
+            case APP_JOKE:
+                if (step == 0) showJoke(nullptr, now);
+                else toIdle(now);
+                break;
+            case APP_BREATHING:
+                nextBreath(now);
+                break;
+            case APP_SETUP:
+                if (step == 2) {
+                    emit(CMD_RESTART);
+                    deadline = 0;
+                } else {
+                    leaveSetup(now);            // Time is up
+                }
+                break;
+            default:
+                toIdle(now);
+                break;
+        }
+    }
+
+    bool onTurnEvent(const AppEvent& e, unsigned long now) {
+        if (state == APP_LISTENING && e.type == EV_RECORDED) {
+            enter(APP_THINKING);
+            emit(CMD_LED, 0);
+            emit(CMD_SHOW_TEXT, TONE_WARN, "Thinking...");
+            emit(CMD_TRANSCRIBE);
+        } else if (state == APP_LISTENING && e.type == EV_STREAMED) {
+            emit(CMD_LED, 0);
+            if (!e.a) {
+                halLog("Feature: Realtime session failed\n");
+                notice("AI Error", TONE_ERROR, NOTICE_MS, now);
+                return true;
+            }
+            enter(APP_SPEAKING);
+            emit(CMD_SHOW_REPLY);
+            emit(CMD_PLAY_RESPONSE);
+        } else if (state == APP_THINKING && e.type == EV_TRANSCRIBED) {
+            if (!e.text || e.text[0] == '\0') {
+                halLog("Feature: No audio detected\n");
+                notice("Didn't hear you", TONE_ERROR, NOTICE_MS, now);
+                return true;
+            }
+            emit(CMD_CHAT, 0, e.text);
+        } else if (state == APP_THINKING && e.type == EV_REPLY) {
+            if (!e.text || e.text[0] == '\0') {
+                halLog("Feature: AI response failed\n");
+                notice("AI Error", TONE_ERROR, NOTICE_MS, now);
+                return true;
+            }
+            enter(APP_SPEAKING);
+            emit(CMD_SHOW_REPLY, 0, e.text);
+            emit(CMD_SPEAK, 0, e.text);
+        } else if (state == APP_SPEAKING && e.type == EV_SPOKEN) {
+            halLog("Feature: Voice chat complete\n");
+            toIdle(now);
+        } else if (state == APP_SPEAKING && e.type == EV_PLAYED) {
+            if (!e.a) {
+                halLog("Feature: Realtime response failed\n");
+                notice("AI Error", TONE_ERROR, NOTICE_MS, now);
+                return true;
+            }
+            toIdle(now);
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    static const char* jokePrompt() {
+        return "Tell a short, funny joke for an 8-year-old boy named Stone. Keep it under 30 words.";
+    }
+
+    const char* offlineJoke() {
+        static const char* const jokes[] = {
+            "Why did the scarecrow win an award? Because he was outstanding in his field!",
+            "What do you call a bear with no teeth? A gummy bear!",
+            "Why don't scientists trust atoms? Because they make up everything!",
+            "What did the ocean say to the beach? Nothing, it just waved!",
+            "Why did the bicycle fall over? It was two tired!",
+            "What do you call a dinosaur that crashes his car? Tyrannosaurus Wrecks!",
+            "Why can't you hear a pterodactyl go to the bathroom? Because the P is silent!",
+            "What do you call a sleeping bull? A bulldozer!"
+        };
+        halLog("Feature: Using offline joke\n");
+        return jokes[halRandom(0, 8)];
+    }
+
+public:
+    AppStateMachine()
+        : state(APP_IDLE), online(false), realtimeReady(false), turnOpen(false),
+          lowBattery(false), stateChanged(false), speaking(false), holdMs(0), deadline(0),
+          step(0), cmdCount(0), ignored(0) {
+        config = { 0xFF, 5000, "" };
+    }
+
+    void begin(const AppConfig& cfg, bool isOnline) {
+        config = cfg;
+        online = isOnline;
+    }
+
+    // Handles one event; the commands to carry out, in order, are
+    // command(0 .. count - 1)
+    int handle(const AppEvent& e, unsigned long now) {
+        cmdCount = 0;
+        stateChanged = false;
+
+        switch (e.type) {
+            case EV_TICK:
+                if (deadline != 0 && (long)(now - deadline) >= 0) {
+                    deadline = 0;
+                    onDeadline(now);
+                }
+                break;
+
+            case EV_NET_STATUS: {
+                bool changed = online != (e.a != 0);
+                online = e.a != 0;
+                realtimeReady = e.b != 0;
+                if (changed && state == APP_IDLE) emit(CMD_SHOW_IDLE);  // "Ready" / "Offline"
+                break;
+            }
+
+            case EV_LOW_BATTERY:
+                if (state == APP_IDLE) notice("Low Battery!", TONE_ERROR, NOTICE_MS, now);
+                else lowBattery = true;
+                break;
+
+            case EV_PRESSES:
+            case EV_LONG_PRESS:
+                onButton(e.type, e.a, now);
+                break;
+
+            // Without FEATURE_SOS a hold is just a long press. The
+            // warning only shows over idle; the alert goes out from
+            // any state.
+            case EV_SOS_WARNING:
+                if (state == APP_IDLE && (config.features & FEATURE_SOS)) {
+                    enter(APP_SOS);
+                    emit(CMD_SHOW_TEXT, TONE_ERROR, "Hold for SOS...");
+                }
+                break;
+
+            case EV_SOS_CANCEL:
+                if (!(config.features & FEATURE_SOS)) onButton(EV_LONG_PRESS, 0, now);
+                else if (state == APP_SOS && step == 0) toIdle(now);
+                break;
+
+            case EV_SOS:
+                if (config.features & FEATURE_SOS) sendSos(now);
+                else onButton(EV_LONG_PRESS, 0, now);
+                break;
+
+            case EV_SPOKEN:
+                if (speaking) {
+                    speaking = false;
+                    deadline = now + holdMs;
+                    if (deadline == 0) deadline = 1;
+                } else if (!onTurnEvent(e, now)) {
+                    ignored++;
+                }
+                break;
+
+            case EV_REPLY:
+                if (state == APP_JOKE && step == 0) {
+                    showJoke(e.text, now);
+                } else if (!onTurnEvent(e, now)) {
+                    ignored++;
+                }
+                break;
+
+            case EV_AP_STARTED:
+                if (state != APP_SETUP || step != 0) {
+                    ignored++;
+                } else if (e.a) {
+                    halLog("AP Mode: Started successfully\n");
+                    step = 1;
+                    hold(nullptr, SETUP_MS, now);
+                } else {
+                    halLog("AP Mode: Failed to start\n");
+                    notice("AP Failed", TONE_ERROR, NOTICE_MS, now);
+                }
+                break;
+
+            default:
+                if (!onTurnEvent(e, now)) ignored++;
+                break;
+        }
+        return cmdCount;
+    }
+
+    const AppCommand& command(int i) const { return cmds[i]; }
+
+    // Set by the last handle() when the state changed
+    bool changed() const { return stateChanged; }
+
+    AppStateId getState() const { return state; }
+    bool isOnline() const { return online; }
+
+    // Until the current step's hold ends; HAL_WAIT_FOREVER while
+    // nothing is timed (waiting for a result or a press)
+    uint32_t waitMs(unsigned long now) const {
+        if (deadline == 0) return HAL_WAIT_FOREVER;
+        return (long)(now - deadline) >= 0 ? 0 : (uint32_t)(deadline - now);
+    }
+    uint32_t getIgnored() const { return ignored; }
+
+    // What GET /api/status reports
+    static const char* stateName(AppStateId s) {
+        static const char* const names[APP_STATE_COUNT] = {
+            "idle", "listening", "thinking", "speaking", "joke", "breathing",
+            "message", "notice", "setup", "sos"
+        };
+        return s < APP_STATE_COUNT ? names[s] : "unknown";
+    }
+
+    // How long a breathing phase holds after its line (0 in, 1 hold,
+    // 2 out); the screen's animation runs over the same time
+    static unsigned long breathMs(int phase) {
+        static const unsigned long holds[] = { 4000, 4000, 6000 };
+        return phase >= 0 && phase < 3 ? holds[phase] : 0;
+    }
+
+    // What a task was doing, for the supervisor's stall report
+    static const char* commandName(uint8_t cmd) {
+        static const char* const names[CMD_COUNT] = {
+            "show_idle", "show_text", "show_joke", "show_reply", "show_breathe", "show_great_job",
+            "show_love", "show_need_wifi", "show_setup", "led", "record", "speak", "stream_mic",
+            "play_response", "transcribe", "chat", "end_turn", "start_ap", "restart", "check_net",
+            "sos"
+        };
+        return cmd < CMD_COUNT ? names[cmd] : "unknown";
+    }
+};
+
+#endif // APP_STATE_H
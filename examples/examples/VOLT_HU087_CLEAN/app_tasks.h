@@ -0,0 +1,510 @@
+/*
+ * ============================================
+ * App Tasks - UI, Audio and Network
+ * ============================================
+ *
+ * Handles:
+ * - Three tasks instead of one loop():
+ *   - ui (core 0): button gestures, screen and
+ *     the app state machine (app_state.h).
+ *     Sleeps until a button edge, a result or
+ *     its next timer, never on a long job, so
+ *     presses are answered at once
+ *   - audio (core 1, highest priority): records
+ *     and plays. Speech streams in while it
+ *     plays, so TTS runs here too
+ *   - net (core 0, with WiFi): transcription,
+ *     chat, end of turn, reconnects, setup
+ * - Typed bounded queues between them: commands
+ *   to audio and net, result events back to ui.
+ *   A full queue drops the message and counts
+ *   it; nothing blocks the UI
+ * - Button edges from the pin interrupt, through
+ *   the event queue, into the gesture engine
+ *   (button_gestures.h): presses, long press,
+ *   SOS hold. Nothing polls the pin
+ * - Automatic light sleep while every task
+ *   waits (start()), held off while the button
+ *   is down: only a press wakes the chip
+ * - A WiFi check every NET_CHECK_MS, queued to
+ *   net so it never runs mid-request; or off,
+ *   with loop()'s housekeeping timers asking
+ *   for it (requestNetCheck())
+ * - Deterministic stepping off-target:
+ *   runUntilIdle() runs the three in a fixed
+ *   order until nothing moves, so host tests
+ *   drive whole turns on a virtual clock
+ * - Queue, ignored event, UI wakeup and UI pass
+ *   metrics
+ * - Animation frames on ui (optional, a frame
+ *   hook): started by a screen, drawn every
+ *   FRAME_MS on a fixed grid (frame_pacer.h)
+ *   between events, while audio plays a reply
+ * - Heartbeats to a task supervisor (optional,
+ *   task_supervisor.h): ui every pass, audio and
+ *   net for each command, each task with its own
+ *   deadline
+ *
+ * The machine issues one audio or net command
+ * at a time and waits for its answer, so the
+ * engine is never used by both tasks at once.
+ * Without a supervisor only ui subscribes to
+ * the task watchdog; the other two block for as
+ * long as a request or a reply takes. With one,
+ * nothing does: the supervisor's caller feeds
+ * the watchdog while every task is within its
+ * deadline.
+ *
+ * ============================================
+ */
+
+#ifndef APP_TASKS_H
+#define APP_TASKS_H
+
+#include <stdint.h>
+#include <atomic>
+#include "volt_hal.h"
+#include "metrics.h"
+#include "msg_queue.h"
+#include "app_state.h"
+#include "button_gestures.h"
+#include "task_stats.h"
+#include "task_supervisor.h"
+#include "frame_pacer.h"
+
+#ifdef ARDUINO
+#include <esp_task_wdt.h>
+#define APP_IRAM IRAM_ATTR
+#else
+#define APP_IRAM
+#endif
+
+class AppTasks {
+public:
+    static const int EVENT_DEPTH = 16;
+    static const int WORK_DEPTH = 4;
+    static const uint32_t IDLE_MAX_MS = 2000;       // ui still feeds the watchdog (8 s)
+    static const unsigned long NET_CHECK_MS = 30000;
+    static const uint32_t RESULT_WAIT_MS = 1000;    // A result is never dropped lightly
+    static const uint32_t UI_DEADLINE_MS = 5000;    // A pass, after at most IDLE_MAX_MS asleep
+    static const uint32_t AUDIO_DEADLINE_MS = 45000; // A 30 s reply, spoken
+    static const uint32_t NET_DEADLINE_MS = 40000;  // Reconnect, or a request with its retries
+    static const uint32_t FRAME_MS = 33;            // 30 frames a second
+
+    enum Target { TO_UI, TO_AUDIO, TO_NET };
+
+    // Draws a CMD_SHOW_* or sets the LED (ui task)
+    typedef void (*UiFn)(const AppCommand& cmd, void* ctx);
+    // Carries out an audio or net command. result comes with its
+    // type set (EV_NONE if the command has no answer) and a = 1.
+    typedef void (*WorkFn)(const AppCommand& cmd, AppEvent& result, void* ctx);
+    typedef void (*StateFn)(AppStateId state, void* ctx);
+    // Every gesture before the machine sees it (LED, idle timer)
+    typedef void (*ButtonFn)(Gesture gesture, void* ctx);
+    // Draws one animation frame (ui task); false when it is over
+    typedef bool (*FrameFn)(unsigned long now, void* ctx);
+
+    struct Hooks {
+        UiFn ui;
+        WorkFn audio;
+        WorkFn net;
+        StateFn onState;
+        ButtonFn onButton;
+        void* ctx;
+    };
+
+    typedef MsgQueue<AppCommand, WORK_DEPTH> WorkQueue;
+    typedef MsgQueue<AppEvent, EVENT_DEPTH> EventQueue;
+
+private:
+    AppStateMachine machine;
+    ButtonGestures gestures;
+    Hooks hooks;
+    int buttonPin;
+    bool lightSleep;
+    std::atomic<bool> edgeLost;  // The interrupt found the event queue full
+    std::atomic<uint8_t> state;
+    unsigned long lastNetCheck;
+    uint32_t netCheckMs;         // 0: only requestNetCheck()
+    uint32_t ignoredSeen;
+
+    EventQueue events;
+    WorkQueue audioCmds;
+    WorkQueue netCmds;
+
+    MetricCounter eventsFull;
+    MetricCounter audioFull;
+    MetricCounter netFull;
+    MetricCounter ignoredEvents;
+    MetricCounter uiWakeups;
+    MetricHistogram uiPassUs;
+
+    FrameFn frameFn;
+    uint32_t frameMs;
+    FramePacer pacer;
+
+    TaskSupervisor* supervisor;
+    int uiWatch, audioWatch, netWatch;
+    MetricHistogram uiDeadline;
+    MetricHistogram audioDeadline;
+    MetricHistogram netDeadline;
+
+    static const char* deadlineHelp() { return "Gap between a task's heartbeats, in % of its deadline"; }
+
+    static const uint32_t* passBuckets() {
+        static const uint32_t b[] = { 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000 };
+        return b;
+    }
+
+    static Target targetOf(uint8_t cmd) {
+        if (cmd <= CMD_LED) return TO_UI;
+        if (cmd <= CMD_PLAY_RESPONSE) return TO_AUDIO;
+        return TO_NET;
+    }
+
+    static uint8_t eventOf(Gesture g) {
+        switch (g) {
+            case GESTURE_PRESSES: return EV_PRESSES;
+            case GESTURE_LONG_PRESS: return EV_LONG_PRESS;
+            case GESTURE_SOS_WARNING: return EV_SOS_WARNING;
+            case GESTURE_SOS_CANCEL: return EV_SOS_CANCEL;
+            case GESTURE_SOS: return EV_SOS;
+            default: return EV_NONE;
+        }
+    }
+
+    static uint8_t resultOf(uint8_t cmd) {
+        switch (cmd) {
+            case CMD_RECORD: return EV_RECORDED;
+            case CMD_SPEAK: return EV_SPOKEN;
+            case CMD_STREAM_MIC: return EV_STREAMED;
+            case CMD_PLAY_RESPONSE: return EV_PLAYED;
+            case CMD_TRANSCRIBE: return EV_TRANSCRIBED;
+            case CMD_CHAT: return EV_REPLY;
+            case CMD_START_AP: return EV_AP_STARTED;
+            case CMD_CHECK_NET: return EV_NET_STATUS;
+            default: return EV_NONE;
+        }
+    }
+
+    void route(const AppCommand& cmd) {
+        switch (targetOf(cmd.type)) {
+            case TO_UI:
+                if (hooks.ui) hooks.ui(cmd, hooks.ctx);
+                break;
+            case TO_AUDIO:
+                if (!audioCmds.send(cmd)) {
+                    audioFull.inc();
+                    halLog("Tasks: Audio queue full, command %d dropped\n", cmd.type);
+                }
+                break;
+            case TO_NET:
+                if (!netCmds.send(cmd)) {
+                    netFull.inc();
+                    halLog("Tasks: Net queue full, command %d dropped\n", cmd.type);
+                }
+                break;
+        }
+    }
+
+    // Runs one event through the machine; true if anything happened
+    bool dispatch(const AppEvent& e) {
+        int n = machine.handle(e, halMillis());
+        bool changed = machine.changed();
+        if (changed) {
+            state.store((uint8_t)machine.getState(), std::memory_order_relaxed);
+            if (hooks.onState) hooks.onState(machine.getState(), hooks.ctx);
+        }
+        for (int i = 0; i < n; i++) {
+            route(machine.command(i));
+        }
+        uint32_t ignored = machine.getIgnored();
+        if (ignored != ignoredSeen) {
+            ignoredEvents.inc(ignored - ignoredSeen);
+            ignoredSeen = ignored;
+        }
+        return changed || n > 0;
+    }
+
+    // Pin interrupt: the level and the time, nothing else
+    static void APP_IRAM onButtonEdge(void* arg) {
+        AppTasks* self = (AppTasks*)arg;
+        AppEvent e = { EV_BUTTON_EDGE, halDigitalRead(self->buttonPin) == LOW,
+                       (int32_t)halMillis(), nullptr };
+        if (!self->events.sendFromIsr(e)) self->edgeLost.store(true, std::memory_order_relaxed);
+    }
+
+    // Every gesture that is due, to the hook and the machine
+    bool pollButton(unsigned long now) {
+        bool progress = false;
+        for (Gesture g = gestures.poll(now); g != GESTURE_NONE; g = gestures.poll(now)) {
+            if (hooks.onButton) hooks.onButton(g, hooks.ctx);
+            uint8_t type = eventOf(g);
+            if (type != EV_NONE) {
+                dispatch({ type, type == EV_PRESSES ? gestures.getPressCount() : 0, 0, nullptr });
+            }
+            progress = true;
+        }
+        if (lightSleep) halLightSleepBlock(gestures.isActive());
+        return progress;
+    }
+
+    bool workStep(WorkQueue& queue, WorkFn fn, int watch, uint32_t waitMs) {
+        AppCommand cmd;
+        if (!queue.receive(cmd, waitMs)) return false;
+        AppEvent result = { resultOf(cmd.type), 1, 0, nullptr };
+        if (supervisor) supervisor->beat(watch, AppStateMachine::commandName(cmd.type));
+        if (fn) fn(cmd, result, hooks.ctx);
+        if (supervisor) supervisor->rest(watch);
+        if (result.type != EV_NONE && !events.send(result, RESULT_WAIT_MS)) {
+            eventsFull.inc();
+            halLog("Tasks: Event queue full, result %d lost\n", result.type);
+        }
+        return true;
+    }
+
+#ifdef ARDUINO
+    static void uiMain(void* arg) {
+        AppTasks* self = (AppTasks*)arg;
+        bool wdt = self->supervisor == nullptr;
+        if (wdt) esp_task_wdt_add(NULL);
+        for (;;) {
+            if (wdt) esp_task_wdt_reset();
+            self->uiStep(self->idleMs());
+        }
+    }
+
+    static void audioMain(void* arg) {
+        for (;;) {
+            ((AppTasks*)arg)->audioStep(HAL_WAIT_FOREVER);
+        }
+    }
+
+    static void netMain(void* arg) {
+        for (;;) {
+            ((AppTasks*)arg)->netStep(HAL_WAIT_FOREVER);
+        }
+    }
+#endif
+
+public:
+    AppTasks()
+        : buttonPin(-1), lightSleep(false), edgeLost(false), state(APP_IDLE), lastNetCheck(0),
+          netCheckMs(NET_CHECK_MS), ignoredSeen(0),
+          eventsFull("volt_app_queue_full_total", "Messages dropped because a task queue was full",
+                     "queue=\"events\""),
+          audioFull("volt_app_queue_full_total", "Messages dropped because a task queue was full",
+                    "queue=\"audio\""),
+          netFull("volt_app_queue_full_total", "Messages dropped because a task queue was full",
+                  "queue=\"net\""),
+          ignoredEvents("volt_app_ignored_events_total", "Events the app state had no use for (busy, late)"),
+          uiWakeups("volt_app_ui_wakeups_total", "Times the UI task woke (button edge, result, timer)"),
+          uiPassUs("volt_app_ui_pass_us", "Time one pass of the UI task took (what a press waits for)",
+                   passBuckets(), 10),
+          frameFn(nullptr), frameMs(FRAME_MS), supervisor(nullptr), uiWatch(-1), audioWatch(-1), netWatch(-1),
+          uiDeadline("volt_task_deadline_percent", deadlineHelp(), TaskSupervisor::percentBuckets(),
+                     TaskSupervisor::PERCENT_BUCKETS, "task=\"ui\""),
+          audioDeadline("volt_task_deadline_percent", deadlineHelp(), TaskSupervisor::percentBuckets(),
+                        TaskSupervisor::PERCENT_BUCKETS, "task=\"audio\""),
+          netDeadline("volt_task_deadline_percent", deadlineHelp(), TaskSupervisor::percentBuckets(),
+                      TaskSupervisor::PERCENT_BUCKETS, "task=\"net\"") {
+        hooks = { nullptr, nullptr, nullptr, nullptr, nullptr, nullptr };
+    }
+
+    // Reserves the queues and hooks the button's pin interrupt
+    // (active low); pin -1 for none
+    bool begin(const AppConfig& config, const Hooks& h, int pin, bool online) {
+        hooks = h;
+        buttonPin = pin;
+        machine.begin(config, online);
+        gestures.begin(ButtonGestures::defaultTiming());
+        lastNetCheck = halMillis();
+        bool ok = events.begin() && audioCmds.begin() && netCmds.begin();
+        if (ok && pin >= 0) halAttachPinChange(pin, onButtonEdge, this);
+        return ok;
+    }
+
+    // Heartbeats for the three tasks, each with its own deadline.
+    // Before start(): ui then leaves the hardware watchdog to the
+    // supervisor's caller.
+    void superviseWith(TaskSupervisor& s) {
+        supervisor = &s;
+        uiWatch = s.watch("ui", UI_DEADLINE_MS, &uiDeadline);
+        audioWatch = s.watch("audio", AUDIO_DEADLINE_MS, &audioDeadline);
+        netWatch = s.watch("net", NET_DEADLINE_MS, &netDeadline);
+    }
+
+    // Animation frames every frameMs while one runs (startFrames()).
+    // Before start().
+    void setFrameHook(FrameFn fn, uint32_t ms = FRAME_MS) {
+        frameFn = fn;
+        frameMs = ms;
+    }
+
+    // From the ui task (a UiFn): the first frame at the next pass,
+    // until the hook returns false or stopFrames()
+    void startFrames() {
+        if (frameFn) pacer.start(frameMs, halMillis());
+    }
+
+    void stopFrames() { pacer.stop(); }
+
+    // Light sleep whenever all tasks wait, woken by the button;
+    // false if the core can't (the tasks still sleep, the chip not)
+    bool beginLightSleep() {
+        if (buttonPin < 0 || !halLightSleepBegin(buttonPin)) return false;
+        lightSleep = true;
+        return true;
+    }
+
+    void registerMetrics(MetricsRegistry& registry) {
+        registry.add(&eventsFull);
+        registry.add(&audioFull);
+        registry.add(&netFull);
+        registry.add(&ignoredEvents);
+        registry.add(&uiWakeups);
+        registry.add(&uiPassUs);
+        if (frameFn) pacer.registerMetrics(registry);
+        if (supervisor) {
+            registry.add(&uiDeadline);
+            registry.add(&audioDeadline);
+            registry.add(&netDeadline);
+        }
+    }
+
+    // Queue depths in the "tasks" report and /api/metrics
+    void watchQueues(TaskStats& stats) {
+        stats.watchQueue("app_events", &events, EventQueue::depthOf);
+        stats.watchQueue("app_audio", &audioCmds, WorkQueue::depthOf);
+        stats.watchQueue("app_net", &netCmds, WorkQueue::depthOf);
+    }
+
+#ifdef ARDUINO
+    // audio alone on core 1; ui and net on core 0 with WiFi and
+    // the API task
+    bool start() {
+        if (beginLightSleep()) halLog("Tasks: Light sleep when idle\n");
+        else halLog("Tasks: No light sleep in this core build\n");
+        return xTaskCreatePinnedToCore(audioMain, "audio", 12288, this, 4, nullptr, 1) == pdPASS &&
+               xTaskCreatePinnedToCore(netMain, "net", 12288, this, 2, nullptr, 0) == pdPASS &&
+               xTaskCreatePinnedToCore(uiMain, "ui", 6144, this, 3, nullptr, 0) == pdPASS;
+    }
+#endif
+
+    // From any task (low battery from loop()); false if the queue
+    // stayed full
+    bool post(const AppEvent& e) {
+        if (events.send(e)) return true;
+        eventsFull.inc();
+        return false;
+    }
+
+    // How long the ui task may sleep: until the machine's next step,
+    // a gesture timer, the next frame or the WiFi check, at most
+    // IDLE_MAX_MS. Edges and results end the wait sooner.
+    uint32_t idleMs() const {
+        unsigned long now = halMillis();
+        uint32_t wait = IDLE_MAX_MS;
+        uint32_t t = machine.waitMs(now);
+        if (t < wait) wait = t;
+        t = gestures.waitMs(now);
+        if (t < wait) wait = t;
+        t = pacer.waitMs(now);
+        if (t < wait) wait = t;
+        if (netCheckMs > 0 && netCmds.count() == 0) {
+            unsigned long since = now - lastNetCheck;
+            t = since >= netCheckMs ? 0 : (uint32_t)(netCheckMs - since);
+            if (t < wait) wait = t;
+        }
+        return wait;
+    }
+
+    // One pass of the ui task: waits up to waitMs for an event, then
+    // handles every queued event and button edge, due gestures, the
+    // clock, the WiFi check and a due frame. True if anything
+    // happened.
+    bool uiStep(uint32_t waitMs) {
+        AppEvent e;
+        bool got = events.receive(e, waitMs);
+        uiWakeups.inc();
+        if (supervisor) supervisor->beat(uiWatch, AppStateMachine::stateName(getState()));
+        uint32_t startUs = (uint32_t)halMicros();
+        unsigned long now = halMillis();
+        bool progress = false;
+
+        while (got) {
+            if (e.type == EV_BUTTON_EDGE) {
+                // 32-bit time from the interrupt, back to the clock's width
+                unsigned long at = now - (uint32_t)((uint32_t)now - (uint32_t)e.b);
+                pollButton(at);
+                gestures.edge(e.a != 0, at);
+            } else {
+                dispatch(e);
+            }
+            progress = true;
+            got = events.receive(e, 0);
+        }
+        if (buttonPin >= 0 && edgeLost.exchange(false, std::memory_order_relaxed)) {
+            gestures.edge(halDigitalRead(buttonPin) == LOW, now);   // Resync to the level
+        }
+        progress |= pollButton(now);
+        progress |= dispatch({ EV_TICK, 0, 0, nullptr });
+
+        if (netCheckMs > 0 && now - lastNetCheck >= netCheckMs && netCmds.count() == 0) {
+            lastNetCheck = now;
+            route({ CMD_CHECK_NET, 0, nullptr });
+            progress = true;
+        }
+        if (frameFn && pacer.due(now)) {
+            uint32_t frameStart = (uint32_t)halMicros();
+            if (!frameFn(now, hooks.ctx)) pacer.stop();
+            pacer.frameDone((uint32_t)halMicros() - frameStart, halMillis());
+            progress = true;
+        }
+        uiPassUs.observe((uint32_t)halMicros() - startUs);
+        return progress;
+    }
+
+    // How often ui queues the WiFi check itself; 0 leaves it to
+    // requestNetCheck(). Before start().
+    void setNetCheckMs(uint32_t ms) { netCheckMs = ms; }
+
+    // A WiFi check from another task (loop()'s timers). Skipped
+    // while net has work queued: that work shows the link anyway.
+    bool requestNetCheck() {
+        if (netCmds.count() > 0) return false;
+        if (netCmds.send({ CMD_CHECK_NET, 0, nullptr })) return true;
+        netFull.inc();
+        return false;
+    }
+
+    // One command from the queue; true if there was one
+    bool audioStep(uint32_t waitMs) { return workStep(audioCmds, hooks.audio, audioWatch, waitMs); }
+    bool netStep(uint32_t waitMs) { return workStep(netCmds, hooks.net, netWatch, waitMs); }
+
+    // Off-target scheduler: ui, audio, net in that order until a
+    // round does nothing. Returns the rounds that did something.
+    int runUntilIdle(int maxRounds = 1000) {
+        int rounds = 0;
+        while (rounds < maxRounds) {
+            bool progress = uiStep(0);
+            progress |= audioStep(0);
+            progress |= netStep(0);
+            if (!progress) break;
+            rounds++;
+        }
+        return rounds;
+    }
+
+    // Safe from any task
+    AppStateId getState() const { return (AppStateId)state.load(std::memory_order_relaxed); }
+    const AppStateMachine& getMachine() const { return machine; }
+    uint32_t getQueueFull() const { return eventsFull.get() + audioFull.get() + netFull.get(); }
+    uint32_t getIgnored() const { return ignoredEvents.get(); }
+    uint32_t getUiWakeups() const { return uiWakeups.get(); }
+    const ButtonGestures& getGestures() const { return gestures; }
+    const MetricHistogram& getUiPassTimes() const { return uiPassUs; }
+    const FramePacer& getFramePacer() const { return pacer; }
+};
+
+#endif // APP_TASKS_H
@@ -0,0 +1,171 @@
+/*
+ * ============================================
+ * Streaming Base64 Codec
+ * ============================================
+ *
+ * Handles:
+ * - Chunked encoding with carry between calls
+ * - Chunked decoding (whitespace tolerant)
+ * - Exact output sizes so frames can be sized
+ *   before any data is produced
+ *
+ * Used to move PCM audio through JSON events
+ * without holding whole clips in memory.
+ *
+ * ============================================
+ */
+
+#ifndef BASE64_STREAM_H
+#define BASE64_STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================
+// ENCODER
+// ============================================
+
+class Base64Encoder {
+private:
+    uint8_t carry[3];
+    uint8_t carryLen;
+
+    static char symbol(uint8_t v) {
+        static const char table[] =
+            "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        return table[v & 0x3F];
+    }
+
+    static void encodeGroup(const uint8_t* g, char* out) {
+        out[0] = symbol(g[0] >> 2);
+        out[1] = symbol(((g[0] & 0x03) << 4) | (g[1] >> 4));
+        out[2] = symbol(((g[1] & 0x0F) << 2) | (g[2] >> 6));
+        out[3] = symbol(g[2]);
+    }
+
+public:
+    Base64Encoder() : carryLen(0) {}
+
+    // Final encoded length of n input bytes, including padding
+    static size_t encodedLength(size_t n) {
+        return ((n + 2) / 3) * 4;
+    }
+
+    void reset() {
+        carryLen = 0;
+    }
+
+    // Encode as many whole groups as fit in out. Returns the number
+    // of characters written; *consumed reports input bytes taken
+    // (a partial group is carried into the next call).
+    size_t update(const uint8_t* in, size_t n, char* out, size_t outCap, size_t* consumed = nullptr) {
+        size_t written = 0;
+        size_t used = 0;
+
+        while (used < n) {
+            if (carryLen == 3) {
+                if (outCap - written < 4) break;
+                encodeGroup(carry, out + written);
+                written += 4;
+                carryLen = 0;
+            } else if (carryLen == 0 && n - used >= 3) {
+                if (outCap - written < 4) break;
+                encodeGroup(in + used, out + written);
+                used += 3;
+                written += 4;
+            } else {
+                carry[carryLen++] = in[used++];
+            }
+        }
+
+        if (carryLen == 3 && outCap - written >= 4) {
+            encodeGroup(carry, out + written);
+            written += 4;
+            carryLen = 0;
+        }
+
+        if (consumed) *consumed = used;
+        return written;
+    }
+
+    // Flush the carried bytes with '=' padding. Needs 4 bytes of room.
+    size_t finish(char* out) {
+        if (carryLen == 0) return 0;
+        uint8_t g[3] = { carry[0], 0, 0 };
+        if (carryLen > 1) g[1] = carry[1];
+        if (carryLen > 2) g[2] = carry[2];
+        encodeGroup(g, out);
+        if (carryLen == 1) out[2] = '=';
+        if (carryLen < 3) out[3] = '=';
+        carryLen = 0;
+        return 4;
+    }
+};
+
+// ============================================
+// DECODER
+// ============================================
+
+class Base64Decoder {
+private:
+    uint32_t acc;
+    uint8_t bits;
+    bool done;      // Saw padding
+    bool invalid;
+
+    static int value(char c) {
+        if (c >= 'A' && c <= 'Z') return c - 'A';
+        if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+        if (c >= '0' && c <= '9') return c - '0' + 52;
+        if (c == '+' || c == '-') return 62;   // '-' / '_' are the URL-safe forms
+        if (c == '/' || c == '_') return 63;
+        return -1;
+    }
+
+public:
+    Base64Decoder() : acc(0), bits(0), done(false), invalid(false) {}
+
+    // Upper bound of decoded bytes for n input characters
+    static size_t decodedMax(size_t n) {
+        return (n / 4) * 3 + 3;
+    }
+
+    void reset() {
+        acc = 0;
+        bits = 0;
+        done = false;
+        invalid = false;
+    }
+
+    // Decode up to n characters. out must hold decodedMax(n) bytes.
+    // Returns the number of bytes produced.
+    size_t update(const char* in, size_t n, uint8_t* out) {
+        size_t produced = 0;
+        for (size_t i = 0; i < n; i++) {
+            char c = in[i];
+            if (c == '=') {
+                done = true;
+                continue;
+            }
+            if (c == ' ' || c == '\r' || c == '\n' || c == '\t') continue;
+            int v = value(c);
+            if (v < 0 || done) {
+                invalid = true;
+                continue;
+            }
+            acc = (acc << 6) | (uint32_t)v;
+            bits += 6;
+            if (bits >= 8) {
+                bits -= 8;
+                out[produced++] = (uint8_t)(acc >> bits);
+            }
+        }
+        return produced;
+    }
+
+    bool hasError() const {
+        return invalid;
+    }
+};
+
+#endif // BASE64_STREAM_H
@@ -0,0 +1,258 @@
+/*
+ * ============================================
+ * Board Traits - What Each Board Has
+ * ============================================
+ *
+ * Handles:
+ * - Pins: microphone, speaker, display,
+ *   button, LED, battery (-1: not on this
+ *   board), and which level lights the LED
+ * - Display: controller, size, bus pins,
+ *   backlight, whether it scrolls rows itself
+ * - I2S topology: microphone and speaker on
+ *   ports of their own, or one port and one
+ *   set of clock pins, installed for one
+ *   direction at a time
+ * - PSRAM, and the battery's voltage divider
+ * - Checks on every board (static_assert):
+ *   two uses of one pin, a port shared the
+ *   wrong way or a display without its bus
+ *   fails the build, not the first turn
+ *
+ * One struct of constants per board. Board is
+ * the one being built: the HU-087, or with
+ * VOLT_BOARD_SSD1306 defined, the ESP32 with an
+ * SSD1306 OLED of restored_code/. Code reads
+ * Board::Mic::SD and the like and tests traits
+ * with plain ifs on constants, so the other
+ * board's side compiles away: nothing is
+ * looked up or dispatched at run time.
+ * pins_hu087.h keeps the pin names the sketch
+ * has always used, for the selected board.
+ *
+ * Constants only, no hardware access: the host
+ * build compiles and tests each board.
+ *
+ * ============================================
+ */
+
+#ifndef BOARD_TRAITS_H
+#define BOARD_TRAITS_H
+
+#include <stdint.h>
+
+enum BoardDisplayKind {
+    BOARD_DISPLAY_ST7789 = 0,    // SPI, RGB565 (TFT_eSPI)
+    BOARD_DISPLAY_SSD1306 = 1    // I2C, monochrome (Adafruit_SSD1306)
+};
+
+enum BoardI2sTopology {
+    BOARD_I2S_SEPARATE = 0,      // Microphone and speaker on their own ports and pins
+    BOARD_I2S_SHARED = 1         // One port and clock, reinstalled per direction
+};
+
+// ============================================
+// BOARDS
+// ============================================
+
+// XiaoZhi HU-087 ESP32-S3 watch kit (verified pin assignments)
+struct BoardHu087 {
+    static const char* name() { return "HU-087"; }
+
+    struct Mic {                 // INMP441 I2S MEMS
+        static constexpr int WS = 4;
+        static constexpr int SCK = 5;
+        static constexpr int SD = 6;
+        static constexpr int PORT = 0;
+    };
+
+    struct Speaker {             // MAX98357A I2S class-D amplifier
+        static constexpr int DOUT = 7;
+        static constexpr int BCLK = 15;
+        static constexpr int LRCK = 16;
+        static constexpr int SD_MODE = 17;   // Amplifier on while HIGH
+        static constexpr int PORT = 1;
+    };
+
+    static constexpr BoardI2sTopology I2S = BOARD_I2S_SEPARATE;
+
+    struct Display {             // 1.47" ST7789 IPS
+        static constexpr BoardDisplayKind KIND = BOARD_DISPLAY_ST7789;
+        static constexpr int WIDTH = 172;
+        static constexpr int HEIGHT = 320;
+        static constexpr int SCLK = 21;
+        static constexpr int MOSI = 47;
+        static constexpr int CS = 41;
+        static constexpr int DC = 40;
+        static constexpr int RST = 45;
+        static constexpr int SDA = -1;
+        static constexpr int SCL = -1;
+        static constexpr int I2C_ADDRESS = 0;
+        static constexpr int BL = 42;
+        static constexpr bool BL_ACTIVE_LOW = true;
+        static constexpr bool SCROLLS = true;    // VSCRDEF/VSCRSADD (ui_scene.h)
+    };
+
+    static constexpr int BUTTON = 0;         // BOOT, the one button
+    static constexpr int LED = 48;           // Built-in white LED
+    static constexpr bool LED_ACTIVE_LOW = false;
+    static constexpr bool PSRAM = true;
+
+    struct Battery {
+        static constexpr int PIN = -1;       // Not wired on the stock kit
+        static constexpr int DIVIDER = 2;
+    };
+};
+
+// ESP32 DevKit with a 128x64 SSD1306 on I2C and one I2S port for
+// both directions (restored_code/VoltAI.h, full_featured.ino)
+struct BoardSsd1306 {
+    static const char* name() { return "ESP32 + SSD1306"; }
+
+    struct Mic {
+        static constexpr int WS = 15;
+        static constexpr int SCK = 2;
+        static constexpr int SD = 13;
+        static constexpr int PORT = 0;
+    };
+
+    struct Speaker {             // Same port, clock and data pin as the mic
+        static constexpr int DOUT = 13;
+        static constexpr int BCLK = 2;
+        static constexpr int LRCK = 15;
+        static constexpr int SD_MODE = -1;   // Amplifier always on
+        static constexpr int PORT = 0;
+    };
+
+    static constexpr BoardI2sTopology I2S = BOARD_I2S_SHARED;
+
+    struct Display {
+        static constexpr BoardDisplayKind KIND = BOARD_DISPLAY_SSD1306;
+        static constexpr int WIDTH = 128;
+        static constexpr int HEIGHT = 64;
+        static constexpr int SCLK = -1;
+        static constexpr int MOSI = -1;
+        static constexpr int CS = -1;
+        static constexpr int DC = -1;
+        static constexpr int RST = -1;
+        static constexpr int SDA = 21;       // Wire's defaults
+        static constexpr int SCL = 22;
+        static constexpr int I2C_ADDRESS = 0x3C;
+        static constexpr int BL = -1;        // Self-lit
+        static constexpr bool BL_ACTIVE_LOW = false;
+        static constexpr bool SCROLLS = false;
+    };
+
+    static constexpr int BUTTON = 0;
+    static constexpr int LED = -1;           // GPIO 2 is the I2S clock here
+    static constexpr bool LED_ACTIVE_LOW = false;
+    static constexpr bool PSRAM = false;     // WROOM module
+
+    struct Battery {
+        static constexpr int PIN = 35;       // Through a 1:2 divider (power_management.h)
+        static constexpr int DIVIDER = 2;
+    };
+};
+
+#if defined(VOLT_BOARD_SSD1306)
+typedef BoardSsd1306 Board;
+#else
+typedef BoardHu087 Board;
+#endif
+
+// ============================================
+// CHECKS
+// ============================================
+
+// A GPIO of the ESP32-S3 or ESP32, or -1 for none
+constexpr bool boardPinsValid() { return true; }
+
+template <typename... Rest>
+constexpr bool boardPinsValid(int pin, Rest... rest) {
+    return pin >= -1 && pin <= 48 && boardPinsValid(rest...);
+}
+
+// No pin used twice (-1s don't count)
+constexpr bool boardPinUnused(int) { return true; }
+
+template <typename... Rest>
+constexpr bool boardPinUnused(int pin, int other, Rest... rest) {
+    return (pin < 0 || pin != other) && boardPinUnused(pin, rest...);
+}
+
+constexpr bool boardPinsDistinct() { return true; }
+
+template <typename... Rest>
+constexpr bool boardPinsDistinct(int pin, Rest... rest) {
+    return boardPinUnused(pin, rest...) && boardPinsDistinct(rest...);
+}
+
+// Every pin the board uses; a shared I2S port's speaker pins are
+// the microphone's
+template <typename B>
+constexpr bool boardPinsOk() {
+    return boardPinsValid(B::Mic::WS, B::Mic::SCK, B::Mic::SD, B::Speaker::DOUT, B::Speaker::BCLK,
+                          B::Speaker::LRCK, B::Speaker::SD_MODE, B::Display::SCLK, B::Display::MOSI,
+                          B::Display::CS, B::Display::DC, B::Display::RST, B::Display::SDA, B::Display::SCL,
+                          B::Display::BL, B::BUTTON, B::LED, B::Battery::PIN) &&
+           boardPinsDistinct(B::Mic::WS, B::Mic::SCK, B::Mic::SD,
+                             B::I2S == BOARD_I2S_SHARED && B::Speaker::DOUT == B::Mic::SD ? -1 : B::Speaker::DOUT,
+                             B::I2S == BOARD_I2S_SHARED ? -1 : B::Speaker::BCLK,
+                             B::I2S == BOARD_I2S_SHARED ? -1 : B::Speaker::LRCK, B::Speaker::SD_MODE,
+                             B::Display::SCLK, B::Display::MOSI, B::Display::CS, B::Display::DC, B::Display::RST,
+                             B::Display::SDA, B::Display::SCL, B::Display::BL, B::BUTTON, B::LED, B::Battery::PIN);
+}
+
+template <typename B>
+struct BoardCheck {
+    static_assert(boardPinsOk<B>(), "A board pin is out of range or used twice");
+    static_assert(B::Mic::WS >= 0 && B::Mic::SCK >= 0 && B::Mic::SD >= 0 && B::Speaker::DOUT >= 0 &&
+                  B::Speaker::BCLK >= 0 && B::Speaker::LRCK >= 0 && B::BUTTON >= 0,
+                  "Every board needs a microphone, a speaker and a button");
+    static_assert(B::Mic::PORT >= 0 && B::Mic::PORT <= 1 && B::Speaker::PORT >= 0 && B::Speaker::PORT <= 1,
+                  "I2S ports are 0 and 1");
+    static_assert(B::I2S == BOARD_I2S_SHARED ?
+                  B::Mic::PORT == B::Speaker::PORT && B::Mic::SCK == B::Speaker::BCLK &&
+                  B::Mic::WS == B::Speaker::LRCK :
+                  B::Mic::PORT != B::Speaker::PORT,
+                  "A shared I2S port has one port and one clock; separate ones have a port each");
+    static_assert(B::Display::WIDTH > 0 && B::Display::HEIGHT > 0, "The display has a size");
+    static_assert(B::Display::KIND != BOARD_DISPLAY_ST7789 ||
+                  (B::Display::SCLK >= 0 && B::Display::MOSI >= 0 && B::Display::DC >= 0 &&
+                   B::Display::WIDTH <= 240 && B::Display::HEIGHT <= 320),
+                  "An ST7789 needs its SPI pins and is at most 240x320");
+    static_assert(B::Display::KIND != BOARD_DISPLAY_SSD1306 ||
+                  (B::Display::SDA >= 0 && B::Display::SCL >= 0 && B::Display::I2C_ADDRESS > 0),
+                  "An SSD1306 needs its I2C pins and address");
+    static_assert(!B::Display::SCROLLS || B::Display::KIND == BOARD_DISPLAY_ST7789,
+                  "Only the ST7789 scrolls rows itself");
+    static_assert(B::Battery::DIVIDER >= 1, "The battery divider is at least 1:1");
+    static constexpr bool OK = true;
+};
+
+// Every board, whichever is built
+static_assert(BoardCheck<BoardHu087>::OK, "HU-087");
+static_assert(BoardCheck<BoardSsd1306>::OK, "ESP32 + SSD1306");
+
+// ============================================
+// LED
+// ============================================
+
+// Whether the LED pin goes high to turn the LED on (or off)
+template <typename B>
+constexpr bool boardLedHigh(bool on) {
+    return on != B::LED_ACTIVE_LOW;
+}
+
+// ============================================
+// BATTERY
+// ============================================
+
+// Millivolts at the battery for a 12-bit reading of its divided
+// voltage (3.3 V full scale)
+template <typename B>
+constexpr int boardBatteryMillivolts(int raw) {
+    return (int)((int32_t)raw * 3300 * B::Battery::DIVIDER / 4095);
+}
+
+#endif // BOARD_TRAITS_H
@@ -0,0 +1,301 @@
+/*
+ * ============================================
+ * Boot Sequencer - Phases and Boot Timeline
+ * ============================================
+ *
+ * Handles:
+ * - Boot as a table of phases (display, WiFi,
+ *   AI, ...), each started once its `after`
+ *   phases have finished and polled until done:
+ *   WiFi associates while the display and the
+ *   AI come up, instead of one after the other
+ * - Phases that only a cold boot needs (splash,
+ *   greeting), skipped when the button woke the
+ *   watch from deep sleep
+ * - Ready: the phases the button waits for are
+ *   finished, so the app can start while the
+ *   rest (WiFi, usually) keeps going in loop()
+ * - Timeouts per phase; a phase that needs
+ *   another to have worked is skipped if it
+ *   didn't
+ * - The boot timeline: start and end of every
+ *   phase in microseconds since the chip
+ *   started, when setup() began, ready and
+ *   done. Serial "boot" report, JSON for
+ *   GET /api/boot, gauges for /api/metrics
+ *
+ * setup() used to hold the button for over 8 s
+ * of fixed delays on every wake. Phases here
+ * never wait: a slow one (WiFi) is started and
+ * then polled, and the caller sleeps POLL_MS
+ * only when nothing moved. Phases start in the
+ * order they were added.
+ *
+ * Time comes from halMicros(), so host tests
+ * play whole boots on the virtual clock. Steps
+ * run on one task; the API task may read the
+ * timeline while the last phases finish and see
+ * one of them mid-update.
+ *
+ * ============================================
+ */
+
+#ifndef BOOT_SEQUENCER_H
+#define BOOT_SEQUENCER_H
+
+#include <stdint.h>
+#include "volt_hal.h"
+#include "metrics.h"
+
+enum BootState {
+    BOOT_WAITING = 0,        // For its `after` phases
+    BOOT_RUNNING,            // Started, polled until done
+    BOOT_OK,
+    BOOT_FAILED,
+    BOOT_TIMED_OUT,
+    BOOT_SKIPPED             // Cold boot only, or what it needed failed
+};
+
+// Phase flags
+enum {
+    BOOT_COLD_ONLY = 0x01,   // Not after a button wake (splash, greeting)
+    BOOT_BEFORE_READY = 0x02,// The button waits for it
+    BOOT_IF_OK = 0x04        // Skipped unless every `after` phase worked
+};
+
+class BootSequencer {
+public:
+    static const int MAX_PHASES = 12;
+    static const uint32_t POLL_MS = 10;
+
+    // Starts or polls a phase: BOOT_RUNNING while it isn't done yet,
+    // else BOOT_OK or BOOT_FAILED
+    typedef BootState (*StepFn)(void* ctx);
+    typedef void (*IdleFn)(void* ctx);
+
+    struct Phase {
+        const char* name;
+        StepFn start;
+        StepFn poll;             // nullptr: start() finishes it
+        void* ctx;
+        uint32_t after;          // Bit i: phase i finishes first
+        uint32_t timeoutMs;      // 0: none
+        uint8_t flags;
+        BootState state;
+        uint32_t startUs;
+        uint32_t endUs;
+    };
+
+private:
+    Phase phases[MAX_PHASES];
+    int phaseCount;
+    HalWakeCause wake;
+    uint32_t beginUs;
+    uint32_t readyUs;
+    uint32_t doneUs;
+    bool ready;
+    bool done;
+
+    MetricGauge readyMs;
+    MetricGauge doneMs;
+
+    static bool finished(BootState s) { return s >= BOOT_OK; }
+
+    void finish(Phase& p, BootState s, uint32_t now) {
+        p.state = s;
+        p.endUs = now;
+        halLog("Boot: %s %s (%lu ms)\n", p.name, stateName(s),
+               (unsigned long)((p.endUs - p.startUs) / 1000));
+    }
+
+    // Whether every `after` phase has finished; allOk if they all
+    // worked
+    bool afterFinished(const Phase& p, bool& allOk) const {
+        allOk = true;
+        for (int i = 0; i < phaseCount; i++) {
+            if (!(p.after & (1u << i))) continue;
+            if (!finished(phases[i].state)) return false;
+            if (phases[i].state != BOOT_OK) allOk = false;
+        }
+        return true;
+    }
+
+    bool allFinished(uint8_t flags) const {
+        for (int i = 0; i < phaseCount; i++) {
+            if ((phases[i].flags & flags) == flags && !finished(phases[i].state)) return false;
+        }
+        return true;
+    }
+
+public:
+    BootSequencer()
+        : phaseCount(0), wake(HAL_WAKE_POWER_ON), beginUs(0), readyUs(0), doneUs(0), ready(false),
+          done(false),
+          readyMs("volt_boot_ready_ms", "Chip start to the button working, this boot"),
+          doneMs("volt_boot_done_ms", "Chip start to the last boot phase, this boot") {}
+
+    // The bit for `after`; -1 (a phase that wasn't added) is none
+    static uint32_t bit(int phase) { return phase < 0 ? 0 : 1u << phase; }
+
+    static const char* stateName(BootState s) {
+        switch (s) {
+            case BOOT_WAITING: return "waiting";
+            case BOOT_RUNNING: return "running";
+            case BOOT_OK: return "ok";
+            case BOOT_FAILED: return "failed";
+            case BOOT_TIMED_OUT: return "timeout";
+            case BOOT_SKIPPED: return "skipped";
+        }
+        return "?";
+    }
+
+    static const char* wakeName(HalWakeCause cause) {
+        switch (cause) {
+            case HAL_WAKE_POWER_ON: return "power_on";
+            case HAL_WAKE_BUTTON: return "button";
+            case HAL_WAKE_TIMER: return "timer";
+            case HAL_WAKE_OTHER: return "other";
+        }
+        return "?";
+    }
+
+    // Clears the phases; the timeline starts now
+    void begin(HalWakeCause cause) {
+        phaseCount = 0;
+        wake = cause;
+        beginUs = (uint32_t)halMicros();
+        readyUs = doneUs = 0;
+        ready = done = false;
+        readyMs.set(0);
+        doneMs.set(0);
+    }
+
+    // -1 if the table is full
+    int add(const char* name, StepFn start, StepFn poll, void* ctx, uint32_t after = 0,
+            uint8_t flags = 0, uint32_t timeoutMs = 0) {
+        if (phaseCount >= MAX_PHASES) return -1;
+        phases[phaseCount] = { name, start, poll, ctx, after, timeoutMs, flags, BOOT_WAITING, 0, 0 };
+        return phaseCount++;
+    }
+
+    // Starts what can start and polls what is running, in table
+    // order; true if a phase started or finished
+    bool step() {
+        bool moved = false;
+        for (int i = 0; i < phaseCount; i++) {
+            Phase& p = phases[i];
+            uint32_t now = (uint32_t)halMicros();
+            if (p.state == BOOT_WAITING) {
+                bool allOk;
+                bool coldOnly = (p.flags & BOOT_COLD_ONLY) && wake == HAL_WAKE_BUTTON;
+                if (!afterFinished(p, allOk) && !coldOnly) continue;
+                moved = true;
+                p.startUs = now;
+                if (coldOnly || ((p.flags & BOOT_IF_OK) && !allOk)) {
+                    finish(p, BOOT_SKIPPED, now);
+                    continue;
+                }
+                p.state = BOOT_RUNNING;
+                BootState s = p.start ? p.start(p.ctx) : BOOT_RUNNING;
+                if (s != BOOT_RUNNING || !p.poll) {
+                    finish(p, s == BOOT_RUNNING ? BOOT_OK : s, (uint32_t)halMicros());
+                }
+                continue;
+            }
+            if (p.state != BOOT_RUNNING) continue;
+            BootState s = p.poll(p.ctx);
+            now = (uint32_t)halMicros();
+            if (s != BOOT_RUNNING) {
+                finish(p, s, now);
+                moved = true;
+            } else if (p.timeoutMs && now - p.startUs >= p.timeoutMs * 1000) {
+                finish(p, BOOT_TIMED_OUT, now);
+                moved = true;
+            }
+        }
+
+        uint32_t now = (uint32_t)halMicros();
+        if (!ready && allFinished(BOOT_BEFORE_READY)) {
+            ready = true;
+            readyUs = now;
+            readyMs.set((int32_t)(now / 1000));
+        }
+        if (!done && allFinished(0)) {
+            done = true;
+            doneUs = now;
+            doneMs.set((int32_t)(now / 1000));
+        }
+        return moved;
+    }
+
+    // Steps until the button may be used, sleeping POLL_MS whenever
+    // nothing moved; idle(ctx) runs before each sleep (the sketch
+    // feeds the watchdog there)
+    void runUntilReady(IdleFn idle = nullptr, void* ctx = nullptr) {
+        while (!ready) {
+            if (step()) continue;
+            if (idle) idle(ctx);
+            if (!ready) halDelay(POLL_MS);
+        }
+    }
+
+    // Bits of the phases that have finished
+    uint32_t doneMask() const {
+        uint32_t mask = 0;
+        for (int i = 0; i < phaseCount; i++) {
+            if (finished(phases[i].state)) mask |= 1u << i;
+        }
+        return mask;
+    }
+
+    bool isReady() const { return ready; }
+    bool isDone() const { return done; }
+    HalWakeCause getWake() const { return wake; }
+    uint32_t getBeginUs() const { return beginUs; }
+    uint32_t getReadyUs() const { return readyUs; }
+    uint32_t getDoneUs() const { return doneUs; }
+    int getPhaseCount() const { return phaseCount; }
+    const Phase& getPhase(int i) const { return phases[i]; }
+
+    void registerMetrics(MetricsRegistry& registry) {
+        registry.add(&readyMs);
+        registry.add(&doneMs);
+    }
+
+    // GET /api/boot; 0 for ready_us / done_us not reached yet
+    void writeJson(Print& out) const {
+        out.printf("{\"wake\":\"%s\",\"setup_us\":%lu,\"ready_us\":%lu,\"done_us\":%lu,\"phases\":[",
+                   wakeName(wake), (unsigned long)beginUs, (unsigned long)readyUs,
+                   (unsigned long)doneUs);
+        for (int i = 0; i < phaseCount; i++) {
+            const Phase& p = phases[i];
+            out.printf("%s{\"name\":\"%s\",\"state\":\"%s\",\"start_us\":%lu,\"end_us\":%lu}",
+                       i ? "," : "", p.name, stateName(p.state), (unsigned long)p.startUs,
+                       (unsigned long)p.endUs);
+        }
+        out.print("]}");
+    }
+
+    // Serial "boot" command: ms since the chip started
+    void printReport(Print& out) const {
+        out.printf("=== Boot (%s wake) ===\n", wakeName(wake));
+        out.printf("  setup %lu ms, ready %lu ms, done %lu ms\n", (unsigned long)(beginUs / 1000),
+                   (unsigned long)(readyUs / 1000), (unsigned long)(doneUs / 1000));
+        out.printf("  %-10s %-8s %9s %9s\n", "phase", "state", "start ms", "took ms");
+        for (int i = 0; i < phaseCount; i++) {
+            const Phase& p = phases[i];
+            bool ran = p.state != BOOT_WAITING;
+            out.printf("  %-10s %-8s %9lu %9lu%s\n", p.name, stateName(p.state),
+                       ran ? (unsigned long)(p.startUs / 1000) : 0ul,
+                       finished(p.state) ? (unsigned long)((p.endUs - p.startUs) / 1000) : 0ul,
+                       ready && finished(p.state) && p.endUs > readyUs ? "  (after ready)" : "");
+        }
+    }
+};
+
+inline BootSequencer& bootSequencer() {
+    static BootSequencer boot;
+    return boot;
+}
+
+#endif // BOOT_SEQUENCER_H
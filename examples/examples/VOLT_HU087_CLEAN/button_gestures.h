@@ -0,0 +1,212 @@
+/*
+ * ============================================
+ * Button Gestures - Edge-Driven Press Patterns
+ * ============================================
+ *
+ * Handles:
+ * - Debounce: a level counts once it has been
+ *   stable for settleMs after the last edge
+ * - Multi-press counting (1 = talk, 2 = joke...)
+ * - Long press (released after longPressMs)
+ * - SOS hold: a warning at sosWarnMs, the alert
+ *   at sosHoldMs, a cancel if released between
+ * - The next time anything is due, so the
+ *   caller can sleep until then or the next
+ *   edge instead of polling the pin
+ *
+ * Fed by edges (from a pin interrupt, through
+ * a queue) rather than a level every 10 ms like
+ * button_input.h. The pattern itself is the
+ * rules() table: state + input (press, release,
+ * timer) -> gesture, next state and the timer
+ * to start. Pure, no hardware access:
+ * host tests replay edge timelines on a virtual
+ * clock.
+ *
+ * ============================================
+ */
+
+#ifndef BUTTON_GESTURES_H
+#define BUTTON_GESTURES_H
+
+#include <stdint.h>
+
+enum Gesture {
+    GESTURE_NONE,
+    GESTURE_DOWN,            // Press started (activity)
+    GESTURE_CLICK,           // Press released and counted
+    GESTURE_PRESSES,         // Pattern finished, see getPressCount()
+    GESTURE_LONG_PRESS,      // Released after longPressMs
+    GESTURE_SOS_WARNING,     // Still held at sosWarnMs
+    GESTURE_SOS_CANCEL,      // Released after the warning, before the alert
+    GESTURE_SOS              // Held for sosHoldMs
+};
+
+struct GestureTiming {
+    unsigned long settleMs;      // Contact bounce
+    unsigned long multiPressMs;  // Gap that ends a pattern
+    unsigned long longPressMs;
+    unsigned long sosWarnMs;
+    unsigned long sosHoldMs;
+};
+
+class ButtonGestures {
+public:
+    static const uint32_t NO_TIMER = 0xFFFFFFFF;
+
+    static GestureTiming defaultTiming() {
+        return { 30, 600, 2000, 3000, 5000 };
+    }
+
+private:
+    enum State : uint8_t { S_IDLE, S_DOWN, S_HELD, S_WARNED, S_SENT, S_GAP };
+    enum Input : uint8_t { IN_PRESS, IN_RELEASE, IN_TIMEOUT };
+    enum Timer : uint8_t { T_NONE, T_LONG, T_WARN, T_SOS, T_GAP };
+
+    struct Rule {
+        uint8_t state;
+        uint8_t input;
+        uint8_t gesture;
+        uint8_t next;
+        uint8_t timer;
+    };
+
+    // Anything not listed (a release nobody saw pressed, a press
+    // while the alert's press is still down) is dropped and counted
+    static const Rule* rules(int* count) {
+        static const Rule table[] = {
+            { S_IDLE,   IN_PRESS,   GESTURE_DOWN,        S_DOWN,   T_LONG },
+            { S_DOWN,   IN_RELEASE, GESTURE_CLICK,       S_GAP,    T_GAP  },
+            { S_DOWN,   IN_TIMEOUT, GESTURE_NONE,        S_HELD,   T_WARN },
+            { S_HELD,   IN_RELEASE, GESTURE_LONG_PRESS,  S_IDLE,   T_NONE },
+            { S_HELD,   IN_TIMEOUT, GESTURE_SOS_WARNING, S_WARNED, T_SOS  },
+            { S_WARNED, IN_RELEASE, GESTURE_SOS_CANCEL,  S_IDLE,   T_NONE },
+            { S_WARNED, IN_TIMEOUT, GESTURE_SOS,         S_SENT,   T_NONE },
+            { S_SENT,   IN_RELEASE, GESTURE_NONE,        S_IDLE,   T_NONE },
+            { S_GAP,    IN_PRESS,   GESTURE_DOWN,        S_DOWN,   T_LONG },
+            { S_GAP,    IN_TIMEOUT, GESTURE_PRESSES,     S_IDLE,   T_NONE },
+        };
+        *count = (int)(sizeof(table) / sizeof(table[0]));
+        return table;
+    }
+
+    GestureTiming timing;
+    uint8_t state;
+    bool raw;                // Level of the last edge
+    bool stable;             // Debounced level
+    bool settling;
+    unsigned long settleAt;
+    bool timed;
+    unsigned long deadline;
+    int presses;
+    int pressCount;
+    uint32_t unmatched;
+
+    static bool due(unsigned long at, unsigned long now) { return (long)(now - at) >= 0; }
+
+    // A settling edge from before the timer goes first
+    bool settleFirst() const {
+        return settling && (!timed || due(settleAt - timing.settleMs, deadline));
+    }
+
+    unsigned long timerMs(uint8_t timer) const {
+        switch (timer) {
+            case T_LONG: return timing.longPressMs;
+            case T_WARN: return timing.sosWarnMs - timing.longPressMs;
+            case T_SOS: return timing.sosHoldMs - timing.sosWarnMs;
+            case T_GAP: return timing.multiPressMs;
+            default: return 0;
+        }
+    }
+
+    // One input at time at; timers run from when the input was due,
+    // not from when it was noticed, so a late wakeup doesn't stretch
+    // the next step
+    Gesture apply(uint8_t input, unsigned long at) {
+        int n;
+        const Rule* table = rules(&n);
+        for (int i = 0; i < n; i++) {
+            const Rule& r = table[i];
+            if (r.state != state || r.input != input) continue;
+
+            state = r.next;
+            timed = r.timer != T_NONE;
+            deadline = at + timerMs(r.timer);
+            if (r.gesture == GESTURE_CLICK) presses++;
+            if (r.gesture == GESTURE_PRESSES) pressCount = presses;
+            if (state == S_IDLE) presses = 0;
+            return (Gesture)r.gesture;
+        }
+        unmatched++;
+        return GESTURE_NONE;
+    }
+
+public:
+    ButtonGestures() { begin(defaultTiming()); }
+
+    void begin(const GestureTiming& t) {
+        timing = t;
+        state = S_IDLE;
+        raw = stable = false;
+        settling = timed = false;
+        settleAt = deadline = 0;
+        presses = pressCount = 0;
+        unmatched = 0;
+    }
+
+    // An edge: the level just after it and when it happened. Call
+    // poll(at) first, or a level that settled before this edge is
+    // lost. Not for an interrupt handler; queue edges from there.
+    void edge(bool pressed, unsigned long at) {
+        raw = pressed;
+        settling = true;
+        settleAt = at + timing.settleMs;
+    }
+
+    // Runs whatever is due by now and returns the next gesture;
+    // call until GESTURE_NONE. Inputs go in the order they happened:
+    // a release just before the long press timer is still a click,
+    // even though it only settles after the timer.
+    Gesture poll(unsigned long now) {
+        for (;;) {
+            uint8_t input;
+            unsigned long at;
+            if (settleFirst()) {
+                if (!due(settleAt, now)) return GESTURE_NONE;
+                settling = false;
+                if (raw == stable) continue;    // Bounced back
+                stable = raw;
+                input = raw ? IN_PRESS : IN_RELEASE;
+                at = settleAt - timing.settleMs;
+            } else if (timed) {
+                if (!due(deadline, now)) return GESTURE_NONE;
+                timed = false;
+                input = IN_TIMEOUT;
+                at = deadline;
+            } else {
+                return GESTURE_NONE;
+            }
+            Gesture g = apply(input, at);
+            if (g != GESTURE_NONE) return g;
+        }
+    }
+
+    // Until poll() has something to do; NO_TIMER when only an edge
+    // can change anything
+    uint32_t waitMs(unsigned long now) const {
+        unsigned long at;
+        if (settleFirst()) at = settleAt;
+        else if (timed) at = deadline;
+        else return NO_TIMER;
+        return due(at, now) ? 0 : (uint32_t)(at - now);
+    }
+
+    // Down or bouncing: a release must be seen on time, and a
+    // sleeping chip only wakes on a press
+    bool isActive() const { return stable || settling; }
+
+    int getPressCount() const { return pressCount; }
+    uint32_t getUnmatched() const { return unmatched; }
+};
+
+#endif // BUTTON_GESTURES_H
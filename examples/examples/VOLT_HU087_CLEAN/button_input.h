@@ -0,0 +1,104 @@
+/*
+ * ============================================
+ * Button Input - Press Patterns
+ * ============================================
+ *
+ * Handles:
+ * - Debounce
+ * - Multi-press counting (1 = talk, 2 = joke...)
+ * - Long press (Dad's message)
+ *
+ * Pure state machine: feed it the button level
+ * and the time, act on the event it returns.
+ * No hardware access, so it runs unchanged in
+ * host tests with a virtual clock.
+ *
+ * ============================================
+ */
+
+#ifndef BUTTON_INPUT_H
+#define BUTTON_INPUT_H
+
+enum ButtonEvent {
+    BUTTON_NONE,
+    BUTTON_DOWN,         // Press started (activity)
+    BUTTON_LONG_PRESS,   // Held for LONG_PRESS_MS as the first press
+    BUTTON_CLICK,        // Press released and counted
+    BUTTON_PRESSES       // Pattern finished, see getPressCount()
+};
+
+class ButtonInput {
+public:
+    static const unsigned long DEBOUNCE_MS = 250;
+    static const unsigned long MULTI_PRESS_MS = 600;
+    static const unsigned long LONG_PRESS_MS = 2000;
+
+private:
+    unsigned long pressStart;
+    unsigned long lastPress;
+    int presses;
+    int pressCount;
+    bool down;
+    bool waitRelease;    // Long press handled, ignore until released
+
+public:
+    ButtonInput()
+        : pressStart(0), lastPress(0), presses(0), pressCount(0),
+          down(false), waitRelease(false) {}
+
+    // Call every loop with the debounced-or-not button level
+    ButtonEvent update(bool pressed, unsigned long now) {
+        if (waitRelease) {
+            if (!pressed) {
+                waitRelease = false;
+            }
+            return BUTTON_NONE;
+        }
+
+        // Detect button press start
+        if (pressed && !down) {
+            pressStart = now;
+            down = true;
+            return BUTTON_DOWN;
+        }
+
+        // Detect long press (for love message)
+        if (pressed && down) {
+            if (now - pressStart >= LONG_PRESS_MS && presses == 0) {
+                down = false;
+                waitRelease = true;
+                return BUTTON_LONG_PRESS;
+            }
+            return BUTTON_NONE;
+        }
+
+        // Detect button release (for counting presses)
+        if (!pressed && down) {
+            down = false;
+            if (now - lastPress > DEBOUNCE_MS) {
+                presses++;
+                lastPress = now;
+                return BUTTON_CLICK;
+            }
+            return BUTTON_NONE;
+        }
+
+        // Pattern ends once no press follows within the timeout
+        if (presses > 0 && now - lastPress > MULTI_PRESS_MS) {
+            pressCount = presses;
+            presses = 0;
+            return BUTTON_PRESSES;
+        }
+        return BUTTON_NONE;
+    }
+
+    // Presses counted so far (BUTTON_CLICK) or in the
+    // finished pattern (BUTTON_PRESSES)
+    int getPressCount() const {
+        return presses > 0 ? presses : pressCount;
+    }
+
+    bool isDown() const { return down || waitRelease; }
+};
+
+#endif // BUTTON_INPUT_H
@@ -0,0 +1,131 @@
+/*
+ * ============================================
+ * Coalesced Timers - Periodic Housekeeping
+ * ============================================
+ *
+ * Handles:
+ * - Periodic jobs (battery, WiFi check, stats
+ *   samples...) with a slack each: a job may
+ *   run up to slackMs after it is due
+ * - Coalescing: the caller sleeps until the
+ *   first job has used up its slack, then every
+ *   job that is due runs in that one wakeup
+ * - Piggybacking: woken for something else
+ *   (a console line), due jobs run then too
+ * - Wakeups per hour, runs and worst lateness
+ *   per job, for the serial "timers" report
+ *
+ * Replaces millis() comparisons scattered over
+ * loop(), each of which woke the CPU on its own
+ * schedule. The next period counts from when a
+ * job ran, like those did, so jobs that ran
+ * together stay together.
+ *
+ * A table scan, not a timer wheel: there are a
+ * dozen jobs at most, and the scan gives the
+ * exact next wakeup. Pure, no hardware access;
+ * call from one task.
+ *
+ * ============================================
+ */
+
+#ifndef COALESCED_TIMERS_H
+#define COALESCED_TIMERS_H
+
+#include <stdint.h>
+
+class CoalescedTimers {
+public:
+    static const int MAX_JOBS = 12;
+    static const uint32_t NO_TIMER = 0xFFFFFFFF;
+
+    typedef void (*JobFn)(unsigned long now, void* ctx);
+
+    struct Job {
+        const char* name;
+        uint32_t periodMs;
+        uint32_t slackMs;
+        JobFn fn;
+        void* ctx;
+        unsigned long due;
+        uint32_t runs;
+        uint32_t maxLateMs;      // Worst run after due
+    };
+
+private:
+    Job jobs[MAX_JOBS];
+    int jobCount;
+    unsigned long since;
+    uint32_t wakeups;
+    uint32_t runs;
+
+    static bool due(unsigned long at, unsigned long now) { return (long)(now - at) >= 0; }
+
+public:
+    CoalescedTimers() : jobCount(0), since(0), wakeups(0), runs(0) {}
+
+    // Clears the jobs and starts the wakeups-per-hour window
+    void begin(unsigned long now) {
+        jobCount = 0;
+        since = now;
+        wakeups = runs = 0;
+    }
+
+    // First run periodMs from now; -1 if the table is full
+    int add(const char* name, uint32_t periodMs, uint32_t slackMs, JobFn fn, void* ctx,
+            unsigned long now) {
+        if (jobCount >= MAX_JOBS) return -1;
+        jobs[jobCount] = { name, periodMs, slackMs, fn, ctx, now + periodMs, 0, 0 };
+        return jobCount++;
+    }
+
+    // Runs every job that is due. A wakeup is counted when one of
+    // them had no slack left (the caller slept for it); returns the
+    // number of jobs run.
+    int run(unsigned long now) {
+        bool needed = false;
+        for (int i = 0; i < jobCount; i++) {
+            if (due(jobs[i].due + jobs[i].slackMs, now)) needed = true;
+        }
+        if (needed) wakeups++;
+
+        int n = 0;
+        for (int i = 0; i < jobCount; i++) {
+            Job& j = jobs[i];
+            if (!due(j.due, now)) continue;
+            uint32_t late = (uint32_t)(now - j.due);
+            if (late > j.maxLateMs) j.maxLateMs = late;
+            j.due = now + j.periodMs;
+            j.runs++;
+            n++;
+            if (j.fn) j.fn(now, j.ctx);
+        }
+        runs += n;
+        return n;
+    }
+
+    // Until some job runs out of slack; NO_TIMER with no jobs
+    uint32_t waitMs(unsigned long now) const {
+        uint32_t wait = NO_TIMER;
+        for (int i = 0; i < jobCount; i++) {
+            unsigned long at = jobs[i].due + jobs[i].slackMs;
+            uint32_t t = due(at, now) ? 0 : (uint32_t)(at - now);
+            if (t < wait) wait = t;
+        }
+        return wait;
+    }
+
+    uint32_t getWakeups() const { return wakeups; }
+    uint32_t getRuns() const { return runs; }
+
+    uint32_t wakeupsPerHour(unsigned long now) const {
+        unsigned long elapsed = now - since;
+        if (elapsed == 0) return 0;
+        return (uint32_t)((uint64_t)wakeups * 3600000ULL / elapsed);
+    }
+
+    int getJobCount() const { return jobCount; }
+    const Job& getJob(int i) const { return jobs[i]; }
+};
+
+#endif // COALESCED_TIMERS_H
@@ -67,6 +67,22 @@ const float AI_TEMPERATURE = 0.7;  // Creativity (0.0-2.0)
 const int MAX_TOKENS = 150;        // Response length
 const float TTS_SPEED = 1.0;       // Speech speed (0.25-4.0)
 
+// Realtime Mode (speech-to-speech over one WebSocket session)
+// Replies start while VOLT is still generating, instead of after
+// the Whisper -> Chat -> TTS round trips. Costs more per minute.
+const bool USE_REALTIME_MODE = false;
+const char* REALTIME_MODEL = "gpt-4o-mini-realtime-preview";
+const int REALTIME_SAMPLE_RATE = 24000;  // Realtime API audio is pcm16 @ 24 kHz
+
+// HTTP/2 (Whisper, Chat and TTS share one TLS connection; long
+// replies are spoken sentence by sentence with the next one prefetched)
+const bool USE_HTTP2 = false;
+
+// Hosts resolved as soon as WiFi connects (answers are cached,
+// and kept through deep sleep, for as long as their DNS TTL allows)
+const char* const DNS_PREWARM_HOSTS[] = { "api.openai.com" };
+const int DNS_PREWARM_HOST_COUNT = sizeof(DNS_PREWARM_HOSTS) / sizeof(DNS_PREWARM_HOSTS[0]);
+
 // ============================================
 // 🎯 STONE'S AI PERSONALITY
 // ============================================
@@ -115,6 +131,7 @@ const bool ENABLE_JOKES = true;
 const bool ENABLE_BREATHING_EXERCISES = true;
 const bool ENABLE_LOVE_MESSAGES = true;
 const bool ENABLE_WIFI_SETUP = true;
+const bool ENABLE_SOS_HOLD = true;       // Hold the button 5 s: "sos" alert on /api/events
 
 // ============================================
 // ⚙️ DISPLAY SETTINGS
@@ -122,8 +139,7 @@ const bool ENABLE_WIFI_SETUP = true;
 
 const int DISPLAY_BRIGHTNESS = 200;  // 0-255
 const int DISPLAY_TIMEOUT = 30;      // seconds
-const int SCREEN_WIDTH = 172;
-const int SCREEN_HEIGHT = 320;
+// Screen size comes with the board (board_traits.h)
 
 // ============================================
 // 🔋 POWER MANAGEMENT
@@ -140,6 +156,28 @@ const int SAMPLE_RATE = 16000;  // Hz
 const int RECORD_TIME_SEC = 5;  // seconds
 const int BUFFER_SIZE = (SAMPLE_RATE * RECORD_TIME_SEC);
 
+// ============================================
+// 🧠 MEMORY SETTINGS
+// ============================================
+
+// Scratch memory reused by every conversation turn
+// (request JSON, HTTP headers, API responses)
+const int TURN_ARENA_SIZE = 48 * 1024;  // bytes
+
+// Streaming buffers kept in internal RAM (PSRAM is too slow
+// to sit between the TLS socket and the I2S DMA)
+const int TTS_JITTER_BUFFER = 2048;  // bytes per TTS read
+const int HTTP_BUFFER_SIZE = 1024;   // request header scratch
+
+// Realtime mode: holds one incoming event (audio is streamed,
+// only the JSON around it is buffered)
+const int REALTIME_EVENT_BUFFER = 8 * 1024;  // bytes
+
+// HTTP/2: requests in flight at once, and the receive window
+// (and pool block) each stream gets
+const int H2_MAX_STREAMS = 3;
+const int H2_STREAM_WINDOW = 16 * 1024;  // bytes
+
 // ============================================
 // 🛠️ DEVELOPER OPTIONS
 // ============================================
@@ -147,4 +185,28 @@ const int BUFFER_SIZE = (SAMPLE_RATE * RECORD_TIME_SEC);
 const bool DEBUG_MODE = true;  // Enable serial debugging
 const bool VERBOSE_LOGGING = false;  // Detailed logs
 
+// Turn timing spans served at /api/trace (volt_trace.h);
+// 0 compiles every span out
+#ifndef VOLT_TRACE
+#define VOLT_TRACE 1
+#endif
+
+// Allocation call sites and heap fragmentation samples
+// (heap_profiler.h), dumped by the serial "heap" command
+// and /api/heap. Off: only the current heap numbers
+#ifndef VOLT_HEAP_PROFILE
+#define VOLT_HEAP_PROFILE 0
+#endif
+
+// Task CPU / stack / queue samples (task_stats.h), shown by the
+// serial "tasks" command and /api/metrics (0 = off)
+const unsigned long TASK_STATS_INTERVAL = 5000;  // ms
+
+// Timer-driven PC sampling for flame graphs (pc_profiler.h):
+// "prof start" / "prof dump" on serial, or /api/profile.
+// Adds an IRAM interrupt handler; off in normal builds
+#ifndef VOLT_PC_PROFILE
+#define VOLT_PC_PROFILE 0
+#endif
+
 #endif // CONFIG_STONE_H
@@ -0,0 +1,310 @@
+/*
+ * ============================================
+ * Device API - Local HTTP Endpoints
+ * ============================================
+ *
+ * Handles:
+ * - The routes of the watch's local API on
+ *   port 80, served by api_server.h
+ * - GET /api/status: uptime, app state,
+ *   battery, WiFi, heap and API load as JSON,
+ *   streamed straight into the socket buffer
+ * - GET /api/events: server-sent events
+ *   (event_hub.h) pushed as things change:
+ *   "status" (state, battery, WiFi), "steps"
+ *   and "sos" for firmware with an activity
+ *   tracker or SOS button (phase 1); POST
+ *   /api/sos/ack clears the alert
+ * - GET /api/trace: the last turns' spans
+ *   (volt_trace.h) as JSON, or with
+ *   ?format=chrome as a Chrome trace to load
+ *   in chrome://tracing or ui.perfetto.dev
+ * - GET /api/boot: this boot's timeline
+ *   (boot_sequencer.h): wake cause, when each
+ *   phase ran, when the button started working
+ * - GET /api/heap: the heap profiler's report
+ *   (heap_profiler.h) as text
+ * - GET /api/metrics: every registered metric
+ *   (metrics.h: requests, HTTP codes, WiFi,
+ *   battery, loop latency, tasks and queues) in
+ *   the Prometheus text format
+ * - POST /api/profile?hz=N starts a PC sample
+ *   capture (pc_profiler.h); GET stops it and
+ *   streams the samples for pcprof_symbolize.py
+ * - GET /: the list of routes (a constant)
+ *
+ * On the watch the server runs on its own task
+ * (begin() then startTask()), so a slow client
+ * never stalls the button and a turn never
+ * stalls a client. Handlers only read what is
+ * safe from another core: atomics, the trace
+ * rings, the heap profiler (locked) and task
+ * stats (may mix two samples). Example:
+ *   curl http://<watch-ip>/api/trace?format=chrome -o turn.json
+ *
+ * ============================================
+ */
+
+#ifndef DEVICE_API_H
+#define DEVICE_API_H
+
+#include <atomic>
+#include "volt_hal.h"
+#include "api_server.h"
+#include "event_hub.h"
+#include "volt_trace.h"
+#include "boot_sequencer.h"
+#include "heap_profiler.h"
+#include "metrics.h"
+#include "pc_profiler.h"
+
+// What /api/status reports that only the sketch knows. Set from
+// loop(), read by the server task.
+struct DeviceStatus {
+    std::atomic<const char*> state;   // "idle", "listening", ...
+    std::atomic<int> battery;         // Percent, -1 until measured
+    std::atomic<int> rssi;            // dBm of the last WiFi check, 0 if none
+
+    DeviceStatus() : state("booting"), battery(-1), rssi(0) {}
+};
+
+class DeviceApi {
+private:
+    ApiServer server;
+    DeviceStatus status;
+    EventHub events;
+    bool running;
+
+    // Last "status" event, so only changes are published (under
+    // statusLock: the ui, net and loop() tasks all publish)
+    HalLock statusLock;
+    const char* sentState;
+    int sentBattery;
+    bool sentConnected;
+
+    static const char* routeList() {
+        return "GET  /api/status\n"
+               "GET  /api/events\n"
+               "POST /api/sos/ack\n"
+               "GET  /api/trace[?format=chrome]\n"
+               "GET  /api/boot\n"
+               "GET  /api/heap\n"
+               "GET  /api/metrics\n"
+               "POST /api/profile[?hz=N]\n"
+               "GET  /api/profile\n";
+    }
+
+    static void printField(Print& out, const char* key, int64_t value) {
+        out.print(key);
+        metricsPrintI64(out, value);
+    }
+
+    // One piece: the whole object is ~300 bytes
+    static bool writeStatus(ApiChunk& out, uint32_t& cursor, void* ctx) {
+        DeviceApi* self = (DeviceApi*)ctx;
+        const DeviceStatus& st = self->status;
+        HalHeapInfo internal = halHeapInfo(HAL_HEAP_INTERNAL);
+        HalHeapInfo psram = halHeapInfo(HAL_HEAP_SPIRAM);
+        printField(out, "{\"uptime_ms\":", (int64_t)halMillis());
+        out.print(",\"state\":\"");
+        out.print(st.state.load());
+        printField(out, "\",\"battery\":", st.battery.load());
+        out.print(",\"wifi\":{\"connected\":");
+        out.print(halNetConnected() ? "true" : "false");
+        printField(out, ",\"rssi\":", st.rssi.load());
+        printField(out, "},\"heap\":{\"free\":", (int64_t)internal.freeBytes);
+        printField(out, ",\"largest\":", (int64_t)internal.largestFree);
+        printField(out, ",\"min_free\":", (int64_t)internal.minFree);
+        printField(out, ",\"psram_free\":", (int64_t)psram.freeBytes);
+        printField(out, "},\"api\":{\"connections\":", self->server.getActive());
+        printField(out, ",\"requests\":", self->server.getRequests());
+        printField(out, ",\"rejected\":", self->server.getRejected());
+        out.print("}}");
+        cursor++;
+        return true;
+    }
+
+    static void handleStatus(const ApiRequest&, ApiResponse& res, void* ctx) {
+        res.stream(200, "application/json", writeStatus, ctx);
+    }
+
+    static void handleEvents(const ApiRequest&, ApiResponse& res, void* ctx) {
+        ((DeviceApi*)ctx)->events.handle(res);
+    }
+
+    static void handleSosAck(const ApiRequest&, ApiResponse& res, void* ctx) {
+        static const char CLEARED[] = "{\"status\":\"acknowledged\"}";
+        ((DeviceApi*)ctx)->events.publish("sos", "{\"active\":false}", EVENT_RETAIN);
+        res.sendStatic(200, "application/json", CLEARED, sizeof(CLEARED) - 1);
+    }
+
+    static void wakeServer(void* ctx) {
+        ((ApiServer*)ctx)->wake();
+    }
+
+    static void handleRoot(const ApiRequest&, ApiResponse& res, void*) {
+        res.sendStatic(200, "text/plain", routeList(), strlen(routeList()));
+    }
+
+    static void writeTraceJson(Print& out, void*) {
+        traceWriteJson(out);
+    }
+
+    static void writeTraceChrome(Print& out, void*) {
+        traceWriteChrome(out);
+    }
+
+    static void handleTrace(const ApiRequest& req, ApiResponse& res, void*) {
+        char format[16];
+        bool chrome = req.arg("format", format, sizeof(format)) && strcmp(format, "chrome") == 0;
+        res.snapshot(200, "application/json", chrome ? writeTraceChrome : writeTraceJson, nullptr);
+    }
+
+    static void writeBoot(Print& out, void*) {
+        bootSequencer().writeJson(out);
+    }
+
+    static void handleBoot(const ApiRequest&, ApiResponse& res, void*) {
+        res.snapshot(200, "application/json", writeBoot, nullptr);
+    }
+
+    static void writeHeap(Print& out, void*) {
+        heapProfileDump(out);
+    }
+
+    static void handleHeap(const ApiRequest&, ApiResponse& res, void*) {
+        res.snapshot(200, "text/plain", writeHeap, nullptr);
+    }
+
+    static void writeMetrics(Print& out, void*) {
+        metricsRegistry().write(out);
+    }
+
+    // Current values; task numbers are from the last sample
+    // loop() took, so a scrape never stalls the scheduler itself
+    static void handleMetrics(const ApiRequest&, ApiResponse& res, void*) {
+        res.snapshot(200, "text/plain; version=0.0.4", writeMetrics, nullptr);
+    }
+
+    static void handleProfileStart(const ApiRequest& req, ApiResponse& res, void*) {
+        static const char STARTED[] = "{\"status\":\"sampling\"}";
+        static const char REFUSED[] =
+            "{\"error\":\"not started (running, no memory, or VOLT_PC_PROFILE off)\"}";
+        uint32_t hz = (uint32_t)req.argInt("hz", PcProfiler::DEFAULT_HZ);
+        if (pcProfiler().start(hz)) {
+            res.sendStatic(202, "application/json", STARTED, sizeof(STARTED) - 1);
+        } else {
+            res.sendStatic(409, "application/json", REFUSED, sizeof(REFUSED) - 1);
+        }
+    }
+
+    // Cursor 0 is the header, then 1 + the next sample
+    static bool writeProfile(ApiChunk& out, uint32_t& cursor, void*) {
+        PcProfiler& prof = pcProfiler();
+        if (cursor == 0) {
+            prof.dumpHeader(out);
+            cursor = 1;
+        }
+        while (cursor - 1 < prof.getCount() && out.room() >= PcProfiler::MAX_LINE) {
+            prof.dumpSamples(out, cursor - 1, 1);
+            cursor++;
+        }
+        return cursor - 1 >= prof.getCount();
+    }
+
+    static void handleProfileDump(const ApiRequest&, ApiResponse& res, void*) {
+        pcProfiler().stop();
+        res.stream(200, "text/plain", writeProfile, nullptr);
+    }
+
+public:
+    DeviceApi()
+        : running(false), statusLock(halLockCreate()), sentState(nullptr), sentBattery(-2),
+          sentConnected(false) {}
+
+    // Open event streams unsubscribe as they close: before the hub goes
+    ~DeviceApi() {
+        server.end();
+        halLockDelete(statusLock);
+    }
+
+    DeviceStatus& getStatus() { return status; }
+    ApiServer& getServer() { return server; }
+    EventHub& getEvents() { return events; }
+
+    // After changing getStatus(): pushes "status" if the state,
+    // battery or WiFi link changed since the last push. From any
+    // task; RSSI alone is too noisy to push.
+    void publishStatus() {
+        halLockTake(statusLock);
+        const char* state = status.state.load();
+        int battery = status.battery.load();
+        bool connected = halNetConnected();
+        if (state != sentState || battery != sentBattery || connected != sentConnected) {
+            char json[96];
+            snprintf(json, sizeof(json), "{\"state\":\"%s\",\"battery\":%d,\"wifi\":%s,\"rssi\":%d}",
+                     state, battery, connected ? "true" : "false", status.rssi.load());
+            if (events.publish("status", json, EVENT_COALESCE | EVENT_RETAIN)) {
+                sentState = state;
+                sentBattery = battery;
+                sentConnected = connected;
+            }
+        }
+        halLockGive(statusLock);
+    }
+
+    void publishSteps(int steps, int calories) {
+        char json[48];
+        snprintf(json, sizeof(json), "{\"steps\":%d,\"calories\":%d}", steps, calories);
+        events.publish("steps", json, EVENT_COALESCE | EVENT_RETAIN);
+    }
+
+    // Never coalesced: every alert reaches every open dashboard.
+    // Stays retained until POST /api/sos/ack.
+    void publishSos(double latitude, double longitude, bool gpsValid, int battery) {
+        char json[EventHub::DATA_MAX];
+        snprintf(json, sizeof(json),
+                 "{\"active\":true,\"uptime_ms\":%lu,\"location\":{\"latitude\":%.6f,"
+                 "\"longitude\":%.6f,\"valid\":%s},\"battery\":%d}",
+                 (unsigned long)halMillis(), latitude, longitude, gpsValid ? "true" : "false", battery);
+        events.publish("sos", json, EVENT_RETAIN);
+    }
+
+    // Routes, buffers and the listening socket; port 0 picks one
+    bool begin(uint16_t port = 80) {
+        if (running) return true;
+        server.on("GET", "/", handleRoot);
+        server.on("GET", "/api/status", handleStatus, this);
+        server.on("GET", "/api/events", handleEvents, this);
+        server.on("POST", "/api/sos/ack", handleSosAck, this);
+        server.on("GET", "/api/trace", handleTrace);
+        server.on("GET", "/api/boot", handleBoot);
+        server.on("GET", "/api/heap", handleHeap);
+        server.on("GET", "/api/metrics", handleMetrics);
+        server.on("POST", "/api/profile", handleProfileStart);
+        server.on("GET", "/api/profile", handleProfileDump);
+        if (!events.begin() || !server.begin(port)) return false;
+        events.setNotify(wakeServer, &server);
+        server.registerMetrics(metricsRegistry());
+        events.registerMetrics(metricsRegistry());
+        running = true;
+        return true;
+    }
+
+#ifdef ARDUINO
+    // Serve from now on without loop(): core 0, next to WiFi
+    bool startTask() {
+        return running && server.startTask(0);
+    }
+#endif
+
+    // One round of the server (host tests, or a build without
+    // the task); waits up to timeoutMs for a socket
+    void handle(uint32_t timeoutMs = 0) {
+        if (running) {
+            server.poll(timeoutMs);
+        }
+    }
+};
+
+#endif // DEVICE_API_H
@@ -0,0 +1,508 @@
+/*
+ * ============================================
+ * DNS Cache - TTL-Respecting Resolver Cache
+ * ============================================
+ *
+ * Handles:
+ * - A-record lookups with the server's TTL
+ * - Fixed-size cache (no heap), oldest evicted
+ * - Pre-resolution right after WiFi connects
+ * - Persistence in RTC memory across deep sleep
+ * - Stale answers when a fresh lookup fails
+ *
+ * On the ESP32 the cache lives in RTC slow memory
+ * and lookups go to the DHCP DNS server over UDP
+ * (falling back to WiFi.hostByName() with a
+ * default TTL). Off-target (no ARDUINO) the
+ * resolver and clock are injected, so the cache
+ * logic runs in host tests.
+ *
+ * ============================================
+ */
+
+#ifndef DNS_CACHE_H
+#define DNS_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "volt_trace.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include <WiFiClientSecure.h>
+#define DNS_LOG(...) Serial.printf(__VA_ARGS__)
+#else
+#include <stdio.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#define DNS_LOG(...) printf(__VA_ARGS__)
+#endif
+
+#ifndef RTC_DATA_ATTR
+#define RTC_DATA_ATTR
+#endif
+
+// Resolve host to an IPv4 address (network byte order, as stored
+// by IPAddress) and how many seconds the answer may be cached
+typedef bool (*DnsResolveFn)(const char* host, uint32_t& ip, uint32_t& ttl);
+
+// Seconds on a clock that keeps running through deep sleep
+typedef uint32_t (*DnsClockFn)();
+
+// ============================================
+// WIRE FORMAT
+// ============================================
+
+static const uint16_t DNS_TYPE_A = 1;
+static const uint16_t DNS_CLASS_IN = 1;
+static const size_t DNS_PACKET_SIZE = 512;
+
+// Build a recursive A query. Returns its length, 0 if it won't fit.
+inline size_t dnsBuildQuery(uint8_t* buf, size_t cap, const char* host, uint16_t id) {
+    size_t hostLen = strlen(host);
+    size_t len = 12 + hostLen + 2 + 4;
+    if (hostLen == 0 || hostLen > 253 || len > cap) {
+        return 0;
+    }
+
+    memset(buf, 0, 12);
+    buf[0] = id >> 8;
+    buf[1] = id & 0xFF;
+    buf[2] = 0x01;      // RD
+    buf[5] = 1;         // QDCOUNT
+
+    size_t pos = 12;
+    const char* label = host;
+    while (*label) {
+        const char* dot = strchr(label, '.');
+        size_t n = dot ? (size_t)(dot - label) : strlen(label);
+        if (n == 0 || n > 63) {
+            return 0;
+        }
+        buf[pos++] = (uint8_t)n;
+        memcpy(buf + pos, label, n);
+        pos += n;
+        label += n;
+        if (*label == '.') label++;
+    }
+    buf[pos++] = 0;
+
+    buf[pos++] = 0;
+    buf[pos++] = DNS_TYPE_A;
+    buf[pos++] = 0;
+    buf[pos++] = DNS_CLASS_IN;
+    return pos;
+}
+
+// Skip a (possibly compressed) name. Returns the offset after it, 0 on error.
+inline size_t dnsSkipName(const uint8_t* msg, size_t len, size_t pos) {
+    while (pos < len) {
+        uint8_t n = msg[pos];
+        if (n == 0) {
+            return pos + 1;
+        }
+        if ((n & 0xC0) == 0xC0) {
+            return pos + 2 <= len ? pos + 2 : 0;
+        }
+        if (n & 0xC0) {
+            return 0;
+        }
+        pos += 1 + n;
+    }
+    return 0;
+}
+
+// Pick the first A record out of a response to query id. The TTL
+// is the lowest along the answer chain (CNAMEs included).
+inline bool dnsParseResponse(const uint8_t* msg, size_t len, uint16_t id,
+                             uint32_t& ip, uint32_t& ttl) {
+    if (len < 12) return false;
+    if (((msg[0] << 8) | msg[1]) != id) return false;
+    if (!(msg[2] & 0x80)) return false;         // Not a response
+    if ((msg[3] & 0x0F) != 0) return false;     // RCODE
+
+    int questions = (msg[4] << 8) | msg[5];
+    int answers = (msg[6] << 8) | msg[7];
+
+    size_t pos = 12;
+    for (int i = 0; i < questions; i++) {
+        pos = dnsSkipName(msg, len, pos);
+        if (pos == 0 || pos + 4 > len) return false;
+        pos += 4;
+    }
+
+    uint32_t chainTtl = UINT32_MAX;
+    for (int i = 0; i < answers; i++) {
+        pos = dnsSkipName(msg, len, pos);
+        if (pos == 0 || pos + 10 > len) return false;
+
+        uint16_t type = (msg[pos] << 8) | msg[pos + 1];
+        uint16_t cls = (msg[pos + 2] << 8) | msg[pos + 3];
+        uint32_t recordTtl = ((uint32_t)msg[pos + 4] << 24) | ((uint32_t)msg[pos + 5] << 16) |
+                             ((uint32_t)msg[pos + 6] << 8) | msg[pos + 7];
+        uint16_t rdLength = (msg[pos + 8] << 8) | msg[pos + 9];
+        pos += 10;
+        if (pos + rdLength > len) return false;
+
+        if (recordTtl < chainTtl) {
+            chainTtl = recordTtl;
+        }
+        if (type == DNS_TYPE_A && cls == DNS_CLASS_IN && rdLength == 4) {
+            memcpy(&ip, msg + pos, 4);
+            ttl = chainTtl;
+            return true;
+        }
+        pos += rdLength;
+    }
+    return false;
+}
+
+// ============================================
+// CACHE
+// ============================================
+
+static const int DNS_CACHE_ENTRIES = 8;
+static const size_t DNS_HOST_LEN = 64;
+
+struct DnsCacheEntry {
+    char host[DNS_HOST_LEN];
+    uint32_t ip;
+    uint32_t expiresAt;     // Clock seconds
+};
+
+// Plain data so it can sit in RTC memory as is
+struct DnsCacheStore {
+    uint32_t magic;
+    uint32_t checksum;
+    DnsCacheEntry entries[DNS_CACHE_ENTRIES];
+};
+
+struct DnsCacheStats {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t staleHits;
+    uint32_t failures;
+};
+
+class DnsCache {
+public:
+    // TTLs outside this range are clamped
+    static const uint32_t MIN_TTL = 30;
+    static const uint32_t MAX_TTL = 24 * 3600;
+    // TTL for answers that came without one (hostByName fallback)
+    static const uint32_t DEFAULT_TTL = 300;
+    // How long an expired answer may still be used if a lookup fails
+    static const uint32_t STALE_GRACE = 24 * 3600;
+
+private:
+    static const uint32_t STORE_MAGIC = 0x444E5331;    // "DNS1"
+
+    DnsCacheStore* backing;
+    DnsResolveFn resolver;
+    DnsClockFn clock;
+    DnsCacheStats stats;
+
+    uint32_t computeChecksum() const {
+        // FNV-1a over the entries
+        const uint8_t* p = (const uint8_t*)backing->entries;
+        uint32_t h = 2166136261u;
+        for (size_t i = 0; i < sizeof(backing->entries); i++) {
+            h = (h ^ p[i]) * 16777619u;
+        }
+        return h;
+    }
+
+    void seal() {
+        backing->magic = STORE_MAGIC;
+        backing->checksum = computeChecksum();
+    }
+
+    DnsCacheEntry* find(const char* host) {
+        for (int i = 0; i < DNS_CACHE_ENTRIES; i++) {
+            DnsCacheEntry& e = backing->entries[i];
+            if (e.host[0] && strcmp(e.host, host) == 0) {
+                return &e;
+            }
+        }
+        return nullptr;
+    }
+
+    // Empty slot, else the one that expires first
+    DnsCacheEntry* victim() {
+        DnsCacheEntry* oldest = &backing->entries[0];
+        for (int i = 0; i < DNS_CACHE_ENTRIES; i++) {
+            DnsCacheEntry& e = backing->entries[i];
+            if (!e.host[0]) {
+                return &e;
+            }
+            if ((int32_t)(e.expiresAt - oldest->expiresAt) < 0) {
+                oldest = &e;
+            }
+        }
+        return oldest;
+    }
+
+    // Seconds until expiry, negative once expired. An entry more
+    // than MAX_TTL ahead is from before a clock step and is dropped.
+    int32_t timeLeft(const DnsCacheEntry& e, uint32_t now) const {
+        int32_t left = (int32_t)(e.expiresAt - now);
+        return left > (int32_t)MAX_TTL ? INT32_MIN : left;
+    }
+
+public:
+    DnsCache(DnsCacheStore* storage, DnsResolveFn resolveFn, DnsClockFn clockFn)
+        : backing(storage), resolver(resolveFn), clock(clockFn) {
+        memset(&stats, 0, sizeof(stats));
+        restore();
+    }
+
+    // Keep the entries if the store survived (deep sleep wake),
+    // otherwise start empty (power-on, or a layout change)
+    bool restore() {
+        if (backing->magic == STORE_MAGIC && backing->checksum == computeChecksum()) {
+            return true;
+        }
+        clear();
+        return false;
+    }
+
+    void clear() {
+        memset(backing->entries, 0, sizeof(backing->entries));
+        seal();
+    }
+
+    void setResolver(DnsResolveFn resolveFn) { resolver = resolveFn; }
+    void setClock(DnsClockFn clockFn) { clock = clockFn; }
+
+    // Cached address only, never a lookup
+    bool lookup(const char* host, uint32_t& ip) {
+        DnsCacheEntry* e = find(host);
+        if (!e || timeLeft(*e, clock()) <= 0) {
+            return false;
+        }
+        ip = e->ip;
+        return true;
+    }
+
+    // Cached address if still fresh, else a lookup. If the lookup
+    // fails, a recently expired answer beats no answer.
+    bool resolve(const char* host, uint32_t& ip) {
+        if (!host || !host[0]) {
+            return false;
+        }
+        uint32_t now = clock();
+        DnsCacheEntry* e = find(host);
+        if (e && timeLeft(*e, now) > 0) {
+            stats.hits++;
+            ip = e->ip;
+            return true;
+        }
+
+        stats.misses++;
+        return refresh(host, ip);
+    }
+
+    // Look the host up now, even if the cached answer is still fresh
+    bool refresh(const char* host, uint32_t& ip) {
+        uint32_t ttl = DEFAULT_TTL;
+        uint32_t fresh;
+        if (resolver && resolver(host, fresh, ttl)) {
+            store(host, fresh, ttl);
+            ip = fresh;
+            return true;
+        }
+
+        stats.failures++;
+        DnsCacheEntry* e = find(host);
+        if (e && timeLeft(*e, clock()) > -(int32_t)STALE_GRACE) {
+            DNS_LOG("DNS: Lookup of %s failed, using cached address\n", host);
+            stats.staleHits++;
+            ip = e->ip;
+            return true;
+        }
+        DNS_LOG("DNS: Lookup of %s failed\n", host);
+        return false;
+    }
+
+    void store(const char* host, uint32_t ip, uint32_t ttl) {
+        if (strlen(host) >= DNS_HOST_LEN) {
+            return;
+        }
+        if (ttl < MIN_TTL) ttl = MIN_TTL;
+        if (ttl > MAX_TTL) ttl = MAX_TTL;
+
+        DnsCacheEntry* e = find(host);
+        if (!e) {
+            e = victim();
+            memset(e->host, 0, sizeof(e->host));
+            strcpy(e->host, host);
+        }
+        e->ip = ip;
+        e->expiresAt = clock() + ttl;
+        seal();
+    }
+
+    // Drop an address that stopped answering
+    void invalidate(const char* host) {
+        DnsCacheEntry* e = find(host);
+        if (e) {
+            memset(e, 0, sizeof(*e));
+            seal();
+        }
+    }
+
+    // Resolve every host that is missing or about to expire
+    int prewarm(const char* const* hosts, int count) {
+        int ready = 0;
+        uint32_t now = clock();
+        for (int i = 0; i < count; i++) {
+            DnsCacheEntry* e = find(hosts[i]);
+            uint32_t ip;
+            if ((e && timeLeft(*e, now) > (int32_t)MIN_TTL) || refresh(hosts[i], ip)) {
+                ready++;
+            }
+        }
+        return ready;
+    }
+
+    int size() const {
+        int n = 0;
+        for (int i = 0; i < DNS_CACHE_ENTRIES; i++) {
+            if (backing->entries[i].host[0]) n++;
+        }
+        return n;
+    }
+
+    DnsCacheStats getStats() const { return stats; }
+};
+
+// ============================================
+// ESP32 RESOLVER, CLOCK AND CONNECT HELPERS
+// ============================================
+
+// System time is kept by the RTC through deep sleep
+inline uint32_t dnsClockSeconds() {
+    return (uint32_t)time(nullptr);
+}
+
+#ifdef ARDUINO
+
+static const unsigned long DNS_QUERY_TIMEOUT_MS = 1500;
+
+// Ask the DHCP DNS server directly so the TTL comes back too
+inline bool dnsResolveWiFi(const char* host, uint32_t& ip, uint32_t& ttl) {
+    uint8_t packet[DNS_PACKET_SIZE];
+    uint16_t id = (uint16_t)esp_random();
+    size_t len = dnsBuildQuery(packet, sizeof(packet), host, id);
+    IPAddress server = WiFi.dnsIP();
+
+    if (len > 0 && server != IPAddress(0, 0, 0, 0)) {
+        WiFiUDP udp;
+        if (udp.beginPacket(server, 53)) {
+            udp.write(packet, len);
+            if (udp.endPacket()) {
+                unsigned long start = millis();
+                while (millis() - start < DNS_QUERY_TIMEOUT_MS) {
+                    if (udp.parsePacket() > 0) {
+                        int n = udp.read(packet, sizeof(packet));
+                        if (n > 0 && dnsParseResponse(packet, n, id, ip, ttl)) {
+                            udp.stop();
+                            return true;
+                        }
+                    }
+                    delay(5);
+                }
+            }
+        }
+        udp.stop();
+    }
+
+    IPAddress addr;
+    if (WiFi.hostByName(host, addr) == 1) {
+        ip = (uint32_t)addr;
+        ttl = DnsCache::DEFAULT_TTL;
+        return true;
+    }
+    return false;
+}
+
+RTC_DATA_ATTR static DnsCacheStore dnsRtcStore;
+
+inline DnsCache& dnsCache() {
+    static DnsCache cache(&dnsRtcStore, dnsResolveWiFi, dnsClockSeconds);
+    return cache;
+}
+
+// Connect by cached address; TLS still sends SNI for the host
+// name. A cached address that refuses is dropped and the connect
+// retried with a normal lookup. The connect calls (TCP + TLS) are
+// traced as the tls span.
+inline bool dnsConnect(WiFiClientSecure& client, const char* host, uint16_t port) {
+    uint32_t ip;
+    if (dnsCache().resolve(host, ip)) {
+        TRACE_DECLARE(handshake, TRACE_TLS);
+        TRACE_START(handshake);
+        bool ok = client.connect(IPAddress(ip), port, host, nullptr, nullptr, nullptr);
+        TRACE_STOP(handshake);
+        if (ok) {
+            return true;
+        }
+        dnsCache().invalidate(host);
+    }
+    TRACE_SCOPE(TRACE_TLS);
+    return client.connect(host, port);
+}
+
+inline bool dnsConnect(WiFiClient& client, const char* host, uint16_t port) {
+    uint32_t ip;
+    if (dnsCache().resolve(host, ip)) {
+        TRACE_DECLARE(handshake, TRACE_TLS);
+        TRACE_START(handshake);
+        bool ok = client.connect(IPAddress(ip), port);
+        TRACE_STOP(handshake);
+        if (ok) {
+            return true;
+        }
+        dnsCache().invalidate(host);
+    }
+    TRACE_SCOPE(TRACE_TLS);
+    return client.connect(host, port);
+}
+
+#else
+
+// Host builds look names up with getaddrinfo (no TTL, so the default)
+inline bool dnsResolveHost(const char* host, uint32_t& ip, uint32_t& ttl) {
+    struct addrinfo hints;
+    struct addrinfo* res = nullptr;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    if (getaddrinfo(host, nullptr, &hints, &res) != 0 || !res) {
+        return false;
+    }
+    ip = ((struct sockaddr_in*)res->ai_addr)->sin_addr.s_addr;
+    ttl = DnsCache::DEFAULT_TTL;
+    freeaddrinfo(res);
+    return true;
+}
+
+inline DnsCache& dnsCache() {
+    static DnsCacheStore store;
+    static DnsCache cache(&store, dnsResolveHost, dnsClockSeconds);
+    return cache;
+}
+
+// ... and connect through the native client (and its routes)
+template <typename ClientT>
+inline bool dnsConnect(ClientT& client, const char* host, uint16_t port) {
+    TRACE_SCOPE(TRACE_TLS);
+    return client.connect(host, port) != 0;
+}
+
+#endif // ARDUINO
+
+#endif // DNS_CACHE_H
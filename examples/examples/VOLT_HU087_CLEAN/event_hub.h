@@ -0,0 +1,353 @@
+/*
+ * ============================================
+ * Event Hub - Pushed Updates for Dashboards
+ * ============================================
+ *
+ * Handles:
+ * - publish(type, json) from any task: status
+ *   deltas, step counts, SOS alerts
+ * - One bounded queue per subscriber (GET
+ *   /api/events, server-sent events), filled
+ *   by publish() and drained by the API task
+ *   as fast as that client's socket takes it
+ * - Backpressure per client, never for the
+ *   publisher:
+ *   - COALESCE events (status, steps) replace
+ *     a queued one of the same type: a slow
+ *     client gets the latest value, not a
+ *     backlog
+ *   - when the queue is still full the oldest
+ *     coalescable event makes room
+ *   - a queue full of events that must not be
+ *     lost (SOS) ends that client's stream; the
+ *     browser reconnects and gets the state
+ *     again
+ * - RETAIN events (the latest per type) are
+ *   queued first for every new subscriber, so a
+ *   dashboard opening or reconnecting mid-SOS
+ *   sees it at once
+ * - A comment line every HEARTBEAT_MS so a
+ *   dead client is noticed
+ * - Counters and a delivery time histogram for
+ *   GET /api/metrics
+ *
+ * publish() copies the event under a short
+ * lock and wakes the API task (ApiServer::wake),
+ * so delivery takes one pass of that task, not
+ * a polling interval.
+ *
+ * ============================================
+ */
+
+#ifndef EVENT_HUB_H
+#define EVENT_HUB_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "volt_hal.h"
+#include "metrics.h"
+#include "api_server.h"
+
+enum EventFlags {
+    EVENT_COALESCE = 1,          // Only the latest one matters
+    EVENT_RETAIN = 2             // Replayed to new subscribers
+};
+
+class EventHub {
+public:
+    static const int MAX_SUBSCRIBERS = 4;       // Of the server's 8 connections
+    static const int QUEUE_DEPTH = 8;
+    static const int MAX_RETAINED = 4;
+    static const size_t TYPE_MAX = 16;
+    static const size_t DATA_MAX = 200;         // One line of JSON
+    static const uint32_t HEARTBEAT_MS = 15000;
+    static const uint32_t RETRY_MS = 2000;      // Browser reconnect delay
+
+    typedef void (*NotifyFn)(void* ctx);
+
+private:
+    struct Event {
+        uint32_t id;
+        uint32_t publishedUs;
+        uint8_t flags;
+        char type[TYPE_MAX];
+        char data[DATA_MAX];
+    };
+
+    struct Subscriber {
+        bool used;
+        bool overflowed;
+        bool greeted;            // retry: line sent
+        uint8_t head;
+        uint8_t count;
+        unsigned long lastWriteMs;
+        Event queue[QUEUE_DEPTH];
+    };
+
+    Subscriber* subs;
+    Event retained[MAX_RETAINED];
+    int retainedCount;
+    uint32_t nextId;
+    NotifyFn notify;
+    void* notifyCtx;
+    HalLock mutex;
+
+    MetricCounter published;
+    MetricCounter coalesced;
+    MetricCounter overflows;
+    MetricGauge subscribers;
+    MetricHistogram deliveryUs;
+
+    static const uint32_t* deliveryBuckets() {
+        static const uint32_t b[] = { 100, 250, 500, 1000, 2500, 5000, 10000, 25000,
+                                      50000, 100000, 1000000 };
+        return b;
+    }
+
+    void lock() { halLockTake(mutex); }
+
+    void unlock() { halLockGive(mutex); }
+
+    Event& at(Subscriber& s, int i) {
+        return s.queue[(s.head + i) % QUEUE_DEPTH];
+    }
+
+    // Removes entry i, keeping the order of the rest
+    void removeAt(Subscriber& s, int i) {
+        for (int k = i; k < s.count - 1; k++) {
+            at(s, k) = at(s, k + 1);
+        }
+        s.count--;
+    }
+
+    void enqueue(Subscriber& s, const Event& e) {
+        if (s.overflowed) return;
+        if (e.flags & EVENT_COALESCE) {
+            for (int i = 0; i < s.count; i++) {
+                if (strcmp(at(s, i).type, e.type) == 0) {
+                    removeAt(s, i);
+                    coalesced.inc();
+                    break;
+                }
+            }
+        }
+        if (s.count == QUEUE_DEPTH) {
+            for (int i = 0; i < s.count; i++) {
+                if (at(s, i).flags & EVENT_COALESCE) {
+                    removeAt(s, i);
+                    coalesced.inc();
+                    break;
+                }
+            }
+        }
+        if (s.count == QUEUE_DEPTH) {
+            s.overflowed = true;
+            overflows.inc();
+            return;
+        }
+        at(s, s.count++) = e;
+    }
+
+    void retain(const Event& e) {
+        for (int i = 0; i < retainedCount; i++) {
+            if (strcmp(retained[i].type, e.type) == 0) {
+                retained[i] = e;
+                return;
+            }
+        }
+        if (retainedCount < MAX_RETAINED) {
+            retained[retainedCount++] = e;
+        } else {
+            halLog("Events: No room to retain '%s'\n", e.type);
+        }
+    }
+
+    // "id: N\nevent: type\ndata: json\n\n"
+    static size_t frameSize(const Event& e) {
+        return 4 + 10 + 8 + strlen(e.type) + 7 + strlen(e.data) + 3;
+    }
+
+    static void writeFrame(Print& out, const Event& e) {
+        out.print("id: ");
+        metricsPrintU64(out, e.id);
+        out.print("\nevent: ");
+        out.print(e.type);
+        out.print("\ndata: ");
+        out.print(e.data);
+        out.print("\n\n");
+    }
+
+    // Server callbacks; cursor is the subscriber slot + 1
+    static bool writeEvents(ApiChunk& out, uint32_t& cursor, void* ctx) {
+        return ((EventHub*)ctx)->drain(out, (int)cursor - 1);
+    }
+
+    static void closeEvents(uint32_t cursor, void* ctx) {
+        ((EventHub*)ctx)->unsubscribe((int)cursor - 1);
+    }
+
+public:
+    EventHub()
+        : subs(nullptr), retainedCount(0), nextId(1), notify(nullptr), notifyCtx(nullptr),
+          mutex(halLockCreate()),
+          published("volt_events_published_total", "Events published for /api/events"),
+          coalesced("volt_events_coalesced_total", "Queued events replaced by a newer one (slow client)"),
+          overflows("volt_events_overflows_total", "Event streams ended because a client fell too far behind"),
+          subscribers("volt_events_subscribers", "Open /api/events streams"),
+          deliveryUs("volt_events_delivery_us", "Publish to written into the socket buffer",
+                     deliveryBuckets(), 11) {}
+
+    ~EventHub() {
+        if (subs) halHeapFree(subs);
+        halLockDelete(mutex);
+    }
+
+    // Reserves the queues (PSRAM first)
+    bool begin() {
+        if (subs) return true;
+        size_t bytes = sizeof(Subscriber) * MAX_SUBSCRIBERS;
+        subs = (Subscriber*)halHeapAlloc(bytes, HAL_HEAP_SPIRAM);
+        if (!subs) subs = (Subscriber*)halHeapAlloc(bytes, HAL_HEAP_INTERNAL);
+        if (!subs) {
+            halLog("Events: No memory for %d subscribers\n", MAX_SUBSCRIBERS);
+            return false;
+        }
+        for (int i = 0; i < MAX_SUBSCRIBERS; i++) {
+            subs[i].used = false;
+        }
+        return true;
+    }
+
+    // Called after every publish (ApiServer::wake)
+    void setNotify(NotifyFn fn, void* ctx) {
+        notify = fn;
+        notifyCtx = ctx;
+    }
+
+    void registerMetrics(MetricsRegistry& registry) {
+        registry.add(&published);
+        registry.add(&coalesced);
+        registry.add(&overflows);
+        registry.add(&subscribers);
+        registry.add(&deliveryUs);
+    }
+
+    // From any task. data is one line of JSON (no newlines);
+    // longer than DATA_MAX is refused.
+    bool publish(const char* type, const char* data, uint8_t flags = 0) {
+        if (strlen(type) >= TYPE_MAX || strlen(data) >= DATA_MAX || strchr(data, '\n')) {
+            halLog("Events: '%s' refused (too long or multi-line)\n", type);
+            return false;
+        }
+        Event e;
+        e.publishedUs = (uint32_t)halMicros();
+        e.flags = flags;
+        strcpy(e.type, type);
+        strcpy(e.data, data);
+
+        lock();
+        e.id = nextId++;
+        if (flags & EVENT_RETAIN) retain(e);
+        if (subs) {
+            for (int i = 0; i < MAX_SUBSCRIBERS; i++) {
+                if (subs[i].used) enqueue(subs[i], e);
+            }
+        }
+        unlock();
+        published.inc();
+        if (notify) notify(notifyCtx);
+        return true;
+    }
+
+    // A slot with the retained events queued, or -1 if all are taken
+    int subscribe() {
+        if (!subs) return -1;
+        int slot = -1;
+        lock();
+        for (int i = 0; i < MAX_SUBSCRIBERS && slot < 0; i++) {
+            if (!subs[i].used) slot = i;
+        }
+        if (slot >= 0) {
+            Subscriber& s = subs[slot];
+            s.used = true;
+            s.overflowed = false;
+            s.greeted = false;
+            s.head = 0;
+            s.count = 0;
+            s.lastWriteMs = halMillis();
+            for (int i = 0; i < retainedCount; i++) {
+                Event& e = at(s, s.count++);
+                e = retained[i];
+                e.publishedUs = (uint32_t)halMicros();   // Delivery time counts from now
+            }
+        }
+        unlock();
+        if (slot >= 0) subscribers.add(1);
+        return slot;
+    }
+
+    void unsubscribe(int slot) {
+        if (!subs || slot < 0 || slot >= MAX_SUBSCRIBERS) return;
+        lock();
+        bool was = subs[slot].used;
+        subs[slot].used = false;
+        unlock();
+        if (was) subscribers.add(-1);
+    }
+
+    // Writes what fits of one subscriber's queue. False while the
+    // stream goes on, true once it must end (overflowed).
+    bool drain(ApiChunk& out, int slot) {
+        Subscriber& s = subs[slot];
+        uint32_t now = (uint32_t)halMicros();
+        bool wrote = false;
+        lock();
+        if (!s.greeted) {
+            out.print("retry: ");
+            metricsPrintU64(out, RETRY_MS);
+            out.print("\n\n");
+            s.greeted = true;
+            wrote = true;
+        }
+        while (s.count > 0 && frameSize(at(s, 0)) <= out.room()) {
+            Event& e = at(s, 0);
+            writeFrame(out, e);
+            deliveryUs.observe(now - e.publishedUs);
+            s.head = (s.head + 1) % QUEUE_DEPTH;
+            s.count--;
+            wrote = true;
+        }
+        bool end = s.overflowed && s.count == 0;
+        unlock();
+
+        unsigned long ms = halMillis();
+        if (wrote) {
+            s.lastWriteMs = ms;
+        } else if (!end && ms - s.lastWriteMs >= HEARTBEAT_MS) {
+            out.print(": ping\n\n");
+            s.lastWriteMs = ms;
+        }
+        return end;
+    }
+
+    // GET /api/events: a slot, or 503 while all are taken
+    void handle(ApiResponse& res) {
+        static const char FULL[] = "{\"error\":\"too many event streams\"}";
+        int slot = subscribe();
+        if (slot < 0) {
+            res.sendStatic(503, "application/json", FULL, sizeof(FULL) - 1);
+            return;
+        }
+        res.events(writeEvents, this, (uint32_t)slot + 1, closeEvents);
+    }
+
+    int getSubscribers() const { return subscribers.get(); }
+    uint32_t getPublished() const { return published.get(); }
+    uint32_t getCoalesced() const { return coalesced.get(); }
+    uint32_t getOverflows() const { return overflows.get(); }
+    const MetricHistogram& getDeliveryTimes() const { return deliveryUs; }
+};
+
+#endif // EVENT_HUB_H
@@ -0,0 +1,105 @@
+/*
+ * ============================================
+ * Frame Pacer - Fixed Frame Budget
+ * ============================================
+ *
+ * Handles:
+ * - Animation frames on a fixed grid (every
+ *   frameMs from start()), so a slow frame does
+ *   not push every later one back
+ * - How long the caller may sleep before the
+ *   next frame (waitMs()), for a task that also
+ *   waits on a queue
+ * - Frame times against the budget: a frame
+ *   that overruns is late, grid slots it ran
+ *   past are skipped rather than drawn in a
+ *   burst afterwards
+ * - Frame time histogram and skipped frame
+ *   counter for /api/metrics
+ *
+ * Runs on the ui task (app_tasks.h), which draws
+ * a frame whenever due() and sleeps otherwise.
+ *
+ * ============================================
+ */
+
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <stdint.h>
+#include "volt_hal.h"
+#include "metrics.h"
+
+class FramePacer {
+private:
+    uint32_t frameMs;
+    bool running;
+    unsigned long nextAt;
+
+    uint32_t frames;
+    uint32_t late;
+    uint32_t worstUs;
+    MetricHistogram frameUs;
+    MetricCounter skipped;
+
+    static const uint32_t* frameBuckets() {
+        static const uint32_t b[] = { 1000, 2500, 5000, 10000, 16000, 25000, 33000, 50000, 100000 };
+        return b;
+    }
+
+public:
+    FramePacer()
+        : frameMs(33), running(false), nextAt(0), frames(0), late(0), worstUs(0),
+          frameUs("volt_ui_frame_us", "Time one animation frame took to draw and send", frameBuckets(), 9),
+          skipped("volt_ui_frames_skipped_total", "Animation frames dropped because the one before ran over") {}
+
+    // First frame at now, then every ms
+    void start(uint32_t ms, unsigned long now) {
+        frameMs = ms > 0 ? ms : 1;
+        running = true;
+        nextAt = now;
+    }
+
+    void stop() { running = false; }
+
+    bool isRunning() const { return running; }
+
+    bool due(unsigned long now) const { return running && (long)(now - nextAt) >= 0; }
+
+    // Until the next frame (0: due)
+    uint32_t waitMs(unsigned long now) const {
+        if (!running) return HAL_WAIT_FOREVER;
+        long left = (long)(nextAt - now);
+        return left > 0 ? (uint32_t)left : 0;
+    }
+
+    // A frame took tookUs and ended at now: the next one is the
+    // first grid slot not yet passed
+    void frameDone(uint32_t tookUs, unsigned long now) {
+        frames++;
+        frameUs.observe(tookUs);
+        if (tookUs > worstUs) worstUs = tookUs;
+        if (tookUs > frameMs * 1000) late++;
+        nextAt += frameMs;
+        if ((long)(now - nextAt) > 0) {
+            uint32_t missed = (uint32_t)((now - nextAt - 1) / frameMs) + 1;
+            skipped.inc(missed);
+            nextAt += (unsigned long)missed * frameMs;
+        }
+    }
+
+    void registerMetrics(MetricsRegistry& registry) {
+        registry.add(&frameUs);
+        registry.add(&skipped);
+    }
+
+    uint32_t getFrameMs() const { return frameMs; }
+    uint32_t getFrames() const { return frames; }
+    uint32_t getLate() const { return late; }
+    uint32_t getSkipped() const { return skipped.get(); }
+    uint32_t getWorstUs() const { return worstUs; }
+    unsigned long getNextAt() const { return nextAt; }
+    const MetricHistogram& getFrameTimes() const { return frameUs; }
+};
+
+#endif // FRAME_PACER_H
@@ -0,0 +1,1462 @@
+/*
+ * ============================================
+ * HTTP/2 Client - One Connection, Many Requests
+ * ============================================
+ *
+ * Handles:
+ * - HPACK header compression (static and
+ *   dynamic tables, Huffman decoding)
+ * - Several requests in flight on one TLS
+ *   connection (e.g. a TTS prefetch while the
+ *   previous sentence is still playing)
+ * - Flow control in both directions
+ * - Streams that behave like an Arduino Client,
+ *   so request code works over either protocol
+ *
+ * Memory is fixed: one block for header blocks
+ * plus one receive ring per open stream, all
+ * taken from the "h2" pool bucket. The receive
+ * window advertised to the server equals the
+ * ring size, so a fast server can never overrun
+ * a stream that is not being read.
+ *
+ * ============================================
+ */
+
+#ifndef H2_CLIENT_H
+#define H2_CLIENT_H
+
+#include <Arduino.h>
+#include <Client.h>
+#include "mem_pools.h"
+
+// ============================================
+// PROTOCOL CONSTANTS (RFC 9113 / RFC 7541)
+// ============================================
+
+enum H2FrameType : uint8_t {
+    H2_DATA = 0x0,
+    H2_HEADERS = 0x1,
+    H2_PRIORITY = 0x2,
+    H2_RST_STREAM = 0x3,
+    H2_SETTINGS = 0x4,
+    H2_PUSH_PROMISE = 0x5,
+    H2_PING = 0x6,
+    H2_GOAWAY = 0x7,
+    H2_WINDOW_UPDATE = 0x8,
+    H2_CONTINUATION = 0x9
+};
+
+enum H2FrameFlag : uint8_t {
+    H2_FLAG_END_STREAM = 0x01,
+    H2_FLAG_ACK = 0x01,
+    H2_FLAG_END_HEADERS = 0x04,
+    H2_FLAG_PADDED = 0x08,
+    H2_FLAG_PRIORITY = 0x20
+};
+
+enum H2ErrorCode : uint32_t {
+    H2_NO_ERROR = 0x0,
+    H2_PROTOCOL_ERROR = 0x1,
+    H2_INTERNAL_ERROR = 0x2,
+    H2_FLOW_CONTROL_ERROR = 0x3,
+    H2_STREAM_CLOSED = 0x5,
+    H2_FRAME_SIZE_ERROR = 0x6,
+    H2_CANCEL = 0x8,
+    H2_COMPRESSION_ERROR = 0x9
+};
+
+enum H2Setting : uint16_t {
+    H2_SETTINGS_HEADER_TABLE_SIZE = 0x1,
+    H2_SETTINGS_ENABLE_PUSH = 0x2,
+    H2_SETTINGS_MAX_CONCURRENT_STREAMS = 0x3,
+    H2_SETTINGS_INITIAL_WINDOW_SIZE = 0x4,
+    H2_SETTINGS_MAX_FRAME_SIZE = 0x5,
+    H2_SETTINGS_MAX_HEADER_LIST_SIZE = 0x6
+};
+
+// ============================================
+// HPACK DECODER
+// ============================================
+
+class HpackHandler {
+public:
+    virtual ~HpackHandler() {}
+    virtual void onHeader(const char* name, size_t nameLen,
+                          const char* value, size_t valueLen) = 0;
+};
+
+class HpackDecoder {
+public:
+    // Advertised as SETTINGS_HEADER_TABLE_SIZE
+    static const size_t TABLE_SIZE = 1024;
+
+private:
+    static const int STATIC_COUNT = 61;
+    static const int MAX_ENTRIES = TABLE_SIZE / 32;
+
+    struct Entry {
+        uint16_t offset;
+        uint16_t nameLen;
+        uint16_t valueLen;
+    };
+
+    char data[TABLE_SIZE];
+    Entry entries[MAX_ENTRIES];   // Oldest first
+    int count;
+    size_t dataLen;
+    size_t size;                  // RFC size: name + value + 32 per entry
+    size_t maxSize;
+
+    static const char* staticEntry(int index, bool value) {
+        static const char* const table[STATIC_COUNT][2] = {
+            { ":authority", "" }, { ":method", "GET" }, { ":method", "POST" },
+            { ":path", "/" }, { ":path", "/index.html" }, { ":scheme", "http" },
+            { ":scheme", "https" }, { ":status", "200" }, { ":status", "204" },
+            { ":status", "206" }, { ":status", "304" }, { ":status", "400" },
+            { ":status", "404" }, { ":status", "500" }, { "accept-charset", "" },
+            { "accept-encoding", "gzip, deflate" }, { "accept-language", "" },
+            { "accept-ranges", "" }, { "accept", "" }, { "access-control-allow-origin", "" },
+            { "age", "" }, { "allow", "" }, { "authorization", "" },
+            { "cache-control", "" }, { "content-disposition", "" }, { "content-encoding", "" },
+            { "content-language", "" }, { "content-length", "" }, { "content-location", "" },
+            { "content-range", "" }, { "content-type", "" }, { "cookie", "" },
+            { "date", "" }, { "etag", "" }, { "expect", "" },
+            { "expires", "" }, { "from", "" }, { "host", "" },
+            { "if-match", "" }, { "if-modified-since", "" }, { "if-none-match", "" },
+            { "if-range", "" }, { "if-unmodified-since", "" }, { "last-modified", "" },
+            { "link", "" }, { "location", "" }, { "max-forwards", "" },
+            { "proxy-authenticate", "" }, { "proxy-authorization", "" }, { "range", "" },
+            { "referer", "" }, { "refresh", "" }, { "retry-after", "" },
+            { "server", "" }, { "set-cookie", "" }, { "strict-transport-security", "" },
+            { "transfer-encoding", "" }, { "user-agent", "" }, { "vary", "" },
+            { "via", "" }, { "www-authenticate", "" }
+        };
+        return table[index - 1][value ? 1 : 0];
+    }
+
+    void evictOldest() {
+        size_t bytes = entries[0].nameLen + entries[0].valueLen;
+        memmove(data, data + bytes, dataLen - bytes);
+        dataLen -= bytes;
+        size -= bytes + 32;
+        for (int i = 1; i < count; i++) {
+            entries[i - 1] = entries[i];
+            entries[i - 1].offset -= bytes;
+        }
+        count--;
+    }
+
+    void evictTo(size_t limit) {
+        while (count > 0 && size > limit) {
+            evictOldest();
+        }
+    }
+
+    void insert(const char* name, size_t nameLen, const char* value, size_t valueLen) {
+        size_t entrySize = nameLen + valueLen + 32;
+        evictTo(entrySize > maxSize ? 0 : maxSize - entrySize);
+        if (entrySize > maxSize) return;   // Too big: table is now empty
+        if (count == MAX_ENTRIES) evictOldest();
+
+        Entry& e = entries[count++];
+        e.offset = (uint16_t)dataLen;
+        e.nameLen = (uint16_t)nameLen;
+        e.valueLen = (uint16_t)valueLen;
+        memcpy(data + dataLen, name, nameLen);
+        memcpy(data + dataLen + nameLen, value, valueLen);
+        dataLen += nameLen + valueLen;
+        size += entrySize;
+    }
+
+    bool lookup(uint32_t index, const char*& name, size_t& nameLen,
+                const char*& value, size_t& valueLen) const {
+        if (index == 0) return false;
+        if (index <= STATIC_COUNT) {
+            name = staticEntry(index, false);
+            value = staticEntry(index, true);
+            nameLen = strlen(name);
+            valueLen = strlen(value);
+            return true;
+        }
+        uint32_t d = index - STATIC_COUNT - 1;   // 0 = newest
+        if (d >= (uint32_t)count) return false;
+        const Entry& e = entries[count - 1 - d];
+        name = data + e.offset;
+        nameLen = e.nameLen;
+        value = data + e.offset + e.nameLen;
+        valueLen = e.valueLen;
+        return true;
+    }
+
+    static bool readInt(const uint8_t* in, size_t len, size_t& pos, int prefix, uint32_t& value) {
+        uint32_t max = (1u << prefix) - 1;
+        value = in[pos++] & max;
+        if (value < max) return true;
+        int shift = 0;
+        while (pos < len) {
+            uint8_t b = in[pos++];
+            if (shift > 21) return false;   // Larger than anything we accept
+            value += (uint32_t)(b & 0x7F) << shift;
+            shift += 7;
+            if (!(b & 0x80)) return true;
+        }
+        return false;
+    }
+
+    // Literal strings point into the block unless they are
+    // Huffman coded, in which case they are decoded into scratch
+    static bool readString(const uint8_t* in, size_t len, size_t& pos,
+                           char* scratch, size_t scratchCap, size_t& used,
+                           const char*& out, size_t& outLen) {
+        if (pos >= len) return false;
+        bool huffman = (in[pos] & 0x80) != 0;
+        uint32_t n;
+        if (!readInt(in, len, pos, 7, n) || n > len - pos) return false;
+        if (huffman) {
+            size_t decoded;
+            if (!huffmanDecode(in + pos, n, scratch + used, scratchCap - used, decoded)) {
+                return false;
+            }
+            out = scratch + used;
+            outLen = decoded;
+            used += decoded;
+        } else {
+            out = (const char*)in + pos;
+            outLen = n;
+        }
+        pos += n;
+        return true;
+    }
+
+public:
+    HpackDecoder() {
+        reset();
+    }
+
+    void reset() {
+        count = 0;
+        dataLen = 0;
+        size = 0;
+        maxSize = TABLE_SIZE;
+    }
+
+    // Canonical Huffman code from RFC 7541 Appendix B, decoded
+    // bit by bit from the count of codes of each length
+    static bool huffmanDecode(const uint8_t* in, size_t n, char* out, size_t cap, size_t& outLen) {
+        static const uint8_t COUNTS[31] = {
+            0, 0, 0, 0, 0, 10, 26, 32, 6, 0, 5, 3, 2, 6, 2, 3,
+            0, 0, 0, 3, 8, 13, 26, 29, 12, 4, 15, 19, 29, 0, 4
+        };
+        static const uint8_t SYMBOLS[256] = {
+             48,  49,  50,  97,  99, 101, 105, 111, 115, 116,  32,  37,  45,  46,  47,  51,
+             52,  53,  54,  55,  56,  57,  61,  65,  95,  98, 100, 102, 103, 104, 108, 109,
+            110, 112, 114, 117,  58,  66,  67,  68,  69,  70,  71,  72,  73,  74,  75,  76,
+             77,  78,  79,  80,  81,  82,  83,  84,  85,  86,  87,  89, 106, 107, 113, 118,
+            119, 120, 121, 122,  38,  42,  44,  59,  88,  90,  33,  34,  40,  41,  63,  39,
+             43, 124,  35,  62,   0,  36,  64,  91,  93, 126,  94, 125,  60,  96, 123,  92,
+            195, 208, 128, 130, 131, 162, 184, 194, 224, 226, 153, 161, 167, 172, 176, 177,
+            179, 209, 216, 217, 227, 229, 230, 129, 132, 133, 134, 136, 146, 154, 156, 160,
+            163, 164, 169, 170, 173, 178, 181, 185, 186, 187, 189, 190, 196, 198, 228, 232,
+            233,   1, 135, 137, 138, 139, 140, 141, 143, 147, 149, 150, 151, 152, 155, 157,
+            158, 165, 166, 168, 174, 175, 180, 182, 183, 188, 191, 197, 231, 239,   9, 142,
+            144, 145, 148, 159, 171, 206, 215, 225, 236, 237, 199, 207, 234, 235, 192, 193,
+            200, 201, 202, 205, 210, 213, 218, 219, 238, 240, 242, 243, 255, 203, 204, 211,
+            212, 214, 221, 222, 223, 241, 244, 245, 246, 247, 248, 250, 251, 252, 253, 254,
+              2,   3,   4,   5,   6,   7,   8,  11,  12,  14,  15,  16,  17,  18,  19,  20,
+             21,  23,  24,  25,  26,  27,  28,  29,  30,  31, 127, 220, 249,  10,  13,  22
+        };
+
+        outLen = 0;
+        int32_t code = 0;    // Bits of the current symbol
+        int32_t first = 0;   // First code of the current length
+        int index = 0;       // Index of that code in SYMBOLS
+        int len = 0;
+
+        for (size_t i = 0; i < n; i++) {
+            for (int bit = 7; bit >= 0; bit--) {
+                code |= (in[i] >> bit) & 1;
+                len++;
+                int32_t c = COUNTS[len];
+                if (code < first + c) {
+                    int sym = index + (code - first);
+                    if (sym >= 256 || outLen >= cap) return false;   // EOS or no room
+                    out[outLen++] = (char)SYMBOLS[sym];
+                    code = 0;
+                    first = 0;
+                    index = 0;
+                    len = 0;
+                } else {
+                    if (len >= 30) return false;
+                    index += c;
+                    first = (first + c) << 1;
+                    code <<= 1;
+                }
+            }
+        }
+
+        // Padding must be a prefix of EOS (all ones) and shorter than a byte
+        return len == 0 || (len <= 7 && (code >> 1) == (int32_t)((1u << len) - 1));
+    }
+
+    // Decode one complete header block. scratch holds Huffman output
+    // and names copied out of the dynamic table.
+    bool decode(const uint8_t* in, size_t len, char* scratch, size_t scratchCap, HpackHandler& handler) {
+        size_t pos = 0;
+        while (pos < len) {
+            uint8_t b = in[pos];
+            const char* name;
+            const char* value;
+            size_t nameLen, valueLen;
+            uint32_t index;
+
+            if (b & 0x80) {
+                // Indexed field
+                if (!readInt(in, len, pos, 7, index) ||
+                    !lookup(index, name, nameLen, value, valueLen)) {
+                    return false;
+                }
+                handler.onHeader(name, nameLen, value, valueLen);
+            } else if ((b & 0xE0) == 0x20) {
+                // Dynamic table size update
+                if (!readInt(in, len, pos, 5, index) || index > TABLE_SIZE) {
+                    return false;
+                }
+                maxSize = index;
+                evictTo(maxSize);
+            } else {
+                // Literal: with incremental indexing, without, or never indexed
+                bool incremental = (b & 0xC0) == 0x40;
+                if (!readInt(in, len, pos, incremental ? 6 : 4, index)) {
+                    return false;
+                }
+                size_t used = 0;
+                if (index == 0) {
+                    if (!readString(in, len, pos, scratch, scratchCap, used, name, nameLen)) {
+                        return false;
+                    }
+                } else {
+                    if (!lookup(index, name, nameLen, value, valueLen)) {
+                        return false;
+                    }
+                    if (index > STATIC_COUNT) {
+                        // Inserting may move the table under us
+                        if (nameLen > scratchCap) return false;
+                        memcpy(scratch, name, nameLen);
+                        name = scratch;
+                        used = nameLen;
+                    }
+                }
+                if (!readString(in, len, pos, scratch, scratchCap, used, value, valueLen)) {
+                    return false;
+                }
+                handler.onHeader(name, nameLen, value, valueLen);
+                if (incremental) {
+                    insert(name, nameLen, value, valueLen);
+                }
+            }
+        }
+        return true;
+    }
+
+    size_t getTableSize() const {
+        return size;
+    }
+
+    int getEntryCount() const {
+        return count;
+    }
+};
+
+// ============================================
+// HPACK ENCODER (no dynamic table)
+// ============================================
+
+// Requests only use static indexes and literals, so
+// the server's table size setting never matters.
+class HpackEncoder {
+private:
+    uint8_t* buf;
+    size_t cap;
+    size_t len;
+    bool overflow;
+
+    void put(uint8_t b) {
+        if (len < cap) {
+            buf[len++] = b;
+        } else {
+            overflow = true;
+        }
+    }
+
+    void putInt(uint8_t flags, int prefix, uint32_t value) {
+        uint32_t max = (1u << prefix) - 1;
+        if (value < max) {
+            put(flags | (uint8_t)value);
+            return;
+        }
+        put(flags | (uint8_t)max);
+        value -= max;
+        while (value >= 0x80) {
+            put((uint8_t)(value & 0x7F) | 0x80);
+            value >>= 7;
+        }
+        put((uint8_t)value);
+    }
+
+public:
+    HpackEncoder(uint8_t* out, size_t capacity) : buf(out), cap(capacity), len(0), overflow(false) {}
+
+    void indexed(uint8_t index) {
+        putInt(0x80, 7, index);
+    }
+
+    // Literal value with a static-table name. Secrets are sent
+    // never-indexed so intermediaries won't store them either.
+    void literal(uint8_t nameIndex, const char* value, bool sensitive = false) {
+        size_t n = strlen(value);
+        putInt(sensitive ? 0x10 : 0x00, 4, nameIndex);
+        putInt(0x00, 7, (uint32_t)n);
+        for (size_t i = 0; i < n; i++) put((uint8_t)value[i]);
+    }
+
+    size_t length() const { return len; }
+    bool overflowed() const { return overflow; }
+};
+
+// ============================================
+// STREAM
+// ============================================
+
+class H2Connection;
+
+struct H2Stats {
+    uint32_t streamsOpened;
+    uint32_t framesIn;
+    uint32_t framesOut;
+    uint32_t windowUpdatesSent;
+    uint32_t bytesIn;
+    uint32_t bytesOut;
+};
+
+// One request/response exchange. Reads and writes work like any
+// Arduino Client; stop() releases the stream and its receive ring.
+class H2Stream : public Client {
+    friend class H2Connection;
+
+private:
+    H2Connection* conn;
+    uint32_t id;
+    bool inUse;
+    int status;
+    bool localClosed;     // We sent END_STREAM
+    bool remoteClosed;    // Server sent END_STREAM
+    bool reset;           // RST_STREAM either way, or connection lost
+    uint32_t errorCode;
+    long bodyRemaining;   // Request body still to send (-1 = unknown)
+    int32_t sendWindow;
+    int32_t recvWindow;
+    size_t unacked;       // Read by the app, not yet credited
+    uint8_t* ring;
+    size_t ringCap;
+    size_t ringHead;
+    size_t ringCount;
+
+    void clearState() {
+        id = 0;
+        inUse = false;
+        status = 0;
+        localClosed = false;
+        remoteClosed = false;
+        reset = false;
+        errorCode = H2_NO_ERROR;
+        bodyRemaining = -1;
+        sendWindow = 0;
+        recvWindow = 0;
+        unacked = 0;
+        ring = nullptr;
+        ringCap = 0;
+        ringHead = 0;
+        ringCount = 0;
+    }
+
+public:
+    H2Stream() : conn(nullptr) {
+        clearState();
+    }
+
+    // Streams are opened with H2Connection::request()
+    int connect(IPAddress ip, uint16_t port) override { (void)ip; (void)port; return 0; }
+    int connect(const char* host, uint16_t port) override { (void)host; (void)port; return 0; }
+    int connect(IPAddress ip, uint16_t port, int32_t timeout) { (void)ip; (void)port; (void)timeout; return 0; }
+    int connect(const char* host, uint16_t port, int32_t timeout) { (void)host; (void)port; (void)timeout; return 0; }
+
+    size_t write(uint8_t b) override {
+        return write(&b, 1);
+    }
+    size_t write(const uint8_t* buf, size_t size) override;
+    int available() override;
+    int read() override {
+        uint8_t b;
+        return read(&b, 1) == 1 ? b : -1;
+    }
+    int read(uint8_t* buf, size_t size) override;
+    int peek() override;
+    void flush() override {}
+    void stop() override;
+    uint8_t connected() override;
+    operator bool() override {
+        return inUse;
+    }
+
+    // Wait for the response :status (-1 on reset, timeout or lost connection)
+    int awaitStatus(unsigned long timeoutMs);
+
+    // END_STREAM for requests opened without a content length
+    bool finishRequest();
+
+    uint32_t getId() const { return id; }
+    uint32_t getErrorCode() const { return errorCode; }
+    bool isFinished() const { return remoteClosed && ringCount == 0; }
+};
+
+// ============================================
+// CONNECTION
+// ============================================
+
+class H2Connection : public HpackHandler {
+    friend class H2Stream;
+
+public:
+    static const int MAX_STREAMS = 4;
+
+private:
+    static const uint32_t DEFAULT_WINDOW = 65535;
+    static const uint32_t MAX_FRAME = 16384;      // We never raise SETTINGS_MAX_FRAME_SIZE
+    static const size_t POLL_BUDGET = 16384;      // Bytes handled per poll() pass
+    static const unsigned long WRITE_TIMEOUT = 15000;
+
+    Client* client;
+    const char* authority;
+    const char* authorization;
+    const char* poolName;
+    bool secure;
+    bool open;
+    bool goaway;
+    bool peerSettingsSeen;
+
+    // Memory
+    uint8_t* block;          // [header block | decode/encode scratch]
+    size_t blockSize;
+    size_t headerLimit;
+    int maxStreams;
+    size_t streamWindow;
+
+    H2Stream streams[MAX_STREAMS];
+    uint32_t nextStreamId;
+    HpackDecoder decoder;
+
+    // Peer settings and windows
+    int32_t connSendWindow;
+    int32_t peerInitialWindow;
+    uint32_t peerMaxFrame;
+    uint32_t peerMaxStreams;
+    int32_t connRecvWindow;
+    int32_t connWindowTarget;
+    size_t connUnacked;
+
+    // Receive state
+    enum RxState { RX_FRAME_HEADER, RX_PAYLOAD };
+    RxState rxState;
+    uint8_t fh[9];
+    size_t fhLen;
+    uint32_t fLen;
+    uint32_t fRemaining;
+    uint8_t fType;
+    uint8_t fFlags;
+    uint32_t fStream;
+    H2Stream* rxStream;      // DATA target (nullptr = discard)
+    bool needPadLength;
+    uint32_t dataLeft;
+    uint8_t padLen;
+    uint32_t rxConsumed;     // Frame bytes that never reach a ring
+    uint8_t ctrl[96];        // Payload of small control frames
+    size_t ctrlLen;
+
+    // Header block assembly (HEADERS + CONTINUATION)
+    bool hbActive;
+    uint32_t hbStream;
+    bool hbEndStream;
+    size_t hbLen;
+    size_t hbFrameStart;
+    H2Stream* hbTarget;
+
+    H2Stats stats;
+
+    static uint32_t be32(const uint8_t* p) {
+        return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+    }
+
+    static void putBe32(uint8_t* p, uint32_t v) {
+        p[0] = (uint8_t)(v >> 24);
+        p[1] = (uint8_t)(v >> 16);
+        p[2] = (uint8_t)(v >> 8);
+        p[3] = (uint8_t)v;
+    }
+
+    static void frameHeader(uint8_t* h, uint32_t len, uint8_t type, uint8_t flags, uint32_t stream) {
+        h[0] = (uint8_t)(len >> 16);
+        h[1] = (uint8_t)(len >> 8);
+        h[2] = (uint8_t)len;
+        h[3] = type;
+        h[4] = flags;
+        putBe32(h + 5, stream & 0x7FFFFFFF);
+    }
+
+    bool writeAll(const uint8_t* data, size_t n) {
+        while (n > 0) {
+            size_t w = client->write(data, n);
+            if (w == 0) {
+                Serial.println("H2: Write failed");
+                fail(H2_INTERNAL_ERROR, false);
+                return false;
+            }
+            data += w;
+            n -= w;
+            stats.bytesOut += w;
+        }
+        return true;
+    }
+
+    // Small frames go out in a single write (one TLS record)
+    bool sendFrame(uint8_t type, uint8_t flags, uint32_t stream, const uint8_t* payload, size_t len) {
+        uint8_t out[9 + 64];
+        frameHeader(out, (uint32_t)len, type, flags, stream);
+        stats.framesOut++;
+        if (len <= 64) {
+            if (len > 0) memcpy(out + 9, payload, len);
+            return writeAll(out, 9 + len);
+        }
+        return writeAll(out, 9) && writeAll(payload, len);
+    }
+
+    bool sendWindowUpdate(uint32_t stream, uint32_t increment) {
+        uint8_t p[4];
+        putBe32(p, increment & 0x7FFFFFFF);
+        stats.windowUpdatesSent++;
+        return sendFrame(H2_WINDOW_UPDATE, 0, stream, p, 4);
+    }
+
+    bool sendRst(uint32_t stream, uint32_t code) {
+        uint8_t p[4];
+        putBe32(p, code);
+        return sendFrame(H2_RST_STREAM, 0, stream, p, 4);
+    }
+
+    // Give the server its connection window back in big steps
+    void creditConnection(size_t n) {
+        connUnacked += n;
+        if (open && connUnacked >= (size_t)connWindowTarget / 2) {
+            if (sendWindowUpdate(0, (uint32_t)connUnacked)) {
+                connRecvWindow += (int32_t)connUnacked;
+                connUnacked = 0;
+            }
+        }
+    }
+
+    void creditStream(H2Stream& s, size_t n) {
+        s.unacked += n;
+        if (open && !s.remoteClosed && !s.reset && s.unacked >= s.ringCap / 2) {
+            if (sendWindowUpdate(s.id, (uint32_t)s.unacked)) {
+                s.recvWindow += (int32_t)s.unacked;
+                s.unacked = 0;
+            }
+        }
+        creditConnection(n);
+    }
+
+    H2Stream* findStream(uint32_t id) {
+        for (int i = 0; i < MAX_STREAMS; i++) {
+            if (streams[i].inUse && streams[i].id == id) return &streams[i];
+        }
+        return nullptr;
+    }
+
+    void failStream(H2Stream& s, uint32_t code) {
+        if (!s.reset && !s.remoteClosed && open) {
+            sendRst(s.id, code);
+        }
+        s.reset = true;
+        s.errorCode = code;
+    }
+
+    // Connection error: tell the server why (if we still can) and close
+    void fail(uint32_t code, bool notify = true) {
+        if (!open) return;
+        Serial.printf("H2: Connection error 0x%x\n", (unsigned)code);
+        open = false;
+        if (notify) {
+            uint8_t p[8];
+            putBe32(p, 0);
+            putBe32(p + 4, code);
+            uint8_t out[17];
+            frameHeader(out, 8, H2_GOAWAY, 0, 0);
+            memcpy(out + 9, p, 8);
+            client->write(out, sizeof(out));
+        }
+        client->stop();
+        markAllReset(code);
+    }
+
+    void markAllReset(uint32_t code) {
+        for (int i = 0; i < MAX_STREAMS; i++) {
+            H2Stream& s = streams[i];
+            if (s.inUse && !s.remoteClosed) {
+                s.reset = true;
+                s.errorCode = code;
+            }
+        }
+    }
+
+    void applySetting(uint16_t id, uint32_t value) {
+        switch (id) {
+            case H2_SETTINGS_INITIAL_WINDOW_SIZE: {
+                if (value > 0x7FFFFFFF) {
+                    fail(H2_FLOW_CONTROL_ERROR);
+                    return;
+                }
+                // Adjust every open stream by the difference
+                int32_t delta = (int32_t)value - peerInitialWindow;
+                peerInitialWindow = (int32_t)value;
+                for (int i = 0; i < MAX_STREAMS; i++) {
+                    if (streams[i].inUse) streams[i].sendWindow += delta;
+                }
+                break;
+            }
+            case H2_SETTINGS_MAX_FRAME_SIZE:
+                if (value < 16384 || value > 16777215) {
+                    fail(H2_PROTOCOL_ERROR);
+                    return;
+                }
+                peerMaxFrame = value;
+                break;
+            case H2_SETTINGS_MAX_CONCURRENT_STREAMS:
+                peerMaxStreams = value;
+                break;
+            default:
+                break;   // Table size, push, header list: nothing to do
+        }
+    }
+
+    bool startFrame() {
+        stats.framesIn++;
+
+        if (!peerSettingsSeen && fType != H2_SETTINGS) {
+            Serial.println("H2: Server did not answer with HTTP/2");
+            fail(H2_PROTOCOL_ERROR);
+            return false;
+        }
+        if (fLen > MAX_FRAME) {
+            fail(H2_FRAME_SIZE_ERROR);
+            return false;
+        }
+        if (hbActive && (fType != H2_CONTINUATION || fStream != hbStream)) {
+            fail(H2_PROTOCOL_ERROR);
+            return false;
+        }
+
+        ctrlLen = 0;
+        switch (fType) {
+            case H2_DATA: {
+                if (fStream == 0 || (int32_t)fLen > connRecvWindow) {
+                    fail(fStream == 0 ? H2_PROTOCOL_ERROR : H2_FLOW_CONTROL_ERROR);
+                    return false;
+                }
+                connRecvWindow -= (int32_t)fLen;
+                rxStream = findStream(fStream);
+                if (rxStream && (rxStream->reset || rxStream->remoteClosed)) {
+                    rxStream = nullptr;
+                }
+                if (rxStream && (int32_t)fLen > rxStream->recvWindow) {
+                    failStream(*rxStream, H2_FLOW_CONTROL_ERROR);
+                    rxStream = nullptr;
+                }
+                if (rxStream) {
+                    rxStream->recvWindow -= (int32_t)fLen;
+                }
+                needPadLength = (fFlags & H2_FLAG_PADDED) != 0;
+                padLen = 0;
+                rxConsumed = 0;
+                dataLeft = needPadLength ? 0 : fLen;
+                return true;
+            }
+            case H2_HEADERS:
+                if (fStream == 0 || (fStream & 1) == 0 || fStream >= nextStreamId) {
+                    fail(H2_PROTOCOL_ERROR);
+                    return false;
+                }
+                hbActive = true;
+                hbStream = fStream;
+                hbEndStream = (fFlags & H2_FLAG_END_STREAM) != 0;
+                hbLen = 0;
+                hbTarget = findStream(fStream);
+                // fall through
+            case H2_CONTINUATION:
+                if (!hbActive) {
+                    fail(H2_PROTOCOL_ERROR);
+                    return false;
+                }
+                if (hbLen + fLen > headerLimit) {
+                    Serial.println("H2: Header block too large");
+                    fail(H2_INTERNAL_ERROR);
+                    return false;
+                }
+                hbFrameStart = hbLen;
+                return true;
+            case H2_SETTINGS:
+                if (fStream != 0 || ((fFlags & H2_FLAG_ACK) ? fLen != 0 : fLen % 6 != 0)) {
+                    fail(H2_FRAME_SIZE_ERROR);
+                    return false;
+                }
+                return true;
+            case H2_PING:
+            case H2_WINDOW_UPDATE:
+            case H2_RST_STREAM:
+                if (fLen != (fType == H2_PING ? 8u : 4u)) {
+                    fail(H2_FRAME_SIZE_ERROR);
+                    return false;
+                }
+                return true;
+            case H2_GOAWAY:
+                if (fLen < 8) {
+                    fail(H2_FRAME_SIZE_ERROR);
+                    return false;
+                }
+                return true;
+            case H2_PUSH_PROMISE:
+                fail(H2_PROTOCOL_ERROR);   // Push is disabled in our SETTINGS
+                return false;
+            default:
+                return true;   // PRIORITY and unknown types are ignored
+        }
+    }
+
+    // Read up to n payload bytes of the current frame
+    int readPayload(size_t n) {
+        uint8_t trash[64];
+
+        if (fType == H2_DATA) {
+            if (needPadLength) {
+                int r = client->read(&padLen, 1);
+                if (r <= 0) return r;
+                if ((uint32_t)padLen + 1 > fLen) {
+                    fail(H2_PROTOCOL_ERROR);
+                    return -1;
+                }
+                needPadLength = false;
+                dataLeft = fLen - 1 - padLen;
+                rxConsumed++;
+                return 1;
+            }
+            if (dataLeft > 0 && rxStream) {
+                // Space from the tail to the end of the ring (or to the head)
+                H2Stream& s = *rxStream;
+                size_t tail = (s.ringHead + s.ringCount) % s.ringCap;
+                size_t contiguous = s.ringCap - tail;
+                if (contiguous > s.ringCap - s.ringCount) contiguous = s.ringCap - s.ringCount;
+                if (contiguous == 0) {
+                    // Only possible if the server ignored our window
+                    failStream(s, H2_FLOW_CONTROL_ERROR);
+                    rxStream = nullptr;
+                    return 0;
+                }
+                size_t want = n < dataLeft ? n : dataLeft;
+                if (want > contiguous) want = contiguous;
+                int r = client->read(s.ring + tail, want);
+                if (r > 0) {
+                    s.ringCount += r;
+                    dataLeft -= r;
+                }
+                return r;
+            }
+            // Padding, or data for a stream we no longer want
+            size_t want = n < sizeof(trash) ? n : sizeof(trash);
+            if (dataLeft > 0 && want > dataLeft) want = dataLeft;
+            int r = client->read(trash, want);
+            if (r > 0) {
+                if (dataLeft > 0) dataLeft -= r;
+                rxConsumed += r;
+            }
+            return r;
+        }
+
+        if (fType == H2_HEADERS || fType == H2_CONTINUATION) {
+            int r = client->read(block + hbLen, n);
+            if (r > 0) hbLen += r;
+            return r;
+        }
+
+        // Control frames: keep what fits, drop the rest (GOAWAY debug data)
+        if (fType == H2_SETTINGS) {
+            // Settings are applied one 6-byte entry at a time
+            size_t want = 6 - ctrlLen;
+            if (want > n) want = n;
+            int r = client->read(ctrl + ctrlLen, want);
+            if (r > 0) {
+                ctrlLen += r;
+                if (ctrlLen == 6) {
+                    applySetting((uint16_t)((ctrl[0] << 8) | ctrl[1]), be32(ctrl + 2));
+                    ctrlLen = 0;
+                }
+            }
+            return r;
+        }
+        if (ctrlLen < sizeof(ctrl)) {
+            size_t want = sizeof(ctrl) - ctrlLen;
+            if (want > n) want = n;
+            int r = client->read(ctrl + ctrlLen, want);
+            if (r > 0) ctrlLen += r;
+            return r;
+        }
+        size_t want = n < sizeof(trash) ? n : sizeof(trash);
+        return client->read(trash, want);
+    }
+
+    void endFrame() {
+        switch (fType) {
+            case H2_DATA:
+                // Padding and discarded data are consumed right away
+                if (rxStream) {
+                    if (rxConsumed > 0) creditStream(*rxStream, rxConsumed);
+                    if (fFlags & H2_FLAG_END_STREAM) rxStream->remoteClosed = true;
+                } else if (rxConsumed > 0) {
+                    creditConnection(rxConsumed);
+                }
+                rxStream = nullptr;
+                break;
+            case H2_HEADERS:
+            case H2_CONTINUATION: {
+                if (fType == H2_HEADERS) {
+                    // Strip padding and priority from this frame's fragment
+                    uint8_t* frag = block + hbFrameStart;
+                    size_t fragLen = hbLen - hbFrameStart;
+                    size_t skip = 0;
+                    size_t pad = 0;
+                    if (fFlags & H2_FLAG_PADDED) {
+                        if (fragLen < 1) { fail(H2_PROTOCOL_ERROR); return; }
+                        pad = frag[0];
+                        skip = 1;
+                    }
+                    if (fFlags & H2_FLAG_PRIORITY) skip += 5;
+                    if (skip + pad > fragLen) {
+                        fail(H2_PROTOCOL_ERROR);
+                        return;
+                    }
+                    memmove(frag, frag + skip, fragLen - skip - pad);
+                    hbLen = hbFrameStart + fragLen - skip - pad;
+                }
+                if (!(fFlags & H2_FLAG_END_HEADERS)) break;
+
+                hbActive = false;
+                char* scratch = (char*)block + headerLimit;
+                if (!decoder.decode(block, hbLen, scratch, blockSize - headerLimit, *this)) {
+                    Serial.println("H2: HPACK decode failed");
+                    fail(H2_COMPRESSION_ERROR);
+                    return;
+                }
+                if (hbTarget && hbEndStream) {
+                    hbTarget->remoteClosed = true;
+                }
+                hbTarget = nullptr;
+                break;
+            }
+            case H2_SETTINGS:
+                if (!(fFlags & H2_FLAG_ACK)) {
+                    peerSettingsSeen = true;
+                    sendFrame(H2_SETTINGS, H2_FLAG_ACK, 0, nullptr, 0);
+                }
+                break;
+            case H2_PING:
+                if (!(fFlags & H2_FLAG_ACK)) {
+                    sendFrame(H2_PING, H2_FLAG_ACK, 0, ctrl, 8);
+                }
+                break;
+            case H2_WINDOW_UPDATE: {
+                uint32_t inc = be32(ctrl) & 0x7FFFFFFF;
+                if (fStream == 0) {
+                    if (inc == 0 || (int64_t)connSendWindow + inc > 0x7FFFFFFF) {
+                        fail(inc == 0 ? H2_PROTOCOL_ERROR : H2_FLOW_CONTROL_ERROR);
+                        return;
+                    }
+                    connSendWindow += (int32_t)inc;
+                } else {
+                    H2Stream* s = findStream(fStream);
+                    if (!s) break;
+                    if (inc == 0 || (int64_t)s->sendWindow + inc > 0x7FFFFFFF) {
+                        failStream(*s, inc == 0 ? H2_PROTOCOL_ERROR : H2_FLOW_CONTROL_ERROR);
+                        break;
+                    }
+                    s->sendWindow += (int32_t)inc;
+                }
+                break;
+            }
+            case H2_RST_STREAM: {
+                H2Stream* s = findStream(fStream);
+                if (s) {
+                    s->reset = true;
+                    s->errorCode = be32(ctrl);
+                    Serial.printf("H2: Stream %u reset by server (0x%x)\n", (unsigned)s->id, (unsigned)s->errorCode);
+                }
+                break;
+            }
+            case H2_GOAWAY: {
+                goaway = true;
+                uint32_t last = be32(ctrl) & 0x7FFFFFFF;
+                for (int i = 0; i < MAX_STREAMS; i++) {
+                    H2Stream& s = streams[i];
+                    if (s.inUse && s.id > last && !s.remoteClosed) {
+                        s.reset = true;
+                        s.errorCode = H2_CANCEL;
+                    }
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    size_t processInput(size_t budget) {
+        size_t processed = 0;
+        while (open && processed < budget) {
+            int avail = client->available();
+            if (avail <= 0) break;
+
+            if (rxState == RX_FRAME_HEADER) {
+                size_t want = 9 - fhLen;
+                if (want > (size_t)avail) want = avail;
+                int r = client->read(fh + fhLen, want);
+                if (r <= 0) break;
+                fhLen += r;
+                processed += r;
+                if (fhLen < 9) continue;
+
+                fhLen = 0;
+                fLen = ((uint32_t)fh[0] << 16) | ((uint32_t)fh[1] << 8) | fh[2];
+                fType = fh[3];
+                fFlags = fh[4];
+                fStream = be32(fh + 5) & 0x7FFFFFFF;
+                if (!startFrame()) break;
+                fRemaining = fLen;
+                rxState = RX_PAYLOAD;
+            } else {
+                size_t want = fRemaining;
+                if (want > (size_t)avail) want = avail;
+                int r = readPayload(want);
+                if (r <= 0) break;
+                fRemaining -= r;
+                processed += r;
+            }
+
+            if (rxState == RX_PAYLOAD && fRemaining == 0) {
+                rxState = RX_FRAME_HEADER;
+                endFrame();
+            }
+        }
+        stats.bytesIn += processed;
+        return processed;
+    }
+
+    void releaseAll() {
+        for (int i = 0; i < MAX_STREAMS; i++) {
+            if (streams[i].inUse) {
+                memPools().free(streams[i].ring);
+                streams[i].clearState();
+            }
+        }
+    }
+
+public:
+    H2Connection(const char* bucket = "h2")
+        : client(nullptr), authority(""), authorization(nullptr), poolName(bucket),
+          secure(true), open(false), goaway(false), peerSettingsSeen(false),
+          block(nullptr), blockSize(0), headerLimit(0), maxStreams(3), streamWindow(16384),
+          nextStreamId(1), rxStream(nullptr), hbTarget(nullptr) {
+        for (int i = 0; i < MAX_STREAMS; i++) {
+            streams[i].conn = this;
+        }
+        memset(&stats, 0, sizeof(stats));
+    }
+
+    ~H2Connection() {
+        end();
+    }
+
+    // Streams open at once and the receive ring (= window) per stream.
+    // Pool blocks must be at least streamWindow bytes.
+    void setLimits(int streamsAtOnce, size_t windowBytes) {
+        maxStreams = streamsAtOnce < 1 ? 1 : (streamsAtOnce > MAX_STREAMS ? MAX_STREAMS : streamsAtOnce);
+        streamWindow = windowBytes;
+    }
+
+    // Send the preface and settings over an already connected client
+    // (TLS with ALPN "h2") and wait for the server's SETTINGS.
+    bool begin(Client& c, const char* host, const char* auth = nullptr,
+               bool useTls = true, unsigned long timeoutMs = 5000) {
+        end();
+
+        if (!block) {
+            MemPools& pools = memPools();
+            for (int i = 0; i < pools.getBucketCount(); i++) {
+                PoolBucketStats b = pools.getBucketStats(i);
+                if (strcmp(b.name, poolName) == 0) blockSize = b.blockSize;
+            }
+            if (blockSize < streamWindow || blockSize < 2048) {
+                Serial.printf("H2: Pool bucket '%s' missing or smaller than the window\n", poolName);
+                return false;
+            }
+            block = (uint8_t*)pools.allocFrom(poolName);
+            if (!block) {
+                Serial.println("H2: No connection buffer available");
+                return false;
+            }
+            headerLimit = blockSize / 2;
+        }
+
+        client = &c;
+        authority = host;
+        authorization = auth;
+        secure = useTls;
+        open = true;
+        goaway = false;
+        peerSettingsSeen = false;
+        nextStreamId = 1;
+        decoder.reset();
+        connSendWindow = DEFAULT_WINDOW;
+        peerInitialWindow = DEFAULT_WINDOW;
+        peerMaxFrame = MAX_FRAME;
+        peerMaxStreams = MAX_STREAMS;
+        connRecvWindow = DEFAULT_WINDOW;
+        connWindowTarget = DEFAULT_WINDOW;
+        connUnacked = 0;
+        rxState = RX_FRAME_HEADER;
+        fhLen = 0;
+        hbActive = false;
+        hbTarget = nullptr;
+        rxStream = nullptr;
+
+        static const char preface[] = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+        if (!writeAll((const uint8_t*)preface, sizeof(preface) - 1)) return false;
+
+        uint8_t settings[5 * 6];
+        const uint16_t ids[5] = {
+            H2_SETTINGS_HEADER_TABLE_SIZE, H2_SETTINGS_ENABLE_PUSH, H2_SETTINGS_MAX_CONCURRENT_STREAMS,
+            H2_SETTINGS_INITIAL_WINDOW_SIZE, H2_SETTINGS_MAX_HEADER_LIST_SIZE
+        };
+        const uint32_t values[5] = {
+            (uint32_t)HpackDecoder::TABLE_SIZE, 0, 0, (uint32_t)streamWindow, (uint32_t)headerLimit
+        };
+        for (int i = 0; i < 5; i++) {
+            settings[i * 6] = (uint8_t)(ids[i] >> 8);
+            settings[i * 6 + 1] = (uint8_t)ids[i];
+            putBe32(settings + i * 6 + 2, values[i]);
+        }
+        if (!sendFrame(H2_SETTINGS, 0, 0, settings, sizeof(settings))) return false;
+
+        // Connection window must cover every stream's window
+        int32_t wanted = (int32_t)(streamWindow * maxStreams);
+        if (wanted > connWindowTarget) {
+            sendWindowUpdate(0, (uint32_t)(wanted - connWindowTarget));
+            connRecvWindow = wanted;
+            connWindowTarget = wanted;
+        }
+
+        unsigned long start = millis();
+        while (open && !peerSettingsSeen && millis() - start < timeoutMs) {
+            poll(10);
+        }
+        if (!peerSettingsSeen) {
+            if (open) Serial.println("H2: No SETTINGS from server");
+            end();
+            return false;
+        }
+
+        Serial.printf("H2: Connected to %s (max frame %u, window %d)\n",
+            authority, (unsigned)peerMaxFrame, (int)peerInitialWindow);
+        return true;
+    }
+
+    bool isOpen() {
+        if (!client) return false;
+        if (open && !client->connected() && client->available() <= 0) {
+            Serial.println("H2: Connection closed by server");
+            open = false;
+            markAllReset(H2_CANCEL);
+        }
+        return open;
+    }
+
+    // Usable for new requests (GOAWAY lets running streams finish)
+    bool canRequest() {
+        return isOpen() && !goaway && nextStreamId < 0x7FFFFFFF;
+    }
+
+    int activeStreams() const {
+        int n = 0;
+        for (int i = 0; i < MAX_STREAMS; i++) {
+            if (streams[i].inUse) n++;
+        }
+        return n;
+    }
+
+    int freeStreams() const {
+        int limit = maxStreams < (int)peerMaxStreams ? maxStreams : (int)peerMaxStreams;
+        int n = limit - activeStreams();
+        return n > 0 ? n : 0;
+    }
+
+    // Open a stream and send the request headers. contentLength 0
+    // ends the request immediately; -1 means finishRequest() will.
+    H2Stream* request(const char* method, const char* path,
+                      const char* contentType = nullptr, long contentLength = 0) {
+        if (!canRequest()) return nullptr;
+        if (freeStreams() == 0) {
+            Serial.println("H2: No free stream");
+            return nullptr;
+        }
+
+        H2Stream* s = nullptr;
+        for (int i = 0; i < MAX_STREAMS && !s; i++) {
+            if (!streams[i].inUse) s = &streams[i];
+        }
+        uint8_t* ring = (uint8_t*)memPools().allocFrom(poolName);
+        if (!ring) {
+            Serial.println("H2: No stream buffer available");
+            return nullptr;
+        }
+
+        // Request headers are encoded into the scratch half of the block
+        HpackEncoder enc(block + headerLimit, blockSize - headerLimit);
+        if (strcmp(method, "POST") == 0) {
+            enc.indexed(3);
+        } else if (strcmp(method, "GET") == 0) {
+            enc.indexed(2);
+        } else {
+            enc.literal(2, method);
+        }
+        enc.indexed(secure ? 7 : 6);
+        enc.literal(4, path);
+        enc.literal(1, authority);
+        if (contentType) enc.literal(31, contentType);
+        if (contentLength > 0) {
+            char len[24];
+            snprintf(len, sizeof(len), "%ld", contentLength);
+            enc.literal(28, len);
+        }
+        if (authorization) enc.literal(23, authorization, true);
+
+        if (enc.overflowed() || enc.length() > peerMaxFrame) {
+            Serial.println("H2: Request headers too large");
+            memPools().free(ring);
+            return nullptr;
+        }
+
+        s->clearState();
+        s->id = nextStreamId;
+        s->inUse = true;
+        s->bodyRemaining = contentLength;
+        s->sendWindow = peerInitialWindow;
+        s->recvWindow = (int32_t)streamWindow;
+        s->ring = ring;
+        s->ringCap = streamWindow;
+        s->localClosed = contentLength == 0;
+        nextStreamId += 2;
+
+        uint8_t flags = H2_FLAG_END_HEADERS | (contentLength == 0 ? H2_FLAG_END_STREAM : 0);
+        if (!sendFrame(H2_HEADERS, flags, s->id, block + headerLimit, enc.length())) {
+            memPools().free(ring);
+            s->clearState();
+            return nullptr;
+        }
+        stats.streamsOpened++;
+        return s;
+    }
+
+    // Send request body bytes as DATA frames, waiting for window as needed
+    size_t sendData(H2Stream& s, const uint8_t* data, size_t size, bool endStream) {
+        size_t sent = 0;
+        unsigned long lastProgress = millis();
+
+        if (size == 0 && endStream) {
+            if (sendFrame(H2_DATA, H2_FLAG_END_STREAM, s.id, nullptr, 0)) s.localClosed = true;
+            return 0;
+        }
+
+        while (sent < size && open && !s.reset) {
+            size_t chunk = size - sent;
+            if (chunk > peerMaxFrame) chunk = peerMaxFrame;
+            if (s.sendWindow <= 0 || connSendWindow <= 0) {
+                chunk = 0;
+            } else {
+                if (chunk > (size_t)s.sendWindow) chunk = s.sendWindow;
+                if (chunk > (size_t)connSendWindow) chunk = connSendWindow;
+            }
+
+            if (chunk == 0) {
+                if (millis() - lastProgress > WRITE_TIMEOUT) {
+                    Serial.println("H2: Timed out waiting for send window");
+                    break;
+                }
+                poll(5);
+                continue;
+            }
+
+            bool last = endStream && sent + chunk == size;
+            uint8_t h[9];
+            frameHeader(h, (uint32_t)chunk, H2_DATA, last ? H2_FLAG_END_STREAM : 0, s.id);
+            stats.framesOut++;
+            if (!writeAll(h, 9) || !writeAll(data + sent, chunk)) break;
+            s.sendWindow -= (int32_t)chunk;
+            connSendWindow -= (int32_t)chunk;
+            sent += chunk;
+            lastProgress = millis();
+            if (last) s.localClosed = true;
+
+            // Keep up with pings and window updates during long uploads
+            processInput(1024);
+        }
+        return sent;
+    }
+
+    // Handle whatever the server sent. With waitMs > 0, wait up to
+    // that long for something to arrive.
+    bool poll(unsigned long waitMs = 0) {
+        unsigned long start = millis();
+        while (open) {
+            size_t n = processInput(POLL_BUDGET);
+            if (n > 0 || millis() - start >= waitMs) break;
+            if (!isOpen()) break;
+            delay(1);
+        }
+        return isOpen();
+    }
+
+    void releaseStream(H2Stream& s) {
+        if (!s.inUse) return;
+        if (!s.reset && (!s.remoteClosed || !s.localClosed) && open) {
+            sendRst(s.id, H2_CANCEL);
+        }
+        // Unread data still counts against the connection window
+        if (s.ringCount > 0 && open) {
+            creditConnection(s.ringCount);
+        }
+        memPools().free(s.ring);
+        s.clearState();
+    }
+
+    void end() {
+        if (open) {
+            uint8_t p[8];
+            putBe32(p, 0);   // We accept no server-initiated streams
+            putBe32(p + 4, H2_NO_ERROR);
+            sendFrame(H2_GOAWAY, 0, 0, p, 8);
+            client->stop();
+            open = false;
+        }
+        releaseAll();
+        if (block) {
+            memPools().free(block);
+            block = nullptr;
+        }
+    }
+
+    H2Stats getStats() const {
+        return stats;
+    }
+
+    // ---- HpackHandler ----
+
+    void onHeader(const char* name, size_t nameLen, const char* value, size_t valueLen) override {
+        if (!hbTarget || hbTarget->status >= 200) return;
+        if (nameLen == 7 && memcmp(name, ":status", 7) == 0) {
+            int code = 0;
+            for (size_t i = 0; i < valueLen && value[i] >= '0' && value[i] <= '9'; i++) {
+                code = code * 10 + (value[i] - '0');
+            }
+            // 1xx responses are informational; wait for the final one
+            hbTarget->status = code >= 200 ? code : 0;
+        }
+    }
+};
+
+// ============================================
+// STREAM I/O
+// ============================================
+
+inline size_t H2Stream::write(const uint8_t* buf, size_t size) {
+    if (!inUse || localClosed || reset) return 0;
+    bool end = false;
+    if (bodyRemaining >= 0) {
+        if ((long)size >= bodyRemaining) {
+            size = (size_t)bodyRemaining;
+            end = true;
+        }
+        if (size == 0 && !end) return 0;
+    }
+    size_t sent = conn->sendData(*this, buf, size, end);
+    if (bodyRemaining >= 0) bodyRemaining -= (long)sent;
+    return sent;
+}
+
+inline bool H2Stream::finishRequest() {
+    if (!inUse || localClosed || reset) return localClosed;
+    conn->sendData(*this, nullptr, 0, true);
+    return localClosed;
+}
+
+inline int H2Stream::available() {
+    if (inUse && ringCount == 0) conn->poll(0);
+    return (int)ringCount;
+}
+
+inline int H2Stream::read(uint8_t* buf, size_t size) {
+    if (!inUse) return -1;
+    if (ringCount == 0) conn->poll(0);
+    if (ringCount == 0) return -1;
+
+    size_t n = size < ringCount ? size : ringCount;
+    size_t first = ringCap - ringHead;
+    if (first > n) first = n;
+    memcpy(buf, ring + ringHead, first);
+    memcpy(buf + first, ring, n - first);
+    ringHead = (ringHead + n) % ringCap;
+    ringCount -= n;
+
+    conn->creditStream(*this, n);
+    return (int)n;
+}
+
+inline int H2Stream::peek() {
+    if (inUse && ringCount == 0) conn->poll(0);
+    return ringCount > 0 ? ring[ringHead] : -1;
+}
+
+inline void H2Stream::stop() {
+    if (conn) conn->releaseStream(*this);
+}
+
+inline uint8_t H2Stream::connected() {
+    if (!inUse) return 0;
+    if (ringCount > 0) return 1;
+    return (!remoteClosed && !reset && conn->isOpen()) ? 1 : 0;
+}
+
+inline int H2Stream::awaitStatus(unsigned long timeoutMs) {
+    unsigned long start = millis();
+    while (inUse && status == 0 && !reset && conn->isOpen() && millis() - start < timeoutMs) {
+        conn->poll(10);
+    }
+    return status > 0 ? status : -1;
+}
+
+#endif // H2_CLIENT_H
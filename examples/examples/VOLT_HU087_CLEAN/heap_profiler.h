@@ -0,0 +1,392 @@
+/*
+ * ============================================
+ * Heap Profiler - Fragmentation and Call Sites
+ * ============================================
+ *
+ * Handles:
+ * - Tracked malloc / ps_malloc / free
+ *   (VOLT_MALLOC, VOLT_PS_MALLOC, VOLT_FREE)
+ *   attributed to the calling file:line, and
+ *   the pool reservations by bucket name
+ * - Per call site: allocs, frees, failures,
+ *   live blocks and bytes, peak
+ * - A ring of samples of free heap, largest
+ *   free block and low-water mark for internal
+ *   RAM and PSRAM, so fragmentation shows up
+ *   as a trend instead of one number
+ * - Leak candidates: sites holding more than
+ *   at the baseline, with blocks older than
+ *   leakAgeMs
+ * - A text dump (serial "heap" command and
+ *   GET /api/heap)
+ *
+ * Opt-in: with VOLT_HEAP_PROFILE at 0 (the
+ * default, see config_stone.h) the tracked
+ * calls go straight to the HAL heap and the
+ * dump only prints the current heap numbers.
+ *
+ * The samples cover the whole heap (String,
+ * TLS and driver buffers included). Call-site
+ * numbers cover what is allocated through here.
+ * On the host the heap is the deterministic
+ * model in host/native_heap.h, for soak tests.
+ *
+ * ============================================
+ */
+
+#ifndef HEAP_PROFILER_H
+#define HEAP_PROFILER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "volt_hal.h"
+
+#ifndef VOLT_HEAP_PROFILE
+#define VOLT_HEAP_PROFILE 0
+#endif
+
+#define HEAP_SITE_STR2(x) #x
+#define HEAP_SITE_STR(x) HEAP_SITE_STR2(x)
+#define HEAP_SITE __FILE__ ":" HEAP_SITE_STR(__LINE__)
+
+// "path/to/file.h:123" -> "file.h:123"
+inline const char* heapSiteName(const char* site) {
+    const char* slash = strrchr(site, '/');
+    return slash ? slash + 1 : site;
+}
+
+// Fragmentation in percent: how much of the free heap can't be
+// had in one piece
+inline unsigned heapFragPercent(size_t freeBytes, size_t largestFree) {
+    if (freeBytes == 0) return 0;
+    return (unsigned)(100 - (uint64_t)largestFree * 100 / freeBytes);
+}
+
+#if VOLT_HEAP_PROFILE
+
+// ============================================
+// PROFILER
+// ============================================
+
+struct HeapSiteStats {
+    const char* name;
+    uint32_t allocs;
+    uint32_t frees;
+    uint32_t failures;
+    uint32_t liveBlocks;
+    size_t liveBytes;
+    size_t peakBytes;
+    size_t baselineBytes;        // liveBytes at markBaseline()
+};
+
+struct HeapSample {
+    uint32_t ms;
+    uint32_t internalFree;
+    uint32_t internalLargest;
+    uint32_t internalMin;
+    uint32_t psramFree;
+    uint32_t psramLargest;
+    uint32_t trackedBytes;       // Live through this profiler
+};
+
+class HeapProfiler {
+public:
+    static const int MAX_SITES = 32;
+    static const int MAX_LIVE = 256;
+    static const int MAX_SAMPLES = 64;
+
+private:
+    struct LiveBlock {
+        void* ptr;
+        uint32_t size;
+        uint32_t bornMs;
+        uint8_t site;
+    };
+
+    HeapSiteStats sites[MAX_SITES];
+    int siteCount;
+    LiveBlock live[MAX_LIVE];
+    int liveCount;
+    uint32_t untracked;          // Blocks that didn't fit in live[]
+    size_t trackedBytes;
+
+    HeapSample samples[MAX_SAMPLES];
+    int sampleHead;
+    int sampleCount;
+    uint32_t intervalMs;
+    uint32_t lastSampleMs;
+    uint32_t leakAgeMs;
+
+    HalLock mutex;
+
+    void lock() { halLockTake(mutex); }
+
+    void unlock() { halLockGive(mutex); }
+
+    // Sites are string literals, so the pointer identifies them;
+    // the last slot collects everything past MAX_SITES
+    int siteIndex(const char* name) {
+        for (int i = 0; i < siteCount; i++) {
+            if (sites[i].name == name) return i;
+        }
+        if (siteCount == MAX_SITES) return MAX_SITES - 1;
+        HeapSiteStats& s = sites[siteCount];
+        memset(&s, 0, sizeof(s));
+        s.name = siteCount == MAX_SITES - 1 ? "(other)" : name;
+        return siteCount++;
+    }
+
+    int findLive(const void* p) const {
+        for (int i = 0; i < liveCount; i++) {
+            if (live[i].ptr == p) return i;
+        }
+        return -1;
+    }
+
+public:
+    HeapProfiler() {
+        mutex = halLockCreate();
+        intervalMs = 10000;
+        leakAgeMs = 10 * 60 * 1000UL;
+        reset();
+    }
+
+    ~HeapProfiler() {
+        halLockDelete(mutex);
+    }
+
+    // Forget all sites, blocks and samples (blocks stay allocated)
+    void reset() {
+        lock();
+        siteCount = 0;
+        liveCount = 0;
+        untracked = 0;
+        trackedBytes = 0;
+        sampleHead = 0;
+        sampleCount = 0;
+        lastSampleMs = 0;
+        unlock();
+    }
+
+    void setSampleInterval(uint32_t ms) { intervalMs = ms; }
+    void setLeakAge(uint32_t ms) { leakAgeMs = ms; }
+
+    void* alloc(size_t size, uint8_t caps, const char* site) {
+        void* p = halHeapAlloc(size, caps);
+        uint32_t now = (uint32_t)halMillis();
+        lock();
+        HeapSiteStats& s = sites[siteIndex(site)];
+        if (!p) {
+            s.failures++;
+            unlock();
+            return nullptr;
+        }
+        s.allocs++;
+        s.liveBlocks++;
+        s.liveBytes += size;
+        if (s.liveBytes > s.peakBytes) s.peakBytes = s.liveBytes;
+        trackedBytes += size;
+        if (liveCount < MAX_LIVE) {
+            LiveBlock& b = live[liveCount++];
+            b.ptr = p;
+            b.size = (uint32_t)size;
+            b.bornMs = now;
+            b.site = (uint8_t)(&s - sites);
+        } else {
+            untracked++;
+        }
+        unlock();
+        return p;
+    }
+
+    void free(void* p) {
+        if (!p) return;
+        lock();
+        int i = findLive(p);
+        if (i >= 0) {
+            HeapSiteStats& s = sites[live[i].site];
+            s.frees++;
+            s.liveBlocks--;
+            s.liveBytes -= live[i].size;
+            trackedBytes -= live[i].size;
+            live[i] = live[--liveCount];
+        }
+        unlock();
+        halHeapFree(p);
+    }
+
+    // Take the current live bytes per site as normal (after boot)
+    void markBaseline() {
+        lock();
+        for (int i = 0; i < siteCount; i++) {
+            sites[i].baselineBytes = sites[i].liveBytes;
+        }
+        unlock();
+    }
+
+    void sample(uint32_t nowMs) {
+        HalHeapInfo internal = halHeapInfo(HAL_HEAP_INTERNAL);
+        HalHeapInfo psram = halHeapInfo(HAL_HEAP_SPIRAM);
+        lock();
+        HeapSample& s = samples[(sampleHead + sampleCount) % MAX_SAMPLES];
+        if (sampleCount == MAX_SAMPLES) {
+            sampleHead = (sampleHead + 1) % MAX_SAMPLES;
+        } else {
+            sampleCount++;
+        }
+        s.ms = nowMs;
+        s.internalFree = (uint32_t)internal.freeBytes;
+        s.internalLargest = (uint32_t)internal.largestFree;
+        s.internalMin = (uint32_t)internal.minFree;
+        s.psramFree = (uint32_t)psram.freeBytes;
+        s.psramLargest = (uint32_t)psram.largestFree;
+        s.trackedBytes = (uint32_t)trackedBytes;
+        lastSampleMs = nowMs;
+        unlock();
+    }
+
+    // Call from loop(); samples once per interval. True if it did.
+    bool tick(uint32_t nowMs) {
+        if (sampleCount > 0 && nowMs - lastSampleMs < intervalMs) return false;
+        sample(nowMs);
+        return true;
+    }
+
+    int getSiteCount() const { return siteCount; }
+    HeapSiteStats getSite(int i) const { return sites[i]; }
+    int getSampleCount() const { return sampleCount; }
+    uint32_t getUntracked() const { return untracked; }
+    size_t getTrackedBytes() const { return trackedBytes; }
+
+    // 0 = oldest
+    HeapSample getSample(int i) const {
+        return samples[(sampleHead + i) % MAX_SAMPLES];
+    }
+
+    // Oldest live block of a site (0 if none)
+    uint32_t oldestBlockMs(int site, uint32_t nowMs) const {
+        uint32_t age = 0;
+        for (int i = 0; i < liveCount; i++) {
+            if (live[i].site == site && nowMs - live[i].bornMs > age) {
+                age = nowMs - live[i].bornMs;
+            }
+        }
+        return age;
+    }
+
+    bool isLeakCandidate(int site, uint32_t nowMs) const {
+        return sites[site].liveBytes > sites[site].baselineBytes &&
+               oldestBlockMs(site, nowMs) >= leakAgeMs;
+    }
+
+    void dump(Print& out, uint32_t nowMs) {
+        lock();
+        out.printf("Sites (%d):\n", siteCount);
+        out.printf("  %-28s %7s %7s %5s %6s %9s %9s\n",
+                   "site", "allocs", "frees", "fails", "blocks", "live", "peak");
+        // Biggest holders first (selection: the table is small)
+        bool shown[MAX_SITES] = {};
+        for (int n = 0; n < siteCount; n++) {
+            int best = -1;
+            for (int i = 0; i < siteCount; i++) {
+                if (!shown[i] && (best < 0 || sites[i].liveBytes > sites[best].liveBytes)) best = i;
+            }
+            shown[best] = true;
+            const HeapSiteStats& s = sites[best];
+            out.printf("  %-28s %7u %7u %5u %6u %9u %9u\n", heapSiteName(s.name),
+                       (unsigned)s.allocs, (unsigned)s.frees, (unsigned)s.failures,
+                       (unsigned)s.liveBlocks, (unsigned)s.liveBytes, (unsigned)s.peakBytes);
+        }
+        if (untracked) {
+            out.printf("  (%u blocks not tracked: live table full)\n", (unsigned)untracked);
+        }
+
+        out.printf("Samples (every %u s, oldest first):\n", (unsigned)(intervalMs / 1000));
+        out.printf("  %8s %9s %9s %5s %9s %9s %9s %5s %9s\n", "t s", "int free",
+                   "largest", "frag", "min free", "psram", "largest", "frag", "tracked");
+        for (int i = 0; i < sampleCount; i++) {
+            const HeapSample& s = samples[(sampleHead + i) % MAX_SAMPLES];
+            out.printf("  %8u %9u %9u %4u%% %9u %9u %9u %4u%% %9u\n", (unsigned)(s.ms / 1000),
+                       (unsigned)s.internalFree, (unsigned)s.internalLargest,
+                       heapFragPercent(s.internalFree, s.internalLargest), (unsigned)s.internalMin,
+                       (unsigned)s.psramFree, (unsigned)s.psramLargest,
+                       heapFragPercent(s.psramFree, s.psramLargest), (unsigned)s.trackedBytes);
+        }
+
+        out.print("Leak candidates:\n");
+        int leaks = 0;
+        for (int i = 0; i < siteCount; i++) {
+            if (!isLeakCandidate(i, nowMs)) continue;
+            const HeapSiteStats& s = sites[i];
+            out.printf("  %-28s +%u bytes since baseline, %u blocks, oldest %u s\n",
+                       heapSiteName(s.name), (unsigned)(s.liveBytes - s.baselineBytes),
+                       (unsigned)s.liveBlocks, (unsigned)(oldestBlockMs(i, nowMs) / 1000));
+            leaks++;
+        }
+        if (leaks == 0) {
+            out.print("  none\n");
+        }
+        unlock();
+    }
+};
+
+inline HeapProfiler& heapProfiler() {
+    static HeapProfiler profiler;
+    return profiler;
+}
+
+inline void* voltHeapAlloc(size_t size, uint8_t caps, const char* site) {
+    return heapProfiler().alloc(size, caps, site);
+}
+
+inline void voltHeapFree(void* p) {
+    heapProfiler().free(p);
+}
+
+#define HEAP_PROFILE_TICK(nowMs) heapProfiler().tick(nowMs)
+#define HEAP_PROFILE_BASELINE() heapProfiler().markBaseline()
+
+#else
+
+inline void* voltHeapAlloc(size_t size, uint8_t caps, const char* site) {
+    return halHeapAlloc(size, caps);
+}
+
+inline void voltHeapFree(void* p) {
+    halHeapFree(p);
+}
+
+#define HEAP_PROFILE_TICK(nowMs)
+#define HEAP_PROFILE_BASELINE()
+
+#endif // VOLT_HEAP_PROFILE
+
+// Drop-in tracked versions of malloc / ps_malloc / free
+#define VOLT_MALLOC(size) voltHeapAlloc((size), 0, HEAP_SITE)
+#define VOLT_PS_MALLOC(size) voltHeapAlloc((size), HAL_HEAP_SPIRAM, HEAP_SITE)
+#define VOLT_FREE(p) voltHeapFree(p)
+
+// ============================================
+// DUMP
+// ============================================
+
+inline void heapProfileDump(Print& out) {
+    uint32_t now = (uint32_t)halMillis();
+    HalHeapInfo internal = halHeapInfo(HAL_HEAP_INTERNAL);
+    HalHeapInfo psram = halHeapInfo(HAL_HEAP_SPIRAM);
+    out.printf("=== Heap (uptime %u s) ===\n", (unsigned)(now / 1000));
+    out.printf("Internal: free %u, largest %u (frag %u%%), min free %u\n",
+               (unsigned)internal.freeBytes, (unsigned)internal.largestFree,
+               heapFragPercent(internal.freeBytes, internal.largestFree), (unsigned)internal.minFree);
+    out.printf("PSRAM:    free %u, largest %u (frag %u%%), min free %u\n",
+               (unsigned)psram.freeBytes, (unsigned)psram.largestFree,
+               heapFragPercent(psram.freeBytes, psram.largestFree), (unsigned)psram.minFree);
+#if VOLT_HEAP_PROFILE
+    heapProfiler().dump(out, now);
+#else
+    out.print("Call sites: off (build with VOLT_HEAP_PROFILE 1)\n");
+#endif
+}
+
+#endif // HEAP_PROFILER_H
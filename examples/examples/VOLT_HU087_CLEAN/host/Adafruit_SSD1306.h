@@ -0,0 +1,33 @@
+/*
+ * ============================================
+ * Host Shim - SSD1306 OLED
+ * ============================================
+ *
+ * Accepts the drawing calls phase 1 makes and
+ * throws them away.
+ *
+ * ============================================
+ */
+
+#ifndef HOST_ADAFRUIT_SSD1306_H
+#define HOST_ADAFRUIT_SSD1306_H
+
+#include "Arduino.h"
+
+#define SSD1306_WHITE 1
+#define SSD1306_BLACK 0
+
+class Adafruit_SSD1306 : public Print {
+public:
+    size_t write(uint8_t) override { return 1; }
+    using Print::write;
+
+    bool begin(int = 0, int = 0) { return true; }
+    void clearDisplay() {}
+    void display() {}
+    void setTextSize(int) {}
+    void setTextColor(int) {}
+    void setCursor(int, int) {}
+};
+
+#endif // HOST_ADAFRUIT_SSD1306_H
@@ -0,0 +1,219 @@
+/*
+ * ============================================
+ * Host Shim - Minimal Arduino API on Linux
+ * ============================================
+ *
+ * Just enough of the Arduino core for the
+ * portable firmware headers (h2_client.h,
+ * ws_client.h, turn_arena.h, mem_pools.h), the
+ * engine on the native HAL (volt_hal.h) and
+ * phase 1's sos_system.h to compile into host
+ * tests and benchmarks.
+ *
+ * ============================================
+ */
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include <unistd.h>
+#include <string>
+#include "native_clock.h"
+
+// Time comes from the native HAL clock (real or virtual)
+inline unsigned long millis() {
+    return (unsigned long)(nativeClock().nowUs() / 1000);
+}
+
+inline unsigned long micros() {
+    return (unsigned long)nativeClock().nowUs();
+}
+
+inline void delay(unsigned long ms) {
+    nativeClock().sleepUs((uint64_t)ms * 1000);
+}
+
+#define LOW             0
+#define HIGH            1
+#define INPUT           0x01
+#define OUTPUT          0x03
+#define INPUT_PULLUP    0x05
+
+template <typename T>
+inline T min(T a, T b) { return b < a ? b : a; }
+
+template <typename T>
+inline T max(T a, T b) { return a < b ? b : a; }
+
+inline long random(long howbig) {
+    return howbig > 0 ? rand() % howbig : 0;
+}
+
+inline long random(long howsmall, long howbig) {
+    return howsmall >= howbig ? howsmall : howsmall + random(howbig - howsmall);
+}
+
+// ============================================
+// STRING
+// ============================================
+
+// The calls sos_system.h makes; ArduinoJson reads it through
+// c_str()/length() and serializes into it through write()
+class String {
+private:
+    std::string s;
+
+public:
+    typedef char value_type;
+
+    String(const char* c = "") : s(c ? c : "") {}
+    String(const std::string& v) : s(v) {}
+    String(int v) : s(std::to_string(v)) {}
+    String(long v) : s(std::to_string(v)) {}
+    String(unsigned long v) : s(std::to_string(v)) {}
+
+    const char* c_str() const { return s.c_str(); }
+    size_t length() const { return s.size(); }
+    char operator[](size_t i) const { return i < s.size() ? s[i] : 0; }
+
+    int indexOf(char c, int from = 0) const {
+        size_t i = s.find(c, from < 0 ? 0 : from);
+        return i == std::string::npos ? -1 : (int)i;
+    }
+    int indexOf(const String& t, int from = 0) const {
+        size_t i = s.find(t.s, from < 0 ? 0 : from);
+        return i == std::string::npos ? -1 : (int)i;
+    }
+    bool startsWith(const String& t) const { return s.compare(0, t.s.size(), t.s) == 0; }
+    bool endsWith(const String& t) const {
+        return s.size() >= t.s.size() && s.compare(s.size() - t.s.size(), t.s.size(), t.s) == 0;
+    }
+    String substring(int from) const { return substring(from, (int)s.size()); }
+    String substring(int from, int to) const {
+        if (from < 0) from = 0;
+        if (to > (int)s.size()) to = (int)s.size();
+        return from < to ? String(s.substr(from, to - from)) : String();
+    }
+    long toInt() const { return strtol(s.c_str(), nullptr, 10); }
+
+    bool concat(const String& t) { s += t.s; return true; }
+    String& operator+=(const String& t) { s += t.s; return *this; }
+    String& operator+=(char c) { s += c; return *this; }
+    bool operator==(const String& t) const { return s == t.s; }
+    bool operator!=(const String& t) const { return s != t.s; }
+
+    size_t write(uint8_t c) { s += (char)c; return 1; }
+    size_t write(const uint8_t* buf, size_t n) { s.append((const char*)buf, n); return n; }
+};
+
+inline String operator+(const String& a, const String& b) {
+    String out(a);
+    out += b;
+    return out;
+}
+
+// ============================================
+// PRINT / STREAM
+// ============================================
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t b) = 0;
+    virtual size_t write(const uint8_t* buf, size_t size) {
+        size_t n = 0;
+        while (size--) n += write(*buf++);
+        return n;
+    }
+    size_t write(const char* s) {
+        return s ? write((const uint8_t*)s, strlen(s)) : 0;
+    }
+    size_t print(const char* s) {
+        return write(s);
+    }
+    size_t println(const char* s = "") {
+        return write(s) + write((const uint8_t*)"\r\n", 2);
+    }
+    size_t print(const String& s) {
+        return print(s.c_str());
+    }
+    size_t println(const String& s) {
+        return println(s.c_str());
+    }
+    size_t printf(const char* fmt, ...) {
+        char buf[256];
+        va_list args;
+        va_start(args, fmt);
+        int n = vsnprintf(buf, sizeof(buf), fmt, args);
+        va_end(args);
+        if (n < 0) return 0;
+        return write((const uint8_t*)buf, (size_t)n < sizeof(buf) ? (size_t)n : sizeof(buf) - 1);
+    }
+    virtual void flush() {}
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
+
+// Serial goes to stdout
+class HostSerial : public Print {
+public:
+    bool quiet = false;          // Drop output (benchmarks printing JSON)
+
+    size_t write(uint8_t b) override {
+        return quiet ? 1 : fwrite(&b, 1, 1, stdout);
+    }
+    size_t write(const uint8_t* buf, size_t size) override {
+        return quiet ? size : fwrite(buf, 1, size, stdout);
+    }
+    using Print::write;
+    size_t println(const char* s = "") {
+        return write(s) + write((const uint8_t*)"\n", 1);
+    }
+    size_t println(const String& s) {
+        return println(s.c_str());
+    }
+};
+
+inline HostSerial& hostSerial() {
+    static HostSerial serial;
+    return serial;
+}
+#define Serial hostSerial()
+
+// ============================================
+// IP ADDRESS
+// ============================================
+
+class IPAddress {
+private:
+    uint8_t bytes[4];
+
+public:
+    IPAddress() { memset(bytes, 0, sizeof(bytes)); }
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+        bytes[0] = a; bytes[1] = b; bytes[2] = c; bytes[3] = d;
+    }
+    // Raw address in network byte order, as on the ESP32
+    IPAddress(uint32_t address) { memcpy(bytes, &address, sizeof(bytes)); }
+    operator uint32_t() const {
+        uint32_t address;
+        memcpy(&address, bytes, sizeof(address));
+        return address;
+    }
+    uint8_t operator[](int i) const { return bytes[i]; }
+    uint8_t& operator[](int i) { return bytes[i]; }
+};
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,167 @@
+/*
+ * ============================================
+ * Host Shim - ESP32 HTTPClient
+ * ============================================
+ *
+ * The subset phase 1 uses (begin, addHeader,
+ * POST, getString, end) over any Client, with
+ * the ESP32 library's behaviour where it shows:
+ * - An open socket is reused, a dropped one is
+ *   reconnected on the next request
+ * - Same negative error codes and 5 s timeout
+ * - The body is only read by getString()
+ *
+ * ============================================
+ */
+
+#ifndef HOST_HTTPCLIENT_H
+#define HOST_HTTPCLIENT_H
+
+#include "WiFi.h"
+
+#define HTTP_CODE_OK                    200
+#define HTTP_CODE_CREATED               201
+
+#define HTTPC_ERROR_CONNECTION_REFUSED  (-1)
+#define HTTPC_ERROR_SEND_PAYLOAD_FAILED (-3)
+#define HTTPC_ERROR_NOT_CONNECTED       (-4)
+#define HTTPC_ERROR_CONNECTION_LOST     (-5)
+#define HTTPC_ERROR_READ_TIMEOUT        (-11)
+
+class HTTPClient {
+private:
+    static const unsigned long TIMEOUT_MS = 5000;   // HTTPCLIENT_DEFAULT_TCP_TIMEOUT
+
+    Client* client;
+    NativeTlsClient ownClient;   // begin(url) without a client
+    String host;
+    uint16_t port;
+    String uri;
+    String headers;
+    long contentLength;          // Of the last response (-1 = until close)
+
+    bool connect() {
+        if (!client) return false;
+        if (client->connected()) return true;
+        return client->connect(host.c_str(), port) != 0;
+    }
+
+    // One header line without its CRLF; 0 or an HTTPC_ERROR_ code
+    int readLine(String& line) {
+        line = "";
+        unsigned long start = millis();
+        while (millis() - start < TIMEOUT_MS) {
+            int c = client->read();
+            if (c < 0) {
+                if (!client->connected()) return HTTPC_ERROR_CONNECTION_LOST;
+                delay(1);
+                continue;
+            }
+            if (c == '\n') return 0;
+            if (c != '\r') line += (char)c;
+        }
+        return HTTPC_ERROR_READ_TIMEOUT;
+    }
+
+public:
+    HTTPClient() : client(nullptr), port(0), contentLength(-1) {}
+
+    bool begin(Client& c, const String& h, uint16_t p, const String& u, bool https) {
+        client = &c;
+        host = h;
+        port = p;
+        uri = u;
+        headers = "";
+        return true;
+    }
+
+    bool begin(const String& url) {
+        int start = url.indexOf("://");
+        if (start < 0) return false;
+        bool https = url.startsWith("https");
+        start += 3;
+        int end = url.indexOf('/', start);
+        if (end < 0) end = (int)url.length();
+        String hostPort = url.substring(start, end);
+        uint16_t p = https ? 443 : 80;
+        int colon = hostPort.indexOf(':');
+        if (colon >= 0) {
+            p = (uint16_t)hostPort.substring(colon + 1).toInt();
+            hostPort = hostPort.substring(0, colon);
+        }
+        String path = end < (int)url.length() ? url.substring(end) : String("/");
+        return begin(ownClient, hostPort, p, path, https);
+    }
+
+    void addHeader(const String& name, const String& value) {
+        headers += name + ": " + value + "\r\n";
+    }
+
+    // Status code, or a negative HTTPC_ERROR_ code
+    int POST(const String& payload) {
+        if (!connect()) return HTTPC_ERROR_CONNECTION_REFUSED;
+
+        String head = "POST " + uri + " HTTP/1.1\r\n"
+                      "Host: " + host + "\r\n"
+                      "User-Agent: ESP32HTTPClient\r\n"
+                      "Connection: keep-alive\r\n" + headers +
+                      "Content-Length: " + String((long)payload.length()) + "\r\n\r\n";
+        if (client->write((const uint8_t*)head.c_str(), head.length()) != head.length() ||
+            client->write((const uint8_t*)payload.c_str(), payload.length()) != payload.length()) {
+            client->stop();
+            return HTTPC_ERROR_SEND_PAYLOAD_FAILED;
+        }
+
+        String line;
+        int err = readLine(line);
+        if (err) {
+            client->stop();
+            return err;
+        }
+        int space = line.indexOf(' ');
+        int code = space > 0 ? (int)line.substring(space + 1).toInt() : 0;
+
+        contentLength = -1;
+        while ((err = readLine(line)) == 0 && line.length() > 0) {
+            String lower;
+            for (size_t i = 0; i < line.length(); i++) {
+                char c = line[i];
+                lower += (c >= 'A' && c <= 'Z') ? (char)(c + 32) : c;
+            }
+            if (lower.startsWith("content-length:")) {
+                contentLength = line.substring(15).toInt();
+            }
+        }
+        if (err) {
+            client->stop();
+            return err;
+        }
+        return code;
+    }
+
+    String getString() {
+        String body;
+        if (!client) return body;
+        unsigned long last = millis();
+        while ((contentLength < 0 || (long)body.length() < contentLength) &&
+               millis() - last < TIMEOUT_MS) {
+            uint8_t buf[256];
+            int n = client->read(buf, sizeof(buf));
+            if (n > 0) {
+                body.write(buf, n);
+                last = millis();
+            } else if (!client->connected()) {
+                break;
+            } else {
+                delay(1);
+            }
+        }
+        return body;
+    }
+
+    void end() {
+        if (client) client->stop();
+    }
+};
+
+#endif // HOST_HTTPCLIENT_H
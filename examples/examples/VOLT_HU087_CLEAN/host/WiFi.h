@@ -0,0 +1,38 @@
+/*
+ * ============================================
+ * Host Shim - WiFi
+ * ============================================
+ *
+ * WiFi.status() follows halNetConnected() and
+ * WiFi.RSSI() reports nativeHal().rssi; plain
+ * WiFiClient is the native socket client.
+ *
+ * ============================================
+ */
+
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+#include "volt_hal.h"
+
+typedef NativeTlsClient WiFiClient;
+
+enum wl_status_t {
+    WL_IDLE_STATUS = 0,
+    WL_CONNECTED = 3,
+    WL_DISCONNECTED = 6
+};
+
+class HostWiFi {
+public:
+    wl_status_t status() { return halNetConnected() ? WL_CONNECTED : WL_DISCONNECTED; }
+    int RSSI() { return nativeHal().rssi; }
+};
+
+inline HostWiFi& hostWiFi() {
+    static HostWiFi wifi;
+    return wifi;
+}
+#define WiFi hostWiFi()
+
+#endif // HOST_WIFI_H
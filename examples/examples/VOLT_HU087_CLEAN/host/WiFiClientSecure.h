@@ -0,0 +1,19 @@
+/*
+ * ============================================
+ * Host Shim - WiFiClientSecure
+ * ============================================
+ *
+ * Same native client as WiFiClient: TLS or not
+ * is decided by the port or the route.
+ *
+ * ============================================
+ */
+
+#ifndef HOST_WIFI_CLIENT_SECURE_H
+#define HOST_WIFI_CLIENT_SECURE_H
+
+#include "WiFi.h"
+
+typedef NativeTlsClient WiFiClientSecure;
+
+#endif // HOST_WIFI_CLIENT_SECURE_H
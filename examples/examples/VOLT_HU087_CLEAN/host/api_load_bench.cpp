@@ -0,0 +1,225 @@
+/*
+ * ============================================
+ * Device API Load Benchmark (host)
+ * ============================================
+ *
+ * Serves device_api.h on the native HAL (one
+ * thread polling, like the watch's API task) and
+ * hits GET /api/status from 1-20 concurrent
+ * clients in three modes:
+ *
+ *   close       a new connection per request
+ *               (what curl and the dashboard do)
+ *   keep-alive  one connection per client,
+ *               requests back to back
+ *   stalled     keep-alive, plus one client that
+ *               sends half a request and goes
+ *               quiet (the case that used to
+ *               stall the whole loop)
+ *
+ * Reports requests/s, p50 and p99 latency and
+ * errors (503 once the pool of 8 is full, or no
+ * answer) for each level.
+ *
+ * Build and run (from this directory):
+ *   cmake -S . -B build && cmake --build build
+ *   ./build/api_load_bench --requests 2000
+ *
+ * ============================================
+ */
+
+#include "device_api.h"
+
+#include <arpa/inet.h>
+#include <netinet/tcp.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+static uint16_t port = 0;
+
+static double nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ============================================
+// CLIENT
+// ============================================
+
+static int openConnection() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    struct timeval tv = { 2, 0 };                 // A lost answer is an error, not a hang
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Reads one response; its status, or -1 if the connection died
+static int readResponse(int fd, bool& serverClosed) {
+    std::string buf;
+    char tmp[2048];
+    serverClosed = false;
+    for (;;) {
+        ssize_t n = recv(fd, tmp, sizeof(tmp), 0);
+        if (n <= 0) return -1;
+        buf.append(tmp, n);
+        size_t end = buf.find("\r\n\r\n");
+        if (end == std::string::npos) continue;
+        bool done = false;
+        size_t cl = buf.find("Content-Length: ");
+        if (cl != std::string::npos && cl < end) {
+            done = buf.size() >= end + 4 + strtoul(buf.c_str() + cl + 16, nullptr, 10);
+        } else {
+            done = buf.size() >= 5 && buf.compare(buf.size() - 5, 5, "0\r\n\r\n") == 0;
+        }
+        if (done) {
+            serverClosed = buf.find("Connection: close") < end;
+            return atoi(buf.c_str() + 9);
+        }
+    }
+}
+
+struct ClientResult {
+    std::vector<double> latencyUs;
+    int errors;
+};
+
+static const char REQUEST[] = "GET /api/status HTTP/1.1\r\nHost: watch\r\n\r\n";
+static const char REQUEST_CLOSE[] = "GET /api/status HTTP/1.1\r\nHost: watch\r\nConnection: close\r\n\r\n";
+
+static void runClient(int requests, bool keepAlive, ClientResult& out) {
+    out.errors = 0;
+    int fd = -1;
+    for (int i = 0; i < requests; i++) {
+        double start = nowUs();
+        if (fd < 0) fd = openConnection();
+        const char* req = keepAlive ? REQUEST : REQUEST_CLOSE;
+        bool serverClosed = true;
+        int status = -1;
+        if (fd >= 0 && send(fd, req, strlen(req), MSG_NOSIGNAL) == (ssize_t)strlen(req)) {
+            status = readResponse(fd, serverClosed);
+        }
+        if (status == 200) {
+            out.latencyUs.push_back(nowUs() - start);
+        } else {
+            out.errors++;
+            serverClosed = true;
+            if (status == 503) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (serverClosed && fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    if (fd >= 0) close(fd);
+}
+
+// ============================================
+// MAIN
+// ============================================
+
+static double percentile(std::vector<double> v, double p) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    size_t i = (size_t)(p * (v.size() - 1) + 0.5);
+    return v[i];
+}
+
+int main(int argc, char** argv) {
+    int total = 2000;
+    bool json = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--requests") && i + 1 < argc) total = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--json")) json = true;
+        else {
+            printf("usage: %s [--requests N] [--json]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    nativeHal().quiet = true;
+    DeviceApi api;
+    if (!api.begin(0)) {
+        printf("could not start the server\n");
+        return 1;
+    }
+    port = api.getServer().getPort();
+    api.getStatus().state = "idle";
+    api.getStatus().battery = 80;
+
+    std::atomic<bool> stop(false);
+    std::thread serverTask([&]() {
+        while (!stop.load()) {
+            api.handle(5);
+        }
+    });
+
+    const char* modes[3] = { "close", "keep-alive", "stalled" };
+    const int levels[] = { 1, 2, 5, 10, 20 };
+    if (json) {
+        printf("{");
+    } else {
+        printf("%-11s %7s %10s %9s %9s %7s\n", "mode", "clients", "req/s", "p50 ms", "p99 ms", "errors");
+    }
+    for (int m = 0; m < 3; m++) {
+        if (json) printf("%s\"%s\":[", m ? "," : "", modes[m]);
+        for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); l++) {
+            int clients = levels[l];
+            int stalled = -1;
+            if (m == 2) {
+                stalled = openConnection();
+                send(stalled, "GET /api/status HTTP/1.1\r\nHo", 28, MSG_NOSIGNAL);
+            }
+
+            std::vector<ClientResult> results(clients);
+            std::vector<std::thread> threads;
+            double start = nowUs();
+            for (int c = 0; c < clients; c++) {
+                threads.emplace_back(runClient, total / clients, m != 0, std::ref(results[c]));
+            }
+            for (std::thread& t : threads) {
+                t.join();
+            }
+            double seconds = (nowUs() - start) / 1e6;
+            if (stalled >= 0) close(stalled);
+
+            std::vector<double> latency;
+            int errors = 0;
+            for (ClientResult& r : results) {
+                latency.insert(latency.end(), r.latencyUs.begin(), r.latencyUs.end());
+                errors += r.errors;
+            }
+            double rps = latency.size() / seconds;
+            double p50 = percentile(latency, 0.5) / 1000;
+            double p99 = percentile(latency, 0.99) / 1000;
+            if (json) {
+                printf("%s{\"clients\":%d,\"rps\":%.0f,\"p50_ms\":%.3f,\"p99_ms\":%.3f,\"errors\":%d}",
+                       l ? "," : "", clients, rps, p50, p99, errors);
+            } else {
+                printf("%-11s %7d %10.0f %9.3f %9.3f %7d\n", modes[m], clients, rps, p50, p99, errors);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));   // Let closes drain
+        }
+        if (json) printf("]");
+    }
+    if (json) printf("}\n");
+
+    stop.store(true);
+    serverTask.join();
+    printf("%sserved %u, rejected %u, timed out %u\n", json ? "" : "\n",
+           (unsigned)api.getServer().getRequests(), (unsigned)api.getServer().getRejected(),
+           (unsigned)api.getServer().getTimeouts());
+    return 0;
+}
@@ -0,0 +1,530 @@
+/*
+ * ============================================
+ * API Server Tests (host)
+ * ============================================
+ *
+ * Runs api_server.h and device_api.h on the
+ * native HAL with real loopback sockets. The
+ * server is polled from the test itself, so
+ * every step is deterministic:
+ * - Text, static, streamed and snapshot bodies
+ * - Query decoding and POST bodies
+ * - Keep-alive and pipelined requests
+ * - 404, 405, 400, 413 and 431
+ * - A full pool (503), slow and idle clients
+ *   cut off (virtual clock)
+ * - Streams and snapshots to a client that
+ *   reads slowly; a second snapshot while one
+ *   is being sent (503)
+ * - The device routes: status, metrics, the
+ *   route list, the boot timeline and a
+ *   streamed profile dump
+ *
+ * Built by CMakeLists.txt (ctest).
+ *
+ * ============================================
+ */
+
+#include "device_api.h"
+#include "test_check.h"
+
+#include <arpa/inet.h>
+#include <netinet/tcp.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+// ============================================
+// CLIENT SIDE
+// ============================================
+
+// Blocking connect, then non-blocking like the server's side
+static int connectTo(uint16_t port, int rcvBuf = 0) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (rcvBuf > 0) setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvBuf, sizeof(rcvBuf));
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    int one = 1;                       // Small writes go out at once
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    return fd;
+}
+
+static void sendText(int fd, const std::string& s) {
+    size_t sent = 0;
+    while (sent < s.size()) {
+        ssize_t n = send(fd, s.data() + sent, s.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) break;
+        sent += n;
+    }
+}
+
+struct Reply {
+    int status;
+    std::string head;
+    std::string body;            // De-chunked
+    bool complete;
+};
+
+// One response from the front of buf, removed from it
+static bool takeReply(std::string& buf, Reply& r) {
+    size_t end = buf.find("\r\n\r\n");
+    if (end == std::string::npos) return false;
+    r.head = buf.substr(0, end + 4);
+    r.status = atoi(r.head.c_str() + 9);
+    size_t at = end + 4;
+    size_t cl = r.head.find("Content-Length: ");
+    if (cl != std::string::npos) {
+        size_t len = strtoul(r.head.c_str() + cl + 16, nullptr, 10);
+        if (buf.size() < at + len) return false;
+        r.body = buf.substr(at, len);
+        buf.erase(0, at + len);
+        return true;
+    }
+    std::string body;
+    for (;;) {
+        size_t eol = buf.find("\r\n", at);
+        if (eol == std::string::npos) return false;
+        size_t len = strtoul(buf.c_str() + at, nullptr, 16);
+        if (buf.size() < eol + 2 + len + 2) return false;
+        body.append(buf, eol + 2, len);
+        at = eol + 2 + len + 2;
+        if (len == 0) break;
+    }
+    r.body = body;
+    buf.erase(0, at);
+    return true;
+}
+
+// Wall time: the HAL clock is virtual in these tests
+static uint64_t realMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static const uint64_t WAIT_MS = 10000;
+
+// Polls the server and reads until a whole response is in
+struct Peer {
+    int fd;
+    std::string buf;
+    bool closed;
+
+    explicit Peer(uint16_t port, int rcvBuf = 0) : fd(connectTo(port, rcvBuf)), closed(false) {}
+    ~Peer() {
+        if (fd >= 0) close(fd);
+    }
+
+    // Whatever has arrived, without waiting
+    void readNow() {
+        char tmp[4096];
+        for (;;) {
+            ssize_t n = recv(fd, tmp, sizeof(tmp), 0);
+            if (n > 0) {
+                buf.append(tmp, n);
+            } else {
+                if (n == 0) closed = true;
+                return;
+            }
+        }
+    }
+
+    Reply reply(ApiServer& server) {
+        Reply r = { 0, "", "", false };
+        uint64_t deadline = realMs() + WAIT_MS;
+        while (realMs() < deadline) {
+            server.poll(0);
+            readNow();
+            if (takeReply(buf, r)) {
+                r.complete = true;
+                return r;
+            }
+            if (closed) break;
+        }
+        return r;
+    }
+
+    // Polls until the server closes this connection
+    bool waitClosed(ApiServer& server) {
+        uint64_t deadline = realMs() + WAIT_MS;
+        while (realMs() < deadline && !closed) {
+            server.poll(0);
+            readNow();
+        }
+        return closed;
+    }
+};
+
+// ============================================
+// HANDLERS
+// ============================================
+
+static const char HELLO[] = "hello from flash";
+
+static void handleHello(const ApiRequest&, ApiResponse& res, void*) {
+    res.sendStatic(200, "text/plain", HELLO, sizeof(HELLO) - 1);
+}
+
+static void handleEcho(const ApiRequest& req, ApiResponse& res, void*) {
+    char name[32];
+    char text[96];
+    if (!req.arg("name", name, sizeof(name))) {
+        res.send(400, "text/plain", "no name");
+        return;
+    }
+    snprintf(text, sizeof(text), "hi %s (%ld)", name, req.argInt("n", -1));
+    res.send(200, "text/plain", text);      // Stack buffer: copied
+}
+
+static void handleLong(const ApiRequest&, ApiResponse& res, void*) {
+    static const std::string text(ApiServer::TEXT_MAX + 1, 'x');
+    res.send(200, "text/plain", text.c_str());
+}
+
+static void handlePost(const ApiRequest& req, ApiResponse& res, void*) {
+    static char text[64];
+    snprintf(text, sizeof(text), "%u:%.*s", (unsigned)req.bodyLength, (int)req.bodyLength, req.body);
+    res.send(200, "text/plain", text);
+}
+
+// "line N\n" for N in 0..count-1
+static bool writeLines(ApiChunk& out, uint32_t& cursor, void* ctx) {
+    uint32_t count = *(uint32_t*)ctx;
+    char line[24];
+    while (cursor < count && out.room() >= sizeof(line)) {
+        int n = snprintf(line, sizeof(line), "line %u\n", (unsigned)cursor);
+        out.write((const uint8_t*)line, n);
+        cursor++;
+    }
+    return cursor >= count;
+}
+
+static uint32_t lineCount = 0;
+
+static void handleLines(const ApiRequest&, ApiResponse& res, void*) {
+    res.stream(200, "text/plain", writeLines, &lineCount);
+}
+
+static std::string expectedLines(uint32_t count) {
+    std::string s;
+    char line[24];
+    for (uint32_t i = 0; i < count; i++) {
+        snprintf(line, sizeof(line), "line %u\n", (unsigned)i);
+        s += line;
+    }
+    return s;
+}
+
+static size_t snapshotBytes = 0;
+
+static void writeBlob(Print& out, void*) {
+    for (size_t i = 0; i < snapshotBytes; i++) {
+        out.write((uint8_t)('a' + i % 26));
+    }
+}
+
+static void handleBlob(const ApiRequest&, ApiResponse& res, void*) {
+    res.snapshot(200, "text/plain", writeBlob, nullptr);
+}
+
+static void addRoutes(ApiServer& server) {
+    server.on("GET", "/hello", handleHello);
+    server.on("GET", "/echo", handleEcho);
+    server.on("POST", "/post", handlePost);
+    server.on("GET", "/long", handleLong);
+    server.on("GET", "/lines", handleLines);
+    server.on("GET", "/blob", handleBlob);
+}
+
+// ============================================
+// TESTS
+// ============================================
+
+static void testBodies() {
+    resetHal();
+    ApiServer server;
+    addRoutes(server);
+    CHECK(server.begin(0));
+    CHECK(server.getPort() != 0);
+
+    Peer c(server.getPort());
+    sendText(c.fd, "GET /hello HTTP/1.1\r\nHost: x\r\n\r\n");
+    Reply r = c.reply(server);
+    CHECK(r.complete && r.status == 200);
+    CHECK(r.body == HELLO);
+    CHECK(r.head.find("Content-Length: 16\r\n") != std::string::npos);
+    CHECK(r.head.find("Connection: keep-alive") != std::string::npos);
+
+    sendText(c.fd, "GET /echo?name=Stone%20Age&n=7 HTTP/1.1\r\n\r\n");
+    r = c.reply(server);
+    CHECK(r.status == 200 && r.body == "hi Stone Age (7)");
+    sendText(c.fd, "GET /echo?n=1 HTTP/1.1\r\n\r\n");
+    CHECK(c.reply(server).status == 400);
+
+    // Body sent in two parts
+    sendText(c.fd, "POST /post HTTP/1.1\r\nContent-Length: 11\r\n\r\nhello");
+    server.poll(0);
+    sendText(c.fd, " world");
+    r = c.reply(server);
+    CHECK(r.status == 200 && r.body == "11:hello world");
+
+    lineCount = 5;
+    sendText(c.fd, "GET /lines HTTP/1.1\r\n\r\n");
+    r = c.reply(server);
+    CHECK(r.status == 200 && r.body == expectedLines(5));
+    CHECK(r.head.find("Transfer-Encoding: chunked") != std::string::npos);
+
+    lineCount = 0;                     // Empty stream: only the last chunk
+    sendText(c.fd, "GET /lines HTTP/1.1\r\n\r\n");
+    r = c.reply(server);
+    CHECK(r.complete && r.body.empty());
+
+    CHECK(server.getRequests() == 6);
+    CHECK(server.getActive() == 1);
+}
+
+static void testKeepAlive() {
+    resetHal();
+    ApiServer server;
+    addRoutes(server);
+    CHECK(server.begin(0));
+
+    // Three requests in one write
+    Peer c(server.getPort());
+    sendText(c.fd, "GET /hello HTTP/1.1\r\n\r\n"
+                   "GET /echo?name=a HTTP/1.1\r\n\r\n"
+                   "GET /hello HTTP/1.1\r\nConnection: close\r\n\r\n");
+    Reply a = c.reply(server);
+    Reply b = c.reply(server);
+    Reply d = c.reply(server);
+    CHECK(a.body == HELLO && b.body == "hi a (-1)" && d.body == HELLO);
+    CHECK(d.head.find("Connection: close") != std::string::npos);
+    CHECK(c.waitClosed(server));
+    CHECK(server.getActive() == 0);
+
+    // HTTP/1.0 closes unless asked not to
+    Peer old(server.getPort());
+    sendText(old.fd, "GET /hello HTTP/1.0\r\n\r\n");
+    CHECK(old.reply(server).body == HELLO);
+    CHECK(old.waitClosed(server));
+}
+
+static void testErrors() {
+    resetHal();
+    ApiServer server;
+    addRoutes(server);
+    CHECK(server.begin(0));
+
+    Peer c(server.getPort());
+    sendText(c.fd, "GET /nothing HTTP/1.1\r\n\r\n");
+    CHECK(c.reply(server).status == 404);
+    sendText(c.fd, "DELETE /hello HTTP/1.1\r\n\r\n");
+    CHECK(c.reply(server).status == 405);
+    sendText(c.fd, "GET /long HTTP/1.1\r\n\r\n");
+    CHECK(c.reply(server).status == 500);
+    CHECK(!c.closed);                  // Still usable
+
+    Peer bad(server.getPort());
+    sendText(bad.fd, "NONSENSE\r\n\r\n");
+    CHECK(bad.reply(server).status == 400);
+    CHECK(bad.waitClosed(server));
+
+    Peer big(server.getPort());
+    sendText(big.fd, "POST /post HTTP/1.1\r\nContent-Length: 5000\r\n\r\n");
+    CHECK(big.reply(server).status == 413);
+
+    Peer huge(server.getPort());
+    sendText(huge.fd, "GET /hello HTTP/1.1\r\nX-Filler: " + std::string(2000, 'x'));
+    Reply r = huge.reply(server);
+    CHECK(r.status == 431);
+    CHECK(huge.waitClosed(server));
+}
+
+static void testPoolFull() {
+    resetHal();
+    ApiServer server;
+    addRoutes(server);
+    CHECK(server.begin(0));
+
+    std::vector<Peer*> open;
+    for (int i = 0; i < ApiServer::MAX_CONNECTIONS; i++) {
+        open.push_back(new Peer(server.getPort()));
+        server.poll(0);
+    }
+    CHECK(server.getActive() == ApiServer::MAX_CONNECTIONS);
+
+    Peer extra(server.getPort());
+    Reply r = extra.reply(server);
+    CHECK(r.status == 503);
+    CHECK(r.head.find("Retry-After: 1") != std::string::npos);
+    CHECK(extra.waitClosed(server));
+    CHECK(server.getRejected() == 1);
+
+    // Everyone already in is still served
+    for (Peer* c : open) {
+        sendText(c->fd, "GET /hello HTTP/1.1\r\n\r\n");
+    }
+    int served = 0;
+    for (Peer* c : open) {
+        if (c->reply(server).body == HELLO) served++;
+        delete c;
+    }
+    CHECK(served == ApiServer::MAX_CONNECTIONS);
+}
+
+static void testTimeouts() {
+    resetHal();
+    ApiServer server;
+    addRoutes(server);
+    CHECK(server.begin(0));
+
+    // Half a head, then nothing: cut off after HEAD_TIMEOUT_MS
+    Peer slow(server.getPort());
+    sendText(slow.fd, "GET /hello HTTP/1.1\r\n");
+    server.poll(0);
+    nativeClock().advanceUs((ApiServer::HEAD_TIMEOUT_MS - 100) * 1000ULL);
+    server.poll(0);
+    slow.readNow();
+    CHECK(!slow.closed);
+    nativeClock().advanceUs(200 * 1000ULL);
+    CHECK(slow.waitClosed(server));
+    CHECK(server.getTimeouts() == 1);
+
+    // Idle keep-alive: closed quietly after IDLE_TIMEOUT_MS
+    Peer idle(server.getPort());
+    sendText(idle.fd, "GET /hello HTTP/1.1\r\n\r\n");
+    CHECK(idle.reply(server).status == 200);
+    nativeClock().advanceUs((ApiServer::IDLE_TIMEOUT_MS + 1) * 1000ULL);
+    CHECK(idle.waitClosed(server));
+    CHECK(server.getTimeouts() == 1);
+    CHECK(server.getActive() == 0);
+}
+
+// Bodies bigger than the socket buffers, to a client that reads
+// slowly: the server keeps polling, nothing waits on it
+static void testSlowReader() {
+    resetHal();
+    ApiServer server;
+    addRoutes(server);
+    snapshotBytes = 6 * 1024 * 1024;   // More than loopback buffers hold
+    CHECK(server.begin(0, snapshotBytes));
+
+    lineCount = 200000;               // ~2.2 MB streamed
+    Peer s(server.getPort(), 4096);
+    sendText(s.fd, "GET /lines HTTP/1.1\r\n\r\n");
+    Reply r = s.reply(server);
+    CHECK(r.complete && r.body == expectedLines(lineCount));
+
+    // A snapshot being sent holds the buffer: a second one waits
+    Peer first(server.getPort(), 4096);
+    sendText(first.fd, "GET /blob HTTP/1.1\r\n\r\n");
+    for (int i = 0; i < 10; i++) {
+        server.poll(0);                // Socket fills; first does not read
+    }
+    Peer second(server.getPort());
+    sendText(second.fd, "GET /blob HTTP/1.1\r\n\r\n");
+    Reply busy = second.reply(server);
+    CHECK(busy.status == 503);
+    Peer quick(server.getPort());
+    sendText(quick.fd, "GET /hello HTTP/1.1\r\n\r\n");
+    CHECK(quick.reply(server).body == HELLO);   // Others still served
+
+    r = first.reply(server);
+    CHECK(r.complete && r.body.size() == snapshotBytes);
+    CHECK(r.complete && r.body.compare(0, 3, "abc") == 0 && r.body[26] == 'a');
+    sendText(second.fd, "GET /blob HTTP/1.1\r\n\r\n");
+    r = second.reply(server);
+    CHECK(r.status == 200 && r.body.size() == snapshotBytes);
+
+    // Larger than the buffer
+    snapshotBytes += 1;
+    sendText(second.fd, "GET /blob HTTP/1.1\r\n\r\n");
+    CHECK(second.reply(server).status == 500);
+}
+
+static void testDeviceApi() {
+    resetHal();
+    DeviceApi api;
+    CHECK(api.begin(0));
+    ApiServer& server = api.getServer();
+    uint16_t port = server.getPort();
+
+    Peer c(port);
+    sendText(c.fd, "GET /api/status HTTP/1.1\r\n\r\n");
+    Reply r = c.reply(server);
+    CHECK(r.status == 200);
+    CHECK(r.body.find("\"state\":\"booting\"") != std::string::npos);
+    CHECK(r.body.find("\"battery\":-1") != std::string::npos);
+    CHECK(r.body.find("\"wifi\":{\"connected\":true,\"rssi\":0}") != std::string::npos);
+    CHECK(r.body.front() == '{' && r.body.back() == '}');
+
+    api.getStatus().state = "speaking";
+    api.getStatus().battery = 64;
+    sendText(c.fd, "GET /api/status HTTP/1.1\r\n\r\n");
+    r = c.reply(server);
+    CHECK(r.body.find("\"state\":\"speaking\",\"battery\":64") != std::string::npos);
+    CHECK(r.body.find("\"requests\":1") != std::string::npos);
+
+    sendText(c.fd, "GET /api/metrics HTTP/1.1\r\n\r\n");
+    r = c.reply(server);
+    CHECK(r.status == 200);
+    CHECK(r.head.find("text/plain; version=0.0.4") != std::string::npos);
+    CHECK(r.body.find("volt_api_requests_total 2\n") != std::string::npos);
+    CHECK(r.body.find("volt_api_response_us_bucket{le=\"+Inf\"} 2\n") != std::string::npos);
+
+    sendText(c.fd, "GET / HTTP/1.1\r\n\r\n");
+    CHECK(c.reply(server).body.find("GET  /api/status\n") == 0);
+
+    sendText(c.fd, "POST /api/profile?hz=500 HTTP/1.1\r\n\r\n");
+    CHECK(c.reply(server).status == 409);      // No sampler on the host
+
+    // A capture fed by hand, dumped in pieces
+    CHECK(pcProfiler().reserve(600));
+    for (uint32_t i = 0; i < 600; i++) {
+        uint32_t pcs[3] = { 0x42000000u + i, 0x42001000u, 0x42002000u };
+        pcProfiler().record(i % 2, pcs, 3);
+    }
+    sendText(c.fd, "GET /api/profile HTTP/1.1\r\n\r\n");
+    r = c.reply(server);
+    CHECK(r.status == 200);
+    CHECK(r.body.find("# volt-pcprof 1\n# hz ") == 0);
+    CHECK(r.body.find(" samples 600 skipped 0 dropped 0\n") != std::string::npos);
+    size_t lines = 0;
+    for (char ch : r.body) {
+        if (ch == '\n') lines++;
+    }
+    CHECK(lines == 602);
+    CHECK(r.body.find("\n1 0x42000257 0x42001000 0x42002000\n") != std::string::npos);
+
+    sendText(c.fd, "GET /api/trace?format=chrome HTTP/1.1\r\n\r\n");
+    r = c.reply(server);
+    CHECK(r.status == 200 && r.body.find("{\"displayTimeUnit\":\"ms\"") == 0);
+
+    // This boot's timeline (boot_sequencer.h)
+    bootSequencer().begin(HAL_WAKE_BUTTON);
+    bootSequencer().add("display", nullptr, nullptr, nullptr, 0, BOOT_BEFORE_READY);
+    bootSequencer().step();
+    sendText(c.fd, "GET /api/boot HTTP/1.1\r\n\r\n");
+    r = c.reply(server);
+    CHECK(r.status == 200 && r.head.find("application/json") != std::string::npos);
+    CHECK(r.body.find("{\"wake\":\"button\",") == 0);
+    CHECK(r.body.find("\"phases\":[{\"name\":\"display\",\"state\":\"ok\",") != std::string::npos);
+}
+
+int main() {
+    testBodies();
+    testKeepAlive();
+    testErrors();
+    testPoolFull();
+    testTimeouts();
+    testSlowReader();
+    testDeviceApi();
+
+    return testSummary();
+}
@@ -0,0 +1,725 @@
+/*
+ * ============================================
+ * App State and Task Tests (host)
+ * ============================================
+ *
+ * Runs msg_queue.h, app_state.h and app_tasks.h
+ * on the native HAL. Fake audio and network
+ * hooks take (virtual) time the way recording,
+ * requests and speech do, and runUntilIdle()
+ * schedules the three tasks in a fixed order,
+ * so every turn, exercise and error path plays
+ * out the same way on every run. Breathing
+ * animation frames keep their rate while the
+ * audio task speaks.
+ *
+ * One test runs the tasks on real threads (one
+ * per task, audio on "core 1") to check the UI
+ * sleeps while audio blocks and still answers
+ * a press at once.
+ *
+ * Built and run by CMakeLists.txt (ctest).
+ *
+ * ============================================
+ */
+
+#include "volt_hal.h"
+#include "app_tasks.h"
+#include "test_check.h"
+
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const int BUTTON_PIN = 0;
+
+// ============================================
+// FAKE DEVICE
+// ============================================
+
+// Records what the tasks were asked to do; audio and network
+// commands take as long as the fields say
+struct Fake {
+    std::mutex lock;
+    std::vector<int> ui;             // UI command types, in order
+    std::vector<int> work;           // Audio and net command types, in order
+    std::vector<AppStateId> states;
+    std::vector<std::string> spoken;
+    std::vector<unsigned long> breatheAt;
+    std::vector<unsigned long> frameAt;
+    AppTasks* app;                   // Set: frames on, ui runs while speaking
+    std::string lastText;
+    int led;
+    int uiCore, audioCore, netCore;
+
+    const char* transcript;
+    const char* reply;
+    unsigned long recordMs, requestMs, speakMs;
+    bool connected, realtime, apOk, streamOk;
+
+    Fake()
+        : app(nullptr), led(0), uiCore(-1), audioCore(-1), netCore(-1), transcript("why is the sky blue"),
+          reply("Sunlight bounces off the air!"), recordMs(5000), requestMs(1500), speakMs(3000),
+          connected(true), realtime(false), apOk(true), streamOk(true) {}
+
+    int count(const std::vector<int>& v, int type) {
+        int n = 0;
+        for (int t : v) n += t == type;
+        return n;
+    }
+};
+
+static void fakeUi(const AppCommand& cmd, void* ctx) {
+    Fake& f = *(Fake*)ctx;
+    f.uiCore = halCoreId();
+    f.ui.push_back(cmd.type);
+    if (cmd.type == CMD_LED) f.led = cmd.a;
+    if (cmd.type == CMD_SHOW_BREATHE) f.breatheAt.push_back(halMillis());
+    if (cmd.text) f.lastText = cmd.text;
+    // As the sketch: breathing animates, any other screen stops it
+    if (f.app && cmd.type == CMD_SHOW_BREATHE) f.app->startFrames();
+    else if (f.app && cmd.type != CMD_LED) f.app->stopFrames();
+}
+
+static bool fakeFrame(unsigned long now, void* ctx) {
+    Fake& f = *(Fake*)ctx;
+    f.frameAt.push_back(now);
+    return f.app->getState() == APP_BREATHING;
+}
+
+// Speech that takes ms while the ui task keeps running, the way
+// it does on its own core
+static void speakWithUi(Fake& f, unsigned long ms) {
+    for (unsigned long t = 0; t < ms; t += 10) {
+        halDelay(10);
+        f.app->uiStep(0);
+    }
+}
+
+static void fakeAudio(const AppCommand& cmd, AppEvent& result, void* ctx) {
+    Fake& f = *(Fake*)ctx;
+    {
+        std::lock_guard<std::mutex> held(f.lock);
+        f.audioCore = halCoreId();
+        f.work.push_back(cmd.type);
+        if (cmd.type == CMD_SPEAK) f.spoken.push_back(cmd.text);
+    }
+    switch (cmd.type) {
+        case CMD_RECORD: halDelay(f.recordMs); break;
+        case CMD_SPEAK:
+            if (f.app) speakWithUi(f, f.speakMs);
+            else halDelay(f.speakMs);
+            break;
+        case CMD_STREAM_MIC:
+            halDelay((unsigned long)cmd.a);
+            result.a = f.streamOk;
+            break;
+        case CMD_PLAY_RESPONSE: halDelay(f.speakMs); break;
+    }
+}
+
+static void fakeNet(const AppCommand& cmd, AppEvent& result, void* ctx) {
+    Fake& f = *(Fake*)ctx;
+    {
+        std::lock_guard<std::mutex> held(f.lock);
+        f.netCore = halCoreId();
+        f.work.push_back(cmd.type);
+    }
+    switch (cmd.type) {
+        case CMD_TRANSCRIBE:
+            halDelay(f.requestMs);
+            result.text = f.transcript;
+            break;
+        case CMD_CHAT:
+            halDelay(f.requestMs);
+            result.text = f.reply;
+            break;
+        case CMD_START_AP: result.a = f.apOk; break;
+        case CMD_CHECK_NET:
+            result.a = f.connected;
+            result.b = f.realtime;
+            break;
+    }
+}
+
+static void fakeState(AppStateId state, void* ctx) {
+    ((Fake*)ctx)->states.push_back(state);
+}
+
+static const AppConfig CONFIG = {
+    FEATURE_VOICE | FEATURE_JOKES | FEATURE_BREATHING | FEATURE_LOVE | FEATURE_WIFI_SETUP,
+    5000, "Love you, buddy"
+};
+
+static void start(AppTasks& app, Fake& f, bool online = true, const AppConfig& config = CONFIG) {
+    AppTasks::Hooks hooks = { fakeUi, fakeAudio, fakeNet, fakeState, nullptr, &f };
+    CHECK(app.begin(config, hooks, BUTTON_PIN, online));
+}
+
+// Runs the scheduler every 10 ms of clock for ms
+static void runFor(AppTasks& app, unsigned long ms) {
+    unsigned long end = halMillis() + ms;
+    while ((long)(halMillis() - end) < 0) {
+        app.runUntilIdle();
+        halDelay(10);
+    }
+}
+
+static void post(AppTasks& app, uint8_t type, int32_t a = 0, int32_t b = 0) {
+    CHECK(app.post({ type, a, b, nullptr }));
+}
+
+// ============================================
+// QUEUES
+// ============================================
+
+static void testQueueBounds() {
+    resetHal();
+    MsgQueue<AppEvent, 4> q;
+    AppEvent e = { EV_PRESSES, 0, 0, nullptr };
+    CHECK(!q.send(e));                       // Not begun
+    CHECK(q.begin());
+    for (int i = 0; i < 4; i++) {
+        e.a = i;
+        CHECK(q.send(e));
+    }
+    e.a = 4;
+    CHECK(!q.send(e));                       // Full, dropped
+    CHECK(q.count() == 4);
+    uint32_t capacity = 0;
+    typedef MsgQueue<AppEvent, 4> Queue4;
+    CHECK(Queue4::depthOf(&q, &capacity) == 4);
+    CHECK(capacity == 4);
+
+    for (int i = 0; i < 4; i++) {
+        CHECK(q.receive(e));
+        CHECK(e.a == i);                     // In order
+    }
+    CHECK(!q.receive(e));
+
+    // Virtual time: a wait on an empty queue passes its timeout at once
+    unsigned long before = halMillis();
+    CHECK(!q.receive(e, 250));
+    CHECK(halMillis() - before == 250);
+    CHECK(!q.receive(e, HAL_WAIT_FOREVER));  // Nobody else could send
+}
+
+static void testQueueThreads() {
+    resetHal();
+    nativeClock().setVirtual(false);
+    MsgQueue<AppEvent, 4> q;
+    CHECK(q.begin());
+    const int N = 5000;
+    std::thread producer([&]() {
+        nativeCoreId() = 1;
+        for (int i = 0; i < N; i++) {
+            q.send({ EV_TICK, i, 0, nullptr }, HAL_WAIT_FOREVER);
+        }
+    });
+    bool ordered = true;
+    AppEvent e;
+    for (int i = 0; i < N; i++) {
+        if (!q.receive(e, 2000) || e.a != i) ordered = false;
+    }
+    producer.join();
+    CHECK(ordered);
+    CHECK(q.count() == 0);
+}
+
+// ============================================
+// VOICE TURN
+// ============================================
+
+static void testVoiceTurn() {
+    resetHal();
+    Fake f;
+    AppTasks app;
+    start(app, f);
+
+    post(app, EV_PRESSES, 1);
+    unsigned long t0 = halMillis();
+    app.runUntilIdle();
+
+    // idle -> listening -> thinking -> speaking -> idle
+    CHECK(f.states.size() == 4);
+    CHECK(f.states.size() == 4 && f.states[0] == APP_LISTENING && f.states[1] == APP_THINKING &&
+          f.states[2] == APP_SPEAKING && f.states[3] == APP_IDLE);
+    std::vector<int> expected = { CMD_RECORD, CMD_TRANSCRIBE, CMD_CHAT, CMD_SPEAK, CMD_END_TURN };
+    CHECK(f.work == expected);
+    CHECK(f.spoken.size() == 1 && f.spoken[0] == f.reply);
+    CHECK(f.count(f.ui, CMD_SHOW_REPLY) == 1 && f.lastText == f.reply);   // Shown while it's said
+    CHECK(f.led == 0);
+    CHECK(f.count(f.ui, CMD_LED) == 2);
+    CHECK(f.ui.back() == CMD_SHOW_IDLE);
+    CHECK(app.getState() == APP_IDLE);
+    CHECK(halMillis() - t0 == 5000 + 1500 + 1500 + 3000);
+    CHECK(f.uiCore == 0);
+    CHECK(app.getIgnored() == 0);
+    CHECK(app.getQueueFull() == 0);
+}
+
+static void testTurnErrors() {
+    resetHal();
+    Fake f;
+    AppTasks app;
+    start(app, f);
+
+    // Nothing heard: a notice for 2 s, then idle, turn ended
+    f.transcript = "";
+    post(app, EV_PRESSES, 1);
+    app.runUntilIdle();
+    CHECK(app.getState() == APP_NOTICE);
+    CHECK(f.lastText == "Didn't hear you");
+    CHECK(f.count(f.work, CMD_CHAT) == 0);
+    runFor(app, 1900);
+    CHECK(app.getState() == APP_NOTICE);
+    runFor(app, 200);
+    CHECK(app.getState() == APP_IDLE);
+    CHECK(f.count(f.work, CMD_END_TURN) == 1);
+
+    // Chat failed
+    f.transcript = "hello";
+    f.reply = "";
+    post(app, EV_PRESSES, 1);
+    app.runUntilIdle();
+    CHECK(app.getState() == APP_NOTICE);
+    CHECK(f.lastText == "AI Error");
+    CHECK(f.count(f.work, CMD_SPEAK) == 0);
+    runFor(app, 2100);
+    CHECK(app.getState() == APP_IDLE);
+    CHECK(f.count(f.work, CMD_END_TURN) == 2);
+}
+
+static void testBusyIgnoresPresses() {
+    resetHal();
+    Fake f;
+    AppTasks app;
+    start(app, f);
+
+    post(app, EV_PRESSES, 1);
+    app.uiStep(0);                           // Listening, RECORD queued
+    CHECK(app.getState() == APP_LISTENING);
+    post(app, EV_PRESSES, 2);                // A joke mid-turn
+    post(app, EV_LONG_PRESS);
+    post(app, EV_LOW_BATTERY, 15);           // Shown once the turn is over
+    app.runUntilIdle();
+    CHECK(app.getIgnored() == 2);
+    CHECK(f.count(f.work, CMD_CHAT) == 1);   // The turn's only
+    CHECK(app.getState() == APP_NOTICE);
+    CHECK(f.lastText == "Low Battery!");
+    runFor(app, 2100);
+    CHECK(app.getState() == APP_IDLE);
+
+    // A late answer for a state that's gone is ignored too
+    post(app, EV_REPLY);
+    app.runUntilIdle();
+    CHECK(app.getIgnored() == 3);
+    CHECK(app.getState() == APP_IDLE);
+}
+
+static void testOfflineAndNetCheck() {
+    resetHal();
+    Fake f;
+    AppTasks app;
+    start(app, f, false);
+
+    post(app, EV_PRESSES, 1);
+    app.runUntilIdle();
+    CHECK(app.getState() == APP_NOTICE);
+    CHECK(f.count(f.ui, CMD_SHOW_NEED_WIFI) == 1);
+    CHECK(f.work.empty());
+    runFor(app, AppStateMachine::NEED_WIFI_MS + 100);
+    CHECK(app.getState() == APP_IDLE);
+
+    // The 30 s check finds WiFi back: idle screen redrawn
+    int idleDraws = f.count(f.ui, CMD_SHOW_IDLE);
+    runFor(app, AppTasks::NET_CHECK_MS);
+    CHECK(f.count(f.work, CMD_CHECK_NET) == 1);
+    CHECK(app.getMachine().isOnline());
+    CHECK(f.count(f.ui, CMD_SHOW_IDLE) == idleDraws + 1);
+
+    post(app, EV_PRESSES, 1);
+    app.runUntilIdle();
+    CHECK(f.count(f.work, CMD_RECORD) == 1);
+    CHECK(app.getState() == APP_IDLE);
+}
+
+static void testRequestedNetCheck() {
+    resetHal();
+    Fake f;
+    AppTasks app;
+    app.setNetCheckMs(0);
+    start(app, f, false);
+
+    // Left to loop()'s timers: ui never queues it, nor wakes for it
+    CHECK(app.idleMs() == AppTasks::IDLE_MAX_MS);
+    runFor(app, AppTasks::NET_CHECK_MS * 3);
+    CHECK(f.count(f.work, CMD_CHECK_NET) == 0);
+
+    CHECK(app.requestNetCheck());
+    CHECK(!app.requestNetCheck());           // One already queued
+    app.runUntilIdle();
+    CHECK(f.count(f.work, CMD_CHECK_NET) == 1);
+    CHECK(app.getMachine().isOnline());
+    CHECK(app.getQueueFull() == 0);
+}
+
+static void testRealtimeTurn() {
+    resetHal();
+    Fake f;
+    AppTasks app;
+    start(app, f);
+    f.realtime = true;
+    post(app, EV_NET_STATUS, 1, 1);
+
+    post(app, EV_PRESSES, 1);
+    app.runUntilIdle();
+    std::vector<int> expected = { CMD_STREAM_MIC, CMD_PLAY_RESPONSE };
+    CHECK(f.work == expected);               // No arena turn to end
+    CHECK(f.count(f.ui, CMD_SHOW_REPLY) == 1);    // The transcript, as it streams
+    CHECK(app.getState() == APP_IDLE);
+    CHECK(f.states.size() == 3 && f.states[1] == APP_SPEAKING);
+
+    f.work.clear();
+    f.streamOk = false;
+    post(app, EV_PRESSES, 1);
+    app.runUntilIdle();
+    CHECK(f.count(f.work, CMD_PLAY_RESPONSE) == 0);
+    CHECK(f.lastText == "AI Error");
+    CHECK(f.led == 0);
+}
+
+// ============================================
+// TIMED ACTIVITIES
+// ============================================
+
+static void testBreathingOffline() {
+    resetHal();
+    Fake f;
+    f.connected = false;
+    AppTasks app;
+    start(app, f, false);
+
+    unsigned long t0 = halMillis();
+    post(app, EV_PRESSES, 3);
+    runFor(app, 60000);
+    CHECK(app.getState() == APP_IDLE);
+    CHECK(f.spoken.empty());
+    CHECK(f.breatheAt.size() == 9);
+    // Intro 1.5 s, then in 4 s, hold 4 s, out 6 s, three times
+    static const unsigned long offsets[] = { 1500, 5500, 9500, 15500, 19500, 23500,
+                                             29500, 33500, 37500 };
+    bool onTime = f.breatheAt.size() == 9;
+    for (size_t i = 0; i < f.breatheAt.size() && onTime; i++) {
+        long late = (long)(f.breatheAt[i] - t0 - offsets[i]);
+        onTime = late >= 0 && late <= 10;
+    }
+    CHECK(onTime);
+    CHECK(f.count(f.ui, CMD_SHOW_GREAT_JOB) == 1);
+    CHECK(f.count(f.ui, CMD_SHOW_IDLE) == 1);
+    CHECK(f.states.size() == 2 && f.states[0] == APP_BREATHING && f.states[1] == APP_IDLE);
+}
+
+static void testBreathingOnline() {
+    resetHal();
+    Fake f;
+    f.speakMs = 2000;
+    AppTasks app;
+    start(app, f);
+
+    unsigned long t0 = halMillis();
+    post(app, EV_PRESSES, 3);
+    runFor(app, 80000);
+    CHECK(app.getState() == APP_IDLE);
+    CHECK(f.spoken.size() == 11);            // Intro, 9 phases, "Great job"
+    CHECK(f.breatheAt.size() == 9);
+    // Each hold starts when its line has been said
+    CHECK(f.breatheAt.size() == 9 && f.breatheAt[0] - t0 >= 2000 + 1500);
+    CHECK(f.breatheAt.size() == 9 && f.breatheAt[1] - f.breatheAt[0] >= 2000 + 4000);
+    CHECK(f.breatheAt.size() == 9 && f.breatheAt[1] - f.breatheAt[0] <= 2000 + 4000 + 10);
+    CHECK(f.count(f.work, CMD_END_TURN) == 0);
+}
+
+static void testBreathingFrames() {
+    resetHal();
+    Fake f;
+    f.speakMs = 2000;
+    AppTasks app;
+    f.app = &app;
+    app.setFrameHook(fakeFrame);
+    start(app, f);
+    CHECK(!app.getFramePacer().isRunning());
+
+    post(app, EV_PRESSES, 3);
+    runFor(app, 80000);
+    CHECK(app.getState() == APP_IDLE);
+    CHECK(f.breatheAt.size() == 9);
+    CHECK(!app.getFramePacer().isRunning());
+    CHECK(f.frameAt.size() > 0 && f.frameAt[0] == f.breatheAt[0]);
+
+    // 30 a second while "Breathe in" is being said, and after
+    int speaking = 0, gapsOk = 1;
+    unsigned long from = f.breatheAt.empty() ? 0 : f.breatheAt[0];
+    for (size_t i = 0; i < f.frameAt.size(); i++) {
+        if (f.frameAt[i] - from < f.speakMs) speaking++;
+        if (i > 0 && f.frameAt[i] - f.breatheAt[0] < 10000) {
+            gapsOk &= f.frameAt[i] - f.frameAt[i - 1] <= AppTasks::FRAME_MS + 10;
+        }
+    }
+    CHECK(speaking >= 55 && speaking <= 62);
+    CHECK(gapsOk);
+    CHECK(app.getFramePacer().getSkipped() == 0);
+    // Only breathing animates: none after the last phase
+    CHECK(f.frameAt.back() < f.breatheAt.back() + f.speakMs + AppStateMachine::breathMs(2) + 40);
+
+    MetricsRegistry registry;
+    app.registerMetrics(registry);
+    CHECK(registry.find("volt_ui_frame_us") != nullptr);
+    CHECK(registry.find("volt_ui_frames_skipped_total") != nullptr);
+
+    // Idle again: ui sleeps as long as before
+    CHECK(app.idleMs() > AppTasks::FRAME_MS);
+}
+
+static void testJokes() {
+    resetHal();
+    Fake f;
+    f.reply = "Why did the robot cross the road?";
+    AppTasks app;
+    start(app, f);
+
+    post(app, EV_PRESSES, 2);
+    app.runUntilIdle();
+    CHECK(f.count(f.work, CMD_CHAT) == 1);
+    CHECK(f.count(f.ui, CMD_SHOW_JOKE) == 1);
+    CHECK(f.spoken.size() == 1 && f.spoken[0] == f.reply);
+    CHECK(app.getState() == APP_JOKE);
+    runFor(app, AppStateMachine::JOKE_HOLD_MS + 100);
+    CHECK(app.getState() == APP_IDLE);
+    CHECK(f.count(f.work, CMD_END_TURN) == 1);
+
+    // Chat failed: an offline joke instead
+    f.reply = "";
+    post(app, EV_PRESSES, 2);
+    app.runUntilIdle();
+    CHECK(f.count(f.ui, CMD_SHOW_JOKE) == 2);
+    CHECK(f.spoken.size() == 2 && !f.spoken[1].empty());
+
+    // Offline: no request, a joke after a second
+    resetHal();
+    Fake g;
+    AppTasks offline;
+    start(offline, g, false);
+    post(offline, EV_PRESSES, 2);
+    offline.runUntilIdle();
+    CHECK(g.count(g.ui, CMD_SHOW_JOKE) == 0);
+    runFor(offline, AppStateMachine::JOKE_INTRO_MS + 20);
+    CHECK(g.count(g.ui, CMD_SHOW_JOKE) == 1);
+    CHECK(g.work.empty());
+    runFor(offline, AppStateMachine::JOKE_HOLD_MS + 20);
+    CHECK(offline.getState() == APP_IDLE);
+}
+
+static void testLoveMessageAndFeatures() {
+    resetHal();
+    Fake f;
+    AppTasks app;
+    start(app, f);
+
+    post(app, EV_LONG_PRESS);
+    app.runUntilIdle();
+    CHECK(f.count(f.ui, CMD_SHOW_LOVE) == 1);
+    CHECK(f.spoken.size() == 1 && f.spoken[0] == "Love you, buddy");
+    runFor(app, AppStateMachine::LOVE_HOLD_MS + 100);
+    CHECK(app.getState() == APP_IDLE);
+
+    post(app, EV_PRESSES, 4);
+    app.runUntilIdle();
+    CHECK(f.lastText == "Unknown pattern");
+    runFor(app, AppStateMachine::UNKNOWN_MS + 100);
+    CHECK(app.getState() == APP_IDLE);
+
+    // Turned off in the config: nothing starts
+    resetHal();
+    Fake g;
+    AppTasks limited;
+    AppConfig config = CONFIG;
+    config.features = FEATURE_BREATHING;
+    start(limited, g, true, config);
+    post(limited, EV_PRESSES, 1);
+    post(limited, EV_LONG_PRESS);
+    limited.runUntilIdle();
+    CHECK(g.work.empty());
+    CHECK(g.states.empty());
+}
+
+static void testWifiSetup() {
+    resetHal();
+    Fake f;
+    AppTasks app;
+    start(app, f);
+
+    post(app, EV_PRESSES, 5);
+    app.runUntilIdle();
+    CHECK(app.getState() == APP_SETUP);
+    CHECK(f.count(f.ui, CMD_SHOW_SETUP) == 1);
+    CHECK(f.count(f.work, CMD_START_AP) == 1);
+    runFor(app, 60000);
+    CHECK(app.getState() == APP_SETUP);      // Stays up
+
+    post(app, EV_PRESSES, 1);                // Any press leaves
+    app.runUntilIdle();
+    CHECK(f.lastText == "Restarting...");
+    CHECK(f.count(f.work, CMD_RESTART) == 0);
+    runFor(app, AppStateMachine::RESTART_MS + 100);
+    CHECK(f.count(f.work, CMD_RESTART) == 1);
+
+    // No access point: a notice, then back to idle
+    resetHal();
+    Fake g;
+    g.apOk = false;
+    AppTasks failed;
+    start(failed, g);
+    post(failed, EV_PRESSES, 5);
+    failed.runUntilIdle();
+    CHECK(g.lastText == "AP Failed");
+    runFor(failed, AppStateMachine::NOTICE_MS + 100);
+    CHECK(failed.getState() == APP_IDLE);
+    CHECK(g.count(g.work, CMD_RESTART) == 0);
+}
+
+// ============================================
+// BUTTON, QUEUES AND METRICS
+// ============================================
+
+static void pressButton(AppTasks& app, int times) {
+    for (int i = 0; i < times; i++) {
+        halDigitalWrite(BUTTON_PIN, LOW);
+        runFor(app, 100);
+        halDigitalWrite(BUTTON_PIN, HIGH);
+        runFor(app, 300);
+    }
+}
+
+static void testButtonPin() {
+    resetHal();
+    Fake f;
+    f.connected = false;
+    AppTasks app;
+    start(app, f, false);
+    GestureTiming timing = ButtonGestures::defaultTiming();
+
+    pressButton(app, 3);
+    runFor(app, timing.multiPressMs + 100);
+    CHECK(app.getState() == APP_BREATHING);
+
+    // A long press mid-exercise is ignored
+    halDigitalWrite(BUTTON_PIN, LOW);
+    runFor(app, timing.longPressMs + 100);
+    halDigitalWrite(BUTTON_PIN, HIGH);
+    runFor(app, 100);
+    CHECK(app.getState() == APP_BREATHING);
+    CHECK(app.getIgnored() == 1);
+}
+
+static void testQueueFullAndMetrics() {
+    resetHal();
+    Fake f;
+    AppTasks app;
+    start(app, f);
+
+    int accepted = 0;
+    for (int i = 0; i < AppTasks::EVENT_DEPTH + 3; i++) {
+        accepted += app.post({ EV_TICK, 0, 0, nullptr });
+    }
+    CHECK(accepted == AppTasks::EVENT_DEPTH);
+    CHECK(app.getQueueFull() == 3);
+    app.runUntilIdle();
+    CHECK(app.getUiPassTimes().getCount() > 0);
+
+    MetricsRegistry registry;
+    app.registerMetrics(registry);
+    CHECK(registry.getCount() == 6);
+    CHECK(registry.find("volt_app_queue_full_total", "queue=\"events\"") != nullptr);
+    CHECK(registry.find("volt_app_queue_full_total", "queue=\"net\"") != nullptr);
+    CHECK(registry.find("volt_app_ui_pass_us") != nullptr);
+
+    TaskStats stats;
+    app.watchQueues(stats);
+    CHECK(stats.getQueueCount() == 3);
+}
+
+// ============================================
+// REAL THREADS
+// ============================================
+
+static void testThreadsKeepUiResponsive() {
+    resetHal();
+    nativeClock().setVirtual(false);
+    Fake f;
+    f.recordMs = 300;
+    f.requestMs = 50;
+    f.speakMs = 100;
+    AppTasks app;
+    start(app, f);
+
+    std::atomic<bool> stop(false);
+    std::thread audio([&]() {
+        nativeCoreId() = 1;
+        while (!stop.load()) app.audioStep(20);
+    });
+    std::thread net([&]() {
+        while (!stop.load()) app.netStep(20);
+    });
+    std::thread ui([&]() {
+        while (!stop.load()) app.uiStep(app.idleMs());
+    });
+
+    post(app, EV_PRESSES, 1);
+    for (int i = 0; i < 100 && app.getState() != APP_LISTENING; i++) halDelay(2);
+    CHECK(app.getState() == APP_LISTENING);
+    uint32_t wakeups = app.getUiWakeups();
+    halDelay(200);                           // Audio is recording, ui sleeps
+    CHECK(app.getUiWakeups() - wakeups <= 1);
+    post(app, EV_PRESSES, 2);                // Answered (ignored) at once
+    for (int i = 0; i < 50 && app.getIgnored() == 0; i++) halDelay(2);
+    CHECK(app.getIgnored() == 1);
+    CHECK(app.getState() == APP_LISTENING);
+
+    for (int i = 0; i < 300 && app.getState() != APP_IDLE; i++) halDelay(10);
+    halDelay(100);                           // END_TURN on its way to net
+    stop.store(true);
+    post(app, EV_TICK);                      // Wakes ui to see it
+    audio.join();
+    net.join();
+    ui.join();
+
+    CHECK(app.getState() == APP_IDLE);
+    CHECK(f.audioCore == 1);
+    CHECK(f.netCore == 0);
+    std::vector<int> expected = { CMD_RECORD, CMD_TRANSCRIBE, CMD_CHAT, CMD_SPEAK, CMD_END_TURN };
+    CHECK(f.work == expected);
+}
+
+int main() {
+    testQueueBounds();
+    testQueueThreads();
+    testVoiceTurn();
+    testTurnErrors();
+    testBusyIgnoresPresses();
+    testOfflineAndNetCheck();
+    testRequestedNetCheck();
+    testRealtimeTurn();
+    testBreathingOffline();
+    testBreathingOnline();
+    testBreathingFrames();
+    testJokes();
+    testLoveMessageAndFeatures();
+    testWifiSetup();
+    testButtonPin();
+    testQueueFullAndMetrics();
+    testThreadsKeepUiResponsive();
+
+    return testSummary();
+}
@@ -0,0 +1,189 @@
+/*
+ * ============================================
+ * Board Traits Tests (host)
+ * ============================================
+ *
+ * Built once per board in board_traits.h
+ * (board_traits_test for the HU-087,
+ * board_traits_ssd1306_test with
+ * VOLT_BOARD_SSD1306), each against the native
+ * HAL:
+ * - The selected board's traits, and the pin
+ *   names (pins_hu087.h) that follow them
+ * - The checks: clashing pins and a shared I2S
+ *   port with two clocks are caught
+ * - Board parts through the HAL: amplifier,
+ *   LED and battery where the board has them,
+ *   nothing touched where it doesn't
+ * - The power manager and the memory pools on
+ *   the board: battery percent measured or
+ *   estimated, PSRAM only where there is some
+ *
+ * Built and run by CMakeLists.txt (ctest).
+ *
+ * ============================================
+ */
+
+#include "volt_hal.h"
+#include "board_traits.h"
+#include "pins_hu087.h"
+#include "power_mgmt.h"
+#include "mem_pools.h"
+#include "test_check.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <type_traits>
+
+// ============================================
+// TRAITS
+// ============================================
+
+static void testSelected() {
+#ifdef VOLT_BOARD_SSD1306
+    CHECK((std::is_same<Board, BoardSsd1306>::value));
+    CHECK(Board::I2S == BOARD_I2S_SHARED);
+    CHECK(Board::Display::KIND == BOARD_DISPLAY_SSD1306);
+    CHECK(!Board::PSRAM && Board::Battery::PIN == 35);
+#else
+    CHECK((std::is_same<Board, BoardHu087>::value));
+    CHECK(Board::I2S == BOARD_I2S_SEPARATE);
+    CHECK(Board::Display::KIND == BOARD_DISPLAY_ST7789);
+    CHECK(Board::Display::WIDTH == 172 && Board::Display::HEIGHT == 320 && Board::Display::SCROLLS);
+    // The verified HU-087 pins
+    CHECK(MIC_WS == 4 && MIC_SCK == 5 && MIC_SD == 6 && MIC_I2S_NUM == 0);
+    CHECK(SPK_DOUT == 7 && SPK_BCLK == 15 && SPK_LRCK == 16 && SPK_SD_MODE == 17 && SPK_I2S_NUM == 1);
+    CHECK(LCD_SCLK == 21 && LCD_MOSI == 47 && LCD_CS == 41 && LCD_DC == 40 && LCD_RST == 45 && LCD_BL == 42);
+    CHECK(BTN_BOOT == 0 && LED_BUILTIN == 48);
+    CHECK(Board::PSRAM && Board::Battery::PIN == -1);
+#endif
+    printf("  board: %s\n", Board::name());
+
+    // The old names are the selected board's
+    CHECK(MIC_SD == Board::Mic::SD && SPK_DOUT == Board::Speaker::DOUT && BTN_BOOT == Board::BUTTON);
+}
+
+// A board with the LED on the microphone's clock
+struct LedOnClock : BoardHu087 {
+    static constexpr int LED = BoardHu087::Mic::SCK;
+};
+
+// A board whose LED lights with the pin low
+struct LedActiveLow : BoardHu087 {
+    static constexpr bool LED_ACTIVE_LOW = true;
+};
+
+// A shared port whose speaker has a clock of its own
+struct SharedTwoClocks : BoardSsd1306 {
+    struct Speaker : BoardSsd1306::Speaker {
+        static constexpr int BCLK = 4;
+    };
+};
+
+static void testChecks() {
+    static_assert(boardPinsDistinct(1, 2, 3), "");
+    static_assert(!boardPinsDistinct(1, 2, 1), "");
+    static_assert(boardPinsDistinct(-1, 2, -1, -1), "Unused pins don't clash");
+    static_assert(!boardPinsValid(4, 49) && boardPinsValid(-1, 0, 48), "");
+    static_assert(boardPinsOk<BoardHu087>() && boardPinsOk<BoardSsd1306>(), "");
+    static_assert(boardLedHigh<BoardHu087>(true) && !boardLedHigh<BoardHu087>(false), "");
+    static_assert(!boardLedHigh<LedActiveLow>(true) && boardLedHigh<LedActiveLow>(false), "");
+
+    CHECK(!boardPinsOk<LedOnClock>());
+    // Shared: the speaker's pins are checked as the mic's, so a
+    // second clock is only caught by BoardCheck's topology rule
+    CHECK(boardPinsOk<SharedTwoClocks>());
+    CHECK(SharedTwoClocks::Speaker::BCLK != SharedTwoClocks::Mic::SCK);
+    CHECK(BoardCheck<Board>::OK);
+}
+
+// ============================================
+// HAL
+// ============================================
+
+static bool samePins(const int* before) {
+    return memcmp(before, nativeHal().pinLevels, sizeof(nativeHal().pinLevels)) == 0;
+}
+
+static void testAmpAndLed() {
+    resetHal();
+    int before[NativeHal::PIN_COUNT];
+    memcpy(before, nativeHal().pinLevels, sizeof(before));
+
+    halSpeakerAmp(true);
+    if (Board::Speaker::SD_MODE >= 0) {
+        CHECK(halDigitalRead(Board::Speaker::SD_MODE) == HIGH);
+        CHECK(nativeHal().pinModes[Board::Speaker::SD_MODE] == OUTPUT);
+        halSpeakerAmp(false);
+        CHECK(halDigitalRead(Board::Speaker::SD_MODE) == LOW);
+    } else {
+        CHECK(samePins(before));
+    }
+
+    memcpy(before, nativeHal().pinLevels, sizeof(before));
+    halLed(true);
+    if (Board::LED >= 0) {
+        CHECK(nativeHal().pinModes[Board::LED] == OUTPUT);   // No setup needed
+        CHECK(halDigitalRead(Board::LED) == (boardLedHigh<Board>(true) ? HIGH : LOW));
+        halLed(false);
+        CHECK(halDigitalRead(Board::LED) == (boardLedHigh<Board>(false) ? HIGH : LOW));
+    } else {
+        CHECK(samePins(before));
+    }
+}
+
+static void testBattery() {
+    // Full scale of a 1:2 divider is 6.6 V
+    static_assert(boardBatteryMillivolts<BoardSsd1306>(4095) == 6600, "");
+    static_assert(boardBatteryMillivolts<BoardSsd1306>(0) == 0, "");
+    CHECK(boardBatteryMillivolts<BoardSsd1306>(2606) == 4200);
+
+    resetHal();
+    PowerManager power;
+    power.begin();
+    if (Board::Battery::PIN < 0) {
+        CHECK(halBatteryMillivolts() == -1);
+        halDelay(95UL * 60 * 1000);
+        CHECK(power.getBatteryPercent() == 91);      // Estimated from uptime
+        return;
+    }
+    int* adc = &nativeHal().analogLevels[Board::Battery::PIN];
+    *adc = 2606;
+    CHECK(halBatteryMillivolts() == 4200);
+    CHECK(power.getBatteryPercent() == 100);
+    *adc = 2300;                                      // 3.7 V
+    CHECK(power.getBatteryPercent() == 40);
+    *adc = 1900;                                      // 3.06 V
+    CHECK(power.getBatteryPercent() == 10);
+    halDelay(95UL * 60 * 1000);
+    CHECK(power.getBatteryPercent() == 10);           // Measured, not the uptime
+}
+
+static void testDeepSleep() {
+    resetHal();
+    PowerManager power;
+    power.begin();
+    CHECK(nativeHal().wakePin == Board::BUTTON);
+    halSpeakerAmp(true);
+    halLed(true);
+    power.enterDeepSleep();
+    CHECK(nativeHal().deepSleeps == 1);
+    CHECK(Board::Speaker::SD_MODE < 0 || halDigitalRead(Board::Speaker::SD_MODE) == LOW);
+    CHECK(Board::LED < 0 || halDigitalRead(Board::LED) == (boardLedHigh<Board>(false) ? HIGH : LOW));
+}
+
+static void testPools() {
+    size_t psram = memPools().getRegionBudget(MEM_REGION_SPIRAM);
+    CHECK(Board::PSRAM ? psram == (size_t)-1 : psram == 0);
+}
+
+int main() {
+    testSelected();
+    testChecks();
+    testAmpAndLed();
+    testBattery();
+    testDeepSleep();
+    testPools();
+
+    return testSummary();
+}
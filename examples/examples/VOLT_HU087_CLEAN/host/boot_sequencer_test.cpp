@@ -0,0 +1,337 @@
+/*
+ * ============================================
+ * Boot Sequencer Tests (host)
+ * ============================================
+ *
+ * Plays the sketch's boot (volt_stone_FINAL.ino
+ * setup(): the same phases, after-lists and
+ * flags) on the native HAL's virtual clock,
+ * each phase taking what it takes on the watch:
+ * - Cold boot: splash and greeting, WiFi
+ *   associating while the display and the AI
+ *   come up, against the old setup()'s fixed
+ *   delays one after the other
+ * - Button wake: no splash, no greeting, the
+ *   button working before WiFi is up; WiFi
+ *   finishes from loop() afterwards
+ * - WiFi that never comes: timed out, the boot
+ *   still gets ready, phases that needed it
+ *   skipped
+ * - The timeline: JSON for GET /api/boot, the
+ *   serial report, the gauges, the same on
+ *   every run
+ *
+ * Prints both timelines. Built and run by
+ * CMakeLists.txt (ctest).
+ *
+ * ============================================
+ */
+
+#include "volt_hal.h"
+#include "boot_sequencer.h"
+#include "metrics.h"
+#include "test_check.h"
+
+#include <string>
+
+// Collects a report
+class Capture : public Print {
+public:
+    std::string text;
+
+    size_t write(uint8_t b) override {
+        text += (char)b;
+        return 1;
+    }
+
+    size_t write(const uint8_t* buf, size_t size) override {
+        text.append((const char*)buf, size);
+        return size;
+    }
+
+    bool has(const char* s) const { return text.find(s) != std::string::npos; }
+};
+
+// ============================================
+// THE SKETCH'S BOOT, SIMULATED
+// ============================================
+
+// What each phase costs on the watch (ms)
+static const uint32_t ROM_MS = 85;         // Chip start to setup()
+static const uint32_t DISPLAY_MS = 120;    // ST7789 reset and init
+static const uint32_t SPLASH_MS = 35;      // One full frame
+static const uint32_t API_MS = 2;
+static const uint32_t AI_MS = 60;          // Pools and buffers
+static const uint32_t REALTIME_MS = 5;
+static const uint32_t ENGINE_MS = 15;      // Sprites, metrics
+static const uint32_t GREETING_MS = 1800;  // TTS of the greeting
+static const uint32_t WIFI_TIMEOUT_MS = 20000;
+
+// The old setup(): the same work one step after another, with its
+// delay(1000, 1000, 1500, 1500, 2000) in between
+static uint32_t legacyReadyMs(uint32_t associateMs) {
+    return ROM_MS + 1000 + DISPLAY_MS + SPLASH_MS + 1000 + associateMs + API_MS + 1500 + AI_MS +
+           REALTIME_MS + ENGINE_MS + 1500 + GREETING_MS + 2000;
+}
+
+struct Sim {
+    uint32_t associateMs;        // 0: never associates
+    unsigned long wifiStarted;
+    bool spoke;
+    bool requestedNetCheck;      // WiFi came up after ready
+};
+
+static Sim sim;
+
+static BootState cost(uint32_t ms) {
+    halDelay(ms);
+    return BOOT_OK;
+}
+
+static BootState simDisplay(void*) { return cost(DISPLAY_MS); }
+static BootState simSplash(void*) { return cost(SPLASH_MS); }
+static BootState simPower(void*) { return BOOT_OK; }
+static BootState simApi(void*) { return cost(API_MS); }
+static BootState simAi(void*) { return cost(AI_MS); }
+static BootState simRealtime(void*) { return cost(REALTIME_MS); }
+static BootState simEngine(void*) { return cost(ENGINE_MS); }
+
+static BootState simWifiStart(void*) {
+    nativeHal().netUp = false;
+    sim.wifiStarted = halMillis();
+    return BOOT_RUNNING;
+}
+
+static BootState simWifiPoll(void*) {
+    if (sim.associateMs == 0 || halMillis() - sim.wifiStarted < sim.associateMs) {
+        return BOOT_RUNNING;
+    }
+    nativeHal().netUp = true;
+    sim.requestedNetCheck = bootSequencer().isReady();
+    return BOOT_OK;
+}
+
+static BootState simGreeting(void*) {
+    if (halNetConnected()) {
+        sim.spoke = true;
+        halDelay(GREETING_MS);
+    }
+    return BOOT_OK;
+}
+
+// setup()'s table; returns the wifi phase
+static int addSketchPhases(BootSequencer& boot) {
+    int display = boot.add("display", simDisplay, nullptr, nullptr, 0, BOOT_BEFORE_READY);
+    boot.add("splash", simSplash, nullptr, nullptr, BootSequencer::bit(display),
+             BOOT_COLD_ONLY | BOOT_IF_OK);
+    boot.add("power", simPower, nullptr, nullptr, 0, BOOT_BEFORE_READY);
+    int wifi = boot.add("wifi", simWifiStart, simWifiPoll, nullptr, 0, 0, WIFI_TIMEOUT_MS);
+    boot.add("api", simApi, nullptr, nullptr);
+    int ai = boot.add("ai", simAi, nullptr, nullptr, 0, BOOT_BEFORE_READY);
+    int rt = boot.add("realtime", simRealtime, nullptr, nullptr, 0, BOOT_BEFORE_READY);
+    boot.add("engine", simEngine, nullptr, nullptr, BootSequencer::bit(ai) | BootSequencer::bit(rt),
+             BOOT_BEFORE_READY);
+    boot.add("greeting", simGreeting, nullptr, nullptr,
+             BootSequencer::bit(display) | BootSequencer::bit(wifi) | BootSequencer::bit(ai),
+             BOOT_COLD_ONLY | BOOT_BEFORE_READY);
+    return wifi;
+}
+
+// setup() to ready, then loop() stepping what is left
+static BootSequencer& boot(HalWakeCause wake, uint32_t associateMs) {
+    resetHal();
+    nativeHal().wakeCause = wake;
+    sim = Sim();
+    sim.associateMs = associateMs;
+    halDelay(ROM_MS);
+
+    BootSequencer& b = bootSequencer();
+    b.begin(halWakeCause());
+    addSketchPhases(b);
+    b.runUntilReady();
+    return b;
+}
+
+static void finishInLoop(BootSequencer& b) {
+    while (!b.isDone()) {
+        if (!b.step()) halDelay(BootSequencer::POLL_MS);
+    }
+}
+
+static const BootSequencer::Phase& phase(const BootSequencer& b, const char* name) {
+    for (int i = 0; i < b.getPhaseCount(); i++) {
+        if (strcmp(b.getPhase(i).name, name) == 0) return b.getPhase(i);
+    }
+    return b.getPhase(0);
+}
+
+static uint32_t ms(uint32_t us) { return us / 1000; }
+
+// ============================================
+// TESTS
+// ============================================
+
+static void testColdBoot() {
+    BootSequencer& b = boot(HAL_WAKE_POWER_ON, 2300);
+    CHECK(b.isReady() && b.isDone());        // Ready waits for the greeting, after WiFi
+    CHECK(ms(b.getBeginUs()) == ROM_MS);
+    CHECK(phase(b, "splash").state == BOOT_OK);
+    CHECK(phase(b, "wifi").state == BOOT_OK);
+    CHECK(phase(b, "greeting").state == BOOT_OK && sim.spoke);
+    CHECK(!sim.requestedNetCheck);
+
+    // The display and the AI came up while WiFi associated
+    const BootSequencer::Phase& wifi = phase(b, "wifi");
+    CHECK(ms(wifi.startUs) == ROM_MS + DISPLAY_MS + SPLASH_MS);
+    CHECK(phase(b, "ai").endUs < wifi.endUs && phase(b, "engine").endUs < wifi.endUs);
+    CHECK(phase(b, "greeting").startUs == wifi.endUs);
+    uint32_t associated = ms(wifi.endUs - wifi.startUs);
+    CHECK(associated >= 2300 && associated < 2300 + 2 * BootSequencer::POLL_MS);
+
+    uint32_t ready = ms(b.getReadyUs());
+    uint32_t expected = ROM_MS + DISPLAY_MS + SPLASH_MS + 2300 + GREETING_MS;
+    CHECK(ready >= expected && ready < expected + 2 * BootSequencer::POLL_MS);
+    CHECK(ready + 7000 < legacyReadyMs(2300));   // The fixed delays alone were 7 s
+    printf("  cold boot: ready %u ms (old setup() %u ms)\n", (unsigned)ready,
+           (unsigned)legacyReadyMs(2300));
+}
+
+static void testButtonWake() {
+    BootSequencer& b = boot(HAL_WAKE_BUTTON, 2300);
+    CHECK(b.getWake() == HAL_WAKE_BUTTON);
+    CHECK(b.isReady() && !b.isDone());       // WiFi still associating
+    CHECK(phase(b, "splash").state == BOOT_SKIPPED);
+    CHECK(phase(b, "greeting").state == BOOT_SKIPPED && !sim.spoke);
+    CHECK(phase(b, "wifi").state == BOOT_RUNNING);
+
+    uint32_t ready = ms(b.getReadyUs());
+    CHECK(ready == ROM_MS + DISPLAY_MS + API_MS + AI_MS + REALTIME_MS + ENGINE_MS);
+    CHECK(ready * 20 < legacyReadyMs(2300));
+
+    finishInLoop(b);
+    const BootSequencer::Phase& wifi = phase(b, "wifi");
+    CHECK(wifi.state == BOOT_OK && wifi.endUs > b.getReadyUs());
+    CHECK(sim.requestedNetCheck);            // The app is told it is online
+    CHECK(b.getDoneUs() == wifi.endUs);
+    printf("  button wake: ready %u ms, WiFi up at %u ms (old setup() %u ms)\n", (unsigned)ready,
+           (unsigned)ms(wifi.endUs), (unsigned)legacyReadyMs(2300));
+}
+
+static BootState simPrewarm(void*) { return BOOT_OK; }
+
+static void testWifiNeverComes() {
+    BootSequencer& b = boot(HAL_WAKE_POWER_ON, 0);
+    const BootSequencer::Phase& wifi = phase(b, "wifi");
+    CHECK(wifi.state == BOOT_TIMED_OUT);
+    CHECK(ms(wifi.endUs - wifi.startUs) >= WIFI_TIMEOUT_MS);
+    CHECK(ms(wifi.endUs - wifi.startUs) < WIFI_TIMEOUT_MS + 2 * BootSequencer::POLL_MS);
+    CHECK(phase(b, "greeting").state == BOOT_OK && !sim.spoke);   // Welcome screen, no speech
+    CHECK(b.isReady() && b.isDone());
+
+    // A phase that needs WiFi to have worked is skipped
+    resetHal();
+    sim = Sim();
+    BootSequencer& w = bootSequencer();
+    w.begin(HAL_WAKE_BUTTON);
+    int wifiPhase = addSketchPhases(w);
+    int prewarm = w.add("prewarm", simPrewarm, nullptr, nullptr, BootSequencer::bit(wifiPhase), BOOT_IF_OK);
+    w.runUntilReady();
+    CHECK(w.getPhase(prewarm).state == BOOT_WAITING);
+    finishInLoop(w);
+    CHECK(w.getPhase(prewarm).state == BOOT_SKIPPED);
+    CHECK(w.getPhase(prewarm).startUs == w.getPhase(wifiPhase).endUs);
+}
+
+static int order[BootSequencer::MAX_PHASES];
+static int orderCount;
+
+static BootState recordA(void*) { order[orderCount++] = 0; return BOOT_OK; }
+static BootState recordB(void*) { order[orderCount++] = 1; return BOOT_FAILED; }
+static BootState recordC(void*) { order[orderCount++] = 2; return BOOT_OK; }
+static BootState keepsRunning(void*) { return BOOT_RUNNING; }
+
+static void testTable() {
+    resetHal();
+    orderCount = 0;
+    BootSequencer b;
+    b.begin(HAL_WAKE_POWER_ON);
+    // Added out of order: c (0) waits for a (1) and b (2), b for a
+    b.add("c", recordC, nullptr, nullptr, BootSequencer::bit(1) | BootSequencer::bit(2));
+    int a = b.add("a", recordA, nullptr, nullptr);
+    b.add("b", recordB, nullptr, nullptr, BootSequencer::bit(a));
+    b.add("d", keepsRunning, nullptr, nullptr);              // No poll: start() finishes it
+    CHECK(b.step());
+    CHECK(orderCount == 2 && order[0] == 0 && order[1] == 1);  // a then b in one pass
+    CHECK(b.getPhase(3).state == BOOT_OK);
+    CHECK(!b.isDone());
+    CHECK(b.step());
+    CHECK(orderCount == 3 && order[2] == 2);                  // Ran although b failed
+    CHECK(b.getPhase(0).state == BOOT_OK && b.getPhase(2).state == BOOT_FAILED &&
+          b.getPhase(1).state == BOOT_OK);
+    CHECK(b.isReady() && b.isDone());                        // No BOOT_BEFORE_READY phases
+    CHECK(!b.step());
+    CHECK(b.doneMask() == 0xF);
+
+    CHECK(BootSequencer::bit(-1) == 0 && BootSequencer::bit(3) == 8);
+    for (int i = b.getPhaseCount(); i < BootSequencer::MAX_PHASES; i++) {
+        CHECK(b.add("x", recordA, nullptr, nullptr) == i);
+    }
+    CHECK(b.add("full", recordA, nullptr, nullptr) == -1);
+}
+
+static std::string timelineJson() {
+    Capture json;
+    bootSequencer().writeJson(json);
+    return json.text;
+}
+
+static void testTimeline() {
+    boot(HAL_WAKE_BUTTON, 2300);
+    finishInLoop(bootSequencer());
+    std::string first = timelineJson();
+    Capture report;
+    bootSequencer().printReport(report);
+
+    // The same boot gives the same timeline
+    boot(HAL_WAKE_BUTTON, 2300);
+    finishInLoop(bootSequencer());
+    CHECK(timelineJson() == first);
+
+    CHECK(first.find("{\"wake\":\"button\",\"setup_us\":85000,\"ready_us\":287000,") == 0);
+    CHECK(first.find("{\"name\":\"display\",\"state\":\"ok\",\"start_us\":85000,\"end_us\":205000}") !=
+          std::string::npos);
+    CHECK(first.find("{\"name\":\"splash\",\"state\":\"skipped\",\"start_us\":205000,\"end_us\":205000}") !=
+          std::string::npos);
+    CHECK(first.find("\"name\":\"wifi\",\"state\":\"ok\",\"start_us\":205000,") != std::string::npos);
+    CHECK(first.back() == '}' && first.find("]}") == first.size() - 2);
+
+    CHECK(report.has("=== Boot (button wake) ===\n"));
+    CHECK(report.has("  setup 85 ms, ready 287 ms, done "));
+    CHECK(report.has("  display    ok              85       120\n"));
+    CHECK(report.has("  greeting   skipped        287         0\n"));
+    CHECK(report.has("  wifi       ok             205      23"));
+    CHECK(report.has("  (after ready)\n  api "));
+
+    MetricsRegistry registry;
+    bootSequencer().registerMetrics(registry);
+    Capture metrics;
+    registry.write(metrics);
+    CHECK(metrics.has("volt_boot_ready_ms 287\n"));
+    CHECK(metrics.has("# TYPE volt_boot_done_ms gauge\n"));
+
+    printf("%s", report.text.c_str());
+    boot(HAL_WAKE_POWER_ON, 2300);
+    Capture cold;
+    bootSequencer().printReport(cold);
+    printf("%s", cold.text.c_str());
+}
+
+int main() {
+    testColdBoot();
+    testButtonWake();
+    testWifiNeverComes();
+    testTable();
+    testTimeline();
+
+    return testSummary();
+}
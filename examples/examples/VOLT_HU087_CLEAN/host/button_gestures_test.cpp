@@ -0,0 +1,501 @@
+/*
+ * ============================================
+ * Button Gesture Tests (host)
+ * ============================================
+ *
+ * Replays scripted edge timelines (with contact
+ * bounce) through button_gestures.h the way the
+ * ui task runs it: asleep until the next edge
+ * or the next timer the engine asks for. Checks
+ * the gestures, when they fire and how many
+ * wakeups each pattern costs.
+ *
+ * Then drives the pin on the native HAL (its
+ * writes run the change handler like the
+ * interrupt) through app_tasks.h: presses, SOS
+ * hold and cancel, light sleep held off while
+ * the button is down, edges lost to a full
+ * queue, and UI wakeups over a quiet minute.
+ *
+ * Built and run by CMakeLists.txt (ctest).
+ *
+ * ============================================
+ */
+
+#include "volt_hal.h"
+#include "app_tasks.h"
+#include "test_check.h"
+
+#include <string>
+#include <vector>
+
+static const int BUTTON_PIN = 0;
+
+// ============================================
+// EDGE TIMELINES
+// ============================================
+
+struct Edge {
+    unsigned long at;
+    bool pressed;
+};
+
+struct Seen {
+    Gesture gesture;
+    unsigned long at;
+};
+
+struct Replay {
+    std::vector<Seen> seen;
+    std::vector<int> counts;     // getPressCount() at each GESTURE_PRESSES
+    int wakeups;
+    uint32_t unmatched;
+
+    int count(Gesture g) const {
+        int n = 0;
+        for (const Seen& s : seen) n += s.gesture == g;
+        return n;
+    }
+
+    // Gestures other than DOWN and CLICK, in order
+    std::vector<Gesture> outcomes() const {
+        std::vector<Gesture> out;
+        for (const Seen& s : seen) {
+            if (s.gesture != GESTURE_DOWN && s.gesture != GESTURE_CLICK) out.push_back(s.gesture);
+        }
+        return out;
+    }
+};
+
+static void take(ButtonGestures& button, Replay& r, unsigned long now) {
+    for (Gesture g = button.poll(now); g != GESTURE_NONE; g = button.poll(now)) {
+        r.seen.push_back({ g, now });
+        if (g == GESTURE_PRESSES) r.counts.push_back(button.getPressCount());
+    }
+}
+
+// Sleeps until the next edge or the engine's next timer, whichever
+// comes first, until endMs. Each edge is one wakeup (an interrupt),
+// each timer another.
+static Replay replay(const std::vector<Edge>& edges, unsigned long endMs,
+                     const GestureTiming& timing = ButtonGestures::defaultTiming()) {
+    ButtonGestures button;
+    button.begin(timing);
+    Replay r;
+    r.wakeups = 0;
+    size_t i = 0;
+    unsigned long now = 0;
+
+    for (int guard = 0; guard < 10000; guard++) {
+        uint32_t wait = button.waitMs(now);
+        unsigned long next = wait == ButtonGestures::NO_TIMER ? endMs + 1 : now + wait;
+        if (i < edges.size() && edges[i].at <= next) next = edges[i].at;
+        if (next > endMs) break;
+
+        now = next;
+        r.wakeups++;
+        take(button, r, now);
+        if (i < edges.size() && edges[i].at == now) {
+            button.edge(edges[i].pressed, now);
+            i++;
+            take(button, r, now);
+        }
+    }
+    r.unmatched = button.getUnmatched();
+    return r;
+}
+
+// A press from at for ms, with no bounce
+static void click(std::vector<Edge>& edges, unsigned long at, unsigned long ms) {
+    edges.push_back({ at, true });
+    edges.push_back({ at + ms, false });
+}
+
+static void testClicks() {
+    GestureTiming t = ButtonGestures::defaultTiming();
+
+    // One click: down and up each wake twice (edge, settle), then
+    // the gap timer ends the pattern
+    std::vector<Edge> one;
+    click(one, 1000, 120);
+    Replay r = replay(one, 5000);
+    CHECK(r.count(GESTURE_DOWN) == 1);
+    CHECK(r.count(GESTURE_CLICK) == 1);
+    CHECK(r.count(GESTURE_PRESSES) == 1);
+    CHECK(r.counts.size() == 1 && r.counts[0] == 1);
+    CHECK(r.seen.size() == 3);
+    CHECK(r.seen[0].at == 1000 + t.settleMs);
+    CHECK(r.seen[1].at == 1120 + t.settleMs);
+    CHECK(r.seen[2].at == 1120 + t.multiPressMs);   // From the release, not its settle
+    CHECK(r.wakeups == 5);
+    CHECK(r.unmatched == 0);
+
+    // Three quick ones, then five: the count only comes out once
+    std::vector<Edge> three;
+    click(three, 1000, 100);
+    click(three, 1300, 100);
+    click(three, 1600, 100);
+    r = replay(three, 5000);
+    CHECK(r.count(GESTURE_CLICK) == 3);
+    CHECK(r.counts.size() == 1 && r.counts[0] == 3);
+    CHECK(r.wakeups == 3 * 4 + 1);
+
+    std::vector<Edge> five;
+    for (int i = 0; i < 5; i++) click(five, 1000 + i * 250, 80);
+    r = replay(five, 5000);
+    CHECK(r.counts.size() == 1 && r.counts[0] == 5);
+
+    // Two patterns, far enough apart
+    std::vector<Edge> two;
+    click(two, 1000, 100);
+    click(two, 1000 + 100 + t.multiPressMs + 50, 100);
+    r = replay(two, 5000);
+    CHECK(r.counts.size() == 2 && r.counts[0] == 1 && r.counts[1] == 1);
+
+    // A slower gap than multiPressMs splits them; one just under
+    // doesn't
+    std::vector<Edge> edge;
+    click(edge, 1000, 100);
+    click(edge, 1100 + t.multiPressMs - 1, 100);
+    r = replay(edge, 5000);
+    CHECK(r.counts.size() == 1 && r.counts[0] == 2);
+}
+
+static void testBounce() {
+    GestureTiming t = ButtonGestures::defaultTiming();
+
+    // Press and release chatter for a few ms each
+    std::vector<Edge> edges = {
+        { 1000, true }, { 1002, false }, { 1003, true }, { 1006, false }, { 1008, true },
+        { 1150, false }, { 1151, true }, { 1154, false }
+    };
+    Replay r = replay(edges, 5000);
+    CHECK(r.count(GESTURE_DOWN) == 1);
+    CHECK(r.count(GESTURE_CLICK) == 1);
+    CHECK(r.counts.size() == 1 && r.counts[0] == 1);
+    CHECK(r.seen[0].at == 1008 + t.settleMs);       // Settles after the last bounce
+    CHECK(r.wakeups == (int)edges.size() + 3);     // Every edge, two settles, the gap
+
+    // A spike shorter than settleMs is no press at all
+    std::vector<Edge> spike = { { 1000, true }, { 1005, false } };
+    r = replay(spike, 5000);
+    CHECK(r.seen.empty());
+    CHECK(r.wakeups == 3);
+    CHECK(r.unmatched == 0);
+
+    // Noise during a hold doesn't end it
+    std::vector<Edge> noisy = { { 1000, true }, { 2400, false }, { 2404, true }, { 3500, false } };
+    r = replay(noisy, 8000);
+    CHECK(r.outcomes() == std::vector<Gesture>{ GESTURE_LONG_PRESS });
+    CHECK(r.count(GESTURE_CLICK) == 0);
+
+    // A release with nothing pressed (held through boot) is ignored
+    std::vector<Edge> boot = { { 1000, false } };
+    r = replay(boot, 3000);
+    CHECK(r.seen.empty());
+}
+
+static void testLongAndSos() {
+    GestureTiming t = ButtonGestures::defaultTiming();
+
+    // Released between the long press and the warning
+    std::vector<Edge> longPress;
+    click(longPress, 1000, t.longPressMs + 500);
+    Replay r = replay(longPress, 8000);
+    CHECK(r.outcomes() == std::vector<Gesture>{ GESTURE_LONG_PRESS });
+    CHECK(r.count(GESTURE_CLICK) == 0);
+    CHECK(r.seen.back().at == 1000 + t.longPressMs + 500 + t.settleMs);
+    // Edge, settle, long timer, edge, settle: nothing while held
+    CHECK(r.wakeups == 5);
+
+    // A release just before the long press timer is still a click,
+    // though it only settles after the timer is due
+    std::vector<Edge> close;
+    click(close, 1000, t.longPressMs - 10);
+    r = replay(close, 8000);
+    CHECK(r.outcomes() == std::vector<Gesture>{ GESTURE_PRESSES });
+    CHECK(r.count(GESTURE_CLICK) == 1);
+
+    // Warned, then let go: cancelled
+    std::vector<Edge> cancel;
+    click(cancel, 1000, t.sosWarnMs + 500);
+    r = replay(cancel, 10000);
+    CHECK((r.outcomes() == std::vector<Gesture>{ GESTURE_SOS_WARNING, GESTURE_SOS_CANCEL }));
+    CHECK(r.seen[1].at == 1000 + t.sosWarnMs);
+
+    // Held through: the alert at sosHoldMs, the release is silent
+    std::vector<Edge> sos;
+    click(sos, 1000, t.sosHoldMs + 3000);
+    r = replay(sos, 12000);
+    CHECK((r.outcomes() == std::vector<Gesture>{ GESTURE_SOS_WARNING, GESTURE_SOS }));
+    CHECK(r.seen.back().at == 1000 + t.sosHoldMs);
+    CHECK(r.wakeups == 7);                          // Edge, settle, 3 timers, edge, settle
+    CHECK(r.unmatched == 0);
+
+    // Clicks and then a hold: the hold wins, the clicks are dropped
+    std::vector<Edge> clicksThenHold;
+    click(clicksThenHold, 1000, 100);
+    click(clicksThenHold, 1300, t.longPressMs + 200);
+    r = replay(clicksThenHold, 8000);
+    CHECK(r.outcomes() == std::vector<Gesture>{ GESTURE_LONG_PRESS });
+
+    // Phase 1 style timing: SOS at 3 s, warning at 2 s, no room for
+    // a long press that isn't a warning
+    GestureTiming quick = { 20, 400, 2000, 2000, 3000 };
+    std::vector<Edge> held;
+    click(held, 1000, 3200);
+    r = replay(held, 8000, quick);
+    CHECK((r.outcomes() == std::vector<Gesture>{ GESTURE_SOS_WARNING, GESTURE_SOS }));
+    CHECK(r.seen.back().at == 1000 + 3000);
+}
+
+static void testLateWakeups() {
+    GestureTiming t = ButtonGestures::defaultTiming();
+
+    // Two edges queued while nobody polled: only the last level
+    // counts, unless the caller polls up to each edge first (as
+    // app_tasks.h does)
+    ButtonGestures button;
+    button.edge(true, 1000);
+    button.edge(false, 1100);
+    CHECK(button.waitMs(1000) == 100 + t.settleMs);
+    CHECK(button.isActive());
+    CHECK(button.poll(9000) == GESTURE_NONE);
+    CHECK(!button.isActive());
+
+    button.begin(t);
+    button.edge(true, 1000);
+    std::vector<Gesture> got;
+    for (Gesture g = button.poll(1100); g != GESTURE_NONE; g = button.poll(1100)) got.push_back(g);
+    button.edge(false, 1100);
+    for (Gesture g = button.poll(9000); g != GESTURE_NONE; g = button.poll(9000)) got.push_back(g);
+    CHECK((got == std::vector<Gesture>{ GESTURE_DOWN, GESTURE_CLICK, GESTURE_PRESSES }));
+
+    // Polled late: everything comes out in order, timed from when
+    // it was due
+    button.begin(t);
+    button.edge(true, 1000);
+    CHECK(button.poll(1000 + t.settleMs) == GESTURE_DOWN);
+    button.edge(false, 1100);
+    got.clear();
+    for (Gesture g = button.poll(9000); g != GESTURE_NONE; g = button.poll(9000)) got.push_back(g);
+    CHECK((got == std::vector<Gesture>{ GESTURE_CLICK, GESTURE_PRESSES }));
+    CHECK(button.getPressCount() == 1);
+    CHECK(button.waitMs(9000) == ButtonGestures::NO_TIMER);
+
+    // Nothing to do: no timer at all, where a 10 ms poll would have
+    // woken 6000 times a minute
+    std::vector<Edge> none;
+    Replay r = replay(none, 60000);
+    CHECK(r.wakeups == 0);
+}
+
+// ============================================
+// THROUGH THE APP TASKS
+// ============================================
+
+struct Fake {
+    std::vector<int> work;
+    std::vector<AppStateId> states;
+    std::vector<Gesture> gestures;
+    std::string lastText;
+
+    int count(int type) const {
+        int n = 0;
+        for (int t : work) n += t == type;
+        return n;
+    }
+};
+
+static void fakeUi(const AppCommand& cmd, void* ctx) {
+    if (cmd.text) ((Fake*)ctx)->lastText = cmd.text;
+}
+
+static void fakeWork(const AppCommand& cmd, AppEvent& result, void* ctx) {
+    ((Fake*)ctx)->work.push_back(cmd.type);
+    if (cmd.type == CMD_CHECK_NET) result.a = 0;     // Stays offline
+}
+
+static void fakeState(AppStateId state, void* ctx) {
+    ((Fake*)ctx)->states.push_back(state);
+}
+
+static void fakeButton(Gesture g, void* ctx) {
+    ((Fake*)ctx)->gestures.push_back(g);
+}
+
+static const uint8_t ALL_FEATURES = FEATURE_VOICE | FEATURE_JOKES | FEATURE_BREATHING |
+                                    FEATURE_LOVE | FEATURE_WIFI_SETUP | FEATURE_SOS;
+
+static void start(AppTasks& app, Fake& f, uint8_t features = ALL_FEATURES) {
+    AppConfig config = { features, 5000, "Love you, buddy" };
+    AppTasks::Hooks hooks = { fakeUi, fakeWork, fakeWork, fakeState, fakeButton, &f };
+    CHECK(app.begin(config, hooks, BUTTON_PIN, false));
+}
+
+// The ui task until endMs: asleep for idleMs() unless an edge comes
+// first. Edges are pin writes at their time (the handler queues
+// them); audio and net run right after each ui pass.
+static void runUi(AppTasks& app, const std::vector<Edge>& edges, unsigned long endMs) {
+    size_t i = 0;
+    for (int guard = 0; guard < 100000; guard++) {
+        unsigned long now = halMillis();
+        uint32_t wait = app.idleMs();
+        if (i < edges.size() && edges[i].at <= now + wait) {
+            if (edges[i].at > now) halDelay(edges[i].at - now);
+            halDigitalWrite(BUTTON_PIN, edges[i].pressed ? LOW : HIGH);
+            i++;
+        } else if (now + wait > endMs) {
+            if (endMs > now) halDelay(endMs - now);
+            return;
+        }
+        app.uiStep(wait);
+        while (app.audioStep(0) || app.netStep(0)) {
+        }
+    }
+}
+
+static void testAppPresses() {
+    resetHal();
+    Fake f;
+    AppTasks app;
+    start(app, f);
+    GestureTiming t = ButtonGestures::defaultTiming();
+
+    // Two clicks: a joke (offline, so the intro hold then a joke)
+    std::vector<Edge> edges;
+    click(edges, 1000, 100);
+    click(edges, 1300, 100);
+    runUi(app, edges, 1400 + t.multiPressMs + 10);
+    CHECK(app.getState() == APP_JOKE);
+    CHECK((f.gestures == std::vector<Gesture>{ GESTURE_DOWN, GESTURE_CLICK, GESTURE_DOWN,
+                                               GESTURE_CLICK, GESTURE_PRESSES }));
+    // 4 edges, 4 settles, the gap; no wakeups between
+    CHECK(app.getUiWakeups() == 9);
+
+    runUi(app, {}, 10000);
+    CHECK(app.getState() == APP_IDLE);
+}
+
+static void testAppSos() {
+    GestureTiming t = ButtonGestures::defaultTiming();
+
+    // Held through: warning over idle, then the alert on the net
+    // task, then idle after SOS_MS. The chip stays awake while held.
+    resetHal();
+    Fake f;
+    AppTasks app;
+    start(app, f);
+    CHECK(app.beginLightSleep());
+    CHECK(nativeHal().lightSleepPin == BUTTON_PIN);
+    CHECK(!nativeHal().sleepBlocked);
+
+    std::vector<Edge> press = { { 1000, true } };
+    runUi(app, press, 1000 + t.sosWarnMs + 10);
+    CHECK(app.getState() == APP_SOS);
+    CHECK(f.lastText == "Hold for SOS...");
+    CHECK(nativeHal().sleepBlocked);
+    CHECK(f.count(CMD_SOS) == 0);
+
+    std::vector<Edge> release = { { 1000 + t.sosHoldMs + 1000, false } };
+    runUi(app, release, 1000 + t.sosHoldMs + 10);
+    CHECK(f.lastText == "SOS Sent!");
+    CHECK(f.count(CMD_SOS) == 1);
+    runUi(app, release, 1000 + t.sosHoldMs + 1100);
+    CHECK(!nativeHal().sleepBlocked);
+    runUi(app, {}, 1000 + t.sosHoldMs + AppStateMachine::SOS_MS + 10);
+    CHECK(app.getState() == APP_IDLE);
+    CHECK(AppStateMachine::stateName(APP_SOS) == std::string("sos"));
+
+    // Let go after the warning: back to idle, no alert
+    resetHal();
+    Fake g;
+    AppTasks cancel;
+    start(cancel, g);
+    std::vector<Edge> hold;
+    click(hold, 1000, t.sosWarnMs + 500);
+    runUi(cancel, hold, 6000);
+    CHECK(cancel.getState() == APP_IDLE);
+    CHECK(g.count(CMD_SOS) == 0);
+    CHECK((g.states == std::vector<AppStateId>{ APP_SOS, APP_IDLE }));
+
+    // Mid-exercise the warning doesn't show, the alert still goes
+    resetHal();
+    Fake h;
+    AppTasks busy;
+    start(busy, h);
+    CHECK(busy.post({ EV_PRESSES, 3, 0, nullptr }));
+    busy.uiStep(0);
+    CHECK(busy.getState() == APP_BREATHING);
+    std::vector<Edge> busyHold;
+    click(busyHold, 1000, t.sosHoldMs + 100);
+    runUi(busy, busyHold, 1000 + t.sosWarnMs + 10);
+    CHECK(busy.getState() == APP_BREATHING);
+    runUi(busy, busyHold, 1000 + t.sosHoldMs + 10);
+    CHECK(busy.getState() == APP_SOS);
+    CHECK(h.count(CMD_SOS) == 1);
+
+    // Without the feature a hold is Dad's message
+    resetHal();
+    Fake k;
+    AppTasks off;
+    start(off, k, ALL_FEATURES & ~FEATURE_SOS);
+    std::vector<Edge> offHold;
+    click(offHold, 1000, t.sosWarnMs + 500);
+    runUi(off, offHold, 1000 + t.sosWarnMs + 600);
+    CHECK(off.getState() == APP_MESSAGE);
+    CHECK(k.count(CMD_SOS) == 0);
+}
+
+static void testLostEdges() {
+    resetHal();
+    Fake f;
+    AppTasks app;
+    start(app, f);
+
+    // The queue is full when the press comes: the edge is lost, the
+    // next pass reads the pin instead
+    for (int i = 0; i < AppTasks::EVENT_DEPTH; i++) app.post({ EV_TICK, 0, 0, nullptr });
+    halDelay(1000);
+    halDigitalWrite(BUTTON_PIN, LOW);
+    app.uiStep(0);
+    CHECK(app.getGestures().isActive());
+    std::vector<Edge> release = { { 1100, false } };
+    runUi(app, release, 3000);
+    CHECK(f.gestures.size() >= 3 && f.gestures[0] == GESTURE_DOWN && f.gestures[2] == GESTURE_PRESSES);
+    CHECK(app.getState() == APP_NOTICE);            // One press offline: "need WiFi"
+}
+
+static void testQuietMinute() {
+    resetHal();
+    Fake f;
+    AppTasks app;
+    start(app, f);
+
+    // Nothing happens: ui wakes for the watchdog cap and the WiFi
+    // checks only, not every 10 ms
+    runUi(app, {}, 60000);
+    uint32_t wakeups = app.getUiWakeups();
+    CHECK(wakeups <= 60000 / AppTasks::IDLE_MAX_MS + 2);
+    CHECK(wakeups >= 60000 / AppTasks::IDLE_MAX_MS - 1);
+    CHECK(f.count(CMD_CHECK_NET) == 2);
+
+    MetricsRegistry registry;
+    app.registerMetrics(registry);
+    const Metric* m = registry.find("volt_app_ui_wakeups_total");
+    CHECK(m != nullptr);
+    CHECK(m == nullptr || ((const MetricCounter*)m)->get() == wakeups);
+}
+
+int main() {
+    testClicks();
+    testBounce();
+    testLongAndSos();
+    testLateWakeups();
+    testAppPresses();
+    testAppSos();
+    testLostEdges();
+    testQuietMinute();
+
+    return testSummary();
+}
@@ -0,0 +1,225 @@
+/*
+ * ============================================
+ * Coalesced Timer Tests (host)
+ * ============================================
+ *
+ * Runs coalesced_timers.h on a simulated clock
+ * that jumps from one wakeup to the next, the
+ * way loop() sleeps between them. Checks when
+ * jobs run, that none runs later than its
+ * slack, and piggybacking on other wakeups.
+ *
+ * Then an hour of the sketch's and phase 1's
+ * housekeeping three ways: a polled loop, each
+ * job on its own timer (no slack, today's
+ * millis() checks), and coalesced. Prints the
+ * wakeups per hour of each.
+ *
+ * Built and run by CMakeLists.txt (ctest).
+ *
+ * ============================================
+ */
+
+#include "coalesced_timers.h"
+#include "test_check.h"
+
+#include <stdio.h>
+
+static const unsigned long HOUR_MS = 3600000;
+
+struct Ran {
+    int count;
+    unsigned long last;
+};
+
+static void record(unsigned long now, void* ctx) {
+    Ran* r = (Ran*)ctx;
+    r->count++;
+    r->last = now;
+}
+
+// Sleeps until waitMs() each time, until end
+static void simulate(CoalescedTimers& timers, unsigned long& now, unsigned long end) {
+    for (;;) {
+        uint32_t wait = timers.waitMs(now);
+        if (wait == CoalescedTimers::NO_TIMER || now + wait > end) break;
+        now += wait;
+        timers.run(now);
+    }
+    now = end;
+}
+
+// ============================================
+// BEHAVIOUR
+// ============================================
+
+static void testSingleJob() {
+    CoalescedTimers timers;
+    timers.begin(0);
+    CHECK(timers.waitMs(0) == CoalescedTimers::NO_TIMER);
+
+    Ran r = { 0, 0 };
+    CHECK(timers.add("tick", 1000, 0, record, &r, 0) == 0);
+    CHECK(timers.waitMs(0) == 1000);
+    CHECK(timers.waitMs(400) == 600);
+    CHECK(timers.run(999) == 0);
+    CHECK(timers.run(1000) == 1);
+    CHECK(r.last == 1000);
+    CHECK(timers.waitMs(1000) == 1000);
+
+    // Late: the next period counts from the run, and lateness shows
+    CHECK(timers.run(2300) == 1);
+    CHECK(timers.getJob(0).maxLateMs == 300);
+    CHECK(timers.waitMs(2300) == 1000);
+    CHECK(timers.waitMs(5000) == 0);             // Overdue
+
+    CHECK(timers.getWakeups() == 2);
+    CHECK(timers.getRuns() == 2);
+    CHECK(timers.wakeupsPerHour(2300) == 2 * HOUR_MS / 2300);
+}
+
+static void testCoalescing() {
+    CoalescedTimers timers;
+    timers.begin(0);
+    Ran fast = { 0, 0 }, slow = { 0, 0 };
+    timers.add("fast", 5000, 1000, record, &fast, 0);
+    timers.add("slow", 30000, 10000, record, &slow, 1700);
+
+    // The slow job never wakes the CPU itself: it always has slack
+    // left when the fast one comes round
+    unsigned long now = 0;
+    simulate(timers, now, 10 * 60000);
+    CHECK(fast.count >= 600000 / 6000);
+    CHECK(slow.count >= 600000 / 40000);
+    CHECK(timers.getWakeups() == (uint32_t)fast.count);
+    CHECK(timers.getJob(0).maxLateMs <= 1000);
+    CHECK(timers.getJob(1).maxLateMs <= 10000);
+
+    // Fast sleeps its slack out every time, so it runs every 6 s,
+    // and slow only ever runs in one of those wakeups
+    CHECK(fast.last % 6000 == 0);
+    CHECK(slow.last % 6000 == 0);
+}
+
+static void testPiggyback() {
+    CoalescedTimers timers;
+    timers.begin(0);
+    Ran r = { 0, 0 };
+    timers.add("battery", 60000, 15000, record, &r, 0);
+
+    // Woken at 61 s for something else: due, so it runs, but that
+    // wakeup wasn't for the timers
+    CHECK(timers.run(61000) == 1);
+    CHECK(r.count == 1);
+    CHECK(timers.getWakeups() == 0);
+    CHECK(timers.waitMs(61000) == 60000 + 15000);
+
+    // Not due yet: nothing runs
+    CHECK(timers.run(100000) == 0);
+    CHECK(r.count == 1);
+}
+
+static void testTableFull() {
+    CoalescedTimers timers;
+    timers.begin(0);
+    for (int i = 0; i < CoalescedTimers::MAX_JOBS; i++) {
+        CHECK(timers.add("job", 1000, 0, nullptr, nullptr, 0) == i);
+    }
+    CHECK(timers.add("one too many", 1000, 0, nullptr, nullptr, 0) == -1);
+    CHECK(timers.getJobCount() == CoalescedTimers::MAX_JOBS);
+    CHECK(timers.run(1000) == CoalescedTimers::MAX_JOBS);   // No fn is fine
+    CHECK(timers.getWakeups() == 1);
+}
+
+// ============================================
+// AN HOUR OF HOUSEKEEPING
+// ============================================
+
+struct JobSpec {
+    const char* name;
+    uint32_t periodMs;
+    uint32_t slackMs;
+    unsigned long startMs;       // First armed (staggered, as at boot)
+};
+
+// As volt_stone_FINAL.ino registers them
+static const JobSpec VOLT_JOBS[] = {
+    { "samples", 5000, 2000, 900 },
+    { "sleep", 5000, 2000, 950 },
+    { "heap", 10000, 5000, 1200 },
+    { "wifi", 30000, 10000, 2600 },
+    { "battery", 60000, 15000, 3100 },
+};
+
+// As phase 1's volt_firmware_v6.ino registers them
+static const JobSpec PHASE1_JOBS[] = {
+    { "activity", 5000, 2000, 1500 },
+    { "gps", 30000, 10000, 4200 },
+    { "api", 60000, 30000, 9800 },
+};
+
+struct HourResult {
+    uint32_t wakeups;
+    int runs[8];
+};
+
+static HourResult runHour(const JobSpec* specs, int n, bool slack) {
+    static Ran ran[8];
+    CoalescedTimers timers;
+    timers.begin(0);
+    for (int i = 0; i < n; i++) {
+        ran[i] = { 0, 0 };
+        timers.add(specs[i].name, specs[i].periodMs, slack ? specs[i].slackMs : 0, record, &ran[i],
+                   specs[i].startMs);
+    }
+    unsigned long now = 0;
+    simulate(timers, now, HOUR_MS);
+
+    HourResult h;
+    h.wakeups = timers.wakeupsPerHour(now);
+    for (int i = 0; i < n; i++) {
+        h.runs[i] = ran[i].count;
+        CHECK(timers.getJob(i).maxLateMs <= (slack ? specs[i].slackMs : 0));
+    }
+    return h;
+}
+
+static void compareHour(const char* label, const JobSpec* specs, int n, uint32_t loopMs) {
+    HourResult own = runHour(specs, n, false);
+    HourResult coalesced = runHour(specs, n, true);
+    printf("%s: polled loop %u/h, own timers %u/h, coalesced %u/h\n", label,
+           (unsigned)(HOUR_MS / loopMs), (unsigned)own.wakeups, (unsigned)coalesced.wakeups);
+
+    for (int i = 0; i < n; i++) {
+        // Every job still runs about as often as its period asks
+        CHECK(own.runs[i] >= (int)(HOUR_MS / specs[i].periodMs) - 1);
+        CHECK(coalesced.runs[i] >= (int)(HOUR_MS / (specs[i].periodMs + specs[i].slackMs)) - 1);
+    }
+    CHECK(coalesced.wakeups < own.wakeups);
+    CHECK(own.wakeups < HOUR_MS / loopMs);
+}
+
+static void testHour() {
+    int nVolt = (int)(sizeof(VOLT_JOBS) / sizeof(VOLT_JOBS[0]));
+    int nPhase1 = (int)(sizeof(PHASE1_JOBS) / sizeof(PHASE1_JOBS[0]));
+    compareHour("VOLT", VOLT_JOBS, nVolt, 100);
+    compareHour("Phase 1", PHASE1_JOBS, nPhase1, 10);
+
+    // The sketch's jobs, coalesced: at most one wakeup per 5 s,
+    // and never a sleep past the 8 s watchdog
+    HourResult volt = runHour(VOLT_JOBS, nVolt, true);
+    CHECK(volt.wakeups <= HOUR_MS / 5000);
+    CHECK(VOLT_JOBS[0].periodMs + VOLT_JOBS[0].slackMs < 8000);    // Samples bound every sleep
+    HourResult own = runHour(VOLT_JOBS, nVolt, false);
+    CHECK(volt.wakeups * 3 < own.wakeups);
+}
+
+int main() {
+    testSingleJob();
+    testCoalescing();
+    testPiggyback();
+    testTableFull();
+    testHour();
+
+    return testSummary();
+}
@@ -0,0 +1,281 @@
+/*
+ * ============================================
+ * DNS Cache Tests (host)
+ * ============================================
+ *
+ * Runs dns_cache.h against a fake resolver and
+ * a fake clock: TTL expiry, stale answers,
+ * eviction, RTC persistence and the DNS wire
+ * format.
+ *
+ * Build and run (from this directory):
+ *   g++ -std=c++17 -Wall -Wextra -I. -I.. dns_cache_test.cpp -o dns_cache_test
+ *   ./dns_cache_test
+ *
+ * Also built and run by CMakeLists.txt (ctest).
+ *
+ * ============================================
+ */
+
+#include "../dns_cache.h"
+#include "test_check.h"
+
+// ============================================
+// FAKE RESOLVER AND CLOCK
+// ============================================
+
+static uint32_t fakeNow = 1000;
+static int resolveCalls = 0;
+static bool resolverUp = true;
+static uint32_t answerTtl = 300;
+
+static uint32_t fakeClock() {
+    return fakeNow;
+}
+
+// Every host resolves to 10.0.0.<length of its name>
+static bool fakeResolve(const char* host, uint32_t& ip, uint32_t& ttl) {
+    resolveCalls++;
+    if (!resolverUp) {
+        return false;
+    }
+    uint8_t bytes[4] = { 10, 0, 0, (uint8_t)strlen(host) };
+    memcpy(&ip, bytes, 4);
+    ttl = answerTtl;
+    return true;
+}
+
+static uint32_t ipFor(const char* host) {
+    uint8_t bytes[4] = { 10, 0, 0, (uint8_t)strlen(host) };
+    uint32_t ip;
+    memcpy(&ip, bytes, 4);
+    return ip;
+}
+
+static void reset(DnsCacheStore& store) {
+    memset(&store, 0xA5, sizeof(store));     // RTC memory after power-on
+    fakeNow = 1000;
+    resolveCalls = 0;
+    resolverUp = true;
+    answerTtl = 300;
+}
+
+// ============================================
+// TESTS
+// ============================================
+
+static void testHitWithinTtl() {
+    DnsCacheStore store;
+    reset(store);
+    DnsCache cache(&store, fakeResolve, fakeClock);
+    uint32_t ip = 0;
+
+    CHECK(cache.resolve("api.openai.com", ip));
+    CHECK(ip == ipFor("api.openai.com"));
+    CHECK(resolveCalls == 1);
+
+    fakeNow += 299;
+    CHECK(cache.resolve("api.openai.com", ip));
+    CHECK(resolveCalls == 1);
+
+    fakeNow += 1;
+    CHECK(cache.resolve("api.openai.com", ip));
+    CHECK(resolveCalls == 2);
+
+    DnsCacheStats stats = cache.getStats();
+    CHECK(stats.hits == 1);
+    CHECK(stats.misses == 2);
+}
+
+static void testTtlClamped() {
+    DnsCacheStore store;
+    reset(store);
+    DnsCache cache(&store, fakeResolve, fakeClock);
+    uint32_t ip;
+
+    answerTtl = 0;
+    CHECK(cache.resolve("a.example", ip));
+    fakeNow += DnsCache::MIN_TTL - 1;
+    CHECK(cache.lookup("a.example", ip));
+    fakeNow += 1;
+    CHECK(!cache.lookup("a.example", ip));
+
+    answerTtl = 7 * 24 * 3600;
+    CHECK(cache.resolve("b.example", ip));
+    fakeNow += DnsCache::MAX_TTL;
+    CHECK(!cache.lookup("b.example", ip));
+}
+
+static void testStaleWhenLookupFails() {
+    DnsCacheStore store;
+    reset(store);
+    DnsCache cache(&store, fakeResolve, fakeClock);
+    uint32_t ip = 0;
+
+    CHECK(cache.resolve("sos.example", ip));
+    resolverUp = false;
+    fakeNow += 600;
+
+    ip = 0;
+    CHECK(cache.resolve("sos.example", ip));
+    CHECK(ip == ipFor("sos.example"));
+    CHECK(cache.getStats().staleHits == 1);
+
+    fakeNow += DnsCache::STALE_GRACE;
+    CHECK(!cache.resolve("sos.example", ip));
+    CHECK(!cache.resolve("never.example", ip));
+    CHECK(cache.getStats().failures == 3);
+}
+
+static void testEvictsFirstToExpire() {
+    DnsCacheStore store;
+    reset(store);
+    DnsCache cache(&store, fakeResolve, fakeClock);
+    char host[16];
+
+    for (int i = 0; i < DNS_CACHE_ENTRIES; i++) {
+        snprintf(host, sizeof(host), "h%d.example", i);
+        cache.store(host, ipFor(host), i == 3 ? 60 : 600);
+    }
+    CHECK(cache.size() == DNS_CACHE_ENTRIES);
+
+    cache.store("new.example", ipFor("new.example"), 600);
+    uint32_t ip;
+    CHECK(cache.size() == DNS_CACHE_ENTRIES);
+    CHECK(!cache.lookup("h3.example", ip));
+    CHECK(cache.lookup("h2.example", ip));
+    CHECK(cache.lookup("new.example", ip));
+}
+
+static void testSurvivesDeepSleep() {
+    DnsCacheStore store;
+    reset(store);
+    uint32_t ip;
+    {
+        DnsCache cache(&store, fakeResolve, fakeClock);
+        CHECK(cache.size() == 0);
+        CHECK(cache.resolve("api.openai.com", ip));
+    }
+
+    // Wake: a new cache on the same RTC store, clock moved on
+    fakeNow += 120;
+    DnsCache woken(&store, fakeResolve, fakeClock);
+    CHECK(woken.lookup("api.openai.com", ip));
+    CHECK(ip == ipFor("api.openai.com"));
+    CHECK(resolveCalls == 1);
+
+    // A corrupted store starts empty
+    store.entries[0].ip ^= 1;
+    DnsCache corrupted(&store, fakeResolve, fakeClock);
+    CHECK(corrupted.size() == 0);
+}
+
+static void testClockStepBack() {
+    DnsCacheStore store;
+    reset(store);
+    fakeNow = 1700000000;
+    DnsCache cache(&store, fakeResolve, fakeClock);
+    uint32_t ip;
+
+    CHECK(cache.resolve("api.openai.com", ip));
+    fakeNow = 50;
+    CHECK(!cache.lookup("api.openai.com", ip));
+    CHECK(cache.resolve("api.openai.com", ip));
+    CHECK(resolveCalls == 2);
+}
+
+static void testPrewarm() {
+    DnsCacheStore store;
+    reset(store);
+    DnsCache cache(&store, fakeResolve, fakeClock);
+    const char* hosts[] = { "api.openai.com", "sos.example" };
+
+    CHECK(cache.prewarm(hosts, 2) == 2);
+    CHECK(resolveCalls == 2);
+    CHECK(cache.prewarm(hosts, 2) == 2);
+    CHECK(resolveCalls == 2);
+
+    // Refreshed once close to expiry
+    fakeNow += 300 - DnsCache::MIN_TTL;
+    CHECK(cache.prewarm(hosts, 2) == 2);
+    CHECK(resolveCalls == 4);
+
+    cache.invalidate("sos.example");
+    CHECK(cache.size() == 1);
+}
+
+static void testLongHostNotCached() {
+    DnsCacheStore store;
+    reset(store);
+    DnsCache cache(&store, fakeResolve, fakeClock);
+    char host[DNS_HOST_LEN + 8];
+    memset(host, 'a', sizeof(host) - 1);
+    host[sizeof(host) - 1] = '\0';
+    uint32_t ip;
+
+    CHECK(cache.resolve(host, ip));
+    CHECK(cache.size() == 0);
+    CHECK(!cache.resolve("", ip));
+}
+
+static void testWireFormat() {
+    uint8_t query[DNS_PACKET_SIZE];
+    size_t len = dnsBuildQuery(query, sizeof(query), "api.openai.com", 0x1234);
+    static const uint8_t expected[] = {
+        0x12, 0x34, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        3, 'a', 'p', 'i', 6, 'o', 'p', 'e', 'n', 'a', 'i', 3, 'c', 'o', 'm', 0,
+        0x00, 0x01, 0x00, 0x01
+    };
+    CHECK(len == sizeof(expected));
+    CHECK(memcmp(query, expected, sizeof(expected)) == 0);
+    CHECK(dnsBuildQuery(query, sizeof(query), "bad..name", 1) == 0);
+    CHECK(dnsBuildQuery(query, 20, "api.openai.com", 1) == 0);
+
+    // Response: question, CNAME (TTL 300) -> A 104.18.7.192 (TTL 60),
+    // both answer names compressed
+    uint8_t response[DNS_PACKET_SIZE];
+    memcpy(response, expected, sizeof(expected));
+    response[2] = 0x81;
+    response[3] = 0x80;
+    response[7] = 2;
+    size_t pos = sizeof(expected);
+    static const uint8_t cname[] = {
+        0xC0, 0x0C, 0x00, 0x05, 0x00, 0x01, 0x00, 0x00, 0x01, 0x2C, 0x00, 0x05,
+        2, 'c', 'f', 0xC0, 0x10
+    };
+    memcpy(response + pos, cname, sizeof(cname));
+    pos += sizeof(cname);
+    static const uint8_t a[] = {
+        0xC0, 0x2D, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x3C, 0x00, 0x04,
+        104, 18, 7, 192
+    };
+    memcpy(response + pos, a, sizeof(a));
+    pos += sizeof(a);
+
+    uint32_t ip = 0;
+    uint32_t ttl = 0;
+    CHECK(dnsParseResponse(response, pos, 0x1234, ip, ttl));
+    uint8_t bytes[4];
+    memcpy(bytes, &ip, 4);
+    CHECK(bytes[0] == 104 && bytes[1] == 18 && bytes[2] == 7 && bytes[3] == 192);
+    CHECK(ttl == 60);
+
+    CHECK(!dnsParseResponse(response, pos, 0x4321, ip, ttl));      // Wrong id
+    CHECK(!dnsParseResponse(response, pos - 3, 0x1234, ip, ttl));  // Truncated
+    response[3] = 0x83;                                             // NXDOMAIN
+    CHECK(!dnsParseResponse(response, pos, 0x1234, ip, ttl));
+}
+
+int main() {
+    testHitWithinTtl();
+    testTtlClamped();
+    testStaleWhenLookupFails();
+    testEvictsFirstToExpire();
+    testSurvivesDeepSleep();
+    testClockStepBack();
+    testPrewarm();
+    testLongHostNotCached();
+    testWireFormat();
+
+    return testSummary();
+}
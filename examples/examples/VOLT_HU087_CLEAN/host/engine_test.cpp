@@ -0,0 +1,496 @@
+/*
+ * ============================================
+ * AI Engine Tests (host)
+ * ============================================
+ *
+ * Runs VoltAI (volt_ai_FINAL.h) on the native
+ * HAL against a canned HTTP/1.1 server thread
+ * standing in for api.openai.com:
+ * - transcribe(): multipart upload of the mic
+ *   audio, Content-Length response
+ * - chat(): chunked JSON response
+ * - speak(): chunked PCM streamed to the
+ *   speaker model
+ * - Error statuses and a dead network
+ * - A 10,000-turn soak of whole turns (virtual
+ *   clock, short speech): arena allocations per
+ *   turn, peak use and the heaps stay flat
+ * - The turn's trace spans (volt_trace.h)
+ * - Request and HTTP status counters
+ *
+ * Needs ArduinoJson; built and run by
+ * CMakeLists.txt (ctest) when it is found.
+ *
+ * ============================================
+ */
+
+#include "volt_ai_FINAL.h"
+#include "test_check.h"
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// ============================================
+// CANNED SERVER
+// ============================================
+
+struct SeenRequest {
+    std::string path;
+    std::string head;
+    std::string body;
+};
+
+class CannedServer {
+private:
+    int listener;
+    std::thread worker;
+    std::atomic<bool> running;
+    std::mutex seenLock;
+    std::vector<SeenRequest> requests;     // Under seenLock
+    std::string transcript;                // Under seenLock
+    std::string reply;                     // Under seenLock
+
+    static bool readRequest(int fd, SeenRequest& req) {
+        std::string data;
+        char buf[4096];
+        size_t headEnd;
+        while ((headEnd = data.find("\r\n\r\n")) == std::string::npos) {
+            ssize_t n = recv(fd, buf, sizeof(buf), 0);
+            if (n <= 0) return false;
+            data.append(buf, n);
+        }
+        req.head = data.substr(0, headEnd);
+        size_t sp = req.head.find(' ');
+        req.path = req.head.substr(sp + 1, req.head.find(' ', sp + 1) - sp - 1);
+
+        size_t length = 0;
+        size_t cl = req.head.find("Content-Length: ");
+        if (cl != std::string::npos) {
+            length = strtoul(req.head.c_str() + cl + 16, nullptr, 10);
+        }
+        req.body = data.substr(headEnd + 4);
+        while (req.body.size() < length) {
+            ssize_t n = recv(fd, buf, sizeof(buf), 0);
+            if (n <= 0) return false;
+            req.body.append(buf, n);
+        }
+        return true;
+    }
+
+    static void sendAll(int fd, const std::string& data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+            ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) return;
+            sent += n;
+        }
+    }
+
+    static std::string chunk(const std::string& data, const char* ext = "") {
+        char size[32];
+        snprintf(size, sizeof(size), "%zx%s\r\n", data.size(), ext);
+        return size + data + "\r\n";
+    }
+
+    std::string respond(const SeenRequest& req) {
+        if (status != 200) {
+            std::string body = "{\"error\":{\"message\":\"nope\"}}";
+            return "HTTP/1.1 " + std::to_string(status) + " Error\r\n"
+                   "Content-Type: application/json\r\n"
+                   "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+        }
+        if (req.path == "/v1/audio/transcriptions") {
+            std::string body = "{\"text\":\"" + transcript + "\"}";
+            return "HTTP/1.1 200 OK\r\n"
+                   "Content-Type: application/json\r\n"
+                   "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+        }
+        if (req.path == "/v1/chat/completions") {
+            std::string body = "{\"id\":\"x\",\"choices\":[{\"index\":0,\"message\":"
+                               "{\"role\":\"assistant\",\"content\":\"" + reply + "\"}}]}";
+            size_t half = body.size() / 2;
+            return "HTTP/1.1 200 OK\r\n"
+                   "Content-Type: application/json\r\n"
+                   "transfer-encoding: chunked\r\n\r\n" +
+                   chunk(body.substr(0, half)) + chunk(body.substr(half)) + "0\r\n\r\n";
+        }
+        if (req.path == "/v1/audio/speech") {
+            std::string pcm(speechBytes, '\0');
+            for (size_t i = 0; i < pcm.size(); i++) pcm[i] = (char)(i & 0x7F);
+            std::string out = "HTTP/1.1 200 OK\r\n"
+                              "Content-Type: audio/pcm\r\n"
+                              "Transfer-Encoding: chunked\r\n\r\n";
+            for (size_t pos = 0; pos < pcm.size(); pos += 3000) {
+                out += chunk(pcm.substr(pos, 3000), pos == 0 ? ";ext=1" : "");
+            }
+            return out + "0\r\nX-Trailer: 1\r\n\r\n";
+        }
+        return "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+    }
+
+    void serve() {
+        while (running) {
+            int fd = accept(listener, nullptr, nullptr);
+            if (fd < 0) continue;
+            if (!running) {
+                close(fd);
+                break;
+            }
+            SeenRequest req;
+            if (readRequest(fd, req)) {
+                // Recorded before the reply: the engine returns as
+                // soon as it has read it
+                std::string out;
+                {
+                    std::lock_guard<std::mutex> held(seenLock);
+                    requests.push_back(req);
+                    out = respond(req);
+                }
+                sendAll(fd, out);
+            }
+            close(fd);   // Connection: close
+        }
+    }
+
+public:
+    uint16_t port;
+    int status;
+    size_t speechBytes;
+
+    CannedServer()
+        : listener(-1), running(false), transcript("what is a volcano"),
+          reply("A mountain that can erupt!"), port(0), status(200), speechBytes(24000) {}
+
+    bool start() {
+        listener = socket(AF_INET, SOCK_STREAM, 0);
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(listener, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(listener, 8) != 0) {
+            return false;
+        }
+        socklen_t len = sizeof(addr);
+        getsockname(listener, (struct sockaddr*)&addr, &len);
+        port = ntohs(addr.sin_port);
+        running = true;
+        worker = std::thread(&CannedServer::serve, this);
+        return true;
+    }
+
+    // The requests answered so far, in order
+    std::vector<SeenRequest> seen() {
+        std::lock_guard<std::mutex> held(seenLock);
+        return requests;
+    }
+
+    size_t seenCount() {
+        std::lock_guard<std::mutex> held(seenLock);
+        return requests.size();
+    }
+
+    void clearSeen() {
+        std::lock_guard<std::mutex> held(seenLock);
+        requests.clear();
+    }
+
+    // What the next transcriptions and chats answer
+    void script(const std::string& said, const std::string& answer) {
+        std::lock_guard<std::mutex> held(seenLock);
+        transcript = said;
+        reply = answer;
+    }
+
+    void stop() {
+        running = false;
+        // Wake the blocking accept()
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(port);
+        ::connect(fd, (struct sockaddr*)&addr, sizeof(addr));
+        close(fd);
+        worker.join();
+        close(listener);
+    }
+};
+
+static CannedServer server;
+
+static void resetServer() {
+    resetHal();
+    nativeClock().setVirtual(false);    // Sockets need real time
+    nativeRoutes().add("api.openai.com", 443, "127.0.0.1", server.port, false);
+    server.clearSeen();
+    server.script("what is a volcano", "A mountain that can erupt!");
+    server.status = 200;
+    server.speechBytes = 24000;
+}
+
+static const char* TEST_KEY = "sk-test-0123456789";
+static const char* TEST_PROMPT = "You are VOLT, a friendly helper.";
+
+// ============================================
+// TESTS
+// ============================================
+
+static void testBeginRejectsBadKey() {
+    resetServer();
+    VoltAI bot;
+    CHECK(!bot.begin("short", TEST_PROMPT));
+    CHECK(*bot.transcribe() == '\0');     // Not initialized: no request
+    CHECK(server.seen().empty());
+}
+
+static void testTurn() {
+    resetServer();
+    std::vector<int16_t> mic(BUFFER_SIZE);
+    for (size_t i = 0; i < mic.size(); i++) mic[i] = (int16_t)(i % 1000);
+    nativeHal().setMicPcm(mic.data(), mic.size() * 2, SAMPLE_RATE);
+
+    VoltAI bot;
+    CHECK(bot.begin(TEST_KEY, TEST_PROMPT));
+    voltTrace().clear();
+    uint16_t turn = TRACE_TURN();
+    bot.recordAudio();
+
+    const char* text = bot.transcribe();
+    CHECK(strcmp(text, "what is a volcano") == 0);
+    std::vector<SeenRequest> seen = server.seen();
+    CHECK(seen.size() == 1);
+    if (seen.size() == 1) {
+        const SeenRequest& req = seen[0];
+        CHECK(req.path == "/v1/audio/transcriptions");
+        CHECK(req.head.find("Authorization: Bearer sk-test-0123456789") != std::string::npos);
+        CHECK(req.head.find("multipart/form-data; boundary=") != std::string::npos);
+        // Samples go up unchanged after the 44-byte WAV header
+        size_t riff = req.body.find("RIFF");
+        CHECK(riff != std::string::npos);
+        CHECK(riff != std::string::npos &&
+              memcmp(req.body.data() + riff + 44, mic.data(), mic.size() * 2) == 0);
+    }
+
+    const char* reply = bot.chat(text);
+    CHECK(strcmp(reply, "A mountain that can erupt!") == 0);
+    CHECK(strcmp(text, "what is a volcano") == 0);   // Still valid this turn
+    seen = server.seen();
+    CHECK(seen.size() == 2);
+    if (seen.size() == 2) {
+        const std::string& body = seen[1].body;
+        CHECK(seen[1].path == "/v1/chat/completions");
+        CHECK(body.find(TEST_PROMPT) != std::string::npos);
+        CHECK(body.find("what is a volcano") != std::string::npos);
+    }
+
+    bot.speak(reply);
+    seen = server.seen();
+    CHECK(seen.size() == 3);
+    if (seen.size() == 3) {
+        CHECK(seen[2].path == "/v1/audio/speech");
+        CHECK(seen[2].body.find("A mountain that can erupt!") != std::string::npos);
+    }
+    // De-chunked PCM plus the 512-byte silence pad
+    CHECK(nativeHal().speaker.bytesPlayed == server.speechBytes + 512);
+    CHECK(nativeHal().speakerRate == SAMPLE_RATE);
+    CHECK(halDigitalRead(SPK_SD_MODE) == LOW);   // Amplifier off again
+    CHECK(aiMetrics().transcribeCodes.get(200) == 1);
+    CHECK(aiMetrics().speechRequests.get() == 1);
+
+    // Every stage of the turn was traced (in the order spans ended);
+    // no upload starts before its connection is up
+    std::string stages;
+    bool sameTurn = true;
+    bool uploadAfterConnect = true;
+    uint32_t connectEndUs = 0;
+    voltTrace().forEach([&](const VoltTrace::Span& span) {
+        stages += TRACE_STAGE_NAMES[span.stage];
+        stages += ' ';
+        sameTurn = sameTurn && span.turn == turn;
+        if (span.stage == TRACE_CONNECT) connectEndUs = span.startUs + span.durUs;
+        if (span.stage == TRACE_UPLOAD) uploadAfterConnect = uploadAfterConnect && span.startUs >= connectEndUs;
+    });
+    CHECK(stages == "record encode tls connect upload server_wait "
+                    "tls connect encode upload server_wait "
+                    "tls connect encode upload server_wait tts_first_byte playback ");
+    CHECK(sameTurn);
+    CHECK(uploadAfterConnect);
+
+    ArenaStats stats = bot.getArenaStats();
+    CHECK(stats.used > 0 && stats.failedAllocs == 0);
+    bot.endTurn();
+    CHECK(bot.getArenaStats().used == 0);
+}
+
+static void testErrorStatus() {
+    resetServer();
+    VoltAI bot;
+    CHECK(bot.begin(TEST_KEY, TEST_PROMPT));
+
+    AiMetrics& m = aiMetrics();
+    uint32_t chats = m.chatRequests.get();
+    uint32_t chat401 = m.chatCodes.get(401);
+    uint32_t speech401 = m.speechCodes.get(401);
+    uint32_t chat200 = m.chatCodes.get(200);
+
+    server.status = 401;
+    CHECK(*bot.chat("hello") == '\0');
+    CHECK(*bot.transcribe() == '\0');
+
+    // Error bodies are never played as audio
+    bot.speak("hello");
+    CHECK(nativeHal().speaker.bytesPlayed == 0);
+    CHECK(server.seen().size() == 3);
+    bot.endTurn();
+
+    CHECK(m.chatRequests.get() == chats + 1);
+    CHECK(m.chatCodes.get(401) == chat401 + 1);
+    CHECK(m.speechCodes.get(401) == speech401 + 1);
+    CHECK(m.chatCodes.get(200) == chat200);
+
+    server.status = 429;
+    uint32_t chat429 = m.chatCodes.get(429);
+    CHECK(*bot.chat("hello") == '\0');
+    CHECK(m.chatCodes.get(429) == chat429 + 1);
+    bot.endTurn();
+
+    // Served from the registry begin() filled
+    CHECK(metricsRegistry().find("volt_ai_responses_total", "endpoint=\"chat\",code=\"429\"") ==
+          &m.chatCodes.counter(2));
+}
+
+// 3200 bytes is 100 ms of 16 kHz mono
+static void testPlaybackClock() {
+    PlaybackClock clock(16000);
+    CHECK(!clock.write(3200, 1000));    // First write never counts
+    CHECK(!clock.write(3200, 1050));    // Queued up to 1200
+    CHECK(!clock.write(3200, 1200));    // Just in time
+    CHECK(clock.write(3200, 1400));     // Ran dry at 1300
+    CHECK(!clock.write(3200, 1450));    // Restarted from 1400
+    CHECK(clock.write(3200, 1700));
+}
+
+static void testNoNetwork() {
+    resetServer();
+    VoltAI bot;
+    CHECK(bot.begin(TEST_KEY, TEST_PROMPT));
+    nativeHal().netUp = false;
+    uint32_t chats = aiMetrics().chatRequests.get();
+    CHECK(*bot.transcribe() == '\0');
+    CHECK(*bot.chat("hello") == '\0');
+    bot.speak("hello");
+    CHECK(server.seen().empty());
+    CHECK(aiMetrics().chatRequests.get() == chats);   // Never started
+}
+
+// ============================================
+// SOAK
+// ============================================
+
+static const int SOAK_TURNS = 10000;
+
+// What the user says, cycled so turns differ in size
+static const char* const SOAK_TEXTS[7] = {
+    "what is a volcano",
+    "hi",
+    "can you tell me a story about a robot who learns to paint the sky",
+    "why is the sea salty",
+    "count to ten",
+    "what do bees do in winter when it is very cold outside",
+    "play a game with me"
+};
+
+// Whole turns through the engine and the canned server. The virtual
+// clock skips speak()'s playout delays; the sockets still wait for
+// the server thread (native_net.h).
+static void testArenaSoak() {
+    resetServer();
+    nativeClock().setVirtual(true);
+    server.speechBytes = 960;                        // 30 ms
+
+    VoltAI bot;
+    CHECK(bot.begin(TEST_KEY, TEST_PROMPT));
+    HalHeapInfo internal = halHeapInfo(HAL_HEAP_INTERNAL);
+    HalHeapInfo psram = halHeapInfo(HAL_HEAP_SPIRAM);
+    uint32_t transcribed = aiMetrics().transcribeCodes.get(200);
+
+    // The first pass over the texts sets what every later one must match
+    uint32_t allocs[7] = {};
+    uint32_t expectedAllocs = 0;
+    size_t peak = 0;
+    bool replies = true;
+    bool served = true;
+    bool sameAllocs = true;
+    bool heapsKept = true;
+    for (int turn = 0; turn < SOAK_TURNS; turn++) {
+        const char* said = SOAK_TEXTS[turn % 7];
+        std::string expected = std::string("You said: ") + said + ". Nice!";
+        server.script(said, expected);
+
+        bot.recordAudio();
+        const char* text = bot.transcribe();
+        const char* reply = bot.chat(text);
+        replies = replies && strcmp(text, said) == 0 && expected == reply;
+        bot.speak(reply);
+        served = served && server.seenCount() == 3;
+        server.clearSeen();
+
+        ArenaStats stats = bot.getArenaStats();
+        if (turn < 7) {
+            allocs[turn] = stats.turnAllocs;
+        } else {
+            sameAllocs = sameAllocs && stats.turnAllocs == allocs[turn % 7];
+        }
+        expectedAllocs += allocs[turn % 7];
+        if (turn == 6) peak = stats.highWater;
+        bot.endTurn();
+
+        if (turn % 1000 == 999) {
+            HalHeapInfo i = halHeapInfo(HAL_HEAP_INTERNAL);
+            HalHeapInfo p = halHeapInfo(HAL_HEAP_SPIRAM);
+            heapsKept = heapsKept && i.freeBytes == internal.freeBytes &&
+                        i.largestFree == internal.largestFree &&
+                        p.freeBytes == psram.freeBytes && p.largestFree == psram.largestFree;
+        }
+    }
+
+    ArenaStats stats = bot.getArenaStats();
+    CHECK(replies);
+    CHECK(served);
+    CHECK(nativeHal().speaker.bytesPlayed == (uint64_t)SOAK_TURNS * (server.speechBytes + 512));
+    CHECK(aiMetrics().transcribeCodes.get(200) == transcribed + SOAK_TURNS);
+    CHECK(sameAllocs && allocs[0] > 0);
+    CHECK(stats.totalAllocs == expectedAllocs);      // Nothing allocated between turns
+    CHECK(stats.highWater == peak && peak < stats.capacity);
+    CHECK(stats.failedAllocs == 0);
+    CHECK(stats.turns == (uint32_t)SOAK_TURNS && stats.used == 0);
+    CHECK(heapsKept);
+
+    HalHeapInfo after = halHeapInfo(HAL_HEAP_INTERNAL);
+    CHECK(after.minFree == internal.minFree);        // The low-water mark never moved
+    printf("soak: %d turns, %u allocs/turn avg, peak %u of %u bytes, internal largest %u (frag %u%%)\n",
+           SOAK_TURNS, (unsigned)(stats.totalAllocs / SOAK_TURNS), (unsigned)peak,
+           (unsigned)stats.capacity, (unsigned)after.largestFree,
+           heapFragPercent(after.freeBytes, after.largestFree));
+}
+
+int main() {
+    if (!server.start()) {
+        printf("Could not start the canned server\n");
+        return 1;
+    }
+
+    testBeginRejectsBadKey();
+    testTurn();
+    testErrorStatus();
+    testPlaybackClock();
+    testNoNetwork();
+    testArenaSoak();
+
+    server.stop();
+    return testSummary();
+}
@@ -0,0 +1,410 @@
+/*
+ * ============================================
+ * Event Hub Tests (host)
+ * ============================================
+ *
+ * Runs event_hub.h on the native HAL:
+ * - Queue policy per subscriber: coalescing,
+ *   making room, overflow ending the stream
+ * - Retained events replayed to new
+ *   subscribers; the SOS acknowledge route
+ * - Heartbeats (virtual clock) and limits
+ * - Two threads publishing while a third
+ *   drains (the HAL lock); status published
+ *   from several tasks goes out once per
+ *   change and ends on the latest values
+ * - End to end over loopback: events published
+ *   from another thread while the server
+ *   waits in poll() with a 1 s timeout reach an
+ *   SSE client in well under that (the wake
+ *   socket), with a stalled client connected;
+ *   reports p50/p99 latency
+ *
+ * Built by CMakeLists.txt (ctest).
+ *
+ * ============================================
+ */
+
+#include "device_api.h"
+#include "test_check.h"
+
+#include <arpa/inet.h>
+#include <netinet/tcp.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Everything one drain() writes
+static std::string drainText(EventHub& hub, int slot, bool* ended = nullptr, size_t cap = 1024) {
+    std::vector<uint8_t> buf(cap);
+    ApiChunk out(buf.data(), cap);
+    bool end = hub.drain(out, slot);
+    if (ended) *ended = end;
+    return std::string((const char*)buf.data(), out.length());
+}
+
+static int countOf(const std::string& text, const char* s) {
+    int n = 0;
+    for (size_t at = 0; (at = text.find(s, at)) != std::string::npos; at++) n++;
+    return n;
+}
+
+// ============================================
+// QUEUE POLICY
+// ============================================
+
+static void testCoalesce() {
+    resetHal();
+    EventHub hub;
+    CHECK(hub.begin());
+    int slot = hub.subscribe();
+    CHECK(slot == 0);
+    CHECK(hub.getSubscribers() == 1);
+
+    std::string first = drainText(hub, slot);
+    CHECK(first == "retry: 2000\n\n");
+
+    hub.publish("status", "{\"battery\":80}", EVENT_COALESCE);
+    hub.publish("sos", "{\"active\":true}");
+    hub.publish("status", "{\"battery\":79}", EVENT_COALESCE);
+    hub.publish("status", "{\"battery\":78}", EVENT_COALESCE);
+    CHECK(hub.getCoalesced() == 2);
+
+    // Latest status only, after the SOS it was published after
+    bool ended = true;
+    std::string text = drainText(hub, slot, &ended);
+    CHECK(!ended);
+    CHECK(text == "id: 2\nevent: sos\ndata: {\"active\":true}\n\n"
+                  "id: 4\nevent: status\ndata: {\"battery\":78}\n\n");
+    CHECK(drainText(hub, slot).empty());
+    CHECK(hub.getDeliveryTimes().getCount() == 2);
+}
+
+static void testBackpressure() {
+    resetHal();
+    EventHub hub;
+    CHECK(hub.begin());
+    int slot = hub.subscribe();
+    drainText(hub, slot);
+
+    // Full: the oldest coalescable event makes room
+    hub.publish("steps", "{\"steps\":1}", EVENT_COALESCE);
+    for (int i = 0; i < EventHub::QUEUE_DEPTH - 1; i++) {
+        hub.publish("sos", "{\"n\":1}");
+    }
+    hub.publish("sos", "{\"n\":2}");
+    CHECK(hub.getCoalesced() == 1);
+    CHECK(hub.getOverflows() == 0);
+    std::string text = drainText(hub, slot);
+    CHECK(countOf(text, "event: sos") == EventHub::QUEUE_DEPTH);
+    CHECK(countOf(text, "event: steps") == 0);
+
+    // Full of events that must not be lost: the stream ends once
+    // what was queued is written, and later events are not taken
+    for (int i = 0; i < EventHub::QUEUE_DEPTH + 3; i++) {
+        hub.publish("sos", "{\"n\":3}");
+    }
+    CHECK(hub.getOverflows() == 1);
+    bool ended = false;
+    text = drainText(hub, slot, &ended, 200);       // Only part fits
+    CHECK(!ended && countOf(text, "event: sos") > 0);
+    int written = countOf(text, "event: sos");
+    text = drainText(hub, slot, &ended);
+    CHECK(ended);
+    CHECK(written + countOf(text, "event: sos") == EventHub::QUEUE_DEPTH);
+
+    // Other subscribers are not held back by this one
+    hub.unsubscribe(slot);
+    CHECK(hub.getSubscribers() == 0);
+}
+
+static void testRetained() {
+    resetHal();
+    EventHub hub;
+    CHECK(hub.begin());
+    hub.publish("status", "{\"battery\":50}", EVENT_COALESCE | EVENT_RETAIN);
+    hub.publish("status", "{\"battery\":49}", EVENT_COALESCE | EVENT_RETAIN);
+    hub.publish("sos", "{\"active\":true}", EVENT_RETAIN);
+    hub.publish("tick", "{}");                      // Not retained
+
+    int slot = hub.subscribe();
+    std::string text = drainText(hub, slot);
+    CHECK(text.compare(0, 13, "retry: 2000\n\n") == 0);
+    CHECK(text.find("event: status\ndata: {\"battery\":49}") != std::string::npos);
+    CHECK(text.find("{\"battery\":50}") == std::string::npos);
+    CHECK(text.find("event: sos\ndata: {\"active\":true}") != std::string::npos);
+    CHECK(text.find("tick") == std::string::npos);
+
+    hub.publish("sos", "{\"active\":false}", EVENT_RETAIN);
+    int late = hub.subscribe();
+    text = drainText(hub, late);
+    CHECK(text.find("{\"active\":false}") != std::string::npos);
+    CHECK(text.find("{\"active\":true}") == std::string::npos);
+}
+
+static void testHeartbeatAndLimits() {
+    resetHal();
+    EventHub hub;
+    CHECK(hub.begin());
+    int slot = hub.subscribe();
+    drainText(hub, slot);
+    CHECK(drainText(hub, slot).empty());
+    nativeClock().advanceUs((EventHub::HEARTBEAT_MS - 1) * 1000ULL);
+    CHECK(drainText(hub, slot).empty());
+    nativeClock().advanceUs(1000);
+    CHECK(drainText(hub, slot) == ": ping\n\n");
+    CHECK(drainText(hub, slot).empty());
+
+    CHECK(!hub.publish("status", "{\"a\":1}\n{\"b\":2}"));         // Would break the framing
+    CHECK(!hub.publish("status", std::string(EventHub::DATA_MAX, 'x').c_str()));
+    CHECK(!hub.publish("a_very_long_type_name", "{}"));
+    CHECK(hub.getPublished() == 0);
+
+    for (int i = 1; i < EventHub::MAX_SUBSCRIBERS; i++) {
+        CHECK(hub.subscribe() >= 0);
+    }
+    CHECK(hub.subscribe() == -1);
+    ApiResponse res;
+    hub.handle(res);
+    CHECK(res.kind == ApiResponse::STATIC && res.status == 503);
+    hub.unsubscribe(2);
+    ApiResponse again;
+    hub.handle(again);
+    CHECK(again.kind == ApiResponse::STREAM && again.longLived && again.cursor == 3);
+}
+
+// As on the watch: the ui and sensor tasks publish while the API
+// task drains, each blocking on the others' hold of the lock
+static void testPublishFromTasks() {
+    resetHal();
+    EventHub hub;
+    CHECK(hub.begin());
+    int slot = hub.subscribe();
+    drainText(hub, slot);
+
+    const int PER_TASK = 2000;
+    auto publisher = [&hub](const char* type) {
+        for (int i = 0; i < PER_TASK; i++) {
+            char data[32];
+            snprintf(data, sizeof(data), "{\"n\":%d}", i);
+            hub.publish(type, data, EVENT_COALESCE);
+        }
+    };
+    std::thread ui(publisher, "status");
+    std::thread sensors(publisher, "steps");
+    std::string text;
+    for (int i = 0; i < PER_TASK; i++) text += drainText(hub, slot);
+    ui.join();
+    sensors.join();
+    text += drainText(hub, slot);
+
+    CHECK(hub.getPublished() == 2 * PER_TASK);
+    CHECK(hub.getOverflows() == 0);
+    char last[32];
+    snprintf(last, sizeof(last), "{\"n\":%d}", PER_TASK - 1);
+    CHECK(countOf(text, "event: status") >= 1 && countOf(text, "event: steps") >= 1);
+    CHECK(text.rfind(last) != std::string::npos);
+}
+
+// onAppState (ui), checkWiFiConnection (net) and checkBattery
+// (loop()) each change their part of the status and publish it
+static void testStatusFromTasks() {
+    resetHal();
+    for (int round = 0; round < 200; round++) {
+        DeviceApi api;
+        EventHub& hub = api.getEvents();
+        CHECK(hub.begin());
+        api.getStatus().state = "idle";
+        api.getStatus().battery = 90;
+        api.publishStatus();
+
+        // Nothing changed: no task sends it again
+        std::vector<std::thread> same;
+        for (int t = 0; t < 3; t++) {
+            same.emplace_back([&api]() {
+                for (int i = 0; i < 100; i++) api.publishStatus();
+            });
+        }
+        for (std::thread& t : same) t.join();
+
+        std::thread ui([&api]() {
+            api.getStatus().state = "listening";
+            api.publishStatus();
+        });
+        std::thread loop([&api]() {
+            api.getStatus().battery = 89;
+            api.publishStatus();
+        });
+        ui.join();
+        loop.join();
+
+        // The retained status has both changes
+        std::string text = drainText(hub, hub.subscribe());
+        bool ok = hub.getPublished() >= 2 && hub.getPublished() <= 3 &&
+                  text.find("\"state\":\"listening\",\"battery\":89") != std::string::npos;
+        CHECK(ok);
+        if (!ok) break;
+    }
+}
+
+// ============================================
+// END TO END
+// ============================================
+
+static uint64_t steadyUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static int openEvents(uint16_t port, int rcvBuf = 0) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (rcvBuf > 0) setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvBuf, sizeof(rcvBuf));
+    struct timeval tv = { 3, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    const char req[] = "GET /api/events HTTP/1.1\r\nAccept: text/event-stream\r\n\r\n";
+    send(fd, req, sizeof(req) - 1, MSG_NOSIGNAL);
+    return fd;
+}
+
+// Reads until `until` appears (or the socket times out)
+static bool readUntil(int fd, std::string& buf, const char* until) {
+    char tmp[2048];
+    while (buf.find(until) == std::string::npos) {
+        ssize_t n = recv(fd, tmp, sizeof(tmp), 0);
+        if (n <= 0) return false;
+        buf.append(tmp, n);
+    }
+    return true;
+}
+
+static void testEndToEnd() {
+    resetHal();
+    nativeClock().setVirtual(false);
+    DeviceApi api;
+    CHECK(api.begin(0));
+    uint16_t port = api.getServer().getPort();
+    EventHub& hub = api.getEvents();
+
+    std::atomic<bool> stop(false);
+    std::thread serverTask([&]() {
+        while (!stop.load()) {
+            api.handle(1000);            // Only a wake ends this early
+        }
+    });
+
+    // Retained status is there before the first live event
+    api.getStatus().state = "idle";
+    api.getStatus().battery = 90;
+    api.publishStatus();
+    api.publishStatus();                 // Nothing changed: not sent
+    CHECK(hub.getPublished() == 1);
+
+    int stalled = openEvents(port, 2048);  // Connects, never reads
+    int fd = openEvents(port);
+    std::string buf;
+    CHECK(readUntil(fd, buf, "\"battery\":90"));
+    CHECK(buf.find("HTTP/1.1 200 OK\r\nContent-Type: text/event-stream") == 0);
+    CHECK(buf.find("Connection: close") != std::string::npos);
+    CHECK(buf.find("retry: 2000") != std::string::npos);
+    for (int i = 0; i < 100 && hub.getSubscribers() < 2; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    CHECK(hub.getSubscribers() == 2);
+
+    const int count = 200;
+    std::vector<double> latencyMs;
+    std::thread reader([&]() {
+        std::string in;
+        char tmp[4096];
+        while ((int)latencyMs.size() < count) {
+            ssize_t n = recv(fd, tmp, sizeof(tmp), 0);
+            if (n <= 0) break;
+            uint64_t now = steadyUs();
+            in.append(tmp, n);
+            size_t at;
+            while ((at = in.find("data: {\"t\":")) != std::string::npos) {
+                size_t end = in.find('}', at);
+                if (end == std::string::npos) break;
+                uint64_t sent = strtoull(in.c_str() + at + 11, nullptr, 10);
+                latencyMs.push_back((now - sent) / 1000.0);
+                in.erase(0, end + 1);
+            }
+        }
+    });
+
+    double slowestPublishMs = 0;
+    for (int i = 0; i < count; i++) {
+        char json[48];
+        snprintf(json, sizeof(json), "{\"t\":%llu}", (unsigned long long)steadyUs());
+        uint64_t start = steadyUs();
+        hub.publish("tick", json);
+        slowestPublishMs = std::max(slowestPublishMs, (steadyUs() - start) / 1000.0);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    reader.join();
+
+    CHECK((int)latencyMs.size() == count);
+    std::vector<double> sorted = latencyMs;
+    std::sort(sorted.begin(), sorted.end());
+    double p50 = sorted.empty() ? 0 : sorted[sorted.size() / 2];
+    double p99 = sorted.empty() ? 0 : sorted[(sorted.size() * 99) / 100];
+    printf("event latency over loopback: p50 %.3f ms, p99 %.3f ms (%d events, slowest publish %.3f ms)\n",
+           p50, p99, (int)latencyMs.size(), slowestPublishMs);
+    CHECK(p99 < 100);                    // The poll timeout is 1000 ms
+    CHECK(slowestPublishMs < 100);       // A stalled client never blocks the publisher
+
+    // Leaving frees the slot
+    close(fd);
+    close(stalled);
+    for (int i = 0; i < 200 && hub.getSubscribers() > 0; i++) {
+        hub.publish("tick", "{}");       // Wakes the server to notice
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    CHECK(hub.getSubscribers() == 0);
+
+    // The dashboard's acknowledge clears the retained alert
+    api.publishSos(37.7749, -122.4194, true, 55);
+    int ack = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    CHECK(connect(ack, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+    const char req[] = "POST /api/sos/ack HTTP/1.1\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+    send(ack, req, sizeof(req) - 1, MSG_NOSIGNAL);
+    std::string reply;
+    CHECK(readUntil(ack, reply, "acknowledged"));
+    close(ack);
+    int late = openEvents(port);
+    std::string replay;
+    CHECK(readUntil(late, replay, "event: sos"));
+    CHECK(readUntil(late, replay, "}\n\n"));
+    CHECK(replay.find("{\"active\":false}") != std::string::npos);
+    close(late);
+
+    stop.store(true);
+    api.getServer().wake();
+    serverTask.join();
+}
+
+int main() {
+    testCoalesce();
+    testBackpressure();
+    testRetained();
+    testHeartbeatAndLimits();
+    testPublishFromTasks();
+    testStatusFromTasks();
+    testEndToEnd();
+
+    return testSummary();
+}
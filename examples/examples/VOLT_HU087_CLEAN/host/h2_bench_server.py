@@ -0,0 +1,471 @@
+#!/usr/bin/env python3
+"""
+VOLT AI Watch - Local OpenAI Stand-in for the Host Benchmarks
+Serves the three endpoints a conversation turn uses over HTTP/1.1 and
+cleartext HTTP/2 (prior knowledge) on the same port:
+
+  POST /v1/audio/transcriptions  -> {"text": ...}
+  POST /v1/chat/completions      -> {"choices": [{"message": {"content": ...}}]}
+  POST /v1/audio/speech          -> raw 24 kHz pcm16, streamed
+  POST /api/device/<id>/sos      -> 201 (phase 1 SOS alert, for net_impair_bench)
+
+Latencies are modelled so the protocols can be compared offline:
+--handshake-ms is charged once per new connection (the TLS handshake the
+ESP32 would do), STT/chat take fixed processing time, and speech starts
+after a length-dependent delay then streams faster than real time.
+--jitter-ms adds a random extra delay to each response so tail
+latencies (p95/p99) show up in turn_latency_bench.
+
+HTTP/2 support is just what h2_client.h needs: SETTINGS, HEADERS (HPACK
+without Huffman on the request side), DATA with flow control in both
+directions, WINDOW_UPDATE, PING, RST_STREAM and GOAWAY.
+
+Standard library only.
+"""
+
+import argparse
+import json
+import random
+import socket
+import struct
+import threading
+import time
+
+PREFACE = b"PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"
+
+DATA, HEADERS, PRIORITY, RST_STREAM, SETTINGS, PUSH_PROMISE, PING, GOAWAY, WINDOW_UPDATE, CONTINUATION = range(10)
+END_STREAM = 0x1
+ACK = 0x1
+END_HEADERS = 0x4
+PADDED = 0x8
+PRIORITY_FLAG = 0x20
+
+PCM_BYTES_PER_SEC = 24000 * 2
+
+STATIC_TABLE = [
+    (":authority", ""), (":method", "GET"), (":method", "POST"), (":path", "/"),
+    (":path", "/index.html"), (":scheme", "http"), (":scheme", "https"), (":status", "200"),
+    (":status", "204"), (":status", "206"), (":status", "304"), (":status", "400"),
+    (":status", "404"), (":status", "500"), ("accept-charset", ""), ("accept-encoding", "gzip, deflate"),
+    ("accept-language", ""), ("accept-ranges", ""), ("accept", ""), ("access-control-allow-origin", ""),
+    ("age", ""), ("allow", ""), ("authorization", ""), ("cache-control", ""),
+    ("content-disposition", ""), ("content-encoding", ""), ("content-language", ""), ("content-length", ""),
+    ("content-location", ""), ("content-range", ""), ("content-type", ""), ("cookie", ""),
+    ("date", ""), ("etag", ""), ("expect", ""), ("expires", ""),
+    ("from", ""), ("host", ""), ("if-match", ""), ("if-modified-since", ""),
+    ("if-none-match", ""), ("if-range", ""), ("if-unmodified-since", ""), ("last-modified", ""),
+    ("link", ""), ("location", ""), ("max-forwards", ""), ("proxy-authenticate", ""),
+    ("proxy-authorization", ""), ("range", ""), ("referer", ""), ("refresh", ""),
+    ("retry-after", ""), ("server", ""), ("set-cookie", ""), ("strict-transport-security", ""),
+    ("transfer-encoding", ""), ("user-agent", ""), ("vary", ""), ("via", ""),
+    ("www-authenticate", ""),
+]
+
+REPLY = (
+    "The sky looks blue because air scatters blue sunlight more than red. "
+    "Sunlight has every color mixed together, like a rainbow squished into one. "
+    "When it bumps into tiny bits of air, the blue light bounces all over the sky. "
+    "At sunset the light travels farther, so more red and orange reaches your eyes!"
+)
+
+
+# ============================================
+# HPACK (request side: no Huffman)
+# ============================================
+
+class HpackDecoder:
+    def __init__(self):
+        self.table = []        # newest first
+        self.max_size = 4096
+
+    def _size(self):
+        return sum(len(n) + len(v) + 32 for n, v in self.table)
+
+    def _int(self, data, pos, prefix):
+        mask = (1 << prefix) - 1
+        value = data[pos] & mask
+        pos += 1
+        if value < mask:
+            return value, pos
+        shift = 0
+        while True:
+            b = data[pos]
+            pos += 1
+            value += (b & 0x7F) << shift
+            shift += 7
+            if not b & 0x80:
+                return value, pos
+
+    def _string(self, data, pos):
+        if data[pos] & 0x80:
+            raise ValueError("Huffman request strings are not supported")
+        n, pos = self._int(data, pos, 7)
+        return data[pos:pos + n].decode("latin-1"), pos + n
+
+    def _lookup(self, index):
+        if index <= len(STATIC_TABLE):
+            return STATIC_TABLE[index - 1]
+        return self.table[index - len(STATIC_TABLE) - 1]
+
+    def decode(self, data):
+        headers = []
+        pos = 0
+        while pos < len(data):
+            b = data[pos]
+            if b & 0x80:
+                index, pos = self._int(data, pos, 7)
+                headers.append(self._lookup(index))
+            elif b & 0xE0 == 0x20:
+                self.max_size, pos = self._int(data, pos, 5)
+            else:
+                incremental = b & 0xC0 == 0x40
+                index, pos = self._int(data, pos, 6 if incremental else 4)
+                if index:
+                    name = self._lookup(index)[0]
+                else:
+                    name, pos = self._string(data, pos)
+                value, pos = self._string(data, pos)
+                headers.append((name, value))
+                if incremental:
+                    self.table.insert(0, (name, value))
+                    while self._size() > self.max_size:
+                        self.table.pop()
+        return headers
+
+
+def hpack_int(value, prefix, flags):
+    mask = (1 << prefix) - 1
+    if value < mask:
+        return bytes([flags | value])
+    out = bytearray([flags | mask])
+    value -= mask
+    while value >= 0x80:
+        out.append((value & 0x7F) | 0x80)
+        value >>= 7
+    out.append(value)
+    return bytes(out)
+
+
+def hpack_literal(value):
+    raw = value.encode("latin-1")
+    return hpack_int(len(raw), 7, 0) + raw
+
+
+def encode_response_headers(status, content_type, length, turn):
+    """Static :status, literals, plus indexed entries that churn the
+    client's dynamic table (and evict) the way real servers do"""
+    block = bytearray()
+    if status == 200:
+        block += hpack_int(8, 7, 0x80)
+    else:
+        block += hpack_int(8, 4, 0x00) + hpack_literal(str(status))
+    block += hpack_int(31, 4, 0x00) + hpack_literal(content_type)
+    if length is not None:
+        block += hpack_int(28, 4, 0x00) + hpack_literal(str(length))
+    block += hpack_int(54, 6, 0x40) + hpack_literal("volt-bench")
+    block += hpack_int(0, 6, 0x40) + hpack_literal("x-request-id") + hpack_literal("req_%08d" % turn)
+    return bytes(block)
+
+
+# ============================================
+# ENDPOINTS
+# ============================================
+
+class Endpoints:
+    def __init__(self, args):
+        self.args = args
+        self.counter = 0
+        self.lock = threading.Lock()
+        self.rng = random.Random(args.seed)
+
+    def jitter(self):
+        with self.lock:
+            return self.rng.uniform(0, self.args.jitter_ms) / 1000.0
+
+    def next_id(self):
+        with self.lock:
+            self.counter += 1
+            return self.counter
+
+    def handle(self, path, body):
+        """Return (status, content_type, first_byte_delay_s, payload, stream_rate)"""
+        a = self.args
+        if path.startswith("/v1/audio/transcriptions"):
+            return 200, "application/json", a.stt_ms / 1000.0 + self.jitter(), json.dumps({"text": "Why is the sky blue?"}).encode(), None
+        if path.startswith("/v1/chat/completions"):
+            reply = {"choices": [{"message": {"role": "assistant", "content": REPLY}}]}
+            return 200, "application/json", a.chat_ms / 1000.0 + self.jitter(), json.dumps(reply).encode(), None
+        if path.startswith("/v1/audio/speech"):
+            try:
+                text = json.loads(body.decode("utf-8")).get("input", "")
+            except ValueError:
+                return 400, "application/json", 0, b'{"error":{"message":"bad json"}}', None
+            seconds = len(text) / a.chars_per_sec
+            pcm = bytes(int(seconds * PCM_BYTES_PER_SEC) & ~1)
+            ttfb = (a.tts_ttfb_ms + a.tts_ms_per_char * len(text)) / 1000.0 + self.jitter()
+            return 200, "audio/pcm", ttfb, pcm, PCM_BYTES_PER_SEC * a.tts_speed
+        if path.startswith("/api/device/") and path.endswith("/sos"):
+            return 201, "application/json", a.sos_ms / 1000.0 + self.jitter(), b'{"status":"received"}', None
+        return 404, "application/json", 0, b'{"error":{"message":"not found"}}', None
+
+
+def paced_chunks(payload, rate, chunk):
+    """Yield payload pieces no faster than rate bytes/s (None = unpaced)"""
+    start = time.monotonic()
+    sent = 0
+    for offset in range(0, len(payload), chunk):
+        piece = payload[offset:offset + chunk]
+        if rate:
+            ahead = (sent + len(piece)) / rate - (time.monotonic() - start)
+            if ahead > 0:
+                time.sleep(ahead)
+        sent += len(piece)
+        yield piece
+
+
+# ============================================
+# HTTP/1.1
+# ============================================
+
+def serve_http1(sock, first, endpoints):
+    data = first
+    while b"\r\n\r\n" not in data:
+        chunk = sock.recv(4096)
+        if not chunk:
+            return
+        data += chunk
+    head, body = data.split(b"\r\n\r\n", 1)
+    lines = head.decode("latin-1").split("\r\n")
+    path = lines[0].split(" ")[1]
+    length = 0
+    for line in lines[1:]:
+        if line.lower().startswith("content-length:"):
+            length = int(line.split(":", 1)[1])
+    while len(body) < length:
+        chunk = sock.recv(65536)
+        if not chunk:
+            return
+        body += chunk
+
+    status, ctype, delay, payload, rate = endpoints.handle(path, body)
+    time.sleep(delay)
+    sock.sendall((
+        f"HTTP/1.1 {status} {'OK' if status == 200 else 'Created' if status == 201 else 'Error'}\r\n"
+        f"Content-Type: {ctype}\r\n"
+        f"Content-Length: {len(payload)}\r\n"
+        "Server: volt-bench\r\n"
+        "Connection: close\r\n\r\n"
+    ).encode("latin-1"))
+    for piece in paced_chunks(payload, rate, 4096):
+        sock.sendall(piece)
+
+
+# ============================================
+# HTTP/2
+# ============================================
+
+class H2Session:
+    def __init__(self, sock, endpoints):
+        self.sock = sock
+        self.endpoints = endpoints
+        self.decoder = HpackDecoder()
+        self.write_lock = threading.Lock()
+        self.cond = threading.Condition()
+        self.conn_window = 65535
+        self.initial_window = 65535
+        self.max_frame = 16384
+        self.windows = {}       # stream -> send window
+        self.cancelled = set()
+        self.requests = {}      # stream -> [headers, body]
+        self.header_block = None
+        self.closed = False
+
+    def send_frame(self, ftype, flags, stream, payload=b""):
+        header = struct.pack(">I", len(payload))[1:] + bytes([ftype, flags]) + struct.pack(">I", stream)
+        with self.write_lock:
+            self.sock.sendall(header + payload)
+
+    def recv_exact(self, n):
+        data = b""
+        while len(data) < n:
+            chunk = self.sock.recv(n - len(data))
+            if not chunk:
+                raise ConnectionError("closed")
+            data += chunk
+        return data
+
+    def send_body(self, stream, payload, rate):
+        """DATA frames within both flow-control windows"""
+        pending = b""
+        chunks = paced_chunks(payload, rate, 4096)
+        while True:
+            if not pending:
+                pending = next(chunks, None)
+                if pending is None:
+                    self.send_frame(DATA, END_STREAM, stream)
+                    return
+            with self.cond:
+                while not self.closed and stream not in self.cancelled and \
+                        (self.windows[stream] <= 0 or self.conn_window <= 0):
+                    self.cond.wait(1.0)
+                if self.closed or stream in self.cancelled:
+                    return
+                n = min(len(pending), self.windows[stream], self.conn_window, self.max_frame)
+                self.windows[stream] -= n
+                self.conn_window -= n
+            self.send_frame(DATA, 0, stream, pending[:n])
+            pending = pending[n:]
+
+    def respond(self, stream, headers, body):
+        path = dict(headers).get(":path", "/")
+        status, ctype, delay, payload, rate = self.endpoints.handle(path, body)
+        time.sleep(delay)
+        block = encode_response_headers(status, ctype, len(payload), self.endpoints.next_id())
+        try:
+            self.send_frame(HEADERS, END_HEADERS, stream, block)
+            self.send_body(stream, payload, rate)
+        except OSError:
+            pass
+
+    def on_headers_complete(self, stream, flags):
+        headers = self.decoder.decode(self.header_block)
+        self.header_block = None
+        with self.cond:
+            self.windows[stream] = self.initial_window
+        self.requests[stream] = [headers, b""]
+        if self.headers_end_stream:
+            self.start(stream)
+
+    def start(self, stream):
+        headers, body = self.requests.pop(stream)
+        threading.Thread(target=self.respond, args=(stream, headers, body), daemon=True).start()
+
+    def run(self):
+        self.send_frame(SETTINGS, 0, 0, struct.pack(">HI", 3, 100) + struct.pack(">HI", 4, 65535))
+        while True:
+            header = self.recv_exact(9)
+            length = struct.unpack(">I", b"\0" + header[:3])[0]
+            ftype, flags = header[3], header[4]
+            stream = struct.unpack(">I", header[5:9])[0] & 0x7FFFFFFF
+            payload = self.recv_exact(length) if length else b""
+
+            if ftype == SETTINGS:
+                if not flags & ACK:
+                    for i in range(0, len(payload), 6):
+                        key, value = struct.unpack(">HI", payload[i:i + 6])
+                        if key == 4:
+                            with self.cond:
+                                delta = value - self.initial_window
+                                self.initial_window = value
+                                for s in self.windows:
+                                    self.windows[s] += delta
+                                self.cond.notify_all()
+                    self.send_frame(SETTINGS, ACK, 0)
+            elif ftype == HEADERS:
+                fragment = payload
+                if flags & PADDED:
+                    fragment = fragment[1:len(fragment) - payload[0]]
+                if flags & PRIORITY_FLAG:
+                    fragment = fragment[5:]
+                self.header_block = fragment
+                self.headers_end_stream = bool(flags & END_STREAM)
+                if flags & END_HEADERS:
+                    self.on_headers_complete(stream, flags)
+            elif ftype == CONTINUATION:
+                self.header_block += payload
+                if flags & END_HEADERS:
+                    self.on_headers_complete(stream, flags)
+            elif ftype == DATA:
+                data = payload
+                if flags & PADDED:
+                    data = data[1:len(data) - payload[0]]
+                if stream in self.requests:
+                    self.requests[stream][1] += data
+                # Give the window straight back
+                if length:
+                    self.send_frame(WINDOW_UPDATE, 0, 0, struct.pack(">I", length))
+                    if not flags & END_STREAM:
+                        self.send_frame(WINDOW_UPDATE, 0, stream, struct.pack(">I", length))
+                if flags & END_STREAM and stream in self.requests:
+                    self.start(stream)
+            elif ftype == WINDOW_UPDATE:
+                increment = struct.unpack(">I", payload)[0] & 0x7FFFFFFF
+                with self.cond:
+                    if stream == 0:
+                        self.conn_window += increment
+                    elif stream in self.windows:
+                        self.windows[stream] += increment
+                    self.cond.notify_all()
+            elif ftype == RST_STREAM:
+                with self.cond:
+                    self.cancelled.add(stream)
+                    self.cond.notify_all()
+            elif ftype == PING:
+                if not flags & ACK:
+                    self.send_frame(PING, ACK, 0, payload)
+            elif ftype == GOAWAY:
+                return
+
+
+def serve_connection(sock, endpoints, args):
+    try:
+        # The TLS handshake the device would pay on every new connection
+        time.sleep(args.handshake_ms / 1000.0)
+        first = b""
+        while len(first) < len(PREFACE):
+            chunk = sock.recv(len(PREFACE) - len(first))
+            if not chunk:
+                return
+            first += chunk
+            if not PREFACE.startswith(first):
+                break
+        if first == PREFACE:
+            session = H2Session(sock, endpoints)
+            try:
+                session.run()
+            finally:
+                with session.cond:
+                    session.closed = True
+                    session.cond.notify_all()
+        else:
+            serve_http1(sock, first, endpoints)
+    except (ConnectionError, OSError):
+        pass
+    finally:
+        sock.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Local h1/h2c OpenAI stand-in for the host benchmarks")
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=8090)
+    parser.add_argument("--handshake-ms", type=int, default=400, help="Cost of each new connection")
+    parser.add_argument("--stt-ms", type=int, default=500, help="Transcription processing time")
+    parser.add_argument("--chat-ms", type=int, default=700, help="Chat completion time")
+    parser.add_argument("--tts-ttfb-ms", type=int, default=250, help="Speech first-byte delay")
+    parser.add_argument("--tts-ms-per-char", type=float, default=1.5, help="Extra first-byte delay per input char")
+    parser.add_argument("--tts-speed", type=float, default=3.0, help="Speech streaming speed vs real time")
+    parser.add_argument("--chars-per-sec", type=float, default=15.0, help="Speaking rate used to size audio")
+    parser.add_argument("--sos-ms", type=int, default=150, help="SOS alert handling time")
+    parser.add_argument("--jitter-ms", type=float, default=0.0, help="Random extra delay (0..N) per response")
+    parser.add_argument("--seed", type=int, default=1, help="Jitter random seed")
+    args = parser.parse_args()
+
+    endpoints = Endpoints(args)
+    server = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    server.bind((args.host, args.port))
+    server.listen(16)
+    print(f"⚡ Bench server on {args.host}:{args.port} (HTTP/1.1 and h2c)", flush=True)
+
+    try:
+        while True:
+            sock, _ = server.accept()
+            sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+            threading.Thread(target=serve_connection, args=(sock, endpoints, args), daemon=True).start()
+    except KeyboardInterrupt:
+        print("\n👋 Stopped")
+
+
+if __name__ == "__main__":
+    main()
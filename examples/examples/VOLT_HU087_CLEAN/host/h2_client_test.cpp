@@ -0,0 +1,624 @@
+/*
+ * ============================================
+ * HTTP/2 Client Tests (host)
+ * ============================================
+ *
+ * Runs h2_client.h against a scripted server
+ * (bytes queued up front, read back in any
+ * chunk size) on the native HAL:
+ * - HPACK: the RFC 7541 Appendix C examples,
+ *   plain and Huffman coded, with the dynamic
+ *   table filling and evicting as listed there
+ * - Huffman: bad padding, padding of a byte or
+ *   more, EOS in a string, output that doesn't
+ *   fit
+ * - Header blocks that must be rejected: index
+ *   0 or past the tables, integers that never
+ *   end, strings longer than the block, table
+ *   size updates over what we advertise, and
+ *   an entry larger than the whole table
+ * - Frames: padded HEADERS and DATA (with and
+ *   without priority), padding longer than the
+ *   frame, CONTINUATION sequences and frames
+ *   interleaved with them, header blocks over
+ *   the limit
+ * - Flow control: WINDOW_UPDATE of 0 and past
+ *   2^31-1 on the connection and on a stream,
+ *   DATA larger than the stream's or the
+ *   connection's receive window, frames over
+ *   the maximum frame size
+ *
+ * Built and run by CMakeLists.txt (ctest).
+ *
+ * ============================================
+ */
+
+#include "volt_hal.h"
+#include "mem_pools.h"
+#include "h2_client.h"
+#include "test_check.h"
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+static std::string hex(const char* s) {
+    std::string out;
+    for (; s[0] && s[1]; s += 2) {
+        unsigned b;
+        sscanf(s, "%2x", &b);
+        out += (char)b;
+    }
+    return out;
+}
+
+// ============================================
+// HPACK
+// ============================================
+
+// Collects "name: value\n" lines
+struct HeaderList : HpackHandler {
+    std::string lines;
+
+    void onHeader(const char* name, size_t nameLen, const char* value, size_t valueLen) override {
+        lines.append(name, nameLen);
+        lines += ": ";
+        lines.append(value, valueLen);
+        lines += "\n";
+    }
+};
+
+static bool decodeBlock(HpackDecoder& d, const std::string& block, std::string& lines,
+                        size_t scratchCap = 256) {
+    char scratch[256];
+    HeaderList list;
+    bool ok = d.decode((const uint8_t*)block.data(), block.size(), scratch, scratchCap, list);
+    lines = list.lines;
+    return ok;
+}
+
+// C.3 (plain) and C.4 (Huffman): three requests on one connection
+static void testRfcRequests(bool huffman) {
+    static const char* const plain[3] = {
+        "828684410f7777772e6578616d706c652e636f6d",
+        "828684be58086e6f2d6361636865",
+        "828785bf400a637573746f6d2d6b65790c637573746f6d2d76616c7565"
+    };
+    static const char* const coded[3] = {
+        "828684418cf1e3c2e5f23a6ba0ab90f4ff",
+        "828684be5886a8eb10649cbf",
+        "828785bf408825a849e95ba97d7f8925a849e95bb8e8b4bf"
+    };
+    static const char* const expected[3] = {
+        ":method: GET\n:scheme: http\n:path: /\n:authority: www.example.com\n",
+        ":method: GET\n:scheme: http\n:path: /\n:authority: www.example.com\n"
+        "cache-control: no-cache\n",
+        ":method: GET\n:scheme: https\n:path: /index.html\n:authority: www.example.com\n"
+        "custom-key: custom-value\n"
+    };
+    static const size_t sizes[3] = { 57, 110, 164 };
+
+    HpackDecoder d;
+    for (int i = 0; i < 3; i++) {
+        std::string lines;
+        CHECK(decodeBlock(d, hex(huffman ? coded[i] : plain[i]), lines));
+        CHECK(lines == expected[i]);
+        CHECK(d.getTableSize() == sizes[i]);
+        CHECK(d.getEntryCount() == i + 1);
+    }
+}
+
+// C.5 (plain) and C.6 (Huffman): three responses with the table
+// limited to 256 bytes, so each one evicts
+static void testRfcResponses(bool huffman) {
+    static const char* const plain[3] = {
+        "4803333032580770726976617465611d4d6f6e2c203231204f637420323031332032303a31333a3231"
+        "20474d546e1768747470733a2f2f7777772e6578616d706c652e636f6d",
+        "4803333037c1c0bf",
+        "88c1611d4d6f6e2c203231204f637420323031332032303a31333a323220474d54c05a04677a6970"
+        "7738666f6f3d4153444a4b48514b425a584f5157454f50495541585157454f49553b206d61782d61"
+        "67653d333630303b2076657273696f6e3d31"
+    };
+    static const char* const coded[3] = {
+        "488264025885aec3771a4b6196d07abe941054d444a8200595040b8166e082a62d1bff6e919d29ad"
+        "171863c78f0b97c8e9ae82ae43d3",
+        "4883640effc1c0bf",
+        "88c16196d07abe941054d444a8200595040b8166e084a62d1bffc05a839bd9ab77ad94e7821dd7f2"
+        "e6c7b335dfdfcd5b3960d5af27087f3672c1ab270fb5291f9587316065c003ed4ee5b1063d5007"
+    };
+    static const char* const expected[3] = {
+        ":status: 302\ncache-control: private\ndate: Mon, 21 Oct 2013 20:13:21 GMT\n"
+        "location: https://www.example.com\n",
+        ":status: 307\ncache-control: private\ndate: Mon, 21 Oct 2013 20:13:21 GMT\n"
+        "location: https://www.example.com\n",
+        ":status: 200\ncache-control: private\ndate: Mon, 21 Oct 2013 20:13:22 GMT\n"
+        "location: https://www.example.com\ncontent-encoding: gzip\n"
+        "set-cookie: foo=ASDJKHQKBZXOQWEOPIUAXQWEOIU; max-age=3600; version=1\n"
+    };
+    static const size_t sizes[3] = { 222, 222, 215 };
+    static const int counts[3] = { 4, 4, 3 };
+    // Newest entry (index 62) after each response
+    static const char* const newest[3] = {
+        "location: https://www.example.com\n",
+        ":status: 307\n",
+        "set-cookie: foo=ASDJKHQKBZXOQWEOPIUAXQWEOIU; max-age=3600; version=1\n"
+    };
+
+    HpackDecoder d;
+    std::string lines;
+    CHECK(decodeBlock(d, hex("3fe101"), lines));   // Table size update to 256
+    CHECK(lines.empty());
+    for (int i = 0; i < 3; i++) {
+        CHECK(decodeBlock(d, hex(huffman ? coded[i] : plain[i]), lines));
+        CHECK(lines == expected[i]);
+        CHECK(d.getTableSize() == sizes[i]);
+        CHECK(d.getEntryCount() == counts[i]);
+        CHECK(decodeBlock(d, hex("be"), lines) && lines == newest[i]);
+    }
+    // The oldest entry left is the second date; past it is nothing
+    CHECK(decodeBlock(d, hex("c0"), lines) && lines == "date: Mon, 21 Oct 2013 20:13:22 GMT\n");
+    CHECK(!decodeBlock(d, hex("c1"), lines));
+}
+
+static bool huffman(const std::string& in, std::string& out, size_t cap = 64) {
+    char buf[64];
+    size_t n = 0;
+    bool ok = HpackDecoder::huffmanDecode((const uint8_t*)in.data(), in.size(), buf, cap, n);
+    out.assign(buf, n);
+    return ok;
+}
+
+static void testHuffman() {
+    std::string out;
+    CHECK(huffman(hex("f1e3c2e5f23a6ba0ab90f4ff"), out) && out == "www.example.com");
+    CHECK(huffman("", out) && out.empty());
+    CHECK(huffman(hex("1f"), out) && out == "a");           // 'a' is 00011, then 111
+
+    CHECK(!huffman(hex("18"), out));                         // Padded with zeros
+    CHECK(!huffman(hex("1c"), out));                         // Padding not all ones
+    CHECK(!huffman(hex("1fff"), out));                       // 11 bits of padding
+    CHECK(!huffman(hex("ff"), out));                         // A whole byte of it
+    CHECK(!huffman(hex("fffffffc"), out));                   // EOS (30 ones)
+    CHECK(!huffman(hex("1ffffffff0"), out));                 // EOS after a symbol
+    CHECK(!huffman(hex("f1e3c2e5f23a6ba0ab90f4ff"), out, 4)); // Doesn't fit
+
+    // The same cases inside a header block: literal name, coded value
+    HpackDecoder d;
+    std::string lines;
+    CHECK(decodeBlock(d, hex("0001788118"), lines) == false);
+    CHECK(decodeBlock(d, hex("00017884fffffffc"), lines) == false);
+    CHECK(decodeBlock(d, hex("000178811f"), lines) && lines == "x: a\n");
+    CHECK(d.getEntryCount() == 0);                           // Without indexing
+}
+
+static void testBadBlocks() {
+    std::string lines;
+    {
+        HpackDecoder d;
+        CHECK(!decodeBlock(d, hex("80"), lines));            // Index 0
+    }
+    {
+        HpackDecoder d;
+        CHECK(!decodeBlock(d, hex("be"), lines));            // 62: empty dynamic table
+        CHECK(decodeBlock(d, hex("bd"), lines) && lines == "www-authenticate: \n");
+        CHECK(!decodeBlock(d, hex("7e0178"), lines));        // Name index 62
+    }
+    {
+        HpackDecoder d;
+        CHECK(!decodeBlock(d, hex("ffffffffff0f"), lines));  // Index past 2^28
+        CHECK(!decodeBlock(d, hex("ff"), lines));            // Integer cut short
+        CHECK(!decodeBlock(d, hex("ff80"), lines));
+        CHECK(decodeBlock(d, "", lines) && lines.empty());   // Empty block is fine
+    }
+    {
+        HpackDecoder d;
+        CHECK(!decodeBlock(d, hex("00056162"), lines));      // Name of 5, 2 bytes left
+        CHECK(!decodeBlock(d, hex("0001610f"), lines));      // Value cut short
+        CHECK(!decodeBlock(d, hex("00"), lines));            // No name length
+        CHECK(!decodeBlock(d, hex("000161"), lines));        // No value
+        CHECK(!decodeBlock(d, hex("00017f"), lines));        // Value length cut short
+    }
+    {
+        // Huffman output larger than the scratch space
+        HpackDecoder d;
+        CHECK(!decodeBlock(d, hex("0001788cf1e3c2e5f23a6ba0ab90f4ff"), lines, 8));
+        // A dynamic name copied into scratch too small for it
+        CHECK(decodeBlock(d, hex("400a637573746f6d2d6b657901" "76"), lines));
+        CHECK(!decodeBlock(d, hex("7e0176"), lines, 4));
+        CHECK(decodeBlock(d, hex("7e0176"), lines) && lines == "custom-key: v\n");
+    }
+    {
+        // Size updates: up to what we advertised, no further
+        HpackDecoder d;
+        CHECK(decodeBlock(d, hex("3fe107"), lines));         // 1024
+        CHECK(!decodeBlock(d, hex("3fe207"), lines));        // 1025
+    }
+    {
+        // An entry bigger than the table empties it and isn't stored
+        HpackDecoder d;
+        CHECK(decodeBlock(d, hex("3f21" "40016101" "62"), lines));   // 64 bytes, a: b
+        CHECK(d.getEntryCount() == 1 && d.getTableSize() == 34);
+        std::string big = hex("40016b28") + std::string(40, 'v');
+        CHECK(decodeBlock(d, big, lines) && lines == "k: " + std::string(40, 'v') + "\n");
+        CHECK(d.getEntryCount() == 0 && d.getTableSize() == 0);
+        // Shrinking the table evicts as well
+        CHECK(decodeBlock(d, hex("40016101624001630164"), lines));
+        CHECK(d.getEntryCount() == 1 && d.getTableSize() == 34);   // c: d pushed out a: b
+        CHECK(decodeBlock(d, hex("20"), lines));
+        CHECK(d.getEntryCount() == 0 && d.getTableSize() == 0);
+    }
+}
+
+// ============================================
+// SCRIPTED SERVER
+// ============================================
+
+// Replays queued server bytes, at most maxRead per read(), and
+// keeps what the client wrote
+class ScriptClient : public Client {
+public:
+    std::string in;
+    size_t inPos = 0;
+    std::string out;
+    size_t maxRead = 1 << 20;
+    bool open = true;
+
+    void feed(const std::string& bytes) { in += bytes; }
+
+    int connect(IPAddress, uint16_t) override { return 1; }
+    int connect(const char*, uint16_t) override { return 1; }
+    size_t write(uint8_t b) override { return write(&b, 1); }
+    size_t write(const uint8_t* buf, size_t size) override {
+        if (!open) return 0;
+        out.append((const char*)buf, size);
+        return size;
+    }
+    int available() override { return (int)(in.size() - inPos); }
+    int read() override {
+        uint8_t b;
+        return read(&b, 1) == 1 ? b : -1;
+    }
+    int read(uint8_t* buf, size_t size) override {
+        size_t n = in.size() - inPos;
+        if (n == 0) return -1;
+        if (n > size) n = size;
+        if (n > maxRead) n = maxRead;
+        memcpy(buf, in.data() + inPos, n);
+        inPos += n;
+        return (int)n;
+    }
+    int peek() override { return inPos < in.size() ? (uint8_t)in[inPos] : -1; }
+    void flush() override {}
+    void stop() override { open = false; }
+    uint8_t connected() override { return open; }
+    operator bool() override { return open; }
+};
+
+struct Frame {
+    uint8_t type;
+    uint8_t flags;
+    uint32_t stream;
+    std::string payload;
+};
+
+static std::string frame(uint8_t type, uint8_t flags, uint32_t stream, const std::string& payload) {
+    uint32_t len = (uint32_t)payload.size();
+    std::string f;
+    f += (char)(len >> 16);
+    f += (char)(len >> 8);
+    f += (char)len;
+    f += (char)type;
+    f += (char)flags;
+    f += (char)(stream >> 24);
+    f += (char)(stream >> 16);
+    f += (char)(stream >> 8);
+    f += (char)stream;
+    return f + payload;
+}
+
+static std::string be32(uint32_t v) {
+    std::string s;
+    s += (char)(v >> 24);
+    s += (char)(v >> 16);
+    s += (char)(v >> 8);
+    s += (char)v;
+    return s;
+}
+
+static uint32_t be32(const std::string& s, size_t at) {
+    const uint8_t* p = (const uint8_t*)s.data() + at;
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+// Frames the client sent, after the preface
+static std::vector<Frame> sent(const ScriptClient& c) {
+    std::vector<Frame> frames;
+    size_t pos = c.out.compare(0, 3, "PRI") == 0 ? 24 : 0;
+    while (pos + 9 <= c.out.size()) {
+        const uint8_t* h = (const uint8_t*)c.out.data() + pos;
+        uint32_t len = ((uint32_t)h[0] << 16) | ((uint32_t)h[1] << 8) | h[2];
+        Frame f = { h[3], h[4], be32(c.out, pos + 5) & 0x7FFFFFFF, c.out.substr(pos + 9, len) };
+        frames.push_back(f);
+        pos += 9 + len;
+    }
+    return frames;
+}
+
+// Error code of the GOAWAY the client sent, -1 if none
+static long goawayCode(const ScriptClient& c) {
+    for (const Frame& f : sent(c)) {
+        if (f.type == H2_GOAWAY && f.payload.size() >= 8) return be32(f.payload, 4);
+    }
+    return -1;
+}
+
+static long rstCode(const ScriptClient& c, uint32_t stream) {
+    for (const Frame& f : sent(c)) {
+        if (f.type == H2_RST_STREAM && f.stream == stream) return be32(f.payload, 0);
+    }
+    return -1;
+}
+
+// Keeps the response headers it decodes
+class TapConnection : public H2Connection {
+public:
+    HeaderList seen;
+
+    void onHeader(const char* name, size_t nameLen, const char* value, size_t valueLen) override {
+        seen.onHeader(name, nameLen, value, valueLen);
+        H2Connection::onHeader(name, nameLen, value, valueLen);
+    }
+};
+
+static bool connectTo(H2Connection& h2, ScriptClient& c, int streams = 2, size_t window = 4096) {
+    resetHal();
+    c.feed(frame(H2_SETTINGS, 0, 0, ""));
+    h2.setLimits(streams, window);
+    return h2.begin(c, "example.com", nullptr, false, 100);
+}
+
+// Polls until the script is used up or the connection fails
+static void drain(H2Connection& h2, ScriptClient& c) {
+    for (int i = 0; i < 1000 && c.available() > 0 && h2.isOpen(); i++) {
+        h2.poll(0);
+    }
+}
+
+static std::string readAll(H2Stream& s) {
+    std::string body;
+    uint8_t buf[512];
+    int n;
+    while ((n = s.read(buf, sizeof(buf))) > 0) body.append((const char*)buf, n);
+    return body;
+}
+
+// Plays the script on a fresh connection with `requests` open
+// streams: the GOAWAY code it failed with, -1 if it stayed open
+static long connectionError(const std::string& script, size_t chunk = 1 << 20, int requests = 1) {
+    ScriptClient c;
+    c.maxRead = chunk;
+    H2Connection h2;
+    if (!connectTo(h2, c)) return -2;
+    for (int i = 0; i < requests; i++) {
+        if (!h2.request("GET", "/")) return -2;
+    }
+    c.feed(script);
+    drain(h2, c);
+    return h2.isOpen() ? -1 : goawayCode(c);
+}
+
+// ============================================
+// FRAMES
+// ============================================
+
+static void testPadded(size_t chunk) {
+    ScriptClient c;
+    c.maxRead = chunk;
+    H2Connection h2;
+    CHECK(connectTo(h2, c));
+    H2Stream* a = h2.request("GET", "/a");
+    H2Stream* b = h2.request("GET", "/b");
+    CHECK(a && b && a->getId() == 1 && b->getId() == 3);
+
+    // Pad length 3 around :status 200; then priority and padding
+    c.feed(frame(H2_HEADERS, H2_FLAG_PADDED | H2_FLAG_END_HEADERS, 1,
+                 hex("03" "88" "000000")));
+    c.feed(frame(H2_HEADERS, H2_FLAG_PADDED | H2_FLAG_PRIORITY | H2_FLAG_END_HEADERS, 3,
+                 hex("02" "0000000010" "8d" "0000")));
+    c.feed(frame(H2_DATA, H2_FLAG_PADDED | H2_FLAG_END_STREAM, 1, hex("04") + "hello" + hex("00000000")));
+    c.feed(frame(H2_DATA, H2_FLAG_PADDED | H2_FLAG_END_STREAM, 3, hex("00") + "bye"));
+    drain(h2, c);
+    CHECK(h2.isOpen());
+    CHECK(a->awaitStatus(0) == 200);
+    CHECK(b->awaitStatus(0) == 404);
+    CHECK(readAll(*a) == "hello" && a->isFinished());
+    CHECK(readAll(*b) == "bye" && b->isFinished());
+    a->stop();
+    b->stop();
+
+    // Padding that doesn't fit in the frame, or no room for its length
+    CHECK(connectionError(frame(H2_DATA, H2_FLAG_PADDED, 1, hex("05") + "abcd"), chunk) ==
+          H2_PROTOCOL_ERROR);
+    CHECK(connectionError(frame(H2_HEADERS, H2_FLAG_PADDED | H2_FLAG_END_HEADERS, 1,
+                                hex("03" "88" "00")), chunk) == H2_PROTOCOL_ERROR);
+    CHECK(connectionError(frame(H2_HEADERS, H2_FLAG_PADDED | H2_FLAG_END_HEADERS, 1, ""), chunk) ==
+          H2_PROTOCOL_ERROR);
+    CHECK(connectionError(frame(H2_HEADERS, H2_FLAG_PRIORITY | H2_FLAG_END_HEADERS, 1,
+                                hex("00000000")), chunk) == H2_PROTOCOL_ERROR);
+}
+
+static void testContinuation(size_t chunk) {
+    // :status 200, then x-request-id: abc (incremental indexing),
+    // split across three frames mid-string
+    std::string block = hex("88" "400c") + "x-request-id" + hex("03") + "abc";
+
+    ScriptClient c;
+    c.maxRead = chunk;
+    TapConnection h2;
+    CHECK(connectTo(h2, c));
+    H2Stream* s = h2.request("GET", "/");
+    CHECK(s != nullptr);
+    c.feed(frame(H2_HEADERS, H2_FLAG_END_STREAM, 1, block.substr(0, 5)));
+    c.feed(frame(H2_CONTINUATION, 0, 1, block.substr(5, 6)));
+    c.feed(frame(H2_CONTINUATION, H2_FLAG_END_HEADERS, 1, block.substr(11)));
+    drain(h2, c);
+    CHECK(h2.isOpen());
+    CHECK(s->awaitStatus(0) == 200);
+    CHECK(h2.seen.lines == ":status: 200\nx-request-id: abc\n");
+    CHECK(s->isFinished());
+    s->stop();
+
+    // The next block refers to the entry the first one added
+    H2Stream* t = h2.request("GET", "/");
+    CHECK(t && t->getId() == 3);
+    h2.seen.lines.clear();
+    c.feed(frame(H2_HEADERS, H2_FLAG_END_HEADERS, 3, hex("88be")));
+    drain(h2, c);
+    CHECK(h2.seen.lines == ":status: 200\nx-request-id: abc\n");
+    t->stop();
+
+    // Anything else between HEADERS and its last CONTINUATION
+    std::string open = frame(H2_HEADERS, 0, 1, block.substr(0, 5));
+    CHECK(connectionError(open + frame(H2_PING, 0, 0, std::string(8, '\0')), chunk, 2) ==
+          H2_PROTOCOL_ERROR);
+    CHECK(connectionError(open + frame(H2_CONTINUATION, H2_FLAG_END_HEADERS, 3, block.substr(5)),
+                          chunk, 2) == H2_PROTOCOL_ERROR);
+    CHECK(connectionError(open + frame(H2_HEADERS, H2_FLAG_END_HEADERS, 1, block.substr(5)),
+                          chunk, 2) == H2_PROTOCOL_ERROR);
+    CHECK(connectionError(open + frame(H2_CONTINUATION, H2_FLAG_END_HEADERS, 1, block.substr(5)),
+                          chunk, 2) == -1);
+
+    // CONTINUATION with no HEADERS before it, or after END_HEADERS
+    CHECK(connectionError(frame(H2_CONTINUATION, H2_FLAG_END_HEADERS, 1, hex("88")), chunk) ==
+          H2_PROTOCOL_ERROR);
+    CHECK(connectionError(frame(H2_HEADERS, H2_FLAG_END_HEADERS, 1, hex("88")) +
+                          frame(H2_CONTINUATION, H2_FLAG_END_HEADERS, 1, hex("88")), chunk) ==
+          H2_PROTOCOL_ERROR);
+
+    // A block that grows past half the connection buffer
+    CHECK(connectionError(frame(H2_HEADERS, 0, 1, std::string(4000, '\x88')) +
+                          frame(H2_CONTINUATION, 0, 1, std::string(4000, '\x88')) +
+                          frame(H2_CONTINUATION, H2_FLAG_END_HEADERS, 1, std::string(4000, '\x88')),
+                          chunk) == H2_INTERNAL_ERROR);
+
+    // A block HPACK rejects
+    CHECK(connectionError(frame(H2_HEADERS, H2_FLAG_END_HEADERS, 1, hex("be")), chunk) ==
+          H2_COMPRESSION_ERROR);
+}
+
+// ============================================
+// FLOW CONTROL
+// ============================================
+
+static void testWindowUpdate() {
+    // On the connection: a connection error
+    CHECK(connectionError(frame(H2_WINDOW_UPDATE, 0, 0, be32(0))) == H2_PROTOCOL_ERROR);
+    CHECK(connectionError(frame(H2_WINDOW_UPDATE, 0, 0, be32(0x7FFFFFFF))) ==   // 65535 + 2^31-1
+          H2_FLOW_CONTROL_ERROR);
+    CHECK(connectionError(frame(H2_WINDOW_UPDATE, 0, 0, hex("000001"))) == H2_FRAME_SIZE_ERROR);
+
+    // On a stream: that stream is reset, the connection carries on
+    static const uint32_t increments[2] = { 0, 0x7FFFFFFF };
+    static const uint32_t codes[2] = { H2_PROTOCOL_ERROR, H2_FLOW_CONTROL_ERROR };
+    for (int i = 0; i < 2; i++) {
+        ScriptClient c;
+        H2Connection h2;
+        CHECK(connectTo(h2, c));
+        H2Stream* s = h2.request("GET", "/");
+        CHECK(s != nullptr);
+        c.feed(frame(H2_WINDOW_UPDATE, 0, 1, be32(increments[i])));
+        drain(h2, c);
+        CHECK(h2.isOpen() && goawayCode(c) == -1);
+        CHECK(rstCode(c, 1) == codes[i] && s->getErrorCode() == codes[i]);
+        CHECK(s->awaitStatus(0) == -1);
+    }
+
+    // Right up to 2^31-1 is allowed; the reserved bit is ignored
+    ScriptClient c;
+    H2Connection h2;
+    CHECK(connectTo(h2, c));
+    CHECK(h2.request("GET", "/") != nullptr);
+    c.feed(frame(H2_WINDOW_UPDATE, 0, 0, be32(0x7FFFFFFF - 65535)));
+    c.feed(frame(H2_WINDOW_UPDATE, 0, 1, be32(0x80000000u | (0x7FFFFFFF - 65535))));
+    c.feed(frame(H2_WINDOW_UPDATE, 0, 7, be32(1)));   // No such stream: ignored
+    drain(h2, c);
+    CHECK(h2.isOpen() && goawayCode(c) == -1 && rstCode(c, 1) == -1);
+}
+
+static void testReceiveWindow() {
+    // A full stream window is fine; one byte past it resets the stream
+    {
+        ScriptClient c;
+        H2Connection h2;
+        CHECK(connectTo(h2, c, 2, 4096));
+        H2Stream* a = h2.request("GET", "/a");
+        H2Stream* b = h2.request("GET", "/b");
+        CHECK(a && b);
+        c.feed(frame(H2_DATA, 0, 1, std::string(4096, 'a')));
+        c.feed(frame(H2_DATA, 0, 3, std::string(4097, 'b')));
+        drain(h2, c);
+        CHECK(h2.isOpen() && goawayCode(c) == -1);
+        CHECK(a->available() == 4096 && rstCode(c, 1) == -1);
+        CHECK(rstCode(c, 3) == H2_FLOW_CONTROL_ERROR);
+        CHECK(b->getErrorCode() == H2_FLOW_CONTROL_ERROR && b->available() == 0);
+
+        // Reading gives the stream its window back
+        CHECK(readAll(*a) == std::string(4096, 'a'));
+        uint32_t credited = 0;
+        for (const Frame& f : sent(c)) {
+            if (f.type == H2_WINDOW_UPDATE && f.stream == 1) credited += be32(f.payload, 0);
+        }
+        CHECK(credited == 4096);
+        c.feed(frame(H2_DATA, H2_FLAG_END_STREAM, 1, std::string(4096, 'a')));
+        drain(h2, c);
+        CHECK(h2.isOpen() && rstCode(c, 1) == -1);
+        CHECK(readAll(*a).size() == 4096 && a->isFinished());
+    }
+
+    // Four full rings use the whole connection window; the next byte
+    // is a connection error even though it is for a stream
+    {
+        ScriptClient c;
+        H2Connection h2;
+        CHECK(connectTo(h2, c, 4, 16384));
+        H2Stream* s[4];
+        for (int i = 0; i < 4; i++) {
+            s[i] = h2.request("GET", "/");
+            CHECK(s[i] != nullptr);
+            c.feed(frame(H2_DATA, 0, 1 + 2 * i, std::string(16384, (char)('0' + i))));
+        }
+        drain(h2, c);
+        CHECK(h2.isOpen());
+        for (int i = 0; i < 4; i++) CHECK(s[i] && s[i]->available() == 16384);
+        c.feed(frame(H2_DATA, 0, 1, "x"));
+        drain(h2, c);
+        CHECK(!h2.isOpen() && goawayCode(c) == H2_FLOW_CONTROL_ERROR);
+    }
+
+    // Over the largest frame we allow, and DATA on stream 0
+    CHECK(connectionError(frame(H2_DATA, 0, 1, std::string(16385, 'z'))) == H2_FRAME_SIZE_ERROR);
+    CHECK(connectionError(frame(H2_DATA, 0, 0, "z")) == H2_PROTOCOL_ERROR);
+}
+
+int main() {
+    static const PoolBucketConfig layout[] = {
+        { "h2", 16384, 5, MEM_CAP_INTERNAL, MEM_CAP_NONE }
+    };
+    CHECK(memPools().begin(layout, 1));
+    Serial.quiet = true;         // h2_client.h logs through Serial
+
+    testRfcRequests(false);
+    testRfcRequests(true);
+    testRfcResponses(false);
+    testRfcResponses(true);
+    testHuffman();
+    testBadBlocks();
+    testPadded(1 << 20);
+    testPadded(1);
+    testContinuation(1 << 20);
+    testContinuation(1);
+    testWindowUpdate();
+    testReceiveWindow();
+
+    return testSummary();
+}
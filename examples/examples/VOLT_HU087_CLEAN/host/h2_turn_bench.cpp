@@ -0,0 +1,438 @@
+/*
+ * ============================================
+ * HTTP/2 Turn Benchmark (host)
+ * ============================================
+ *
+ * Plays full conversation turns (upload speech,
+ * get a reply, speak it) against the local
+ * stand-in server and compares:
+ *
+ *   http1      a new connection per request,
+ *              one TTS request (today's firmware)
+ *   h2-serial  one kept-alive HTTP/2 connection,
+ *              same requests one at a time
+ *   h2-mux     one HTTP/2 connection, the reply
+ *              spoken sentence by sentence with
+ *              the next TTS streams prefetched
+ *              while the current one plays
+ *
+ * The speaker is simulated at 24 kHz pcm16 with
+ * an I2S-sized DMA queue, so prefetched audio is
+ * held back by flow control exactly like on the
+ * watch.
+ *
+ * Build and run (from this directory):
+ *   g++ -std=c++17 -O2 -I. -I.. h2_turn_bench.cpp -o h2_turn_bench
+ *   python3 h2_bench_server.py &
+ *   ./h2_turn_bench --turns 10
+ *
+ * ============================================
+ */
+
+#include "Arduino.h"
+#include "posix_client.h"
+#include "../mem_pools.h"
+#include "../h2_client.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// Same budget the watch reserves (see config_stone_FINAL.h)
+static const int H2_MAX_STREAMS = 3;
+static const int H2_STREAM_WINDOW = 16 * 1024;
+
+static const size_t STT_AUDIO_BYTES = 16000 * 2 * 5;   // 5 s @ 16 kHz
+static const double PCM_BYTES_PER_SEC = 24000 * 2;
+static const double DMA_QUEUE_SEC = 8 * 1024 / 24000.0; // dma_buf_count * dma_buf_len
+
+static double nowSec() {
+    return micros() / 1e6;
+}
+
+// ============================================
+// SIMULATED SPEAKER
+// ============================================
+
+struct Speaker {
+    double turnStart;
+    double freeAt;       // When the queued audio finishes
+    double firstAudio;
+    double gaps;         // Silence after the first sample (underruns)
+    bool started;
+
+    void begin(double start) {
+        turnStart = start;
+        freeAt = 0;
+        firstAudio = 0;
+        gaps = 0;
+        started = false;
+    }
+
+    void play(size_t bytes) {
+        double now = nowSec();
+        if (!started) {
+            started = true;
+            firstAudio = now - turnStart;
+            freeAt = now;
+        } else if (now > freeAt) {
+            gaps += now - freeAt;
+            freeAt = now;
+        }
+        freeAt += bytes / PCM_BYTES_PER_SEC;
+
+        // i2s_write blocks once the DMA queue is full
+        double ahead = freeAt - now - DMA_QUEUE_SEC;
+        if (ahead > 0) usleep((useconds_t)(ahead * 1e6));
+    }
+
+    double finish() {
+        double now = nowSec();
+        return (freeAt > now ? freeAt : now) - turnStart;
+    }
+};
+
+struct TurnResult {
+    double firstAudio;
+    double total;
+    double gaps;
+    int connections;
+};
+
+// ============================================
+// REQUEST HELPERS
+// ============================================
+
+static const char* host = "127.0.0.1";
+static uint16_t port = 8090;
+static uint8_t audio[STT_AUDIO_BYTES];
+
+static std::string jsonEscape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+static std::string extractString(const std::string& json, const char* key) {
+    std::string pattern = std::string("\"") + key + "\": \"";
+    size_t p = json.find(pattern);
+    if (p == std::string::npos) return "";
+    p += pattern.size();
+    std::string out;
+    while (p < json.size() && json[p] != '"') {
+        if (json[p] == '\\' && p + 1 < json.size()) p++;
+        out += json[p++];
+    }
+    return out;
+}
+
+static std::string chatBody(const std::string& text) {
+    return "{\"model\":\"gpt-4o-mini\",\"max_tokens\":150,\"messages\":["
+           "{\"role\":\"system\",\"content\":\"You are VOLT, a friendly helper for Stone.\"},"
+           "{\"role\":\"user\",\"content\":\"" + jsonEscape(text) + "\"}]}";
+}
+
+static std::string speechBody(const std::string& text) {
+    return "{\"model\":\"tts-1\",\"voice\":\"echo\",\"response_format\":\"pcm\",\"input\":\"" +
+           jsonEscape(text) + "\"}";
+}
+
+static const char* BOUNDARY = "----VoltBenchBoundary";
+
+static std::string multipartHead() {
+    return std::string("--") + BOUNDARY + "\r\n"
+           "Content-Disposition: form-data; name=\"model\"\r\n\r\nwhisper-1\r\n"
+           "--" + BOUNDARY + "\r\n"
+           "Content-Disposition: form-data; name=\"file\"; filename=\"audio.wav\"\r\n"
+           "Content-Type: audio/wav\r\n\r\n";
+}
+
+static std::string multipartTail() {
+    return std::string("\r\n--") + BOUNDARY + "--\r\n";
+}
+
+// Split on sentence ends, keeping pieces at least minChars long
+static std::vector<std::string> splitSentences(const std::string& text, size_t minChars) {
+    std::vector<std::string> out;
+    size_t start = 0;
+    for (size_t i = 0; i + 1 < text.size(); i++) {
+        char c = text[i];
+        if ((c == '.' || c == '!' || c == '?') && text[i + 1] == ' ' && i + 1 - start >= minChars) {
+            out.push_back(text.substr(start, i + 1 - start));
+            start = i + 2;
+        }
+    }
+    if (start < text.size()) out.push_back(text.substr(start));
+    return out;
+}
+
+// ============================================
+// HTTP/1.1 (one connection per request)
+// ============================================
+
+// Send one request, return the status; the body goes to out or the speaker
+static int http1Request(const char* path, const char* contentType,
+                        const std::vector<std::pair<const uint8_t*, size_t>>& body,
+                        std::string* out, Speaker* speaker) {
+    PosixClient client;
+    if (!client.connect(host, port)) return -1;
+
+    size_t length = 0;
+    for (auto& part : body) length += part.second;
+    char head[512];
+    snprintf(head, sizeof(head),
+        "POST %s HTTP/1.1\r\nHost: api.openai.com\r\nAuthorization: Bearer sk-bench\r\n"
+        "Content-Type: %s\r\nContent-Length: %u\r\nConnection: close\r\n\r\n",
+        path, contentType, (unsigned)length);
+    client.write((const uint8_t*)head, strlen(head));
+    for (auto& part : body) client.write(part.first, part.second);
+
+    // Response head
+    std::string line;
+    int status = -1;
+    bool headDone = false;
+    uint8_t buf[2048];
+    while (client.connected() || client.available() > 0) {
+        int n = client.read(buf, headDone ? sizeof(buf) : 1);
+        if (n <= 0) {
+            usleep(200);
+            continue;
+        }
+        if (!headDone) {
+            char c = (char)buf[0];
+            if (c == '\n') {
+                if (status < 0 && line.compare(0, 5, "HTTP/") == 0) status = atoi(line.c_str() + 9);
+                if (line.empty() || line == "\r") headDone = true;
+                line.clear();
+            } else {
+                line += c;
+            }
+            continue;
+        }
+        if (speaker) {
+            speaker->play(n);
+        } else if (out) {
+            out->append((const char*)buf, n);
+        }
+    }
+    client.stop();
+    return status;
+}
+
+static TurnResult runHttp1Turn() {
+    TurnResult r = { 0, 0, 0, 0 };
+    Speaker speaker;
+    speaker.begin(nowSec());
+
+    std::string head = multipartHead();
+    std::string tail = multipartTail();
+    std::string contentType = std::string("multipart/form-data; boundary=") + BOUNDARY;
+    std::string response;
+    http1Request("/v1/audio/transcriptions", contentType.c_str(),
+        { { (const uint8_t*)head.data(), head.size() }, { audio, sizeof(audio) },
+          { (const uint8_t*)tail.data(), tail.size() } }, &response, nullptr);
+    std::string text = extractString(response, "text");
+
+    std::string chat = chatBody(text);
+    response.clear();
+    http1Request("/v1/chat/completions", "application/json",
+        { { (const uint8_t*)chat.data(), chat.size() } }, &response, nullptr);
+    std::string reply = extractString(response, "content");
+
+    std::string speech = speechBody(reply);
+    http1Request("/v1/audio/speech", "application/json",
+        { { (const uint8_t*)speech.data(), speech.size() } }, nullptr, &speaker);
+
+    r.connections = 3;
+    r.firstAudio = speaker.firstAudio;
+    r.gaps = speaker.gaps;
+    r.total = speaker.finish();
+    return r;
+}
+
+// ============================================
+// HTTP/2
+// ============================================
+
+static PosixClient h2Socket;
+static H2Connection h2;
+
+static bool ensureH2(int& connections) {
+    if (h2.canRequest()) return true;
+    if (!h2Socket.connect(host, port)) return false;
+    connections++;
+    return h2.begin(h2Socket, "api.openai.com", "Bearer sk-bench", false);
+}
+
+static std::string h2Fetch(const char* path, const char* contentType,
+                           const std::vector<std::pair<const uint8_t*, size_t>>& body) {
+    size_t length = 0;
+    for (auto& part : body) length += part.second;
+    H2Stream* s = h2.request("POST", path, contentType, (long)length);
+    if (!s) return "";
+    for (auto& part : body) s->write(part.first, part.second);
+    std::string out;
+    if (s->awaitStatus(30000) == 200) {
+        uint8_t buf[1024];
+        while (s->connected()) {
+            int n = s->read(buf, sizeof(buf));
+            if (n > 0) {
+                out.append((const char*)buf, n);
+            } else {
+                h2.poll(2);
+            }
+        }
+    }
+    s->stop();
+    return out;
+}
+
+static H2Stream* h2Speech(const std::string& text) {
+    std::string body = speechBody(text);
+    H2Stream* s = h2.request("POST", "/v1/audio/speech", "application/json", (long)body.size());
+    if (s) s->write((const uint8_t*)body.data(), body.size());
+    return s;
+}
+
+static void playStream(H2Stream* s, Speaker& speaker) {
+    if (!s || s->awaitStatus(30000) != 200) {
+        if (s) s->stop();
+        return;
+    }
+    uint8_t buf[2048];
+    while (s->connected()) {
+        int n = s->read(buf, sizeof(buf));
+        if (n > 0) {
+            speaker.play(n);
+        } else {
+            h2.poll(2);
+        }
+    }
+    s->stop();
+}
+
+static TurnResult runH2Turn(bool multiplex) {
+    TurnResult r = { 0, 0, 0, 0 };
+    Speaker speaker;
+    speaker.begin(nowSec());
+    if (!ensureH2(r.connections)) {
+        printf("h2 connect failed\n");
+        return r;
+    }
+
+    std::string head = multipartHead();
+    std::string tail = multipartTail();
+    std::string contentType = std::string("multipart/form-data; boundary=") + BOUNDARY;
+    std::string text = extractString(h2Fetch("/v1/audio/transcriptions", contentType.c_str(),
+        { { (const uint8_t*)head.data(), head.size() }, { audio, sizeof(audio) },
+          { (const uint8_t*)tail.data(), tail.size() } }), "text");
+
+    std::string chat = chatBody(text);
+    std::string reply = extractString(h2Fetch("/v1/chat/completions", "application/json",
+        { { (const uint8_t*)chat.data(), chat.size() } }), "content");
+
+    if (!multiplex) {
+        playStream(h2Speech(reply), speaker);
+    } else {
+        // Keep every free stream busy with the next sentences
+        std::vector<std::string> parts = splitSentences(reply, 60);
+        std::vector<H2Stream*> inFlight;
+        size_t next = 0;
+        for (size_t i = 0; i < parts.size(); i++) {
+            while (next < parts.size() && h2.freeStreams() > 0) {
+                inFlight.push_back(h2Speech(parts[next++]));
+            }
+            playStream(inFlight[i], speaker);
+        }
+    }
+
+    r.firstAudio = speaker.firstAudio;
+    r.gaps = speaker.gaps;
+    r.total = speaker.finish();
+    return r;
+}
+
+// ============================================
+// MAIN
+// ============================================
+
+static double percentile(std::vector<double> v, double p) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    size_t i = (size_t)(p * (v.size() - 1) + 0.5);
+    return v[i];
+}
+
+int main(int argc, char** argv) {
+    int turns = 5;
+    bool json = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--turns") && i + 1 < argc) turns = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--host") && i + 1 < argc) host = argv[++i];
+        else if (!strcmp(argv[i], "--port") && i + 1 < argc) port = (uint16_t)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--json")) json = true;
+        else {
+            printf("usage: %s [--turns N] [--host H] [--port P] [--json]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // Connection block plus one ring per stream, as on the watch
+    static const PoolBucketConfig layout[] = {
+        { "h2", H2_STREAM_WINDOW, H2_MAX_STREAMS + 1, MEM_CAP_SPIRAM, MEM_CAP_INTERNAL }
+    };
+    memPools().begin(layout, 1);
+    h2.setLimits(H2_MAX_STREAMS, H2_STREAM_WINDOW);
+
+    const char* modes[3] = { "http1", "h2-serial", "h2-mux" };
+    std::vector<TurnResult> results[3];
+    for (int m = 0; m < 3; m++) {
+        h2.end();   // Each HTTP/2 mode pays for its own first connection
+        for (int t = 0; t < turns; t++) {
+            results[m].push_back(m == 0 ? runHttp1Turn() : runH2Turn(m == 2));
+        }
+    }
+
+    if (json) printf("{");
+    for (int m = 0; m < 3; m++) {
+        std::vector<double> first, total, gaps;
+        int connections = 0;
+        for (auto& r : results[m]) {
+            first.push_back(r.firstAudio * 1000);
+            total.push_back(r.total * 1000);
+            gaps.push_back(r.gaps * 1000);
+            connections += r.connections;
+        }
+        if (json) {
+            printf("%s\"%s\":{\"turns\":%d,\"connections\":%d,"
+                   "\"first_audio_ms\":{\"p50\":%.1f,\"p95\":%.1f},"
+                   "\"turn_ms\":{\"p50\":%.1f,\"p95\":%.1f},"
+                   "\"gap_ms\":{\"p50\":%.1f,\"p95\":%.1f}}",
+                m ? "," : "", modes[m], turns, connections,
+                percentile(first, 0.5), percentile(first, 0.95),
+                percentile(total, 0.5), percentile(total, 0.95),
+                percentile(gaps, 0.5), percentile(gaps, 0.95));
+        } else {
+            if (m == 0) {
+                printf("%-10s %18s %18s %14s %6s\n", "mode", "first audio p50/95", "turn p50/95", "gaps p50", "conns");
+            }
+            printf("%-10s %8.0f / %5.0f ms %8.0f / %5.0f ms %11.0f ms %6d\n", modes[m],
+                percentile(first, 0.5), percentile(first, 0.95),
+                percentile(total, 0.5), percentile(total, 0.95),
+                percentile(gaps, 0.5), connections);
+        }
+    }
+    if (json) printf("}\n");
+
+    H2Stats s = h2.getStats();
+    if (!json) {
+        printf("h2: %u streams, %u frames in, %u frames out, %u window updates\n",
+            (unsigned)s.streamsOpened, (unsigned)s.framesIn, (unsigned)s.framesOut,
+            (unsigned)s.windowUpdatesSent);
+    }
+    h2.end();
+    return 0;
+}
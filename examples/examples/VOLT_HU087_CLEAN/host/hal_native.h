@@ -0,0 +1,759 @@
+/*
+ * ============================================
+ * Native HAL - Linux Backend for volt_hal.h
+ * ============================================
+ *
+ * Handles:
+ * - Time: real or virtual clock (native_clock.h)
+ * - Logging to stdout, with a quiet switch
+ * - GPIO as a pin table tests can drive; a
+ *   write that changes a level runs the pin's
+ *   change handler, as the interrupt would
+ * - I2S microphone read from a WAV file
+ * - I2S speaker with a modeled DMA queue:
+ *   writes block while it is full, underruns
+ *   are counted, audio can be saved to a file
+ * - Sockets/TLS (native_net.h), routes and
+ *   network impairment (net_impair.h)
+ * - TCP server sockets on the loopback or any
+ *   interface (device API tests, load bench)
+ * - Filesystem under a host directory
+ * - Heap regions as deterministic first-fit
+ *   arenas (native_heap.h)
+ * - Light and deep sleep recorded instead of
+ *   entered; the wake cause a test boots with
+ * - A scripted task table for halTaskSnapshot()
+ * - Queues that threads can block on; with a
+ *   virtual clock a wait passes its timeout at
+ *   once, so single-threaded tests never hang
+ * - Core ids per thread (nativeCoreId())
+ * - Arduino GPIO calls for shared headers
+ *   that use them directly (phase 1)
+ *
+ * Everything a test sets or inspects lives in
+ * nativeHal(); call nativeHal().reset() between
+ * tests.
+ *
+ * ============================================
+ */
+
+#ifndef HAL_NATIVE_H
+#define HAL_NATIVE_H
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/select.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include "Arduino.h"
+#include "native_clock.h"
+#include "native_net.h"
+#include "native_heap.h"
+
+// ============================================
+// STATE
+// ============================================
+
+struct NativeSpeakerStats {
+    uint64_t bytesPlayed;
+    uint32_t underruns;          // Queue ran dry mid-playback
+    uint64_t underrunMs;         // Silence heard because of it
+    uint64_t firstWriteUs;       // Clock time of the first sample (0 = none yet)
+};
+
+class NativeHal {
+public:
+    static const int PIN_COUNT = 64;
+
+    // I2S DMA queue the speaker plays from (8 x 1024 samples, as configured on the watch)
+    static const size_t SPEAKER_QUEUE_BYTES = 8 * 1024 * 2;
+
+    bool quiet;                  // Drop halLog() output
+    bool netUp;                  // What halNetConnected() reports
+    int rssi;                    // What WiFi.RSSI() reports (WiFi.h shim)
+    bool psram;                  // What halPsramInit() reports
+    bool paceMic;                // Mic reads take real (or virtual) recording time
+    bool paceSpeaker;            // Speaker plays in real time (off: writes never block)
+    char fsRoot[128];
+
+    int pinModes[PIN_COUNT];
+    int pinLevels[PIN_COUNT];
+    int analogLevels[PIN_COUNT];
+    HalPinFn pinChange[PIN_COUNT];
+    void* pinChangeArg[PIN_COUNT];
+    int deepSleeps;
+    int wakePin;
+    HalWakeCause wakeCause;      // What halWakeCause() reports
+    int lightSleepPin;           // halLightSleepBegin() (-1 = off)
+    bool sleepBlocked;           // halLightSleepBlock()
+
+    // Microphone source: 16-bit mono PCM, zeros once it runs out
+    uint8_t* micPcm;
+    size_t micLen;
+    size_t micPos;
+    int micRate;
+
+    // Speaker model
+    int speakerRate;
+    uint64_t playbackBytes;      // Since the last halI2sBegin(speaker)
+    uint64_t queueBytes;
+    uint64_t queueUpdatedUs;
+    NativeSpeakerStats speaker;
+    FILE* speakerOut;
+
+    // What halTaskSnapshot() reports; tests add tasks and advance
+    // their runTime and taskRunTime between samples
+    HalTaskInfo tasks[HAL_MAX_TASKS];
+    int taskCount;
+    uint32_t taskRunTime;
+
+    NativeHal() : micPcm(nullptr), speakerOut(nullptr) {
+        reset();
+    }
+
+    void reset() {
+        quiet = false;
+        netUp = true;
+        rssi = -60;
+        psram = true;
+        paceMic = false;
+        paceSpeaker = true;
+        strcpy(fsRoot, "volt_fs");
+        for (int i = 0; i < PIN_COUNT; i++) {
+            pinModes[i] = INPUT;
+            pinLevels[i] = HIGH;     // Buttons idle high (pull-ups)
+            analogLevels[i] = 0;
+            pinChange[i] = nullptr;
+            pinChangeArg[i] = nullptr;
+        }
+        deepSleeps = 0;
+        wakePin = -1;
+        wakeCause = HAL_WAKE_POWER_ON;
+        lightSleepPin = -1;
+        sleepBlocked = false;
+        free(micPcm);
+        micPcm = nullptr;
+        micLen = micPos = 0;
+        micRate = 0;
+        speakerRate = 0;
+        playbackBytes = 0;
+        queueBytes = 0;
+        queueUpdatedUs = 0;
+        memset(&speaker, 0, sizeof(speaker));
+        setSpeakerFile(nullptr);
+        memset(tasks, 0, sizeof(tasks));
+        taskCount = 0;
+        taskRunTime = 0;
+        nativeRoutes().clear();
+        nativeNetImpairment().clear();
+    }
+
+    // Returns the task's index in tasks[] (-1 when full)
+    int addTask(const char* name, int core, uint32_t stackFree, bool idle = false) {
+        if (taskCount == HAL_MAX_TASKS) return -1;
+        HalTaskInfo& t = tasks[taskCount];
+        memset(&t, 0, sizeof(t));
+        snprintf(t.name, sizeof(t.name), "%s", name);
+        t.id = (uint32_t)taskCount + 1;
+        for (int i = 0; i < taskCount; i++) {
+            if (tasks[i].id >= t.id) t.id = tasks[i].id + 1;
+        }
+        t.core = (int8_t)core;
+        t.stackFree = stackFree;
+        t.idle = idle;
+        return taskCount++;
+    }
+
+    // Task deleted: later ones move down one slot
+    void removeTask(int index) {
+        for (int i = index; i < taskCount - 1; i++) {
+            tasks[i] = tasks[i + 1];
+        }
+        taskCount--;
+    }
+
+    // Use a 16-bit mono WAV as the microphone
+    bool setMicWav(const char* path) {
+        FILE* f = fopen(path, "rb");
+        if (!f) return false;
+        uint8_t header[12];
+        bool ok = fread(header, 1, 12, f) == 12 &&
+                  memcmp(header, "RIFF", 4) == 0 && memcmp(header + 8, "WAVE", 4) == 0;
+        int channels = 0;
+        int bits = 0;
+        int rate = 0;
+        while (ok) {
+            uint8_t chunk[8];
+            if (fread(chunk, 1, 8, f) != 8) {
+                ok = false;
+                break;
+            }
+            uint32_t size = chunk[4] | (chunk[5] << 8) | (chunk[6] << 16) | ((uint32_t)chunk[7] << 24);
+            if (memcmp(chunk, "fmt ", 4) == 0) {
+                uint8_t fmt[16];
+                ok = size >= 16 && fread(fmt, 1, 16, f) == 16;
+                channels = fmt[2] | (fmt[3] << 8);
+                rate = fmt[4] | (fmt[5] << 8) | (fmt[6] << 16) | ((uint32_t)fmt[7] << 24);
+                bits = fmt[14] | (fmt[15] << 8);
+                fseek(f, size - 16 + (size & 1), SEEK_CUR);
+            } else if (memcmp(chunk, "data", 4) == 0) {
+                if (channels != 1 || bits != 16) {
+                    fprintf(stderr, "HAL: %s must be 16-bit mono\n", path);
+                    ok = false;
+                    break;
+                }
+                uint8_t* pcm = (uint8_t*)malloc(size ? size : 1);
+                size_t got = fread(pcm, 1, size, f);
+                setMicPcm(pcm, got, rate);
+                free(pcm);
+                break;
+            } else {
+                fseek(f, size + (size & 1), SEEK_CUR);
+            }
+        }
+        fclose(f);
+        return ok;
+    }
+
+    // Use raw 16-bit mono PCM as the microphone (copied)
+    void setMicPcm(const void* pcm, size_t len, int rate) {
+        free(micPcm);
+        micPcm = (uint8_t*)malloc(len ? len : 1);
+        memcpy(micPcm, pcm, len);
+        micLen = len;
+        micPos = 0;
+        micRate = rate;
+    }
+
+    // Append everything the speaker plays to a raw PCM file (nullptr: stop)
+    bool setSpeakerFile(const char* path) {
+        if (speakerOut) {
+            fclose(speakerOut);
+            speakerOut = nullptr;
+        }
+        if (path) {
+            speakerOut = fopen(path, "wb");
+        }
+        return !path || speakerOut;
+    }
+
+    uint64_t bytesToUs(uint64_t bytes) const {
+        return bytes * 1000000 / ((uint64_t)speakerRate * 2);
+    }
+
+    // Drain the speaker queue up to now. If it ran dry and
+    // playback is still going (countGap), that is an underrun.
+    void drainSpeaker(bool countGap) {
+        if (speakerRate <= 0) return;
+        uint64_t now = nativeClock().nowUs();
+        uint64_t elapsedUs = now - queueUpdatedUs;
+        uint64_t played = elapsedUs * (uint64_t)speakerRate * 2 / 1000000;
+        played &= ~1ULL;
+        if (played > queueBytes) {
+            if (countGap && playbackBytes > 0) {
+                uint64_t gapUs = elapsedUs - bytesToUs(queueBytes);
+                if (gapUs >= 1000) {
+                    speaker.underruns++;
+                    speaker.underrunMs += gapUs / 1000;
+                }
+            }
+            queueBytes = 0;
+            queueUpdatedUs = now;
+        } else if (played > 0) {
+            queueBytes -= played;
+            queueUpdatedUs += bytesToUs(played);
+        }
+    }
+};
+
+inline NativeHal& nativeHal() {
+    static NativeHal hal;
+    return hal;
+}
+
+// ============================================
+// TIME
+// ============================================
+
+inline unsigned long halMillis() {
+    return (unsigned long)(nativeClock().nowUs() / 1000);
+}
+
+inline unsigned long halMicros() {
+    return (unsigned long)nativeClock().nowUs();
+}
+
+inline void halDelay(unsigned long ms) {
+    nativeClock().sleepUs((uint64_t)ms * 1000);
+}
+
+// ============================================
+// LOGGING
+// ============================================
+
+inline void halLog(const char* fmt, ...) {
+    if (nativeHal().quiet) return;
+    va_list args;
+    va_start(args, fmt);
+    vprintf(fmt, args);
+    va_end(args);
+}
+
+// ============================================
+// GPIO
+// ============================================
+
+inline void halPinMode(int pin, int mode) {
+    if (pin >= 0 && pin < NativeHal::PIN_COUNT) {
+        nativeHal().pinModes[pin] = mode;
+    }
+}
+
+inline void halDigitalWrite(int pin, int level) {
+    if (pin < 0 || pin >= NativeHal::PIN_COUNT) return;
+    NativeHal& hal = nativeHal();
+    int old = hal.pinLevels[pin];
+    hal.pinLevels[pin] = level ? HIGH : LOW;
+    if (hal.pinLevels[pin] != old && hal.pinChange[pin]) {
+        hal.pinChange[pin](hal.pinChangeArg[pin]);
+    }
+}
+
+inline int halDigitalRead(int pin) {
+    if (pin < 0 || pin >= NativeHal::PIN_COUNT) return LOW;
+    return nativeHal().pinLevels[pin];
+}
+
+inline int halAnalogRead(int pin) {
+    if (pin < 0 || pin >= NativeHal::PIN_COUNT) return 0;
+    return nativeHal().analogLevels[pin];
+}
+
+// Runs on the thread that changes the level (halDigitalWrite)
+inline void halAttachPinChange(int pin, HalPinFn fn, void* arg) {
+    if (pin < 0 || pin >= NativeHal::PIN_COUNT) return;
+    nativeHal().pinChange[pin] = fn;
+    nativeHal().pinChangeArg[pin] = arg;
+}
+
+// The Arduino names, for headers that don't go through the HAL
+// (phase 1 sos_system.h); a tone just holds the pin high
+inline void pinMode(int pin, int mode) { halPinMode(pin, mode); }
+inline void digitalWrite(int pin, int level) { halDigitalWrite(pin, level); }
+inline int digitalRead(int pin) { return halDigitalRead(pin); }
+inline void tone(int pin, unsigned int freq, unsigned long ms = 0) { halDigitalWrite(pin, HIGH); }
+inline void noTone(int pin) { halDigitalWrite(pin, LOW); }
+
+// ============================================
+// I2S
+// ============================================
+
+inline bool halI2sBegin(HalI2sMode mode, int sampleRate) {
+    NativeHal& hal = nativeHal();
+    if (mode == HAL_I2S_MIC) {
+        if (hal.micRate && hal.micRate != sampleRate) {
+            halLog("HAL: Mic source is %d Hz, recording at %d Hz\n", hal.micRate, sampleRate);
+        }
+        return true;
+    }
+    hal.drainSpeaker(false);
+    hal.speakerRate = sampleRate;
+    hal.playbackBytes = 0;
+    hal.queueBytes = 0;
+    hal.queueUpdatedUs = nativeClock().nowUs();
+    return true;
+}
+
+inline size_t halI2sRead(void* buf, size_t len) {
+    NativeHal& hal = nativeHal();
+    size_t fromMic = 0;
+    if (hal.micPos < hal.micLen) {
+        fromMic = hal.micLen - hal.micPos;
+        if (fromMic > len) fromMic = len;
+        memcpy(buf, hal.micPcm + hal.micPos, fromMic);
+        hal.micPos += fromMic;
+    }
+    memset((uint8_t*)buf + fromMic, 0, len - fromMic);
+    if (hal.paceMic && hal.micRate > 0) {
+        nativeClock().sleepUs((uint64_t)len * 1000000 / ((uint64_t)hal.micRate * 2));
+    }
+    return len;
+}
+
+// Blocks (on the HAL clock) while the DMA queue is full
+inline size_t halI2sWrite(const void* buf, size_t len) {
+    NativeHal& hal = nativeHal();
+    if (hal.speakerRate <= 0) return 0;
+    if (hal.speaker.firstWriteUs == 0 && len > 0) {
+        hal.speaker.firstWriteUs = nativeClock().nowUs() + 1;
+    }
+    if (!hal.paceSpeaker) {
+        // Infinitely fast DMA: no queue, no underruns
+        hal.speaker.bytesPlayed += len;
+        if (hal.speakerOut) {
+            fwrite(buf, 1, len, hal.speakerOut);
+        }
+        return len;
+    }
+    hal.drainSpeaker(true);
+    size_t done = 0;
+    while (done < len) {
+        size_t room = NativeHal::SPEAKER_QUEUE_BYTES - (size_t)hal.queueBytes;
+        if (room == 0) {
+            // Wait until the rest (or one DMA buffer) fits
+            size_t want = len - done < 2048 ? len - done : 2048;
+            nativeClock().sleepUs(hal.bytesToUs(want) + 1);
+            hal.drainSpeaker(true);
+            continue;
+        }
+        size_t n = len - done < room ? len - done : room;
+        if (hal.queueBytes == 0) {
+            hal.queueUpdatedUs = nativeClock().nowUs();
+        }
+        hal.queueBytes += n;
+        hal.playbackBytes += n;
+        hal.speaker.bytesPlayed += n;
+        if (hal.speakerOut) {
+            fwrite((const uint8_t*)buf + done, 1, n, hal.speakerOut);
+        }
+        done += n;
+    }
+    return len;
+}
+
+// ============================================
+// NETWORK
+// ============================================
+
+typedef NativeTlsClient HalTlsClient;
+
+inline bool halNetConnected() {
+    return nativeHal().netUp;
+}
+
+// ============================================
+// TCP SERVER
+// ============================================
+
+inline int halTcpListen(uint16_t port, int backlog) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, backlog) != 0) {
+        close(fd);
+        return -1;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    return fd;
+}
+
+inline uint16_t halTcpLocalPort(int fd) {
+    struct sockaddr_in addr = {};
+    socklen_t len = sizeof(addr);
+    if (getsockname(fd, (struct sockaddr*)&addr, &len) != 0) return 0;
+    return ntohs(addr.sin_port);
+}
+
+inline int halTcpAccept(int listenFd) {
+    int fd = accept(listenFd, nullptr, nullptr);
+    if (fd < 0) return -1;
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    return fd;
+}
+
+inline int halTcpRecv(int fd, void* buf, size_t len) {
+    ssize_t n = recv(fd, buf, len, 0);
+    if (n > 0) return (int)n;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) return 0;
+    return -1;
+}
+
+// MSG_NOSIGNAL: a peer that hung up is an error, not SIGPIPE
+inline int halTcpSend(int fd, const void* buf, size_t len) {
+    ssize_t n = send(fd, buf, len, MSG_NOSIGNAL);
+    if (n >= 0) return (int)n;
+    return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+}
+
+inline void halTcpClose(int fd) {
+    close(fd);
+}
+
+inline int halTcpWait(const int* fds, const bool* wantWrite, int count, uint32_t timeoutMs) {
+    fd_set rd, wr;
+    FD_ZERO(&rd);
+    FD_ZERO(&wr);
+    int top = -1;
+    for (int i = 0; i < count; i++) {
+        if (fds[i] < 0) continue;
+        FD_SET(fds[i], wantWrite[i] ? &wr : &rd);
+        if (fds[i] > top) top = fds[i];
+    }
+    struct timeval tv = { (time_t)(timeoutMs / 1000), (suseconds_t)(timeoutMs % 1000) * 1000 };
+    int n = select(top + 1, &rd, &wr, nullptr, &tv);
+    return n < 0 ? 0 : n;
+}
+
+// Same loopback UDP socket as on the watch
+inline int halWakeOpen() {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) return -1;
+    struct sockaddr_in addr = {};
+    socklen_t len = sizeof(addr);
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        getsockname(fd, (struct sockaddr*)&addr, &len) != 0 ||
+        connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    return fd;
+}
+
+inline void halWakeSignal(int fd) {
+    uint8_t b = 1;
+    send(fd, &b, 1, MSG_NOSIGNAL);
+}
+
+inline void halWakeDrain(int fd) {
+    uint8_t buf[16];
+    while (recv(fd, buf, sizeof(buf), 0) > 0) {}
+}
+
+// ============================================
+// FILESYSTEM
+// ============================================
+
+inline bool halFsBegin() {
+    mkdir(nativeHal().fsRoot, 0755);
+    return true;
+}
+
+// False if fsRoot + path doesn't fit in cap (never a cut-off name)
+inline bool nativeFsPath(char* out, size_t cap, const char* path) {
+    int n = snprintf(out, cap, "%s/%s", nativeHal().fsRoot, path[0] == '/' ? path + 1 : path);
+    return n >= 0 && (size_t)n < cap;
+}
+
+inline long halFsRead(const char* path, void* buf, size_t cap) {
+    char full[256];
+    if (!nativeFsPath(full, sizeof(full), path)) return -1;
+    FILE* f = fopen(full, "rb");
+    if (!f) return -1;
+    size_t n = fread(buf, 1, cap, f);
+    fclose(f);
+    return (long)n;
+}
+
+inline bool halFsWrite(const char* path, const void* data, size_t len) {
+    char full[256];
+    if (!nativeFsPath(full, sizeof(full), path)) return false;
+    FILE* f = fopen(full, "wb");
+    if (!f) return false;
+    bool ok = fwrite(data, 1, len, f) == len;
+    fclose(f);
+    return ok;
+}
+
+inline bool halFsRemove(const char* path) {
+    char full[256];
+    return nativeFsPath(full, sizeof(full), path) && remove(full) == 0;
+}
+
+// ============================================
+// HEAP
+// ============================================
+
+// PSRAM requests fail when nativeHal().psram is off, as on a
+// board without it; "anywhere" tries internal first
+inline void* halHeapAlloc(size_t size, uint8_t caps) {
+    if (caps & HAL_HEAP_SPIRAM) {
+        return nativeHal().psram ? nativeHeapPsram().alloc(size) : nullptr;
+    }
+    void* p = nativeHeapInternal().alloc(size);
+    if (!p && caps == 0 && nativeHal().psram) {
+        p = nativeHeapPsram().alloc(size);
+    }
+    return p;
+}
+
+inline void halHeapFree(void* p) {
+    if (!p) return;
+    if (!nativeHeapInternal().free(p) && !nativeHeapPsram().free(p)) {
+        fprintf(stderr, "Heap: free() of unknown pointer %p\n", p);
+    }
+}
+
+inline HalHeapInfo halHeapInfo(uint8_t caps) {
+    NativeHeap& heap = (caps & HAL_HEAP_SPIRAM) ? nativeHeapPsram() : nativeHeapInternal();
+    HalHeapInfo info;
+    info.freeBytes = heap.getFree();
+    info.largestFree = heap.getLargestFree();
+    info.minFree = heap.getMinFree();
+    return info;
+}
+
+// ============================================
+// TASKS
+// ============================================
+
+inline int halTaskSnapshot(HalTaskInfo* out, int max, uint32_t* totalRunTime) {
+    NativeHal& hal = nativeHal();
+    int n = hal.taskCount < max ? hal.taskCount : max;
+    memcpy(out, hal.tasks, sizeof(HalTaskInfo) * (size_t)n);
+    *totalRunTime = hal.taskRunTime;
+    return n;
+}
+
+// ============================================
+// QUEUES
+// ============================================
+
+struct NativeQueue {
+    std::mutex lock;
+    std::condition_variable changed;
+    size_t itemSize;
+    int depth;
+    int head;
+    int count;
+    uint8_t* items;
+};
+
+// Waits for ready() under q.lock. Virtual time: the timeout passes
+// at once (nobody else can make the queue ready).
+template <typename F>
+inline bool nativeQueueWait(NativeQueue& q, std::unique_lock<std::mutex>& held, uint32_t timeoutMs, F ready) {
+    if (ready()) return true;
+    if (timeoutMs == 0) return false;
+    if (nativeClock().isVirtual()) {
+        if (timeoutMs != HAL_WAIT_FOREVER) nativeClock().advanceUs((uint64_t)timeoutMs * 1000);
+        return false;
+    }
+    if (timeoutMs == HAL_WAIT_FOREVER) {
+        q.changed.wait(held, ready);
+        return true;
+    }
+    return q.changed.wait_for(held, std::chrono::milliseconds(timeoutMs), ready);
+}
+
+inline HalQueue halQueueCreate(size_t itemSize, int depth) {
+    NativeQueue* q = new NativeQueue();
+    q->itemSize = itemSize;
+    q->depth = depth;
+    q->head = 0;
+    q->count = 0;
+    q->items = (uint8_t*)malloc(itemSize * (size_t)depth);
+    return q;
+}
+
+inline void halQueueDelete(HalQueue handle) {
+    NativeQueue* q = (NativeQueue*)handle;
+    free(q->items);
+    delete q;
+}
+
+inline bool halQueueSend(HalQueue handle, const void* item, uint32_t timeoutMs) {
+    NativeQueue& q = *(NativeQueue*)handle;
+    std::unique_lock<std::mutex> held(q.lock);
+    if (!nativeQueueWait(q, held, timeoutMs, [&]() { return q.count < q.depth; })) return false;
+    memcpy(q.items + (size_t)((q.head + q.count) % q.depth) * q.itemSize, item, q.itemSize);
+    q.count++;
+    q.changed.notify_all();
+    return true;
+}
+
+inline bool halQueueReceive(HalQueue handle, void* item, uint32_t timeoutMs) {
+    NativeQueue& q = *(NativeQueue*)handle;
+    std::unique_lock<std::mutex> held(q.lock);
+    if (!nativeQueueWait(q, held, timeoutMs, [&]() { return q.count > 0; })) return false;
+    memcpy(item, q.items + (size_t)q.head * q.itemSize, q.itemSize);
+    q.head = (q.head + 1) % q.depth;
+    q.count--;
+    q.changed.notify_all();
+    return true;
+}
+
+inline bool halQueueSendFromIsr(HalQueue handle, const void* item) {
+    return halQueueSend(handle, item, 0);
+}
+
+inline int halQueueWaiting(HalQueue handle) {
+    NativeQueue& q = *(NativeQueue*)handle;
+    std::lock_guard<std::mutex> held(q.lock);
+    return q.count;
+}
+
+// ============================================
+// LOCKS
+// ============================================
+
+inline HalLock halLockCreate() { return new std::mutex(); }
+
+inline void halLockDelete(HalLock l) { delete (std::mutex*)l; }
+
+inline void halLockTake(HalLock l) { ((std::mutex*)l)->lock(); }
+
+inline void halLockGive(HalLock l) { ((std::mutex*)l)->unlock(); }
+
+// ============================================
+// SYSTEM
+// ============================================
+
+inline bool halPsramInit() {
+    return nativeHal().psram;
+}
+
+inline long halRandom(long low, long high) {
+    return random(low, high);
+}
+
+// Threads stand in for the two cores: each reports the core it
+// was given with nativeCoreId() = n (0 unless set)
+inline int& nativeCoreId() {
+    static thread_local int core = 0;
+    return core;
+}
+
+inline int halCoreId() {
+    return nativeCoreId();
+}
+
+inline void halEnableWakeOnPin(int pin, int level) {
+    (void)level;
+    nativeHal().wakePin = pin;
+}
+
+// The watch never returns from this; the host records it and does
+inline void halDeepSleep() {
+    nativeHal().deepSleeps++;
+}
+
+inline HalWakeCause halWakeCause() {
+    return nativeHal().wakeCause;
+}
+
+inline bool halLightSleepBegin(int wakePin) {
+    nativeHal().lightSleepPin = wakePin;
+    return true;
+}
+
+inline void halLightSleepBlock(bool block) {
+    nativeHal().sleepBlocked = block;
+}
+
+#endif // HAL_NATIVE_H
@@ -0,0 +1,378 @@
+/*
+ * ============================================
+ * Native HAL Tests (host)
+ * ============================================
+ *
+ * Checks the Linux backend the other host tests
+ * rely on: virtual clock, GPIO table, WAV mic,
+ * the speaker's DMA queue model (blocking and
+ * underruns), the filesystem root, socket
+ * routes and network impairment.
+ *
+ * Built and run by CMakeLists.txt (ctest).
+ *
+ * ============================================
+ */
+
+#include "volt_hal.h"
+#include "dns_cache.h"
+#include "test_check.h"
+
+#include <arpa/inet.h>
+#include <thread>
+
+// ============================================
+// TESTS
+// ============================================
+
+static void testVirtualClock() {
+    resetHal();
+    CHECK(halMillis() == 0);
+    halDelay(1500);
+    CHECK(halMillis() == 1500);
+    CHECK(millis() == 1500);             // Arduino shim shares the clock
+    nativeClock().advanceUs(250);
+    CHECK(halMicros() == 1500250);
+}
+
+static void testGpio() {
+    resetHal();
+    CHECK(halDigitalRead(0) == HIGH);    // Pull-ups idle high
+    halPinMode(21, OUTPUT);
+    halDigitalWrite(21, HIGH);
+    CHECK(nativeHal().pinModes[21] == OUTPUT);
+    CHECK(halDigitalRead(21) == HIGH);
+    halDigitalWrite(21, LOW);
+    CHECK(halDigitalRead(21) == LOW);
+    nativeHal().analogLevels[4] = 2048;
+    CHECK(halAnalogRead(4) == 2048);
+    CHECK(halDigitalRead(999) == LOW);   // Out of range is harmless
+}
+
+static void writeWav(const char* path, const int16_t* samples, uint32_t count, int rate) {
+    FILE* f = fopen(path, "wb");
+    uint32_t dataSize = count * 2;
+    uint32_t riffSize = 36 + dataSize;
+    uint32_t fmtSize = 16;
+    uint16_t format = 1;
+    uint16_t channels = 1;
+    uint32_t sampleRate = rate;
+    uint32_t byteRate = rate * 2;
+    uint16_t blockAlign = 2;
+    uint16_t bits = 16;
+    fwrite("RIFF", 1, 4, f);
+    fwrite(&riffSize, 4, 1, f);
+    fwrite("WAVEfmt ", 1, 8, f);
+    fwrite(&fmtSize, 4, 1, f);
+    fwrite(&format, 2, 1, f);
+    fwrite(&channels, 2, 1, f);
+    fwrite(&sampleRate, 4, 1, f);
+    fwrite(&byteRate, 4, 1, f);
+    fwrite(&blockAlign, 2, 1, f);
+    fwrite(&bits, 2, 1, f);
+    fwrite("data", 1, 4, f);
+    fwrite(&dataSize, 4, 1, f);
+    fwrite(samples, 2, count, f);
+    fclose(f);
+}
+
+static void testWavMicrophone() {
+    resetHal();
+    int16_t samples[100];
+    for (int i = 0; i < 100; i++) samples[i] = (int16_t)(i * 10);
+    writeWav("hal_test_mic.wav", samples, 100, 16000);
+    CHECK(nativeHal().setMicWav("hal_test_mic.wav"));
+    CHECK(nativeHal().micRate == 16000);
+
+    halI2sBegin(HAL_I2S_MIC, 16000);
+    int16_t frame[64];
+    CHECK(halI2sRead(frame, sizeof(frame)) == sizeof(frame));
+    CHECK(frame[0] == 0 && frame[63] == 630);
+
+    // Past the end of the file the mic hears silence
+    CHECK(halI2sRead(frame, sizeof(frame)) == sizeof(frame));
+    CHECK(frame[35] == 990);
+    CHECK(frame[36] == 0 && frame[63] == 0);
+
+    // Pacing makes a read take as long as the audio it returns
+    nativeHal().paceMic = true;
+    unsigned long before = halMillis();
+    int16_t second[16000];
+    halI2sRead(second, sizeof(second));
+    CHECK(halMillis() - before == 1000);
+
+    CHECK(!nativeHal().setMicWav("does_not_exist.wav"));
+    remove("hal_test_mic.wav");
+}
+
+static void testSpeakerQueue() {
+    resetHal();
+    static uint8_t audio[48000];          // 1 s @ 24 kHz
+    memset(audio, 0, sizeof(audio));
+
+    halI2sBegin(HAL_I2S_SPEAKER, 24000);
+    unsigned long before = halMillis();
+    CHECK(halI2sWrite(audio, sizeof(audio)) == sizeof(audio));
+
+    // Only the DMA queue's worth is still buffered when the write returns
+    unsigned long blockedMs = halMillis() - before;
+    CHECK(blockedMs > 600 && blockedMs < 700);
+    CHECK(nativeHal().speaker.bytesPlayed == sizeof(audio));
+    CHECK(nativeHal().speaker.underruns == 0);
+
+    // A 500 ms gap while more audio is expected is one underrun
+    halDelay(500 + 341 + 10);
+    halI2sWrite(audio, 4800);
+    CHECK(nativeHal().speaker.underruns == 1);
+    CHECK(nativeHal().speaker.underrunMs >= 500 && nativeHal().speaker.underrunMs <= 520);
+
+    // Restarting playback isn't an underrun
+    halDelay(2000);
+    halI2sBegin(HAL_I2S_SPEAKER, 24000);
+    halI2sWrite(audio, 4800);
+    CHECK(nativeHal().speaker.underruns == 1);
+}
+
+static void testSpeakerFile() {
+    resetHal();
+    CHECK(nativeHal().setSpeakerFile("hal_test_out.pcm"));
+    halI2sBegin(HAL_I2S_SPEAKER, 16000);
+    const uint8_t pcm[6] = { 1, 2, 3, 4, 5, 6 };
+    halI2sWrite(pcm, sizeof(pcm));
+    nativeHal().setSpeakerFile(nullptr);
+
+    FILE* f = fopen("hal_test_out.pcm", "rb");
+    uint8_t back[8];
+    size_t n = f ? fread(back, 1, sizeof(back), f) : 0;
+    if (f) fclose(f);
+    CHECK(n == 6 && memcmp(back, pcm, 6) == 0);
+    remove("hal_test_out.pcm");
+}
+
+static void testFilesystem() {
+    resetHal();
+    CHECK(halFsBegin());
+    CHECK(halFsWrite("/hal_test.bin", "volt", 4));
+    char buf[8] = {0};
+    CHECK(halFsRead("/hal_test.bin", buf, sizeof(buf)) == 4);
+    CHECK(memcmp(buf, "volt", 4) == 0);
+    CHECK(halFsRemove("/hal_test.bin"));
+    CHECK(halFsRead("/hal_test.bin", buf, sizeof(buf)) == -1);
+
+    // A path too long for the host's buffer fails instead of writing
+    // to the name cut short
+    char name[300];
+    memset(name, 'a', sizeof(name) - 1);
+    name[0] = '/';
+    name[sizeof(name) - 1] = '\0';
+    CHECK(!halFsWrite(name, "volt", 4));
+    CHECK(halFsRead(name, buf, sizeof(buf)) == -1);
+    CHECK(!halFsRemove(name));
+    name[255 - strlen(nativeHal().fsRoot)] = '\0';   // What snprintf would have kept
+    CHECK(halFsRead(name, buf, sizeof(buf)) == -1);
+}
+
+static void testSystem() {
+    resetHal();
+    CHECK(halPsramInit());
+    nativeHal().psram = false;
+    CHECK(!halPsramInit());
+    for (int i = 0; i < 100; i++) {
+        long r = halRandom(5, 10);
+        CHECK(r >= 5 && r < 10);
+    }
+    halEnableWakeOnPin(0, 0);
+    halDeepSleep();
+    CHECK(nativeHal().wakePin == 0);
+    CHECK(nativeHal().deepSleeps == 1);
+    nativeHal().netUp = false;
+    CHECK(!halNetConnected());
+}
+
+static void testRoutes() {
+    resetHal();
+    nativeClock().setVirtual(false);
+
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    bind(listener, (struct sockaddr*)&addr, sizeof(addr));
+    listen(listener, 1);
+    socklen_t len = sizeof(addr);
+    getsockname(listener, (struct sockaddr*)&addr, &len);
+    uint16_t port = ntohs(addr.sin_port);
+
+    // Echo one message, then close
+    std::thread server([listener]() {
+        int fd = accept(listener, nullptr, nullptr);
+        char buf[64];
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n > 0) send(fd, buf, n, 0);
+        close(fd);
+    });
+
+    CHECK(nativeRoutes().add("api.openai.com", 443, "127.0.0.1", port, false));
+    HalTlsClient client;
+    client.setInsecure();
+    CHECK(dnsConnect(client, "api.openai.com", 443));
+    CHECK(client.write((const uint8_t*)"ping", 4) == 4);
+
+    char reply[8] = {0};
+    size_t got = 0;
+    unsigned long start = halMillis();
+    while (got < 4 && halMillis() - start < 2000) {
+        int n = client.read((uint8_t*)reply + got, sizeof(reply) - 1 - got);
+        if (n > 0) got += n; else halDelay(1);
+    }
+    CHECK(got == 4 && strcmp(reply, "ping") == 0);
+
+    server.join();
+    start = halMillis();
+    while (client.connected() && halMillis() - start < 2000) {
+        halDelay(1);
+    }
+    CHECK(!client.connected());
+    client.stop();
+    close(listener);
+
+    // Routed to a port nobody listens on: connect fails cleanly
+    nativeRoutes().clear();
+    CHECK(nativeRoutes().add("api.openai.com", 443, "127.0.0.1", port, false));
+    CHECK(!client.connect("api.openai.com", 443));
+}
+
+// Loopback listener on a free port
+static int listenLocal(uint16_t& port) {
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(listener, (struct sockaddr*)&addr, sizeof(addr));
+    listen(listener, 1);
+    socklen_t len = sizeof(addr);
+    getsockname(listener, (struct sockaddr*)&addr, &len);
+    port = ntohs(addr.sin_port);
+    return listener;
+}
+
+static void testProfiles() {
+    NetProfile profiles[8];
+    CHECK(netParseProfiles(NET_DEFAULT_PROFILES, profiles, 8) == 6);
+    CHECK(strcmp(profiles[0].name, "ideal") == 0 && profiles[0].latencyMs == 0);
+    CHECK(strcmp(profiles[3].name, "weak") == 0);
+    CHECK(profiles[3].upKbps == 256 && profiles[3].downKbps == 512);
+
+    NetProfile p;
+    CHECK(netParseProfile("slow latency=10 kbps=64 # comment", p));
+    CHECK(p.latencyMs == 10 && p.upKbps == 64 && p.downKbps == 64);
+    CHECK(!netParseProfile("# only a comment", p));
+    CHECK(!netParseProfile("bad latency=fast", p));
+    CHECK(!netParseProfile("bad colour=blue", p));
+}
+
+static void testImpairedLink() {
+    resetHal();
+    nativeClock().setVirtual(false);
+    uint16_t port;
+    int listener = listenLocal(port);
+
+    // Swallow the upload, then answer and close
+    std::thread server([listener]() {
+        int fd = accept(listener, nullptr, nullptr);
+        char buf[4096];
+        size_t got = 0;
+        while (got < 20000) {
+            ssize_t n = recv(fd, buf, sizeof(buf), 0);
+            if (n <= 0) break;
+            got += n;
+        }
+        send(fd, "done", 4, 0);
+        close(fd);
+    });
+
+    NetProfile p;
+    CHECK(netParseProfile("test latency=100 up_kbps=800", p));
+    nativeNetImpairment().set(p);
+    nativeRoutes().add("api.openai.com", 443, "127.0.0.1", port, false);
+    HalTlsClient client;
+
+    unsigned long start = halMillis();
+    CHECK(client.connect("api.openai.com", 443));
+    CHECK(halMillis() - start >= 200);                // Two round trips
+
+    // 20 KB at 100 KB/s
+    static uint8_t upload[20000];
+    start = halMillis();
+    CHECK(client.write(upload, sizeof(upload)) == sizeof(upload));
+    CHECK(halMillis() - start >= 180);
+
+    // The reply waits out the latency once it is on the socket
+    start = halMillis();
+    char reply[8] = {0};
+    size_t got = 0;
+    while (got < 4 && halMillis() - start < 2000) {
+        int n = client.read((uint8_t*)reply + got, sizeof(reply) - 1 - got);
+        if (n > 0) got += n; else halDelay(1);
+    }
+    CHECK(got == 4 && strcmp(reply, "done") == 0);
+    CHECK(halMillis() - start >= 100);
+    CHECK(nativeNetImpairment().stats.connects == 1);
+    CHECK(nativeNetImpairment().stats.bytesUp == sizeof(upload));
+    CHECK(nativeNetImpairment().stats.bytesDown == 4);
+
+    server.join();
+    client.stop();
+    close(listener);
+    nativeNetImpairment().clear();
+}
+
+static void testDroppedLink() {
+    resetHal();
+    nativeClock().setVirtual(false);
+    uint16_t port;
+    int listener = listenLocal(port);
+    std::thread server([listener]() {
+        int fd = accept(listener, nullptr, nullptr);
+        char buf[256];
+        while (recv(fd, buf, sizeof(buf), 0) > 0) {}
+        close(fd);
+    });
+
+    // Every connection is cut within its first 10 bytes
+    NetProfile p;
+    CHECK(netParseProfile("cut drop_pct=100 drop_within=10", p));
+    nativeNetImpairment().set(p);
+    nativeRoutes().add("api.openai.com", 443, "127.0.0.1", port, false);
+    HalTlsClient client;
+    CHECK(client.connect("api.openai.com", 443));
+    uint8_t data[100] = {0};
+    CHECK(client.write(data, sizeof(data)) <= 10);
+    CHECK(!client.connected());
+    CHECK(client.write(data, sizeof(data)) == 0);
+    CHECK(nativeNetImpairment().stats.drops == 1);
+
+    server.join();                                   // Saw the link go down too
+    client.stop();
+    close(listener);
+    nativeNetImpairment().clear();
+}
+
+int main() {
+    testVirtualClock();
+    testGpio();
+    testWavMicrophone();
+    testSpeakerQueue();
+    testSpeakerFile();
+    testFilesystem();
+    testSystem();
+    testRoutes();
+    testProfiles();
+    testImpairedLink();
+    testDroppedLink();
+
+    return testSummary();
+}
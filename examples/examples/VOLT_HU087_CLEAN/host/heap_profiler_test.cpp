@@ -0,0 +1,388 @@
+/*
+ * ============================================
+ * Heap Profiler Tests (host)
+ * ============================================
+ *
+ * Runs heap_profiler.h on the native HAL's
+ * modeled heap (native_heap.h): first-fit
+ * placement and coalescing, per-site counts
+ * and failures, the sample ring, the dump, the
+ * pools' reservations, and a soak of 60
+ * simulated turns on the virtual clock that
+ * must flag the one leaking site, show the
+ * largest free block shrinking, and come out
+ * the same when run again.
+ *
+ * Built with VOLT_HEAP_PROFILE=1 by
+ * CMakeLists.txt (ctest).
+ *
+ * ============================================
+ */
+
+#include "heap_profiler.h"
+#include "mem_pools.h"
+#include "test_check.h"
+
+#include <string>
+#include <vector>
+
+// Collects a dump
+class Capture : public Print {
+public:
+    std::string text;
+
+    size_t write(uint8_t b) override {
+        text += (char)b;
+        return 1;
+    }
+
+    size_t write(const uint8_t* buf, size_t size) override {
+        text.append((const char*)buf, size);
+        return size;
+    }
+
+    bool has(const char* s) const { return text.find(s) != std::string::npos; }
+};
+
+static void resetProfiler() {
+    resetHal();
+    nativeHeapInternal().resize(64 * 1024);
+    nativeHeapPsram().resize(256 * 1024);
+    heapProfiler().reset();
+    heapProfiler().setSampleInterval(10000);
+    heapProfiler().setLeakAge(10 * 60 * 1000UL);
+}
+
+static int findSite(const char* name) {
+    for (int i = 0; i < heapProfiler().getSiteCount(); i++) {
+        if (strcmp(heapSiteName(heapProfiler().getSite(i).name), name) == 0) return i;
+    }
+    return -1;
+}
+
+// ============================================
+// HEAP MODEL
+// ============================================
+
+static void testModel() {
+    NativeHeap heap(1024);
+    CHECK(heap.getFree() == 1024 && heap.getLargestFree() == 1024);
+
+    void* a = heap.alloc(100);     // Rounded up to 104
+    void* b = heap.alloc(200);
+    void* c = heap.alloc(300);
+    CHECK(a && b && c);
+    CHECK(heap.getFree() == 1024 - 104 - 200 - 304);
+    CHECK((uint8_t*)b == (uint8_t*)a + 104);
+
+    // A hole between two live blocks: free is up, largest is not
+    CHECK(heap.free(b));
+    CHECK(heap.getFree() == 1024 - 104 - 304);
+    CHECK(heap.getLargestFree() == 1024 - 104 - 200 - 304);
+    CHECK(heap.alloc(500) == nullptr);
+
+    // First fit goes back into the hole
+    void* d = heap.alloc(64);
+    CHECK(d == b);
+    CHECK(heap.free(d));
+
+    // Freeing the neighbours coalesces everything
+    CHECK(heap.free(a));
+    CHECK(heap.free(c));
+    CHECK(heap.getLargestFree() == 1024);
+    CHECK(heap.getBlockCount() == 0);
+    CHECK(heap.getMinFree() == 1024 - 104 - 200 - 304);
+
+    CHECK(!heap.free(a));          // Double free
+    int local = 0;
+    CHECK(!heap.free(&local));     // Not this heap's
+}
+
+static void testHalHeap() {
+    resetProfiler();
+    void* p = halHeapAlloc(1000, HAL_HEAP_SPIRAM);
+    CHECK(nativeHeapPsram().owns(p));
+    void* q = halHeapAlloc(1000, HAL_HEAP_DMA);
+    CHECK(nativeHeapInternal().owns(q));
+
+    // "Anywhere" spills into PSRAM when internal is full
+    void* big = halHeapAlloc(100 * 1024, 0);
+    CHECK(nativeHeapPsram().owns(big));
+
+    HalHeapInfo info = halHeapInfo(HAL_HEAP_INTERNAL);
+    CHECK(info.freeBytes == 64 * 1024 - 1000);
+    halHeapFree(p);
+    halHeapFree(q);
+    halHeapFree(big);
+    CHECK(halHeapInfo(HAL_HEAP_SPIRAM).largestFree == 256 * 1024);
+
+    // No PSRAM on the board
+    nativeHal().psram = false;
+    CHECK(halHeapAlloc(16, HAL_HEAP_SPIRAM) == nullptr);
+    CHECK(halHeapAlloc(100 * 1024, 0) == nullptr);
+}
+
+// ============================================
+// CALL SITES
+// ============================================
+
+static void testSites() {
+    resetProfiler();
+    void* a = VOLT_MALLOC(1000);
+    void* b = VOLT_MALLOC(1000);
+    void* c = VOLT_PS_MALLOC(4000);
+    void* none = VOLT_MALLOC(1024 * 1024);   // Bigger than both regions
+    CHECK(a && b && c && !none);
+    CHECK(nativeHeapPsram().owns(c));
+    CHECK(heapProfiler().getSiteCount() == 4);
+    CHECK(heapProfiler().getTrackedBytes() == 6000);
+
+    HeapSiteStats s = heapProfiler().getSite(0);
+    CHECK(s.allocs == 1 && s.liveBytes == 1000);
+    CHECK(strstr(s.name, "heap_profiler_test.cpp:"));
+    HeapSiteStats failed = heapProfiler().getSite(3);
+    CHECK(failed.failures == 1 && failed.allocs == 0 && failed.liveBytes == 0);
+
+    VOLT_FREE(a);
+    VOLT_FREE(b);
+    VOLT_FREE(c);
+    VOLT_FREE(nullptr);
+    CHECK(heapProfiler().getTrackedBytes() == 0);
+    s = heapProfiler().getSite(0);
+    CHECK(s.frees == 1 && s.liveBlocks == 0 && s.peakBytes == 1000);
+    CHECK(halHeapInfo(HAL_HEAP_INTERNAL).freeBytes == 64 * 1024);
+
+    // The same line allocating in a loop is one site
+    void* blocks[5];
+    for (int i = 0; i < 5; i++) {
+        blocks[i] = VOLT_MALLOC(16);
+    }
+    CHECK(heapProfiler().getSiteCount() == 5);
+    CHECK(heapProfiler().getSite(4).liveBlocks == 5);
+    for (int i = 0; i < 5; i++) {
+        VOLT_FREE(blocks[i]);
+    }
+}
+
+static void testLiveTableFull() {
+    resetProfiler();
+    std::vector<void*> blocks;
+    for (int i = 0; i < HeapProfiler::MAX_LIVE + 10; i++) {
+        blocks.push_back(VOLT_MALLOC(8));
+    }
+    CHECK(heapProfiler().getUntracked() == 10);
+    for (void* p : blocks) {
+        VOLT_FREE(p);
+    }
+    // The untracked ones are still freed, just not counted
+    CHECK(nativeHeapInternal().getBlockCount() == 0);
+    CHECK(heapProfiler().getSite(0).liveBlocks == 10);
+}
+
+// ============================================
+// SAMPLES
+// ============================================
+
+static void testSamples() {
+    resetProfiler();
+    CHECK(heapProfiler().tick(0));
+    CHECK(!heapProfiler().tick(9999));
+    CHECK(heapProfiler().tick(10000));
+    CHECK(heapProfiler().getSampleCount() == 2);
+
+    HeapSample first = heapProfiler().getSample(0);
+    CHECK(first.internalFree == 64 * 1024 && first.internalLargest == 64 * 1024);
+    CHECK(first.psramFree == 256 * 1024);
+
+    for (int i = 0; i < HeapProfiler::MAX_SAMPLES + 5; i++) {
+        heapProfiler().sample(20000 + i * 1000);
+    }
+    CHECK(heapProfiler().getSampleCount() == HeapProfiler::MAX_SAMPLES);
+    // 71 samples taken: the first 7 (0 s, 10 s, 20-24 s) are gone
+    CHECK(heapProfiler().getSample(0).ms == 25000);
+    CHECK(heapProfiler().getSample(HeapProfiler::MAX_SAMPLES - 1).ms ==
+          20000 + (HeapProfiler::MAX_SAMPLES + 4) * 1000);
+
+    CHECK(heapFragPercent(1000, 1000) == 0);
+    CHECK(heapFragPercent(1000, 250) == 75);
+    CHECK(heapFragPercent(0, 0) == 0);
+}
+
+// ============================================
+// SOAK
+// ============================================
+
+// One simulated turn: a TLS session's buffer, a small JSON string
+// that outlives it (kept in a ring of 3, like the chat history),
+// and the bug: a 256-byte block nobody frees.
+struct SoakState {
+    void* history[3];
+    int next;
+    std::vector<void*> leaked;
+};
+
+static void soakTurn(SoakState& st, int turn) {
+    void* tls = VOLT_MALLOC(16 * 1024);
+    void* json = VOLT_MALLOC(200 + (turn % 7) * 96);
+    if (st.history[st.next]) VOLT_FREE(st.history[st.next]);
+    st.history[st.next] = json;
+    st.next = (st.next + 1) % 3;
+    st.leaked.push_back(VOLT_MALLOC(256));
+    VOLT_FREE(tls);
+}
+
+static void freeSoak(SoakState& st) {
+    for (void* p : st.leaked) VOLT_FREE(p);
+    for (void* p : st.history) VOLT_FREE(p);
+}
+
+static const int SOAK_TURNS = 60;
+
+// Boots, then a turn every 30 s on the virtual clock, sampling
+// once a minute. Leaves the boot block in *boot.
+static void runSoak(SoakState& st, void** boot) {
+    resetProfiler();
+    heapProfiler().setSampleInterval(60000);
+    *boot = VOLT_MALLOC(2048);     // Long-lived, not a leak
+    heapProfiler().markBaseline();
+    heapProfiler().tick(0);
+    for (int turn = 0; turn < SOAK_TURNS; turn++) {
+        halDelay(30000);
+        soakTurn(st, turn);
+        heapProfiler().tick((uint32_t)halMillis());
+    }
+}
+
+static void testSoak() {
+    SoakState st = {};
+    void* boot = nullptr;
+    runSoak(st, &boot);
+    uint32_t now = (uint32_t)halMillis();
+
+    // Sites by what they did
+    int leakSite = -1;
+    int tlsSite = -1;
+    int jsonSite = -1;
+    int bootSite = -1;
+    for (int i = 0; i < heapProfiler().getSiteCount(); i++) {
+        HeapSiteStats s = heapProfiler().getSite(i);
+        if (s.liveBlocks == (uint32_t)SOAK_TURNS) leakSite = i;
+        else if (s.peakBytes == 16 * 1024) tlsSite = i;
+        else if (s.liveBlocks == 3) jsonSite = i;
+        else if (s.liveBytes == 2048) bootSite = i;
+        CHECK(s.failures == 0);
+    }
+    CHECK(leakSite >= 0 && tlsSite >= 0 && jsonSite >= 0 && bootSite >= 0);
+    if (leakSite < 0 || tlsSite < 0 || jsonSite < 0 || bootSite < 0) return;
+
+    // Only the leaking site is flagged
+    CHECK(heapProfiler().getSite(leakSite).liveBytes == (size_t)SOAK_TURNS * 256);
+    CHECK(heapProfiler().isLeakCandidate(leakSite, now));
+    CHECK(!heapProfiler().isLeakCandidate(tlsSite, now));
+    CHECK(!heapProfiler().isLeakCandidate(jsonSite, now));
+    CHECK(!heapProfiler().isLeakCandidate(bootSite, now));
+
+    // The leaked blocks land past the TLS buffer's hole and pin
+    // the heap, so the largest free block keeps shrinking
+    int n = heapProfiler().getSampleCount();
+    CHECK(n == 1 + SOAK_TURNS / 2);
+    HeapSample first = heapProfiler().getSample(0);
+    HeapSample last = heapProfiler().getSample(n - 1);
+    HeapSample middle = heapProfiler().getSample(n / 2);
+    CHECK(middle.internalLargest < first.internalLargest);
+    CHECK(last.internalLargest < middle.internalLargest);
+    CHECK(last.internalMin <= last.internalFree);
+    printf("soak: largest internal block %u -> %u bytes over %d turns (frag %u%%)\n",
+           (unsigned)first.internalLargest, (unsigned)last.internalLargest, SOAK_TURNS,
+           heapFragPercent(last.internalFree, last.internalLargest));
+    CHECK(last.trackedBytes == heapProfiler().getTrackedBytes());
+    CHECK(heapFragPercent(last.internalFree, last.internalLargest) >
+          heapFragPercent(first.internalFree, first.internalLargest));
+
+    Capture out;
+    heapProfiler().dump(out, now);
+    std::string leakLine = std::string("Leak candidates:\n  ") +
+                           heapSiteName(heapProfiler().getSite(leakSite).name);
+    CHECK(out.has(leakLine.c_str()));
+    CHECK(out.has("+15360 bytes since baseline, 60 blocks"));
+    CHECK(!out.has("  none\n"));
+
+    // Same run, same numbers: placement is deterministic
+    freeSoak(st);
+    VOLT_FREE(boot);
+    CHECK(nativeHeapInternal().getBlockCount() == 0);
+    SoakState again = {};
+    runSoak(again, &boot);
+    HeapSample rerun = heapProfiler().getSample(heapProfiler().getSampleCount() - 1);
+    CHECK(rerun.internalLargest == last.internalLargest);
+    CHECK(rerun.internalFree == last.internalFree);
+    freeSoak(again);
+    VOLT_FREE(boot);
+}
+
+// ============================================
+// DUMP AND POOLS
+// ============================================
+
+static void testDump() {
+    resetProfiler();
+    void* p = VOLT_PS_MALLOC(1000);
+    heapProfiler().tick(0);
+
+    Capture out;
+    heapProfileDump(out);
+    CHECK(out.has("=== Heap (uptime 0 s) ==="));
+    CHECK(out.has("Internal: free 65536, largest 65536 (frag 0%), min free 65536"));
+    CHECK(out.has("PSRAM:    free 261144"));
+    CHECK(out.has("Sites (1):"));
+    CHECK(out.has("heap_profiler_test.cpp:"));
+    CHECK(out.has("Leak candidates:\n  none\n"));
+    VOLT_FREE(p);
+}
+
+static void testPools() {
+    resetProfiler();
+    static const PoolBucketConfig layout[] = {
+        { "capture", 32 * 1024, 1, MEM_CAP_SPIRAM, MEM_CAP_INTERNAL },
+        { "tts",     4096,      2, MEM_CAP_DMA,    MEM_CAP_INTERNAL }
+    };
+    {
+        MemPools pools;
+        CHECK(pools.begin(layout, 2));
+        CHECK(nativeHeapPsram().getFree() == 256 * 1024 - 32 * 1024);
+        CHECK(nativeHeapInternal().getFree() == 64 * 1024 - 8192);
+
+        // Each bucket is a site under its own name
+        int capture = findSite("capture");
+        int tts = findSite("tts");
+        CHECK(capture >= 0 && tts >= 0);
+        if (capture >= 0) CHECK(heapProfiler().getSite(capture).liveBytes == 32 * 1024);
+
+        // Reserved at boot and never freed: not a leak
+        heapProfiler().markBaseline();
+        halDelay(60 * 60 * 1000UL);
+        if (capture >= 0) CHECK(!heapProfiler().isLeakCandidate(capture, (uint32_t)halMillis()));
+    }
+
+    // No PSRAM: the capture bucket falls back into internal RAM
+    resetProfiler();
+    nativeHal().psram = false;
+    MemPools small;
+    CHECK(small.begin(layout, 2));
+    CHECK(small.getBucketStats(0).placedCaps == MEM_CAP_INTERNAL);
+    int capture = findSite("capture");
+    CHECK(capture >= 0 && heapProfiler().getSite(capture).failures == 1);
+}
+
+int main() {
+    testModel();
+    testHalHeap();
+    testSites();
+    testLiveTableFull();
+    testSamples();
+    testSoak();
+    testDump();
+    testPools();
+
+    return testSummary();
+}
@@ -0,0 +1,142 @@
+/*
+ * ============================================
+ * Memory Pool Layout Tests (host)
+ * ============================================
+ *
+ * Reserves the sketch's VOLT_POOL_LAYOUT
+ * (volt_ai_FINAL.h) under the S3's budgets,
+ * once per board in board_traits.h
+ * (mem_pools_test for the HU-087 with 8 MB
+ * PSRAM, mem_pools_ssd1306_test with
+ * VOLT_BOARD_SSD1306 and none):
+ * - The layout as configured fits, with a TLS
+ *   session's worth of internal RAM left over
+ * - Where each bucket lands: PSRAM, or internal
+ *   RAM when there is none; the streaming
+ *   buffers DMA-capable either way
+ * - Every feature on (Realtime and HTTP/2):
+ *   fits with PSRAM; without, the HTTP/2
+ *   windows are the part that doesn't
+ *
+ * Needs ArduinoJson (for the layout); built and
+ * run by CMakeLists.txt (ctest) when it is found.
+ *
+ * ============================================
+ */
+
+#include "volt_ai_FINAL.h"
+#include "test_check.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Heap left for the app on an S3 (native_heap.h), and what has to
+// stay free of the pools: a TLS session's records and handshake,
+// and the task stacks
+static const size_t S3_INTERNAL = 320 * 1024;
+static const size_t INTERNAL_RESERVE = 64 * 1024;
+static const size_t S3_PSRAM = 8 * 1024 * 1024;
+
+static const int LAYOUT_COUNT = sizeof(VOLT_POOL_LAYOUT) / sizeof(VOLT_POOL_LAYOUT[0]);
+
+static int findBucket(const MemPools& pools, const char* name) {
+    for (int i = 0; i < pools.getBucketCount(); i++) {
+        if (strcmp(pools.getBucketStats(i).name, name) == 0) return i;
+    }
+    return -1;
+}
+
+static uint8_t placed(const MemPools& pools, const char* name) {
+    int i = findBucket(pools, name);
+    return i < 0 ? (uint8_t)MEM_CAP_NONE : pools.getBucketStats(i).placedCaps;
+}
+
+static void budget(MemPools& pools) {
+    pools.setBudget(MEM_REGION_INTERNAL, S3_INTERNAL - INTERNAL_RESERVE);
+    if (Board::PSRAM) pools.setBudget(MEM_REGION_SPIRAM, S3_PSRAM);
+}
+
+// The layout as the sketch reserves it
+static void testConfigured() {
+    nativeHal().psram = Board::PSRAM;
+    MemPools& pools = memPools();
+    CHECK(pools.getRegionBudget(MEM_REGION_SPIRAM) == (Board::PSRAM ? (size_t)-1 : 0));
+    budget(pools);
+    CHECK(pools.begin(VOLT_POOL_LAYOUT, LAYOUT_COUNT));
+    pools.printReport();
+
+    size_t internal = pools.getRegionUsed(MEM_REGION_INTERNAL);
+    size_t psram = pools.getRegionUsed(MEM_REGION_SPIRAM);
+    CHECK(internal <= S3_INTERNAL - INTERNAL_RESERVE);
+    CHECK(halHeapInfo(HAL_HEAP_INTERNAL).freeBytes >= INTERNAL_RESERVE);
+
+    uint8_t big = Board::PSRAM ? MEM_CAP_SPIRAM : MEM_CAP_INTERNAL;
+    CHECK(placed(pools, "capture") == big);
+    CHECK(placed(pools, "arena") == big);
+    CHECK(placed(pools, "tts") == (MEM_CAP_DMA | MEM_CAP_INTERNAL));
+    CHECK(placed(pools, "http") == MEM_CAP_INTERNAL);
+    CHECK((findBucket(pools, "event") >= 0) == USE_REALTIME_MODE);
+    CHECK((findBucket(pools, "h2") >= 0) == USE_HTTP2);
+    if (Board::PSRAM) {
+        CHECK(internal == 2 * TTS_JITTER_BUFFER + 2 * HTTP_BUFFER_SIZE);
+    } else {
+        CHECK(psram == 0);
+    }
+
+    // The streaming buffers are served DMA-capable
+    void* a = pools.alloc(TTS_JITTER_BUFFER, MEM_CAP_DMA);
+    void* b = pools.alloc(TTS_JITTER_BUFFER, MEM_CAP_DMA);
+    CHECK(a && b && findBucket(pools, "tts") >= 0);
+    CHECK(!pools.alloc(TTS_JITTER_BUFFER, MEM_CAP_DMA));     // Two blocks
+    pools.free(a);
+    pools.free(b);
+    printf("  %s: internal %u bytes, PSRAM %u bytes\n", Board::name(), (unsigned)internal,
+           (unsigned)psram);
+}
+
+// Realtime's event buffer and the HTTP/2 windows on as well
+static void testAllFeatures() {
+    PoolBucketConfig layout[LAYOUT_COUNT];
+    memcpy(layout, VOLT_POOL_LAYOUT, sizeof(layout));
+    for (PoolBucketConfig& cfg : layout) {
+        if (strcmp(cfg.name, "event") == 0) cfg.blockCount = 1;
+        if (strcmp(cfg.name, "h2") == 0) cfg.blockCount = H2_MAX_STREAMS + 1;
+    }
+
+    // Same budgets as memPools() (before the sketch's begin())
+    nativeHal().psram = Board::PSRAM;
+    MemPools pools;
+    pools.setBudget(MEM_REGION_SPIRAM, memPools().getRegionBudget(MEM_REGION_SPIRAM));
+    budget(pools);
+    bool ok = pools.begin(layout, LAYOUT_COUNT);
+    pools.printReport();
+
+    if (Board::PSRAM) {
+        CHECK(ok);
+        CHECK(placed(pools, "event") == MEM_CAP_SPIRAM);
+        CHECK(placed(pools, "h2") == MEM_CAP_SPIRAM);
+        CHECK(pools.getRegionUsed(MEM_REGION_INTERNAL) ==
+              2 * TTS_JITTER_BUFFER + 2 * HTTP_BUFFER_SIZE);
+    } else {
+        // 4 x 16 KB of windows on top of 156 KB of capture: too much
+        CHECK(!ok);
+        CHECK(placed(pools, "event") == MEM_CAP_INTERNAL);
+        CHECK(findBucket(pools, "h2") < 0);
+        CHECK(findBucket(pools, "capture") >= 0 && findBucket(pools, "arena") >= 0);
+    }
+    CHECK(pools.getRegionUsed(MEM_REGION_INTERNAL) <= S3_INTERNAL - INTERNAL_RESERVE);
+    CHECK(halHeapInfo(HAL_HEAP_INTERNAL).freeBytes >= INTERNAL_RESERVE);
+
+    // Hand the heaps back for the sketch's own pools
+    nativeHeapInternal().reset();
+    nativeHeapPsram().reset();
+}
+
+int main() {
+    resetHal();
+
+    testAllFeatures();
+    testConfigured();
+
+    return testSummary();
+}
@@ -0,0 +1,310 @@
+/*
+ * ============================================
+ * Metrics Tests (host)
+ * ============================================
+ *
+ * Runs metrics.h on the native HAL: the text
+ * exposition format (HELP/TYPE once per family,
+ * labels, cumulative buckets, +Inf, _sum and
+ * _count), HTTP status classes, registration
+ * limits, collectors, and counters and
+ * histograms updated from several threads while
+ * another one scrapes.
+ *
+ * Built by CMakeLists.txt (ctest).
+ *
+ * ============================================
+ */
+
+#include "metrics.h"
+#include "test_check.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+// Collects a scrape
+class Capture : public Print {
+public:
+    std::string text;
+
+    size_t write(uint8_t b) override {
+        text += (char)b;
+        return 1;
+    }
+
+    size_t write(const uint8_t* buf, size_t size) override {
+        text.append((const char*)buf, size);
+        return size;
+    }
+
+    bool has(const char* s) const { return text.find(s) != std::string::npos; }
+};
+
+static const uint32_t MS_BUCKETS[] = { 10, 100, 1000 };
+
+static int32_t readAnswer() {
+    return 42;
+}
+
+static void testFormat() {
+    resetHal();
+    MetricsRegistry reg;
+    MetricCounter ok("volt_wifi_reconnects_total", "WiFi reconnect attempts", "result=\"ok\"");
+    MetricCounter failed("volt_wifi_reconnects_total", "WiFi reconnect attempts", "result=\"failed\"");
+    MetricGauge battery("volt_battery_percent", "Battery charge");
+    MetricGauge answer("volt_answer", "Read at scrape time", nullptr, readAnswer);
+    MetricHistogram loop("volt_loop_latency_ms", "Loop pass", MS_BUCKETS, 3);
+
+    CHECK(reg.add(&ok));
+    CHECK(reg.add(&battery));
+    CHECK(reg.add(&failed));           // Same family, added later
+    CHECK(reg.add(&answer));
+    CHECK(reg.add(&loop));
+    CHECK(reg.getCount() == 5);
+
+    ok.inc();
+    ok.inc(2);
+    failed.inc();
+    battery.set(87);
+    battery.add(-2);
+    loop.observe(3);
+    loop.observe(10);                  // On a bound: counted in it
+    loop.observe(11);
+    loop.observe(5000);
+
+    Capture out;
+    reg.write(out);
+    CHECK(out.text ==
+          "# HELP volt_wifi_reconnects_total WiFi reconnect attempts\n"
+          "# TYPE volt_wifi_reconnects_total counter\n"
+          "volt_wifi_reconnects_total{result=\"ok\"} 3\n"
+          "volt_wifi_reconnects_total{result=\"failed\"} 1\n"
+          "# HELP volt_battery_percent Battery charge\n"
+          "# TYPE volt_battery_percent gauge\n"
+          "volt_battery_percent 85\n"
+          "# HELP volt_answer Read at scrape time\n"
+          "# TYPE volt_answer gauge\n"
+          "volt_answer 42\n"
+          "# HELP volt_loop_latency_ms Loop pass\n"
+          "# TYPE volt_loop_latency_ms histogram\n"
+          "volt_loop_latency_ms_bucket{le=\"10\"} 2\n"
+          "volt_loop_latency_ms_bucket{le=\"100\"} 3\n"
+          "volt_loop_latency_ms_bucket{le=\"1000\"} 3\n"
+          "volt_loop_latency_ms_bucket{le=\"+Inf\"} 4\n"
+          "volt_loop_latency_ms_sum 5024\n"
+          "volt_loop_latency_ms_count 4\n");
+
+    // Labels come before le
+    MetricHistogram labelled("volt_h", "h", MS_BUCKETS, 1, "endpoint=\"chat\"");
+    labelled.observe(7);
+    Capture h;
+    labelled.write(h);
+    CHECK(h.text ==
+          "volt_h_bucket{endpoint=\"chat\",le=\"10\"} 1\n"
+          "volt_h_bucket{endpoint=\"chat\",le=\"+Inf\"} 1\n"
+          "volt_h_sum{endpoint=\"chat\"} 7\n"
+          "volt_h_count{endpoint=\"chat\"} 1\n");
+
+    // Negative gauges and counters past 2^31
+    MetricGauge temp("volt_t", "t");
+    temp.set(-40);
+    MetricCounter big("volt_big_total", "b");
+    big.inc(3000000000u);
+    Capture g;
+    temp.write(g);
+    big.write(g);
+    CHECK(g.text == "volt_t -40\nvolt_big_total 3000000000\n");
+}
+
+static void testHttpCodes() {
+    resetHal();
+    MetricHttpCodes codes("volt_ai_responses_total", "Responses", "chat");
+    codes.count(200);
+    codes.count(401);
+    codes.count(401);
+    codes.count(429);
+    codes.count(404);
+    codes.count(503);
+    codes.count(-1);                   // No status line
+    codes.count(0);
+    codes.count(204);                  // Not what the engine expects
+    CHECK(codes.get(200) == 1);
+    CHECK(codes.get(401) == 2);
+    CHECK(codes.get(429) == 1);
+    CHECK(codes.get(400) == 2);        // 404 and 204
+    CHECK(codes.get(500) == 1);
+    CHECK(codes.get(-5) == 2);
+
+    MetricsRegistry reg;
+    reg.add(codes);
+    CHECK(reg.getCount() == MetricHttpCodes::CLASSES);
+    CHECK(reg.find("volt_ai_responses_total", "endpoint=\"chat\",code=\"401\"") == &codes.counter(1));
+
+    Capture out;
+    reg.write(out);
+    CHECK(out.has("# TYPE volt_ai_responses_total counter\n"
+                  "volt_ai_responses_total{endpoint=\"chat\",code=\"200\"} 1\n"
+                  "volt_ai_responses_total{endpoint=\"chat\",code=\"401\"} 2\n"
+                  "volt_ai_responses_total{endpoint=\"chat\",code=\"429\"} 1\n"
+                  "volt_ai_responses_total{endpoint=\"chat\",code=\"4xx\"} 2\n"
+                  "volt_ai_responses_total{endpoint=\"chat\",code=\"5xx\"} 1\n"
+                  "volt_ai_responses_total{endpoint=\"chat\",code=\"none\"} 2\n"));
+}
+
+static void writeExtra(Print& out) {
+    out.print("volt_extra 1\n");
+}
+
+static void testRegistry() {
+    resetHal();
+    MetricsRegistry reg;
+    MetricCounter a("volt_a_total", "a");
+    MetricCounter sameName("volt_a_total", "a");
+    CHECK(reg.add(&a));
+    CHECK(!reg.add(&a));               // Twice is a no-op
+    CHECK(!reg.add(&sameName));        // Same name and labels
+    CHECK(reg.find("volt_a_total") == &a);
+    CHECK(reg.find("volt_b_total") == nullptr);
+
+    // A full table refuses more
+    std::vector<MetricCounter*> many;
+    char labels[MetricsRegistry::MAX_METRICS][16];
+    for (int i = 0; i < MetricsRegistry::MAX_METRICS; i++) {
+        snprintf(labels[i], sizeof(labels[i]), "n=\"%d\"", i);
+        many.push_back(new MetricCounter("volt_n_total", "n", labels[i]));
+    }
+    int added = 0;
+    for (MetricCounter* m : many) {
+        if (reg.add(m)) added++;
+    }
+    CHECK(added == MetricsRegistry::MAX_METRICS - 1);
+    CHECK(reg.getCount() == MetricsRegistry::MAX_METRICS);
+
+    // Collectors go after the registered metrics
+    CHECK(reg.addCollector(writeExtra));
+    Capture out;
+    reg.write(out);
+    CHECK(out.text.size() > 20 && out.text.compare(out.text.size() - 13, 13, "volt_extra 1\n") == 0);
+    size_t headers = 0;
+    for (size_t at = 0; (at = out.text.find("# TYPE volt_n_total", at)) != std::string::npos; at++) {
+        headers++;
+    }
+    CHECK(headers == 1);
+
+    for (int i = 1; i < MetricsRegistry::MAX_COLLECTORS; i++) {
+        CHECK(reg.addCollector(writeExtra));
+    }
+    CHECK(!reg.addCollector(writeExtra));
+
+    reg.clear();
+    CHECK(reg.getCount() == 0);
+    Capture empty;
+    reg.write(empty);
+    CHECK(empty.text.empty());
+    for (MetricCounter* m : many) {
+        delete m;
+    }
+}
+
+// Cumulative bucket values of one scrape, in order
+static std::vector<uint64_t> bucketValues(const std::string& text, const char* name) {
+    std::vector<uint64_t> values;
+    std::string key = std::string(name) + "_bucket{";
+    for (size_t at = 0; (at = text.find(key, at)) != std::string::npos; at++) {
+        size_t sp = text.find("} ", at);
+        values.push_back(strtoull(text.c_str() + sp + 2, nullptr, 10));
+    }
+    std::string count = std::string(name) + "_count ";
+    size_t at = text.find(count);
+    values.push_back(at == std::string::npos ? 0 : strtoull(text.c_str() + at + count.size(), nullptr, 10));
+    return values;
+}
+
+// Updates from several threads while another scrapes: nothing is
+// lost, and every scrape is self-consistent
+static void testConcurrency() {
+    resetHal();
+    MetricsRegistry reg;
+    MetricCounter requests("volt_requests_total", "r");
+    MetricGauge depth("volt_depth", "d");
+    MetricHistogram latency("volt_latency_ms", "l", MS_BUCKETS, 3);
+    reg.add(&requests);
+    reg.add(&depth);
+    reg.add(&latency);
+
+    const int threads = 4;
+    const uint32_t perThread = 50000;
+    std::atomic<bool> done(false);
+    int scrapes = 0;
+    int badScrapes = 0;
+
+    std::thread scraper([&]() {
+        while (!done.load()) {
+            Capture out;
+            reg.write(out);
+            std::vector<uint64_t> v = bucketValues(out.text, "volt_latency_ms");
+            bool ok = v.size() == 5;
+            for (size_t i = 1; ok && i < v.size(); i++) {
+                ok = v[i] >= v[i - 1];
+            }
+            if (ok) ok = v[4] == v[3];        // _count is the +Inf bucket
+            if (!ok) badScrapes++;
+            scrapes++;
+        }
+    });
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            for (uint32_t i = 0; i < perThread; i++) {
+                requests.inc();
+                depth.add(1);
+                latency.observe((i + t) % 2000);
+                depth.add(-1);
+            }
+        });
+    }
+    for (std::thread& w : workers) {
+        w.join();
+    }
+    done.store(true);
+    scraper.join();
+
+    const uint32_t total = threads * perThread;
+    CHECK(requests.get() == total);
+    CHECK(depth.get() == 0);
+    CHECK(latency.getCount() == total);
+    CHECK(scrapes > 0);
+    CHECK(badScrapes == 0);
+
+    // Every value 0..1999 equally often (per thread, shifted by t)
+    uint64_t sum = 0;
+    uint32_t upTo10 = 0;
+    for (int t = 0; t < threads; t++) {
+        for (uint32_t i = 0; i < perThread; i++) {
+            uint32_t v = (i + t) % 2000;
+            sum += v;
+            if (v <= 10) upTo10++;
+        }
+    }
+    CHECK(latency.getSum() == sum);
+    CHECK(latency.getBucket(0) == upTo10);
+
+    Capture last;
+    reg.write(last);
+    char expect[64];
+    snprintf(expect, sizeof(expect), "volt_requests_total %u\n", (unsigned)total);
+    CHECK(last.has(expect));
+    snprintf(expect, sizeof(expect), "volt_latency_ms_count %u\n", (unsigned)total);
+    CHECK(last.has(expect));
+}
+
+int main() {
+    testFormat();
+    testHttpCodes();
+    testRegistry();
+    testConcurrency();
+
+    return testSummary();
+}
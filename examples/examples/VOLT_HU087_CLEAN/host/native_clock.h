@@ -0,0 +1,77 @@
+/*
+ * ============================================
+ * Native HAL - Clock
+ * ============================================
+ *
+ * Handles:
+ * - Real time (monotonic clock, delay sleeps)
+ * - Virtual time (delay advances instantly)
+ *
+ * Shared by the Arduino shim and the native HAL
+ * so millis() and halMillis() never disagree.
+ *
+ * Use virtual time for logic tests (power
+ * manager, button) and real time for anything
+ * that waits on a socket: with a virtual clock
+ * a 15 s network timeout passes in 15000 spins.
+ *
+ * ============================================
+ */
+
+#ifndef NATIVE_CLOCK_H
+#define NATIVE_CLOCK_H
+
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+class NativeClock {
+private:
+    bool virtualTime;
+    uint64_t virtualUs;
+    uint64_t startUs;
+
+    static uint64_t monotonicUs() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+    }
+
+public:
+    NativeClock() : virtualTime(false), virtualUs(0), startUs(monotonicUs()) {}
+
+    // Switching mode restarts the clock at 0
+    void setVirtual(bool on) {
+        virtualTime = on;
+        virtualUs = 0;
+        startUs = monotonicUs();
+    }
+
+    bool isVirtual() const { return virtualTime; }
+
+    uint64_t nowUs() const {
+        return virtualTime ? virtualUs : monotonicUs() - startUs;
+    }
+
+    void sleepUs(uint64_t us) {
+        if (virtualTime) {
+            virtualUs += us;
+        } else if (us > 0) {
+            usleep((useconds_t)us);
+        }
+    }
+
+    // Virtual time only: move the clock without a delay() call
+    void advanceUs(uint64_t us) {
+        if (virtualTime) {
+            virtualUs += us;
+        }
+    }
+};
+
+inline NativeClock& nativeClock() {
+    static NativeClock clock;
+    return clock;
+}
+
+#endif // NATIVE_CLOCK_H
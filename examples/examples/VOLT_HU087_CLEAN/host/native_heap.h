@@ -0,0 +1,164 @@
+/*
+ * ============================================
+ * Native HAL - Heap Model
+ * ============================================
+ *
+ * Handles:
+ * - The watch's two heap regions (internal
+ *   SRAM and PSRAM) as fixed-size arenas
+ * - First-fit placement with block splitting
+ *   and coalescing on free, like the ESP-IDF
+ *   heap
+ * - Free bytes, largest free block and the
+ *   low-water mark, for halHeapInfo()
+ *
+ * Placement only depends on the order of
+ * allocations and frees, so fragmentation in a
+ * soak test comes out the same on every run.
+ * Only memory that goes through halHeapAlloc()
+ * is modeled; Strings and the TLS client use
+ * the host's malloc.
+ *
+ * ============================================
+ */
+
+#ifndef NATIVE_HEAP_H
+#define NATIVE_HEAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <iterator>
+#include <map>
+#include <mutex>
+
+class NativeHeap {
+public:
+    static const size_t ALIGN = 8;
+
+private:
+    size_t capacity;
+    uint8_t* base;               // Backing store, allocated on first use
+    std::map<size_t, size_t> freeBlocks;   // offset -> size
+    std::map<size_t, size_t> usedBlocks;
+    size_t freeBytes;
+    size_t minFree;
+    std::mutex lock;
+
+    void ensureBase() {
+        if (!base) {
+            base = (uint8_t*)malloc(capacity);
+        }
+    }
+
+public:
+    explicit NativeHeap(size_t bytes) : capacity(bytes), base(nullptr) {
+        reset();
+    }
+
+    ~NativeHeap() { ::free(base); }
+
+    // Forget every block (only when nothing still points into it)
+    void reset() {
+        std::lock_guard<std::mutex> guard(lock);
+        freeBlocks.clear();
+        usedBlocks.clear();
+        freeBlocks[0] = capacity;
+        freeBytes = minFree = capacity;
+    }
+
+    // Shrink or grow the region (resets it)
+    void resize(size_t bytes) {
+        ::free(base);
+        base = nullptr;
+        capacity = bytes;
+        reset();
+    }
+
+    size_t getCapacity() const { return capacity; }
+
+    void* alloc(size_t size) {
+        if (size == 0) size = 1;
+        size = (size + ALIGN - 1) & ~(ALIGN - 1);
+        std::lock_guard<std::mutex> guard(lock);
+        ensureBase();
+        if (!base) return nullptr;
+        for (auto it = freeBlocks.begin(); it != freeBlocks.end(); ++it) {
+            if (it->second < size) continue;
+            size_t offset = it->first;
+            size_t left = it->second - size;
+            freeBlocks.erase(it);
+            if (left > 0) {
+                freeBlocks[offset + size] = left;
+            }
+            usedBlocks[offset] = size;
+            freeBytes -= size;
+            if (freeBytes < minFree) minFree = freeBytes;
+            return base + offset;
+        }
+        return nullptr;
+    }
+
+    bool owns(const void* p) const {
+        return base && (const uint8_t*)p >= base && (const uint8_t*)p < base + capacity;
+    }
+
+    // false if p isn't a live block of this heap
+    bool free(void* p) {
+        if (!owns(p)) return false;
+        std::lock_guard<std::mutex> guard(lock);
+        size_t offset = (size_t)((uint8_t*)p - base);
+        auto used = usedBlocks.find(offset);
+        if (used == usedBlocks.end()) return false;
+        size_t size = used->second;
+        usedBlocks.erase(used);
+        freeBytes += size;
+
+        auto next = freeBlocks.find(offset + size);
+        if (next != freeBlocks.end()) {
+            size += next->second;
+            freeBlocks.erase(next);
+        }
+        auto it = freeBlocks.lower_bound(offset);
+        if (it != freeBlocks.begin()) {
+            auto prev = std::prev(it);
+            if (prev->first + prev->second == offset) {
+                prev->second += size;
+                return true;
+            }
+        }
+        freeBlocks[offset] = size;
+        return true;
+    }
+
+    size_t getFree() const { return freeBytes; }
+    size_t getMinFree() const { return minFree; }
+
+    size_t getLargestFree() {
+        std::lock_guard<std::mutex> guard(lock);
+        size_t largest = 0;
+        for (const auto& block : freeBlocks) {
+            if (block.second > largest) largest = block.second;
+        }
+        return largest;
+    }
+
+    size_t getBlockCount() {
+        std::lock_guard<std::mutex> guard(lock);
+        return usedBlocks.size();
+    }
+};
+
+// Heap left for the app on an S3 with 8 MB PSRAM, after the
+// WiFi stack and Arduino core have taken theirs
+inline NativeHeap& nativeHeapInternal() {
+    static NativeHeap heap(320 * 1024);
+    return heap;
+}
+
+inline NativeHeap& nativeHeapPsram() {
+    static NativeHeap heap(8 * 1024 * 1024);
+    return heap;
+}
+
+#endif // NATIVE_HEAP_H
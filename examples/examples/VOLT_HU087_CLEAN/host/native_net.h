@@ -0,0 +1,385 @@
+/*
+ * ============================================
+ * Native HAL - Sockets and TLS
+ * ============================================
+ *
+ * Handles:
+ * - NativeTlsClient, the host HalTlsClient
+ *   (same calls the engine makes on the
+ *   ESP32's WiFiClientSecure)
+ * - Routes: send a host:port the firmware
+ *   hard-codes (api.openai.com:443) to a local
+ *   stand-in server, with or without TLS
+ * - TLS through OpenSSL when built with
+ *   VOLT_HOST_OPENSSL, else plain TCP only
+ * - Bad networks on demand: every byte goes
+ *   through a NetShaper (net_impair.h)
+ *
+ * Reads are non-blocking like the ESP32 client:
+ * available() and read() never wait. Except
+ * with a virtual clock, where the peer is still
+ * a real thread: an empty read waits up to 1 ms
+ * of real time for it, so a 15 s timeout can't
+ * pass in 15000 spins while it is answering.
+ *
+ * ============================================
+ */
+
+#ifndef NATIVE_NET_H
+#define NATIVE_NET_H
+
+#include "Client.h"
+#include "net_impair.h"
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+
+#ifdef VOLT_HOST_OPENSSL
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#endif
+
+// ============================================
+// ROUTES
+// ============================================
+
+struct NativeRoute {
+    char host[64];
+    uint16_t port;
+    char targetHost[64];
+    uint16_t targetPort;
+    bool tls;
+};
+
+class NativeRoutes {
+public:
+    static const int MAX_ROUTES = 8;
+
+private:
+    NativeRoute routes[MAX_ROUTES];
+    int count;
+
+public:
+    NativeRoutes() : count(0) {}
+
+    // Connections to host:port go to targetHost:targetPort instead
+    bool add(const char* host, uint16_t port, const char* targetHost, uint16_t targetPort, bool tls) {
+        if (count >= MAX_ROUTES || strlen(host) >= 64 || strlen(targetHost) >= 64) {
+            return false;
+        }
+        NativeRoute& r = routes[count++];
+        strcpy(r.host, host);
+        r.port = port;
+        strcpy(r.targetHost, targetHost);
+        r.targetPort = targetPort;
+        r.tls = tls;
+        return true;
+    }
+
+    void clear() { count = 0; }
+
+    const NativeRoute* find(const char* host, uint16_t port) const {
+        for (int i = 0; i < count; i++) {
+            if (routes[i].port == port && strcmp(routes[i].host, host) == 0) {
+                return &routes[i];
+            }
+        }
+        return nullptr;
+    }
+};
+
+inline NativeRoutes& nativeRoutes() {
+    static NativeRoutes routes;
+    return routes;
+}
+
+// ============================================
+// CLIENT
+// ============================================
+
+class NativeTlsClient : public Client {
+private:
+    static const size_t RX_SIZE = 4096;
+
+    int fd;
+    bool insecure;
+    const char** alpn;
+    uint8_t rx[RX_SIZE];
+    size_t rxStart;
+    size_t rxReady;              // [rxReady, rxEnd) is still in flight (shaper latency)
+    size_t rxEnd;
+    bool peerClosed;
+    NetShaper shaper;
+
+#ifdef VOLT_HOST_OPENSSL
+    SSL_CTX* ctx;
+    SSL* ssl;
+
+    bool startTls(const char* serverName) {
+        ctx = SSL_CTX_new(TLS_client_method());
+        if (!ctx) return false;
+        if (insecure) {
+            SSL_CTX_set_verify(ctx, SSL_VERIFY_NONE, nullptr);
+        } else {
+            SSL_CTX_set_default_verify_paths(ctx);
+            SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER, nullptr);
+        }
+        if (alpn) {
+            uint8_t wire[64];
+            size_t len = 0;
+            for (const char** p = alpn; *p; p++) {
+                size_t n = strlen(*p);
+                if (len + 1 + n > sizeof(wire)) break;
+                wire[len++] = (uint8_t)n;
+                memcpy(wire + len, *p, n);
+                len += n;
+            }
+            SSL_CTX_set_alpn_protos(ctx, wire, (unsigned)len);
+        }
+        ssl = SSL_new(ctx);
+        SSL_set_fd(ssl, fd);
+        SSL_set_tlsext_host_name(ssl, serverName);
+        if (!insecure) {
+            SSL_set1_host(ssl, serverName);
+        }
+        if (SSL_connect(ssl) != 1) {
+            ERR_print_errors_fp(stderr);
+            return false;
+        }
+        return true;
+    }
+#endif
+
+    bool openSocket(const char* host, uint16_t port) {
+        struct addrinfo hints;
+        struct addrinfo* res = nullptr;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_socktype = SOCK_STREAM;
+        char portStr[8];
+        snprintf(portStr, sizeof(portStr), "%u", port);
+        if (getaddrinfo(host, portStr, &hints, &res) != 0 || !res) {
+            return false;
+        }
+        fd = socket(res->ai_family, SOCK_STREAM, 0);
+        bool ok = fd >= 0 && ::connect(fd, res->ai_addr, res->ai_addrlen) == 0;
+        freeaddrinfo(res);
+        if (ok) {
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+        return ok;
+    }
+
+    // Raw transport: everything on the wire passes through these two
+    ssize_t rawSend(const uint8_t* buf, size_t size) {
+#ifdef VOLT_HOST_OPENSSL
+        if (ssl) {
+            int n = SSL_write(ssl, buf, (int)size);
+            return n > 0 ? n : -1;
+        }
+#endif
+        ssize_t n;
+        do {
+            n = send(fd, buf, size, MSG_NOSIGNAL);
+        } while (n < 0 && errno == EINTR);
+        return n;
+    }
+
+    // > 0 bytes read, 0 peer closed, -1 nothing yet (or error)
+    ssize_t rawRecv(uint8_t* buf, size_t size) {
+#ifdef VOLT_HOST_OPENSSL
+        if (ssl) {
+            if (SSL_pending(ssl) == 0) {
+                uint8_t probe;
+                ssize_t n = recv(fd, &probe, 1, MSG_PEEK | MSG_DONTWAIT);
+                if (n == 0) return 0;
+                if (n < 0) return -1;
+            }
+            int n = SSL_read(ssl, buf, (int)size);
+            if (n > 0) return n;
+            int err = SSL_get_error(ssl, n);
+            return (err == SSL_ERROR_ZERO_RETURN) ? 0 : -1;
+        }
+#endif
+        ssize_t n = recv(fd, buf, size, MSG_DONTWAIT);
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            return 0;
+        }
+        return n;
+    }
+
+    // The shaper cut the link: both ends see it drop
+    void cutLink() {
+        shutdown(fd, SHUT_RDWR);
+        peerClosed = true;
+    }
+
+    void fill() {
+        if (fd < 0) return;
+        rxReady += shaper.release();
+        if (peerClosed) return;
+        if (shaper.isCut()) {
+            cutLink();
+            return;
+        }
+        if (rxStart == rxEnd) {
+            rxStart = rxReady = rxEnd = 0;
+        }
+        if (rxEnd == RX_SIZE) return;
+        size_t room = shaper.recvBudget(RX_SIZE - rxEnd);
+        if (room == 0) return;
+        if (rxStart == rxEnd && nativeClock().isVirtual()) {
+            struct pollfd pfd = { fd, POLLIN, 0 };
+            poll(&pfd, 1, 1);
+        }
+        ssize_t n = rawRecv(rx + rxEnd, room);
+        if (n > 0) {
+            rxEnd += (size_t)n;
+            rxReady += shaper.received((size_t)n);
+        } else if (n == 0) {
+            peerClosed = true;
+        }
+    }
+
+public:
+    NativeTlsClient()
+        : fd(-1), insecure(false), alpn(nullptr), rxStart(0), rxReady(0), rxEnd(0), peerClosed(false) {
+#ifdef VOLT_HOST_OPENSSL
+        ctx = nullptr;
+        ssl = nullptr;
+#endif
+    }
+
+    ~NativeTlsClient() { stop(); }
+
+    void setInsecure() { insecure = true; }
+    void setAlpnProtocols(const char** protocols) { alpn = protocols; }
+
+    int connect(const char* host, uint16_t port) override {
+        stop();
+        const NativeRoute* route = nativeRoutes().find(host, port);
+        const char* target = route ? route->targetHost : host;
+        uint16_t targetPort = route ? route->targetPort : port;
+        bool tls = route ? route->tls : (port == 443);
+
+        if (!openSocket(target, targetPort)) {
+            stop();
+            return 0;
+        }
+        if (tls) {
+#ifdef VOLT_HOST_OPENSSL
+            if (!startTls(host)) {
+                stop();
+                return 0;
+            }
+#else
+            fprintf(stderr, "Net: %s:%u needs TLS (build with OpenSSL or add a plain route)\n",
+                host, port);
+            stop();
+            return 0;
+#endif
+        }
+        shaper.begin();
+        return 1;
+    }
+
+    int connect(IPAddress ip, uint16_t port) override {
+        char host[16];
+        snprintf(host, sizeof(host), "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+        return connect(host, port);
+    }
+
+    // WiFiClientSecure's connect-by-address-with-SNI form
+    int connect(IPAddress, uint16_t port, const char* host, const char*, const char*, const char*) {
+        return connect(host, port);
+    }
+
+    size_t write(uint8_t b) override {
+        return write(&b, 1);
+    }
+
+    size_t write(const uint8_t* buf, size_t size) override {
+        if (fd < 0) return 0;
+        size_t sent = 0;
+        while (sent < size) {
+            size_t chunk = shaper.sendBudget(size - sent);
+            if (chunk == 0) {
+                cutLink();
+                break;
+            }
+            ssize_t n = rawSend(buf + sent, chunk);
+            if (n <= 0) break;
+            shaper.sent((size_t)n);
+            sent += (size_t)n;
+        }
+        return sent;
+    }
+
+    int available() override {
+        fill();
+        return (int)(rxReady - rxStart);
+    }
+
+    int read() override {
+        uint8_t b;
+        return read(&b, 1) == 1 ? b : -1;
+    }
+
+    int read(uint8_t* buf, size_t size) override {
+        if (rxStart == rxReady) {
+            fill();
+        }
+        size_t n = rxReady - rxStart;
+        if (n == 0) return -1;
+        if (n > size) n = size;
+        memcpy(buf, rx + rxStart, n);
+        rxStart += n;
+        return (int)n;
+    }
+
+    int peek() override {
+        if (rxStart == rxReady) {
+            fill();
+        }
+        return rxStart < rxReady ? rx[rxStart] : -1;
+    }
+
+    void flush() override {}
+
+    void stop() override {
+#ifdef VOLT_HOST_OPENSSL
+        if (ssl) {
+            SSL_shutdown(ssl);
+            SSL_free(ssl);
+            ssl = nullptr;
+        }
+        if (ctx) {
+            SSL_CTX_free(ctx);
+            ctx = nullptr;
+        }
+#endif
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+        rxStart = rxReady = rxEnd = 0;
+        peerClosed = false;
+    }
+
+    // Like the ESP32 client: still "connected" while unread data is left
+    // (including data the shaper is still holding back)
+    uint8_t connected() override {
+        if (fd < 0) return 0;
+        fill();
+        return (rxEnd > rxStart || !peerClosed) ? 1 : 0;
+    }
+
+    operator bool() override {
+        return fd >= 0;
+    }
+};
+
+#endif // NATIVE_NET_H
@@ -0,0 +1,360 @@
+/*
+ * ============================================
+ * Native HAL - Network Impairment
+ * ============================================
+ *
+ * Handles:
+ * - Profiles: latency, jitter, bandwidth caps,
+ *   stalls and mid-stream disconnects, scripted
+ *   one per line (see NET_DEFAULT_PROFILES)
+ * - NetShaper, the per-connection shim
+ *   NativeTlsClient pushes every byte through
+ * - Counters the benchmarks read back
+ *
+ * Nothing is shaped until a profile is set
+ * with nativeNetImpairment().set(), so the
+ * tests see a plain socket.
+ *
+ * Model (what the watch sees over WiFi):
+ * - latency + 0..jitter ms is added to every
+ *   received segment (order is kept), so a
+ *   request/response pays it once; a new
+ *   connection pays it twice (TCP + TLS)
+ * - up/down caps pace bytes through the link
+ * - every stall_every bytes the link freezes
+ *   for stall_ms (sends block, reads see
+ *   nothing)
+ * - drop_pct of connections are cut at a
+ *   random point in their first drop_within
+ *   bytes
+ *
+ * Shaping is applied above TLS (on plaintext),
+ * which is close enough for these sizes.
+ *
+ * ============================================
+ */
+
+#ifndef NET_IMPAIR_H
+#define NET_IMPAIR_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "native_clock.h"
+
+// ============================================
+// PROFILES
+// ============================================
+
+struct NetProfile {
+    char name[24];
+    uint32_t latencyMs;
+    uint32_t jitterMs;
+    uint32_t upKbps;             // 0 = unlimited
+    uint32_t downKbps;
+    uint32_t stallEvery;         // Bytes between stalls (0 = none)
+    uint32_t stallMs;
+    uint32_t dropPct;            // Chance a connection is cut
+    uint32_t dropWithin;         // ... somewhere in its first N bytes
+};
+
+// name key=value ...   (kbps sets both directions)
+static const char NET_DEFAULT_PROFILES[] =
+    "ideal\n"
+    "home     latency=30  jitter=10  kbps=20000\n"
+    "cafe     latency=80  jitter=60  kbps=2000\n"
+    "weak     latency=250 jitter=150 up_kbps=256 down_kbps=512\n"
+    "stalls   latency=80  jitter=40  kbps=2000 stall_every=16384 stall_ms=1200\n"
+    "drops    latency=80  jitter=40  kbps=2000 drop_pct=25 drop_within=4096\n";
+
+inline bool netKeyIs(const char* key, size_t len, const char* name) {
+    return len == strlen(name) && strncmp(key, name, len) == 0;
+}
+
+// One profile line; false for blanks, comments and unknown keys
+inline bool netParseProfile(const char* line, NetProfile& p) {
+    memset(&p, 0, sizeof(p));
+    while (*line == ' ' || *line == '\t') line++;
+    if (*line == '\0' || *line == '#' || *line == '\n' || *line == '\r') return false;
+
+    size_t n = strcspn(line, " \t\r\n");
+    if (n >= sizeof(p.name)) return false;
+    memcpy(p.name, line, n);
+    line += n;
+
+    while (true) {
+        while (*line == ' ' || *line == '\t') line++;
+        if (*line == '\0' || *line == '\n' || *line == '\r' || *line == '#') return true;
+        const char* eq = strchr(line, '=');
+        size_t keyLen = eq ? (size_t)(eq - line) : 0;
+        if (keyLen == 0 || keyLen != strcspn(line, "= \t")) {
+            fprintf(stderr, "Net: bad profile entry in %s\n", p.name);
+            return false;
+        }
+        char* end;
+        uint32_t value = (uint32_t)strtoul(eq + 1, &end, 10);
+        if (end == eq + 1) {
+            fprintf(stderr, "Net: %.*s needs a number in %s\n", (int)keyLen, line, p.name);
+            return false;
+        }
+
+        if (netKeyIs(line, keyLen, "latency")) p.latencyMs = value;
+        else if (netKeyIs(line, keyLen, "jitter")) p.jitterMs = value;
+        else if (netKeyIs(line, keyLen, "kbps")) p.upKbps = p.downKbps = value;
+        else if (netKeyIs(line, keyLen, "up_kbps")) p.upKbps = value;
+        else if (netKeyIs(line, keyLen, "down_kbps")) p.downKbps = value;
+        else if (netKeyIs(line, keyLen, "stall_every")) p.stallEvery = value;
+        else if (netKeyIs(line, keyLen, "stall_ms")) p.stallMs = value;
+        else if (netKeyIs(line, keyLen, "drop_pct")) p.dropPct = value > 100 ? 100 : value;
+        else if (netKeyIs(line, keyLen, "drop_within")) p.dropWithin = value;
+        else {
+            fprintf(stderr, "Net: unknown key %.*s in %s\n", (int)keyLen, line, p.name);
+            return false;
+        }
+        line = end;
+    }
+}
+
+// Every profile in text (one per line); returns how many
+inline int netParseProfiles(const char* text, NetProfile* out, int max) {
+    int count = 0;
+    while (text && *text && count < max) {
+        if (netParseProfile(text, out[count])) {
+            count++;
+        }
+        text = strchr(text, '\n');
+        if (text) text++;
+    }
+    return count;
+}
+
+// Same, from a file; -1 if it can't be read
+inline int netLoadProfiles(const char* path, NetProfile* out, int max) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return -1;
+    int count = 0;
+    char line[256];
+    while (count < max && fgets(line, sizeof(line), f)) {
+        if (netParseProfile(line, out[count])) {
+            count++;
+        }
+    }
+    fclose(f);
+    return count;
+}
+
+// ============================================
+// ACTIVE PROFILE AND COUNTERS
+// ============================================
+
+struct NetImpairStats {
+    uint32_t connects;
+    uint32_t stalls;
+    uint32_t drops;
+    uint64_t bytesUp;
+    uint64_t bytesDown;
+    uint64_t lastSendUs;         // When the last sent byte left the link (0 = none)
+};
+
+class NetImpairment {
+private:
+    uint32_t rng;
+
+public:
+    bool active;
+    NetProfile profile;
+    NetImpairStats stats;
+
+    NetImpairment() : rng(1), active(false) {
+        memset(&profile, 0, sizeof(profile));
+        memset(&stats, 0, sizeof(stats));
+    }
+
+    // Applies to connections opened from now on
+    void set(const NetProfile& p, uint32_t seed = 1) {
+        profile = p;
+        active = true;
+        rng = seed ? seed : 1;
+        memset(&stats, 0, sizeof(stats));
+    }
+
+    void clear() {
+        active = false;
+        memset(&stats, 0, sizeof(stats));
+    }
+
+    // 0..n-1 (xorshift, so runs repeat with the same seed)
+    uint32_t random(uint32_t n) {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        return n ? rng % n : 0;
+    }
+};
+
+inline NetImpairment& nativeNetImpairment() {
+    static NetImpairment net;
+    return net;
+}
+
+// ============================================
+// PER-CONNECTION SHAPER
+// ============================================
+
+class NetShaper {
+public:
+    static const size_t MSS = 1460;
+    static const uint64_t NEVER = ~0ULL;
+
+private:
+    // Reads may catch up on this much idle link time at once
+    static const uint64_t BURST_US = 50000;
+    static const int MAX_SEGMENTS = 32;
+
+    struct Segment {
+        uint64_t dueUs;
+        size_t bytes;
+    };
+
+    bool on;
+    NetProfile p;
+    uint64_t upFreeUs;           // Link busy sending until
+    uint64_t downFreeUs;         // Link busy receiving until
+    uint64_t stallUntilUs;
+    uint64_t moved;              // Bytes either way on this connection
+    uint64_t nextStall;
+    uint64_t dropAt;
+    bool cut;
+
+    Segment segments[MAX_SEGMENTS];
+    int segHead;
+    int segCount;
+    uint64_t lastDueUs;
+
+    static uint64_t nowUs() { return nativeClock().nowUs(); }
+
+    static uint64_t linkUs(size_t bytes, uint32_t kbps) {
+        return (uint64_t)bytes * 8000 / kbps;
+    }
+
+    uint64_t delayUs() {
+        return ((uint64_t)p.latencyMs + nativeNetImpairment().random(p.jitterMs + 1)) * 1000;
+    }
+
+    void account(size_t n) {
+        moved += n;
+        NetImpairment& net = nativeNetImpairment();
+        if (moved >= nextStall) {
+            stallUntilUs = nowUs() + (uint64_t)p.stallMs * 1000;
+            nextStall = moved + p.stallEvery;
+            net.stats.stalls++;
+        }
+        if (moved >= dropAt && !cut) {
+            cut = true;
+            net.stats.drops++;
+        }
+    }
+
+public:
+    NetShaper() : on(false), cut(false), segHead(0), segCount(0) {}
+
+    // A new connection: picks up the active profile and pays its handshake
+    void begin() {
+        NetImpairment& net = nativeNetImpairment();
+        on = net.active;
+        cut = false;
+        segHead = segCount = 0;
+        if (!on) return;
+
+        p = net.profile;
+        net.stats.connects++;
+        moved = 0;
+        nextStall = p.stallEvery ? p.stallEvery : NEVER;
+        dropAt = NEVER;
+        if (p.dropPct && net.random(100) < p.dropPct) {
+            dropAt = 1 + net.random(p.dropWithin ? p.dropWithin : 1);
+        }
+        nativeClock().sleepUs(delayUs() + delayUs());
+        upFreeUs = downFreeUs = stallUntilUs = lastDueUs = nowUs();
+    }
+
+    bool isCut() const { return on && cut; }
+
+    // Bytes write() may send now, after waiting out stalls and the
+    // up cap (blocking, like a full lwIP send buffer); 0 once cut
+    size_t sendBudget(size_t want) {
+        if (!on) return want;
+        if (cut) return 0;
+        uint64_t wait = upFreeUs > stallUntilUs ? upFreeUs : stallUntilUs;
+        uint64_t now = nowUs();
+        if (wait > now) {
+            nativeClock().sleepUs(wait - now);
+        }
+        size_t n = want;
+        if (p.upKbps && n > MSS) n = MSS;
+        if (dropAt != NEVER && n > dropAt - moved) n = (size_t)(dropAt - moved);
+        return n;
+    }
+
+    void sent(size_t n) {
+        if (!on) return;
+        uint64_t now = nowUs();
+        if (p.upKbps) {
+            upFreeUs = (upFreeUs > now ? upFreeUs : now) + linkUs(n, p.upKbps);
+        }
+        NetImpairStats& stats = nativeNetImpairment().stats;
+        stats.bytesUp += n;
+        stats.lastSendUs = upFreeUs > now ? upFreeUs : now;
+        account(n);
+    }
+
+    // Bytes a read may take off the socket now (0 = not yet)
+    size_t recvBudget(size_t room) {
+        if (!on) return room;
+        uint64_t now = nowUs();
+        if (cut || now < stallUntilUs || segCount == MAX_SEGMENTS) return 0;
+        size_t n = room;
+        if (p.downKbps) {
+            uint64_t from = downFreeUs + BURST_US > now ? downFreeUs : now - BURST_US;
+            if (from >= now) return 0;
+            uint64_t credit = (now - from) * p.downKbps / 8000;
+            if (credit < n) n = (size_t)credit;
+        }
+        if (dropAt != NEVER && n > dropAt - moved) n = (size_t)(dropAt - moved);
+        return n;
+    }
+
+    // n bytes came off the socket; returns how many are readable now
+    size_t received(size_t n) {
+        if (!on) return n;
+        uint64_t now = nowUs();
+        if (p.downKbps) {
+            uint64_t from = downFreeUs + BURST_US > now ? downFreeUs : now - BURST_US;
+            downFreeUs = from + linkUs(n, p.downKbps);
+        }
+        uint64_t due = now + delayUs();
+        if (due < lastDueUs) due = lastDueUs;
+        lastDueUs = due;
+        segments[(segHead + segCount) % MAX_SEGMENTS] = { due, n };
+        segCount++;
+        nativeNetImpairment().stats.bytesDown += n;
+        account(n);
+        return release();
+    }
+
+    // Received bytes whose delay has passed
+    size_t release() {
+        if (!on) return 0;
+        uint64_t now = nowUs();
+        size_t n = 0;
+        while (segCount > 0 && segments[segHead].dueUs <= now) {
+            n += segments[segHead].bytes;
+            segHead = (segHead + 1) % MAX_SEGMENTS;
+            segCount--;
+        }
+        return n;
+    }
+};
+
+#endif // NET_IMPAIR_H
@@ -0,0 +1,269 @@
+/*
+ * ============================================
+ * Bad Network Benchmark (host)
+ * ============================================
+ *
+ * Runs each request the watch makes through
+ * every network profile (net_impair.h) against
+ * the local stand-in server (h2_bench_server.py):
+ *
+ *   transcribe  bot.transcribe() (5 s of audio up)
+ *   chat        bot.chat()
+ *   speak       bot.speak(), played in real time
+ *   sos         SOSSystem::sendSOSAlert() from
+ *               phase 1 (retry included)
+ *
+ * and prints a matrix of success rate, upload
+ * time (call -> last request byte on the wire),
+ * total time and speaker underruns per profile.
+ * speak only counts as a success if every byte
+ * of the speech is played.
+ *
+ * Profiles come from NET_DEFAULT_PROFILES or a
+ * file in the same format (--profiles), e.g.:
+ *   # name  key=value ...
+ *   subway  latency=300 jitter=400 kbps=128 stall_every=8192 stall_ms=3000
+ *
+ * Build (needs ArduinoJson, see CMakeLists.txt)
+ * and run (from this directory):
+ *   cmake -S . -B build && cmake --build build
+ *   python3 h2_bench_server.py --handshake-ms 0 --chars-per-sec 60 &
+ *   ./build/net_impair_bench --runs 5
+ *
+ * ============================================
+ */
+
+#include "volt_ai_FINAL.h"
+#include "sos_system.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+enum Op { OP_TRANSCRIBE, OP_CHAT, OP_SPEAK, OP_SOS, OP_COUNT };
+
+static const char* OP_NAMES[OP_COUNT] = { "transcribe", "chat", "speak", "sos" };
+
+static const char* CHAT_TEXT = "Why is the sky blue?";
+static const char* SPEAK_TEXT = "Air scatters blue light the most, so the whole sky glows blue!";
+static const int SOS_BUZZER_PIN = 25;
+static const int MAX_PROFILES = 16;
+
+struct OpRun {
+    bool ok;
+    double uploadMs;             // < 0: nothing was sent
+    double totalMs;
+    uint32_t underruns;
+};
+
+struct OpSummary {
+    int runs;
+    int ok;
+    uint32_t underruns;
+    std::vector<double> upload;
+    std::vector<double> total;
+};
+
+struct ProfileResult {
+    NetProfile profile;
+    NetImpairStats net;
+    OpSummary ops[OP_COUNT];
+};
+
+static double nowMs() {
+    return nativeClock().nowUs() / 1000.0;
+}
+
+static double percentile(std::vector<double> v, double p) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    size_t i = (size_t)(p * (v.size() - 1) + 0.5);
+    return v[i];
+}
+
+// ============================================
+// ONE REQUEST
+// ============================================
+
+static OpRun runOp(Op op, VoltAI& bot, SOSSystem& sos, uint64_t speechBytes) {
+    OpRun r;
+    NetImpairStats& stats = nativeNetImpairment().stats;
+    stats.lastSendUs = 0;
+    uint32_t underrunsBefore = nativeHal().speaker.underruns;
+    uint64_t playedBefore = nativeHal().speaker.bytesPlayed;
+
+    double start = nowMs();
+    switch (op) {
+        case OP_TRANSCRIBE:
+            r.ok = bot.transcribe()[0] != '\0';
+            break;
+        case OP_CHAT:
+            r.ok = bot.chat(CHAT_TEXT)[0] != '\0';
+            break;
+        case OP_SPEAK:
+            bot.speak(SPEAK_TEXT);
+            r.ok = nativeHal().speaker.bytesPlayed - playedBefore == speechBytes;
+            break;
+        default:
+            r.ok = sos.sendSOSAlert(47.6062, -122.3321, true, 80);
+            break;
+    }
+    r.totalMs = nowMs() - start;
+    r.uploadMs = stats.lastSendUs ? stats.lastSendUs / 1000.0 - start : -1;
+    r.underruns = nativeHal().speaker.underruns - underrunsBefore;
+
+    bot.endTurn();
+    return r;
+}
+
+// ============================================
+// REPORT
+// ============================================
+
+static void printTable(const std::vector<ProfileResult>& results) {
+    printf("%-10s %-10s %7s %10s %10s %10s %10s %9s\n", "profile", "request", "ok",
+           "up p50", "up p95", "total p50", "total p95", "underruns");
+    for (const ProfileResult& pr : results) {
+        for (int op = 0; op < OP_COUNT; op++) {
+            const OpSummary& s = pr.ops[op];
+            char ok[16];
+            snprintf(ok, sizeof(ok), "%d/%d", s.ok, s.runs);
+            printf("%-10s %-10s %7s %10.0f %10.0f %10.0f %10.0f %9s\n",
+                   op == 0 ? pr.profile.name : "", OP_NAMES[op], ok,
+                   percentile(s.upload, 0.5), percentile(s.upload, 0.95),
+                   percentile(s.total, 0.5), percentile(s.total, 0.95),
+                   op == OP_SPEAK ? std::to_string(s.underruns).c_str() : "-");
+        }
+        printf("%-10s %u connections, %u stalls, %u drops\n", "",
+               (unsigned)pr.net.connects, (unsigned)pr.net.stalls, (unsigned)pr.net.drops);
+    }
+    printf("times in ms; up = call -> last request byte sent\n");
+}
+
+static void printJson(const std::vector<ProfileResult>& results) {
+    printf("{\"profiles\":[");
+    for (size_t i = 0; i < results.size(); i++) {
+        const ProfileResult& pr = results[i];
+        printf("%s{\"name\":\"%s\",\"connections\":%u,\"stalls\":%u,\"drops\":%u,\"requests\":{",
+               i ? "," : "", pr.profile.name, (unsigned)pr.net.connects,
+               (unsigned)pr.net.stalls, (unsigned)pr.net.drops);
+        for (int op = 0; op < OP_COUNT; op++) {
+            const OpSummary& s = pr.ops[op];
+            printf("%s\"%s\":{\"runs\":%d,\"ok\":%d,\"success_pct\":%.0f,"
+                   "\"upload_p50\":%.1f,\"upload_p95\":%.1f,\"total_p50\":%.1f,\"total_p95\":%.1f,"
+                   "\"underruns\":%u}",
+                   op ? "," : "", OP_NAMES[op], s.runs, s.ok, s.runs ? 100.0 * s.ok / s.runs : 0.0,
+                   percentile(s.upload, 0.5), percentile(s.upload, 0.95),
+                   percentile(s.total, 0.5), percentile(s.total, 0.95), (unsigned)s.underruns);
+        }
+        printf("}}");
+    }
+    printf("]}\n");
+}
+
+int main(int argc, char** argv) {
+    int runs = 3;
+    const char* host = "127.0.0.1";
+    uint16_t port = 8090;
+    uint32_t seed = 1;
+    bool json = false;
+    const char* profilePath = nullptr;
+    std::vector<std::string> only;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--runs") && i + 1 < argc) runs = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--host") && i + 1 < argc) host = argv[++i];
+        else if (!strcmp(argv[i], "--port") && i + 1 < argc) port = (uint16_t)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = (uint32_t)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--profiles") && i + 1 < argc) profilePath = argv[++i];
+        else if (!strcmp(argv[i], "--only") && i + 1 < argc) only.push_back(argv[++i]);
+        else if (!strcmp(argv[i], "--json")) json = true;
+        else {
+            printf("usage: %s [--runs N] [--host H] [--port P] [--seed N]\n"
+                   "          [--profiles FILE] [--only NAME]... [--json]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    NetProfile profiles[MAX_PROFILES];
+    int count = profilePath ? netLoadProfiles(profilePath, profiles, MAX_PROFILES)
+                            : netParseProfiles(NET_DEFAULT_PROFILES, profiles, MAX_PROFILES);
+    if (count <= 0) {
+        printf("No profiles in %s\n", profilePath ? profilePath : "NET_DEFAULT_PROFILES");
+        return 1;
+    }
+
+    nativeHal().quiet = true;
+    Serial.quiet = true;         // sos_system.h logs through Serial
+    nativeClock().setVirtual(false);
+    nativeRoutes().add("api.openai.com", 443, host, port, false);
+    nativeRoutes().add("sos.volt.test", 80, host, port, false);
+
+    // Reserve the pools up front so begin() doesn't print its report into --json
+    memPools().begin(VOLT_POOL_LAYOUT, sizeof(VOLT_POOL_LAYOUT) / sizeof(VOLT_POOL_LAYOUT[0]));
+
+    VoltAI bot;
+    if (!bot.begin("sk-bench-0123456789", STONE_PERSONALITY)) {
+        printf("AI engine failed to start\n");
+        return 1;
+    }
+    SOSSystem sos;
+    sos.begin(SOS_BUZZER_PIN, nullptr);
+    sos.setAPIConfig("http://sos.volt.test", "bench-key", "watch-01", "Sam");
+
+    // One second of tone, recorded once and uploaded by every transcribe
+    std::vector<int16_t> tone(SAMPLE_RATE);
+    for (size_t i = 0; i < tone.size(); i++) {
+        tone[i] = (int16_t)(8000 * ((i * 440 * 2 / SAMPLE_RATE) % 2 ? 1 : -1));
+    }
+    nativeHal().setMicPcm(tone.data(), tone.size() * 2, SAMPLE_RATE);
+    bot.recordAudio();
+
+    // What a clean speak() plays, to judge the impaired ones by
+    nativeHal().paceSpeaker = false;
+    uint64_t played = nativeHal().speaker.bytesPlayed;
+    bot.speak(SPEAK_TEXT);
+    bot.endTurn();
+    uint64_t speechBytes = nativeHal().speaker.bytesPlayed - played;
+    if (speechBytes <= 512) {
+        printf("No speech from %s:%u (is h2_bench_server.py running?)\n", host, port);
+        return 1;
+    }
+    nativeHal().paceSpeaker = true;
+
+    std::vector<ProfileResult> results;
+    for (int p = 0; p < count; p++) {
+        if (!only.empty() && std::find(only.begin(), only.end(), profiles[p].name) == only.end()) {
+            continue;
+        }
+        ProfileResult pr;
+        pr.profile = profiles[p];
+        nativeNetImpairment().set(profiles[p], seed);
+        for (int op = 0; op < OP_COUNT; op++) {
+            OpSummary& s = pr.ops[op];
+            s.runs = s.ok = 0;
+            s.underruns = 0;
+            for (int r = 0; r < runs; r++) {
+                OpRun run = runOp((Op)op, bot, sos, speechBytes);
+                s.runs++;
+                if (run.ok) s.ok++;
+                s.underruns += run.underruns;
+                if (run.uploadMs >= 0) s.upload.push_back(run.uploadMs);
+                s.total.push_back(run.totalMs);
+            }
+        }
+        pr.net = nativeNetImpairment().stats;
+        results.push_back(pr);
+        if (!json) {
+            fprintf(stderr, "%s done\n", profiles[p].name);
+        }
+    }
+    nativeNetImpairment().clear();
+
+    if (json) {
+        printJson(results);
+    } else {
+        printTable(results);
+    }
+    return 0;
+}
@@ -0,0 +1,140 @@
+/*
+ * ============================================
+ * PC Profiler Tests (host)
+ * ============================================
+ *
+ * Runs pc_profiler.h on the native HAL. Nothing
+ * interrupts on the host, so the tests feed
+ * record() as the timer handler would: buffer
+ * reservation, depth clamping, the full buffer
+ * (dropped ticks, tick() stopping a capture),
+ * skipped ticks, two "cores" recording at once,
+ * and the dump format pcprof_symbolize.py reads.
+ *
+ * Built by CMakeLists.txt (ctest).
+ *
+ * ============================================
+ */
+
+#include "pc_profiler.h"
+#include "test_check.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+// Collects a dump
+class Capture : public Print {
+public:
+    std::string text;
+
+    size_t write(uint8_t b) override {
+        text += (char)b;
+        return 1;
+    }
+
+    size_t write(const uint8_t* buf, size_t size) override {
+        text.append((const char*)buf, size);
+        return size;
+    }
+
+    bool has(const char* s) const { return text.find(s) != std::string::npos; }
+};
+
+static void testRecordAndDump() {
+    resetHal();
+    PcProfiler prof;
+    CHECK(!prof.start());              // No sampler on the host
+    CHECK(!prof.isRunning());
+    CHECK(prof.getCapacity() == PcProfiler::DEFAULT_SAMPLES);
+
+    uint32_t deep[] = { 0x42003f10, 0x42004a2c, 0x420051b8, 1, 2, 3, 4, 5 };
+    prof.record(1, deep, 3);
+    prof.record(0, deep, 8);           // Clamped to MAX_DEPTH
+    prof.record(1, deep, 0);
+    prof.countSkipped();
+    CHECK(prof.getCount() == 3);
+    CHECK(prof.getSample(1).depth == PcProfiler::MAX_DEPTH);
+    CHECK(prof.getSample(1).pc[5] == 3);
+
+    Capture out;
+    prof.dump(out);
+    CHECK(out.text ==
+          "# volt-pcprof 1\n"
+          "# hz 1000 ms 0 samples 3 skipped 1 dropped 0\n"
+          "1 0x42003f10 0x42004a2c 0x420051b8\n"
+          "0 0x42003f10 0x42004a2c 0x420051b8 0x00000001 0x00000002 0x00000003\n"
+          "1\n");
+}
+
+static void testFull() {
+    resetHal();
+    PcProfiler prof;
+    CHECK(prof.reserve(10));
+    CHECK(prof.reserve(5));            // Already big enough
+    CHECK(prof.getCapacity() == 10);
+
+    uint32_t pc = 0x40080000;
+    for (int i = 0; i < 14; i++) {
+        prof.record(0, &pc, 1);
+    }
+    CHECK(prof.getCount() == 10);
+    CHECK(prof.getDropped() == 4);
+
+    Capture out;
+    prof.dump(out);
+    CHECK(out.has("samples 10 skipped 0 dropped 4\n"));
+
+    // Growing the buffer replaces it
+    CHECK(prof.reserve(64));
+    CHECK(prof.getCapacity() == 64);
+
+    // Not enough memory anywhere
+    nativeHal().psram = false;
+    PcProfiler big;
+    CHECK(!big.reserve(1000000));
+    CHECK(big.getCapacity() == 0);
+    big.record(0, &pc, 1);             // Harmless without a buffer
+    CHECK(big.getCount() == 0);
+}
+
+// Both cores' timers write through one atomic index
+static void testTwoCores() {
+    resetHal();
+    PcProfiler prof;
+    const uint32_t perCore = 20000;
+    CHECK(prof.reserve(perCore * 2));
+
+    std::vector<std::thread> cores;
+    for (int core = 0; core < 2; core++) {
+        cores.emplace_back([&prof, core, perCore]() {
+            for (uint32_t n = 0; n < perCore; n++) {
+                uint32_t pcs[2] = { 0x42000000u + n, (uint32_t)core };
+                prof.record(core, pcs, 2);
+            }
+        });
+    }
+    for (std::thread& t : cores) {
+        t.join();
+    }
+
+    CHECK(prof.getCount() == perCore * 2);
+    CHECK(prof.getDropped() == 0);
+    uint32_t perCoreSeen[2] = {};
+    int torn = 0;
+    for (uint32_t i = 0; i < prof.getCount(); i++) {
+        const PcSample& s = prof.getSample(i);
+        if (s.depth != 2 || s.pc[1] != s.core) torn++;
+        if (s.core < 2) perCoreSeen[s.core]++;
+    }
+    CHECK(torn == 0);
+    CHECK(perCoreSeen[0] == perCore && perCoreSeen[1] == perCore);
+}
+
+int main() {
+    testRecordAndDump();
+    testFull();
+    testTwoCores();
+
+    return testSummary();
+}
@@ -0,0 +1,199 @@
+#!/usr/bin/env python3
+"""
+VOLT AI Watch - PC Profiler Symbolizer
+Turns a pc_profiler.h capture into folded stacks for flame graph tools
+(flamegraph.pl, inferno, speedscope):
+
+  curl http://<watch-ip>/api/profile > prof.txt      # or "prof dump" on serial
+  python3 pcprof_symbolize.py build/volt_stone_FINAL.ino.elf prof.txt > prof.folded
+  flamegraph.pl prof.folded > prof.svg
+
+Each input line is a core number then PCs, leaf first. Addresses are
+looked up in the ELF's symbol table (function symbols only, so inlined
+code shows up as its caller). Return addresses are looked up at
+address - 1, the call instruction, so a call at the very end of a
+function is not blamed on the next one. Addresses outside every
+function are folded as [unknown]. C++ names are demangled when c++filt
+(or --cxxfilt) is available.
+
+Output lines are "outer;...;leaf count", sorted. --per-core puts
+"core0" / "core1" at the root; --core N keeps one core.
+
+Standard library only.
+"""
+
+import argparse
+import bisect
+import shutil
+import struct
+import subprocess
+import sys
+
+SHT_SYMTAB = 2
+STT_FUNC = 2
+
+
+class ElfSymbols:
+    """Function symbols of an ELF file (32 or 64 bit, either endian)."""
+
+    def __init__(self, data):
+        if data[:4] != b"\x7fELF":
+            raise ValueError("not an ELF file")
+        is64 = data[4] == 2
+        end = "<" if data[5] == 1 else ">"
+        if is64:
+            shoff, = struct.unpack_from(end + "Q", data, 0x28)
+            shentsize, shnum = struct.unpack_from(end + "HH", data, 0x3A)
+        else:
+            shoff, = struct.unpack_from(end + "I", data, 0x20)
+            shentsize, shnum = struct.unpack_from(end + "HH", data, 0x2E)
+
+        sections = []
+        for i in range(shnum):
+            base = shoff + i * shentsize
+            if is64:
+                _, stype, _, _, off, size, link, _, _, entsize = struct.unpack_from(
+                    end + "IIQQQQIIQQ", data, base)
+            else:
+                _, stype, _, _, off, size, link, _, _, entsize = struct.unpack_from(
+                    end + "IIIIIIIIII", data, base)
+            sections.append((stype, off, size, link, entsize))
+
+        symbols = {}
+        for stype, off, size, link, entsize in sections:
+            if stype != SHT_SYMTAB or entsize == 0:
+                continue
+            _, stroff, strsize, _, _ = sections[link]
+            strtab = data[stroff:stroff + strsize]
+            for n in range(size // entsize):
+                at = off + n * entsize
+                if is64:
+                    name, info, _, _, value, symsize = struct.unpack_from(end + "IBBHQQ", data, at)
+                else:
+                    name, value, symsize, info, _, _ = struct.unpack_from(end + "IIIBBH", data, at)
+                if info & 0xF != STT_FUNC or value == 0:
+                    continue
+                label = strtab[name:strtab.index(b"\0", name)].decode("utf-8", "replace")
+                # Aliases: keep the sized one, then the first name
+                if value not in symbols or (symbols[value][1] == 0 and symsize):
+                    symbols[value] = (label, symsize)
+
+        self.starts = sorted(symbols)
+        self.entries = [(start,) + symbols[start] for start in self.starts]
+
+    def lookup(self, addr):
+        i = bisect.bisect_right(self.starts, addr) - 1
+        if i < 0:
+            return None
+        start, name, size = self.entries[i]
+        if size:
+            return name if addr < start + size else None
+        # Unsized (hand-written asm): up to the next symbol
+        return name
+
+
+def read_samples(lines):
+    """(core, [pc, ...]) per sample line; header fields as a dict."""
+    header = {}
+    samples = []
+    for line in lines:
+        line = line.strip()
+        if not line:
+            continue
+        if line.startswith("#"):
+            words = line[1:].split()
+            for key, value in zip(words[::2], words[1::2]):
+                header[key] = value
+            continue
+        fields = line.split()
+        samples.append((int(fields[0]), [int(pc, 16) for pc in fields[1:]]))
+    return header, samples
+
+
+def demangler(cxxfilt):
+    """Function mapping a list of names to demangled names."""
+    tool = cxxfilt or shutil.which("c++filt")
+    if not tool:
+        return lambda names: names
+
+    def run(names):
+        mangled = [n for n in names if n.startswith("_Z")]
+        if not mangled:
+            return names
+        try:
+            out = subprocess.run([tool], input="\n".join(mangled) + "\n", capture_output=True,
+                                 text=True, check=True).stdout.splitlines()
+        except (OSError, subprocess.CalledProcessError):
+            return names
+        table = dict(zip(mangled, out))
+        return [table.get(n, n) for n in names]
+    return run
+
+
+def fold(symbols, samples, per_core=False, core=None, demangle=None):
+    """{stack: count} with stacks as ";"-joined names, root first."""
+    names = {}
+    stacks = {}
+    for sample_core, pcs in samples:
+        if core is not None and sample_core != core:
+            continue
+        frames = []
+        for depth, pc in enumerate(pcs):
+            addr = pc - 1 if depth > 0 else pc
+            if addr not in names:
+                names[addr] = symbols.lookup(addr) or "[unknown]"
+            frames.append(names[addr])
+        if not frames:
+            frames = ["[unknown]"]
+        frames.reverse()
+        if per_core:
+            frames.insert(0, "core%d" % sample_core)
+        key = ";".join(frames)
+        stacks[key] = stacks.get(key, 0) + 1
+
+    if demangle:
+        keys = list(stacks)
+        parts = [k.split(";") for k in keys]
+        flat = demangle([p for frames in parts for p in frames])
+        renamed = {}
+        at = 0
+        for key, frames in zip(keys, parts):
+            new = ";".join(flat[at:at + len(frames)])
+            at += len(frames)
+            renamed[new] = renamed.get(new, 0) + stacks[key]
+        stacks = renamed
+    return stacks
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    parser.add_argument("elf", help="firmware ELF with symbols")
+    parser.add_argument("samples", help="pc_profiler.h dump ('-' for stdin)")
+    parser.add_argument("--per-core", action="store_true", help="root each stack at its core")
+    parser.add_argument("--core", type=int, help="only samples from this core")
+    parser.add_argument("--cxxfilt", help="c++filt to use (default: from PATH)")
+    parser.add_argument("--no-demangle", action="store_true")
+    args = parser.parse_args(argv)
+
+    with open(args.elf, "rb") as f:
+        symbols = ElfSymbols(f.read())
+    if args.samples == "-":
+        header, samples = read_samples(sys.stdin)
+    else:
+        with open(args.samples) as f:
+            header, samples = read_samples(f)
+
+    demangle = None if args.no_demangle else demangler(args.cxxfilt)
+    stacks = fold(symbols, samples, args.per_core, args.core, demangle)
+    for key in sorted(stacks):
+        sys.stdout.write("%s %d\n" % (key, stacks[key]))
+
+    unknown = sum(n for key, n in stacks.items() if key.endswith("[unknown]"))
+    sys.stderr.write("pcprof: %d samples (%s Hz), %s skipped, %s dropped, %d leaf unknown\n" % (
+        len(samples), header.get("hz", "?"), header.get("skipped", "?"),
+        header.get("dropped", "?"), unknown))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,203 @@
+#!/usr/bin/env python3
+"""
+Tests for pcprof_symbolize.py against synthetic ELF files and sample
+dumps: symbol lookup (sized, unsized, aliases, non-function symbols),
+32-bit Xtensa and 64-bit ELF layouts, return address handling, folding
+per core, demangling and the command line.
+
+Run directly (ctest does) or with pytest.
+"""
+
+import io
+import os
+import struct
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, HERE)
+
+import pcprof_symbolize as ps  # noqa: E402
+
+STT_OBJECT, STT_FUNC = 1, 2
+EM_XTENSA, EM_X86_64 = 94, 62
+
+# A small firmware: the main loop calls the DSP filter and the TLS
+# write; a hand-written asm routine has no size
+SYMBOLS = [
+    ("loopTask", 0x42000000, 0x100, STT_FUNC),
+    ("talkToVolt", 0x42000100, 0x80, STT_FUNC),
+    ("fir_filter", 0x42000180, 0x40, STT_FUNC),
+    ("_Z9tlsWritePKhj", 0x420001c0, 0x40, STT_FUNC),
+    ("memcpy_asm", 0x40080000, 0, STT_FUNC),
+    ("audio_table", 0x42000190, 0x20, STT_OBJECT),   # Data: never a frame
+    ("alias_of_fir", 0x42000180, 0, STT_FUNC),       # Unsized alias: sized name wins
+]
+
+
+def build_elf(symbols, is64=False, big_endian=False, machine=EM_XTENSA):
+    """Minimal ELF with .text, .symtab, .strtab and .shstrtab."""
+    end = ">" if big_endian else "<"
+    strtab = b"\0"
+    entries = []
+    for name, value, size, kind in symbols:
+        entries.append((len(strtab), value, size, kind))
+        strtab += name.encode() + b"\0"
+    if is64:
+        sym = [struct.pack(end + "IBBHQQ", 0, 0, 0, 0, 0, 0)]
+        sym += [struct.pack(end + "IBBHQQ", n, 0x10 | k, 0, 1, v, s) for n, v, s, k in entries]
+        entsize = 24
+    else:
+        sym = [struct.pack(end + "IIIBBH", 0, 0, 0, 0, 0, 0)]
+        sym += [struct.pack(end + "IIIBBH", n, v, s, 0x10 | k, 0, 1) for n, v, s, k in entries]
+        entsize = 16
+    symtab = b"".join(sym)
+    text = b"\0" * 16
+    shstrtab = b"\0.text\0.symtab\0.strtab\0.shstrtab\0"
+
+    ehsize = 64 if is64 else 52
+    shentsize = 64 if is64 else 40
+    body = bytearray()
+    offsets = []
+    for blob in (text, symtab, strtab, shstrtab):
+        offsets.append(ehsize + len(body))
+        body += blob
+        while len(body) % 8:
+            body += b"\0"
+    shoff = ehsize + len(body)
+
+    # name, type, link, entsize per section
+    layout = [(0, 0, 0, 0, 0, 0), (1, 1, 0, 0, offsets[0], len(text)),
+              (7, 2, 3, entsize, offsets[1], len(symtab)),
+              (15, 3, 0, 0, offsets[2], len(strtab)),
+              (23, 3, 0, 0, offsets[3], len(shstrtab))]
+    headers = b""
+    for name, stype, link, esize, off, size in layout:
+        if is64:
+            headers += struct.pack(end + "IIQQQQIIQQ", name, stype, 0, 0, off, size, link, 0, 0, esize)
+        else:
+            headers += struct.pack(end + "IIIIIIIIII", name, stype, 0, 0, off, size, link, 0, 0, esize)
+
+    ident = b"\x7fELF" + bytes([2 if is64 else 1, 2 if big_endian else 1, 1]) + b"\0" * 9
+    if is64:
+        header = ident + struct.pack(end + "HHIQQQIHHHHHH", 2, machine, 1, 0, 0, shoff, 0,
+                                     ehsize, 0, 0, shentsize, len(layout), 4)
+    else:
+        header = ident + struct.pack(end + "HHIIIIIHHHHHH", 2, machine, 1, 0, 0, shoff, 0,
+                                     ehsize, 0, 0, shentsize, len(layout), 4)
+    return bytes(header) + bytes(body) + headers
+
+
+DUMP = """# volt-pcprof 1
+# hz 1000 ms 20 samples 9 skipped 2 dropped 1
+1 0x42000190 0x42000120 0x42000010
+1 0x420001a4 0x42000120 0x42000010
+1 0x420001c4 0x42000140 0x42000010
+0 0x40080010
+0 0x3fc90000
+1 0x42000104 0x42000180
+1 0x42000020
+0 0x420001d0 0x42000140
+1
+"""
+
+
+def test_lookup():
+    syms = ps.ElfSymbols(build_elf(SYMBOLS))
+    assert syms.lookup(0x42000000) == "loopTask"
+    assert syms.lookup(0x420000ff) == "loopTask"
+    assert syms.lookup(0x42000100) == "talkToVolt"
+    assert syms.lookup(0x42000190) == "fir_filter"       # Not the data symbol
+    assert syms.lookup(0x420001c0) == "_Z9tlsWritePKhj"
+    assert syms.lookup(0x42000200) is None              # Past the last sized one
+    assert syms.lookup(0x40080123) == "memcpy_asm"      # Unsized: until the next
+    assert syms.lookup(0x3fc90000) is None              # Below every function
+
+
+def test_layouts():
+    for is64, big, machine in ((True, False, EM_X86_64), (False, True, EM_XTENSA)):
+        syms = ps.ElfSymbols(build_elf(SYMBOLS, is64=is64, big_endian=big, machine=machine))
+        assert syms.lookup(0x42000184) == "fir_filter"
+        assert syms.lookup(0x40080010) == "memcpy_asm"
+    try:
+        ps.ElfSymbols(b"not an elf")
+        assert False, "accepted garbage"
+    except ValueError:
+        pass
+
+
+def test_read_samples():
+    header, samples = ps.read_samples(io.StringIO(DUMP))
+    assert header["hz"] == "1000" and header["skipped"] == "2" and header["dropped"] == "1"
+    assert len(samples) == 9
+    assert samples[0] == (1, [0x42000190, 0x42000120, 0x42000010])
+    assert samples[-1] == (1, [])
+
+
+def test_fold():
+    syms = ps.ElfSymbols(build_elf(SYMBOLS))
+    _, samples = ps.read_samples(io.StringIO(DUMP))
+    stacks = ps.fold(syms, samples)
+    assert stacks == {
+        "loopTask;talkToVolt;fir_filter": 2,
+        "loopTask;talkToVolt;_Z9tlsWritePKhj": 1,
+        "memcpy_asm": 1,
+        "[unknown]": 2,
+        # Return address 0x42000180 is just past talkToVolt's call:
+        # looked up at 0x4200017f, so not fir_filter
+        "talkToVolt;talkToVolt": 1,
+        "loopTask": 1,
+        "talkToVolt;_Z9tlsWritePKhj": 1,
+    }
+    assert sum(stacks.values()) == 9
+
+    per_core = ps.fold(syms, samples, per_core=True)
+    assert per_core["core1;loopTask;talkToVolt;fir_filter"] == 2
+    assert per_core["core0;memcpy_asm"] == 1
+
+    core0 = ps.fold(syms, samples, core=0)
+    assert sum(core0.values()) == 3
+    assert "talkToVolt;_Z9tlsWritePKhj" in core0
+
+
+def test_demangle():
+    syms = ps.ElfSymbols(build_elf(SYMBOLS))
+    _, samples = ps.read_samples(io.StringIO(DUMP))
+    fake = lambda names: [("tlsWrite(unsigned char const*, unsigned int)"
+                           if n == "_Z9tlsWritePKhj" else n) for n in names]
+    stacks = ps.fold(syms, samples, demangle=fake)
+    assert stacks["loopTask;talkToVolt;tlsWrite(unsigned char const*, unsigned int)"] == 1
+    assert sum(stacks.values()) == 9
+
+
+def test_command_line():
+    with tempfile.TemporaryDirectory() as tmp:
+        elf = os.path.join(tmp, "firmware.elf")
+        dump = os.path.join(tmp, "prof.txt")
+        with open(elf, "wb") as f:
+            f.write(build_elf(SYMBOLS))
+        with open(dump, "w") as f:
+            f.write(DUMP)
+        result = subprocess.run([sys.executable, os.path.join(HERE, "pcprof_symbolize.py"),
+                                 elf, dump, "--no-demangle", "--core", "1"],
+                                capture_output=True, text=True, check=True)
+        lines = result.stdout.splitlines()
+        assert lines == sorted(lines)
+        assert "loopTask;talkToVolt;fir_filter 2" in lines
+        assert "[unknown] 1" in lines
+        assert all(not line.startswith("memcpy_asm") for line in lines)
+        assert "9 samples (1000 Hz), 2 skipped, 1 dropped" in result.stderr
+
+
+if __name__ == "__main__":
+    tests = [v for k, v in sorted(globals().items()) if k.startswith("test_")]
+    failed = 0
+    for test in tests:
+        try:
+            test()
+        except AssertionError as e:
+            failed += 1
+            print("FAIL %s: %s" % (test.__name__, e))
+    print("%d tests, %d failed" % (len(tests), failed))
+    sys.exit(1 if failed else 0)
@@ -0,0 +1,136 @@
+/*
+ * ============================================
+ * Host Shim - Arduino Client over BSD Sockets
+ * ============================================
+ *
+ * Handles:
+ * - Plain TCP connect by name or address
+ * - Non-blocking available()/read() like the
+ *   ESP32 WiFiClient
+ *
+ * TLS is not emulated; benchmarks model its
+ * cost on the server side instead.
+ *
+ * ============================================
+ */
+
+#ifndef HOST_POSIX_CLIENT_H
+#define HOST_POSIX_CLIENT_H
+
+#include "Client.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+
+class PosixClient : public Client {
+private:
+    int fd;
+
+    int connectAddr(const struct sockaddr* addr, socklen_t len) {
+        stop();
+        fd = socket(addr->sa_family, SOCK_STREAM, 0);
+        if (fd < 0) return 0;
+        if (::connect(fd, addr, len) != 0) {
+            stop();
+            return 0;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        return 1;
+    }
+
+public:
+    PosixClient() : fd(-1) {}
+    ~PosixClient() { stop(); }
+
+    int connect(IPAddress ip, uint16_t port) override {
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        uint8_t* a = (uint8_t*)&addr.sin_addr.s_addr;
+        for (int i = 0; i < 4; i++) a[i] = ip[i];
+        return connectAddr((struct sockaddr*)&addr, sizeof(addr));
+    }
+
+    int connect(const char* host, uint16_t port) override {
+        struct addrinfo hints;
+        struct addrinfo* res = nullptr;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_socktype = SOCK_STREAM;
+        char portStr[8];
+        snprintf(portStr, sizeof(portStr), "%u", port);
+        if (getaddrinfo(host, portStr, &hints, &res) != 0 || !res) return 0;
+        int ok = connectAddr(res->ai_addr, res->ai_addrlen);
+        freeaddrinfo(res);
+        return ok;
+    }
+
+    size_t write(uint8_t b) override {
+        return write(&b, 1);
+    }
+
+    size_t write(const uint8_t* buf, size_t size) override {
+        if (fd < 0) return 0;
+        size_t sent = 0;
+        while (sent < size) {
+            ssize_t n = send(fd, buf + sent, size - sent, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            sent += (size_t)n;
+        }
+        return sent;
+    }
+
+    int available() override {
+        if (fd < 0) return 0;
+        int n = 0;
+        if (ioctl(fd, FIONREAD, &n) != 0) return 0;
+        return n;
+    }
+
+    int read() override {
+        uint8_t b;
+        return read(&b, 1) == 1 ? b : -1;
+    }
+
+    int read(uint8_t* buf, size_t size) override {
+        if (fd < 0) return -1;
+        ssize_t n = recv(fd, buf, size, MSG_DONTWAIT);
+        return n > 0 ? (int)n : -1;
+    }
+
+    int peek() override {
+        uint8_t b;
+        if (fd < 0) return -1;
+        return recv(fd, &b, 1, MSG_PEEK | MSG_DONTWAIT) == 1 ? b : -1;
+    }
+
+    void flush() override {}
+
+    void stop() override {
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+
+    uint8_t connected() override {
+        if (fd < 0) return 0;
+        uint8_t b;
+        ssize_t n = recv(fd, &b, 1, MSG_PEEK | MSG_DONTWAIT);
+        if (n == 0) return 0;                                         // Orderly shutdown
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) return 0;
+        return 1;
+    }
+
+    operator bool() override {
+        return fd >= 0;
+    }
+};
+
+#endif // HOST_POSIX_CLIENT_H
@@ -0,0 +1,206 @@
+/*
+ * ============================================
+ * Power Manager and Button Tests (host)
+ * ============================================
+ *
+ * Runs power_mgmt_FINAL.h and button_input.h on
+ * the native HAL with a virtual clock: idle
+ * timeout, deep sleep, battery estimate, and the
+ * click / multi-press / long-press patterns the
+ * sketch's loop() acts on.
+ *
+ * Built and run by CMakeLists.txt (ctest).
+ *
+ * ============================================
+ */
+
+#include "volt_hal.h"
+#include "power_mgmt.h"
+#include "button_input.h"
+#include "test_check.h"
+
+// ============================================
+// BUTTON HELPERS
+// ============================================
+
+// Step the loop every 10 ms (as loop() does) and
+// collect the events seen on the way
+struct ButtonRun {
+    ButtonInput button;
+    unsigned long now;
+    int downs;
+    int clicks;
+    int longPresses;
+    int patterns;
+    int lastPattern;
+
+    ButtonRun() : now(1000), downs(0), clicks(0), longPresses(0), patterns(0), lastPattern(0) {}
+
+    void hold(bool pressed, unsigned long ms) {
+        for (unsigned long t = 0; t < ms; t += 10) {
+            switch (button.update(pressed, now)) {
+                case BUTTON_DOWN: downs++; break;
+                case BUTTON_CLICK: clicks++; break;
+                case BUTTON_LONG_PRESS: longPresses++; break;
+                case BUTTON_PRESSES:
+                    patterns++;
+                    lastPattern = button.getPressCount();
+                    break;
+                default: break;
+            }
+            now += 10;
+        }
+    }
+
+    void press(unsigned long downMs = 100, unsigned long upMs = 300) {
+        hold(true, downMs);
+        hold(false, upMs);
+    }
+};
+
+// ============================================
+// TESTS
+// ============================================
+
+static void testSingleClick() {
+    ButtonRun run;
+    run.press();
+    run.hold(false, 1000);
+    CHECK(run.downs == 1);
+    CHECK(run.clicks == 1);
+    CHECK(run.patterns == 1);
+    CHECK(run.lastPattern == 1);
+    CHECK(run.longPresses == 0);
+}
+
+static void testMultiPress() {
+    ButtonRun run;
+    run.press();
+    run.press();
+    run.press();
+    CHECK(run.patterns == 0);        // Still inside the multi-press window
+    run.hold(false, 1000);
+    CHECK(run.clicks == 3);
+    CHECK(run.patterns == 1);
+    CHECK(run.lastPattern == 3);
+}
+
+static void testDebounce() {
+    ButtonRun run;
+    run.press(50, 100);
+    run.press(50, 100);              // Released 150 ms after the first: bounce
+    run.hold(false, 1000);
+    CHECK(run.clicks == 1);
+    CHECK(run.lastPattern == 1);
+}
+
+static void testSeparatePatterns() {
+    ButtonRun run;
+    run.press();
+    run.hold(false, 1000);
+    run.press();
+    run.press();
+    run.hold(false, 1000);
+    CHECK(run.patterns == 2);
+    CHECK(run.lastPattern == 2);
+}
+
+static void testLongPress() {
+    ButtonRun run;
+    run.hold(true, 1900);
+    CHECK(run.longPresses == 0);
+    run.hold(true, 2000);            // Keeps holding after it fired
+    CHECK(run.longPresses == 1);
+    CHECK(run.button.isDown());
+    run.hold(false, 1000);
+    CHECK(run.clicks == 0);          // Release isn't a click
+    CHECK(run.patterns == 0);
+    CHECK(!run.button.isDown());
+
+    run.press();
+    run.hold(false, 1000);
+    CHECK(run.lastPattern == 1);
+}
+
+static void testLongHoldAfterClick() {
+    // Long press only counts as the first press of a pattern
+    ButtonRun run;
+    run.press();
+    run.hold(true, 3000);
+    run.hold(false, 1000);
+    CHECK(run.longPresses == 0);
+    CHECK(run.lastPattern == 2);
+}
+
+static void testIdleTimeout() {
+    resetHal();
+    PowerManager power;
+    power.begin();
+    CHECK(nativeHal().wakePin == BTN_BOOT);
+
+    halDelay((SLEEP_TIMEOUT - 1) * 1000UL);
+    CHECK(!power.shouldSleep());
+    power.resetIdleTimer();
+    halDelay((SLEEP_TIMEOUT - 1) * 1000UL);
+    CHECK(!power.shouldSleep());
+    halDelay(1000);
+    CHECK(power.shouldSleep());
+}
+
+static void testDeepSleep() {
+    resetHal();
+    PowerManager power;
+    power.begin();
+    halDigitalWrite(SPK_SD_MODE, HIGH);
+    halDigitalWrite(LED_BUILTIN, HIGH);
+
+    unsigned long before = halMillis();
+    power.enterDeepSleep();
+    CHECK(nativeHal().deepSleeps == 1);
+    CHECK(halDigitalRead(SPK_SD_MODE) == LOW);
+    CHECK(halDigitalRead(LED_BUILTIN) == LOW);
+    CHECK(halMillis() - before == 100);
+}
+
+static void testBatteryEstimate() {
+    resetHal();
+    PowerManager power;
+    power.begin();
+    CHECK(power.getBatteryPercent() == 100);
+    halDelay(95UL * 60 * 1000);
+    CHECK(power.getBatteryPercent() == 91);
+    halDelay(24UL * 60 * 60 * 1000);
+    CHECK(power.getBatteryPercent() == 10);   // Never reports below 10%
+}
+
+static void testButtonThroughHal() {
+    // Same wiring as loop(): active-low pin, HAL clock
+    resetHal();
+    ButtonInput button;
+    int patterns = 0;
+    for (int step = 0; step < 200; step++) {
+        // Press for 100 ms at 200 ms, once
+        halDigitalWrite(BTN_BOOT, (step >= 20 && step < 30) ? LOW : HIGH);
+        if (button.update(halDigitalRead(BTN_BOOT) == LOW, halMillis()) == BUTTON_PRESSES) {
+            patterns++;
+            CHECK(button.getPressCount() == 1);
+        }
+        halDelay(10);
+    }
+    CHECK(patterns == 1);
+}
+
+int main() {
+    testSingleClick();
+    testMultiPress();
+    testDebounce();
+    testSeparatePatterns();
+    testLongPress();
+    testLongHoldAfterClick();
+    testIdleTimeout();
+    testDeepSleep();
+    testBatteryEstimate();
+    testButtonThroughHal();
+
+    return testSummary();
+}
@@ -0,0 +1,315 @@
+#!/usr/bin/env python3
+"""
+VOLT AI Watch - Realtime API Stand-in Server
+Speaks enough of the OpenAI Realtime WebSocket protocol to exercise
+VOLT's realtime mode (volt_realtime.h) without an API key.
+
+Handles session.update, input_audio_buffer.clear/append/commit and
+response.create. The reply is the uploaded audio echoed back (or a
+16-bit mono WAV given with --wav), sent as response.audio.delta events.
+
+For realtime_test (see CMakeLists.txt) it can also misbehave on purpose:
+--fragment-bytes splits every event over continuation frames, --ping
+pings after session.created, --bad-accept answers the upgrade with the
+wrong Sec-WebSocket-Accept, --mask-frames masks what it sends and
+--close-on-commit closes the session instead of replying. --port 0 takes
+a free port; the first line printed says which.
+
+Standard library only. Plain ws:// (put a TLS proxy in front if needed).
+"""
+
+import argparse
+import base64
+import hashlib
+import json
+import os
+import socket
+import struct
+import sys
+import threading
+import time
+import wave
+
+WS_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+OP_TEXT = 0x1
+OP_BINARY = 0x2
+OP_CLOSE = 0x8
+OP_PING = 0x9
+OP_PONG = 0xA
+
+SAMPLE_RATE = 24000
+
+
+def accept_key(key):
+    """Sec-WebSocket-Accept value for a client key"""
+    digest = hashlib.sha1((key + WS_GUID).encode("ascii")).digest()
+    return base64.b64encode(digest).decode("ascii")
+
+
+def recv_exact(sock, n):
+    data = b""
+    while len(data) < n:
+        chunk = sock.recv(n - len(data))
+        if not chunk:
+            raise ConnectionError("client closed")
+        data += chunk
+    return data
+
+
+def read_frame(sock):
+    """Return (fin, opcode, payload) for one client frame"""
+    b0, b1 = recv_exact(sock, 2)
+    fin = bool(b0 & 0x80)
+    opcode = b0 & 0x0F
+    masked = bool(b1 & 0x80)
+    length = b1 & 0x7F
+    if length == 126:
+        length = struct.unpack(">H", recv_exact(sock, 2))[0]
+    elif length == 127:
+        length = struct.unpack(">Q", recv_exact(sock, 8))[0]
+    mask = recv_exact(sock, 4) if masked else b"\0\0\0\0"
+    payload = bytearray(recv_exact(sock, length))
+    for i in range(length):
+        payload[i] ^= mask[i & 3]
+    return fin, opcode, bytes(payload)
+
+
+def encode_frame(opcode, payload, fin=True, mask=False):
+    """Server frames are never masked (unless testing that clients refuse them)"""
+    header = bytearray([(0x80 if fin else 0) | opcode])
+    bit = 0x80 if mask else 0
+    n = len(payload)
+    if n < 126:
+        header.append(bit | n)
+    elif n < 65536:
+        header.append(bit | 126)
+        header += struct.pack(">H", n)
+    else:
+        header.append(bit | 127)
+        header += struct.pack(">Q", n)
+    if mask:
+        key = os.urandom(4)
+        header += key
+        payload = bytes(b ^ key[i & 3] for i, b in enumerate(payload))
+    return bytes(header) + payload
+
+
+def encode_message(opcode, payload, fragment_bytes=0, mask=False):
+    """One message, split over continuation frames if fragment_bytes is set"""
+    if fragment_bytes <= 0 or len(payload) <= fragment_bytes:
+        return encode_frame(opcode, payload, mask=mask)
+    frames = b""
+    for offset in range(0, len(payload), fragment_bytes):
+        piece = payload[offset:offset + fragment_bytes]
+        last = offset + fragment_bytes >= len(payload)
+        frames += encode_frame(opcode if offset == 0 else 0x0, piece, fin=last, mask=mask)
+    return frames
+
+
+def load_wav(path):
+    """Read a 16-bit mono WAV, return raw little-endian PCM"""
+    with wave.open(path, "rb") as w:
+        if w.getsampwidth() != 2 or w.getnchannels() != 1:
+            raise ValueError("WAV must be 16-bit mono")
+        if w.getframerate() != SAMPLE_RATE:
+            print(f"⚠️  {path} is {w.getframerate()} Hz, Realtime audio is {SAMPLE_RATE} Hz")
+        return w.readframes(w.getnframes())
+
+
+class Session:
+    """One connected client"""
+
+    def __init__(self, sock, args):
+        self.sock = sock
+        self.args = args
+        self.audio = bytearray()
+        self.event_count = 0
+        self.send_lock = threading.Lock()
+        self.closing = False
+
+    def send_frame(self, opcode, payload):
+        with self.send_lock:
+            self.sock.sendall(encode_frame(opcode, payload, mask=self.args.mask_frames))
+
+    def send(self, event):
+        data = json.dumps(event, separators=(",", ":")).encode("utf-8")
+        with self.send_lock:
+            self.sock.sendall(encode_message(OP_TEXT, data, self.args.fragment_bytes,
+                                             self.args.mask_frames))
+
+    def next_id(self, prefix):
+        self.event_count += 1
+        return f"{prefix}_{self.event_count:04d}"
+
+    def handshake(self):
+        request = b""
+        while b"\r\n\r\n" not in request:
+            chunk = self.sock.recv(1024)
+            if not chunk:
+                return False
+            request += chunk
+        lines = request.decode("latin-1").split("\r\n")
+        headers = {}
+        for line in lines[1:]:
+            if ":" in line:
+                name, value = line.split(":", 1)
+                headers[name.strip().lower()] = value.strip()
+
+        if self.args.require_key and not headers.get("authorization", "").startswith("Bearer "):
+            self.sock.sendall(b"HTTP/1.1 401 Unauthorized\r\nContent-Length: 0\r\n\r\n")
+            return False
+
+        key = headers.get("sec-websocket-key", "")
+        if self.args.bad_accept:
+            key += "x"
+        response = (
+            "HTTP/1.1 101 Switching Protocols\r\n"
+            "Upgrade: websocket\r\n"
+            "Connection: Upgrade\r\n"
+            f"Sec-WebSocket-Accept: {accept_key(key)}\r\n\r\n"
+        )
+        self.sock.sendall(response.encode("ascii"))
+        print(f"🔌 {lines[0]}")
+        return True
+
+    def respond(self):
+        """Stream the reply as audio deltas"""
+        time.sleep(self.args.delay_ms / 1000.0)
+        audio = self.args.wav_pcm if self.args.wav_pcm is not None else bytes(self.audio)
+        response_id = self.next_id("resp")
+        self.send({"type": "response.created", "response": {"id": response_id}})
+
+        chunk = self.args.chunk_bytes & ~1
+        bytes_per_sec = SAMPLE_RATE * 2
+        start = time.monotonic()
+        sent = 0
+        for offset in range(0, len(audio), chunk):
+            piece = audio[offset:offset + chunk]
+            self.send({
+                "type": "response.audio.delta",
+                "event_id": self.next_id("evt"),
+                "response_id": response_id,
+                "delta": base64.b64encode(piece).decode("ascii"),
+            })
+            sent += len(piece)
+            if self.args.realtime:
+                # Pace like a live model: never run ahead of playback
+                ahead = sent / bytes_per_sec - (time.monotonic() - start)
+                if ahead > 0:
+                    time.sleep(ahead)
+
+        self.send({"type": "response.audio.done", "response_id": response_id})
+        self.send({"type": "response.done", "response": {"id": response_id, "status": "completed"}})
+        print(f"🔊 Sent {sent} bytes of audio")
+
+    def handle_event(self, event):
+        kind = event.get("type", "")
+        if self.closing:
+            return
+        if kind == "session.update":
+            self.send({"type": "session.updated", "session": event.get("session", {})})
+        elif kind == "input_audio_buffer.clear":
+            self.audio = bytearray()
+            self.send({"type": "input_audio_buffer.cleared"})
+        elif kind == "input_audio_buffer.append":
+            self.audio += base64.b64decode(event.get("audio", ""))
+        elif kind == "input_audio_buffer.commit":
+            print(f"🎙️  Committed {len(self.audio)} bytes of input audio")
+            if self.args.close_on_commit:
+                self.send_frame(OP_CLOSE, struct.pack(">H", 1000))
+                self.closing = True
+                return
+            self.send({"type": "input_audio_buffer.committed", "item_id": self.next_id("item")})
+        elif kind == "response.create":
+            self.respond()
+        else:
+            self.send({"type": "error", "error": {"message": f"Unknown event type: {kind}"}})
+
+    def run(self):
+        if not self.handshake():
+            return
+        self.send({"type": "session.created", "session": {"id": self.next_id("sess")}})
+        if self.args.ping:
+            self.send_frame(OP_PING, b"volt")
+        message = b""
+        while True:
+            fin, opcode, payload = read_frame(self.sock)
+            if opcode == OP_CLOSE:
+                code = struct.unpack(">H", payload[:2])[0] if len(payload) >= 2 else 1005
+                print(f"👋 Close {code}")
+                if not self.closing:
+                    self.send_frame(OP_CLOSE, payload[:2])
+                return
+            if opcode == OP_PING:
+                self.send_frame(OP_PONG, payload)
+                continue
+            if opcode == OP_PONG:
+                print(f"🏓 Pong {payload.decode('latin-1')}")
+                continue
+            if opcode in (OP_TEXT, OP_BINARY, 0x0):
+                message += payload
+                if fin:
+                    try:
+                        self.handle_event(json.loads(message))
+                    except ValueError:
+                        self.send({"type": "error", "error": {"message": "Invalid JSON"}})
+                    message = b""
+
+
+def serve(args):
+    server = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    server.bind((args.host, args.port))
+    server.listen(4)
+    port = server.getsockname()[1]
+    print(f"⚡ Realtime stand-in listening on ws://{args.host}:{port}/v1/realtime", flush=True)
+
+    while True:
+        sock, addr = server.accept()
+        sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+
+        def worker(s=sock, a=addr):
+            try:
+                Session(s, args).run()
+            except (ConnectionError, OSError) as e:
+                print(f"❌ {a[0]}: {e}")
+            finally:
+                s.close()
+
+        threading.Thread(target=worker, daemon=True).start()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Stand-in for the OpenAI Realtime API")
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=8765)
+    parser.add_argument("--wav", help="Reply with this 16-bit mono WAV instead of echoing")
+    parser.add_argument("--delay-ms", type=int, default=0, help="Delay before the first delta")
+    parser.add_argument("--chunk-bytes", type=int, default=4800, help="PCM bytes per delta")
+    parser.add_argument("--realtime", action="store_true", help="Pace deltas at playback speed")
+    parser.add_argument("--require-key", action="store_true", help="Reject requests without a Bearer token")
+    parser.add_argument("--fragment-bytes", type=int, default=0,
+                        help="Split events into frames of this many bytes")
+    parser.add_argument("--ping", action="store_true", help="Ping the client after session.created")
+    parser.add_argument("--bad-accept", action="store_true", help="Answer the upgrade with a wrong key")
+    parser.add_argument("--mask-frames", action="store_true", help="Mask server frames (a protocol error)")
+    parser.add_argument("--close-on-commit", action="store_true",
+                        help="Close the session instead of replying")
+    args = parser.parse_args()
+
+    args.wav_pcm = None
+    if args.wav:
+        if not os.path.exists(args.wav):
+            print(f"❌ {args.wav} not found")
+            sys.exit(1)
+        args.wav_pcm = load_wav(args.wav)
+
+    try:
+        serve(args)
+    except KeyboardInterrupt:
+        print("\n👋 Stopped")
+
+
+if __name__ == "__main__":
+    main()
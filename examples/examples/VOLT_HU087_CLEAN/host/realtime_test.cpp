@@ -0,0 +1,317 @@
+/*
+ * ============================================
+ * Realtime Engine Tests (host)
+ * ============================================
+ *
+ * Runs VoltRealtime (volt_realtime.h) and its
+ * WsClient (ws_client.h) over ws:// against
+ * realtime_standin_server.py, started once per
+ * case with the options it needs:
+ * - A whole turn: mic frames streamed up as
+ *   they are recorded, the echoed reply played
+ *   back byte for byte as the upsampled
+ *   (Upsampler2to3) mic audio, every event cut
+ *   into continuation frames
+ * - Upgrade: the accept key is checked, a wrong
+ *   one is refused
+ * - Ping answered with a pong, held back while
+ *   a frame is half written
+ * - Close from the server (echoed) and from the
+ *   client; masked server frames fail the
+ *   session with 1002
+ *
+ * Needs ArduinoJson and Python 3; built and run
+ * by CMakeLists.txt (ctest), which passes the
+ * interpreter and the server script.
+ *
+ * ============================================
+ */
+
+#include "volt_realtime.h"
+#include "test_check.h"
+
+#include <chrono>
+#include <poll.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+// ============================================
+// STAND-IN SERVER
+// ============================================
+
+static const char* python = nullptr;
+static const char* serverScript = nullptr;
+
+// realtime_standin_server.py on a free port; its output is the log
+class StandIn {
+private:
+    pid_t pid;
+    int fd;
+    std::string log;
+
+public:
+    uint16_t port;
+
+    StandIn() : pid(-1), fd(-1), port(0) {}
+    ~StandIn() { stop(); }
+
+    bool start(std::vector<const char*> flags) {
+        int p[2];
+        if (pipe(p) != 0) return false;
+        std::vector<const char*> argv = { python, "-u", serverScript, "--port", "0" };
+        argv.insert(argv.end(), flags.begin(), flags.end());
+        argv.push_back(nullptr);
+
+        pid = fork();
+        if (pid == 0) {
+            dup2(p[1], STDOUT_FILENO);
+            close(p[0]);
+            close(p[1]);
+            execv(python, (char* const*)argv.data());
+            _exit(127);
+        }
+        close(p[1]);
+        fd = p[0];
+        if (pid < 0 || !waitLog("/v1/realtime", 5000)) return false;
+
+        size_t at = log.find("ws://127.0.0.1:");
+        port = at == std::string::npos ? 0 : (uint16_t)atoi(log.c_str() + at + 15);
+        return port != 0;
+    }
+
+    // Whether the server printed text within timeoutMs
+    bool waitLog(const char* text, int timeoutMs = 3000) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        while (log.find(text) == std::string::npos) {
+            if (std::chrono::steady_clock::now() >= deadline) return false;
+            struct pollfd pfd = { fd, POLLIN, 0 };
+            if (poll(&pfd, 1, 10) <= 0) continue;
+            char buf[512];
+            ssize_t n = read(fd, buf, sizeof(buf));
+            if (n <= 0) return log.find(text) != std::string::npos;
+            log.append(buf, n);
+        }
+        return true;
+    }
+
+    void stop() {
+        if (pid > 0) {
+            kill(pid, SIGTERM);
+            waitpid(pid, nullptr, 0);
+            pid = -1;
+        }
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+};
+
+// One engine for every case, as on the watch: sessions reopen
+static VoltRealtime realtime;
+
+static const char* TEST_KEY = "sk-test-0123456789";
+static const char* TEST_PROMPT = "You are VOLT, a friendly helper.";
+
+static void resetHal(const StandIn& server) {
+    resetHal();
+    nativeHal().paceMic = true;          // Frames at recording pace
+    nativeHal().paceSpeaker = false;
+    nativeClock().setVirtual(false);     // Sockets need real time
+    nativeRoutes().clear();
+    nativeRoutes().add("api.openai.com", 443, "127.0.0.1", server.port, false);
+    static const int16_t silence[160] = {};
+    nativeHal().setMicPcm(silence, sizeof(silence), SAMPLE_RATE);
+}
+
+// Collects whole messages
+struct Messages : public WsHandler {
+    std::string current;
+    std::vector<std::string> done;
+    uint16_t closeCode;
+
+    Messages() : closeCode(0) {}
+
+    void onMessageData(uint8_t opcode, const uint8_t* data, size_t len,
+                       bool first, bool last) override {
+        if (first) current.clear();
+        current.append((const char*)data, len);
+        if (last) done.push_back(current);
+    }
+
+    void onClose(uint16_t code) override { closeCode = code; }
+
+    bool has(const char* text) const {
+        for (const std::string& m : done) {
+            if (m.find(text) != std::string::npos) return true;
+        }
+        return false;
+    }
+};
+
+// ============================================
+// TESTS
+// ============================================
+
+static void testTurn() {
+    StandIn server;
+    CHECK(server.start({ "--fragment-bytes", "40", "--ping" }));
+    resetHal(server);
+
+    std::vector<int16_t> mic(4000);                   // 250 ms
+    for (size_t i = 0; i < mic.size(); i++) mic[i] = (int16_t)((i * 37) % 2000 - 1000);
+    nativeHal().setMicPcm(mic.data(), mic.size() * 2, SAMPLE_RATE);
+    char path[] = "/tmp/realtime_testXXXXXX";
+    int out = mkstemp(path);
+    CHECK(out >= 0);
+    close(out);
+    CHECK(nativeHal().setSpeakerFile(path));
+
+    CHECK(realtime.streamMicrophone(400));
+    CHECK(realtime.requestResponse());
+    CHECK(realtime.playResponse(5000));
+    CHECK(server.waitLog("Pong volt"));
+    realtime.end();
+    CHECK(server.waitLog("Close 1000"));
+
+    nativeHal().setSpeakerFile(nullptr);
+    std::vector<int16_t> played;
+    FILE* f = fopen(path, "rb");
+    int16_t s;
+    while (f && fread(&s, sizeof(s), 1, f) == 1) played.push_back(s);
+    if (f) fclose(f);
+    unlink(path);
+
+    // The echo, then 512 bytes of silence padding
+    CHECK(played.size() > 256);
+    size_t echoed = played.size() > 256 ? played.size() - 256 : 0;
+    char committed[64];
+    snprintf(committed, sizeof(committed), "Committed %u bytes", (unsigned)(echoed * 2));
+    CHECK(server.waitLog(committed));
+
+    // Whole mic frames (the mic then silence), upsampled 128 at a time
+    const size_t FRAME = TTS_JITTER_BUFFER / sizeof(int16_t);
+    Upsampler2to3 up;
+    std::vector<int16_t> expected;
+    int16_t slice[128];
+    int16_t upSlice[128 * 3 / 2 + 2];
+    for (size_t i = 0; expected.size() < echoed; i += 128) {
+        for (size_t k = 0; k < 128; k++) {
+            slice[k] = i + k < mic.size() ? mic[i + k] : 0;
+        }
+        size_t n = up.process(slice, 128, upSlice);
+        expected.insert(expected.end(), upSlice, upSlice + n);
+        if ((i + 128) % FRAME == 0 && expected.size() >= echoed) break;
+    }
+    CHECK(echoed > mic.size() * 3 / 2);             // All the mic audio came back
+    CHECK(expected.size() == echoed);
+    CHECK(echoed && std::equal(expected.begin(), expected.begin() + echoed, played.begin()));
+    bool silence = true;
+    for (size_t i = echoed; i < played.size(); i++) silence = silence && played[i] == 0;
+    CHECK(silence);
+}
+
+static void testBadAcceptKey() {
+    StandIn server;
+    CHECK(server.start({ "--bad-accept" }));
+    resetHal(server);
+    CHECK(server.waitLog("/v1/realtime"));
+    CHECK(!realtime.streamMicrophone(200));
+    CHECK(server.waitLog("GET /v1/realtime?model="));  // It did get the upgrade
+    CHECK(!realtime.requestResponse());
+    CHECK(!server.waitLog("Committed", 200));
+    realtime.end();
+}
+
+static void testMaskedFrames() {
+    StandIn server;
+    CHECK(server.start({ "--mask-frames" }));
+    resetHal(server);
+    CHECK(!realtime.streamMicrophone(400));
+    CHECK(server.waitLog("Close 1002"));
+    CHECK(!realtime.requestResponse());
+    realtime.end();
+}
+
+static void testServerClose() {
+    StandIn server;
+    CHECK(server.start({ "--close-on-commit" }));
+    resetHal(server);
+    CHECK(realtime.streamMicrophone(200));
+    CHECK(realtime.requestResponse());
+    CHECK(!realtime.playResponse(5000));
+    CHECK(server.waitLog("Close 1000"));               // The echo
+    CHECK(!realtime.requestResponse());
+    realtime.end();
+}
+
+// A ping that arrives while a frame is half written is answered
+// after the frame; inside it, the server would see broken JSON
+static void testPingMidFrame() {
+    StandIn server;
+    CHECK(server.start({ "--ping" }));
+    resetHal(server);
+
+    HalTlsClient tls;
+    WsClient ws;
+    Messages msgs;
+    CHECK(tls.connect("api.openai.com", 443));
+    CHECK(ws.handshake(tls, "api.openai.com", "/v1/realtime", nullptr, 2000));
+
+    // session.created and the ping
+    const char* created = "{\"type\":\"session.created\",\"session\":{\"id\":\"sess_0001\"}}";
+    int expect = 2 + (int)strlen(created) + 2 + 4;
+    unsigned long start = halMillis();
+    while (tls.available() < expect && halMillis() - start < 2000) halDelay(1);
+
+    const char* clear = "{\"type\":\"input_audio_buffer.clear\"}";
+    size_t len = strlen(clear);
+    CHECK(ws.beginFrame(WS_OP_TEXT, len));
+    CHECK(ws.writeFrameData((const uint8_t*)clear, 10));
+    CHECK(ws.poll(msgs));
+    CHECK(msgs.has("session.created"));
+    CHECK(!server.waitLog("Pong", 200));
+    CHECK(ws.writeFrameData((const uint8_t*)clear + 10, len - 10));
+
+    start = halMillis();
+    while (!msgs.has("input_audio_buffer.cleared") && halMillis() - start < 2000) {
+        ws.poll(msgs);
+        halDelay(1);
+    }
+    CHECK(msgs.has("input_audio_buffer.cleared"));
+    CHECK(!msgs.has("error"));
+    CHECK(server.waitLog("Pong volt"));
+
+    ws.close();
+    CHECK(server.waitLog("Close 1000"));
+    CHECK(msgs.closeCode == 0);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        printf("Usage: realtime_test <python3> <realtime_standin_server.py>\n");
+        return 1;
+    }
+    python = argv[1];
+    serverScript = argv[2];
+    Serial.quiet = true;
+
+    MemPools& pools = memPools();
+    pools.begin(VOLT_POOL_LAYOUT, sizeof(VOLT_POOL_LAYOUT) / sizeof(VOLT_POOL_LAYOUT[0]));
+    if (!USE_REALTIME_MODE) {
+        pools.addBucket({ "event", REALTIME_EVENT_BUFFER, 1, MEM_CAP_SPIRAM, MEM_CAP_INTERNAL });
+    }
+    CHECK(realtime.begin(TEST_KEY, TEST_PROMPT));
+
+    testTurn();
+    testBadAcceptKey();
+    testMaskedFrames();
+    testServerClose();
+    testPingMidFrame();
+
+    return testSummary();
+}
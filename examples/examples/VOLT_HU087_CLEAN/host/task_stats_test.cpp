@@ -0,0 +1,310 @@
+/*
+ * ============================================
+ * Task Stats Tests (host)
+ * ============================================
+ *
+ * Runs task_stats.h against the native HAL's
+ * scripted task table: each test adds tasks,
+ * advances their run-time counters and the
+ * total between samples, and checks the CPU
+ * shares, per-core idle, stack warnings, queue
+ * depths, counter wrap-around, tasks coming
+ * and going, and the text and Prometheus
+ * output.
+ *
+ * Built by CMakeLists.txt (ctest).
+ *
+ * ============================================
+ */
+
+#include "task_stats.h"
+#include "test_check.h"
+
+#include <string>
+
+// Collects a report
+class Capture : public Print {
+public:
+    std::string text;
+
+    size_t write(uint8_t b) override {
+        text += (char)b;
+        return 1;
+    }
+
+    size_t write(const uint8_t* buf, size_t size) override {
+        text.append((const char*)buf, size);
+        return size;
+    }
+
+    bool has(const char* s) const { return text.find(s) != std::string::npos; }
+};
+
+// The watch at rest: two idle tasks, the loop task on core 1 and
+// the WiFi driver on core 0. Returns the stats, sampled once.
+struct RestTasks {
+    int idle0, idle1, loop, wifi;
+};
+
+static RestTasks bootBoard(TaskStats& stats, uint32_t start = 0) {
+    resetHal();
+    stats.reset();
+    NativeHal& hal = nativeHal();
+    RestTasks b;
+    b.idle0 = hal.addTask("IDLE0", 0, 900, true);
+    b.idle1 = hal.addTask("IDLE1", 1, 900, true);
+    b.loop = hal.addTask("loopTask", 1, 5000);
+    b.wifi = hal.addTask("wifi", 0, 2200);
+    hal.taskRunTime = start;
+    for (int i = 0; i < hal.taskCount; i++) hal.tasks[i].runTime = start;
+    stats.sample();
+    return b;
+}
+
+// One interval of `total` counts per core
+static void run(const RestTasks& b, uint32_t total, uint32_t idle0, uint32_t idle1,
+                uint32_t loop, uint32_t wifi) {
+    NativeHal& hal = nativeHal();
+    hal.taskRunTime += total;
+    hal.tasks[b.idle0].runTime += idle0;
+    hal.tasks[b.idle1].runTime += idle1;
+    hal.tasks[b.loop].runTime += loop;
+    hal.tasks[b.wifi].runTime += wifi;
+}
+
+// ============================================
+// CPU AND IDLE
+// ============================================
+
+static void testShares() {
+    TaskStats stats;
+    RestTasks b = bootBoard(stats);
+    CHECK(stats.getTaskCount() == 4);
+    CHECK(stats.getSamples() == 1);
+    // First sample has nothing to compare with
+    CHECK(stats.getTask(b.loop).cpuPermille == 0);
+    CHECK(stats.getIdlePermille(0) == 0);
+
+    // 5 s at 1 MHz: loop task busy 40%, WiFi 15%
+    run(b, 5000000, 4250000, 3000000, 2000000, 750000);
+    stats.sample();
+    CHECK(stats.findByName("loopTask")->cpuPermille == 400);
+    CHECK(stats.findByName("wifi")->cpuPermille == 150);
+    CHECK(stats.getIdlePermille(0) == 850);
+    CHECK(stats.getIdlePermille(1) == 600);
+    CHECK(stats.findByName("IDLE1")->idle);
+    CHECK(stats.findByName("loopTask")->core == 1);
+
+    // A turn: core 1 pegged
+    run(b, 5000000, 4000000, 0, 5000000, 1000000);
+    stats.sample();
+    CHECK(stats.findByName("loopTask")->cpuPermille == 1000);
+    CHECK(stats.getIdlePermille(1) == 0);
+    CHECK(stats.getIdlePermille(0) == 800);
+
+    // Nothing ran between two samples: no division by zero
+    stats.sample();
+    CHECK(stats.findByName("loopTask")->cpuPermille == 0);
+    CHECK(stats.getIdlePermille(1) == 0);
+}
+
+// Run-time counters are 32 bits and wrap after ~71 minutes at 1 MHz
+static void testWrap() {
+    TaskStats stats;
+    RestTasks b = bootBoard(stats, 0xFFFFFFFFu - 1000000);
+    run(b, 4000000, 3000000, 2000000, 2000000, 1000000);
+    CHECK(nativeHal().taskRunTime < 4000000);     // Total wrapped
+    stats.sample();
+    CHECK(stats.findByName("loopTask")->cpuPermille == 500);
+    CHECK(stats.findByName("wifi")->cpuPermille == 250);
+    CHECK(stats.getIdlePermille(0) == 750);
+    CHECK(stats.getIdlePermille(1) == 500);
+}
+
+static void testTasksComeAndGo() {
+    TaskStats stats;
+    RestTasks b = bootBoard(stats);
+    NativeHal& hal = nativeHal();
+
+    // A task created mid-interval shows 0 until it has a start point
+    int audio = hal.addTask("audio", 0, 3000);
+    run(b, 1000000, 500000, 800000, 200000, 100000);
+    hal.tasks[audio].runTime += 400000;
+    stats.sample();
+    CHECK(stats.getTaskCount() == 5);
+    CHECK(stats.findByName("audio")->cpuPermille == 0);
+
+    hal.taskRunTime += 1000000;
+    hal.tasks[audio].runTime += 300000;
+    stats.sample();
+    CHECK(stats.findByName("audio")->cpuPermille == 300);
+
+    // Deleted: gone from the stats; the others keep their history
+    hal.removeTask(audio);
+    run(b, 1000000, 900000, 900000, 100000, 100000);
+    stats.sample();
+    CHECK(stats.getTaskCount() == 4);
+    CHECK(stats.findByName("audio") == nullptr);
+    CHECK(stats.findByName("loopTask")->cpuPermille == 100);
+
+    // A new task that reuses a name is a new task (new id)
+    int again = hal.addTask("audio", 0, 3000);
+    hal.tasks[again].runTime = 123456789;
+    hal.taskRunTime += 1000000;
+    stats.sample();
+    CHECK(stats.findByName("audio")->cpuPermille == 0);
+}
+
+static void testTableFull() {
+    TaskStats stats;
+    resetHal();
+    char name[16];
+    for (int i = 0; i < HAL_MAX_TASKS + 3; i++) {
+        snprintf(name, sizeof(name), "t%d", i);
+        nativeHal().addTask(name, -1, 1000);
+    }
+    CHECK(nativeHal().taskCount == HAL_MAX_TASKS);
+    stats.sample();
+    CHECK(stats.getTaskCount() == TaskStats::MAX_TASKS);
+}
+
+// ============================================
+// STACKS AND QUEUES
+// ============================================
+
+static void testStacks() {
+    TaskStats stats;
+    RestTasks b = bootBoard(stats);
+    NativeHal& hal = nativeHal();
+    CHECK(stats.findByName("loopTask")->stackFree == 5000);
+
+    // High-water mark only goes down
+    hal.tasks[b.loop].stackFree = 1200;
+    stats.sample();
+    hal.tasks[b.loop].stackFree = 4000;    // Can't happen on FreeRTOS, still kept
+    stats.sample();
+    CHECK(stats.findByName("loopTask")->stackFree == 1200);
+    CHECK(!stats.findByName("loopTask")->stackWarned);
+
+    // Warned once when it drops under STACK_WARN_BYTES
+    hal.tasks[b.wifi].stackFree = 300;
+    stats.sample();
+    stats.sample();
+    CHECK(stats.findByName("wifi")->stackWarned);
+
+    Capture out;
+    stats.printReport(out);
+    CHECK(out.has("wifi"));
+    CHECK(out.has("300  LOW"));
+}
+
+struct FakeQueue {
+    uint32_t waiting;
+    uint32_t length;
+};
+
+static uint32_t fakeDepth(void* queue, uint32_t* capacity) {
+    FakeQueue* q = (FakeQueue*)queue;
+    *capacity = q->length;
+    return q->waiting;
+}
+
+static void testQueues() {
+    TaskStats stats;
+    FakeQueue audio = { 0, 8 };
+    FakeQueue events = { 0, 4 };
+    CHECK(stats.watchQueue("audio", &audio, fakeDepth));
+    CHECK(stats.watchQueue("events", &events, fakeDepth));
+    CHECK(!stats.watchQueue("broken", &events, nullptr));
+    bootBoard(stats);
+
+    audio.waiting = 6;
+    events.waiting = 1;
+    stats.sample();
+    audio.waiting = 2;
+    stats.sample();
+    CHECK(stats.getQueueCount() == 2);
+    CHECK(stats.getQueue(0).depth == 2);
+    CHECK(stats.getQueue(0).capacity == 8);
+    CHECK(stats.getQueue(0).peakDepth == 6);
+    CHECK(stats.getQueue(1).depth == 1);
+
+    for (int i = 0; i < TaskStats::MAX_QUEUES - 2; i++) {
+        CHECK(stats.watchQueue("more", &events, fakeDepth));
+    }
+    CHECK(!stats.watchQueue("one too many", &events, fakeDepth));
+}
+
+// ============================================
+// OUTPUT AND SCHEDULING
+// ============================================
+
+static void testMetrics() {
+    TaskStats stats;
+    FakeQueue audio = { 3, 8 };
+    stats.watchQueue("audio", &audio, fakeDepth);
+    RestTasks b = bootBoard(stats);
+    nativeHal().addTask("we\"ird", -1, 700);
+    run(b, 1000000, 900000, 333000, 667000, 100000);
+    stats.sample();
+
+    Capture out;
+    stats.writeMetrics(out);
+    CHECK(out.has("# TYPE volt_task_cpu_percent gauge\n"));
+    CHECK(out.has("volt_task_cpu_percent{task=\"loopTask\",core=\"1\"} 66.7\n"));
+    CHECK(out.has("volt_task_cpu_percent{task=\"wifi\",core=\"0\"} 10.0\n"));
+    CHECK(out.has("volt_task_cpu_percent{task=\"we\\\"ird\",core=\"any\"} 0.0\n"));
+    CHECK(out.has("volt_task_stack_free_bytes{task=\"loopTask\"} 5000\n"));
+    CHECK(out.has("volt_core_idle_percent{core=\"0\"} 90.0\n"));
+    CHECK(out.has("volt_core_idle_percent{core=\"1\"} 33.3\n"));
+    CHECK(out.has("volt_queue_depth{queue=\"audio\"} 3\n"));
+    CHECK(out.has("volt_queue_capacity{queue=\"audio\"} 8\n"));
+    CHECK(out.has("# TYPE volt_task_stats_samples_total counter\nvolt_task_stats_samples_total 2\n"));
+
+    // Every sample line is "name{labels} value" or "name value"
+    bool wellFormed = true;
+    size_t pos = 0;
+    while (pos < out.text.size()) {
+        size_t end = out.text.find('\n', pos);
+        std::string line = out.text.substr(pos, end - pos);
+        pos = end + 1;
+        if (line.empty() || line[0] == '#') continue;
+        size_t space = line.rfind(' ');
+        if (space == std::string::npos || space + 1 == line.size()) wellFormed = false;
+        if (line.find('{') != std::string::npos && line.find("} ") == std::string::npos) wellFormed = false;
+    }
+    CHECK(wellFormed);
+
+    Capture report;
+    stats.printReport(report);
+    CHECK(report.has("=== Tasks (5, sample "));
+    CHECK(report.has("Core 0 idle 90.0%"));
+    CHECK(report.has("Queue audio      3 / 8 (peak 3)"));
+}
+
+static void testTick() {
+    TaskStats stats;
+    resetHal();
+    stats.setInterval(5000);
+    CHECK(stats.tick(1000));             // First call samples
+    CHECK(!stats.tick(5999));
+    CHECK(stats.tick(6000));
+    CHECK(stats.getSamples() == 2);
+
+    stats.setInterval(0);                // Off
+    CHECK(!stats.tick(60000));
+    CHECK(stats.getSamples() == 2);
+}
+
+int main() {
+    testShares();
+    testWrap();
+    testTasksComeAndGo();
+    testTableFull();
+    testStacks();
+    testQueues();
+    testMetrics();
+    testTick();
+
+    return testSummary();
+}
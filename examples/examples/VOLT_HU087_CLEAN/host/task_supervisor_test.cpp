@@ -0,0 +1,316 @@
+/*
+ * ============================================
+ * Task Supervisor Tests (host)
+ * ============================================
+ *
+ * Runs task_supervisor.h on the native HAL's
+ * virtual clock: heartbeats inside and past
+ * their deadlines, resting tasks, one report
+ * per stall, and the deadline histograms.
+ *
+ * Then AppTasks under the supervisor: a normal
+ * turn stays inside every deadline, and a reply
+ * that never finishes speaking is reported as
+ * the audio task stalled in "speak" while it is
+ * still stuck. One test beats from real threads
+ * while another checks.
+ *
+ * Built and run by CMakeLists.txt (ctest).
+ *
+ * ============================================
+ */
+
+#include "volt_hal.h"
+#include "task_supervisor.h"
+#include "app_tasks.h"
+#include "test_check.h"
+
+#include <string>
+#include <thread>
+
+// Collects a report
+class Capture : public Print {
+public:
+    std::string text;
+
+    size_t write(uint8_t b) override {
+        text += (char)b;
+        return 1;
+    }
+
+    size_t write(const uint8_t* buf, size_t size) override {
+        text.append((const char*)buf, size);
+        return size;
+    }
+
+    bool has(const char* s) const { return text.find(s) != std::string::npos; }
+};
+
+static uint32_t now() { return (uint32_t)halMillis(); }
+
+struct Reports {
+    int count = 0;
+    std::string task;
+    std::string doing;
+    TaskSupervisor::Stall last = {};
+};
+
+static void onStall(const TaskSupervisor::Stall& s, void* ctx) {
+    Reports& r = *(Reports*)ctx;
+    r.count++;
+    r.task = s.task;
+    r.doing = s.doing;
+    r.last = s;
+}
+
+// ============================================
+// HEARTBEATS
+// ============================================
+
+static void testDeadline() {
+    resetHal();
+    TaskSupervisor sup;
+    Reports r;
+    sup.setStallHook(onStall, &r);
+    int ui = sup.watch("ui", 5000);
+    CHECK(ui == 0);
+
+    // Not started yet: resting, never stalled
+    halDelay(60000);
+    CHECK(sup.check(now()) == 0);
+
+    sup.beat(ui, "idle");
+    halDelay(5000);
+    CHECK(sup.check(now()) == 0);            // At the deadline is fine
+    halDelay(1);
+    CHECK(sup.check(now()) == 1);
+    CHECK(r.count == 1);
+    CHECK(r.task == "ui" && r.doing == "idle");
+    CHECK(r.last.busyMs == 5001 && r.last.deadlineMs == 5000 && r.last.beats == 1);
+    CHECK(sup.getStalls() == 1);
+
+    // Still stuck: still stalled, not reported again
+    halDelay(3000);
+    CHECK(sup.check(now()) == 1);
+    CHECK(r.count == 1);
+
+    // It comes back, then sticks again: a second report
+    sup.beat(ui);
+    CHECK(sup.check(now()) == 0);
+    CHECK(sup.getWorstMs(ui) == 8001);
+    halDelay(6000);
+    CHECK(sup.check(now()) == 1);
+    CHECK(r.count == 2);
+    CHECK(r.doing == "running");             // No label
+    CHECK(r.last.worstMs == 8001);
+    CHECK(sup.getStalls() == 2);
+}
+
+static void testRest() {
+    resetHal();
+    TaskSupervisor sup;
+    int audio = sup.watch("audio", 45000);
+    sup.beat(audio, "speak");
+    halDelay(30000);
+    sup.rest(audio);
+    CHECK(!sup.isBusy(audio));
+    CHECK(sup.getWorstMs(audio) == 30000);
+
+    // Waiting for work for an hour is not a stall
+    halDelay(3600000);
+    CHECK(sup.check(now()) == 0);
+    sup.rest(audio);                         // Twice is harmless
+    CHECK(sup.getWorstMs(audio) == 30000);
+
+    sup.beat(audio, "record");
+    CHECK(sup.isBusy(audio));
+    CHECK(sup.getBeats(audio) == 2);
+    halDelay(45001);
+    CHECK(sup.check(now()) == 1);
+}
+
+static void testHistogram() {
+    resetHal();
+    TaskSupervisor sup;
+    MetricHistogram h("volt_task_deadline_percent", "test", TaskSupervisor::percentBuckets(),
+                      TaskSupervisor::PERCENT_BUCKETS, "task=\"ui\"");
+    int ui = sup.watch("ui", 5000, &h);
+
+    // Gaps of 20%, 50%, 98% and 180% of the deadline
+    sup.beat(ui);
+    unsigned long gaps[] = { 1000, 2500, 4900, 9000 };
+    for (unsigned long g : gaps) {
+        halDelay(g);
+        sup.beat(ui);
+    }
+    CHECK(h.getCount() == 4);
+    CHECK(h.getBucket(2) == 1);              // <= 25
+    CHECK(h.getBucket(3) == 1);              // <= 50
+    CHECK(h.getBucket(6) == 1);              // <= 100
+    CHECK(h.getBucket(8) == 1);              // <= 200
+    CHECK(h.getSum() == 20 + 50 + 98 + 180);
+
+    // A rest ends a gap too
+    halDelay(250);
+    sup.rest(ui);
+    CHECK(h.getCount() == 5);
+    CHECK(h.getBucket(0) == 1);              // 5%
+}
+
+static void testLimits() {
+    resetHal();
+    TaskSupervisor sup;
+    for (int i = 0; i < TaskSupervisor::MAX_TASKS; i++) {
+        CHECK(sup.watch("t", 1000) == i);
+    }
+    CHECK(sup.watch("one too many", 1000) == -1);
+    CHECK(sup.getCount() == TaskSupervisor::MAX_TASKS);
+
+    TaskSupervisor other;
+    CHECK(other.watch("no deadline", 0) == -1);
+    other.beat(-1);                          // Ignored
+    other.beat(3);
+    other.rest(7);
+    CHECK(other.check(now()) == 0);
+
+    MetricsRegistry registry;
+    other.registerMetrics(registry);
+    CHECK(registry.find("volt_task_stalls_total") != nullptr);
+}
+
+static void testReport() {
+    resetHal();
+    TaskSupervisor sup;
+    int ui = sup.watch("ui", 5000);
+    int net = sup.watch("net", 40000);
+    sup.beat(ui, "idle");
+    sup.beat(net, "chat");
+    halDelay(1200);
+    sup.rest(ui);
+
+    Capture out;
+    sup.printReport(out, now());
+    CHECK(out.has("2 tasks, 0 stalls"));
+    CHECK(out.has("waiting"));
+    CHECK(out.has("chat"));
+    CHECK(out.has("1200"));
+    CHECK(net == 1);
+}
+
+// Beats from three threads while this one checks: with every gap
+// far inside the deadline, nothing is ever reported
+static void testThreads() {
+    resetHal();
+    nativeClock().setVirtual(false);
+    TaskSupervisor sup;
+    Reports r;
+    sup.setStallHook(onStall, &r);
+    int ids[3] = { sup.watch("a", 2000), sup.watch("b", 2000), sup.watch("c", 2000) };
+    std::atomic<bool> stop(false);
+    std::thread beaters[3];
+    for (int t = 0; t < 3; t++) {
+        beaters[t] = std::thread([&, t]() {
+            while (!stop.load()) {
+                sup.beat(ids[t], "work");
+                halDelay(1);
+                sup.rest(ids[t]);
+            }
+        });
+    }
+    int stalled = 0;
+    unsigned long end = halMillis() + 300;
+    while ((long)(halMillis() - end) < 0) {
+        stalled += sup.check(now());
+    }
+    stop.store(true);
+    for (std::thread& b : beaters) b.join();
+    CHECK(stalled == 0);
+    CHECK(r.count == 0);
+    CHECK(sup.getBeats(ids[0]) > 10);
+}
+
+// ============================================
+// APP TASKS UNDER THE SUPERVISOR
+// ============================================
+
+struct Device {
+    TaskSupervisor* sup;
+    AppTasks* app;
+    unsigned long speakMs;
+    int checkedStalls;
+};
+
+static void deviceUi(const AppCommand& cmd, void* ctx) {}
+
+static void deviceAudio(const AppCommand& cmd, AppEvent& result, void* ctx) {
+    Device& d = *(Device*)ctx;
+    unsigned long ms = cmd.type == CMD_SPEAK ? d.speakMs : 2000;
+    // Meanwhile ui keeps passing on its own task, and loop() checks
+    for (unsigned long t = 0; t < ms; t += 2000) {
+        halDelay(ms - t < 2000 ? ms - t : 2000);
+        d.app->uiStep(0);
+        d.checkedStalls += d.sup->check(now());
+    }
+}
+
+static void deviceNet(const AppCommand& cmd, AppEvent& result, void* ctx) {
+    Device& d = *(Device*)ctx;
+    if (cmd.type == CMD_TRANSCRIBE || cmd.type == CMD_CHAT) {
+        halDelay(1500);
+        result.text = "hello";
+    }
+    if (cmd.type == CMD_CHECK_NET) result.a = 1;
+    d.checkedStalls += d.sup->check(now());
+}
+
+static void testAppTurns() {
+    resetHal();
+    TaskSupervisor sup;
+    Reports r;
+    sup.setStallHook(onStall, &r);
+    AppTasks app;
+    Device d = { &sup, &app, 3000, 0 };
+    app.superviseWith(sup);
+    CHECK(sup.getCount() == 3);
+    AppTasks::Hooks hooks = { deviceUi, deviceAudio, deviceNet, nullptr, nullptr, &d };
+    AppConfig config = { FEATURE_VOICE, 5000, "Love you" };
+    CHECK(app.begin(config, hooks, -1, true));
+
+    MetricsRegistry registry;
+    app.registerMetrics(registry);
+    CHECK(registry.getCount() == 9);         // The three deadline histograms
+
+    // A normal turn: every task well inside its deadline
+    CHECK(app.post({ EV_PRESSES, 1, 0, nullptr }));
+    app.runUntilIdle();
+    CHECK(app.getState() == APP_IDLE);
+    CHECK(d.checkedStalls == 0);
+    CHECK(r.count == 0);
+    CHECK(sup.getBeats(1) == 2);             // audio: record, speak
+    CHECK(!sup.isBusy(1) && !sup.isBusy(2));
+    CHECK(sup.getWorstMs(1) == 3000);
+
+    // A reply that never finishes: reported while audio is still in it
+    d.speakMs = 60000;
+    CHECK(app.post({ EV_PRESSES, 1, 0, nullptr }));
+    app.runUntilIdle();
+    CHECK(r.count == 1);
+    CHECK(r.task == "audio" && r.doing == "speak");
+    CHECK(r.last.busyMs > AppTasks::AUDIO_DEADLINE_MS && r.last.busyMs <= AppTasks::AUDIO_DEADLINE_MS + 2000);
+    CHECK(d.checkedStalls >= 1);
+
+    // Once it returns, the next check is clean again
+    CHECK(sup.check(now()) == 0);
+}
+
+int main() {
+    testDeadline();
+    testRest();
+    testHistogram();
+    testLimits();
+    testReport();
+    testThreads();
+    testAppTurns();
+
+    return testSummary();
+}
@@ -0,0 +1,48 @@
+/*
+ * ============================================
+ * Host Tests - Checks
+ * ============================================
+ *
+ * Shared by every test in host/:
+ * - CHECK(cond): counts the check; a failing
+ *   one prints its file, line and condition
+ *   and the run goes on
+ * - testSummary(): the "N checks, M failed"
+ *   line, and main()'s exit code
+ * - resetHal(): the native HAL as a logic test
+ *   starts (quiet, virtual clock). Suites that
+ *   need more (real time for sockets, smaller
+ *   heaps) call it from their own reset.
+ *
+ * ============================================
+ */
+
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+
+#include <stdio.h>
+#include "volt_hal.h"
+
+static int failures = 0;
+static int checks = 0;
+
+#define CHECK(cond) do { \
+    checks++; \
+    if (!(cond)) { \
+        failures++; \
+        printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+    } \
+} while (0)
+
+inline int testSummary() {
+    printf("%d checks, %d failed\n", checks, failures);
+    return failures == 0 ? 0 : 1;
+}
+
+inline void resetHal() {
+    nativeHal().reset();
+    nativeHal().quiet = true;
+    nativeClock().setVirtual(true);
+}
+
+#endif // TEST_CHECK_H
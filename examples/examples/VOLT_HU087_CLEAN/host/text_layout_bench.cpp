@@ -0,0 +1,154 @@
+/*
+ * ============================================
+ * Text Layout Benchmark (host)
+ * ============================================
+ *
+ * What text_layout.h costs a character, and
+ * what text_scroller.h sends the panel:
+ * - Laying out an 800-character reply at once,
+ *   in the built-in font (as a page) and a
+ *   packed font
+ * - The same reply streamed in pieces of 1, 8
+ *   and 64 characters: append() as it arrives,
+ *   against laying out everything so far again
+ *   for every piece ("reflow")
+ * - Following speech through it on the 172x320
+ *   panel: pixels sent and time per frame with
+ *   the ST7789's vertical scroll, and with the
+ *   band redrawn every step
+ *
+ * Times are ns per character of text, so they
+ * compare across piece sizes.
+ *
+ * Build and run (from this directory):
+ *   cmake -S . -B build && cmake --build build
+ *   ./build/text_layout_bench
+ *
+ * ============================================
+ */
+
+#include "volt_hal.h"
+#include "text_layout.h"
+#include "text_scroller.h"
+#include "volt_screens.h"
+#include "ui_assets_data.h"
+#include "ui_framebuffer.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+
+typedef std::chrono::steady_clock Clock;
+
+static const double MIN_SECONDS = 0.05;
+static const int16_t W = 172;
+static const int16_t H = 320;
+
+// Runs fn until MIN_SECONDS have passed; seconds per call
+template <typename Fn>
+static double timeIt(Fn fn) {
+    uint32_t n = 0, batch = 16;
+    Clock::time_point start = Clock::now();
+    double elapsed = 0;
+    while (elapsed < MIN_SECONDS) {
+        for (uint32_t i = 0; i < batch; i++) fn();
+        n += batch;
+        batch *= 2;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+    return elapsed / n;
+}
+
+// A long reply, about 800 characters
+static std::string reply() {
+    const char* s =
+        "The sky looks blue because sunlight is made of every color, and the air scatters blue light "
+        "the most. So when you look up, blue light comes at you from all over the sky! At sunset the "
+        "light travels through more air, so the blue gets scattered away and you see orange and red. ";
+    std::string text;
+    while (text.size() + strlen(s) <= 1000) text += s;
+    return text;
+}
+
+static void benchWhole(const char* name, const TextMetrics& m, const std::string& text) {
+    TextLayout t;
+    double s = timeIt([&] {
+        t.begin(m, 156);
+        t.append(text.c_str(), (int)text.size());
+    });
+    printf("%-22s %6d %6d %10.1f\n", name, t.getLength(), t.getLineCount(), s * 1e9 / text.size());
+}
+
+static void benchPieces(int piece, const TextMetrics& m, const std::string& text) {
+    int len = (int)text.size();
+    TextLayout t;
+    double incremental = timeIt([&] {
+        t.begin(m, 156);
+        for (int at = 0; at < len; at += piece) t.append(text.c_str() + at, piece < len - at ? piece : len - at);
+    });
+    uint32_t measured = t.getMeasured();
+    double reflow = timeIt([&] {
+        for (int at = 0; at < len; at += piece) {
+            int end = at + piece < len ? at + piece : len;
+            t.begin(m, 156);
+            t.append(text.c_str(), end);
+        }
+    });
+    char name[24];
+    snprintf(name, sizeof(name), "%d-char pieces", piece);
+    printf("%-22s %10.1f %10u %10.1f %10.0fx\n", name, incremental * 1e9 / len, (unsigned)measured,
+           reflow * 1e9 / len, reflow / incremental);
+}
+
+// Speech through the whole reply, one frame per character
+static void benchFollow(const char* name, bool scrollable, const std::string& text) {
+    UiScene scene;
+    scene.begin(W, H);
+    VoltScreens screens(scene);
+    UiFramebuffer fb(W, H);
+    fb.setScrollable(scrollable);
+    UiRect band = screens.reply();
+    scene.flush(fb);
+
+    TextScroller scroller;
+    int len = (int)text.size();
+    uint32_t frames = 0, pixels = 0, worst = 0;
+    double s = timeIt([&] {
+        scroller.start(fb, band, VoltScreens::pageStyle(UI_BLACK), text.c_str());
+        frames = pixels = worst = 0;
+        for (int at = 0; at <= len; at++) {
+            uint32_t sent = scroller.follow(fb, at);
+            pixels += sent;
+            if (sent > worst) worst = sent;
+            frames++;
+        }
+    });
+    printf("%-22s %8u %10.0f %8u %10.1f\n", name, (unsigned)scroller.getScrolls(), (double)pixels / frames,
+           (unsigned)worst, s * 1e6 / frames);
+}
+
+int main() {
+    nativeHal().quiet = true;
+    std::string text = reply();
+    TextMetrics page, heading;
+    page.builtin(2);
+    heading.packed(FONT_HEADING);
+
+    printf("Layout, all at once (156 px lines)\n");
+    printf("%-22s %6s %6s %10s\n", "font", "chars", "lines", "ns/char");
+    benchWhole("built-in, size 2", page, text);
+    benchWhole("FONT_HEADING", heading, text);
+
+    printf("\nStreamed: append() vs reflow of everything so far\n");
+    printf("%-22s %10s %10s %10s %11s\n", "", "ns/char", "measured", "reflow", "");
+    benchPieces(1, page, text);
+    benchPieces(8, page, text);
+    benchPieces(64, page, text);
+
+    printf("\nFollowing speech on %dx%d, one frame per character\n", W, H);
+    printf("%-22s %8s %10s %8s %10s\n", "", "scrolls", "px/frame", "worst", "us/frame");
+    benchFollow("hardware scroll", true, text);
+    benchFollow("redraw", false, text);
+    return 0;
+}
@@ -0,0 +1,407 @@
+/*
+ * ============================================
+ * Text Layout and Scroller Tests (host)
+ * ============================================
+ *
+ * Runs text_layout.h, text_scroller.h and
+ * speech_text.h on the native HAL:
+ * - Word wrap: breaks at spaces, long words by
+ *   character, '\n', hanging spaces, packed
+ *   font advances, the limits
+ * - The same text appended in random pieces
+ *   lays out exactly as all at once, measuring
+ *   each character once and never changing a
+ *   line above the open one
+ * - The scroller on a framebuffer with the
+ *   ST7789's vertical scroll, against one
+ *   without (every step redrawn): the panel
+ *   shows the same pixels after every step,
+ *   for a fraction of what is sent
+ * - The line being said: highlighted and kept
+ *   in view; the heading above the band is
+ *   never touched
+ * - Speech progress from speech_text.h
+ *
+ * Built and run by CMakeLists.txt (ctest).
+ *
+ * ============================================
+ */
+
+#include "volt_hal.h"
+#include "text_layout.h"
+#include "text_scroller.h"
+#include "speech_text.h"
+#include "volt_screens.h"
+#include "ui_framebuffer.h"
+#include "test_check.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+static const int16_t W = 172;
+static const int16_t H = 320;
+
+static const char* REPLY =
+    "The sky looks blue because sunlight is made of every color, and the air scatters blue light "
+    "the most. So when you look up, blue light comes at you from all over the sky! At sunset the "
+    "light travels through more air, so the blue gets scattered away and you see orange and red.";
+
+static std::string lineText(const TextLayout& t, int i) {
+    const TextLine& l = t.getLine(i);
+    return std::string(t.getText() + l.start, l.len);
+}
+
+static TextMetrics builtin(uint8_t size) {
+    TextMetrics m;
+    m.builtin(size);
+    return m;
+}
+
+// ============================================
+// LAYOUT
+// ============================================
+
+static void testMetrics() {
+    TextMetrics m = builtin(2);
+    CHECK(m.advance('A') == 12 && m.advance(' ') == 12 && m.advance('~') == 12);
+    CHECK(m.advance((char)0xC3) == 12);     // UTF-8 bytes print as cells too
+    CHECK(m.height() == 16);
+
+    TextMetrics p;
+    p.packed(FONT_HEADING);
+    CHECK(p.advance('J') == uiFindGlyph(FONT_HEADING, 'J')->advance);
+    CHECK(p.advance('z') == 0);             // Not in the subset
+    CHECK(p.height() == FONT_HEADING.height);
+}
+
+static void testWrap() {
+    TextLayout t;
+    t.begin(builtin(1), 60);                 // 10 cells
+    t.append("the quick brown fox");
+    CHECK(t.getLineCount() == 2);
+    CHECK(lineText(t, 0) == "the quick" && lineText(t, 1) == "brown fox");
+    CHECK(t.getLine(0).width == 54);        // The space it broke at hangs
+
+    // Exactly full, then a space and a word
+    t.begin(builtin(1), 60);
+    t.append("abcdefghij klm");
+    CHECK(t.getLineCount() == 2 && lineText(t, 0) == "abcdefghij" && lineText(t, 1) == "klm");
+
+    // Wider than a line: broken by character
+    t.begin(builtin(1), 60);
+    t.append("hi abcdefghijklmnopqrstuvwxyz!");
+    CHECK(t.getLineCount() == 4);
+    CHECK(lineText(t, 0) == "hi" && lineText(t, 1) == "abcdefghij" && lineText(t, 2) == "klmnopqrst" &&
+          lineText(t, 3) == "uvwxyz!");
+
+    // '\n' always breaks; an empty line stays
+    t.begin(builtin(1), 60);
+    t.append("one\n\ntwo three four");
+    CHECK(t.getLineCount() == 4);
+    CHECK(lineText(t, 0) == "one" && lineText(t, 1) == "" && lineText(t, 2) == "two three" &&
+          lineText(t, 3) == "four");
+    CHECK(t.lineOf(3) == 0 && t.lineOf(4) == 1 && t.lineOf(5) == 2 && t.lineOf(14) == 2 && t.lineOf(15) == 3);
+    CHECK(t.lineOf(999) == t.getLineCount() - 1);
+
+    // Every line fits; together they hold every word in order
+    t.begin(builtin(2), 156);
+    t.append(REPLY);
+    bool fits = true;
+    std::string words;
+    for (int i = 0; i < t.getLineCount(); i++) {
+        fits &= t.getLine(i).width <= 156 && t.getLine(i).width == 12 * t.getLine(i).len;
+        words += lineText(t, i) + (i + 1 < t.getLineCount() ? " " : "");
+    }
+    CHECK(fits);
+    CHECK(words == REPLY);
+
+    // A packed font wraps by its advances
+    TextMetrics heading;
+    heading.packed(FONT_HEADING);
+    int16_t room = (int16_t)(uiTextWidth(FONT_HEADING, "Great Job! H", 12) - 1);
+    t.begin(heading, room);
+    t.append("Great Job! Hi Stone!");
+    CHECK(t.getLineCount() == 2);
+    CHECK(t.getLine(0).width == uiTextWidth(FONT_HEADING, "Great Job!", 10));
+    CHECK(lineText(t, 0) == "Great Job!" && lineText(t, 1) == "Hi Stone!");
+}
+
+static void testIncremental() {
+    srand(48);
+    const char* words[] = { "a", "sky", "blue", "scattering", "supercalifragilistic", "\n", "ok!", " " };
+    bool same = true, once = true, stable = true, first = true;
+    for (int round = 0; round < 200; round++) {
+        std::string text;
+        int n = 5 + rand() % 60;
+        for (int i = 0; i < n; i++) text += std::string(words[rand() % 8]) + (rand() % 4 ? " " : "");
+        int16_t width = (int16_t)(30 + rand() % 140);
+
+        TextLayout whole, pieces;
+        whole.begin(builtin(1), width);
+        whole.append(text.c_str());
+        pieces.begin(builtin(1), width);
+        for (size_t at = 0; at < text.size();) {
+            size_t len = 1 + rand() % 9;
+            if (at + len > text.size()) len = text.size() - at;
+            int before = pieces.getLineCount();
+            std::vector<std::string> kept;
+            for (int i = 0; i + 1 < before; i++) kept.push_back(lineText(pieces, i));
+            int changed = pieces.append(text.c_str() + at, (int)len);
+            first &= changed == before - 1;
+            for (int i = 0; i + 1 < before; i++) stable &= lineText(pieces, i) == kept[i];
+            at += len;
+        }
+        same &= whole.getLineCount() == pieces.getLineCount();
+        for (int i = 0; same && i < whole.getLineCount(); i++) {
+            same &= whole.getLine(i).start == pieces.getLine(i).start && whole.getLine(i).len == pieces.getLine(i).len &&
+                    whole.getLine(i).width == pieces.getLine(i).width;
+        }
+        once &= pieces.getMeasured() == text.size() && whole.getMeasured() == text.size();
+    }
+    CHECK(same);
+    CHECK(once);
+    CHECK(stable);
+    CHECK(first);
+}
+
+static void testLimits() {
+    TextLayout t;
+    t.begin(builtin(1), 160);
+    std::string big(TextLayout::MAX_CHARS + 100, 'x');
+    t.append(big.c_str());
+    CHECK(t.getLength() == TextLayout::MAX_CHARS);
+    CHECK(t.getDropped() == 100);
+
+    // Out of lines before out of characters
+    t.begin(builtin(1), 160);
+    std::string lines;
+    for (int i = 0; i < TextLayout::MAX_LINES + 10; i++) lines += "x\n";
+    t.append(lines.c_str());
+    CHECK(t.getLineCount() == TextLayout::MAX_LINES);
+    CHECK(t.getDropped() > 0);
+    CHECK(t.getLength() == (int)strlen(t.getText()));
+    int16_t before = (int16_t)t.getLength();
+    t.append("more");
+    CHECK(t.getLength() == before);
+}
+
+// ============================================
+// SCROLLER
+// ============================================
+
+// What the panel shows in rows [top, bottom) is the same on both
+static bool sameShown(const UiFramebuffer& a, const UiFramebuffer& b, int16_t top, int16_t bottom) {
+    for (int16_t y = top; y < bottom; y++) {
+        for (int16_t x = 0; x < W; x++) {
+            if (a.shown(x, y) != b.shown(x, y)) return false;
+        }
+    }
+    return true;
+}
+
+// A screen's heading, then the page: one panel scrolls, one can't
+struct Page {
+    UiScene scene;
+    VoltScreens screens;
+    UiFramebuffer fb;
+    TextScroller scroller;
+    UiRect band;
+
+    Page(bool scrollable) : screens(scene), fb(W, H) {
+        fb.setScrollable(scrollable);
+        scene.begin(W, H);
+        band = screens.reply();
+        scene.flush(fb);
+    }
+
+    void start(const char* text) { scroller.start(fb, band, VoltScreens::pageStyle(UI_BLACK), text); }
+};
+
+static void testScrollerMatchesRedraw() {
+    Page hw(true), redraw(false);
+    hw.start(REPLY);
+    redraw.start(REPLY);
+    CHECK(hw.scroller.isHardware() && !redraw.scroller.isHardware());
+    CHECK(sameShown(hw.fb, redraw.fb, 0, H));
+    std::vector<uint16_t> heading;
+    for (int16_t y = 0; y < hw.band.y; y++) {
+        for (int16_t x = 0; x < W; x++) heading.push_back(hw.fb.shown(x, y));
+    }
+
+    // Speech through the whole reply, a frame at a time
+    int len = (int)strlen(REPLY);
+    bool same = true, spokenShown = true;
+    uint32_t hwPx = 0, redrawPx = 0;
+    for (int frame = 0; frame < 1200; frame++) {
+        int at = frame * len / 900;
+        if (at > len) at = len;
+        hwPx += hw.scroller.follow(hw.fb, at);
+        redrawPx += redraw.scroller.follow(redraw.fb, at);
+        same &= sameShown(hw.fb, redraw.fb, hw.band.y, H);
+
+        // The line being said is on the panel, in yellow
+        int line = hw.scroller.getSpokenLine();
+        int32_t y = line * hw.scroller.getLineHeight() - hw.scroller.getTop();
+        spokenShown &= line == hw.scroller.getLayout().lineOf(at) && y >= 0 &&
+                       y + hw.scroller.getLineHeight() <= hw.band.h;
+    }
+    CHECK(same);
+    CHECK(spokenShown);
+    CHECK(hw.scroller.getTop() > 0);         // It did scroll
+    CHECK(hw.scroller.getTop() == hw.scroller.getLayout().getLineCount() * hw.scroller.getLineHeight() - hw.band.h);
+    CHECK(hw.scroller.getScrolls() == redraw.scroller.getScrolls());
+    // The panel scrolls: a row sent a row moved, plus highlights
+    CHECK(hwPx * 10 < redrawPx);
+    printf("  scrolled %d rows: %u px sent with hardware scroll, %u redrawn\n", (int)hw.scroller.getTop(),
+           (unsigned)hwPx, (unsigned)redrawPx);
+
+    // Yellow only on the last line once it's all said
+    int16_t lineH = hw.scroller.getLineHeight();
+    int last = hw.scroller.getSpokenLine();
+    int32_t lastY = hw.band.y + last * lineH - hw.scroller.getTop();
+    bool onlyThere = true, found = false;
+    for (int16_t y = hw.band.y; y < H; y++) {
+        for (int16_t x = 0; x < W; x++) {
+            bool yellow = hw.fb.shown(x, y) == UI_YELLOW;
+            found |= yellow;
+            onlyThere &= !yellow || (y >= lastY && y < lastY + lineH);
+        }
+    }
+    CHECK(found && onlyThere);
+
+    // The heading never moved or changed
+    size_t i = 0;
+    bool headingKept = true;
+    for (int16_t y = 0; y < hw.band.y; y++) {
+        for (int16_t x = 0; x < W; x++) headingKept &= hw.fb.shown(x, y) == heading[i++];
+    }
+    CHECK(headingKept);
+
+    // Stopping puts the rows back (the scene then repaints them)
+    hw.scroller.stop(hw.fb);
+    CHECK(!hw.scroller.isRunning() && hw.fb.getScrollOffset() == 0);
+    hw.scene.invalidate();
+    hw.screens.idle(true, 80);
+    hw.scene.flush(hw.fb);
+    UiScene fresh;
+    fresh.begin(W, H);
+    VoltScreens freshScreens(fresh);
+    UiFramebuffer expected(W, H);
+    freshScreens.idle(true, 80);
+    fresh.flush(expected);
+    CHECK(hw.fb.same(expected));
+}
+
+// A glide is a few rows a frame; a jump further than the band is
+// one step
+static void testFollowSteps() {
+    Page p(true);
+    p.start(REPLY);
+    int len = (int)strlen(REPLY);
+    p.scroller.follow(p.fb, len / 2);
+    CHECK(p.scroller.getTop() == TextScroller::STEP_ROWS);
+    uint32_t sent = p.scroller.follow(p.fb, len / 2);
+    CHECK(p.scroller.getTop() == 2 * TextScroller::STEP_ROWS);
+    CHECK(sent == (uint32_t)W * TextScroller::STEP_ROWS);    // Just the rows that came in
+
+    // Before any audio: no highlight, the top
+    Page q(true);
+    q.start(REPLY);
+    CHECK(q.scroller.follow(q.fb, -1) == 0);
+    CHECK(q.scroller.getSpokenLine() == -1 && q.scroller.getTop() == 0);
+
+    // Short text: never scrolls
+    Page s(true);
+    s.start("Why do bees hum? They forgot the words!");
+    for (int i = 0; i < 50; i++) s.scroller.follow(s.fb, 38);
+    CHECK(s.scroller.getTop() == 0 && s.scroller.getScrolls() == 0);
+}
+
+// Streamed text drawn as it comes looks the same as all of it
+// shown at once
+static void testStreamedText() {
+    srand(7);
+    Page streamed(true), whole(true);
+    streamed.start("");
+    int len = (int)strlen(REPLY);
+    uint32_t sent = 0;
+    for (int at = 0; at < len;) {
+        int n = 1 + rand() % 12;
+        if (at + n > len) n = len - at;
+        sent += streamed.scroller.append(streamed.fb, REPLY + at, n);
+        at += n;
+    }
+    whole.start(REPLY);
+    CHECK(sameShown(streamed.fb, whole.fb, 0, H));
+    CHECK(streamed.scroller.getLength() == len);
+
+    // ... also while following
+    for (int frame = 0; frame < 400; frame++) {
+        int at = frame * len / 300;
+        streamed.scroller.follow(streamed.fb, at > len ? len : at);
+        whole.scroller.follow(whole.fb, at > len ? len : at);
+    }
+    CHECK(sameShown(streamed.fb, whole.fb, 0, H));
+    CHECK(sent < (uint32_t)(len * W * streamed.scroller.getLineHeight()));
+}
+
+// ============================================
+// SPEECH TEXT
+// ============================================
+
+static void testSpeechText() {
+    SpeechText said;
+    uint32_t gen = said.getGeneration();
+    CHECK(!said.isActive() && said.spokenAt(1000) == -1);
+
+    said.begin(REPLY);
+    CHECK(said.isActive() && said.getGeneration() == gen + 1);
+    CHECK(said.startsLike(REPLY, (int)strlen(REPLY)));
+    CHECK(!said.startsLike("The sea", 7));
+    CHECK(said.spokenAt(1000) == -1);       // No audio yet
+
+    // The first piece (50 chars) plays from 1000 ms
+    said.playing(0, 50, 1000);
+    CHECK(said.spokenAt(1000) == 0);
+    CHECK(said.spokenAt(2000) == (int)SpeechText::CHARS_PER_SEC);
+    CHECK(said.spokenAt(60000) == 50);      // Never past the piece
+    said.playing(50, 120, 9000);
+    CHECK(said.spokenAt(9500) == 50 + (int)SpeechText::CHARS_PER_SEC / 2);
+    said.end();
+    CHECK(!said.isActive() && said.spokenAt(9500) == (int)strlen(REPLY));
+
+    // Streamed: copied as it grows, until the next line
+    said.begin();
+    gen = said.getGeneration();
+    said.append("Hello ", 6);
+    char out[64];
+    CHECK(said.copy(gen, 0, out, sizeof(out)) == 6);
+    said.append("there!", 6);
+    CHECK(said.copy(gen, 6, out, sizeof(out)) == 6 && memcmp(out, "there!", 6) == 0);
+    CHECK(said.copy(gen, 12, out, sizeof(out)) == 0);
+    said.playing(0, SpeechText::MAX_CHARS, 100);
+    CHECK(said.spokenAt(100000) == 12);     // Paced, but not past what came in
+    said.begin("Next");
+    CHECK(said.copy(gen, 0, out, sizeof(out)) == -1);
+
+    // Longer than fits
+    std::string big(SpeechText::MAX_CHARS + 10, 'y');
+    said.begin(big.c_str());
+    CHECK(said.getLength() == SpeechText::MAX_CHARS);
+}
+
+int main() {
+    nativeHal().quiet = true;
+    testMetrics();
+    testWrap();
+    testIncremental();
+    testLimits();
+    testScrollerMatchesRedraw();
+    testFollowSteps();
+    testStreamedText();
+    testSpeechText();
+
+    return testSummary();
+}
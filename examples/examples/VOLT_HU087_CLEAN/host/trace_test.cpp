@@ -0,0 +1,330 @@
+/*
+ * ============================================
+ * Turn Trace Tests (host)
+ * ============================================
+ *
+ * Runs volt_trace.h on the native HAL: span
+ * timing on a virtual clock, turn numbering,
+ * ring wrap-around, the JSON and Chrome trace
+ * exports, two "cores" (threads) recording
+ * while the trace is exported, and the cost of
+ * one span on the real clock.
+ *
+ * Built twice by CMakeLists.txt (ctest):
+ * trace_test as is, and trace_off_test with
+ * VOLT_TRACE=0, which checks the macros still
+ * compile and the exports come back empty.
+ *
+ * ============================================
+ */
+
+#include "volt_trace.h"
+#include "test_check.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Collects an export
+class Capture : public Print {
+public:
+    std::string text;
+
+    size_t write(uint8_t b) override {
+        text += (char)b;
+        return 1;
+    }
+
+    size_t write(const uint8_t* buf, size_t size) override {
+        text.append((const char*)buf, size);
+        return size;
+    }
+
+    bool has(const char* s) const { return text.find(s) != std::string::npos; }
+};
+
+// Brackets and braces pair up outside strings
+static bool balanced(const std::string& s) {
+    std::vector<char> open;
+    bool inString = false;
+    for (char c : s) {
+        if (inString) {
+            if (c == '"') inString = false;
+        } else if (c == '"') {
+            inString = true;
+        } else if (c == '{' || c == '[') {
+            open.push_back(c);
+        } else if (c == '}' || c == ']') {
+            if (open.empty() || open.back() != (c == '}' ? '{' : '[')) return false;
+            open.pop_back();
+        }
+    }
+    return open.empty() && !inString;
+}
+
+#if VOLT_TRACE
+
+static std::vector<VoltTrace::Span> collect() {
+    std::vector<VoltTrace::Span> spans;
+    voltTrace().forEach([&](const VoltTrace::Span& s) { spans.push_back(s); });
+    return spans;
+}
+
+// ============================================
+// RECORDING
+// ============================================
+
+static void testSpans() {
+    resetHal();
+    voltTrace().clear();
+    halDelay(1000);
+
+    CHECK(TRACE_TURN() == 1);
+    {
+        TRACE_SCOPE(TRACE_RECORD);
+        halDelay(5);
+    }
+    TRACE_DECLARE(playback, TRACE_PLAYBACK);
+    TRACE_STOP(playback);          // Never started: nothing recorded
+    halDelay(2);
+    TRACE_INSTANT(TRACE_TTS_FIRST_BYTE);
+    TRACE_START(playback);
+    halDelay(30);
+    TRACE_STOP(playback);
+    TRACE_STOP(playback);          // Already stopped
+
+    std::vector<VoltTrace::Span> spans = collect();
+    CHECK(spans.size() == 3);
+    if (spans.size() == 3) {
+        CHECK(spans[0].stage == TRACE_RECORD);
+        CHECK(spans[0].startUs == 1000000);
+        CHECK(spans[0].durUs == 5000);
+        CHECK(!spans[0].instant);
+        CHECK(spans[1].stage == TRACE_TTS_FIRST_BYTE);
+        CHECK(spans[1].instant);
+        CHECK(spans[1].startUs == 1007000);
+        CHECK(spans[2].stage == TRACE_PLAYBACK);
+        CHECK(spans[2].startUs == 1007000);
+        CHECK(spans[2].durUs == 30000);
+        for (const VoltTrace::Span& s : spans) {
+            CHECK(s.turn == 1);
+            CHECK(s.core == 0);
+        }
+    }
+
+    CHECK(TRACE_TURN() == 2);
+    {
+        TRACE_SCOPE(TRACE_UPLOAD);
+    }
+    spans = collect();
+    CHECK(spans.size() == 4 && spans.back().turn == 2 && spans.back().durUs == 0);
+}
+
+static void testRestart() {
+    resetHal();
+    voltTrace().clear();
+
+    // START again before STOP measures from the latest start
+    TRACE_DECLARE(upload, TRACE_UPLOAD);
+    TRACE_START(upload);
+    halDelay(100);
+    TRACE_START(upload);
+    halDelay(10);
+    TRACE_STOP(upload);
+
+    std::vector<VoltTrace::Span> spans = collect();
+    CHECK(spans.size() == 1 && spans[0].durUs == 10000);
+}
+
+static void testWrap() {
+    resetHal();
+    voltTrace().clear();
+
+    uint32_t total = VoltTrace::SPANS_PER_CORE * 2 + 44;
+    for (uint32_t i = 0; i < total; i++) {
+        voltTrace().record(TRACE_ENCODE, i, 1);
+    }
+    CHECK(voltTrace().written(0) == total);
+    CHECK(voltTrace().written(1) == 0);
+
+    std::vector<VoltTrace::Span> spans = collect();
+    CHECK(spans.size() == VoltTrace::SPANS_PER_CORE);
+    bool inOrder = true;
+    for (size_t i = 0; i < spans.size(); i++) {
+        if (spans[i].startUs != total - VoltTrace::SPANS_PER_CORE + i) inOrder = false;
+    }
+    CHECK(inOrder);
+}
+
+// ============================================
+// EXPORT
+// ============================================
+
+static void recordSampleTurn() {
+    resetHal();
+    voltTrace().clear();
+    halDelay(1);
+    TRACE_TURN();
+    {
+        TRACE_SCOPE(TRACE_CONNECT);
+        halDelay(40);
+    }
+    TRACE_INSTANT(TRACE_TTS_FIRST_BYTE);
+}
+
+static void testJson() {
+    recordSampleTurn();
+    Capture out;
+    traceWriteJson(out);
+
+    CHECK(balanced(out.text));
+    CHECK(out.has("{\"turn\":1,\"now_us\":41000,\"spans\":["));
+    CHECK(out.has("{\"stage\":\"connect\",\"turn\":1,\"core\":0,\"start_us\":1000,\"dur_us\":40000}"));
+    CHECK(out.has("{\"stage\":\"tts_first_byte\",\"turn\":1,\"core\":0,\"start_us\":41000}"));
+}
+
+static void testChrome() {
+    recordSampleTurn();
+    Capture out;
+    traceWriteChrome(out);
+
+    CHECK(balanced(out.text));
+    CHECK(out.text.rfind("{\"displayTimeUnit\"", 0) == 0);
+    CHECK(out.has("\"traceEvents\":["));
+    CHECK(out.has("\"args\":{\"name\":\"core 1\"}"));
+    CHECK(out.has("{\"name\":\"connect\",\"cat\":\"turn\",\"ph\":\"X\",\"ts\":1000,\"dur\":40000,"
+                  "\"pid\":1,\"tid\":0,\"args\":{\"turn\":1}}"));
+    CHECK(out.has("{\"name\":\"tts_first_byte\",\"cat\":\"turn\",\"ph\":\"i\",\"ts\":41000,\"s\":\"t\","));
+
+    // Nothing recorded: still a valid (empty) trace
+    voltTrace().clear();
+    Capture empty;
+    traceWriteChrome(empty);
+    CHECK(balanced(empty.text));
+    CHECK(!empty.has("\"ph\":\"X\""));
+}
+
+// ============================================
+// CONCURRENCY AND COST
+// ============================================
+
+// Each writer stores startUs = n and durUs = 3n, so a span torn
+// by a concurrent overwrite shows up as a mismatch
+static void testTwoCores() {
+    resetHal();
+    voltTrace().clear();
+    const uint32_t perCore = 50000;
+
+    std::vector<std::thread> writers;
+    for (int core = 0; core < 2; core++) {
+        writers.emplace_back([core, perCore]() {
+            nativeCoreId() = core;
+            for (uint32_t n = 1; n <= perCore; n++) {
+                voltTrace().record(core ? TRACE_PLAYBACK : TRACE_UPLOAD, n, n * 3);
+            }
+        });
+    }
+
+    int exports = 0;
+    int torn = 0;
+    int wrongCore = 0;
+    do {
+        voltTrace().forEach([&](const VoltTrace::Span& s) {
+            if (s.durUs != s.startUs * 3) torn++;
+            if ((s.core == 0) != (s.stage == TRACE_UPLOAD)) wrongCore++;
+        });
+        Capture out;
+        traceWriteChrome(out);
+        if (!balanced(out.text)) torn++;
+        exports++;
+    } while (voltTrace().written(0) < perCore || voltTrace().written(1) < perCore);
+    for (std::thread& t : writers) {
+        t.join();
+    }
+
+    CHECK(torn == 0);
+    CHECK(wrongCore == 0);
+    CHECK(exports > 0);
+    CHECK(voltTrace().written(0) == perCore);
+    CHECK(voltTrace().written(1) == perCore);
+    std::vector<VoltTrace::Span> spans = collect();
+    CHECK(spans.size() == VoltTrace::SPANS_PER_CORE * 2);
+    CHECK(spans.back().startUs == perCore && spans.back().core == 1);
+}
+
+static void testCost() {
+    resetHal();
+    nativeClock().setVirtual(false);
+    voltTrace().clear();
+    const int batches = 100;
+    const int spans = 2000;
+
+    // The fastest batch: a loaded machine (ctest -j) preempts some
+    double ns = 1e9;
+    for (int b = 0; b < batches; b++) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < spans; i++) {
+            TRACE_SCOPE(TRACE_ENCODE);
+        }
+        auto end = std::chrono::steady_clock::now();
+        ns = std::min(ns, std::chrono::duration<double, std::nano>(end - start).count() / spans);
+    }
+    printf("trace: %.0f ns per span (two clock reads + ring write)\n", ns);
+
+    // Generous so sanitizer builds pass; the watch target is < 1 us
+    CHECK(ns < 1000);
+    CHECK(voltTrace().written(0) == (uint32_t)(batches * spans));
+}
+
+int main() {
+    testSpans();
+    testRestart();
+    testWrap();
+    testJson();
+    testChrome();
+    testTwoCores();
+    testCost();
+
+    return testSummary();
+}
+
+#else
+
+// ============================================
+// VOLT_TRACE=0
+// ============================================
+
+static void testCompiledOut() {
+    resetHal();
+    int sideEffects = 0;
+    TRACE_TURN();
+    {
+        TRACE_SCOPE(TRACE_RECORD);
+        sideEffects++;
+    }
+    TRACE_DECLARE(playback, TRACE_PLAYBACK);
+    TRACE_START(playback);
+    TRACE_INSTANT(TRACE_TTS_FIRST_BYTE);
+    TRACE_STOP(playback);
+    CHECK(sideEffects == 1);
+
+    Capture json;
+    traceWriteJson(json);
+    CHECK(balanced(json.text));
+    CHECK(json.has("\"spans\":[]"));
+
+    Capture chrome;
+    traceWriteChrome(chrome);
+    CHECK(balanced(chrome.text));
+    CHECK(chrome.has("\"traceEvents\":[]"));
+}
+
+int main() {
+    testCompiledOut();
+
+    return testSummary();
+}
+
+#endif // VOLT_TRACE
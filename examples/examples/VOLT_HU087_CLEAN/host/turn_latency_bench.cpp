@@ -0,0 +1,296 @@
+/*
+ * ============================================
+ * Conversation Latency Benchmark (host)
+ * ============================================
+ *
+ * Drives the talkToVolt() flow of
+ * volt_stone_FINAL.ino on the native HAL
+ * against the local stand-in server
+ * (h2_bench_server.py), one turn per WAV file
+ * in the corpus:
+ *
+ *   button   release -> talkToVolt() starts
+ *            (ButtonInput multi-press wait)
+ *   record   bot.recordAudio() (WAV as the mic)
+ *   stt      bot.transcribe()
+ *   chat     bot.chat()
+ *   tts      bot.speak() call -> first sample
+ *            reaches the speaker
+ *   total    release -> first audio, the
+ *            number the user feels
+ *
+ * Reports p50/p95/p99 per stage. --json prints
+ * one JSON object instead of the table, and
+ * --max-p95 STAGE=MS makes the exit status fail
+ * when a stage regresses past its budget.
+ *
+ * Recording takes no time unless --pace-mic is
+ * given (on the watch it is a fixed
+ * RECORD_TIME_SEC, so it rarely changes), and
+ * the reply isn't played out in real time
+ * unless --pace-speaker is given (speaker
+ * underruns are only counted then).
+ *
+ * Build (needs ArduinoJson, see CMakeLists.txt)
+ * and run (from this directory):
+ *   cmake -S . -B build && cmake --build build
+ *   python3 h2_bench_server.py --stt-ms 500 --chat-ms 700 --jitter-ms 200 --tts-speed 20 &
+ *   ./build/turn_latency_bench --corpus corpus/ --turns 20
+ *
+ * ============================================
+ */
+
+#include "volt_ai_FINAL.h"
+#include "button_input.h"
+
+#include <dirent.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+enum Stage { STAGE_BUTTON, STAGE_RECORD, STAGE_STT, STAGE_CHAT, STAGE_TTS, STAGE_TOTAL, STAGE_COUNT };
+
+static const char* STAGE_NAMES[STAGE_COUNT] = { "button", "record", "stt", "chat", "tts", "total" };
+
+struct TurnTiming {
+    double ms[STAGE_COUNT];
+    bool ok;
+    uint32_t underruns;
+};
+
+static double nowMs() {
+    return nativeClock().nowUs() / 1000.0;
+}
+
+// ============================================
+// CORPUS
+// ============================================
+
+static bool endsWith(const std::string& s, const char* suffix) {
+    size_t n = strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+// Files as given; directories expand to their .wav files (sorted)
+static void addCorpus(const char* path, std::vector<std::string>& files) {
+    DIR* dir = opendir(path);
+    if (!dir) {
+        files.push_back(path);
+        return;
+    }
+    std::vector<std::string> found;
+    while (struct dirent* e = readdir(dir)) {
+        std::string name = e->d_name;
+        if (endsWith(name, ".wav") || endsWith(name, ".WAV")) {
+            found.push_back(std::string(path) + "/" + name);
+        }
+    }
+    closedir(dir);
+    std::sort(found.begin(), found.end());
+    files.insert(files.end(), found.begin(), found.end());
+}
+
+// No corpus: one second of a 440 Hz tone
+static void useToneMic() {
+    std::vector<int16_t> tone(SAMPLE_RATE);
+    for (size_t i = 0; i < tone.size(); i++) {
+        tone[i] = (int16_t)(8000 * ((i * 440 * 2 / SAMPLE_RATE) % 2 ? 1 : -1));
+    }
+    nativeHal().setMicPcm(tone.data(), tone.size() * 2, SAMPLE_RATE);
+}
+
+// ============================================
+// ONE TURN
+// ============================================
+
+// Press and release the button, then run loop()'s
+// button handling until the pattern fires
+static double waitForPattern(ButtonInput& button) {
+    halDigitalWrite(BTN_BOOT, LOW);
+    for (int i = 0; i < 10; i++) {
+        button.update(halDigitalRead(BTN_BOOT) == LOW, halMillis());
+        halDelay(10);
+    }
+    halDigitalWrite(BTN_BOOT, HIGH);
+    double release = nowMs();
+    while (button.update(halDigitalRead(BTN_BOOT) == LOW, halMillis()) != BUTTON_PRESSES) {
+        halDelay(10);   // loop()'s delay(10)
+    }
+    return release;
+}
+
+// Same calls, in the same order, as talkToVolt()
+static TurnTiming runTurn(VoltAI& bot, ButtonInput& button) {
+    TurnTiming t;
+    memset(&t, 0, sizeof(t));
+    uint32_t underrunsBefore = nativeHal().speaker.underruns;
+    nativeHal().speaker.firstWriteUs = 0;
+
+    double release = waitForPattern(button);
+    double mark = nowMs();
+    t.ms[STAGE_BUTTON] = mark - release;
+
+    bot.recordAudio();
+    t.ms[STAGE_RECORD] = nowMs() - mark;
+    mark = nowMs();
+
+    const char* userText = bot.transcribe();
+    t.ms[STAGE_STT] = nowMs() - mark;
+    mark = nowMs();
+
+    const char* response = "";
+    if (userText[0] != '\0') {
+        response = bot.chat(userText);
+    }
+    t.ms[STAGE_CHAT] = nowMs() - mark;
+    mark = nowMs();
+
+    if (response[0] != '\0') {
+        bot.speak(response);
+    }
+    uint64_t firstUs = nativeHal().speaker.firstWriteUs;
+    t.ok = firstUs != 0;
+    if (t.ok) {
+        double first = (firstUs - 1) / 1000.0;
+        t.ms[STAGE_TTS] = first - mark;
+        t.ms[STAGE_TOTAL] = first - release;
+    }
+    t.underruns = nativeHal().speaker.underruns - underrunsBefore;
+
+    bot.endTurn();
+    return t;
+}
+
+// ============================================
+// REPORT
+// ============================================
+
+static double percentile(std::vector<double> v, double p) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    size_t i = (size_t)(p * (v.size() - 1) + 0.5);
+    return v[i];
+}
+
+struct Budget {
+    int stage;
+    double p95Ms;
+};
+
+static bool parseBudget(const char* arg, Budget& budget) {
+    const char* eq = strchr(arg, '=');
+    if (!eq) return false;
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        if ((size_t)(eq - arg) == strlen(STAGE_NAMES[s]) && strncmp(arg, STAGE_NAMES[s], eq - arg) == 0) {
+            budget.stage = s;
+            budget.p95Ms = atof(eq + 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+int main(int argc, char** argv) {
+    int turns = 0;
+    const char* host = "127.0.0.1";
+    uint16_t port = 8090;
+    bool json = false;
+    bool paceSpeaker = false;
+    std::vector<std::string> corpus;
+    std::vector<Budget> budgets;
+
+    for (int i = 1; i < argc; i++) {
+        Budget budget;
+        if (!strcmp(argv[i], "--turns") && i + 1 < argc) turns = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--host") && i + 1 < argc) host = argv[++i];
+        else if (!strcmp(argv[i], "--port") && i + 1 < argc) port = (uint16_t)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--corpus") && i + 1 < argc) addCorpus(argv[++i], corpus);
+        else if (!strcmp(argv[i], "--pace-mic")) nativeHal().paceMic = true;
+        else if (!strcmp(argv[i], "--pace-speaker")) paceSpeaker = true;
+        else if (!strcmp(argv[i], "--json")) json = true;
+        else if (!strcmp(argv[i], "--max-p95") && i + 1 < argc && parseBudget(argv[i + 1], budget)) {
+            budgets.push_back(budget);
+            i++;
+        } else {
+            printf("usage: %s [--corpus DIR|WAV]... [--turns N] [--host H] [--port P]\n"
+                   "          [--pace-mic] [--pace-speaker] [--json] [--max-p95 STAGE=MS]...\n"
+                   "stages: button record stt chat tts total\n", argv[0]);
+            return 1;
+        }
+    }
+    if (turns <= 0) {
+        turns = corpus.empty() ? 5 : (int)corpus.size();
+    }
+
+    nativeHal().quiet = true;
+    nativeHal().paceSpeaker = paceSpeaker;
+    nativeClock().setVirtual(false);
+    nativeRoutes().add("api.openai.com", 443, host, port, false);
+
+    // Reserve the pools up front so begin() doesn't print its report into --json
+    memPools().begin(VOLT_POOL_LAYOUT, sizeof(VOLT_POOL_LAYOUT) / sizeof(VOLT_POOL_LAYOUT[0]));
+
+    VoltAI bot;
+    ButtonInput button;
+    if (!bot.begin("sk-bench-0123456789", STONE_PERSONALITY)) {
+        printf("AI engine failed to start\n");
+        return 1;
+    }
+    halDelay(1000);   // setup() takes longer than the debounce window
+
+    std::vector<double> samples[STAGE_COUNT];
+    int failures = 0;
+    uint32_t underruns = 0;
+    for (int t = 0; t < turns; t++) {
+        if (corpus.empty()) {
+            useToneMic();
+        } else if (!nativeHal().setMicWav(corpus[t % corpus.size()].c_str())) {
+            printf("Cannot use %s (16-bit mono WAV)\n", corpus[t % corpus.size()].c_str());
+            return 1;
+        }
+
+        TurnTiming timing = runTurn(bot, button);
+        underruns += timing.underruns;
+        if (!timing.ok) {
+            failures++;
+            continue;
+        }
+        for (int s = 0; s < STAGE_COUNT; s++) {
+            samples[s].push_back(timing.ms[s]);
+        }
+    }
+
+    bool withinBudget = true;
+    for (const Budget& b : budgets) {
+        if (samples[b.stage].empty() || percentile(samples[b.stage], 0.95) > b.p95Ms) {
+            withinBudget = false;
+        }
+    }
+
+    if (json) {
+        printf("{\"turns\":%d,\"ok\":%d,\"failures\":%d,\"underruns\":%u,\"stages\":{",
+            turns, turns - failures, failures, (unsigned)underruns);
+        for (int s = 0; s < STAGE_COUNT; s++) {
+            printf("%s\"%s\":{\"p50\":%.1f,\"p95\":%.1f,\"p99\":%.1f,\"max\":%.1f}",
+                s ? "," : "", STAGE_NAMES[s],
+                percentile(samples[s], 0.5), percentile(samples[s], 0.95),
+                percentile(samples[s], 0.99), percentile(samples[s], 1.0));
+        }
+        printf("},\"within_budget\":%s}\n", withinBudget ? "true" : "false");
+    } else {
+        printf("%-8s %9s %9s %9s %9s\n", "stage", "p50 ms", "p95 ms", "p99 ms", "max ms");
+        for (int s = 0; s < STAGE_COUNT; s++) {
+            printf("%-8s %9.0f %9.0f %9.0f %9.0f\n", STAGE_NAMES[s],
+                percentile(samples[s], 0.5), percentile(samples[s], 0.95),
+                percentile(samples[s], 0.99), percentile(samples[s], 1.0));
+        }
+        printf("%d turns, %d failed, %u speaker underruns\n", turns, failures, (unsigned)underruns);
+        for (const Budget& b : budgets) {
+            double p95 = percentile(samples[b.stage], 0.95);
+            printf("budget %s p95 <= %.0f ms: %s (%.0f ms)\n", STAGE_NAMES[b.stage], b.p95Ms,
+                !samples[b.stage].empty() && p95 <= b.p95Ms ? "ok" : "FAIL", p95);
+        }
+    }
+
+    return (failures == 0 && withinBudget) ? 0 : 2;
+}
@@ -0,0 +1,516 @@
+#!/usr/bin/env python3
+"""
+VOLT AI Watch - UI Asset Packer
+Turns the icons (PNG) and font subsets (BDF) listed in a manifest into
+ui_assets_data.h: constexpr tables that stay in flash and are decoded
+by ui_assets.h while a region is drawn, row by row, with no decoded
+copy of an image anywhere.
+
+  cd examples/examples/VOLT_HU087_CLEAN
+  python3 host/ui_assets.py assets/manifest.txt ui_assets_data.h
+  python3 host/ui_assets.py --check assets/manifest.txt ui_assets_data.h
+
+Manifest lines (paths relative to the manifest, '#' comments):
+
+  image ICON_WIFI   icons/wifi.png
+  font  FONT_TITLE  fonts/dejavu_sans_bold_40.bdf  "VOLT"
+
+Images: PNG, 8-bit gray, RGB, palette (1-8 bit) or with alpha; not
+interlaced. A pixel is transparent below half alpha; the rest become
+RGB565, at most 15 colors an image. Fonts: BDF, only the characters
+given (the subset), trimmed to their ink.
+
+Images are stored as runs of one palette index (0 is transparent):
+
+  byte  high nibble: index, low nibble: length - 1
+        low nibble 15: the next byte adds 0-255 (runs up to 271)
+
+Every row starts on a byte, and for images taller than ROW_STEP the
+offset of every ROW_STEP-th row is kept, so a tile that starts
+halfway down an image does not decode the rows above it.
+
+Glyphs have two colors and are small, so they are stored as pairs of
+runs through the whole glyph, row after row:
+
+  byte  high nibble: transparent pixels, low nibble: ink pixels
+
+Prints each asset's flash bytes (runs, palette and row index, or
+glyph table) against uncompressed (RGB565 for images, 1 bit a pixel
+for fonts). --check only compares with the existing header and fails
+if it is stale.
+
+Standard library only.
+"""
+
+import argparse
+import os
+import shlex
+import struct
+import sys
+import zlib
+
+ROW_STEP = 8             # UI_IMAGE_ROW_STEP in ui_assets.h
+MAX_COLORS = 15          # Index 0 is transparent
+MAX_RUN = 16 + 255
+GLYPH_BYTES = 8          # sizeof(UiGlyph)
+
+
+class AssetError(Exception):
+    pass
+
+
+# ============================================
+# PNG
+# ============================================
+
+def _paeth(a, b, c):
+    p = a + b - c
+    pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+    if pa <= pb and pa <= pc:
+        return a
+    return b if pb <= pc else c
+
+
+def read_png(data):
+    """Pixels of a PNG as rows of (r, g, b, a)."""
+    if data[:8] != b"\x89PNG\r\n\x1a\n":
+        raise AssetError("not a PNG file")
+    pos = 8
+    idat = b""
+    palette, trns = [], None
+    header = None
+    while pos < len(data):
+        length, kind = struct.unpack_from(">I4s", data, pos)
+        body = data[pos + 8:pos + 8 + length]
+        pos += 12 + length
+        if kind == b"IHDR":
+            header = struct.unpack(">IIBBBBB", body)
+        elif kind == b"PLTE":
+            palette = [tuple(body[i:i + 3]) for i in range(0, len(body), 3)]
+        elif kind == b"tRNS":
+            trns = body
+        elif kind == b"IDAT":
+            idat += body
+        elif kind == b"IEND":
+            break
+    if header is None:
+        raise AssetError("PNG without IHDR")
+    w, h, depth, color, _, _, interlace = header
+    if interlace:
+        raise AssetError("interlaced PNG")
+    channels = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}.get(color)
+    if channels is None:
+        raise AssetError("PNG color type %d" % color)
+    if depth != 8 and not (color in (0, 3) and depth in (1, 2, 4)):
+        raise AssetError("PNG bit depth %d with color type %d" % (depth, color))
+
+    raw = zlib.decompress(idat)
+    stride = (w * channels * depth + 7) // 8
+    bpp = max(1, channels * depth // 8)
+    rows, prev = [], bytearray(stride)
+    for y in range(h):
+        base = y * (stride + 1)
+        kind, line = raw[base], bytearray(raw[base + 1:base + 1 + stride])
+        for i in range(stride):
+            a = line[i - bpp] if i >= bpp else 0
+            b, c = prev[i], prev[i - bpp] if i >= bpp else 0
+            if kind == 1:
+                line[i] = (line[i] + a) & 0xFF
+            elif kind == 2:
+                line[i] = (line[i] + b) & 0xFF
+            elif kind == 3:
+                line[i] = (line[i] + (a + b) // 2) & 0xFF
+            elif kind == 4:
+                line[i] = (line[i] + _paeth(a, b, c)) & 0xFF
+            elif kind != 0:
+                raise AssetError("PNG filter %d" % kind)
+        rows.append(line)
+        prev = line
+
+    pixels = []
+    for line in rows:
+        if depth < 8:
+            per = 8 // depth
+            values = [(line[x // per] >> (8 - depth * (x % per + 1))) & ((1 << depth) - 1) for x in range(w)]
+        else:
+            values = None
+        out = []
+        for x in range(w):
+            if color == 3:
+                i = values[x] if values else line[x]
+                if i >= len(palette):
+                    raise AssetError("PNG palette index %d out of range" % i)
+                alpha = trns[i] if trns is not None and i < len(trns) else 255
+                out.append(palette[i] + (alpha,))
+            elif color == 0:
+                level = values[x] if values else line[x]
+                v = level * 255 // ((1 << depth) - 1)
+                key = struct.unpack(">H", trns)[0] if trns else None
+                out.append((v, v, v, 0 if level == key else 255))
+            elif color == 4:
+                out.append((line[2 * x], line[2 * x], line[2 * x], line[2 * x + 1]))
+            elif color == 2:
+                rgb = tuple(line[3 * x:3 * x + 3])
+                key = struct.unpack(">HHH", trns) if trns else None
+                out.append(rgb + (0 if key is not None and rgb == key else 255,))
+            else:
+                out.append(tuple(line[4 * x:4 * x + 4]))
+        pixels.append(out)
+    return w, h, pixels
+
+
+def rgb565(r, g, b):
+    return ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3)
+
+
+# ============================================
+# BDF
+# ============================================
+
+def read_bdf(text):
+    """Glyphs of a BDF font: {code: (advance, w, h, xoff, yoff, rows of 0/1)}, ascent, descent."""
+    glyphs = {}
+    ascent = descent = None
+    lines = iter(text.splitlines())
+    for line in lines:
+        words = line.split()
+        if not words:
+            continue
+        if words[0] == "FONT_ASCENT":
+            ascent = int(words[1])
+        elif words[0] == "FONT_DESCENT":
+            descent = int(words[1])
+        elif words[0] == "STARTCHAR":
+            code = advance = bbx = None
+            bits = []
+            for line in lines:
+                words = line.split()
+                if not words:
+                    continue
+                if words[0] == "ENCODING":
+                    code = int(words[1])
+                elif words[0] == "DWIDTH":
+                    advance = int(words[1])
+                elif words[0] == "BBX":
+                    bbx = [int(v) for v in words[1:5]]
+                elif words[0] == "BITMAP":
+                    for line in lines:
+                        if line.strip() == "ENDCHAR":
+                            break
+                        value, width = int(line.strip(), 16), len(line.strip()) * 4
+                        bits.append([(value >> (width - 1 - x)) & 1 for x in range(bbx[0])])
+                    break
+            if code is None or advance is None or bbx is None:
+                raise AssetError("BDF glyph without ENCODING, DWIDTH or BBX")
+            glyphs[code] = (advance, bbx[0], bbx[1], bbx[2], bbx[3], bits)
+    if ascent is None or descent is None:
+        raise AssetError("BDF without FONT_ASCENT / FONT_DESCENT")
+    return glyphs, ascent, descent
+
+
+# ============================================
+# RUNS
+# ============================================
+
+def encode_runs(rows):
+    """Rows of palette indices as runs; also where each row starts."""
+    data, starts = bytearray(), []
+    for row in rows:
+        starts.append(len(data))
+        x = 0
+        while x < len(row):
+            index, n = row[x], 1
+            while x + n < len(row) and row[x + n] == index:
+                n += 1
+            x += n
+            while n > 0:
+                take = min(n, MAX_RUN)
+                if take >= 16:
+                    data += bytes(((index << 4) | 15, take - 16))
+                else:
+                    data.append((index << 4) | (take - 1))
+                n -= take
+    return bytes(data), starts
+
+
+def decode_runs(data, w, h):
+    """encode_runs() backwards (what ui_assets.h does), for checking."""
+    rows, pos = [], 0
+    for _ in range(h):
+        row = []
+        while len(row) < w:
+            b = data[pos]
+            pos += 1
+            n = (b & 15) + 1
+            if b & 15 == 15:
+                n += data[pos]
+                pos += 1
+            row += [b >> 4] * n
+        if len(row) != w:
+            raise AssetError("run crosses the end of a row")
+        rows.append(row)
+    return rows
+
+
+def encode_pairs(rows):
+    """0/1 rows as (transparent, ink) run pairs, across rows."""
+    runs, current, n = [], 0, 0
+    for row in rows:
+        for bit in row:
+            if bit == current:
+                n += 1
+            else:
+                runs.append(n)
+                current, n = bit, 1
+    runs.append(n)
+    if len(runs) % 2:
+        runs.append(0)
+    data = bytearray()
+    for i in range(0, len(runs), 2):
+        clear, ink = runs[i], runs[i + 1]
+        while clear > 15:
+            data.append(0xF0)
+            clear -= 15
+        while ink > 15:
+            data.append((clear << 4) | 15)
+            clear, ink = 0, ink - 15
+        data.append((clear << 4) | ink)
+    return bytes(data)
+
+
+def decode_pairs(data, w, h):
+    """encode_pairs() backwards, for checking."""
+    flat = []
+    for b in data:
+        flat += [0] * (b >> 4) + [1] * (b & 15)
+    if len(flat) != w * h:
+        raise AssetError("glyph runs cover %d pixels, not %d" % (len(flat), w * h))
+    return [flat[y * w:(y + 1) * w] for y in range(h)]
+
+
+class Image:
+    def __init__(self, name, w, h, pixels):
+        self.name, self.w, self.h = name, w, h
+        self.palette = [0]
+        lookup = {}
+        rows = []
+        for line in pixels:
+            row = []
+            for r, g, b, a in line:
+                if a < 128:
+                    row.append(0)
+                    continue
+                c = rgb565(r, g, b)
+                if c not in lookup:
+                    if len(self.palette) > MAX_COLORS:
+                        raise AssetError("%s: more than %d colors" % (name, MAX_COLORS))
+                    lookup[c] = len(self.palette)
+                    self.palette.append(c)
+                row.append(lookup[c])
+            rows.append(row)
+        self.data, starts = encode_runs(rows)
+        self.rows = starts[::ROW_STEP] if h > ROW_STEP else []
+        if len(self.data) > 0xFFFF:
+            raise AssetError("%s: %d bytes of runs, at most 65535" % (name, len(self.data)))
+        assert decode_runs(self.data, w, h) == rows
+
+    def flash(self):
+        return len(self.data) + 2 * len(self.palette) + 2 * len(self.rows)
+
+    def raw(self):
+        return self.w * self.h * 2
+
+    def describe(self):
+        colors = len(self.palette) - 1
+        return "%dx%d, %d color%s" % (self.w, self.h, colors, "" if colors == 1 else "s")
+
+    def emit(self):
+        n = self.name
+        out = ["// %s: %s, %d bytes (%d as RGB565)" % (n, self.describe(), self.flash(), self.raw())]
+        out.append("static constexpr uint16_t %s_PALETTE[] = { %s };" % (
+            n, ", ".join("0x%04X" % c for c in self.palette)))
+        out += c_bytes("%s_DATA" % n, self.data)
+        rows = "nullptr"
+        if self.rows:
+            out.append("static constexpr uint16_t %s_ROWS[] = { %s };" % (n, ", ".join(str(r) for r in self.rows)))
+            rows = "%s_ROWS" % n
+        out.append("static constexpr UiImage %s = { %d, %d, %s_PALETTE, %s_DATA, %s, sizeof(%s_DATA) };" % (
+            n, self.w, self.h, n, n, rows, n))
+        return out
+
+
+class Font:
+    def __init__(self, name, glyphs, ascent, descent, chars):
+        self.name, self.ascent, self.height = name, ascent, ascent + descent
+        self.chars = "".join(sorted(set(chars)))
+        if not self.chars:
+            raise AssetError("%s: no characters" % name)
+        self.glyphs = []
+        data = bytearray()
+        self.bits = 0
+        for ch in self.chars:
+            if ord(ch) not in glyphs:
+                raise AssetError("%s: %r is not in the font" % (name, ch))
+            advance, w, h, xoff, yoff, bits = glyphs[ord(ch)]
+            top = ascent - (yoff + h)
+            # Trim to the ink
+            while bits and not any(bits[0]):
+                bits, top, h = bits[1:], top + 1, h - 1
+            while bits and not any(bits[-1]):
+                bits, h = bits[:-1], h - 1
+            while bits and not any(r[0] for r in bits):
+                bits, xoff, w = [r[1:] for r in bits], xoff + 1, w - 1
+            while bits and not any(r[-1] for r in bits):
+                bits, w = [r[:-1] for r in bits], w - 1
+            if not bits:
+                w = h = xoff = top = 0
+            if top < 0 or top + h > self.height or not -128 <= xoff < 128 or w > 255 or advance > 255:
+                raise AssetError("%s: %r does not fit its line" % (name, ch))
+            runs = encode_pairs(bits)
+            assert decode_pairs(runs, w, h) == bits
+            self.glyphs.append((len(data), w, h, xoff, top, advance))
+            data += runs
+            self.bits += (w + 7) // 8 * h
+        self.data = bytes(data)
+        if len(self.data) > 0xFFFF:
+            raise AssetError("%s: %d bytes of runs, at most 65535" % (name, len(self.data)))
+
+    def flash(self):
+        return len(self.data) + GLYPH_BYTES * len(self.glyphs) + len(self.chars) + 1
+
+    def raw(self):
+        return self.bits + GLYPH_BYTES * len(self.glyphs) + len(self.chars) + 1
+
+    def describe(self):
+        return "%d px, %d glyphs" % (self.height, len(self.chars))
+
+    def emit(self):
+        n = self.name
+        out = ["// %s: %s, %d bytes (%d as 1-bit bitmaps)" % (n, self.describe(), self.flash(), self.raw())]
+        out.append("static constexpr UiGlyph %s_GLYPHS[] = {" % n)
+        for ch, (offset, w, h, x, y, advance) in zip(self.chars, self.glyphs):
+            out.append("    { %d, %d, %d, %d, %d, %d },    // '%s'" % (offset, w, h, x, y, advance, ch))
+        out.append("};")
+        out += c_bytes("%s_DATA" % n, self.data)
+        out.append("static constexpr UiFont %s = { %s, %d, %d, %d, %s_GLYPHS, %s_DATA, sizeof(%s_DATA) };" % (
+            n, c_string(self.chars), len(self.chars), self.height, self.ascent, n, n, n))
+        return out
+
+
+def c_bytes(name, data):
+    out = ["static constexpr uint8_t %s[] = {" % name]
+    for i in range(0, len(data), 16):
+        out.append("    " + ", ".join("0x%02X" % b for b in data[i:i + 16]) + ",")
+    out.append("};")
+    return out
+
+
+def c_string(s):
+    return '"' + s.replace("\\", "\\\\").replace('"', '\\"') + '"'
+
+
+# ============================================
+# MANIFEST
+# ============================================
+
+def load_manifest(path):
+    base = os.path.dirname(os.path.abspath(path))
+    assets = []
+    with open(path) as f:
+        for number, line in enumerate(f, 1):
+            words = shlex.split(line, comments=True)
+            if not words:
+                continue
+            try:
+                if words[0] == "image" and len(words) == 3:
+                    with open(os.path.join(base, words[2]), "rb") as png:
+                        w, h, pixels = read_png(png.read())
+                    assets.append(Image(words[1], w, h, pixels))
+                elif words[0] == "font" and len(words) == 4:
+                    with open(os.path.join(base, words[2])) as bdf:
+                        glyphs, ascent, descent = read_bdf(bdf.read())
+                    assets.append(Font(words[1], glyphs, ascent, descent, words[3]))
+                else:
+                    raise AssetError("expected 'image NAME PNG' or 'font NAME BDF CHARS'")
+            except (AssetError, OSError, zlib.error) as e:
+                raise AssetError("%s:%d: %s" % (path, number, e))
+    return assets
+
+
+def render(assets, manifest, output):
+    table = ["%-18s %-17s %6s %6s" % ("asset", "", "flash", "raw")]
+    for a in assets:
+        table.append("%-18s %-17s %6d %6d" % (a.name, a.describe(), a.flash(), a.raw()))
+    out = [
+        "/*",
+        " * ============================================",
+        " * UI Assets - Generated, Do Not Edit",
+        " * ============================================",
+        " *",
+        " * Made by host/ui_assets.py from %s:" % manifest,
+        " *   python3 host/ui_assets.py %s %s" % (manifest, output),
+        " *",
+        " * Flash bytes per asset (raw: RGB565 for",
+        " * images, 1-bit bitmaps for fonts):",
+        " *",
+    ]
+    out += [(" *   " + line).rstrip() for line in table]
+    out += [
+        " *",
+        " * ============================================",
+        " */",
+        "",
+        "#ifndef UI_ASSETS_DATA_H",
+        "#define UI_ASSETS_DATA_H",
+        "",
+        "#include <stdint.h>",
+        '#include "ui_assets.h"',
+        "",
+    ]
+    for a in assets:
+        out += a.emit()
+        out.append("")
+    out.append("#endif // UI_ASSETS_DATA_H")
+    return "\n".join(out) + "\n", table
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    parser.add_argument("manifest", help="asset list (assets/manifest.txt)")
+    parser.add_argument("output", help="header to write (ui_assets_data.h)")
+    parser.add_argument("--check", action="store_true", help="fail if output is not up to date")
+    args = parser.parse_args(argv)
+
+    try:
+        assets = load_manifest(args.manifest)
+    except (AssetError, OSError) as e:
+        sys.stderr.write("ui_assets: %s\n" % e)
+        return 1
+    # As run from the header's directory, wherever this was run from
+    here = os.path.dirname(os.path.abspath(args.output))
+    manifest = os.path.relpath(os.path.abspath(args.manifest), here).replace(os.sep, "/")
+    text, table = render(assets, manifest, os.path.basename(args.output))
+
+    if args.check:
+        try:
+            with open(args.output) as f:
+                current = f.read()
+        except OSError:
+            current = None
+        if current != text:
+            sys.stderr.write("ui_assets: %s is stale, rerun without --check\n" % args.output)
+            return 1
+        return 0
+
+    with open(args.output, "w") as f:
+        f.write(text)
+    for line in table:
+        sys.stdout.write(line + "\n")
+    total = sum(a.flash() for a in assets)
+    sys.stdout.write("ui_assets: %d assets, %d bytes of flash (%d raw)\n" % (
+        len(assets), total, sum(a.raw() for a in assets)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
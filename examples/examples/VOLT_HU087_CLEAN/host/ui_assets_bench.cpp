@@ -0,0 +1,151 @@
+/*
+ * ============================================
+ * UI Asset Benchmark (host)
+ * ============================================
+ *
+ * For every packed asset in ui_assets_data.h:
+ * flash bytes (runs plus palette and row index,
+ * or glyph table) against the same asset
+ * uncompressed (RGB565 for images, 1-bit
+ * bitmaps for fonts), and how fast it decodes
+ * into a sprite canvas (ui_sprites.h), the way
+ * a tile is drawn before its push.
+ *
+ * Decode throughput is in megapixels a second
+ * of the asset's box, and MB/s of RGB565 that
+ * the panel is sent for it. "copy" is the
+ * same box copied row by row from an already
+ * decoded RGB565 image: what storing assets
+ * uncompressed would cost to draw.
+ *
+ * Build and run (from this directory):
+ *   cmake -S . -B build && cmake --build build
+ *   ./build/ui_assets_bench
+ *
+ * ============================================
+ */
+
+#include "volt_hal.h"
+#include "ui_assets.h"
+#include "ui_assets_data.h"
+#include "ui_sprites.h"
+#include "ui_framebuffer.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <set>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static const double MIN_SECONDS = 0.05;
+
+// Runs fn until MIN_SECONDS have passed; seconds per call
+template <typename Fn>
+static double timeIt(Fn fn) {
+    uint32_t n = 0, batch = 16;
+    Clock::time_point start = Clock::now();
+    double elapsed = 0;
+    while (elapsed < MIN_SECONDS) {
+        for (uint32_t i = 0; i < batch; i++) fn();
+        n += batch;
+        batch *= 2;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+    return elapsed / n;
+}
+
+static void row(const char* name, const char* size, uint32_t flash, uint32_t raw, uint32_t px, double decodeS,
+                double copyS) {
+    printf("%-18s %-10s %6u %6u %5.0f%% %9.1f %9.1f %9.1f\n", name, size, flash, raw, 100.0 * flash / raw,
+           px / decodeS / 1e6, px * 2 / decodeS / 1e6, px / copyS / 1e6);
+}
+
+static void benchImage(const char* name, const UiImage& img) {
+    std::vector<uint16_t> buffer((size_t)img.w * img.h), raw((size_t)img.w * img.h, 0);
+    UiCanvas canvas;
+    canvas.attach(buffer.data(), (uint32_t)buffer.size(), UiFramebuffer::glyph, true);
+    UiRect box = { 0, 0, (int16_t)img.w, (int16_t)img.h };
+    canvas.place(box);
+
+    // The uncompressed image, for the copy
+    uiImageRuns(img, 0, (int16_t)img.h, [&](int16_t x, int16_t y, int16_t n, uint16_t c) {
+        for (int16_t i = 0; i < n; i++) raw[(size_t)y * img.w + x + i] = c;
+    });
+
+    double decodeS = timeIt([&] {
+        canvas.fillRect(box, UI_BLACK);
+        canvas.drawImage(0, 0, img, box);
+    });
+    double copyS = timeIt([&] {
+        canvas.fillRect(box, UI_BLACK);
+        for (int16_t y = 0; y < (int16_t)img.h; y++) {
+            memcpy(buffer.data() + (size_t)y * img.w, raw.data() + (size_t)y * img.w, img.w * sizeof(uint16_t));
+        }
+    });
+
+    char size[16];
+    snprintf(size, sizeof(size), "%dx%d", img.w, img.h);
+    // Palette entries are distinct: one per color seen, plus [0]
+    std::set<uint16_t> colors;
+    uiImageRuns(img, 0, (int16_t)img.h, [&](int16_t, int16_t, int16_t, uint16_t c) { colors.insert(c); });
+    uint32_t rows = img.rows ? (uint32_t)(img.h - 1) / UI_IMAGE_ROW_STEP + 1 : 0;
+    uint32_t flash = img.bytes + (uint32_t)(colors.size() + 1 + rows) * sizeof(uint16_t);
+    row(name, size, flash, (uint32_t)img.w * img.h * 2, (uint32_t)img.w * img.h, decodeS, copyS);
+}
+
+static void benchFont(const char* name, const UiFont& font, const char* text) {
+    int len = (int)strlen(text);
+    int16_t w = uiTextWidth(font, text, len);
+    std::vector<uint16_t> buffer((size_t)w * font.height), raw(buffer.size(), 0);
+    UiCanvas canvas;
+    canvas.attach(buffer.data(), (uint32_t)buffer.size(), UiFramebuffer::glyph, true);
+    UiRect box = { 0, 0, w, (int16_t)font.height };
+    canvas.place(box);
+
+    auto draw = [&] {
+        canvas.fillRect(box, UI_BLACK);
+        int16_t pen = 0;
+        for (int i = 0; i < len; i++) {
+            const UiGlyph* g = uiFindGlyph(font, text[i]);
+            if (!g) continue;
+            canvas.drawGlyph(pen, 0, font, *g, UI_WHITE, box);
+            pen = (int16_t)(pen + g->advance);
+        }
+    };
+    draw();
+    memcpy(raw.data(), canvas.getPixels(), raw.size() * sizeof(uint16_t));
+    double decodeS = timeIt(draw);
+    double copyS = timeIt([&] {
+        canvas.fillRect(box, UI_BLACK);
+        for (int16_t y = 0; y < box.h; y++) {
+            memcpy(buffer.data() + (size_t)y * w, raw.data() + (size_t)y * w, w * sizeof(uint16_t));
+        }
+    });
+
+    uint32_t flash = font.bytes + (uint32_t)sizeof(UiGlyph) * font.count + font.count + 1;
+    uint32_t bits = (uint32_t)sizeof(UiGlyph) * font.count + font.count + 1;
+    for (int i = 0; i < font.count; i++) bits += (uint32_t)(font.glyphs[i].w + 7) / 8 * font.glyphs[i].h;
+    char size[24];
+    snprintf(size, sizeof(size), "%d chars", font.count);
+    row(name, size, flash, bits, (uint32_t)box.area(), decodeS, copyS);
+    printf("%-18s   \"%s\", %dx%d\n", "", text, w, font.height);
+}
+
+int main() {
+    nativeHal().quiet = true;
+    printf("%-18s %-10s %6s %6s %6s %9s %9s %9s\n", "asset", "size", "flash", "raw", "", "decode", "decode",
+           "copy");
+    printf("%-18s %-10s %6s %6s %6s %9s %9s %9s\n", "", "", "bytes", "bytes", "", "Mpx/s", "MB/s", "Mpx/s");
+    benchImage("ICON_WIFI", ICON_WIFI);
+    benchImage("ICON_WIFI_OFF", ICON_WIFI_OFF);
+    benchImage("ICON_BATTERY_FULL", ICON_BATTERY_FULL);
+    benchImage("ICON_BATTERY_HALF", ICON_BATTERY_HALF);
+    benchImage("ICON_BATTERY_LOW", ICON_BATTERY_LOW);
+    benchImage("ICON_HEART", ICON_HEART);
+    benchImage("ICON_STAR", ICON_STAR);
+    benchFont("FONT_TITLE", FONT_TITLE, "VOLT");
+    benchFont("FONT_HEADING", FONT_HEADING, "Great Job!");
+    return 0;
+}
@@ -0,0 +1,287 @@
+/*
+ * ============================================
+ * UI Asset Tests (host)
+ * ============================================
+ *
+ * Runs ui_assets.h on hand-made runs and on the
+ * packed assets (ui_assets_data.h): exact
+ * pixels, long runs, transparency, the row
+ * index (any band of rows decodes the same as
+ * the whole image), glyph lookup and text
+ * extent, the canvas against UiDisplay's
+ * fallback (a rectangle a run), and image and
+ * font widgets in a UiScene.
+ *
+ * The converter itself is tested by
+ * ui_assets_test.py.
+ *
+ * Built and run by CMakeLists.txt (ctest).
+ *
+ * ============================================
+ */
+
+#include "volt_hal.h"
+#include "ui_assets.h"
+#include "ui_assets_data.h"
+#include "ui_scene.h"
+#include "ui_framebuffer.h"
+#include "test_check.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+static const int16_t W = 172;
+static const int16_t H = 320;
+
+static const UiImage* const IMAGES[] = { &ICON_WIFI, &ICON_WIFI_OFF, &ICON_BATTERY_FULL, &ICON_BATTERY_HALF,
+                                         &ICON_BATTERY_LOW, &ICON_HEART, &ICON_STAR };
+static const int IMAGE_COUNT = sizeof(IMAGES) / sizeof(IMAGES[0]);
+
+// Draws everything with fillRect, through UiDisplay's own
+// drawImage() and drawGlyph(): what TftUiDisplay does
+class RectDisplay : public UiDisplay {
+public:
+    UiFramebuffer fb;
+    uint32_t rects;
+
+    RectDisplay() : fb(W, H), rects(0) {}
+
+    void fillRect(const UiRect& r, uint16_t color) override {
+        fb.fillRect(r, color);
+        rects++;
+    }
+
+    void drawText(int16_t x, int16_t y, uint8_t size, uint16_t color, const char* s, int len,
+                  const UiRect& clip) override {
+        fb.drawText(x, y, size, color, s, len, clip);
+    }
+};
+
+// ============================================
+// RUNS
+// ============================================
+
+static void testHandMadeImage() {
+    // 5x3: a red run of 3, clear 2 / clear 1, blue 4 / green 5
+    static const uint16_t palette[] = { 0, UI_RED, UI_BLUE, UI_GREEN };
+    static const uint8_t data[] = { 0x12, 0x01, 0x00, 0x23, 0x34 };
+    UiImage img = { 5, 3, palette, data, nullptr, sizeof(data) };
+
+    UiFramebuffer fb(8, 4);
+    fb.fillRect({ 0, 0, 8, 4 }, UI_WHITE);
+    fb.drawImage(1, 1, img, { 0, 0, 8, 4 });
+    CHECK(fb.at(1, 1) == UI_RED && fb.at(3, 1) == UI_RED);
+    CHECK(fb.at(4, 1) == UI_WHITE && fb.at(5, 1) == UI_WHITE);   // Transparent
+    CHECK(fb.at(1, 2) == UI_WHITE && fb.at(2, 2) == UI_BLUE && fb.at(5, 2) == UI_BLUE);
+    CHECK(fb.at(1, 3) == UI_GREEN && fb.at(5, 3) == UI_GREEN);
+    CHECK(fb.at(0, 1) == UI_WHITE && fb.at(6, 3) == UI_WHITE);
+
+    // Clipped to one column and one row
+    fb.fillRect({ 0, 0, 8, 4 }, UI_WHITE);
+    fb.drawImage(1, 1, img, { 3, 2, 1, 1 });
+    CHECK(fb.at(3, 2) == UI_BLUE);
+    CHECK(fb.at(2, 2) == UI_WHITE && fb.at(3, 1) == UI_WHITE && fb.at(3, 3) == UI_WHITE);
+}
+
+static void testLongRuns() {
+    // 300 wide: 16 + 255 clear, then 29 red (16 + 13)
+    static const uint16_t palette[] = { 0, UI_RED };
+    static const uint8_t data[] = { 0x0F, 0xFF, 0x1F, 0x0D };
+    UiImage img = { 300, 1, palette, data, nullptr, sizeof(data) };
+    std::vector<int16_t> runs;
+    uiImageRuns(img, 0, 1, [&](int16_t x, int16_t, int16_t n, uint16_t color) {
+        runs.push_back(x);
+        runs.push_back(n);
+        CHECK(color == UI_RED);
+    });
+    CHECK(runs.size() == 2 && runs[0] == 271 && runs[1] == 29);
+}
+
+// Every image, decoded one band of rows at a time, with and without
+// the row index: the same runs as all at once
+static void testRowIndex() {
+    for (int i = 0; i < IMAGE_COUNT; i++) {
+        const UiImage& img = *IMAGES[i];
+        CHECK((img.rows != nullptr) == (img.h > UI_IMAGE_ROW_STEP));
+        UiImage noIndex = img;
+        noIndex.rows = nullptr;
+
+        std::vector<uint32_t> whole;
+        uint32_t pixels = 0;
+        uiImageRuns(img, 0, (int16_t)img.h, [&](int16_t x, int16_t y, int16_t n, uint16_t c) {
+            whole.push_back((uint32_t)y << 24 | (uint32_t)x << 16 | c);
+            whole.push_back((uint32_t)n);
+            pixels += (uint32_t)n;
+        });
+        CHECK(pixels > 0 && pixels < (uint32_t)img.w * img.h);
+
+        const UiImage* both[] = { &img, &noIndex };
+        bool same = true;
+        for (int band = 1; band <= img.h; band += 3) {
+            for (const UiImage* which : both) {
+                std::vector<uint32_t> parts;
+                for (int16_t top = 0; top < (int16_t)img.h; top = (int16_t)(top + band)) {
+                    uiImageRuns(*which, top, (int16_t)(top + band), [&](int16_t x, int16_t y, int16_t n, uint16_t c) {
+                        same &= y >= top && y < top + band;
+                        parts.push_back((uint32_t)y << 24 | (uint32_t)x << 16 | c);
+                        parts.push_back((uint32_t)n);
+                    });
+                }
+                same &= parts == whole;
+            }
+        }
+        CHECK(same);
+
+        // Runs never cross a row
+        bool inRow = true;
+        uiImageRuns(img, 0, (int16_t)img.h, [&](int16_t x, int16_t, int16_t n, uint16_t) {
+            inRow &= x >= 0 && x + n <= (int16_t)img.w;
+        });
+        CHECK(inRow);
+    }
+}
+
+// ============================================
+// FONTS
+// ============================================
+
+static void testGlyphs() {
+    CHECK(FONT_TITLE.count == 4);
+    CHECK(uiFindGlyph(FONT_TITLE, 'V') != nullptr);
+    CHECK(uiFindGlyph(FONT_TITLE, 'X') == nullptr);
+    CHECK(uiFindGlyph(FONT_HEADING, ' ') != nullptr);
+    CHECK(uiFindGlyph(FONT_HEADING, ' ')->w == 0);
+
+    // Every glyph inside its line, ink in every row and column it
+    // claims, runs covering exactly w * h
+    bool fits = true, tight = true;
+    for (const UiFont* f : { &FONT_TITLE, &FONT_HEADING }) {
+        for (int i = 0; i < f->count; i++) {
+            const UiGlyph& g = f->glyphs[i];
+            fits &= g.y >= 0 && g.y + g.h <= f->height;
+            if (g.w == 0) continue;
+            std::vector<int> rows(g.h, 0), cols(g.w, 0);
+            uiGlyphRuns(*f, g, 0, g.h, [&](int16_t x, int16_t y, int16_t n) {
+                rows[y] += n;
+                for (int c = x; c < x + n; c++) cols[c]++;
+                fits &= x + n <= g.w;
+            });
+            tight &= rows.front() > 0 && rows.back() > 0 && cols.front() > 0 && cols.back() > 0;
+        }
+    }
+    CHECK(fits);
+    CHECK(tight);
+
+    // Width: advances; characters outside the subset take no space
+    const UiGlyph* v = uiFindGlyph(FONT_TITLE, 'V');
+    const UiGlyph* o = uiFindGlyph(FONT_TITLE, 'O');
+    CHECK(uiTextWidth(FONT_TITLE, "VO", 2) == v->advance + o->advance);
+    CHECK(uiTextWidth(FONT_TITLE, "VxO", 3) == uiTextWidth(FONT_TITLE, "VO", 2));
+    CHECK(uiTextWidth(FONT_TITLE, "", 0) == 0);
+}
+
+// UiCanvas writes runs itself; UiDisplay's fallback sends one
+// rectangle a run. Same pixels either way.
+static void testCanvasMatchesRects() {
+    UiScene a, b;
+    a.begin(W, H);
+    b.begin(W, H);
+    UiFramebuffer canvas(W, H);
+    RectDisplay rects;
+    for (UiScene* s : { &a, &b }) {
+        s->compose(UI_PURPLE);
+        int16_t y = 0;
+        for (int i = 0; i < IMAGE_COUNT; i++) {
+            s->image((int16_t)(i * 7 - 3), y, *IMAGES[i]);   // The first hangs off the left
+            y = (int16_t)(y + IMAGES[i]->h);
+        }
+        s->text(5, 200, FONT_TITLE, UI_CYAN, "VOLT");
+        s->text(150, 260, FONT_HEADING, UI_WHITE, "Great Job!");  // Off the right edge
+    }
+    a.flush(canvas);
+    b.flush(rects);
+    CHECK(canvas.same(rects.fb));
+    CHECK(rects.rects > 100);
+    CHECK(canvas.getFrameRects() < rects.rects);
+
+    // A band through the middle of everything
+    a.invalidate();
+    b.invalidate();
+    UiFramebuffer canvas2(W, H);
+    RectDisplay rects2;
+    a.beginFlush();
+    b.beginFlush();
+    a.paint(canvas2, { 0, 13, W, 9 });
+    b.paint(rects2, { 0, 13, W, 9 });
+    a.endFlush(0);
+    b.endFlush(0);
+    CHECK(canvas2.same(rects2.fb));
+}
+
+// ============================================
+// SCENE
+// ============================================
+
+static void testSceneWidgets() {
+    UiScene scene;
+    scene.begin(W, H);
+    UiFramebuffer fb(W, H);
+
+    scene.compose(UI_BLACK);
+    scene.image(10, 10, ICON_WIFI);
+    scene.text(20, 100, FONT_HEADING, UI_WHITE, "Hi Stone!");
+    scene.flush(fb);
+
+    // The same again: nothing
+    scene.compose(UI_BLACK);
+    scene.image(10, 10, ICON_WIFI);
+    scene.text(20, 100, FONT_HEADING, UI_WHITE, "Hi Stone!");
+    CHECK(scene.flush(fb) == 0);
+
+    // Another image of the same size in the slot: just its box
+    scene.compose(UI_BLACK);
+    scene.image(10, 10, ICON_WIFI_OFF);
+    scene.text(20, 100, FONT_HEADING, UI_WHITE, "Hi Stone!");
+    CHECK(scene.flush(fb) == (uint32_t)ICON_WIFI.w * ICON_WIFI.h);
+    CHECK(scene.getDirtyCount() == 0);
+
+    // Ink is inside the text's bounds: a box around them stays
+    // background
+    int16_t width = uiTextWidth(FONT_HEADING, "Hi Stone!", 9);
+    bool inside = true;
+    for (int16_t x = 0; x < W; x++) {
+        for (int16_t y = 90; y < 140; y++) {
+            bool in = x >= 20 && x < 20 + width && y >= 100 && y < 100 + FONT_HEADING.height;
+            if (!in && !(x < 40 && y < 40)) inside &= fb.at(x, y) == UI_BLACK;
+        }
+    }
+    CHECK(inside);
+
+    // Changing the text repaints its old and new bounds only
+    scene.compose(UI_BLACK);
+    scene.image(10, 10, ICON_WIFI_OFF);
+    scene.text(20, 100, FONT_HEADING, UI_WHITE, "Hi Dad!");
+    CHECK(scene.flush(fb) == (uint32_t)width * FONT_HEADING.height);
+
+    UiScene full;
+    full.begin(W, H);
+    UiFramebuffer expected(W, H);
+    full.compose(UI_BLACK);
+    full.image(10, 10, ICON_WIFI_OFF);
+    full.text(20, 100, FONT_HEADING, UI_WHITE, "Hi Dad!");
+    full.flush(expected);
+    CHECK(fb.same(expected));
+}
+
+int main() {
+    nativeHal().quiet = true;
+    testHandMadeImage();
+    testLongRuns();
+    testRowIndex();
+    testGlyphs();
+    testCanvasMatchesRects();
+    testSceneWidgets();
+
+    return testSummary();
+}
@@ -0,0 +1,268 @@
+#!/usr/bin/env python3
+"""
+Tests for ui_assets.py against synthetic PNG and BDF files: every PNG
+color type and filter, transparency, the 15 color limit, runs (long
+ones, rows starting on a byte, the row index), glyph pairs, font
+subsets trimmed to their ink, the manifest, the generated header and
+--check. Also checks that the committed ui_assets_data.h is up to date
+with assets/.
+
+Run directly (ctest does) or with pytest.
+"""
+
+import os
+import struct
+import subprocess
+import sys
+import tempfile
+import zlib
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SKETCH = os.path.dirname(HERE)
+sys.path.insert(0, HERE)
+
+import ui_assets as ua  # noqa: E402
+
+
+def build_png(w, h, color, depth, rows, palette=None, trns=None, filters=(0,)):
+    """PNG from rows of raw samples (one int per sample, packed for depth < 8)."""
+    def chunk(kind, body):
+        return struct.pack(">I", len(body)) + kind + body + struct.pack(">I", zlib.crc32(kind + body) & 0xFFFFFFFF)
+
+    channels = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}[color]
+    bpp = max(1, channels * depth // 8)
+    raw, prev = b"", None
+    for y, samples in enumerate(rows):
+        if depth < 8:
+            line, bits, acc = bytearray(), 0, 0
+            for v in samples:
+                acc, bits = (acc << depth) | v, bits + depth
+                if bits == 8:
+                    line.append(acc)
+                    acc = bits = 0
+            if bits:
+                line.append(acc << (8 - bits))
+        else:
+            line = bytearray(samples)
+        prev = prev if prev is not None else bytearray(len(line))
+        kind = filters[y % len(filters)]
+        out = bytearray(line)
+        for i in range(len(line)):
+            a = line[i - bpp] if i >= bpp else 0
+            b, c = prev[i], prev[i - bpp] if i >= bpp else 0
+            pred = [0, a, b, (a + b) // 2, ua._paeth(a, b, c)][kind]
+            out[i] = (line[i] - pred) & 0xFF
+        raw += bytes([kind]) + bytes(out)
+        prev = line
+    data = b"\x89PNG\r\n\x1a\n" + chunk(b"IHDR", struct.pack(">IIBBBBB", w, h, depth, color, 0, 0, 0))
+    if palette:
+        data += chunk(b"PLTE", b"".join(bytes(c) for c in palette))
+    if trns is not None:
+        data += chunk(b"tRNS", trns)
+    return data + chunk(b"IDAT", zlib.compress(raw)) + chunk(b"IEND", b"")
+
+
+def build_bdf(glyphs, ascent=10, descent=3):
+    """BDF from {char: (advance, xoff, yoff, rows as '#.' strings)}."""
+    lines = ["STARTFONT 2.1", "FONT test", "SIZE 12 75 75", "FONTBOUNDINGBOX 12 13 0 -3",
+             "STARTPROPERTIES 2", "FONT_ASCENT %d" % ascent, "FONT_DESCENT %d" % descent,
+             "ENDPROPERTIES", "CHARS %d" % len(glyphs)]
+    for ch, (advance, xoff, yoff, rows) in sorted(glyphs.items()):
+        w = len(rows[0]) if rows else 0
+        lines += ["STARTCHAR c%d" % ord(ch), "ENCODING %d" % ord(ch), "SWIDTH 500 0",
+                  "DWIDTH %d 0" % advance, "BBX %d %d %d %d" % (w, len(rows), xoff, yoff), "BITMAP"]
+        nbytes = (w + 7) // 8
+        for row in rows:
+            value = int(row.replace("#", "1").replace(".", "0"), 2) << (nbytes * 8 - w)
+            lines.append("%0*X" % (nbytes * 2, value))
+        lines.append("ENDCHAR")
+    lines.append("ENDFONT")
+    return "\n".join(lines) + "\n"
+
+
+# 4x3 test card in RGBA
+RED, GREEN, BLUE, CLEAR = (255, 0, 0, 255), (0, 255, 0, 255), (0, 0, 255, 255), (0, 0, 0, 0)
+CARD = [[RED, RED, GREEN, CLEAR], [CLEAR, BLUE, BLUE, BLUE], [GREEN, GREEN, GREEN, GREEN]]
+
+
+def test_png_color_types():
+    flat = lambda px: [v for p in px for v in p]   # noqa: E731
+    for filters in ((0,), (1,), (2,), (3,), (4,), (4, 1, 3)):
+        png = build_png(4, 3, 6, 8, [flat(r) for r in CARD], filters=filters)
+        assert ua.read_png(png) == (4, 3, CARD)
+
+    # RGB with a transparent key color
+    rgb = [[p[:3] if p[3] else (9, 9, 9) for p in r] for r in CARD]
+    png = build_png(4, 3, 2, 8, [flat(r) for r in rgb], trns=struct.pack(">HHH", 9, 9, 9), filters=(2, 4))
+    w, h, px = ua.read_png(png)
+    assert [[p[3] == 0 for p in r] for r in px] == [[p[3] == 0 for p in r] for r in CARD]
+
+    # Palette, 2 bits, with tRNS
+    palette = [(0, 0, 0), (255, 0, 0), (0, 255, 0), (0, 0, 255)]
+    index = {RED: 1, GREEN: 2, BLUE: 3, CLEAR: 0}
+    png = build_png(4, 3, 3, 2, [[index[p] for p in r] for r in CARD], palette=palette, trns=b"\x00")
+    assert ua.read_png(png)[2] == CARD
+
+    # Gray at 1 and 8 bits, gray + alpha
+    png = build_png(3, 1, 0, 1, [[1, 0, 1]])
+    assert ua.read_png(png)[2] == [[(255, 255, 255, 255), (0, 0, 0, 255), (255, 255, 255, 255)]]
+    png = build_png(2, 1, 0, 8, [[0x80, 7]], trns=struct.pack(">H", 7))
+    assert ua.read_png(png)[2] == [[(0x80, 0x80, 0x80, 255), (7, 7, 7, 0)]]
+    png = build_png(2, 1, 4, 8, [[200, 255, 10, 0]], filters=(1,))
+    assert ua.read_png(png)[2] == [[(200, 200, 200, 255), (10, 10, 10, 0)]]
+
+
+def test_png_rejects():
+    for bad in (b"GIF89a", build_png(1, 1, 6, 8, [[0, 0, 0, 0]])[:8]):
+        try:
+            ua.read_png(bad)
+            assert False
+        except ua.AssetError:
+            pass
+    png = bytearray(build_png(1, 1, 6, 8, [[0, 0, 0, 0]]))
+    png[8 + 8 + 12] = 1                         # Interlace byte of IHDR
+    try:
+        ua.read_png(bytes(png))
+        assert False
+    except ua.AssetError as e:
+        assert "interlaced" in str(e)
+
+
+def test_runs():
+    # Long runs split at 271, rows start on a byte
+    rows = [[0] * 300, [1] * 16 + [2] * 284]
+    data, starts = ua.encode_runs(rows)
+    assert starts == [0, 4]
+    assert data[:4] == bytes([0x0F, 0xFF, 0x0F, 0x0D])
+    assert ua.decode_runs(data, 300, 2) == rows
+
+    rows = [[i % 3] * 5 for i in range(40)]
+    data, starts = ua.encode_runs(rows)
+    assert len(data) == 40 and ua.decode_runs(data, 5, 40) == rows
+
+    # Pairs run across rows
+    bits = [[0, 1, 1], [1, 0, 0], [0, 0, 1]]
+    data = ua.encode_pairs(bits)
+    assert data == bytes([0x13, 0x41])
+    assert ua.decode_pairs(data, 3, 3) == bits
+    bits = [[1] * 20 + [0] * 20]
+    assert ua.decode_pairs(ua.encode_pairs(bits), 40, 1) == bits
+
+
+def test_image():
+    img = ua.Image("CARD", 4, 3, CARD)
+    assert img.palette == [0, 0xF800, 0x07E0, 0x001F]
+    assert ua.decode_runs(img.data, 4, 3) == [[1, 1, 2, 0], [0, 3, 3, 3], [2, 2, 2, 2]]
+    assert img.rows == []                       # Too short for an index
+    assert img.flash() == len(img.data) + 8 and img.raw() == 24
+
+    tall = ua.Image("TALL", 2, 20, [[RED, BLUE]] * 20)
+    assert tall.rows == [0, 16, 32]
+    assert "static constexpr uint16_t TALL_ROWS[] = { 0, 16, 32 };" in tall.emit()
+
+    many = [[(i * 16, 0, 0, 255) for i in range(16)]]
+    try:
+        ua.Image("MANY", 16, 1, many)
+        assert False
+    except ua.AssetError as e:
+        assert "15 colors" in str(e)
+    ua.Image("FIFTEEN", 16, 1, [many[0][:15] + [CLEAR]])
+
+    # Below half alpha is transparent
+    assert ua.Image("A", 2, 1, [[(1, 2, 3, 127), (1, 2, 3, 128)]]).palette == [0, 0]
+
+
+GLYPHS = {
+    "A": (7, 0, 0, [".##..", "#..#.", "####.", "#..#.", "....."]),   # Empty column and row
+    "j": (4, -1, -2, ["..#", "...", "..#", "..#", "##."]),          # Below the baseline, left of the pen
+    " ": (4, 0, 0, []),
+    "B": (6, 0, 0, ["##", "##"]),
+}
+
+
+def test_font_subset():
+    glyphs, ascent, descent = ua.read_bdf(build_bdf(GLYPHS))
+    assert ascent == 10 and descent == 3 and set(glyphs) == {ord(c) for c in GLYPHS}
+
+    font = ua.Font("F", glyphs, ascent, descent, "jA A")
+    assert font.chars == " Aj"
+    assert font.height == 13
+    offset, w, h, x, y, advance = font.glyphs[1]   # A: trimmed to 4x4, top at 10 - 5
+    assert (w, h, x, y, advance) == (4, 4, 0, 5, 7)
+    rows = ua.decode_pairs(font.data[offset:font.glyphs[2][0]], w, h)
+    assert rows == [[0, 1, 1, 0], [1, 0, 0, 1], [1, 1, 1, 1], [1, 0, 0, 1]]
+    offset, w, h, x, y, advance = font.glyphs[2]   # j
+    assert (w, h, x, y) == (3, 5, -1, 7)
+    assert font.glyphs[0][1:] == (0, 0, 0, 0, 4)   # Space: no ink
+    assert "B" not in font.chars
+
+    try:
+        ua.Font("F", glyphs, ascent, descent, "AZ")
+        assert False
+    except ua.AssetError as e:
+        assert "'Z'" in str(e)
+    try:
+        ua.Font("F", glyphs, 3, 0, "A")            # Taller than the line
+        assert False
+    except ua.AssetError as e:
+        assert "fit" in str(e)
+
+    lines = font.emit()
+    assert lines[-1] == 'static constexpr UiFont F = { " Aj", 3, 13, 10, F_GLYPHS, F_DATA, sizeof(F_DATA) };'
+    assert "    { %d, 3, 5, -1, 7, 4 },    // 'j'" % font.glyphs[2][0] in lines
+
+
+def test_command_line():
+    with tempfile.TemporaryDirectory() as tmp:
+        os.mkdir(os.path.join(tmp, "assets"))
+        flat = [v for r in CARD for p in r for v in p]
+        with open(os.path.join(tmp, "assets", "card.png"), "wb") as f:
+            f.write(build_png(4, 3, 6, 8, [flat[i * 16:(i + 1) * 16] for i in range(3)]))
+        with open(os.path.join(tmp, "assets", "test.bdf"), "w") as f:
+            f.write(build_bdf(GLYPHS))
+        manifest = os.path.join(tmp, "assets", "manifest.txt")
+        with open(manifest, "w") as f:
+            f.write("# Test\nimage ICON_CARD card.png\n\nfont FONT_T test.bdf \"A j\"  # A and j\n")
+        out = os.path.join(tmp, "ui_assets_data.h")
+        script = os.path.join(HERE, "ui_assets.py")
+
+        result = subprocess.run([sys.executable, script, manifest, out], capture_output=True, text=True)
+        assert result.returncode == 0, result.stderr
+        assert "ICON_CARD" in result.stdout and "2 assets" in result.stdout
+        with open(out) as f:
+            text = f.read()
+        assert "python3 host/ui_assets.py assets/manifest.txt ui_assets_data.h" in text
+        assert "static constexpr UiImage ICON_CARD = { 4, 3, ICON_CARD_PALETTE, ICON_CARD_DATA, nullptr," in text
+        assert '#include "ui_assets.h"' in text
+
+        result = subprocess.run([sys.executable, script, "--check", manifest, out], capture_output=True)
+        assert result.returncode == 0
+        with open(out, "a") as f:
+            f.write("// edited\n")
+        result = subprocess.run([sys.executable, script, "--check", manifest, out], capture_output=True, text=True)
+        assert result.returncode == 1 and "stale" in result.stderr
+
+        with open(manifest, "a") as f:
+            f.write("image ICON_GONE missing.png\n")
+        result = subprocess.run([sys.executable, script, manifest, out], capture_output=True, text=True)
+        assert result.returncode == 1 and "manifest.txt:5" in result.stderr
+
+
+def test_committed_header_is_current():
+    result = subprocess.run([sys.executable, os.path.join(HERE, "ui_assets.py"), "--check",
+                             os.path.join(SKETCH, "assets", "manifest.txt"),
+                             os.path.join(SKETCH, "ui_assets_data.h")], capture_output=True, text=True)
+    assert result.returncode == 0, result.stderr
+
+
+if __name__ == "__main__":
+    tests = [v for k, v in sorted(globals().items()) if k.startswith("test_")]
+    failed = 0
+    for test in tests:
+        try:
+            test()
+        except (AssertionError, ua.AssetError) as e:
+            failed += 1
+            print("FAIL %s: %s" % (test.__name__, e))
+    print("%d tests, %d failed" % (len(tests), failed))
+    sys.exit(1 if failed else 0)
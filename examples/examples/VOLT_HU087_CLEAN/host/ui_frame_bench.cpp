@@ -0,0 +1,202 @@
+/*
+ * ============================================
+ * UI Frame Time Benchmark (host)
+ * ============================================
+ *
+ * Times breathing animation frames (30 a
+ * second, a 33 ms budget) three ways:
+ *
+ *   direct    ui_scene.h straight onto the
+ *             panel: every fill and glyph waits
+ *             for SPI, and the background shows
+ *             before what is drawn over it
+ *   sprite    ui_sprites.h, each tile pushed and
+ *             waited for before the next is drawn
+ *   sprite+dma  the same with two buffers: a tile
+ *             is drawn while the last one is sent
+ *
+ * Scenarios: a breathing cycle (in, hold, out),
+ * and the same frames with the whole screen
+ * repainted each time (a transition, or a
+ * screen that changes everywhere).
+ *
+ * Frame time is drawing time, measured on this
+ * machine and multiplied by a factor standing
+ * in for the watch's CPU (first argument,
+ * default 20; 1 for this machine's own), plus
+ * SPI time at 40 MHz, 16 bits a pixel, where the
+ * drawing has to wait for it. Reports p50, p99,
+ * worst and frames over budget.
+ *
+ * Build and run (from this directory):
+ *   cmake -S . -B build && cmake --build build
+ *   ./build/ui_frame_bench [cpu factor]
+ *
+ * ============================================
+ */
+
+#include "volt_hal.h"
+#include "ui_scene.h"
+#include "ui_sprites.h"
+#include "volt_screens.h"
+#include "ui_framebuffer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+static const int16_t W = 172;
+static const int16_t H = 320;
+static const double SPI_US_PER_PX = 16 / 40.0;   // 40 MHz
+static const double BUDGET_US = 33000;
+
+typedef std::chrono::steady_clock Clock;
+
+static double cpuScale = 20;
+
+static double sinceUs(Clock::time_point t) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - t).count() * cpuScale;
+}
+
+// A modeled panel: drawing time runs between calls, SPI time on
+// its own bus; with DMA the two overlap
+class TimedPanel : public UiFramebufferPanel {
+private:
+    bool dma;
+    double t;                    // This frame, us
+    double busFree;
+    Clock::time_point mark;
+
+    void cpu() { t += sinceUs(mark); }
+    void resume() { mark = Clock::now(); }
+
+public:
+    TimedPanel(UiFramebuffer& fb, bool useDma) : UiFramebufferPanel(fb, true), dma(useDma), t(0), busFree(0) {}
+
+    void startFrame() {
+        t = busFree = 0;
+        resume();
+    }
+
+    void push(const UiRect& r, const uint16_t* px) override {
+        UiFramebufferPanel::push(r, px);     // Waits through wait() first
+        cpu();
+        double end = std::max(t, busFree) + r.area() * SPI_US_PER_PX;
+        busFree = end;
+        if (!dma) t = end;
+        resume();
+    }
+
+    void wait() override {
+        cpu();
+        t = std::max(t, busFree);
+        UiFramebufferPanel::wait();
+        resume();
+    }
+
+    double frameUs() {
+        cpu();
+        resume();
+        return t;
+    }
+};
+
+struct Stats {
+    std::vector<double> us;
+    double pixels = 0;
+
+    double pct(double p) {
+        std::sort(us.begin(), us.end());
+        return us[std::min(us.size() - 1, (size_t)(p * us.size()))];
+    }
+
+    int over() const {
+        int n = 0;
+        for (double u : us) n += u > BUDGET_US;
+        return n;
+    }
+};
+
+struct Frame {
+    int phase;
+    uint32_t ms;
+};
+
+static std::vector<Frame> breathingCycle() {
+    std::vector<Frame> frames;
+    for (int phase = 0; phase < 3; phase++) {
+        for (uint32_t ms = 0; ms < AppStateMachine::breathMs(phase); ms += 33) frames.push_back({ phase, ms });
+    }
+    return frames;
+}
+
+static Stats runDirect(const std::vector<Frame>& frames, bool everything) {
+    UiScene scene;
+    scene.begin(W, H);
+    UiFramebuffer fb(W, H);
+    VoltScreens screens(scene);
+    Stats s;
+    for (const Frame& f : frames) {
+        Clock::time_point start = Clock::now();
+        if (everything) scene.invalidate();
+        screens.breathe(f.phase, f.ms);
+        scene.flush(fb);
+        double cpu = sinceUs(start);
+        s.us.push_back(cpu + fb.getFramePixels() * SPI_US_PER_PX);
+        s.pixels += fb.getFramePixels();
+    }
+    return s;
+}
+
+static Stats runSprites(const std::vector<Frame>& frames, bool everything, bool dma) {
+    nativeHeapInternal().resize(256 * 1024);
+    MemPools pools;
+    UiSpriteRenderer sprites;
+    if (!sprites.begin(pools, (uint32_t)W * 40, UiFramebuffer::glyph, true)) {
+        printf("Sprite buffers failed\n");
+        exit(1);
+    }
+    UiScene scene;
+    scene.begin(W, H);
+    UiFramebuffer fb(W, H);
+    TimedPanel panel(fb, dma);
+    VoltScreens screens(scene);
+    Stats s;
+    for (const Frame& f : frames) {
+        uint32_t before = panel.getPixels();
+        panel.startFrame();
+        if (everything) scene.invalidate();
+        screens.breathe(f.phase, f.ms);
+        sprites.flush(scene, panel);
+        s.us.push_back(panel.frameUs());
+        s.pixels += panel.getPixels() - before;
+    }
+    return s;
+}
+
+static void report(const char* scenario, const char* how, Stats s) {
+    double n = (double)s.us.size();
+    double p50 = s.pct(0.50), p99 = s.pct(0.99);
+    double worst = *std::max_element(s.us.begin(), s.us.end());
+    printf("%-16s %-11s %6d %9.1f %8.2f %8.2f %8.2f %6d\n", scenario, how, (int)n, s.pixels / n * 2 / 1024,
+           p50 / 1000, p99 / 1000, worst / 1000, s.over());
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) cpuScale = atof(argv[1]);
+    nativeHal().quiet = true;
+    std::vector<Frame> frames = breathingCycle();
+
+    printf("CPU factor %.0f, SPI 40 MHz, budget %.0f ms\n\n", cpuScale, BUDGET_US / 1000);
+    printf("%-16s %-11s %6s %9s %8s %8s %8s %6s\n", "scenario", "drawing", "frames", "KB/frame", "p50 ms",
+           "p99 ms", "max ms", "over");
+    for (int everything = 0; everything < 2; everything++) {
+        const char* name = everything ? "full repaint" : "breathing cycle";
+        report(name, "direct", runDirect(frames, everything));
+        report(name, "sprite", runSprites(frames, everything, false));
+        report(name, "sprite+dma", runSprites(frames, everything, true));
+    }
+    return 0;
+}
@@ -0,0 +1,208 @@
+/*
+ * ============================================
+ * UI Framebuffer - Host Display for ui_scene.h
+ * ============================================
+ *
+ * Handles:
+ * - An RGB565 framebuffer the size of the
+ *   watch's screen, drawn by the same canvas
+ *   code as the sprites (ui_sprites.h)
+ * - Counting what a real panel would be sent:
+ *   pixels and rectangles per frame and in
+ *   total (2 bytes a pixel over SPI)
+ * - Text in 6x8 cells with a fixed stand-in
+ *   glyph per character: same bounds as the
+ *   TFT's built-in font, foreground pixels only.
+ *   Packed icons and fonts (ui_assets.h) are
+ *   the real ones
+ * - Comparing two framebuffers pixel by pixel
+ * - The ST7789's vertical scroll: a band of
+ *   rows shown rotated (shown() is what the
+ *   panel displays, at() what was drawn)
+ * - UiFramebufferPanel: a UiPanel for the sprite
+ *   renderer. A push lands in the framebuffer
+ *   only at wait(), the way DMA reads the
+ *   buffer while it sends, so a renderer that
+ *   draws into a buffer still in flight shows
+ *   up as wrong pixels. Pushes that start
+ *   before the last one was waited for are
+ *   counted
+ *
+ * The built-in font's glyphs are not the real
+ * ones; they only need to land in the same
+ * cells and be the same every time, so a
+ * partial update can be checked against a
+ * full redraw.
+ *
+ * ============================================
+ */
+
+#ifndef UI_FRAMEBUFFER_H
+#define UI_FRAMEBUFFER_H
+
+#include <stdint.h>
+#include <vector>
+#include "ui_scene.h"
+#include "ui_sprites.h"
+
+class UiFramebuffer : public UiCanvas {
+private:
+    int16_t width, height;
+    std::vector<uint16_t> px;
+    uint32_t frameStart;         // getWritten() when the frame began
+    uint32_t frameRects;
+    uint32_t totalPixels;
+    uint32_t frames;
+    bool scrollable;
+    int16_t scrollTop, scrollH, scrollOffset;
+
+public:
+    // 5x7 on/off pattern for a character, the same on every run
+    static uint64_t glyph(char c) {
+        if (c == ' ') return 0;
+        uint64_t h = (uint64_t)(uint8_t)c * 0x9E3779B97F4A7C15ULL;
+        h ^= h >> 29;
+        return (h & 0x7FFFFFFFFULL) | 1;     // 35 bits, never blank
+    }
+
+    UiFramebuffer(int16_t w, int16_t h)
+        : width(w), height(h), px((size_t)w * h, 0xDEAD), scrollable(true), scrollTop(0), scrollH(0),
+          scrollOffset(0) {
+        attach(px.data(), (uint32_t)px.size(), glyph, false);
+        place({ 0, 0, w, h });
+        resetCounts();
+    }
+
+    void resetCounts() {
+        frameStart = getWritten();
+        frameRects = totalPixels = frames = 0;
+    }
+
+    void beginFrame() override {
+        frameStart = getWritten();
+        frameRects = 0;
+    }
+
+    void endFrame() override {
+        totalPixels += getFramePixels();
+        frames++;
+    }
+
+    void fillRect(const UiRect& r, uint16_t color) override {
+        UiCanvas::fillRect(r, color);
+        frameRects++;
+    }
+
+    void drawText(int16_t x, int16_t y, uint8_t size, uint16_t color, const char* s, int len,
+                  const UiRect& clip) override {
+        UiCanvas::drawText(x, y, size, color, s, len, clip);
+        frameRects++;
+    }
+
+    void fillCircle(int16_t cx, int16_t cy, int16_t r, uint16_t color, const UiRect& clip) override {
+        UiCanvas::fillCircle(cx, cy, r, color, clip);
+        frameRects++;
+    }
+
+    void drawImage(int16_t x, int16_t y, const UiImage& img, const UiRect& clip) override {
+        UiCanvas::drawImage(x, y, img, clip);
+        frameRects++;
+    }
+
+    void drawGlyph(int16_t x, int16_t y, const UiFont& font, const UiGlyph& g, uint16_t color,
+                   const UiRect& clip) override {
+        UiCanvas::drawGlyph(x, y, font, g, color, clip);
+        frameRects++;
+    }
+
+    bool scrollRows(int16_t top, int16_t h, int16_t offset) override {
+        if (!scrollable || top < 0 || h <= 0 || top + h > height) return false;
+        scrollTop = top;
+        scrollH = h;
+        scrollOffset = (int16_t)(offset % h);
+        return true;
+    }
+
+    // A panel without hardware scroll
+    void setScrollable(bool on) { scrollable = on; }
+    int16_t getScrollOffset() const { return scrollOffset; }
+
+    // Copies a tile in (a panel's push)
+    void blit(const UiRect& r, const uint16_t* src, bool swapped) {
+        for (int16_t y = 0; y < r.h; y++) {
+            for (int16_t x = 0; x < r.w; x++) {
+                uint16_t c = src[(size_t)y * r.w + x];
+                if (swapped) c = (uint16_t)((c >> 8) | (c << 8));
+                int16_t sx = (int16_t)(r.x + x), sy = (int16_t)(r.y + y);
+                if (sx >= 0 && sy >= 0 && sx < width && sy < height) px[(size_t)sy * width + sx] = c;
+            }
+        }
+    }
+
+    // What the last frame sent (0 if flush() had nothing to send)
+    uint32_t getFramePixels() const { return getWritten() - frameStart; }
+    uint32_t getFrameBytes() const { return getFramePixels() * 2; }
+    uint32_t getFrameRects() const { return frameRects; }
+    uint32_t getTotalPixels() const { return totalPixels; }
+    uint32_t getFrames() const { return frames; }
+
+    uint16_t at(int x, int y) const { return px[(size_t)y * width + x]; }
+
+    // What the panel shows at x, y, scrolled
+    uint16_t shown(int x, int y) const {
+        if (scrollH > 0 && y >= scrollTop && y < scrollTop + scrollH) {
+            y = scrollTop + (y - scrollTop + scrollOffset) % scrollH;
+        }
+        return at(x, y);
+    }
+
+    bool same(const UiFramebuffer& o) const { return px == o.px; }
+
+    // Pixels that differ from o
+    uint32_t diff(const UiFramebuffer& o) const {
+        uint32_t n = 0;
+        for (size_t i = 0; i < px.size(); i++) n += px[i] != o.px[i];
+        return n;
+    }
+};
+
+class UiFramebufferPanel : public UiPanel {
+private:
+    UiFramebuffer& fb;
+    bool swapped;
+    bool inFlight;
+    UiRect pending;
+    const uint16_t* pendingPx;
+    uint32_t pushes;
+    uint32_t pixels;
+    uint32_t overlaps;           // push() with the last one not waited for
+
+public:
+    UiFramebufferPanel(UiFramebuffer& target, bool swappedBytes)
+        : fb(target), swapped(swappedBytes), inFlight(false), pending{ 0, 0, 0, 0 }, pendingPx(nullptr),
+          pushes(0), pixels(0), overlaps(0) {}
+
+    void push(const UiRect& r, const uint16_t* px) override {
+        if (inFlight) overlaps++;
+        wait();
+        pending = r;
+        pendingPx = px;
+        inFlight = true;
+        pushes++;
+        pixels += (uint32_t)r.area();
+    }
+
+    void wait() override {
+        if (!inFlight) return;
+        fb.blit(pending, pendingPx, swapped);
+        inFlight = false;
+    }
+
+    void endFrame() override { wait(); }
+
+    uint32_t getPushes() const { return pushes; }
+    uint32_t getPixels() const { return pixels; }
+    uint32_t getOverlaps() const { return overlaps; }
+};
+
+#endif // UI_FRAMEBUFFER_H
@@ -0,0 +1,113 @@
+/*
+ * ============================================
+ * UI Pixels Benchmark (host)
+ * ============================================
+ *
+ * Runs the sketch's screens (volt_screens.h)
+ * through ui_scene.h into the counting host
+ * framebuffer, twice per scenario:
+ *
+ *   full    every change repaints the screen
+ *           (fillScreen() + redraw, the old way)
+ *   dirty   only the regions that changed
+ *
+ * Scenarios: the idle screen drawn once, a
+ * battery tick on it, a voice turn's status
+ * lines (idle, listening, thinking, reply,
+ * idle), a breathing cycle at 30 frames a
+ * second, and a joke.
+ *
+ * Reports pixels and bytes sent per frame and
+ * the SPI time that is at 40 MHz (16 bits a
+ * pixel, no overhead), per scenario.
+ *
+ * Build and run (from this directory):
+ *   cmake -S . -B build && cmake --build build
+ *   ./build/ui_scene_bench
+ *
+ * ============================================
+ */
+
+#include "ui_scene.h"
+#include "volt_screens.h"
+#include "ui_framebuffer.h"
+
+#include <stdio.h>
+#include <functional>
+#include <vector>
+
+static const int16_t W = 172;
+static const int16_t H = 320;
+static const double SPI_HZ = 40e6;
+
+typedef std::function<void(VoltScreens&)> Step;
+
+struct Scenario {
+    const char* name;
+    std::vector<Step> setup;     // Shown first, not counted
+    std::vector<Step> steps;
+};
+
+struct Result {
+    uint32_t frames;
+    uint64_t pixels;
+};
+
+static Result run(const Scenario& s, bool full) {
+    UiScene scene;
+    scene.begin(W, H);
+    scene.setFullRedraw(full);
+    UiFramebuffer fb(W, H);
+    VoltScreens screens(scene);
+    for (const Step& step : s.setup) {
+        step(screens);
+        scene.flush(fb);
+    }
+    Result r = { 0, 0 };
+    for (const Step& step : s.steps) {
+        step(screens);
+        scene.flush(fb);
+        r.frames++;
+        r.pixels += fb.getFramePixels();
+    }
+    return r;
+}
+
+static void report(const Scenario& s) {
+    Result full = run(s, true);
+    Result dirty = run(s, false);
+    double fullPx = (double)full.pixels / full.frames;
+    double dirtyPx = (double)dirty.pixels / dirty.frames;
+    printf("%-18s %6u %10.0f %8.1f %8.2f %10.0f %8.1f %8.2f %7.1fx\n", s.name, (unsigned)full.frames,
+           fullPx, fullPx * 2 / 1024, fullPx * 16 / SPI_HZ * 1000, dirtyPx, dirtyPx * 2 / 1024,
+           dirtyPx * 16 / SPI_HZ * 1000, dirtyPx > 0 ? fullPx / dirtyPx : 0.0);
+}
+
+int main() {
+    Step idle80 = [](VoltScreens& v) { v.idle(true, 80); };
+    Step idle79 = [](VoltScreens& v) { v.idle(true, 79); };
+    Step listening = [](VoltScreens& v) { v.status("Listening...", VoltScreens::toneColor(TONE_INFO)); };
+    Step thinking = [](VoltScreens& v) { v.status("Thinking...", VoltScreens::toneColor(TONE_INFO)); };
+    Step speaking = [](VoltScreens& v) { v.status("Speaking...", VoltScreens::toneColor(TONE_GOOD)); };
+    // In, hold, out: one frame every 33 ms
+    std::vector<Step> breathing;
+    for (int phase = 0; phase < 3; phase++) {
+        for (uint32_t ms = 0; ms < AppStateMachine::breathMs(phase); ms += 33) {
+            breathing.push_back([phase, ms](VoltScreens& v) { v.breathe(phase, ms); });
+        }
+    }
+    Step joke = [](VoltScreens& v) { v.joke(); };
+
+    std::vector<Scenario> scenarios = {
+        { "idle, first draw", {}, { idle80 } },
+        { "idle, battery", { idle80 }, { idle79, idle80, idle79, idle80 } },
+        { "voice turn", { idle80 }, { listening, thinking, speaking, idle80 } },
+        { "breathing cycle", { idle80 }, breathing },
+        { "joke", { idle80 }, { joke, idle80 } },
+    };
+
+    printf("%-18s %6s %10s %8s %8s %10s %8s %8s %8s\n", "scenario", "frames", "full px", "KB",
+           "SPI ms", "dirty px", "KB", "SPI ms", "less");
+    for (const Scenario& s : scenarios) report(s);
+    return 0;
+}
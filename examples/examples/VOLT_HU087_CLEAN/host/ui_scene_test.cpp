@@ -0,0 +1,299 @@
+/*
+ * ============================================
+ * UI Scene Tests (host)
+ * ============================================
+ *
+ * Runs ui_scene.h and the sketch's screens
+ * (volt_screens.h) into host/ui_framebuffer.h.
+ * After every flush the framebuffer must match
+ * a full redraw of the same screen, pixel for
+ * pixel, while sending only the dirty regions:
+ * a battery tick, status changes, breathing
+ * frames, and a long random walk through all
+ * the screens.
+ *
+ * Built and run by CMakeLists.txt (ctest).
+ *
+ * ============================================
+ */
+
+#include "ui_scene.h"
+#include "volt_screens.h"
+#include "ui_framebuffer.h"
+#include "test_check.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static const int16_t W = 172;
+static const int16_t H = 320;
+static const uint32_t SCREEN_PX = (uint32_t)W * H;
+
+// The screen the sketch would show, for the random walk and checks
+struct Shown {
+    int kind;
+    int a;
+    const char* text;
+};
+
+static void show(VoltScreens& screens, const Shown& s) {
+    switch (s.kind) {
+        case 0: screens.idle(s.a & 1, s.a >> 1); break;
+        case 1: screens.status(s.text, VoltScreens::toneColor(s.a)); break;
+        case 2: screens.joke(); break;
+        case 3: screens.breathe(s.a & 3, (uint32_t)s.a >> 2); break;
+        case 4: screens.greatJob(); break;
+        case 5: screens.loveMessage(); break;
+        case 6: screens.needWiFi(); break;
+        case 7: screens.setup(); break;
+        case 8: screens.splash(); break;
+        case 9: screens.reply(); break;
+        default: screens.welcome(); break;
+    }
+}
+
+// The same screen drawn from nothing
+static void fullRedraw(const Shown& s, UiFramebuffer& fb) {
+    UiScene scene;
+    scene.begin(W, H);
+    VoltScreens screens(scene);
+    show(screens, s);
+    scene.flush(fb);
+}
+
+// Shows s on the live scene; true if it matches a full redraw
+static bool showAndCompare(UiScene& scene, UiFramebuffer& fb, const Shown& s) {
+    VoltScreens screens(scene);
+    show(screens, s);
+    scene.flush(fb);
+    UiFramebuffer expected(W, H);
+    fullRedraw(s, expected);
+    uint32_t diff = fb.diff(expected);
+    if (diff) printf("  screen %d (%d): %u pixels differ\n", s.kind, s.a, (unsigned)diff);
+    return diff == 0;
+}
+
+// ============================================
+// RECTANGLES
+// ============================================
+
+static void testRects() {
+    UiRect a = { 0, 0, 10, 10 };
+    UiRect b = { 5, 5, 10, 10 };
+    UiRect c = { 10, 0, 5, 5 };              // Shares a's right edge
+    UiRect d = { 20, 20, 1, 1 };
+    CHECK(a.intersect(b).area() == 25);
+    CHECK(a.intersect(c).empty());
+    CHECK(a.touches(b) && a.touches(c) && !a.touches(d));
+    UiRect u = a.unite(d);
+    CHECK(u.x == 0 && u.y == 0 && u.w == 21 && u.h == 21);
+    CHECK(UiRect({ 0, 0, 0, 5 }).unite(d).area() == 1);
+}
+
+// ============================================
+// SCENE
+// ============================================
+
+static void testFirstFlushAndNoChange() {
+    UiScene scene;
+    scene.begin(W, H);
+    UiFramebuffer fb(W, H);
+    VoltScreens screens(scene);
+
+    screens.idle(true, 80);
+    CHECK(scene.flush(fb) == SCREEN_PX);     // Nothing known yet
+    CHECK(fb.getFramePixels() > SCREEN_PX);  // Plus the text
+    CHECK(scene.getWidgetCount() == 9);
+
+    // The same again: nothing sent
+    screens.idle(true, 80);
+    CHECK(scene.getDirtyCount() == 0);
+    CHECK(scene.flush(fb) == 0);
+    CHECK(fb.getFramePixels() == 0);
+
+    // Something else drew over it
+    scene.invalidate();
+    screens.idle(true, 80);
+    CHECK(scene.flush(fb) == SCREEN_PX);
+}
+
+static void testBatteryTick() {
+    UiScene scene;
+    scene.begin(W, H);
+    UiFramebuffer fb(W, H);
+    CHECK(showAndCompare(scene, fb, { 0, 1 | (80 << 1), nullptr }));
+
+    // "Battery: 80%" -> "Battery: 79%": one line, same width
+    CHECK(showAndCompare(scene, fb, { 0, 1 | (79 << 1), nullptr }));
+    CHECK(scene.getLastArea() == 12 * 6 * 8);
+    CHECK(fb.getFramePixels() < 1000);
+
+    // Low: same text length, new color, and the low battery icon
+    CHECK(showAndCompare(scene, fb, { 0, 1 | (19 << 1), nullptr }));
+    CHECK(scene.getLastArea() == 12 * 6 * 8 + ICON_BATTERY_LOW.w * ICON_BATTERY_LOW.h);
+
+    // Offline: the status line and the hint under it
+    CHECK(showAndCompare(scene, fb, { 0, 0 | (19 << 1), nullptr }));
+    CHECK(scene.getLastArea() < 2500);
+}
+
+static void testStatusTransitions() {
+    UiScene scene;
+    scene.begin(W, H);
+    UiFramebuffer fb(W, H);
+    CHECK(showAndCompare(scene, fb, { 0, 1 | (80 << 1), nullptr }));
+    CHECK(showAndCompare(scene, fb, { 1, TONE_INFO, "Listening..." }));
+    uint32_t toListening = scene.getLastArea();
+    CHECK(toListening < SCREEN_PX / 2);
+    CHECK(showAndCompare(scene, fb, { 1, TONE_INFO, "Thinking..." }));
+    CHECK(scene.getLastArea() == 12 * 12 * 16);   // Just the old line's cells
+    CHECK(showAndCompare(scene, fb, { 1, TONE_ERROR, "No answer" }));
+    CHECK(showAndCompare(scene, fb, { 0, 1 | (80 << 1), nullptr }));
+}
+
+// Breathing phase and ms into it, as Shown::a
+static int breath(int phase, uint32_t ms) { return phase | (int)(ms << 2); }
+
+static void testBreathing() {
+    UiScene scene;
+    scene.begin(W, H);
+    UiFramebuffer fb(W, H);
+    CHECK(showAndCompare(scene, fb, { 3, breath(0, 0), nullptr }));
+
+    // Halfway in: the circle's box, background and circle
+    int16_t r = VoltScreens::breathRadius(0, 2000);
+    CHECK(r == (VoltScreens::BREATH_MIN_R + VoltScreens::BREATH_MAX_R) / 2);
+    CHECK(showAndCompare(scene, fb, { 3, breath(0, 2000), nullptr }));
+    CHECK(scene.getLastArea() == 2u * (2 * r + 1) * (2 * r + 1));
+
+    // Most frames move the edge by a pixel or not at all
+    CHECK(showAndCompare(scene, fb, { 3, breath(0, 2010), nullptr }));
+    CHECK(scene.getLastArea() == 0);
+    CHECK(VoltScreens::breathRadius(0, 2033) - r <= 1);
+
+    // Full size at the end of the phase and through the hold
+    CHECK(VoltScreens::breathRadius(0, 4000) == VoltScreens::BREATH_MAX_R);
+    CHECK(VoltScreens::breathRadius(0, 9000) == VoltScreens::BREATH_MAX_R);
+    CHECK(VoltScreens::breathRadius(1, 0) == VoltScreens::BREATH_MAX_R);
+    CHECK(VoltScreens::breathRadius(2, 6000) == VoltScreens::BREATH_MIN_R);
+    CHECK(VoltScreens::breathRadius(2, 3000) < VoltScreens::BREATH_MAX_R);
+
+    // Into the hold: a new color and word, the rest stays
+    CHECK(showAndCompare(scene, fb, { 3, breath(0, 4000), nullptr }));
+    CHECK(showAndCompare(scene, fb, { 3, breath(1, 0), nullptr }));
+    CHECK(scene.getLastArea() < SCREEN_PX);          // Circle box and word only
+    CHECK(showAndCompare(scene, fb, { 3, breath(2, 3000), nullptr }));
+    CHECK(showAndCompare(scene, fb, { 3, breath(2, 3000), nullptr }));
+    CHECK(scene.getLastArea() == 0);
+}
+
+static void testWrapAndLimits() {
+    UiScene scene;
+    scene.begin(W, H);
+    UiFramebuffer fb(W, H);
+
+    // 40 characters at 6 px in 167 px: 27 a line, so two lines
+    scene.compose(UI_BLACK);
+    scene.text(5, 40, 1, UI_YELLOW, "Why did the cookie go to the doctor? Hmm");
+    scene.flush(fb);
+    scene.compose(UI_BLACK);
+    scene.text(5, 40, 1, UI_YELLOW, "");
+    scene.flush(fb);
+    CHECK(scene.getLastArea() == 27 * 6 * 16);
+
+    // Explicit line breaks and a narrow wrap
+    scene.compose(UI_BLACK);
+    scene.text(0, 0, 2, UI_WHITE, "ab\ncdef", 24);   // 2 chars a line at size 2
+    scene.flush(fb);
+    scene.compose(UI_BLACK);
+    scene.flush(fb);                                 // Gone
+    CHECK(scene.getLastArea() == 24 * 48);           // 3 lines of 2
+
+    // Too many widgets: the rest are dropped and counted
+    scene.compose(UI_BLACK);
+    for (int i = 0; i < UiScene::MAX_WIDGETS + 3; i++) scene.rect(i * 10, 0, 5, 5, UI_RED);
+    scene.flush(fb);
+    CHECK(scene.getWidgetCount() == UiScene::MAX_WIDGETS);
+    CHECK(scene.getDropped() == 3);
+}
+
+static void testDirtyMerging() {
+    UiScene scene;
+    scene.begin(W, H);
+    UiFramebuffer fb(W, H);
+    UiFramebuffer expected(W, H);
+
+    // Ten scattered squares change at once: more than MAX_DIRTY
+    // regions, merged where it costs least
+    for (int pass = 0; pass < 2; pass++) {
+        scene.compose(UI_BLACK);
+        for (int i = 0; i < 10; i++) {
+            scene.rect((int16_t)(i * 17), (int16_t)(i * 31), 8, 8, pass ? UI_GREEN : UI_RED);
+        }
+        if (pass) {
+            CHECK(scene.getDirtyCount() <= UiScene::MAX_DIRTY);
+            CHECK(scene.getDirtyCount() > 1);
+        }
+        scene.flush(fb);
+    }
+    UiScene full;
+    full.begin(W, H);
+    full.compose(UI_BLACK);
+    for (int i = 0; i < 10; i++) full.rect((int16_t)(i * 17), (int16_t)(i * 31), 8, 8, UI_GREEN);
+    full.flush(expected);
+    CHECK(fb.same(expected));
+    CHECK(scene.getLastArea() < SCREEN_PX);
+
+    // Dirty regions never overlap: each pixel sent once
+    scene.compose(UI_BLACK);
+    for (int i = 0; i < 10; i++) {
+        scene.rect((int16_t)(i * 17 + 2), (int16_t)(i * 31 + 2), 8, 8, UI_RED);
+    }
+    int n = scene.getDirtyCount();
+    bool disjoint = true;
+    for (int i = 0; i < n; i++) {
+        for (int j = i + 1; j < n; j++) {
+            if (!scene.getDirty(i).intersect(scene.getDirty(j)).empty()) disjoint = false;
+        }
+    }
+    CHECK(disjoint);
+    scene.flush(fb);
+}
+
+// Every screen the sketch has, in a random order, with random
+// battery levels and status lines
+static void testRandomWalk() {
+    static const char* const texts[] = {
+        "Listening...", "Thinking...", "Oops! Try again", "Why do bees hum? They forgot the words!",
+        "Love you, buddy", ""
+    };
+    srand(43);
+    UiScene scene;
+    scene.begin(W, H);
+    UiFramebuffer fb(W, H);
+    int mismatches = 0;
+    uint32_t sent = 0, steps = 400;
+    for (uint32_t i = 0; i < steps; i++) {
+        Shown s = { rand() % 11, 0, texts[rand() % 6] };
+        if (s.kind == 0) s.a = (rand() & 1) | ((rand() % 101) << 1);
+        if (s.kind == 1) s.a = rand() % 6;
+        if (s.kind == 3) s.a = breath(rand() % 3, (uint32_t)(rand() % 7000));
+        if (!showAndCompare(scene, fb, s)) mismatches++;
+        sent += fb.getFramePixels();
+    }
+    CHECK(mismatches == 0);
+    CHECK(sent < steps * SCREEN_PX);
+}
+
+int main() {
+    testRects();
+    testFirstFlushAndNoChange();
+    testBatteryTick();
+    testStatusTransitions();
+    testBreathing();
+    testWrapAndLimits();
+    testDirtyMerging();
+    testRandomWalk();
+
+    return testSummary();
+}
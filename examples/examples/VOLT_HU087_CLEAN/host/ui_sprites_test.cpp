@@ -0,0 +1,275 @@
+/*
+ * ============================================
+ * UI Sprite and Frame Pacer Tests (host)
+ * ============================================
+ *
+ * Runs ui_sprites.h and frame_pacer.h on the
+ * native HAL. The sprite renderer draws the
+ * sketch's screens (volt_screens.h) in tiles
+ * into a framebuffer panel that, like DMA,
+ * reads a buffer only when the push completes.
+ * After every flush the panel must match the
+ * scene drawn straight onto a framebuffer,
+ * pixel for pixel, with no buffer reused while
+ * in flight. Also: tile sizes, buffer placement
+ * from the pools, and the frame grid.
+ *
+ * Built and run by CMakeLists.txt (ctest).
+ *
+ * ============================================
+ */
+
+#include "volt_hal.h"
+#include "ui_sprites.h"
+#include "volt_screens.h"
+#include "frame_pacer.h"
+#include "ui_framebuffer.h"
+#include "test_check.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+static const int16_t W = 172;
+static const int16_t H = 320;
+
+static void resetHeaps() {
+    resetHal();
+    nativeHeapInternal().resize(128 * 1024);
+    nativeHeapPsram().resize(512 * 1024);
+}
+
+// Records which buffer each push came from
+class RecordingPanel : public UiFramebufferPanel {
+public:
+    std::vector<const uint16_t*> from;
+    std::vector<UiRect> tiles;
+
+    RecordingPanel(UiFramebuffer& fb, bool swapped) : UiFramebufferPanel(fb, swapped) {}
+
+    void push(const UiRect& r, const uint16_t* px) override {
+        from.push_back(px);
+        tiles.push_back(r);
+        UiFramebufferPanel::push(r, px);
+    }
+};
+
+// ============================================
+// CANVAS
+// ============================================
+
+static void testCanvas() {
+    uint16_t buf[64];
+    UiCanvas c;
+    c.attach(buf, 64, UiFramebuffer::glyph, true);
+    CHECK(!c.place({ 0, 0, 10, 10 }));       // 100 > 64
+    CHECK(c.place({ 10, 20, 8, 8 }));
+
+    // Screen coordinates, clipped to where the buffer sits
+    c.fillRect({ 0, 0, 100, 100 }, UI_BLACK);
+    c.fillRect({ 14, 24, 10, 10 }, UI_RED);
+    CHECK(c.getWritten() == 64 + 16);
+    CHECK(buf[0] == 0);
+    CHECK(buf[4 * 8 + 4] == 0x00F8);         // Swapped: high byte first
+    CHECK(buf[7 * 8 + 7] == 0x00F8);
+    CHECK(buf[3 * 8 + 7] == 0);
+
+    // A circle is symmetric and fills its center row edge to edge
+    uint16_t big[21 * 21];
+    c.attach(big, 21 * 21, UiFramebuffer::glyph, false);
+    c.place({ 0, 0, 21, 21 });
+    c.fillRect({ 0, 0, 21, 21 }, UI_BLACK);
+    c.fillCircle(10, 10, 10, UI_GREEN, { 0, 0, 21, 21 });
+    CHECK(big[10 * 21 + 0] == UI_GREEN && big[10 * 21 + 20] == UI_GREEN);
+    CHECK(big[0] == UI_BLACK && big[20 * 21 + 20] == UI_BLACK);
+    bool symmetric = true;
+    for (int y = 0; y < 21; y++) {
+        for (int x = 0; x < 21; x++) symmetric &= big[y * 21 + x] == big[(20 - y) * 21 + (20 - x)];
+    }
+    CHECK(symmetric);
+}
+
+// ============================================
+// RENDERER
+// ============================================
+
+// The sketch's screens in a random order, breathing frames among them
+static void showRandom(VoltScreens& screens, int kind, int a) {
+    switch (kind) {
+        case 0: screens.idle(a & 1, a % 101); break;
+        case 1: screens.status("Thinking...", VoltScreens::toneColor(a % 6)); break;
+        case 2: screens.joke(); break;
+        case 3: screens.greatJob(); break;
+        case 4: screens.loveMessage(); break;
+        default: screens.breathe(a % 3, (uint32_t)(a % 7000)); break;
+    }
+}
+
+// Sprites on one scene, a direct flush on another; both must
+// look the same after every screen
+static void checkMatches(uint32_t capacityPx, bool swapped, int steps, unsigned seed) {
+    resetHeaps();
+    MemPools pools;
+    UiSpriteRenderer sprites;
+    CHECK(sprites.begin(pools, capacityPx, UiFramebuffer::glyph, swapped));
+    UiScene viaSprites, direct;
+    viaSprites.begin(W, H);
+    direct.begin(W, H);
+    UiFramebuffer screen(W, H), expected(W, H);
+    RecordingPanel panel(screen, swapped);
+    VoltScreens a(viaSprites), b(direct);
+
+    srand(seed);
+    int mismatches = 0;
+    bool tilesFit = true;
+    for (int i = 0; i < steps; i++) {
+        int kind = rand() % 8, arg = rand();
+        showRandom(a, kind, arg);
+        showRandom(b, kind, arg);
+        uint32_t area = sprites.flush(viaSprites, panel);
+        CHECK(area == direct.flush(expected));
+        if (!screen.same(expected)) mismatches++;
+    }
+    for (const UiRect& t : panel.tiles) tilesFit &= (uint32_t)t.area() <= capacityPx;
+    bool alternates = true;
+    for (size_t i = 1; i < panel.from.size(); i++) alternates &= panel.from[i] != panel.from[i - 1];
+
+    CHECK(mismatches == 0);
+    CHECK(tilesFit);
+    CHECK(alternates);
+    CHECK(panel.getOverlaps() == 0);
+    CHECK(sprites.getTiles() == panel.getPushes());
+    CHECK(sprites.getPixels() == panel.getPixels());
+}
+
+static void testRendererMatchesDirect() {
+    checkMatches((uint32_t)W * 40, true, 200, 46);    // The sketch's size
+    checkMatches((uint32_t)W * 3, false, 100, 7);     // Many thin tiles
+    checkMatches(100, true, 60, 3);                   // Narrower than the screen
+}
+
+static void testTiles() {
+    resetHeaps();
+    MemPools pools;
+    UiSpriteRenderer sprites;
+    CHECK(sprites.begin(pools, (uint32_t)W * 40, UiFramebuffer::glyph, true));
+    UiScene scene;
+    scene.begin(W, H);
+    UiFramebuffer screen(W, H);
+    RecordingPanel panel(screen, true);
+    VoltScreens screens(scene);
+
+    // First frame: the whole screen in 8 full-width tiles of 40 rows
+    screens.breathe(0, 0);
+    sprites.flush(scene, panel);
+    CHECK(panel.tiles.size() == 8);
+    CHECK(panel.tiles.size() == 8 && panel.tiles[7].y == 280 && panel.tiles[7].h == 40);
+
+    // A growing circle: only its box, in tiles as wide as the box
+    panel.tiles.clear();
+    screens.breathe(0, 2000);
+    sprites.flush(scene, panel);
+    int16_t side = (int16_t)(2 * VoltScreens::breathRadius(0, 2000) + 1);
+    int rows = 0;
+    bool boxWide = true;
+    for (const UiRect& t : panel.tiles) {
+        boxWide &= t.w == side;
+        rows += t.h;
+    }
+    CHECK(boxWide);
+    CHECK(rows == side);
+
+    // Nothing changed: nothing pushed
+    panel.tiles.clear();
+    screens.breathe(0, 2000);
+    CHECK(sprites.flush(scene, panel) == 0);
+    CHECK(panel.tiles.empty());
+    CHECK(sprites.getFrames() == 3);
+}
+
+static void testPlacement() {
+    resetHeaps();
+    {
+        MemPools pools;
+        UiSpriteRenderer sprites;
+        CHECK(!sprites.isReady());
+        CHECK(sprites.begin(pools, (uint32_t)W * 40, UiFramebuffer::glyph, true));
+        CHECK(sprites.isReady());
+        CHECK(sprites.isDmaCapable());
+        CHECK(pools.getRegionUsed(MEM_REGION_INTERNAL) == 2u * W * 40 * 2);
+    }
+
+    // Short of internal RAM: PSRAM, and pushes that block
+    resetHeaps();
+    {
+        MemPools pools;
+        pools.setBudget(MEM_REGION_INTERNAL, 16 * 1024);
+        UiSpriteRenderer sprites;
+        CHECK(sprites.begin(pools, (uint32_t)W * 40, UiFramebuffer::glyph, true));
+        CHECK(!sprites.isDmaCapable());
+        CHECK(sprites.getPlacedCaps() == MEM_CAP_SPIRAM);
+    }
+
+    // Neither
+    resetHeaps();
+    {
+        MemPools pools;
+        pools.setBudget(MEM_REGION_INTERNAL, 0);
+        pools.setBudget(MEM_REGION_SPIRAM, 0);
+        UiSpriteRenderer sprites;
+        CHECK(!sprites.begin(pools, (uint32_t)W * 40, UiFramebuffer::glyph, true));
+        CHECK(!sprites.isReady());
+    }
+}
+
+// ============================================
+// FRAME PACER
+// ============================================
+
+static void testPacer() {
+    FramePacer pacer;
+    CHECK(!pacer.due(0));
+    CHECK(pacer.waitMs(0) == HAL_WAIT_FOREVER);
+
+    pacer.start(33, 1000);
+    CHECK(pacer.due(1000));
+    pacer.frameDone(4000, 1004);
+    CHECK(!pacer.due(1004));
+    CHECK(pacer.waitMs(1004) == 29);
+    CHECK(pacer.due(1033));
+
+    // A late wakeup keeps the grid
+    pacer.frameDone(5000, 1045);
+    CHECK(pacer.getNextAt() == 1066);
+    CHECK(pacer.getSkipped() == 0);
+
+    // A frame that takes 80 ms: two slots passed, skipped
+    pacer.frameDone(80000, 1146);
+    CHECK(pacer.getNextAt() == 1165);
+    CHECK(pacer.getSkipped() == 2);
+    CHECK(pacer.getLate() == 1);
+    CHECK(pacer.getWorstUs() == 80000);
+
+    // Ending exactly on a slot still draws it
+    pacer.frameDone(33000, 1198);
+    CHECK(pacer.getNextAt() == 1198);
+    CHECK(pacer.getSkipped() == 2);
+    CHECK(pacer.getFrames() == 4);
+    CHECK(pacer.getFrameTimes().getCount() == 4);
+
+    pacer.stop();
+    CHECK(!pacer.due(5000));
+    MetricsRegistry registry;
+    pacer.registerMetrics(registry);
+    CHECK(registry.getCount() == 2);
+}
+
+int main() {
+    testCanvas();
+    testRendererMatchesDirect();
+    testTiles();
+    testPlacement();
+    testPacer();
+
+    return testSummary();
+}
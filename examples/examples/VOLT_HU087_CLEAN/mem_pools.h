@@ -0,0 +1,337 @@
+/*
+ * ============================================
+ * Memory Pools - Capability-Aware Placement
+ * ============================================
+ *
+ * Handles:
+ * - Fixed-size block buckets per buffer class
+ * - Placement by capability (DMA, internal, PSRAM)
+ * - Fallback placement when PSRAM is missing
+ * - Per-bucket high-water marks and region budgets
+ *
+ * All blocks are reserved once at startup, so the
+ * big audio and network buffers never come from
+ * the general heap after boot.
+ *
+ * Blocks come from the HAL heap through the heap
+ * profiler (heap_profiler.h), under the bucket's
+ * name. Off-target that is the modeled heap of
+ * host/native_heap.h, and the region budgets
+ * emulate the S3's limits.
+ *
+ * ============================================
+ */
+
+#ifndef MEM_POOLS_H
+#define MEM_POOLS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "heap_profiler.h"
+#include "board_traits.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#define POOL_LOG(...) Serial.printf(__VA_ARGS__)
+#else
+#include <stdio.h>
+#define POOL_LOG(...) printf(__VA_ARGS__)
+#endif
+
+// ============================================
+// CAPABILITIES
+// ============================================
+
+enum MemCap : uint8_t {
+    MEM_CAP_NONE     = 0x00,
+    MEM_CAP_INTERNAL = HAL_HEAP_INTERNAL,   // On-chip SRAM
+    MEM_CAP_DMA      = HAL_HEAP_DMA,        // DMA-capable (always internal)
+    MEM_CAP_SPIRAM   = HAL_HEAP_SPIRAM      // External PSRAM
+};
+
+// Budget regions: DMA blocks are accounted as internal
+enum MemRegion : uint8_t {
+    MEM_REGION_INTERNAL = 0,
+    MEM_REGION_SPIRAM = 1,
+    MEM_REGION_COUNT = 2
+};
+
+struct PoolBucketConfig {
+    const char* name;
+    size_t blockSize;
+    uint8_t blockCount;
+    uint8_t caps;          // Preferred placement
+    uint8_t fallbackCaps;  // Used if preferred fails (MEM_CAP_NONE = required)
+};
+
+struct PoolBucketStats {
+    const char* name;
+    size_t blockSize;
+    uint8_t blockCount;
+    uint8_t placedCaps;    // Where the blocks actually ended up
+    uint8_t inUse;
+    uint8_t highWater;
+    uint32_t allocs;
+    uint32_t failures;
+};
+
+// ============================================
+// POOL ALLOCATOR
+// ============================================
+
+class MemPools {
+public:
+    static const int MAX_BUCKETS = 8;
+    static const int MAX_BLOCKS = 16;
+
+private:
+    struct Bucket {
+        PoolBucketConfig cfg;
+        uint8_t* storage;
+        uint8_t placedCaps;
+        uint16_t freeMask;   // Bit set = block free
+        uint8_t inUse;
+        uint8_t highWater;
+        uint32_t allocs;
+        uint32_t failures;
+    };
+
+    Bucket buckets[MAX_BUCKETS];
+    int bucketCount;
+    size_t regionUsed[MEM_REGION_COUNT];
+    size_t regionBudget[MEM_REGION_COUNT];
+
+    static MemRegion regionFor(uint8_t caps) {
+        return (caps & MEM_CAP_SPIRAM) ? MEM_REGION_SPIRAM : MEM_REGION_INTERNAL;
+    }
+
+    void* capsAlloc(size_t size, uint8_t caps, const char* name) {
+        if (caps == MEM_CAP_NONE) return nullptr;
+        MemRegion region = regionFor(caps);
+        if (size > regionBudget[region] - regionUsed[region]) {
+            return nullptr;
+        }
+
+        void* p = voltHeapAlloc(size, caps, name);
+        if (p) {
+            regionUsed[region] += size;
+        }
+        return p;
+    }
+
+    void* takeSlot(Bucket& b) {
+        int slot = 0;
+        while (!(b.freeMask & (1u << slot))) slot++;
+        b.freeMask &= (uint16_t)~(1u << slot);
+        b.inUse++;
+        b.allocs++;
+        if (b.inUse > b.highWater) b.highWater = b.inUse;
+        return b.storage + (size_t)slot * b.cfg.blockSize;
+    }
+
+    Bucket* findOwner(const void* p) {
+        const uint8_t* addr = (const uint8_t*)p;
+        for (int i = 0; i < bucketCount; i++) {
+            Bucket& b = buckets[i];
+            size_t span = b.cfg.blockSize * b.cfg.blockCount;
+            if (b.storage && addr >= b.storage && addr < b.storage + span) {
+                return &b;
+            }
+        }
+        return nullptr;
+    }
+
+public:
+    MemPools() : bucketCount(0) {
+        for (int r = 0; r < MEM_REGION_COUNT; r++) {
+            regionUsed[r] = 0;
+            regionBudget[r] = (size_t)-1;
+        }
+    }
+
+    // Cap how much of a region the pools may reserve. On host this
+    // emulates the S3 (e.g. budget SPIRAM at 0 for a board without PSRAM).
+    void setBudget(MemRegion region, size_t bytes) {
+        regionBudget[region] = bytes;
+    }
+
+    // Reserve one bucket. Returns false if neither placement fits.
+    // A bucket with no blocks belongs to a feature that is turned off.
+    bool addBucket(const PoolBucketConfig& cfg) {
+        if (cfg.blockCount == 0) {
+            return true;
+        }
+        if (bucketCount >= MAX_BUCKETS ||
+            cfg.blockCount > MAX_BLOCKS || cfg.blockSize == 0) {
+            return false;
+        }
+
+        // Keep every block 4-byte aligned for DMA and int16 samples
+        size_t blockSize = (cfg.blockSize + 3) & ~(size_t)3;
+        size_t total = blockSize * cfg.blockCount;
+
+        uint8_t placed = cfg.caps;
+        uint8_t* storage = (uint8_t*)capsAlloc(total, cfg.caps, cfg.name);
+        if (!storage && cfg.fallbackCaps != MEM_CAP_NONE) {
+            placed = cfg.fallbackCaps;
+            storage = (uint8_t*)capsAlloc(total, cfg.fallbackCaps, cfg.name);
+            if (storage) {
+                POOL_LOG("Pools: '%s' fell back to %s\n", cfg.name, capsName(placed));
+            }
+        }
+
+        if (!storage) {
+            POOL_LOG("Pools: Failed to reserve '%s' (%u bytes)\n", cfg.name, (unsigned)total);
+            return false;
+        }
+
+        if (placed & MEM_CAP_DMA) {
+            placed |= MEM_CAP_INTERNAL;
+        }
+
+        Bucket& b = buckets[bucketCount++];
+        b.cfg = cfg;
+        b.cfg.blockSize = blockSize;
+        b.storage = storage;
+        b.placedCaps = placed;
+        b.freeMask = (uint16_t)((1u << cfg.blockCount) - 1);
+        b.inUse = 0;
+        b.highWater = 0;
+        b.allocs = 0;
+        b.failures = 0;
+        return true;
+    }
+
+    bool begin(const PoolBucketConfig* layout, int count) {
+        bool ok = true;
+        for (int i = 0; i < count; i++) {
+            ok = addBucket(layout[i]) && ok;
+        }
+        return ok;
+    }
+
+    // Smallest free block of at least size bytes whose placement
+    // satisfies every bit in caps (MEM_CAP_NONE = anywhere).
+    void* alloc(size_t size, uint8_t caps = MEM_CAP_NONE) {
+        Bucket* best = nullptr;
+        Bucket* candidate = nullptr;
+        for (int i = 0; i < bucketCount; i++) {
+            Bucket& b = buckets[i];
+            if (b.cfg.blockSize < size) continue;
+            if ((b.placedCaps & caps) != caps) continue;
+            if (!candidate || b.cfg.blockSize < candidate->cfg.blockSize) {
+                candidate = &b;
+            }
+            if (b.freeMask == 0) continue;
+            if (!best || b.cfg.blockSize < best->cfg.blockSize) {
+                best = &b;
+            }
+        }
+
+        if (!best) {
+            if (candidate) candidate->failures++;
+            return nullptr;
+        }
+
+        return takeSlot(*best);
+    }
+
+    // Allocate from a bucket by name (e.g. "capture")
+    void* allocFrom(const char* name) {
+        for (int i = 0; i < bucketCount; i++) {
+            Bucket& b = buckets[i];
+            if (strcmp(b.cfg.name, name) != 0) continue;
+            if (b.freeMask == 0) {
+                b.failures++;
+                return nullptr;
+            }
+            return takeSlot(b);
+        }
+        return nullptr;
+    }
+
+    void free(void* p) {
+        if (!p) return;
+        Bucket* b = findOwner(p);
+        if (!b) {
+            POOL_LOG("Pools: free() of foreign pointer %p\n", p);
+            return;
+        }
+        size_t slot = ((uint8_t*)p - b->storage) / b->cfg.blockSize;
+        uint16_t bit = (uint16_t)(1u << slot);
+        if (b->freeMask & bit) {
+            POOL_LOG("Pools: double free in '%s'\n", b->cfg.name);
+            return;
+        }
+        b->freeMask |= bit;
+        b->inUse--;
+    }
+
+    bool owns(const void* p) {
+        return findOwner(p) != nullptr;
+    }
+
+    int getBucketCount() const {
+        return bucketCount;
+    }
+
+    PoolBucketStats getBucketStats(int index) const {
+        PoolBucketStats s;
+        memset(&s, 0, sizeof(s));
+        if (index < 0 || index >= bucketCount) return s;
+        const Bucket& b = buckets[index];
+        s.name = b.cfg.name;
+        s.blockSize = b.cfg.blockSize;
+        s.blockCount = b.cfg.blockCount;
+        s.placedCaps = b.placedCaps;
+        s.inUse = b.inUse;
+        s.highWater = b.highWater;
+        s.allocs = b.allocs;
+        s.failures = b.failures;
+        return s;
+    }
+
+    size_t getRegionUsed(MemRegion region) const {
+        return regionUsed[region];
+    }
+
+    size_t getRegionBudget(MemRegion region) const {
+        return regionBudget[region];
+    }
+
+    static const char* capsName(uint8_t caps) {
+        if (caps & MEM_CAP_SPIRAM) return "PSRAM";
+        if (caps & MEM_CAP_DMA) return "DMA";
+        if (caps & MEM_CAP_INTERNAL) return "internal";
+        return "none";
+    }
+
+    void printReport() {
+        POOL_LOG("=== Memory Pools ===\n");
+        for (int i = 0; i < bucketCount; i++) {
+            const Bucket& b = buckets[i];
+            POOL_LOG("  %-8s %6u x %2u  %-8s  in use %u, peak %u, fails %u\n",
+                b.cfg.name, (unsigned)b.cfg.blockSize, b.cfg.blockCount,
+                capsName(b.placedCaps), b.inUse, b.highWater, (unsigned)b.failures);
+        }
+        POOL_LOG("  Reserved: internal %u bytes, PSRAM %u bytes\n",
+            (unsigned)regionUsed[MEM_REGION_INTERNAL], (unsigned)regionUsed[MEM_REGION_SPIRAM]);
+    }
+};
+
+// Shared instance for every module in the sketch; on a board
+// without PSRAM nothing is placed there
+inline MemPools& memPools() {
+    struct BoardPools : MemPools {
+        BoardPools() {
+            if (!Board::PSRAM) setBudget(MEM_REGION_SPIRAM, 0);
+        }
+    };
+    static BoardPools pools;
+    return pools;
+}
+
+#endif // MEM_POOLS_H
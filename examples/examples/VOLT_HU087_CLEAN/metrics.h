@@ -0,0 +1,374 @@
+/*
+ * ============================================
+ * Metrics - Counters, Gauges and Histograms
+ * ============================================
+ *
+ * Handles:
+ * - Counters, gauges (set, or read at scrape
+ *   time) and fixed-bucket histograms that any
+ *   module can declare and register
+ * - HTTP status counters per endpoint (200,
+ *   401, 429, other 4xx, 5xx, no response)
+ * - Collectors: functions that append their
+ *   own lines (task_stats.h)
+ * - The Prometheus text exposition format,
+ *   written straight to a Print (GET
+ *   /api/metrics), one family per name
+ *
+ * Updates are single atomic adds on 32-bit
+ * values, safe from any task or core with no
+ * lock; a histogram's sum is 64-bit, which the
+ * ESP32 does in a short critical section. A
+ * scrape reads each value once: a histogram's
+ * _count is the sum of the buckets it printed,
+ * so the buckets and the count always agree.
+ *
+ * Nothing allocates: the registry is a fixed
+ * table, label sets are literals (or built once
+ * into the metric), numbers are formatted on
+ * the stack.
+ *
+ * ============================================
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include "volt_hal.h"
+
+enum MetricType {
+    METRIC_COUNTER = 0,
+    METRIC_GAUGE,
+    METRIC_HISTOGRAM
+};
+
+// ============================================
+// FORMATTING
+// ============================================
+
+inline void metricsPrintU64(Print& out, uint64_t v) {
+    char buf[24];
+    int n = snprintf(buf, sizeof(buf), "%llu", (unsigned long long)v);
+    out.write((const uint8_t*)buf, (size_t)n);
+}
+
+inline void metricsPrintI64(Print& out, int64_t v) {
+    char buf[24];
+    int n = snprintf(buf, sizeof(buf), "%lld", (long long)v);
+    out.write((const uint8_t*)buf, (size_t)n);
+}
+
+// name{labels,extra} with either part optional
+inline void metricsPrintName(Print& out, const char* name, const char* suffix,
+                             const char* labels, const char* extra = nullptr) {
+    out.print(name);
+    if (suffix) out.print(suffix);
+    bool hasLabels = labels && *labels;
+    if (!hasLabels && !extra) return;
+    out.print("{");
+    if (hasLabels) out.print(labels);
+    if (hasLabels && extra) out.print(",");
+    if (extra) out.print(extra);
+    out.print("}");
+}
+
+inline void metricsPrintHeader(Print& out, const char* name, const char* type, const char* help) {
+    out.print("# HELP ");
+    out.print(name);
+    out.print(" ");
+    out.print(help);
+    out.print("\n# TYPE ");
+    out.print(name);
+    out.print(" ");
+    out.print(type);
+    out.print("\n");
+}
+
+// ============================================
+// METRICS
+// ============================================
+
+class Metric {
+public:
+    const char* const name;
+    const char* const help;
+    const MetricType type;
+
+    Metric(const char* n, const char* h, MetricType t, const char* l)
+        : name(n), help(h), type(t), labels(l) {}
+    virtual ~Metric() {}
+
+    const char* getLabels() const { return labels ? labels : ""; }
+
+    // The sample lines, without HELP / TYPE
+    virtual void write(Print& out) const = 0;
+
+protected:
+    const char* labels;          // e.g. endpoint="chat" (no braces)
+};
+
+class MetricCounter : public Metric {
+private:
+    std::atomic<uint32_t> value;
+
+public:
+    MetricCounter(const char* name, const char* help, const char* labels = nullptr)
+        : Metric(name, help, METRIC_COUNTER, labels), value(0) {}
+
+    void inc(uint32_t n = 1) { value.fetch_add(n, std::memory_order_relaxed); }
+    uint32_t get() const { return value.load(std::memory_order_relaxed); }
+    void reset() { value.store(0); }
+
+    void write(Print& out) const override {
+        metricsPrintName(out, name, nullptr, labels);
+        out.print(" ");
+        metricsPrintU64(out, get());
+        out.print("\n");
+    }
+};
+
+class MetricGauge : public Metric {
+public:
+    typedef int32_t (*ReadFn)();
+
+private:
+    std::atomic<int32_t> value;
+    ReadFn read;
+
+public:
+    MetricGauge(const char* name, const char* help, const char* labels = nullptr,
+                ReadFn readFn = nullptr)
+        : Metric(name, help, METRIC_GAUGE, labels), value(0), read(readFn) {}
+
+    void set(int32_t v) { value.store(v, std::memory_order_relaxed); }
+    void add(int32_t d) { value.fetch_add(d, std::memory_order_relaxed); }
+
+    // A gauge with a read function is sampled at scrape time
+    int32_t get() const { return read ? read() : value.load(std::memory_order_relaxed); }
+
+    void write(Print& out) const override {
+        metricsPrintName(out, name, nullptr, labels);
+        out.print(" ");
+        metricsPrintI64(out, get());
+        out.print("\n");
+    }
+};
+
+class MetricHistogram : public Metric {
+public:
+    static const int MAX_BUCKETS = 16;
+
+private:
+    const uint32_t* bounds;      // Upper bounds, ascending (le="...")
+    int boundCount;
+    std::atomic<uint32_t> buckets[MAX_BUCKETS + 1];   // Last one is +Inf
+    std::atomic<uint64_t> sum;
+
+public:
+    // bounds must outlive the histogram (a static array)
+    MetricHistogram(const char* name, const char* help, const uint32_t* upperBounds,
+                    int count, const char* labels = nullptr)
+        : Metric(name, help, METRIC_HISTOGRAM, labels), bounds(upperBounds),
+          boundCount(count > MAX_BUCKETS ? MAX_BUCKETS : count), sum(0) {
+        reset();
+    }
+
+    void observe(uint32_t v) {
+        int i = 0;
+        while (i < boundCount && v > bounds[i]) i++;
+        buckets[i].fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(v, std::memory_order_relaxed);
+    }
+
+    void reset() {
+        for (int i = 0; i <= MAX_BUCKETS; i++) buckets[i].store(0);
+        sum.store(0);
+    }
+
+    int getBoundCount() const { return boundCount; }
+    uint32_t getBucket(int i) const { return buckets[i].load(std::memory_order_relaxed); }
+    uint64_t getSum() const { return sum.load(std::memory_order_relaxed); }
+
+    uint32_t getCount() const {
+        uint32_t n = 0;
+        for (int i = 0; i <= boundCount; i++) n += getBucket(i);
+        return n;
+    }
+
+    void write(Print& out) const override {
+        char le[16];
+        uint64_t cumulative = 0;
+        for (int i = 0; i <= boundCount; i++) {
+            cumulative += getBucket(i);
+            if (i < boundCount) {
+                snprintf(le, sizeof(le), "le=\"%u\"", (unsigned)bounds[i]);
+            } else {
+                strcpy(le, "le=\"+Inf\"");
+            }
+            metricsPrintName(out, name, "_bucket", labels, le);
+            out.print(" ");
+            metricsPrintU64(out, cumulative);
+            out.print("\n");
+        }
+        metricsPrintName(out, name, "_sum", labels);
+        out.print(" ");
+        metricsPrintU64(out, getSum());
+        out.print("\n");
+        metricsPrintName(out, name, "_count", labels);
+        out.print(" ");
+        metricsPrintU64(out, cumulative);
+        out.print("\n");
+    }
+};
+
+// Responses of one endpoint by HTTP status: 200, 401 (bad key),
+// 429 (rate limit), other 4xx, 5xx, and none (no connection or
+// no status line: HTTPClient's negative codes)
+class MetricHttpCodes {
+public:
+    static const int CLASSES = 6;
+
+private:
+    char labels[CLASSES][48];    // Built before the counters that point at them
+    MetricCounter counters[CLASSES];
+
+    const char* label(int i, const char* endpoint) {
+        static const char* const codes[CLASSES] = { "200", "401", "429", "4xx", "5xx", "none" };
+        snprintf(labels[i], sizeof(labels[i]), "endpoint=\"%s\",code=\"%s\"", endpoint, codes[i]);
+        return labels[i];
+    }
+
+    static int classOf(int status) {
+        if (status == 200) return 0;
+        if (status == 401) return 1;
+        if (status == 429) return 2;
+        if (status >= 400 && status < 500) return 3;
+        if (status >= 500) return 4;
+        return status <= 0 ? 5 : 3;
+    }
+
+public:
+    // name must be a literal, endpoint short (labels are built here)
+    MetricHttpCodes(const char* name, const char* help, const char* endpoint)
+        : counters{ { name, help, label(0, endpoint) }, { name, help, label(1, endpoint) },
+                    { name, help, label(2, endpoint) }, { name, help, label(3, endpoint) },
+                    { name, help, label(4, endpoint) }, { name, help, label(5, endpoint) } } {}
+
+    // Any other 2xx/3xx counts with "4xx": the engine only accepts 200
+    void count(int status) { counters[classOf(status)].inc(); }
+
+    uint32_t get(int status) const { return counters[classOf(status)].get(); }
+    MetricCounter& counter(int i) { return counters[i]; }
+};
+
+// ============================================
+// REGISTRY
+// ============================================
+
+class MetricsRegistry {
+public:
+    static const int MAX_METRICS = 64;
+    static const int MAX_COLLECTORS = 4;
+
+    typedef void (*CollectorFn)(Print& out);
+
+private:
+    Metric* metrics[MAX_METRICS];
+    std::atomic<int> count;
+    CollectorFn collectors[MAX_COLLECTORS];
+    int collectorCount;
+
+    static const char* typeName(MetricType t) {
+        switch (t) {
+            case METRIC_COUNTER: return "counter";
+            case METRIC_GAUGE: return "gauge";
+            default: return "histogram";
+        }
+    }
+
+public:
+    MetricsRegistry() : count(0), collectorCount(0) {}
+
+    // Register at startup. False if the table is full or the same
+    // name and labels are already there.
+    bool add(Metric* m) {
+        int n = count.load();
+        if (n == MAX_METRICS) {
+            halLog("Metrics: Registry full, '%s' not added\n", m->name);
+            return false;
+        }
+        for (int i = 0; i < n; i++) {
+            if (metrics[i] == m) return false;
+            if (strcmp(metrics[i]->name, m->name) == 0 &&
+                strcmp(metrics[i]->getLabels(), m->getLabels()) == 0) {
+                halLog("Metrics: '%s{%s}' already registered\n", m->name, m->getLabels());
+                return false;
+            }
+        }
+        metrics[n] = m;
+        count.store(n + 1);      // Published after the slot is filled
+        return true;
+    }
+
+    void add(MetricHttpCodes& codes) {
+        for (int i = 0; i < MetricHttpCodes::CLASSES; i++) add(&codes.counter(i));
+    }
+
+    bool addCollector(CollectorFn fn) {
+        if (collectorCount == MAX_COLLECTORS) return false;
+        collectors[collectorCount++] = fn;
+        return true;
+    }
+
+    // Forget everything (tests)
+    void clear() {
+        count.store(0);
+        collectorCount = 0;
+    }
+
+    int getCount() const { return count.load(); }
+
+    const Metric* find(const char* name, const char* labels = "") const {
+        int n = count.load();
+        for (int i = 0; i < n; i++) {
+            if (strcmp(metrics[i]->name, name) == 0 && strcmp(metrics[i]->getLabels(), labels) == 0) {
+                return metrics[i];
+            }
+        }
+        return nullptr;
+    }
+
+    // Each family once: HELP and TYPE from its first registration,
+    // then every label set of that name
+    void write(Print& out) const {
+        int n = count.load();
+        for (int i = 0; i < n; i++) {
+            bool seen = false;
+            for (int j = 0; j < i && !seen; j++) {
+                seen = strcmp(metrics[j]->name, metrics[i]->name) == 0;
+            }
+            if (seen) continue;
+            metricsPrintHeader(out, metrics[i]->name, typeName(metrics[i]->type), metrics[i]->help);
+            for (int k = i; k < n; k++) {
+                if (strcmp(metrics[k]->name, metrics[i]->name) == 0) {
+                    metrics[k]->write(out);
+                }
+            }
+        }
+        for (int c = 0; c < collectorCount; c++) {
+            collectors[c](out);
+        }
+    }
+};
+
+inline MetricsRegistry& metricsRegistry() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+#endif // METRICS_H
@@ -0,0 +1,82 @@
+/*
+ * ============================================
+ * Message Queue - Typed, Bounded, Between Tasks
+ * ============================================
+ *
+ * Handles:
+ * - A fixed number of fixed-size messages,
+ *   copied in and out (no pointers to stack
+ *   data cross a task boundary by accident)
+ * - Send and receive with a timeout: 0 never
+ *   blocks, HAL_WAIT_FOREVER blocks for good;
+ *   sends from interrupt handlers
+ * - Depth for the task stats report (queues
+ *   show up in "tasks" and /api/metrics)
+ *
+ * A FreeRTOS queue on the watch, a mutex and
+ * condition variable on the host (volt_hal.h).
+ * Messages must be plain structs: a pointer in
+ * one is only as good as what it points to.
+ *
+ * ============================================
+ */
+
+#ifndef MSG_QUEUE_H
+#define MSG_QUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+#include "volt_hal.h"
+
+template <typename T, int N>
+class MsgQueue {
+    static_assert(std::is_trivially_copyable<T>::value, "queue messages are copied byte for byte");
+
+private:
+    HalQueue handle;
+
+    MsgQueue(const MsgQueue&) = delete;
+    MsgQueue& operator=(const MsgQueue&) = delete;
+
+public:
+    static const int DEPTH = N;
+
+    MsgQueue() : handle(nullptr) {}
+
+    ~MsgQueue() {
+        if (handle) halQueueDelete(handle);
+    }
+
+    // Reserves the N slots
+    bool begin() {
+        if (!handle) handle = halQueueCreate(sizeof(T), N);
+        if (!handle) halLog("Queue: No memory for %d x %u bytes\n", N, (unsigned)sizeof(T));
+        return handle != nullptr;
+    }
+
+    // False if still full after timeoutMs; the caller decides what
+    // a dropped message means
+    bool send(const T& msg, uint32_t timeoutMs = 0) {
+        return handle && halQueueSend(handle, &msg, timeoutMs);
+    }
+
+    // From an interrupt handler; never waits
+    bool sendFromIsr(const T& msg) {
+        return handle && halQueueSendFromIsr(handle, &msg);
+    }
+
+    bool receive(T& msg, uint32_t timeoutMs = 0) {
+        return handle && halQueueReceive(handle, &msg, timeoutMs);
+    }
+
+    int count() const { return handle ? halQueueWaiting(handle) : 0; }
+
+    // For taskStats().watchQueue(name, &queue, MsgQueue<T, N>::depthOf)
+    static uint32_t depthOf(void* queue, uint32_t* capacity) {
+        *capacity = N;
+        return (uint32_t)((MsgQueue*)queue)->count();
+    }
+};
+
+#endif // MSG_QUEUE_H
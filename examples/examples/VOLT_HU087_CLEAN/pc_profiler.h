@@ -0,0 +1,315 @@
+/*
+ * ============================================
+ * PC Profiler - Statistical CPU Sampling
+ * ============================================
+ *
+ * Handles:
+ * - A hardware timer interrupt per core at a
+ *   fixed rate (1 kHz by default) that records
+ *   the interrupted PC and a shallow backtrace
+ * - A fixed sample buffer reserved at start():
+ *   a capture runs until it is full or stopped,
+ *   nothing is allocated in the interrupt
+ * - A text dump for host/pcprof_symbolize.py,
+ *   which turns it into folded stacks for
+ *   flamegraph.pl / speedscope / inferno
+ *
+ * How a sample is taken (ESP32, Xtensa): the
+ * level-1 interrupt entry saves the interrupted
+ * task's registers in an exception frame on its
+ * stack, spills the register windows and stores
+ * the frame in the task's pxTopOfStack. The
+ * handler reads PC, return address and SP from
+ * there and walks the stack with
+ * esp_backtrace_get_next_frame(). Ticks that
+ * land on another interrupt (no task frame to
+ * read) or on a flash write (PSRAM buffer out
+ * of reach) are only counted as skipped.
+ *
+ * Opt-in: VOLT_PC_PROFILE (config_stone.h) puts
+ * the handler in IRAM. Off, start() just says
+ * so. On the host nothing interrupts; tests
+ * feed record() directly.
+ *
+ * Dump format (one sample per line, leaf first):
+ *   # volt-pcprof 1
+ *   # hz 1000 ms 5000 samples 4870 skipped 130 dropped 0
+ *   1 0x42003f10 0x42004a2c 0x420051b8
+ *
+ * ============================================
+ */
+
+#ifndef PC_PROFILER_H
+#define PC_PROFILER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include "volt_hal.h"
+
+#ifndef VOLT_PC_PROFILE
+#define VOLT_PC_PROFILE 0
+#endif
+
+#if defined(ARDUINO) && VOLT_PC_PROFILE
+#include <esp_debug_helpers.h>
+#include <esp_cpu.h>
+#include <esp_spi_flash.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <xtensa/xtensa_context.h>
+
+// Current task per core, kept by FreeRTOS (tasks.c)
+extern "C" void* volatile pxCurrentTCB[portNUM_PROCESSORS];
+#define PCPROF_IRAM IRAM_ATTR
+#else
+#define PCPROF_IRAM
+#endif
+
+static const int PCPROF_MAX_DEPTH = 6;
+
+struct PcSample {
+    uint8_t core;
+    uint8_t depth;               // PCs in pc[], leaf first
+    uint32_t pc[PCPROF_MAX_DEPTH];
+};
+
+class PcProfiler {
+public:
+    static const int MAX_DEPTH = PCPROF_MAX_DEPTH;
+    static const uint32_t DEFAULT_HZ = 1000;
+    static const uint32_t DEFAULT_SAMPLES = 4096;   // ~100 KB, from PSRAM if there is some
+
+private:
+    PcSample* samples;
+    uint32_t capacity;
+    std::atomic<uint32_t> next;  // Slots claimed (may pass capacity)
+    std::atomic<uint32_t> skipped; // Ticks with no task frame or no cache
+    std::atomic<bool> running;
+    uint32_t hz;
+    uint32_t startMs;
+    uint32_t stopMs;
+
+#if defined(ARDUINO) && VOLT_PC_PROFILE
+    hw_timer_t* timers[2];
+
+    static void onTimer();
+
+    // The capture the interrupt writes to (constant-initialized,
+    // so reading it needs no guard)
+    static PcProfiler*& PCPROF_IRAM active() {
+        static PcProfiler* p = nullptr;
+        return p;
+    }
+
+    // Timer interrupts land on the core that attached them
+    struct AttachArgs {
+        PcProfiler* self;
+        int core;
+        volatile bool done;
+    };
+
+    void attachTimer(int core) {
+        hw_timer_t* t = timerBegin(core, 80, true);     // 1 MHz
+        timerAttachInterrupt(t, &PcProfiler::onTimer, true);
+        timerAlarmWrite(t, 1000000 / hz, true);
+        timers[core] = t;
+    }
+
+    static void attachTask(void* arg) {
+        AttachArgs* a = (AttachArgs*)arg;
+        a->self->attachTimer(a->core);
+        a->done = true;
+        vTaskDelete(NULL);
+    }
+#endif
+
+public:
+    PcProfiler() : samples(nullptr), capacity(0), next(0), skipped(0), running(false),
+                   hz(DEFAULT_HZ), startMs(0), stopMs(0) {
+#if defined(ARDUINO) && VOLT_PC_PROFILE
+        timers[0] = timers[1] = nullptr;
+#endif
+    }
+
+    ~PcProfiler() {
+        stop();
+        if (samples) halHeapFree(samples);
+    }
+
+    bool isRunning() const { return running.load(); }
+    uint32_t getHz() const { return hz; }
+    uint32_t getCapacity() const { return capacity; }
+    uint32_t getSkipped() const { return skipped.load(); }
+
+    uint32_t getCount() const {
+        uint32_t n = next.load();
+        return n < capacity ? n : capacity;
+    }
+
+    // Ticks that found the buffer full
+    uint32_t getDropped() const {
+        uint32_t n = next.load();
+        return n > capacity ? n - capacity : 0;
+    }
+
+    const PcSample& getSample(uint32_t i) const { return samples[i]; }
+
+    // Reserve the buffer once (kept for later captures)
+    bool reserve(uint32_t count) {
+        if (samples && count <= capacity) return true;
+        if (samples) halHeapFree(samples);
+        size_t bytes = sizeof(PcSample) * count;
+        samples = (PcSample*)halHeapAlloc(bytes, HAL_HEAP_SPIRAM);
+        if (!samples) samples = (PcSample*)halHeapAlloc(bytes, HAL_HEAP_INTERNAL);
+        capacity = samples ? count : 0;
+        return samples != nullptr;
+    }
+
+    // Clear the buffer and start sampling both cores. False if the
+    // buffer can't be had or the build has no sampler.
+    bool start(uint32_t rate = DEFAULT_HZ, uint32_t count = DEFAULT_SAMPLES) {
+        if (running.load()) return false;
+        if (rate == 0 || rate > 10000) rate = DEFAULT_HZ;
+        if (!reserve(count)) {
+            halLog("Prof: No memory for %u samples\n", (unsigned)count);
+            return false;
+        }
+        hz = rate;
+        next.store(0);
+        skipped.store(0);
+        startMs = stopMs = (uint32_t)halMillis();
+#if defined(ARDUINO) && VOLT_PC_PROFILE
+        running.store(true);
+        active() = this;
+        int here = halCoreId();
+        attachTimer(here);
+        AttachArgs args = { this, 1 - here, false };
+        xTaskCreatePinnedToCore(attachTask, "pcprof", 3072, &args, configMAX_PRIORITIES - 1,
+                                nullptr, 1 - here);
+        while (!args.done) {
+            vTaskDelay(1);
+        }
+        for (int c = 0; c < 2; c++) {
+            timerAlarmEnable(timers[c]);
+        }
+        halLog("Prof: Sampling at %u Hz into %u slots\n", (unsigned)hz, (unsigned)capacity);
+        return true;
+#else
+        halLog("Prof: PC sampling is off (build with VOLT_PC_PROFILE 1 for the ESP32)\n");
+        return false;
+#endif
+    }
+
+    void stop() {
+        if (!running.load()) return;
+#if defined(ARDUINO) && VOLT_PC_PROFILE
+        for (int c = 0; c < 2; c++) {
+            if (!timers[c]) continue;
+            timerAlarmDisable(timers[c]);
+            timerDetachInterrupt(timers[c]);
+            timerEnd(timers[c]);
+            timers[c] = nullptr;
+        }
+#endif
+        running.store(false);
+        stopMs = (uint32_t)halMillis();
+        halLog("Prof: Stopped, %u samples\n", (unsigned)getCount());
+    }
+
+    // Stops by itself once the buffer is full; call from loop()
+    void tick() {
+        if (running.load() && next.load() >= capacity) {
+            stop();
+        }
+    }
+
+    // One sample: pcs[0] is the interrupted PC, then return
+    // addresses outwards. Safe from an interrupt.
+    void PCPROF_IRAM record(int core, const uint32_t* pcs, int depth) {
+        uint32_t i = next.fetch_add(1, std::memory_order_relaxed);
+        if (i >= capacity) return;
+        PcSample& s = samples[i];
+        if (depth > MAX_DEPTH) depth = MAX_DEPTH;
+        s.core = (uint8_t)core;
+        s.depth = (uint8_t)depth;
+        for (int d = 0; d < depth; d++) {
+            s.pc[d] = pcs[d];
+        }
+    }
+
+    void PCPROF_IRAM countSkipped() {
+        skipped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Longest sample line
+    static const size_t MAX_LINE = 8 + MAX_DEPTH * 11;
+
+    // The capture so far (stop() first for a consistent one)
+    void dump(Print& out) const {
+        dumpHeader(out);
+        dumpSamples(out, 0, getCount());
+    }
+
+    void dumpHeader(Print& out) const {
+        uint32_t ms = (running.load() ? (uint32_t)halMillis() : stopMs) - startMs;
+        out.print("# volt-pcprof 1\n");
+        out.printf("# hz %u ms %u samples %u skipped %u dropped %u\n", (unsigned)hz,
+                   (unsigned)ms, (unsigned)getCount(), (unsigned)getSkipped(), (unsigned)getDropped());
+    }
+
+    // Sample lines from..from+count-1 (a dump in pieces)
+    void dumpSamples(Print& out, uint32_t from, uint32_t count) const {
+        uint32_t n = getCount();
+        char line[MAX_LINE];
+        char word[12];                      // " 0x" and 8 digits, then the NUL
+        for (uint32_t i = from; i < n && i - from < count; i++) {
+            const PcSample& s = samples[i];
+            size_t len = (size_t)snprintf(word, sizeof(word), "%u", (unsigned)s.core);
+            memcpy(line, word, len);
+            for (int d = 0; d < s.depth && d < MAX_DEPTH; d++) {
+                snprintf(word, sizeof(word), " 0x%08x", (unsigned)s.pc[d]);
+                memcpy(line + len, word, 11);
+                len += 11;
+            }
+            line[len++] = '\n';
+            out.write((const uint8_t*)line, len);
+        }
+    }
+};
+
+inline PcProfiler& pcProfiler() {
+    static PcProfiler profiler;
+    return profiler;
+}
+
+#if defined(ARDUINO) && VOLT_PC_PROFILE
+
+inline void PCPROF_IRAM PcProfiler::onTimer() {
+    int core = xPortGetCoreID();
+    PcProfiler& p = *active();
+    if (xPortInterruptedFromISRContext() || !spi_flash_cache_enabled()) {
+        p.countSkipped();
+        return;
+    }
+    // Frame saved by the interrupt entry: first word of the TCB
+    const XtExcFrame* frame = *(const XtExcFrame* const*)pxCurrentTCB[core];
+    uint32_t pcs[MAX_DEPTH];
+    int depth = 0;
+    pcs[depth++] = (uint32_t)frame->pc;
+    esp_backtrace_frame_t f;
+    f.pc = (uint32_t)frame->pc;
+    f.sp = (uint32_t)frame->a1;
+    f.next_pc = (uint32_t)frame->a0;
+    while (depth < MAX_DEPTH && f.next_pc != 0) {
+        if (!esp_backtrace_get_next_frame(&f)) break;
+        pcs[depth++] = esp_cpu_process_stack_pc(f.pc);
+    }
+    p.record(core, pcs, depth);
+}
+
+#endif
+
+#endif // PC_PROFILER_H
@@ -2,62 +2,70 @@
  * ============================================
  * HU-087 Hardware Pin Definitions
  * ============================================
- * 
+ *
  * XiaoZhi HU-087 ESP32-S3 Watch Kit
  * Verified pin assignments
- * 
+ *
+ * The names the sketch and engine use, for the
+ * board being built. The values are in
+ * board_traits.h (BoardHu087 for the HU-087),
+ * which also checks them; another board is
+ * picked there, not here.
+ *
  * ============================================
  */
 
 #ifndef PINS_HU087_H
 #define PINS_HU087_H
 
+#include "board_traits.h"
+
 // ============================================
 // MICROPHONE (INMP441 I2S MEMS)
 // ============================================
 
-#define MIC_WS          4       // Word Select (LRCLK)
-#define MIC_SCK         5       // Bit Clock (BCLK)
-#define MIC_SD          6       // Data In (DOUT from microphone)
-#define MIC_I2S_NUM     I2S_NUM_0
+#define MIC_WS          Board::Mic::WS          // Word Select (LRCLK)
+#define MIC_SCK         Board::Mic::SCK         // Bit Clock (BCLK)
+#define MIC_SD          Board::Mic::SD          // Data In (DOUT from microphone)
+#define MIC_I2S_NUM     Board::Mic::PORT
 
 // ============================================
 // SPEAKER (MAX98357A I2S Class-D Amplifier)
 // ============================================
 
-#define SPK_DOUT        7       // Data Out (DIN to amplifier)
-#define SPK_BCLK        15      // Bit Clock
-#define SPK_LRCK        16      // Left/Right Clock (Word Select)
-#define SPK_SD_MODE     17      // Shutdown control (HIGH = enabled)
-#define SPK_I2S_NUM     I2S_NUM_1
+#define SPK_DOUT        Board::Speaker::DOUT    // Data Out (DIN to amplifier)
+#define SPK_BCLK        Board::Speaker::BCLK    // Bit Clock
+#define SPK_LRCK        Board::Speaker::LRCK    // Left/Right Clock (Word Select)
+#define SPK_SD_MODE     Board::Speaker::SD_MODE // Shutdown control (HIGH = enabled)
+#define SPK_I2S_NUM     Board::Speaker::PORT
 
 // ============================================
 // DISPLAY (ST7789 1.47" IPS LCD - SPI)
 // ============================================
 
-#define LCD_SCLK        21      // SPI Clock
-#define LCD_MOSI        47      // SPI Data (MOSI)
-#define LCD_CS          41      // Chip Select
-#define LCD_DC          40      // Data/Command
-#define LCD_RST         45      // Reset
-#define LCD_BL          42      // Backlight (active LOW on HU-087)
+// TFT_eSPI takes its bus pins from its User_Setup.h; these must
+// match
+#define LCD_SCLK        Board::Display::SCLK    // SPI Clock
+#define LCD_MOSI        Board::Display::MOSI    // SPI Data (MOSI)
+#define LCD_CS          Board::Display::CS      // Chip Select
+#define LCD_DC          Board::Display::DC      // Data/Command
+#define LCD_RST         Board::Display::RST     // Reset
+#define LCD_BL          Board::Display::BL      // Backlight (active LOW on HU-087)
 
-// Display dimensions
-#define SCREEN_WIDTH    172
-#define SCREEN_HEIGHT   320
+// Display dimensions: Board::Display::WIDTH and HEIGHT
 
 // ============================================
 // BUTTONS & LED
 // ============================================
 
-#define BTN_BOOT        0       // Boot button (main interaction button)
-#define LED_BUILTIN     48      // Built-in white LED
+#define BTN_BOOT        Board::BUTTON           // Boot button (main interaction button)
+#define LED_BUILTIN     Board::LED              // Built-in white LED
 
 // ============================================
 // BATTERY (ADC if available)
 // ============================================
 
-// Uncomment if your HU-087 variant has battery ADC
-// #define BATTERY_ADC     34
+// Board::Battery::PIN, -1 where there is no battery ADC (the
+// stock HU-087); read through halBatteryMillivolts()
 
 #endif // PINS_HU087_H
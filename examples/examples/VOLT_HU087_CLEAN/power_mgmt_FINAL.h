@@ -9,6 +9,9 @@
  * - Battery monitoring
  * - Wake-up
  * 
+ * Hardware access goes through volt_hal.h,
+ * board differences through board_traits.h
+ * 
  * Optimized for Stone's HU-087 watch
  * 
  * ============================================
@@ -18,6 +21,7 @@
 #define POWER_MGMT_H
 
 #include <Arduino.h>
+#include "volt_hal.h"
 #include "config_stone.h"
 #include "pins_hu087.h"
 
@@ -30,64 +34,60 @@ public:
     PowerManager() : lastActivityTime(0), sleepTimeout(SLEEP_TIMEOUT) {}
     
     void begin() {
-        lastActivityTime = millis();
+        lastActivityTime = halMillis();
         
         // Configure wake-up source (button)
-        esp_sleep_enable_ext0_wakeup((gpio_num_t)BTN_BOOT, 0);  // Wake on LOW
+        halEnableWakeOnPin(BTN_BOOT, 0);  // Wake on LOW
         
-        Serial.println("Power: Initialized");
+        halLog("Power: Initialized\n");
     }
     
     void keepAlive() {
         // Called regularly to prevent watchdog timeout
-        delay(1);
+        halDelay(1);
     }
     
     void resetIdleTimer() {
-        lastActivityTime = millis();
+        lastActivityTime = halMillis();
     }
     
     bool shouldSleep() {
-        unsigned long idleTime = (millis() - lastActivityTime) / 1000;  // Convert to seconds
-        return (idleTime >= sleepTimeout);
+        unsigned long idleTime = (halMillis() - lastActivityTime) / 1000;  // Convert to seconds
+        return (idleTime >= (unsigned long)sleepTimeout);
     }
     
     void enterDeepSleep() {
-        Serial.println("Power: Entering deep sleep...");
+        halLog("Power: Entering deep sleep...\n");
         
         // Disable speaker amplifier
-        digitalWrite(SPK_SD_MODE, LOW);
+        halSpeakerAmp(false);
         
         // Turn off LED
-        digitalWrite(LED_BUILTIN, LOW);
+        halLed(false);
         
-        delay(100);
+        halDelay(100);
         
         // Enter deep sleep
-        esp_deep_sleep_start();
+        halDeepSleep();
     }
     
     int getBatteryPercent() {
-        // Simple battery estimation
-        // TODO: Implement actual ADC reading if battery pin available
-        
-        #ifdef BATTERY_ADC
-        int raw = analogRead(BATTERY_ADC);
-        float voltage = (raw / 4095.0) * 3.3 * 2.0;  // Assuming voltage divider
+        // Measured where the board has a battery ADC (board_traits.h)
+        int mv = halBatteryMillivolts();
+        if (mv >= 0) {
+            // LiPo voltage to percentage (approximate)
+            if (mv >= 4200) return 100;
+            if (mv >= 4000) return 80;
+            if (mv >= 3800) return 60;
+            if (mv >= 3600) return 40;
+            if (mv >= 3400) return 20;
+            return 10;
+        }
         
-        // LiPo voltage to percentage (approximate)
-        if (voltage >= 4.2) return 100;
-        if (voltage >= 4.0) return 80;
-        if (voltage >= 3.8) return 60;
-        if (voltage >= 3.6) return 40;
-        if (voltage >= 3.4) return 20;
-        return 10;
-        #else
         // Return estimated value if no ADC
-        unsigned long uptime = millis() / 1000 / 60;  // minutes
+        unsigned long uptime = halMillis() / 1000 / 60;  // minutes
         int estimated = 100 - (uptime / 10);  // Rough estimate: 1% per 10 min
         return max(10, min(100, estimated));
-        #endif
     }
 };
 
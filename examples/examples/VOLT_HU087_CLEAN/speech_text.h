@@ -0,0 +1,144 @@
+/*
+ * ============================================
+ * Speech Text - What Is Being Said, and Where
+ * ============================================
+ *
+ * Handles:
+ * - The text of the line being spoken, copied
+ *   in whole (speak()) or a piece at a time as
+ *   the Realtime API streams its transcript
+ * - Which piece's audio is playing and since
+ *   when, so the screen can estimate the
+ *   character being said (spokenAt())
+ * - A generation per line, so a reader can tell
+ *   a new line from more of the same one
+ *
+ * One writer (the audio task: volt_ai_FINAL.h,
+ * volt_realtime.h), one reader (the ui task,
+ * following along with text_scroller.h). The
+ * writer adds text past the published length
+ * and then publishes it; a reader that sees the
+ * generation change while it copies drops what
+ * it copied.
+ *
+ * ============================================
+ */
+
+#ifndef SPEECH_TEXT_H
+#define SPEECH_TEXT_H
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+class SpeechText {
+public:
+    static const int MAX_CHARS = 1024;
+    static const uint32_t CHARS_PER_SEC = 14;    // The TTS voice, about 150 words a minute
+
+private:
+    char text[MAX_CHARS + 1];
+    std::atomic<uint16_t> length;
+    std::atomic<uint32_t> generation;
+    std::atomic<bool> active;                // Between begin() and end()
+    std::atomic<uint16_t> pieceStart;        // Text whose audio is playing
+    std::atomic<uint16_t> pieceEnd;
+    std::atomic<uint32_t> pieceMs;           // When it started; 0 = nothing yet
+
+public:
+    SpeechText() : length(0), generation(0), active(false), pieceStart(0), pieceEnd(0), pieceMs(0) {
+        text[0] = '\0';
+    }
+
+    // ---- Writer (audio task) ----
+
+    // A new line: s if it is known up front, else it comes through
+    // append()
+    void begin(const char* s = nullptr) {
+        generation.fetch_add(1);
+        length.store(0);
+        pieceStart.store(0);
+        pieceEnd.store(0);
+        pieceMs.store(0);
+        active.store(true);
+        if (s) append(s, strlen(s));
+    }
+
+    void append(const char* s, size_t n) {
+        uint16_t at = length.load();
+        if (n > (size_t)(MAX_CHARS - at)) n = (size_t)(MAX_CHARS - at);
+        memcpy(text + at, s, n);
+        text[at + n] = '\0';
+        length.store((uint16_t)(at + n));
+    }
+
+    // Audio for characters [start, end) started playing at now
+    void playing(uint16_t start, uint16_t end, unsigned long now) {
+        pieceStart.store(start);
+        pieceEnd.store(end);
+        pieceMs.store(now ? (uint32_t)now : 1);
+    }
+
+    // Everything has been said
+    void end() {
+        uint16_t n = length.load();
+        playing(n, n, 1);
+        active.store(false);
+    }
+
+    // ---- Reader (ui task) ----
+
+    uint32_t getGeneration() const { return generation.load(); }
+    bool isActive() const { return active.load(); }
+    uint16_t getLength() const { return length.load(); }
+
+    // Characters [from, getLength()) into out (room for max), as
+    // long as the line is still generation gen. Returns how many,
+    // or -1 if it has moved on.
+    int copy(uint32_t gen, int from, char* out, int max) const {
+        if (generation.load() != gen) return -1;
+        int n = (int)length.load() - from;
+        if (n > max) n = max;
+        if (n < 0) n = 0;
+        memcpy(out, text + from, (size_t)n);
+        return generation.load() == gen ? n : -1;
+    }
+
+    // True if the line so far starts like s (a screen showing s
+    // follows it)
+    bool startsLike(const char* s, int n) const {
+        uint32_t gen = generation.load();
+        int len = length.load();
+        if (n > len) n = len;
+        bool same = n > 0 && strncmp(text, s, (size_t)n) == 0;
+        return same && generation.load() == gen;
+    }
+
+    // The character being said at now: through the playing piece at
+    // CHARS_PER_SEC, never past its end. -1 before any audio.
+    int spokenAt(unsigned long now) const {
+        uint32_t since = pieceMs.load();
+        if (since == 0) return -1;
+        uint16_t start = pieceStart.load(), end = pieceEnd.load();
+        uint32_t elapsed = (uint32_t)now - since;
+        uint32_t at = start + elapsed * CHARS_PER_SEC / 1000;
+        if (at > end) at = end;
+        if (at > length.load()) at = length.load();
+        return (int)at;
+    }
+};
+
+// The one the engines write and the screen reads
+inline SpeechText& speechText() {
+    static SpeechText text;
+    return text;
+}
+
+// begin() now and end() on the way out, whichever way that is
+class SpeechTextScope {
+public:
+    explicit SpeechTextScope(const char* s = nullptr) { speechText().begin(s); }
+    ~SpeechTextScope() { speechText().end(); }
+};
+
+#endif // SPEECH_TEXT_H
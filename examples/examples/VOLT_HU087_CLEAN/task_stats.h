@@ -0,0 +1,349 @@
+/*
+ * ============================================
+ * Task Stats - CPU, Stacks and Queues
+ * ============================================
+ *
+ * Handles:
+ * - Per-task CPU share over the last interval,
+ *   from FreeRTOS run-time counters
+ * - Per-core idle percentage (the IDLE tasks)
+ * - Stack high-water marks, with one warning
+ *   per task when one runs low
+ * - Depth, capacity and peak of watched queues
+ * - A text report (serial "tasks" command) and
+ *   Prometheus text for GET /api/metrics (a
+ *   metrics.h collector)
+ *
+ * Sampling is one halTaskSnapshot() every
+ * interval (5 s by default) from loop(); the
+ * counters are kept by FreeRTOS anyway, so
+ * nothing is added to the tasks themselves.
+ * Call tick() and the writers from one task.
+ *
+ * Shares are of one core: a task pinned to
+ * core 1 that never yields shows 100%.
+ *
+ * ============================================
+ */
+
+#ifndef TASK_STATS_H
+#define TASK_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "volt_hal.h"
+#include "metrics.h"
+
+#ifdef ARDUINO
+#include <freertos/queue.h>
+#endif
+
+// Messages waiting in a queue; sets *capacity to its length
+typedef uint32_t (*QueueDepthFn)(void* queue, uint32_t* capacity);
+
+struct TaskStat {
+    char name[16];
+    uint32_t id;
+    int8_t core;
+    uint8_t priority;
+    bool idle;
+    uint16_t cpuPermille;        // Of one core, last interval
+    uint32_t stackFree;          // Least free stack seen, bytes
+    bool stackWarned;
+};
+
+struct QueueStat {
+    const char* name;
+    void* queue;
+    QueueDepthFn depthFn;
+    uint32_t depth;
+    uint32_t capacity;
+    uint32_t peakDepth;
+};
+
+class TaskStats {
+public:
+    static const int MAX_TASKS = HAL_MAX_TASKS;
+    static const int MAX_QUEUES = 8;
+    static const int CORES = 2;
+    static const uint32_t STACK_WARN_BYTES = 512;
+
+private:
+    TaskStat tasks[MAX_TASKS];
+    uint32_t prevRunTime[MAX_TASKS];
+    int taskCount;
+    QueueStat queues[MAX_QUEUES];
+    int queueCount;
+
+    uint32_t prevTotal;
+    uint16_t idlePermille[CORES];
+    uint32_t samples;
+    uint32_t lastSampleUs;       // What the last sample cost
+    uint32_t intervalMs;
+    uint32_t lastTickMs;
+
+    // Scratch for sample(), kept off the loop task's stack
+    HalTaskInfo snapshot[MAX_TASKS];
+    TaskStat next[MAX_TASKS];
+    uint32_t nextRunTime[MAX_TASKS];
+
+    int findTask(uint32_t id) const {
+        for (int i = 0; i < taskCount; i++) {
+            if (tasks[i].id == id) return i;
+        }
+        return -1;
+    }
+
+    static uint16_t permille(uint32_t part, uint32_t whole) {
+        if (whole == 0) return 0;
+        uint64_t p = (uint64_t)part * 1000 / whole;
+        return (uint16_t)(p > 1000 ? 1000 : p);
+    }
+
+    // Prometheus label values: escape \ and "
+    static void printLabel(Print& out, const char* s) {
+        for (; *s; s++) {
+            if (*s == '\\' || *s == '"') out.write((uint8_t)'\\');
+            out.write((uint8_t)*s);
+        }
+    }
+
+    static void printCore(Print& out, int8_t core) {
+        if (core < 0) {
+            out.print("any");
+        } else {
+            out.printf("%d", core);
+        }
+    }
+
+    static void printPercent(Print& out, uint16_t permille) {
+        out.printf("%u.%u", (unsigned)(permille / 10), (unsigned)(permille % 10));
+    }
+
+    static void printHeader(Print& out, const char* name, const char* type, const char* help) {
+        metricsPrintHeader(out, name, type, help);
+    }
+
+public:
+    TaskStats() : queueCount(0), intervalMs(5000) {
+        reset();
+    }
+
+    // Forget tasks and history (watched queues stay)
+    void reset() {
+        taskCount = 0;
+        prevTotal = 0;
+        samples = 0;
+        lastSampleUs = 0;
+        lastTickMs = 0;
+        for (int c = 0; c < CORES; c++) idlePermille[c] = 0;
+        for (int q = 0; q < queueCount; q++) {
+            queues[q].depth = queues[q].capacity = queues[q].peakDepth = 0;
+        }
+    }
+
+    void setInterval(uint32_t ms) { intervalMs = ms; }
+
+    // name must outlive the stats (a literal)
+    bool watchQueue(const char* name, void* queue, QueueDepthFn depthFn) {
+        if (queueCount == MAX_QUEUES || !depthFn) return false;
+        QueueStat& q = queues[queueCount++];
+        memset(&q, 0, sizeof(q));
+        q.name = name;
+        q.queue = queue;
+        q.depthFn = depthFn;
+        return true;
+    }
+
+#ifdef ARDUINO
+    static uint32_t freertosQueueDepth(void* queue, uint32_t* capacity) {
+        QueueHandle_t q = (QueueHandle_t)queue;
+        uint32_t waiting = uxQueueMessagesWaiting(q);
+        *capacity = waiting + uxQueueSpacesAvailable(q);
+        return waiting;
+    }
+
+    bool watchQueue(const char* name, QueueHandle_t queue) {
+        return watchQueue(name, (void*)queue, freertosQueueDepth);
+    }
+#endif
+
+    void sample() {
+        unsigned long startUs = halMicros();
+        uint32_t total = 0;
+        int n = halTaskSnapshot(snapshot, MAX_TASKS, &total);
+        uint32_t elapsed = total - prevTotal;     // Counters wrap
+        bool haveInterval = samples > 0 && elapsed > 0;
+
+        uint32_t idleRun[CORES] = {};
+        bool idleSeen[CORES] = {};
+        for (int i = 0; i < n; i++) {
+            const HalTaskInfo& info = snapshot[i];
+            int prev = findTask(info.id);
+            TaskStat& t = next[i];
+            if (prev >= 0) {
+                t = tasks[prev];
+            } else {
+                memset(&t, 0, sizeof(t));
+                t.stackFree = info.stackFree;
+            }
+            memcpy(t.name, info.name, sizeof(t.name));
+            t.name[sizeof(t.name) - 1] = '\0';
+            t.id = info.id;
+            t.core = info.core;
+            t.priority = info.priority;
+            t.idle = info.idle;
+            if (info.stackFree < t.stackFree) t.stackFree = info.stackFree;
+
+            // A task that appeared during the interval has no start
+            // point yet: 0 until the next sample
+            uint32_t delta = prev >= 0 ? info.runTime - prevRunTime[prev] : 0;
+            t.cpuPermille = haveInterval ? permille(delta, elapsed) : 0;
+            nextRunTime[i] = info.runTime;
+
+            if (t.idle && t.core >= 0 && t.core < CORES) {
+                idleRun[t.core] += delta;
+                idleSeen[t.core] = prev >= 0;
+            }
+
+            if (t.stackFree < STACK_WARN_BYTES && !t.stackWarned) {
+                halLog("Tasks: '%s' stack low (%u bytes free)\n", t.name, (unsigned)t.stackFree);
+                t.stackWarned = true;
+            }
+        }
+
+        memcpy(tasks, next, sizeof(TaskStat) * (size_t)n);
+        memcpy(prevRunTime, nextRunTime, sizeof(uint32_t) * (size_t)n);
+        taskCount = n;
+        for (int c = 0; c < CORES; c++) {
+            idlePermille[c] = haveInterval && idleSeen[c] ? permille(idleRun[c], elapsed) : 0;
+        }
+        prevTotal = total;
+
+        for (int q = 0; q < queueCount; q++) {
+            QueueStat& qs = queues[q];
+            qs.depth = qs.depthFn(qs.queue, &qs.capacity);
+            if (qs.depth > qs.peakDepth) qs.peakDepth = qs.depth;
+        }
+
+        samples++;
+        lastSampleUs = (uint32_t)(halMicros() - startUs);
+    }
+
+    // Call from loop(); samples once per interval. True if it did.
+    bool tick(uint32_t nowMs) {
+        if (intervalMs == 0) return false;
+        if (samples > 0 && nowMs - lastTickMs < intervalMs) return false;
+        lastTickMs = nowMs;
+        sample();
+        return true;
+    }
+
+    int getTaskCount() const { return taskCount; }
+    const TaskStat& getTask(int i) const { return tasks[i]; }
+    int getQueueCount() const { return queueCount; }
+    const QueueStat& getQueue(int i) const { return queues[i]; }
+    uint32_t getSamples() const { return samples; }
+    uint32_t getLastSampleUs() const { return lastSampleUs; }
+
+    // Idle share of a core over the last interval, in 0.1%
+    uint16_t getIdlePermille(int core) const {
+        return core >= 0 && core < CORES ? idlePermille[core] : 0;
+    }
+
+    const TaskStat* findByName(const char* name) const {
+        for (int i = 0; i < taskCount; i++) {
+            if (strcmp(tasks[i].name, name) == 0) return &tasks[i];
+        }
+        return nullptr;
+    }
+
+    void printReport(Print& out) const {
+        out.printf("=== Tasks (%d, sample %u us) ===\n", taskCount, (unsigned)lastSampleUs);
+        out.printf("  %-16s %4s %4s %7s %10s\n", "task", "core", "prio", "cpu %", "stack free");
+        for (int i = 0; i < taskCount; i++) {
+            const TaskStat& t = tasks[i];
+            char core[5] = "any";    // Fits "-128"
+            if (t.core >= 0) snprintf(core, sizeof(core), "%d", t.core);
+            out.printf("  %-16s %4s %4u %5u.%u %10u%s\n", t.name, core, (unsigned)t.priority,
+                       (unsigned)(t.cpuPermille / 10), (unsigned)(t.cpuPermille % 10),
+                       (unsigned)t.stackFree, t.stackWarned ? "  LOW" : "");
+        }
+        for (int c = 0; c < CORES; c++) {
+            out.printf("  Core %d idle %u.%u%%\n", c,
+                       (unsigned)(idlePermille[c] / 10), (unsigned)(idlePermille[c] % 10));
+        }
+        for (int q = 0; q < queueCount; q++) {
+            const QueueStat& qs = queues[q];
+            out.printf("  Queue %-10s %u / %u (peak %u)\n", qs.name,
+                       (unsigned)qs.depth, (unsigned)qs.capacity, (unsigned)qs.peakDepth);
+        }
+    }
+
+    // Prometheus text exposition format (version 0.0.4)
+    void writeMetrics(Print& out) const {
+        printHeader(out, "volt_task_cpu_percent", "gauge",
+                    "Share of one core used by the task over the last interval");
+        for (int i = 0; i < taskCount; i++) {
+            out.print("volt_task_cpu_percent{task=\"");
+            printLabel(out, tasks[i].name);
+            out.print("\",core=\"");
+            printCore(out, tasks[i].core);
+            out.print("\"} ");
+            printPercent(out, tasks[i].cpuPermille);
+            out.print("\n");
+        }
+
+        printHeader(out, "volt_task_stack_free_bytes", "gauge",
+                    "Least free stack the task has had");
+        for (int i = 0; i < taskCount; i++) {
+            out.print("volt_task_stack_free_bytes{task=\"");
+            printLabel(out, tasks[i].name);
+            out.printf("\"} %u\n", (unsigned)tasks[i].stackFree);
+        }
+
+        printHeader(out, "volt_core_idle_percent", "gauge",
+                    "Time the core spent in its idle task over the last interval");
+        for (int c = 0; c < CORES; c++) {
+            out.printf("volt_core_idle_percent{core=\"%d\"} ", c);
+            printPercent(out, idlePermille[c]);
+            out.print("\n");
+        }
+
+        if (queueCount > 0) {
+            printHeader(out, "volt_queue_depth", "gauge", "Messages waiting in the queue");
+            for (int q = 0; q < queueCount; q++) {
+                out.print("volt_queue_depth{queue=\"");
+                printLabel(out, queues[q].name);
+                out.printf("\"} %u\n", (unsigned)queues[q].depth);
+            }
+            printHeader(out, "volt_queue_capacity", "gauge", "Messages the queue can hold");
+            for (int q = 0; q < queueCount; q++) {
+                out.print("volt_queue_capacity{queue=\"");
+                printLabel(out, queues[q].name);
+                out.printf("\"} %u\n", (unsigned)queues[q].capacity);
+            }
+            printHeader(out, "volt_queue_peak_depth", "gauge", "Most messages seen waiting");
+            for (int q = 0; q < queueCount; q++) {
+                out.print("volt_queue_peak_depth{queue=\"");
+                printLabel(out, queues[q].name);
+                out.printf("\"} %u\n", (unsigned)queues[q].peakDepth);
+            }
+        }
+
+        printHeader(out, "volt_task_stats_samples_total", "counter", "Task snapshots taken");
+        out.printf("volt_task_stats_samples_total %u\n", (unsigned)samples);
+        printHeader(out, "volt_task_stats_sample_us", "gauge", "Time the last snapshot took");
+        out.printf("volt_task_stats_sample_us %u\n", (unsigned)lastSampleUs);
+    }
+};
+
+// Shared instance for the sketch and the device API
+inline TaskStats& taskStats() {
+    static TaskStats stats;
+    return stats;
+}
+
+#endif // TASK_STATS_H
@@ -0,0 +1,207 @@
+/*
+ * ============================================
+ * Task Supervisor - Per-Task Heartbeats
+ * ============================================
+ *
+ * Handles:
+ * - A heartbeat per task with its own deadline
+ *   (ui a few seconds, audio long enough for a
+ *   30 s reply)
+ * - Busy and resting: a task blocked on its
+ *   queue waiting for work is not stalled
+ * - How close each task comes to its deadline,
+ *   as a histogram in % of the deadline
+ * - A diagnostic for a stalled task (what it
+ *   was doing, for how long, its worst gap so
+ *   far), logged and passed to a hook, once
+ *   per stall
+ * - The verdict for the hardware watchdog: the
+ *   caller feeds it only while check() finds
+ *   nothing stalled, so the diagnostic always
+ *   comes out before the reset
+ *
+ * The 8 s task watchdog only sees the tasks
+ * subscribed to it, all with the same timeout.
+ * Here each task beats when it starts a piece
+ * of work (beat()) and rests when it goes back
+ * to waiting (rest()); one task (loop()) calls
+ * check() and feeds the hardware watchdog.
+ *
+ * beat() and rest() are safe from any task;
+ * check() and the writers from one. Time comes
+ * from halMillis(), so host tests stall tasks
+ * on the virtual clock.
+ *
+ * ============================================
+ */
+
+#ifndef TASK_SUPERVISOR_H
+#define TASK_SUPERVISOR_H
+
+#include <stdint.h>
+#include <atomic>
+#include "volt_hal.h"
+#include "metrics.h"
+
+class TaskSupervisor {
+public:
+    static const int MAX_TASKS = 6;
+
+    // What the stall hook gets
+    struct Stall {
+        const char* task;
+        const char* doing;       // Last beat's label, or "running"
+        uint32_t busyMs;         // Since the last beat
+        uint32_t deadlineMs;
+        uint32_t worstMs;        // Longest gap before this one
+        uint32_t beats;
+    };
+
+    typedef void (*StallFn)(const Stall& stall, void* ctx);
+
+    // Upper bounds in % of the deadline
+    static const uint32_t* percentBuckets() {
+        static const uint32_t b[] = { 5, 10, 25, 50, 75, 90, 100, 150, 200 };
+        return b;
+    }
+    static const int PERCENT_BUCKETS = 9;
+
+private:
+    struct Watch {
+        const char* name;
+        uint32_t deadlineMs;
+        MetricHistogram* closeness;
+        std::atomic<uint32_t> lastBeat;
+        std::atomic<bool> busy;
+        std::atomic<const char*> doing;
+        std::atomic<uint32_t> beats;
+        std::atomic<uint32_t> worstMs;
+        uint32_t reportedBeat;   // beats when the stall was reported (check() only)
+        bool reported;
+    };
+
+    Watch watches[MAX_TASKS];
+    std::atomic<int> watchCount;
+    StallFn onStall;
+    void* stallCtx;
+    MetricCounter stalls;
+
+    static void storeMax(std::atomic<uint32_t>& v, uint32_t x) {
+        uint32_t cur = v.load(std::memory_order_relaxed);
+        while (x > cur && !v.compare_exchange_weak(cur, x, std::memory_order_relaxed)) {}
+    }
+
+    // A gap between beats, to the histogram and the worst
+    void observe(Watch& w, uint32_t gapMs) {
+        storeMax(w.worstMs, gapMs);
+        if (w.closeness) {
+            w.closeness->observe((uint32_t)((uint64_t)gapMs * 100 / w.deadlineMs));
+        }
+    }
+
+    bool valid(int id) const { return id >= 0 && id < watchCount.load(std::memory_order_acquire); }
+
+public:
+    TaskSupervisor()
+        : watchCount(0), onStall(nullptr), stallCtx(nullptr),
+          stalls("volt_task_stalls_total", "Times a task went past its heartbeat deadline") {}
+
+    // Before the task starts. closeness (may be null) gets every
+    // gap in % of deadlineMs; give it percentBuckets(). -1 if full.
+    int watch(const char* name, uint32_t deadlineMs, MetricHistogram* closeness = nullptr) {
+        int id = watchCount.load(std::memory_order_relaxed);
+        if (id >= MAX_TASKS || deadlineMs == 0) return -1;
+        Watch& w = watches[id];
+        w.name = name;
+        w.deadlineMs = deadlineMs;
+        w.closeness = closeness;
+        w.lastBeat.store((uint32_t)halMillis());
+        w.busy.store(false);
+        w.doing.store(nullptr);
+        w.beats.store(0);
+        w.worstMs.store(0);
+        w.reportedBeat = 0;
+        w.reported = false;
+        watchCount.store(id + 1, std::memory_order_release);
+        return id;
+    }
+
+    void setStallHook(StallFn fn, void* ctx) {
+        onStall = fn;
+        stallCtx = ctx;
+    }
+
+    // The task is alive and starting doing (a literal); the deadline
+    // runs from now
+    void beat(int id, const char* doing = nullptr) {
+        if (!valid(id)) return;
+        Watch& w = watches[id];
+        uint32_t now = (uint32_t)halMillis();
+        if (w.busy.load()) observe(w, now - w.lastBeat.load());
+        w.doing.store(doing);
+        w.lastBeat.store(now);
+        w.beats.fetch_add(1);
+        w.busy.store(true);
+    }
+
+    // Back to waiting for work: no deadline until the next beat
+    void rest(int id) {
+        if (!valid(id)) return;
+        Watch& w = watches[id];
+        if (!w.busy.exchange(false)) return;
+        observe(w, (uint32_t)halMillis() - w.lastBeat.load());
+    }
+
+    // Reports tasks past their deadline (once per stall) and returns
+    // how many are. Feed the hardware watchdog only when it's 0.
+    int check(uint32_t now) {
+        int stalled = 0;
+        int n = watchCount.load(std::memory_order_acquire);
+        for (int i = 0; i < n; i++) {
+            Watch& w = watches[i];
+            if (!w.busy.load()) continue;
+            uint32_t beats = w.beats.load();
+            uint32_t busyMs = now - w.lastBeat.load();
+            if ((int32_t)busyMs < 0 || busyMs <= w.deadlineMs) continue;   // Beat after now was read
+            stalled++;
+            if (w.reported && w.reportedBeat == beats) continue;
+            w.reported = true;
+            w.reportedBeat = beats;
+            stalls.inc();
+
+            const char* doing = w.doing.load();
+            Stall s = { w.name, doing ? doing : "running", busyMs, w.deadlineMs,
+                        w.worstMs.load(), beats };
+            halLog("Supervisor: %s stalled in %s for %u ms (deadline %u ms, worst gap %u ms, %u beats)\n",
+                   s.task, s.doing, (unsigned)s.busyMs, (unsigned)s.deadlineMs, (unsigned)s.worstMs,
+                   (unsigned)s.beats);
+            if (onStall) onStall(s, stallCtx);
+        }
+        return stalled;
+    }
+
+    void registerMetrics(MetricsRegistry& registry) { registry.add(&stalls); }
+
+    // Serial "health" command
+    void printReport(Print& out, uint32_t now) const {
+        int n = watchCount.load(std::memory_order_acquire);
+        out.printf("=== Task health (%d tasks, %u stalls) ===\n", n, (unsigned)stalls.get());
+        out.printf("  %-8s %9s %9s %9s  %s\n", "task", "deadline", "busy ms", "worst ms", "doing");
+        for (int i = 0; i < n; i++) {
+            const Watch& w = watches[i];
+            bool busy = w.busy.load();
+            const char* doing = w.doing.load();
+            out.printf("  %-8s %9u %9u %9u  %s\n", w.name, (unsigned)w.deadlineMs,
+                       busy ? (unsigned)(now - w.lastBeat.load()) : 0u, (unsigned)w.worstMs.load(),
+                       busy ? (doing ? doing : "running") : "waiting");
+        }
+    }
+
+    int getCount() const { return watchCount.load(std::memory_order_acquire); }
+    uint32_t getStalls() const { return stalls.get(); }
+    uint32_t getWorstMs(int id) const { return valid(id) ? watches[id].worstMs.load() : 0; }
+    uint32_t getBeats(int id) const { return valid(id) ? watches[id].beats.load() : 0; }
+    bool isBusy(int id) const { return valid(id) && watches[id].busy.load(); }
+};
+
+#endif // TASK_SUPERVISOR_H
@@ -0,0 +1,219 @@
+/*
+ * ============================================
+ * Text Layout - Word Wrap as Text Arrives
+ * ============================================
+ *
+ * Handles:
+ * - TextMetrics: the advance of every printable
+ *   ASCII character, looked up once per font
+ *   (the built-in 6x8 font at a size, or a
+ *   packed font from ui_assets.h) and read from
+ *   a table after that
+ * - TextLayout: text broken into lines that fit
+ *   a width, at spaces. A word wider than a
+ *   line is broken by character; '\n' always
+ *   breaks. Spaces at a break hang past the
+ *   width and are not part of either line
+ * - append(): text that comes in pieces (a
+ *   streamed transcript) is laid out as it
+ *   arrives. Lines above the last one never
+ *   change, so only the last is touched and
+ *   every character is measured once
+ * - Which line holds a character, for following
+ *   speech
+ *
+ * UiScene's text (ui_scene.h) wraps by
+ * character and stops at MAX_TEXT; this is for
+ * replies and jokes of any length up to
+ * MAX_CHARS, shown by text_scroller.h. More
+ * than fits is dropped and counted.
+ *
+ * No hardware access and no allocation: the
+ * host test and bench run it as is.
+ *
+ * ============================================
+ */
+
+#ifndef TEXT_LAYOUT_H
+#define TEXT_LAYOUT_H
+
+#include <stdint.h>
+#include <string.h>
+#include "ui_assets.h"
+
+class TextMetrics {
+public:
+    static const int COUNT = 95;             // ' ' to '~'
+
+private:
+    uint8_t advances[COUNT];
+    uint8_t other;               // Anything outside the table
+    uint8_t lineHeight;
+
+public:
+    TextMetrics() { builtin(1); }
+
+    // The built-in font: every character is one 6x8 cell
+    void builtin(uint8_t size) {
+        if (size < 1) size = 1;
+        memset(advances, 6 * size, sizeof(advances));
+        other = (uint8_t)(6 * size);
+        lineHeight = (uint8_t)(8 * size);
+    }
+
+    // A packed font: advances of its subset; characters outside it
+    // take no space (as uiTextExtent())
+    void packed(const UiFont& font) {
+        for (int i = 0; i < COUNT; i++) {
+            const UiGlyph* g = uiFindGlyph(font, (char)(' ' + i));
+            advances[i] = g ? g->advance : 0;
+        }
+        other = 0;
+        lineHeight = font.height;
+    }
+
+    uint8_t advance(char c) const {
+        uint8_t i = (uint8_t)((uint8_t)c - ' ');
+        return i < COUNT ? advances[i] : other;
+    }
+
+    uint8_t height() const { return lineHeight; }
+};
+
+// Characters [start, start + len) are drawn; width is their advance
+struct TextLine {
+    uint16_t start;
+    uint16_t len;
+    int16_t width;
+};
+
+class TextLayout {
+public:
+    static const int MAX_CHARS = 1024;
+    static const int MAX_LINES = 128;
+
+private:
+    TextMetrics metrics;
+    int16_t width;
+    char text[MAX_CHARS + 1];
+    uint16_t length;
+    TextLine lines[MAX_LINES];
+    int count;                   // The last line is still open
+    bool full;                   // Out of lines: the rest is dropped
+
+    // The open line
+    int16_t pen;                 // Advance so far, hanging spaces included
+    uint16_t wordStart;          // Where its last word starts
+    int16_t wordPen;             // pen there
+    uint16_t breakLen;           // The line's len and width if it ends before that word
+    int16_t breakWidth;
+
+    uint32_t measured;           // Characters placed since begin()
+    uint32_t dropped;            // Characters past MAX_CHARS or MAX_LINES
+
+    bool open(uint16_t start) {
+        if (count == MAX_LINES) return false;
+        lines[count++] = { start, 0, 0 };
+        pen = wordPen = breakWidth = 0;
+        wordStart = start;
+        breakLen = 0;
+        return true;
+    }
+
+    // Lays out text[i]; false if it needs a line past MAX_LINES
+    bool place(uint16_t i) {
+        char c = text[i];
+        measured++;
+        if (c == '\n') return open((uint16_t)(i + 1));
+        int16_t adv = metrics.advance(c);
+        if (c == ' ') {
+            pen = (int16_t)(pen + adv);      // Hangs until a word follows
+            return true;
+        }
+        TextLine* line = &lines[count - 1];
+        if (i > line->start && text[i - 1] == ' ') {
+            wordStart = i;
+            wordPen = pen;
+            breakLen = line->len;
+            breakWidth = line->width;
+        }
+        while (pen + adv > width && i > line->start) {
+            uint16_t from = i;               // Break before this character
+            int16_t carried = 0;
+            if (wordStart > line->start) {   // ... or before its word
+                from = wordStart;
+                carried = (int16_t)(pen - wordPen);
+                line->len = breakLen;
+                line->width = breakWidth;
+            }
+            if (!open(from)) return false;
+            line = &lines[count - 1];
+            line->len = (uint16_t)(i - from);
+            line->width = pen = carried;
+        }
+        pen = (int16_t)(pen + adv);
+        line->len = (uint16_t)(i + 1 - line->start);
+        line->width = pen;
+        return true;
+    }
+
+public:
+    TextLayout() { begin(TextMetrics(), 0); }
+
+    // Empty, lines at most maxWidth wide
+    void begin(const TextMetrics& m, int16_t maxWidth) {
+        metrics = m;
+        width = maxWidth;
+        length = 0;
+        text[0] = '\0';
+        count = 0;
+        full = false;
+        measured = dropped = 0;
+        open(0);
+    }
+
+    // Adds len characters (up to a '\0'). Returns the first line
+    // that changed; it and every line after it need drawing.
+    int append(const char* s, int len) {
+        int first = count - 1;
+        for (int i = 0; i < len && s[i]; i++) {
+            if (full || length == MAX_CHARS) {
+                dropped++;
+                continue;
+            }
+            text[length] = s[i] == '\r' || s[i] == '\t' ? ' ' : s[i];
+            if (!place(length)) {
+                text[length] = '\0';
+                full = true;
+                dropped++;
+                continue;
+            }
+            text[++length] = '\0';
+        }
+        return first;
+    }
+
+    int append(const char* s) { return append(s, s ? (int)strlen(s) : 0); }
+
+    // The line holding character i (the last line past the end)
+    int lineOf(int i) const {
+        int lo = 0, hi = count - 1;
+        while (lo < hi) {
+            int mid = (lo + hi + 1) / 2;
+            if (lines[mid].start <= i) lo = mid;
+            else hi = mid - 1;
+        }
+        return lo;
+    }
+
+    const char* getText() const { return text; }
+    int getLength() const { return length; }
+    int getLineCount() const { return count; }
+    const TextLine& getLine(int i) const { return lines[i]; }
+    const TextMetrics& getMetrics() const { return metrics; }
+    int16_t getWidth() const { return width; }
+    uint32_t getMeasured() const { return measured; }
+    uint32_t getDropped() const { return dropped; }
+};
+
+#endif // TEXT_LAYOUT_H
@@ -0,0 +1,215 @@
+/*
+ * ============================================
+ * Text Scroller - Long Text Following Speech
+ * ============================================
+ *
+ * Handles:
+ * - A TextLayout (text_layout.h) shown in a
+ *   band of full-width rows below a screen's
+ *   heading, in the built-in font
+ * - Hardware vertical scroll where the display
+ *   has it (the ST7789 through TftUiDisplay):
+ *   the band is a ring of rows, scrolling moves
+ *   where the ring starts, and only the rows
+ *   coming into view are drawn, into the rows
+ *   going out. Elsewhere each step redraws the
+ *   band
+ * - follow(): the line being said is
+ *   highlighted and the window glides (a few
+ *   rows a frame) to keep it a third of the way
+ *   down, karaoke style
+ * - append(): text that arrives while shown;
+ *   only the changed lines in view are drawn
+ * - Pixels sent, per call and in total
+ *
+ * Moving a 280-row band on the 172x320 panel a
+ * row sends one row of 172 pixels; redrawing
+ * the band would send 96 KB. The band is drawn
+ * straight to the display, not through the
+ * scene: the screen's heading is a UiScene
+ * (ui_scene.h) above it, and the scene must not
+ * flush over the band until stop(), which puts
+ * the rows back where they were. After that
+ * the band's rows hold whatever was drawn last,
+ * so the scene has to repaint everything
+ * (UiScene::invalidate()).
+ *
+ * Call from one task (ui).
+ *
+ * ============================================
+ */
+
+#ifndef TEXT_SCROLLER_H
+#define TEXT_SCROLLER_H
+
+#include <stdint.h>
+#include "ui_scene.h"
+#include "text_layout.h"
+
+struct TextStyle {
+    uint8_t size;                // Built-in font
+    uint16_t color;
+    uint16_t spokenColor;        // The line being said
+    uint16_t background;
+};
+
+class TextScroller {
+public:
+    static const int16_t MARGIN = 8;         // Left and right of the text
+    static const int16_t STEP_ROWS = 2;      // Most the window moves a frame
+
+private:
+    TextLayout layout;
+    UiRect band;
+    TextStyle style;
+    int16_t lineH;
+    bool running;
+    bool hardware;               // The display scrolls the band itself
+    int32_t top;                 // Content row at the top of the band
+    int spoken;                  // Highlighted line, -1 none
+
+    uint32_t pixels;             // Since start()
+    uint32_t lastPixels;         // The last call
+    uint32_t scrolls;            // Steps the window moved
+
+    // Band row holding content row c (c in view)
+    int16_t rowOf(int32_t c) const { return (int16_t)(hardware ? c % band.h : c - top); }
+
+    // Content rows [from, to), the part in view, into their band rows
+    void paintRows(UiDisplay& d, int32_t from, int32_t to) {
+        if (from < top) from = top;
+        if (to > top + band.h) to = top + band.h;
+        const char* text = layout.getText();
+        while (from < to) {
+            int16_t row = rowOf(from);
+            int32_t n = to - from;
+            if (n > band.h - row) n = band.h - row;          // Up to where the ring wraps
+            UiRect clip = { band.x, (int16_t)(band.y + row), band.w, (int16_t)n };
+            int32_t shift = band.y + row - from;             // Screen y of content row 0
+            d.fillRect(clip, style.background);
+            lastPixels += (uint32_t)clip.area();
+            int last = (int)((from + n - 1) / lineH);
+            for (int i = (int)(from / lineH); i <= last && i < layout.getLineCount(); i++) {
+                const TextLine& line = layout.getLine(i);
+                if (line.len == 0) continue;
+                d.drawText((int16_t)(band.x + MARGIN), (int16_t)(i * lineH + shift + style.size), style.size,
+                           i == spoken ? style.spokenColor : style.color, text + line.start, line.len, clip);
+            }
+            from += n;
+        }
+    }
+
+    void paintLine(UiDisplay& d, int i) {
+        if (i >= 0) paintRows(d, (int32_t)i * lineH, (int32_t)(i + 1) * lineH);
+    }
+
+    // Lowest the top can go: the last line at the bottom
+    int32_t maxTop() const {
+        int32_t h = (int32_t)layout.getLineCount() * lineH - band.h;
+        return h > 0 ? h : 0;
+    }
+
+    void scrollTo(UiDisplay& d, int32_t to) {
+        if (to == top) return;
+        int32_t from = top;
+        top = to;
+        scrolls++;
+        if (!hardware) {
+            paintRows(d, top, top + band.h);
+            return;
+        }
+        // What comes into view goes where what leaves was
+        if (to > from) paintRows(d, from + band.h > to ? from + band.h : to, to + band.h);
+        else paintRows(d, to, from < to + band.h ? from : to + band.h);
+        d.scrollRows(band.y, band.h, rowOf(top));
+    }
+
+    void beginDraw(UiDisplay& d) {
+        d.beginFrame();
+        lastPixels = 0;
+    }
+
+    uint32_t endDraw(UiDisplay& d) {
+        d.endFrame();
+        pixels += lastPixels;
+        return lastPixels;
+    }
+
+public:
+    TextScroller()
+        : band{ 0, 0, 0, 0 }, style{ 1, UI_WHITE, UI_YELLOW, UI_BLACK }, lineH(10), running(false),
+          hardware(false), top(0), spoken(-1), pixels(0), lastPixels(0), scrolls(0) {}
+
+    // Takes over band (full width of the screen) and shows text
+    // from its first line; more can follow with append()
+    void start(UiDisplay& d, const UiRect& area, const TextStyle& s, const char* text) {
+        band = area;
+        style = s;
+        if (style.size < 1) style.size = 1;
+        lineH = (int16_t)(UiScene::CHAR_H * style.size + 2 * style.size);
+        TextMetrics metrics;
+        metrics.builtin(style.size);
+        layout.begin(metrics, (int16_t)(band.w - 2 * MARGIN));
+        layout.append(text);
+        top = 0;
+        spoken = -1;
+        pixels = scrolls = 0;
+        running = true;
+        beginDraw(d);
+        hardware = d.scrollRows(band.y, band.h, 0);
+        paintRows(d, 0, band.h);
+        endDraw(d);
+    }
+
+    // More text; draws the lines it changed. Returns pixels sent.
+    uint32_t append(UiDisplay& d, const char* s, int len) {
+        if (!running) return 0;
+        beginDraw(d);
+        int first = layout.append(s, len);
+        paintRows(d, (int32_t)first * lineH, (int32_t)layout.getLineCount() * lineH);
+        return endDraw(d);
+    }
+
+    // Highlights the line holding character at (-1: none) and moves
+    // the window a step toward it. Returns pixels sent.
+    uint32_t follow(UiDisplay& d, int at) {
+        if (!running) return 0;
+        beginDraw(d);
+        int line = at < 0 ? -1 : layout.lineOf(at);
+        if (line != spoken) {
+            int old = spoken;
+            spoken = line;
+            paintLine(d, old);
+            paintLine(d, line);
+        }
+        int32_t want = line < 0 ? 0 : (int32_t)line * lineH - band.h / 3;
+        if (want > maxTop()) want = maxTop();
+        if (want < 0) want = 0;
+        int32_t step = want - top;
+        if (step > band.h || step < -band.h) scrollTo(d, want);            // Too far to glide
+        else if (step > STEP_ROWS) scrollTo(d, top + STEP_ROWS);
+        else if (step < -STEP_ROWS) scrollTo(d, top - STEP_ROWS);
+        else scrollTo(d, want);
+        return endDraw(d);
+    }
+
+    // Gives the band back, rows where they were
+    void stop(UiDisplay& d) {
+        if (!running) return;
+        if (hardware) d.scrollRows(band.y, band.h, 0);
+        running = false;
+    }
+
+    bool isRunning() const { return running; }
+    bool isHardware() const { return hardware; }
+    const TextLayout& getLayout() const { return layout; }
+    int getLength() const { return layout.getLength(); }
+    int getSpokenLine() const { return spoken; }
+    int32_t getTop() const { return top; }
+    int16_t getLineHeight() const { return lineH; }
+    uint32_t getPixels() const { return pixels; }
+    uint32_t getLastPixels() const { return lastPixels; }
+    uint32_t getScrolls() const { return scrolls; }
+};
+
+#endif // TEXT_SCROLLER_H
@@ -0,0 +1,319 @@
+/*
+ * ============================================
+ * Turn Arena - Per-Conversation Scratch Memory
+ * ============================================
+ *
+ * Handles:
+ * - Bump allocation for one conversation turn
+ * - Fixed-capacity string builders (no String churn)
+ * - O(1) reset at the end of every turn
+ * - Allocation statistics for soak testing
+ *
+ * The arena owns one block that is allocated once
+ * at startup and never freed, so request headers,
+ * JSON documents and response bodies no longer
+ * fragment the heap between turns.
+ *
+ * ============================================
+ */
+
+#ifndef TURN_ARENA_H
+#define TURN_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+// ============================================
+// STRING BUILDER
+// ============================================
+
+// Appends into a caller-provided buffer. Never allocates;
+// on overflow the text is truncated and overflowed() is set.
+class StrBuilder {
+protected:
+    char* buf;
+    size_t cap;
+    size_t len;
+    bool overflow;
+
+public:
+    StrBuilder() : buf(nullptr), cap(0), len(0), overflow(false) {}
+    StrBuilder(char* storage, size_t capacity)
+        : buf(storage), cap(capacity), len(0), overflow(false) {
+        if (buf && cap > 0) buf[0] = '\0';
+    }
+
+    StrBuilder& append(const char* s, size_t n) {
+        if (!buf || cap == 0) {
+            overflow = overflow || n > 0;
+            return *this;
+        }
+        size_t room = cap - 1 - len;
+        if (n > room) {
+            n = room;
+            overflow = true;
+        }
+        memcpy(buf + len, s, n);
+        len += n;
+        buf[len] = '\0';
+        return *this;
+    }
+
+    StrBuilder& append(const char* s) {
+        return s ? append(s, strlen(s)) : *this;
+    }
+
+    StrBuilder& append(char c) {
+        return append(&c, 1);
+    }
+
+    StrBuilder& append(long value) {
+        char tmp[24];
+        int n = snprintf(tmp, sizeof(tmp), "%ld", value);
+        return append(tmp, n > 0 ? (size_t)n : 0);
+    }
+
+    StrBuilder& appendf(const char* fmt, ...) {
+        if (!buf || cap == 0) {
+            overflow = true;
+            return *this;
+        }
+        va_list args;
+        va_start(args, fmt);
+        int n = vsnprintf(buf + len, cap - len, fmt, args);
+        va_end(args);
+        if (n < 0) {
+            buf[len] = '\0';
+            overflow = true;
+        } else if ((size_t)n >= cap - len) {
+            len = cap - 1;
+            overflow = true;
+        } else {
+            len += n;
+        }
+        return *this;
+    }
+
+    // Used after writing directly into data() (e.g. socket reads)
+    void commit(size_t n) {
+        len += n;
+        if (len > cap - 1) {
+            len = cap - 1;
+            overflow = true;
+        }
+        buf[len] = '\0';
+    }
+
+    void clear() {
+        len = 0;
+        overflow = false;
+        if (buf && cap > 0) buf[0] = '\0';
+    }
+
+    const char* c_str() const { return buf ? buf : ""; }
+    char* data() { return buf; }
+    size_t length() const { return len; }
+    size_t capacity() const { return cap; }
+    size_t remaining() const { return cap > 0 ? cap - 1 - len : 0; }
+    bool overflowed() const { return overflow; }
+    bool isEmpty() const { return len == 0; }
+};
+
+// Builder with inline storage for short, bounded strings
+// such as HTTP header lines and multipart boundaries.
+template <size_t N>
+class FixedString : public StrBuilder {
+private:
+    char storage[N];
+
+public:
+    FixedString() : StrBuilder(storage, N) {}
+    FixedString(const FixedString& other) : StrBuilder(storage, N) {
+        append(other.c_str(), other.length());
+    }
+    FixedString& operator=(const FixedString& other) {
+        if (this != &other) {
+            clear();
+            append(other.c_str(), other.length());
+        }
+        return *this;
+    }
+};
+
+// ============================================
+// TURN ARENA
+// ============================================
+
+struct ArenaStats {
+    size_t capacity;
+    size_t used;
+    size_t highWater;       // Peak bytes used in any turn
+    uint32_t turnAllocs;    // Allocations in the current turn
+    uint32_t totalAllocs;   // Allocations since boot
+    uint32_t failedAllocs;  // Requests that did not fit
+    uint32_t turns;         // Completed resets
+};
+
+class TurnArena {
+private:
+    uint8_t* base;
+    size_t cap;
+    size_t offset;
+    size_t lastOffset;   // Start of the most recent allocation
+    size_t highWater;
+    uint32_t turnAllocs;
+    uint32_t totalAllocs;
+    uint32_t failedAllocs;
+    uint32_t turns;
+
+    static size_t alignUp(size_t value, size_t align) {
+        return (value + align - 1) & ~(align - 1);
+    }
+
+public:
+    static const size_t DEFAULT_ALIGN = 8;
+
+    TurnArena() : base(nullptr), cap(0), offset(0), lastOffset(0), highWater(0),
+                  turnAllocs(0), totalAllocs(0), failedAllocs(0), turns(0) {}
+
+    // Hand the arena its backing block. The arena never frees it.
+    void attach(void* block, size_t size) {
+        base = (uint8_t*)block;
+        cap = block ? size : 0;
+        offset = 0;
+        lastOffset = 0;
+    }
+
+    // Take the backing block back (e.g. to return it to a pool)
+    void* detach() {
+        void* block = base;
+        attach(nullptr, 0);
+        return block;
+    }
+
+    bool isReady() const {
+        return base != nullptr;
+    }
+
+    void* alloc(size_t size, size_t align = DEFAULT_ALIGN) {
+        size_t start = alignUp(offset, align);
+        if (!base || size == 0 || start > cap || size > cap - start) {
+            failedAllocs++;
+            return nullptr;
+        }
+        lastOffset = start;
+        offset = start + size;
+        if (offset > highWater) highWater = offset;
+        turnAllocs++;
+        totalAllocs++;
+        return base + start;
+    }
+
+    // Grow or shrink the most recent allocation in place.
+    // Returns nullptr if p is not the top of the arena or it won't fit.
+    void* resizeLast(void* p, size_t size) {
+        if (!p || (uint8_t*)p != base + lastOffset || size > cap - lastOffset) {
+            failedAllocs++;
+            return nullptr;
+        }
+        offset = lastOffset + size;
+        if (offset > highWater) highWater = offset;
+        return p;
+    }
+
+    // Builder backed by arena memory. Capacity 0 takes all that is left.
+    StrBuilder builder(size_t capacity = 0) {
+        if (capacity == 0) {
+            capacity = remaining();
+        }
+        char* p = (char*)alloc(capacity, 1);
+        return p ? StrBuilder(p, capacity) : StrBuilder();
+    }
+
+    // Give back the unused tail of the most recent builder
+    void shrinkTo(const StrBuilder& b) {
+        if (b.capacity() > 0) {
+            resizeLast((void*)b.c_str(), b.length() + 1);
+        }
+    }
+
+    const char* copy(const char* s, size_t n) {
+        char* p = (char*)alloc(n + 1, 1);
+        if (!p) return nullptr;
+        memcpy(p, s, n);
+        p[n] = '\0';
+        return p;
+    }
+
+    const char* copy(const char* s) {
+        return s ? copy(s, strlen(s)) : nullptr;
+    }
+
+    // Scoped scratch: everything allocated after mark() is
+    // released by rewind(), earlier results stay valid.
+    size_t mark() const {
+        return offset;
+    }
+
+    void rewind(size_t m) {
+        if (m <= offset) {
+            offset = m;
+            lastOffset = m;
+        }
+    }
+
+    // Everything handed out this turn becomes invalid. O(1).
+    void reset() {
+        offset = 0;
+        lastOffset = 0;
+        turnAllocs = 0;
+        turns++;
+    }
+
+    size_t used() const { return offset; }
+    size_t remaining() const { return cap - offset; }
+    size_t capacity() const { return cap; }
+
+    ArenaStats getStats() const {
+        ArenaStats s;
+        s.capacity = cap;
+        s.used = offset;
+        s.highWater = highWater;
+        s.turnAllocs = turnAllocs;
+        s.totalAllocs = totalAllocs;
+        s.failedAllocs = failedAllocs;
+        s.turns = turns;
+        return s;
+    }
+};
+
+// ============================================
+// ARDUINOJSON ADAPTER
+// ============================================
+
+// Allocator for BasicJsonDocument<ArenaJsonAllocator>. Documents
+// built with it live in the current turn's arena; deallocate is a
+// no-op because the whole arena is released by reset().
+struct ArenaJsonAllocator {
+    static TurnArena*& current() {
+        static TurnArena* arena = nullptr;
+        return arena;
+    }
+
+    void* allocate(size_t size) {
+        TurnArena* arena = current();
+        return arena ? arena->alloc(size) : nullptr;
+    }
+
+    void deallocate(void*) {}
+
+    void* reallocate(void* p, size_t size) {
+        TurnArena* arena = current();
+        return arena ? arena->resizeLast(p, size) : nullptr;
+    }
+};
+
+#endif // TURN_ARENA_H
@@ -0,0 +1,160 @@
+/*
+ * ============================================
+ * UI Assets - Packed Icons and Font Subsets
+ * ============================================
+ *
+ * Handles:
+ * - UiImage: an icon as runs of palette
+ *   indices (index 0 transparent), up to 15
+ *   RGB565 colors
+ * - UiFont: the characters a screen needs from
+ *   a bigger font, each glyph as pairs of runs
+ *   (transparent, ink)
+ * - Walking the runs of the rows being drawn:
+ *   each run is handed to the caller as one
+ *   span, nothing is decoded ahead of it. An
+ *   image's row index skips the rows above a
+ *   tile without decoding them
+ * - Glyph lookup and text extent
+ *
+ * The tables are made on the host by
+ * host/ui_assets.py from the PNGs and BDF fonts
+ * in assets/ and live in ui_assets_data.h as
+ * constexpr data: flash only, no copy in RAM.
+ * UiScene (ui_scene.h) draws them as widgets;
+ * with the sprites (ui_sprites.h) each span is
+ * written into the tile about to be pushed, so
+ * there is no decompression buffer at all.
+ *
+ * Formats (see host/ui_assets.py):
+ *   image byte  index << 4 | (length - 1);
+ *               length - 1 of 15: the next
+ *               byte adds 0-255. Every row
+ *               starts on a byte
+ *   glyph byte  transparent << 4 | ink, row
+ *               after row through the glyph
+ *
+ * ============================================
+ */
+
+#ifndef UI_ASSETS_H
+#define UI_ASSETS_H
+
+#include <stdint.h>
+
+static const int UI_IMAGE_ROW_STEP = 8;   // Rows between row index entries
+
+struct UiImage {
+    uint16_t w, h;
+    const uint16_t* palette;     // RGB565 by index; [0] unused
+    const uint8_t* data;         // Runs
+    const uint16_t* rows;        // Offset of every UI_IMAGE_ROW_STEP-th row; nullptr if h <= step
+    uint32_t bytes;
+};
+
+struct UiGlyph {
+    uint16_t offset;             // Into the font's data
+    uint8_t w, h;
+    int8_t x;                    // Ink from the pen
+    int8_t y;                    // Ink from the top of the line
+    uint8_t advance;
+};
+
+struct UiFont {
+    const char* chars;           // The subset, sorted
+    uint8_t count;
+    uint8_t height;              // Line
+    uint8_t ascent;
+    const UiGlyph* glyphs;       // In the order of chars
+    const uint8_t* data;
+    uint32_t bytes;
+};
+
+// The glyph for c, nullptr if c is not in the subset
+inline const UiGlyph* uiFindGlyph(const UiFont& font, char c) {
+    int lo = 0, hi = font.count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (font.chars[mid] == c) return &font.glyphs[mid];
+        if ((uint8_t)font.chars[mid] < (uint8_t)c) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return nullptr;
+}
+
+// Columns len characters of s cover from a pen at 0, advances
+// and ink: [*left, *right). Characters not in the font take no
+// space.
+inline void uiTextExtent(const UiFont& font, const char* s, int len, int16_t* left, int16_t* right) {
+    int16_t pen = 0, lo = 0, hi = 0;
+    for (int i = 0; i < len; i++) {
+        const UiGlyph* g = uiFindGlyph(font, s[i]);
+        if (!g) continue;
+        if (g->w > 0 && pen + g->x < lo) lo = (int16_t)(pen + g->x);
+        if (g->w > 0 && pen + g->x + g->w > hi) hi = (int16_t)(pen + g->x + g->w);
+        pen = (int16_t)(pen + g->advance);
+    }
+    *left = lo;
+    *right = pen > hi ? pen : hi;
+}
+
+inline int16_t uiTextWidth(const UiFont& font, const char* s, int len) {
+    int16_t left, right;
+    uiTextExtent(font, s, len, &left, &right);
+    return (int16_t)(right - left);
+}
+
+// Calls span(x, y, n, color) for each opaque run in rows [top,
+// bottom) of img, in image coordinates
+template <typename Span>
+inline void uiImageRuns(const UiImage& img, int16_t top, int16_t bottom, Span span) {
+    if (top < 0) top = 0;
+    if (bottom > (int16_t)img.h) bottom = (int16_t)img.h;
+    if (top >= bottom) return;
+    int16_t y = 0;
+    const uint8_t* p = img.data;
+    if (img.rows) {
+        y = (int16_t)(top / UI_IMAGE_ROW_STEP * UI_IMAGE_ROW_STEP);
+        p += img.rows[top / UI_IMAGE_ROW_STEP];
+    }
+    for (; y < bottom; y++) {
+        int16_t x = 0;
+        while (x < (int16_t)img.w) {
+            uint8_t b = *p++;
+            int16_t n = (int16_t)((b & 15) + 1);
+            if ((b & 15) == 15) n = (int16_t)(n + *p++);
+            uint8_t index = b >> 4;
+            if (index && y >= top) span(x, y, n, img.palette[index]);
+            x = (int16_t)(x + n);
+        }
+    }
+}
+
+// Calls span(x, y, n) for each ink run in rows [top, bottom) of
+// a glyph, in glyph coordinates
+template <typename Span>
+inline void uiGlyphRuns(const UiFont& font, const UiGlyph& g, int16_t top, int16_t bottom, Span span) {
+    if (bottom > (int16_t)g.h) bottom = (int16_t)g.h;
+    if (g.w == 0 || top >= bottom) return;
+    const uint8_t* p = font.data + g.offset;
+    int16_t x = 0, y = 0;
+    while (y < bottom) {
+        uint8_t b = *p++;
+        // Transparent, then ink, each maybe past the end of a row
+        for (int part = 0; part < 2; part++) {
+            int16_t n = (int16_t)(part == 0 ? b >> 4 : b & 15);
+            while (n > 0 && y < bottom) {
+                int16_t take = (int16_t)(g.w - x) < n ? (int16_t)(g.w - x) : n;
+                if (part == 1 && y >= top) span(x, y, take);
+                x = (int16_t)(x + take);
+                n = (int16_t)(n - take);
+                if (x == (int16_t)g.w) {
+                    x = 0;
+                    y++;
+                }
+            }
+        }
+    }
+}
+
+#endif // UI_ASSETS_H
@@ -0,0 +1,218 @@
+/*
+ * ============================================
+ * UI Assets - Generated, Do Not Edit
+ * ============================================
+ *
+ * Made by host/ui_assets.py from assets/manifest.txt:
+ *   python3 host/ui_assets.py assets/manifest.txt ui_assets_data.h
+ *
+ * Flash bytes per asset (raw: RGB565 for
+ * images, 1-bit bitmaps for fonts):
+ *
+ *   asset                                 flash    raw
+ *   ICON_WIFI          22x16, 1 color        75    704
+ *   ICON_WIFI_OFF      22x16, 2 colors       99    704
+ *   ICON_BATTERY_FULL  26x14, 2 colors       72    728
+ *   ICON_BATTERY_HALF  26x14, 2 colors       72    728
+ *   ICON_BATTERY_LOW   26x14, 2 colors       72    728
+ *   ICON_HEART         24x21, 3 colors      130   1008
+ *   ICON_STAR          28x27, 2 colors      149   1512
+ *   FONT_TITLE         48 px, 4 glyphs      247    480
+ *   FONT_HEADING       27 px, 30 glyphs     824   1189
+ *
+ * ============================================
+ */
+
+#ifndef UI_ASSETS_DATA_H
+#define UI_ASSETS_DATA_H
+
+#include <stdint.h>
+#include "ui_assets.h"
+
+// ICON_WIFI: 22x16, 1 color, 75 bytes (704 as RGB565)
+static constexpr uint16_t ICON_WIFI_PALETTE[] = { 0x0000, 0x06FF };
+static constexpr uint8_t ICON_WIFI_DATA[] = {
+    0x03, 0x1D, 0x03, 0x02, 0x12, 0x09, 0x12, 0x02, 0x00, 0x12, 0x0D, 0x12, 0x00, 0x12, 0x03, 0x17,
+    0x03, 0x12, 0x11, 0x02, 0x1B, 0x02, 0x11, 0x02, 0x14, 0x05, 0x14, 0x02, 0x02, 0x12, 0x09, 0x12,
+    0x02, 0x03, 0x10, 0x02, 0x15, 0x02, 0x10, 0x03, 0x06, 0x17, 0x06, 0x05, 0x13, 0x01, 0x13, 0x05,
+    0x06, 0x10, 0x05, 0x10, 0x06, 0x0F, 0x06, 0x09, 0x11, 0x09, 0x08, 0x13, 0x08, 0x08, 0x13, 0x08,
+    0x09, 0x11, 0x09,
+};
+static constexpr uint16_t ICON_WIFI_ROWS[] = { 0, 40 };
+static constexpr UiImage ICON_WIFI = { 22, 16, ICON_WIFI_PALETTE, ICON_WIFI_DATA, ICON_WIFI_ROWS, sizeof(ICON_WIFI_DATA) };
+
+// ICON_WIFI_OFF: 22x16, 2 colors, 99 bytes (704 as RGB565)
+static constexpr uint16_t ICON_WIFI_OFF_PALETTE[] = { 0x0000, 0xF800, 0x8410 };
+static constexpr uint8_t ICON_WIFI_OFF_DATA[] = {
+    0x11, 0x01, 0x2D, 0x03, 0x00, 0x11, 0x22, 0x09, 0x22, 0x02, 0x00, 0x20, 0x12, 0x0C, 0x22, 0x00,
+    0x22, 0x00, 0x11, 0x00, 0x27, 0x03, 0x22, 0x21, 0x02, 0x11, 0x29, 0x02, 0x21, 0x02, 0x22, 0x12,
+    0x04, 0x24, 0x02, 0x02, 0x22, 0x01, 0x11, 0x05, 0x22, 0x02, 0x03, 0x20, 0x02, 0x20, 0x12, 0x21,
+    0x02, 0x20, 0x03, 0x06, 0x22, 0x12, 0x21, 0x06, 0x05, 0x23, 0x01, 0x11, 0x21, 0x05, 0x06, 0x20,
+    0x04, 0x12, 0x05, 0x0E, 0x11, 0x04, 0x09, 0x21, 0x03, 0x11, 0x03, 0x08, 0x23, 0x03, 0x12, 0x01,
+    0x08, 0x23, 0x05, 0x11, 0x00, 0x09, 0x21, 0x07, 0x11,
+};
+static constexpr uint16_t ICON_WIFI_OFF_ROWS[] = { 0, 51 };
+static constexpr UiImage ICON_WIFI_OFF = { 22, 16, ICON_WIFI_OFF_PALETTE, ICON_WIFI_OFF_DATA, ICON_WIFI_OFF_ROWS, sizeof(ICON_WIFI_OFF_DATA) };
+
+// ICON_BATTERY_FULL: 26x14, 2 colors, 72 bytes (728 as RGB565)
+static constexpr uint16_t ICON_BATTERY_FULL_PALETTE[] = { 0x0000, 0xFFFF, 0x06E0 };
+static constexpr uint8_t ICON_BATTERY_FULL_DATA[] = {
+    0x1F, 0x07, 0x02, 0x1F, 0x07, 0x02, 0x11, 0x0F, 0x03, 0x11, 0x02, 0x11, 0x0F, 0x03, 0x11, 0x02,
+    0x11, 0x01, 0x2F, 0x01, 0x14, 0x11, 0x01, 0x2F, 0x01, 0x14, 0x11, 0x01, 0x2F, 0x01, 0x14, 0x11,
+    0x01, 0x2F, 0x01, 0x14, 0x11, 0x01, 0x2F, 0x01, 0x14, 0x11, 0x01, 0x2F, 0x01, 0x14, 0x11, 0x0F,
+    0x03, 0x11, 0x02, 0x11, 0x0F, 0x03, 0x11, 0x02, 0x1F, 0x07, 0x02, 0x1F, 0x07, 0x02,
+};
+static constexpr uint16_t ICON_BATTERY_FULL_ROWS[] = { 0, 36 };
+static constexpr UiImage ICON_BATTERY_FULL = { 26, 14, ICON_BATTERY_FULL_PALETTE, ICON_BATTERY_FULL_DATA, ICON_BATTERY_FULL_ROWS, sizeof(ICON_BATTERY_FULL_DATA) };
+
+// ICON_BATTERY_HALF: 26x14, 2 colors, 72 bytes (728 as RGB565)
+static constexpr uint16_t ICON_BATTERY_HALF_PALETTE[] = { 0x0000, 0xFFFF, 0xFEE0 };
+static constexpr uint8_t ICON_BATTERY_HALF_DATA[] = {
+    0x1F, 0x07, 0x02, 0x1F, 0x07, 0x02, 0x11, 0x0F, 0x03, 0x11, 0x02, 0x11, 0x0F, 0x03, 0x11, 0x02,
+    0x11, 0x01, 0x27, 0x08, 0x14, 0x11, 0x01, 0x27, 0x08, 0x14, 0x11, 0x01, 0x27, 0x08, 0x14, 0x11,
+    0x01, 0x27, 0x08, 0x14, 0x11, 0x01, 0x27, 0x08, 0x14, 0x11, 0x01, 0x27, 0x08, 0x14, 0x11, 0x0F,
+    0x03, 0x11, 0x02, 0x11, 0x0F, 0x03, 0x11, 0x02, 0x1F, 0x07, 0x02, 0x1F, 0x07, 0x02,
+};
+static constexpr uint16_t ICON_BATTERY_HALF_ROWS[] = { 0, 36 };
+static constexpr UiImage ICON_BATTERY_HALF = { 26, 14, ICON_BATTERY_HALF_PALETTE, ICON_BATTERY_HALF_DATA, ICON_BATTERY_HALF_ROWS, sizeof(ICON_BATTERY_HALF_DATA) };
+
+// ICON_BATTERY_LOW: 26x14, 2 colors, 72 bytes (728 as RGB565)
+static constexpr uint16_t ICON_BATTERY_LOW_PALETTE[] = { 0x0000, 0xFFFF, 0xF800 };
+static constexpr uint8_t ICON_BATTERY_LOW_DATA[] = {
+    0x1F, 0x07, 0x02, 0x1F, 0x07, 0x02, 0x11, 0x0F, 0x03, 0x11, 0x02, 0x11, 0x0F, 0x03, 0x11, 0x02,
+    0x11, 0x01, 0x22, 0x0D, 0x14, 0x11, 0x01, 0x22, 0x0D, 0x14, 0x11, 0x01, 0x22, 0x0D, 0x14, 0x11,
+    0x01, 0x22, 0x0D, 0x14, 0x11, 0x01, 0x22, 0x0D, 0x14, 0x11, 0x01, 0x22, 0x0D, 0x14, 0x11, 0x0F,
+    0x03, 0x11, 0x02, 0x11, 0x0F, 0x03, 0x11, 0x02, 0x1F, 0x07, 0x02, 0x1F, 0x07, 0x02,
+};
+static constexpr uint16_t ICON_BATTERY_LOW_ROWS[] = { 0, 36 };
+static constexpr UiImage ICON_BATTERY_LOW = { 26, 14, ICON_BATTERY_LOW_PALETTE, ICON_BATTERY_LOW_DATA, ICON_BATTERY_LOW_ROWS, sizeof(ICON_BATTERY_LOW_DATA) };
+
+// ICON_HEART: 24x21, 3 colors, 130 bytes (1008 as RGB565)
+static constexpr uint16_t ICON_HEART_PALETTE[] = { 0x0000, 0x9003, 0xE8C6, 0xFD16 };
+static constexpr uint8_t ICON_HEART_DATA[] = {
+    0x04, 0x12, 0x07, 0x12, 0x04, 0x02, 0x11, 0x22, 0x11, 0x03, 0x11, 0x22, 0x11, 0x02, 0x01, 0x10,
+    0x26, 0x10, 0x01, 0x10, 0x26, 0x10, 0x01, 0x00, 0x10, 0x28, 0x11, 0x28, 0x10, 0x00, 0x00, 0x10,
+    0x22, 0x31, 0x2E, 0x10, 0x00, 0x10, 0x22, 0x31, 0x2F, 0x01, 0x10, 0x10, 0x22, 0x30, 0x2F, 0x02,
+    0x10, 0x10, 0x2F, 0x06, 0x10, 0x00, 0x10, 0x2F, 0x04, 0x10, 0x00, 0x00, 0x10, 0x2F, 0x04, 0x10,
+    0x00, 0x01, 0x10, 0x2F, 0x02, 0x10, 0x01, 0x02, 0x11, 0x2D, 0x11, 0x02, 0x04, 0x10, 0x2B, 0x10,
+    0x04, 0x05, 0x10, 0x29, 0x10, 0x05, 0x06, 0x10, 0x27, 0x10, 0x06, 0x07, 0x10, 0x25, 0x10, 0x07,
+    0x08, 0x10, 0x23, 0x10, 0x08, 0x09, 0x10, 0x21, 0x10, 0x09, 0x09, 0x10, 0x21, 0x10, 0x09, 0x0A,
+    0x11, 0x0A, 0x0F, 0x08,
+};
+static constexpr uint16_t ICON_HEART_ROWS[] = { 0, 53, 96 };
+static constexpr UiImage ICON_HEART = { 24, 21, ICON_HEART_PALETTE, ICON_HEART_DATA, ICON_HEART_ROWS, sizeof(ICON_HEART_DATA) };
+
+// ICON_STAR: 28x27, 2 colors, 149 bytes (1512 as RGB565)
+static constexpr uint16_t ICON_STAR_PALETTE[] = { 0x0000, 0xE3C0, 0xFEE0 };
+static constexpr uint8_t ICON_STAR_DATA[] = {
+    0x0F, 0x0C, 0x0C, 0x10, 0x0D, 0x0C, 0x10, 0x0D, 0x0B, 0x10, 0x20, 0x10, 0x0C, 0x0B, 0x10, 0x20,
+    0x10, 0x0C, 0x0B, 0x10, 0x20, 0x10, 0x0C, 0x0A, 0x10, 0x22, 0x10, 0x0B, 0x0A, 0x10, 0x22, 0x10,
+    0x0B, 0x09, 0x10, 0x24, 0x10, 0x0A, 0x09, 0x10, 0x24, 0x10, 0x0A, 0x00, 0x18, 0x26, 0x18, 0x01,
+    0x01, 0x10, 0x2F, 0x05, 0x10, 0x02, 0x02, 0x10, 0x2F, 0x03, 0x10, 0x03, 0x03, 0x10, 0x2F, 0x01,
+    0x10, 0x04, 0x04, 0x11, 0x2C, 0x11, 0x05, 0x06, 0x10, 0x2A, 0x10, 0x07, 0x07, 0x10, 0x28, 0x10,
+    0x08, 0x06, 0x10, 0x2A, 0x10, 0x07, 0x06, 0x10, 0x2A, 0x10, 0x07, 0x06, 0x10, 0x2A, 0x10, 0x07,
+    0x06, 0x10, 0x23, 0x12, 0x23, 0x10, 0x07, 0x05, 0x10, 0x22, 0x11, 0x02, 0x11, 0x22, 0x10, 0x06,
+    0x05, 0x10, 0x21, 0x10, 0x06, 0x10, 0x21, 0x10, 0x06, 0x05, 0x12, 0x08, 0x12, 0x06, 0x05, 0x10,
+    0x0C, 0x10, 0x06, 0x0F, 0x0C, 0x0F, 0x0C,
+};
+static constexpr uint16_t ICON_STAR_ROWS[] = { 0, 33, 76, 126 };
+static constexpr UiImage ICON_STAR = { 28, 27, ICON_STAR_PALETTE, ICON_STAR_DATA, ICON_STAR_ROWS, sizeof(ICON_STAR_DATA) };
+
+// FONT_TITLE: 48 px, 4 glyphs, 247 bytes (480 as 1-bit bitmaps)
+static constexpr UiGlyph FONT_TITLE_GLYPHS[] = {
+    { 0, 21, 29, 4, 9, 25 },    // 'L'
+    { 32, 30, 31, 2, 8, 34 },    // 'O'
+    { 93, 27, 29, 0, 9, 27 },    // 'T'
+    { 150, 31, 29, 0, 9, 31 },    // 'V'
+};
+static constexpr uint8_t FONT_TITLE_DATA[] = {
+    0x07, 0xE7, 0xE7, 0xE7, 0xE7, 0xE7, 0xE7, 0xE7, 0xE7, 0xE7, 0xE7, 0xE7, 0xE7, 0xE7, 0xE7, 0xE7,
+    0xE7, 0xE7, 0xE7, 0xE7, 0xE7, 0xE7, 0xE7, 0xEF, 0x05, 0x1F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F,
+    0xC6, 0xF0, 0x5E, 0xEF, 0x03, 0xBF, 0x05, 0x9F, 0x07, 0x7F, 0x09, 0x5A, 0x6A, 0x48, 0xA8, 0x39,
+    0xA9, 0x28, 0xC8, 0x28, 0xC8, 0x18, 0xEF, 0x01, 0xEF, 0x01, 0xEF, 0x01, 0xEF, 0x01, 0xEF, 0x01,
+    0xEF, 0x01, 0xEF, 0x01, 0xEF, 0x01, 0xE8, 0x18, 0xC8, 0x28, 0xC8, 0x29, 0xA9, 0x39, 0x89, 0x4A,
+    0x6A, 0x5F, 0x09, 0x7F, 0x07, 0x9F, 0x05, 0xBF, 0x03, 0xFC, 0xF0, 0x74, 0xD0, 0x0F, 0x0F, 0x0F,
+    0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x1F, 0x0B, 0xA8, 0xF0, 0x48, 0xF0, 0x48, 0xF0, 0x48, 0xF0,
+    0x48, 0xF0, 0x48, 0xF0, 0x48, 0xF0, 0x48, 0xF0, 0x48, 0xF0, 0x48, 0xF0, 0x48, 0xF0, 0x48, 0xF0,
+    0x48, 0xF0, 0x48, 0xF0, 0x48, 0xF0, 0x48, 0xF0, 0x48, 0xF0, 0x48, 0xF0, 0x48, 0xF0, 0x48, 0xF0,
+    0x48, 0xF0, 0x48, 0xF0, 0x48, 0x90, 0x08, 0xF8, 0x17, 0xF7, 0x28, 0xD8, 0x37, 0xD7, 0x47, 0xD7,
+    0x48, 0xB8, 0x57, 0xB7, 0x68, 0x98, 0x68, 0x98, 0x77, 0x97, 0x88, 0x78, 0x97, 0x77, 0xA7, 0x77,
+    0xA8, 0x58, 0xB7, 0x57, 0xC7, 0x57, 0xC8, 0x38, 0xD7, 0x37, 0xE7, 0x37, 0xE8, 0x17, 0xF0, 0x17,
+    0x17, 0xF0, 0x1F, 0xF0, 0x2D, 0xF0, 0x3D, 0xF0, 0x3D, 0xF0, 0x4B, 0xF0, 0x5B, 0xF0, 0x5B, 0xF0,
+    0x69, 0xB0,
+};
+static constexpr UiFont FONT_TITLE = { "LOTV", 4, 48, 38, FONT_TITLE_GLYPHS, FONT_TITLE_DATA, sizeof(FONT_TITLE_DATA) };
+
+// FONT_HEADING: 27 px, 30 glyphs, 824 bytes (1189 as 1-bit bitmaps)
+static constexpr UiGlyph FONT_HEADING_GLYPHS[] = {
+    { 0, 0, 0, 0, 0, 8 },    // ' '
+    { 1, 4, 16, 3, 5, 10 },    // '!'
+    { 7, 15, 16, 2, 5, 18 },    // 'D'
+    { 28, 11, 16, 2, 5, 15 },    // 'F'
+    { 43, 16, 16, 1, 5, 18 },    // 'G'
+    { 64, 15, 16, 2, 5, 18 },    // 'H'
+    { 81, 7, 21, -1, 5, 8 },    // 'J'
+    { 102, 12, 16, 2, 5, 14 },    // 'L'
+    { 118, 18, 16, 2, 5, 22 },    // 'M'
+    { 144, 15, 16, 2, 5, 18 },    // 'N'
+    { 164, 17, 16, 1, 5, 19 },    // 'O'
+    { 187, 13, 16, 1, 5, 16 },    // 'S'
+    { 206, 15, 16, 0, 5, 15 },    // 'T'
+    { 223, 17, 16, 0, 5, 17 },    // 'V'
+    { 251, 22, 16, 1, 5, 24 },    // 'W'
+    { 295, 12, 12, 1, 9, 15 },    // 'a'
+    { 309, 13, 17, 2, 4, 16 },    // 'b'
+    { 331, 13, 17, 1, 4, 16 },    // 'd'
+    { 351, 13, 12, 1, 9, 15 },    // 'e'
+    { 367, 10, 17, 0, 4, 10 },    // 'f'
+    { 385, 13, 17, 1, 9, 16 },    // 'g'
+    { 406, 4, 17, 2, 4, 8 },    // 'i'
+    { 411, 13, 17, 2, 4, 15 },    // 'k'
+    { 436, 19, 12, 2, 9, 23 },    // 'm'
+    { 460, 12, 12, 2, 9, 16 },    // 'n'
+    { 474, 13, 12, 1, 9, 15 },    // 'o'
+    { 488, 9, 12, 2, 9, 11 },    // 'r'
+    { 500, 11, 12, 1, 9, 13 },    // 's'
+    { 513, 10, 16, 0, 5, 11 },    // 't'
+    { 528, 14, 17, 0, 9, 14 },    // 'y'
+};
+static constexpr uint8_t FONT_HEADING_DATA[] = {
+    0x00, 0x0F, 0x0F, 0x0A, 0x12, 0x5F, 0x01, 0x0A, 0x5C, 0x3D, 0x24, 0x46, 0x14, 0x64, 0x14, 0x69,
+    0x78, 0x78, 0x78, 0x78, 0x69, 0x64, 0x14, 0x46, 0x1D, 0x2C, 0x3A, 0x50, 0x0F, 0x0F, 0x07, 0x74,
+    0x74, 0x7F, 0x0F, 0x07, 0x74, 0x74, 0x74, 0x74, 0x74, 0x74, 0x70, 0x59, 0x5C, 0x3D, 0x25, 0x72,
+    0x24, 0xB5, 0xB5, 0xB5, 0x4C, 0x4C, 0x4C, 0x65, 0x14, 0x65, 0x15, 0x55, 0x2E, 0x3C, 0x69, 0x20,
+    0x04, 0x69, 0x69, 0x69, 0x69, 0x69, 0x6F, 0x0F, 0x0F, 0x09, 0x69, 0x69, 0x69, 0x69, 0x69, 0x69,
+    0x65, 0x34, 0x34, 0x34, 0x34, 0x34, 0x34, 0x34, 0x34, 0x34, 0x34, 0x34, 0x34, 0x34, 0x34, 0x34,
+    0x34, 0x2F, 0x03, 0x15, 0x21, 0x60, 0x04, 0x84, 0x84, 0x84, 0x84, 0x84, 0x84, 0x84, 0x84, 0x84,
+    0x84, 0x84, 0x84, 0x8F, 0x0F, 0x06, 0x06, 0x6C, 0x6C, 0x5E, 0x4E, 0x4F, 0x23, 0x18, 0x13, 0x23,
+    0x18, 0x18, 0x18, 0x26, 0x28, 0x26, 0x28, 0x34, 0x38, 0x34, 0x38, 0x33, 0x48, 0xA8, 0xA8, 0xA4,
+    0x05, 0x5B, 0x4B, 0x4C, 0x3C, 0x3D, 0x29, 0x13, 0x29, 0x14, 0x19, 0x23, 0x19, 0x2D, 0x3C, 0x3C,
+    0x4B, 0x4B, 0x5A, 0x56, 0x49, 0x7B, 0x5D, 0x35, 0x55, 0x24, 0x74, 0x15, 0x74, 0x15, 0x79, 0x89,
+    0x8A, 0x7A, 0x74, 0x24, 0x74, 0x25, 0x55, 0x3D, 0x5B, 0x78, 0x50, 0x39, 0x3A, 0x2B, 0x24, 0x61,
+    0x14, 0xA4, 0x98, 0x6A, 0x4A, 0x67, 0x94, 0x94, 0x12, 0x64, 0x1C, 0x1B, 0x39, 0x20, 0x0F, 0x0F,
+    0x0F, 0x55, 0xA5, 0xA5, 0xA5, 0xA5, 0xA5, 0xA5, 0xA5, 0xA5, 0xA5, 0xA5, 0xA5, 0xA5, 0x50, 0x04,
+    0x94, 0x14, 0x74, 0x24, 0x74, 0x25, 0x55, 0x34, 0x54, 0x44, 0x54, 0x54, 0x35, 0x54, 0x34, 0x64,
+    0x34, 0x74, 0x14, 0x84, 0x14, 0x89, 0x97, 0xA7, 0xA7, 0xB5, 0x60, 0x04, 0x54, 0x58, 0x55, 0x48,
+    0x55, 0x48, 0x46, 0x44, 0x14, 0x36, 0x44, 0x14, 0x36, 0x34, 0x24, 0x33, 0x13, 0x24, 0x24, 0x23,
+    0x23, 0x24, 0x34, 0x13, 0x23, 0x24, 0x34, 0x13, 0x23, 0x14, 0x48, 0x37, 0x47, 0x47, 0x56, 0x47,
+    0x56, 0x46, 0x66, 0x55, 0x65, 0x65, 0x30, 0x19, 0x3A, 0x22, 0x45, 0x84, 0x39, 0x1F, 0x0C, 0x48,
+    0x49, 0x2F, 0x02, 0x16, 0x14, 0x04, 0x94, 0x94, 0x94, 0x94, 0x94, 0x15, 0x3B, 0x2C, 0x14, 0x44,
+    0x14, 0x58, 0x58, 0x58, 0x58, 0x44, 0x1C, 0x1B, 0x24, 0x15, 0x30, 0x94, 0x94, 0x94, 0x94, 0x94,
+    0x26, 0x14, 0x1C, 0x1F, 0x02, 0x39, 0x58, 0x58, 0x58, 0x59, 0x35, 0x1C, 0x1C, 0x26, 0x14, 0x37,
+    0x59, 0x34, 0x34, 0x14, 0x53, 0x14, 0x5F, 0x0F, 0x04, 0x94, 0xA5, 0x33, 0x3A, 0x49, 0x10, 0x55,
+    0x37, 0x37, 0x24, 0x64, 0x4F, 0x05, 0x18, 0x34, 0x64, 0x64, 0x64, 0x64, 0x64, 0x64, 0x64, 0x64,
+    0x40, 0x26, 0x14, 0x1C, 0x1F, 0x02, 0x39, 0x58, 0x58, 0x58, 0x59, 0x35, 0x1C, 0x2B, 0x34, 0x24,
+    0x94, 0x84, 0x2B, 0x2A, 0x55, 0x50, 0x0F, 0x5F, 0x0F, 0x0F, 0x03, 0x04, 0x94, 0x94, 0x94, 0x94,
+    0x94, 0x44, 0x14, 0x34, 0x24, 0x24, 0x34, 0x14, 0x48, 0x57, 0x68, 0x59, 0x44, 0x15, 0x34, 0x25,
+    0x24, 0x35, 0x14, 0x45, 0x04, 0x15, 0x26, 0x1F, 0x0F, 0x0C, 0x35, 0x38, 0x35, 0x38, 0x35, 0x38,
+    0x35, 0x38, 0x35, 0x38, 0x35, 0x38, 0x35, 0x38, 0x35, 0x38, 0x35, 0x34, 0x04, 0x15, 0x2B, 0x1F,
+    0x01, 0x48, 0x48, 0x48, 0x48, 0x48, 0x48, 0x48, 0x48, 0x44, 0x37, 0x5A, 0x2B, 0x15, 0x48, 0x58,
+    0x58, 0x58, 0x59, 0x44, 0x1B, 0x3A, 0x47, 0x30, 0x04, 0x1F, 0x0C, 0x44, 0x54, 0x54, 0x54, 0x54,
+    0x54, 0x54, 0x54, 0x50, 0x28, 0x29, 0x14, 0x42, 0x14, 0x76, 0x69, 0x39, 0x65, 0x77, 0x4F, 0x09,
+    0x20, 0x33, 0x64, 0x64, 0x64, 0x4F, 0x0F, 0x24, 0x64, 0x64, 0x64, 0x64, 0x64, 0x68, 0x37, 0x46,
+    0x04, 0x64, 0x14, 0x53, 0x24, 0x44, 0x34, 0x34, 0x34, 0x33, 0x53, 0x24, 0x54, 0x13, 0x68, 0x77,
+    0x76, 0x95, 0x95, 0x94, 0xA4, 0x76, 0x86, 0x84, 0x80,
+};
+static constexpr UiFont FONT_HEADING = { " !DFGHJLMNOSTVWabdefgikmnorsty", 30, 27, 21, FONT_HEADING_GLYPHS, FONT_HEADING_DATA, sizeof(FONT_HEADING_DATA) };
+
+#endif // UI_ASSETS_DATA_H
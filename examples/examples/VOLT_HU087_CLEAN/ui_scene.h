@@ -0,0 +1,556 @@
+/*
+ * ============================================
+ * UI Scene - Retained Widgets, Dirty Regions
+ * ============================================
+ *
+ * Handles:
+ * - A screen as a list of widgets (filled
+ *   rectangles and circles, text in the
+ *   built-in 6x8 font or a packed font, icons)
+ *   declared in the same order every time
+ * - Diffing each declaration against the last:
+ *   a widget that moved or changed marks its
+ *   old and new bounds dirty, one that is gone
+ *   marks its old bounds
+ * - A few dirty rectangles, merged when they
+ *   touch (or when there are too many), so each
+ *   pixel is sent once per flush
+ * - flush(): per dirty rectangle, the
+ *   background and every widget over it,
+ *   clipped to it. Nothing else is sent
+ * - Text wrapped at a width (by character, like
+ *   the TFT library's println); text in a
+ *   packed font (ui_assets.h) only breaks at
+ *   '\n'
+ * - paint(): one region drawn on any display,
+ *   for renderers that send regions their own
+ *   way (ui_sprites.h draws them off-screen)
+ *
+ * Replaces fillScreen() plus a full redraw for
+ * every status change: on the 172x320 ST7789
+ * that is 110 KB over SPI and a visible flash.
+ * Changing the battery line now sends a strip
+ * the size of the line.
+ *
+ * Keep a screen's slots stable: declare an
+ * empty text ("") rather than skipping one, or
+ * everything after it counts as moved.
+ *
+ * Drawing goes through UiDisplay: TFT_eSPI on
+ * the watch (TftUiDisplay, below), a counting
+ * framebuffer on the host (host/ui_framebuffer.h).
+ * Call from one task (ui).
+ *
+ * ============================================
+ */
+
+#ifndef UI_SCENE_H
+#define UI_SCENE_H
+
+#include <stdint.h>
+#include <string.h>
+#include "ui_assets.h"
+
+// RGB565, the same values as TFT_eSPI's TFT_* colors
+enum UiColor : uint16_t {
+    UI_BLACK = 0x0000,
+    UI_BLUE = 0x001F,
+    UI_RED = 0xF800,
+    UI_GREEN = 0x07E0,
+    UI_CYAN = 0x07FF,
+    UI_MAGENTA = 0xF81F,
+    UI_YELLOW = 0xFFE0,
+    UI_WHITE = 0xFFFF,
+    UI_PURPLE = 0x780F,
+    UI_GRAY = 0x8410
+};
+
+struct UiRect {
+    int16_t x, y, w, h;
+
+    bool empty() const { return w <= 0 || h <= 0; }
+    int32_t area() const { return empty() ? 0 : (int32_t)w * h; }
+
+    UiRect intersect(const UiRect& o) const {
+        int16_t x0 = x > o.x ? x : o.x;
+        int16_t y0 = y > o.y ? y : o.y;
+        int16_t x1 = x + w < o.x + o.w ? x + w : o.x + o.w;
+        int16_t y1 = y + h < o.y + o.h ? y + h : o.y + o.h;
+        return { x0, y0, (int16_t)(x1 - x0), (int16_t)(y1 - y0) };
+    }
+
+    // Smallest rectangle holding both
+    UiRect unite(const UiRect& o) const {
+        if (empty()) return o;
+        if (o.empty()) return *this;
+        int16_t x0 = x < o.x ? x : o.x;
+        int16_t y0 = y < o.y ? y : o.y;
+        int16_t x1 = x + w > o.x + o.w ? x + w : o.x + o.w;
+        int16_t y1 = y + h > o.y + o.h ? y + h : o.y + o.h;
+        return { x0, y0, (int16_t)(x1 - x0), (int16_t)(y1 - y0) };
+    }
+
+    // Overlapping or sharing an edge
+    bool touches(const UiRect& o) const {
+        return x <= o.x + o.w && o.x <= x + w && y <= o.y + o.h && o.y <= y + h;
+    }
+};
+
+// Half the width of a filled circle of radius r, dy rows from its
+// center (every display draws the same circle)
+inline int16_t uiCircleHalfWidth(int16_t r, int16_t dy) {
+    int32_t limit = (int32_t)r * r + r - (int32_t)dy * dy;
+    if (limit < 0) return -1;
+    int16_t dx = 0;
+    while ((int32_t)(dx + 1) * (dx + 1) <= limit) dx++;
+    return dx;
+}
+
+// Where a scene draws
+class UiDisplay {
+public:
+    virtual ~UiDisplay() {}
+
+    virtual void beginFrame() {}
+    virtual void endFrame() {}
+    virtual void fillRect(const UiRect& r, uint16_t color) = 0;
+    // len characters of s in the 6x8 font at size, top left at x, y;
+    // foreground pixels only, and only inside clip
+    virtual void drawText(int16_t x, int16_t y, uint8_t size, uint16_t color, const char* s, int len,
+                          const UiRect& clip) = 0;
+
+    // Hardware vertical scroll of rows [top, top + h): row top + i
+    // shows what was drawn at row top + (i + offset) % h, and drawing
+    // still goes to the rows as drawn. false if the display can't
+    // (nothing moves; text_scroller.h then redraws instead).
+    virtual bool scrollRows(int16_t top, int16_t h, int16_t offset) { return false; }
+
+    // Filled circle inside clip, one rectangle per row
+    virtual void fillCircle(int16_t cx, int16_t cy, int16_t r, uint16_t color, const UiRect& clip) {
+        for (int16_t dy = -r; dy <= r; dy++) {
+            int16_t dx = uiCircleHalfWidth(r, dy);
+            UiRect row = UiRect{ (int16_t)(cx - dx), (int16_t)(cy + dy), (int16_t)(2 * dx + 1), 1 }.intersect(clip);
+            if (!row.empty()) fillRect(row, color);
+        }
+    }
+
+    // An image with its top left at x, y, inside clip, one
+    // rectangle per run; transparent pixels are left alone
+    virtual void drawImage(int16_t x, int16_t y, const UiImage& img, const UiRect& clip) {
+        uiImageRuns(img, (int16_t)(clip.y - y), (int16_t)(clip.y + clip.h - y),
+                    [&](int16_t rx, int16_t ry, int16_t n, uint16_t color) {
+            UiRect run = UiRect{ (int16_t)(x + rx), (int16_t)(y + ry), n, 1 }.intersect(clip);
+            if (!run.empty()) fillRect(run, color);
+        });
+    }
+
+    // One glyph of a packed font, pen at x, line top at y
+    virtual void drawGlyph(int16_t x, int16_t y, const UiFont& font, const UiGlyph& g, uint16_t color,
+                           const UiRect& clip) {
+        int16_t gx = (int16_t)(x + g.x), gy = (int16_t)(y + g.y);
+        uiGlyphRuns(font, g, (int16_t)(clip.y - gy), (int16_t)(clip.y + clip.h - gy),
+                    [&](int16_t rx, int16_t ry, int16_t n) {
+            UiRect run = UiRect{ (int16_t)(gx + rx), (int16_t)(gy + ry), n, 1 }.intersect(clip);
+            if (!run.empty()) fillRect(run, color);
+        });
+    }
+};
+
+class UiScene {
+public:
+    static const int MAX_WIDGETS = 14;
+    static const int MAX_TEXT = 128;         // Longer text is cut
+    static const int MAX_DIRTY = 6;
+    static const int CHAR_W = 6;             // Built-in font cell, at size 1
+    static const int CHAR_H = 8;
+
+private:
+    enum Kind : uint8_t { W_NONE, W_RECT, W_TEXT, W_CIRCLE, W_IMAGE };
+
+    struct Widget {
+        uint8_t kind;
+        uint8_t size;
+        uint16_t color;
+        int16_t wrapW;
+        UiRect bounds;
+        const UiImage* image;
+        const UiFont* font;          // Text in a packed font, or nullptr
+        int16_t inkLeft;             // Font ink left of the pen (<= 0)
+        char text[MAX_TEXT];
+    };
+
+    Widget widgets[MAX_WIDGETS];
+    int count;                   // Slots in the current screen
+    int next;                    // Slot being declared
+    uint16_t background;
+    int16_t width, height;
+    bool all;                    // Everything is dirty
+    bool fullRedraw;
+    UiRect dirty[MAX_DIRTY];
+    int dirtyCount;
+
+    uint32_t frames;
+    uint32_t lastArea;
+    uint32_t totalArea;
+    uint32_t dropped;            // Widgets past MAX_WIDGETS
+
+    // One line of s from pos: its length, and where the next starts
+    static int nextLine(const char* s, int pos, int maxChars, int* len) {
+        int n = 0;
+        while (s[pos + n] && s[pos + n] != '\n' && n < maxChars) n++;
+        *len = n;
+        pos += n;
+        if (s[pos] == '\n') pos++;
+        return pos;
+    }
+
+    int maxChars(const Widget& w) const {
+        int chars = w.wrapW / (CHAR_W * w.size);
+        return chars < 1 ? 1 : chars;
+    }
+
+    UiRect textBounds(const Widget& w) const {
+        if (w.font) return fontTextBounds(w);
+        int lines = 0, widest = 0, len;
+        int limit = maxChars(w);
+        for (int pos = 0; w.text[pos];) {
+            pos = nextLine(w.text, pos, limit, &len);
+            if (len > widest) widest = len;
+            lines++;
+        }
+        return { w.bounds.x, w.bounds.y, (int16_t)(widest * CHAR_W * w.size),
+                 (int16_t)(lines * CHAR_H * w.size) };
+    }
+
+    // Lines end only at '\n'; bounds cover advances and ink
+    UiRect fontTextBounds(const Widget& w) const {
+        int lines = 0, len;
+        int16_t lo = 0, hi = 0, left, right;
+        for (int pos = 0; w.text[pos];) {
+            int start = pos;
+            pos = nextLine(w.text, pos, MAX_TEXT, &len);
+            uiTextExtent(*w.font, w.text + start, len, &left, &right);
+            if (left < lo) lo = left;
+            if (right > hi) hi = right;
+            lines++;
+        }
+        return { (int16_t)(w.bounds.x + lo), w.bounds.y, (int16_t)(hi - lo), (int16_t)(lines * w.font->height) };
+    }
+
+    void drawFontText(UiDisplay& d, const Widget& w, const UiRect& clip) {
+        const UiFont& font = *w.font;
+        int16_t y = w.bounds.y;
+        int len;
+        for (int pos = 0; w.text[pos]; y = (int16_t)(y + font.height)) {
+            int start = pos;
+            pos = nextLine(w.text, pos, MAX_TEXT, &len);
+            int16_t pen = (int16_t)(w.bounds.x - w.inkLeft);
+            for (int i = 0; i < len; i++) {
+                const UiGlyph* g = uiFindGlyph(font, w.text[start + i]);
+                if (!g) continue;
+                UiRect ink = { (int16_t)(pen + g->x), (int16_t)(y + g->y), g->w, g->h };
+                if (!ink.intersect(clip).empty()) d.drawGlyph(pen, y, font, *g, w.color, clip);
+                pen = (int16_t)(pen + g->advance);
+            }
+        }
+    }
+
+    void drawWidget(UiDisplay& d, const Widget& w, const UiRect& clip) {
+        UiRect part = w.bounds.intersect(clip);
+        if (part.empty()) return;
+        if (w.kind == W_RECT) {
+            d.fillRect(part, w.color);
+            return;
+        }
+        if (w.kind == W_CIRCLE) {
+            int16_t r = (int16_t)(w.bounds.w / 2);
+            d.fillCircle((int16_t)(w.bounds.x + r), (int16_t)(w.bounds.y + r), r, w.color, part);
+            return;
+        }
+        if (w.kind == W_IMAGE) {
+            d.drawImage(w.bounds.x, w.bounds.y, *w.image, part);
+            return;
+        }
+        if (w.font) {
+            drawFontText(d, w, part);
+            return;
+        }
+        int limit = maxChars(w), len;
+        int16_t y = w.bounds.y;
+        for (int pos = 0; w.text[pos]; y += CHAR_H * w.size) {
+            int start = pos;
+            pos = nextLine(w.text, pos, limit, &len);
+            UiRect line = { w.bounds.x, y, (int16_t)(len * CHAR_W * w.size), (int16_t)(CHAR_H * w.size) };
+            if (!line.intersect(clip).empty()) {
+                d.drawText(w.bounds.x, y, w.size, w.color, w.text + start, len, clip);
+            }
+        }
+    }
+
+    static Widget blank(uint8_t kind, uint16_t color) {
+        Widget nw;
+        nw.kind = kind;
+        nw.size = 0;
+        nw.color = color;
+        nw.wrapW = 0;
+        nw.bounds = { 0, 0, 0, 0 };
+        nw.image = nullptr;
+        nw.font = nullptr;
+        nw.inkLeft = 0;
+        nw.text[0] = '\0';
+        return nw;
+    }
+
+    void declare(const Widget& nw) {
+        if (next >= MAX_WIDGETS) {
+            dropped++;
+            return;
+        }
+        Widget& w = widgets[next++];
+        bool same = w.kind == nw.kind && w.size == nw.size && w.color == nw.color &&
+                    w.wrapW == nw.wrapW && w.bounds.x == nw.bounds.x && w.bounds.y == nw.bounds.y &&
+                    w.bounds.w == nw.bounds.w && w.bounds.h == nw.bounds.h && w.image == nw.image &&
+                    w.font == nw.font && strcmp(w.text, nw.text) == 0;
+        if (same) return;
+        if (w.kind != W_NONE) markDirty(w.bounds);
+        w = nw;
+        markDirty(w.bounds);
+    }
+
+public:
+    UiScene() { begin(0, 0); }
+
+    // Screen size; the first flush sends everything
+    void begin(int16_t w, int16_t h) {
+        width = w;
+        height = h;
+        count = next = 0;
+        background = UI_BLACK;
+        for (int i = 0; i < MAX_WIDGETS; i++) {
+            widgets[i].kind = W_NONE;
+            widgets[i].text[0] = '\0';
+        }
+        fullRedraw = false;
+        dirtyCount = 0;
+        all = true;
+        frames = lastArea = totalArea = dropped = 0;
+    }
+
+    // Starts declaring a screen. A new background repaints it all.
+    void compose(uint16_t bg) {
+        if (bg != background) {
+            background = bg;
+            all = true;
+        }
+        next = 0;
+    }
+
+    void rect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+        Widget nw = blank(W_RECT, color);
+        nw.bounds = { x, y, w, h };
+        declare(nw);
+    }
+
+    // Filled, centered on cx, cy; bounds are 2r + 1 square
+    void circle(int16_t cx, int16_t cy, int16_t r, uint16_t color) {
+        Widget nw = blank(W_CIRCLE, color);
+        if (r < 0) r = 0;
+        nw.bounds = { (int16_t)(cx - r), (int16_t)(cy - r), (int16_t)(2 * r + 1), (int16_t)(2 * r + 1) };
+        declare(nw);
+    }
+
+    // Wraps at wrapW pixels (0: the right edge of the screen)
+    void text(int16_t x, int16_t y, uint8_t size, uint16_t color, const char* s, int16_t wrapW = 0) {
+        Widget nw = blank(W_TEXT, color);
+        nw.size = size < 1 ? 1 : size;
+        nw.wrapW = wrapW > 0 ? wrapW : (int16_t)(width - x);
+        strncpy(nw.text, s ? s : "", MAX_TEXT - 1);
+        nw.text[MAX_TEXT - 1] = '\0';
+        nw.bounds = { x, y, 0, 0 };
+        nw.bounds = textBounds(nw);
+        declare(nw);
+    }
+
+    // In a packed font, pen at x, line top at y
+    void text(int16_t x, int16_t y, const UiFont& font, uint16_t color, const char* s) {
+        Widget nw = blank(W_TEXT, color);
+        nw.font = &font;
+        strncpy(nw.text, s ? s : "", MAX_TEXT - 1);
+        nw.text[MAX_TEXT - 1] = '\0';
+        nw.bounds = { x, y, 0, 0 };
+        nw.bounds = textBounds(nw);
+        nw.inkLeft = (int16_t)(nw.bounds.x - x);
+        declare(nw);
+    }
+
+    // A packed image, top left at x, y (a different image in the
+    // same slot repaints it)
+    void image(int16_t x, int16_t y, const UiImage& img) {
+        Widget nw = blank(W_IMAGE, 0);
+        nw.image = &img;
+        nw.bounds = { x, y, (int16_t)img.w, (int16_t)img.h };
+        declare(nw);
+    }
+
+    void markDirty(UiRect r) {
+        r = r.intersect({ 0, 0, width, height });
+        if (r.empty() || all) return;
+        for (int i = 0; i < dirtyCount;) {
+            if (dirty[i].touches(r)) {
+                r = r.unite(dirty[i]);
+                dirty[i] = dirty[--dirtyCount];
+                i = 0;                       // The bigger one may touch others
+            } else {
+                i++;
+            }
+        }
+        if (dirtyCount == MAX_DIRTY) {
+            // Into the one it grows least
+            int best = 0;
+            int32_t bestGrowth = 0;
+            for (int i = 0; i < dirtyCount; i++) {
+                int32_t growth = dirty[i].unite(r).area() - dirty[i].area();
+                if (i == 0 || growth < bestGrowth) {
+                    best = i;
+                    bestGrowth = growth;
+                }
+            }
+            UiRect merged = dirty[best].unite(r);
+            dirty[best] = dirty[--dirtyCount];
+            markDirty(merged);
+            return;
+        }
+        dirty[dirtyCount++] = r;
+    }
+
+    // Repaint everything at the next flush (something else drew)
+    void invalidate() { all = true; }
+
+    // Every flush repaints the whole screen: the old way, to compare
+    void setFullRedraw(bool on) { fullRedraw = on; }
+
+    // Ends the screen and sends what changed. Returns the pixels
+    // repainted (backgrounds and shapes; text is drawn over them).
+    uint32_t flush(UiDisplay& d) {
+        int regions = beginFlush();
+        uint32_t area = 0;
+        d.beginFrame();
+        for (int r = 0; r < regions; r++) {
+            area += paint(d, dirty[r]);
+        }
+        d.endFrame();
+        endFlush(area);
+        return area;
+    }
+
+    // flush() in three parts, for a renderer that sends regions its
+    // own way: the screen ends and its dirty regions are final
+    // (getDirty()); each is painted, in any pieces; then the regions
+    // are cleared and area is counted.
+    int beginFlush() {
+        for (int i = next; i < count; i++) {
+            if (widgets[i].kind != W_NONE) markDirty(widgets[i].bounds);
+            widgets[i].kind = W_NONE;
+            widgets[i].text[0] = '\0';
+        }
+        count = next;
+        frames++;
+        if (all || fullRedraw) {
+            dirty[0] = { 0, 0, width, height };
+            dirtyCount = 1;
+            all = false;
+        }
+        return dirtyCount;
+    }
+
+    // The background and every widget, clipped to clip
+    uint32_t paint(UiDisplay& d, const UiRect& clip) {
+        d.fillRect(clip, background);
+        uint32_t area = (uint32_t)clip.area();
+        for (int i = 0; i < count; i++) {
+            if (widgets[i].kind == W_RECT || widgets[i].kind == W_CIRCLE) {
+                area += (uint32_t)widgets[i].bounds.intersect(clip).area();
+            }
+            drawWidget(d, widgets[i], clip);
+        }
+        return area;
+    }
+
+    void endFlush(uint32_t area) {
+        dirtyCount = 0;
+        lastArea = area;
+        totalArea += area;
+    }
+
+    int16_t getWidth() const { return width; }
+    int16_t getHeight() const { return height; }
+    int getDirtyCount() const { return all ? 1 : dirtyCount; }
+    const UiRect& getDirty(int i) const { return dirty[i]; }
+    int getWidgetCount() const { return count; }
+    uint16_t getBackground() const { return background; }
+    uint32_t getFrames() const { return frames; }
+    uint32_t getLastArea() const { return lastArea; }
+    uint32_t getTotalArea() const { return totalArea; }
+    uint32_t getDropped() const { return dropped; }
+};
+
+// ============================================
+// TFT_eSPI
+// ============================================
+
+#ifdef ARDUINO
+#include <TFT_eSPI.h>
+
+// Text is clipped with a viewport in screen coordinates; one SPI
+// transaction per flush. Packed icons and fonts go out a run at a
+// time (UiDisplay's drawImage() and drawGlyph()). Scrolling is the
+// ST7789's own, along the panel's 320 rows: the screen must be
+// upright (rotation 0) for those to be screen rows.
+class TftUiDisplay : public UiDisplay {
+private:
+    TFT_eSPI& tft;
+
+public:
+    explicit TftUiDisplay(TFT_eSPI& t) : tft(t) {}
+
+    void beginFrame() override { tft.startWrite(); }
+    void endFrame() override { tft.endWrite(); }
+
+    void fillRect(const UiRect& r, uint16_t color) override {
+        tft.fillRect(r.x, r.y, r.w, r.h, color);
+    }
+
+    void drawText(int16_t x, int16_t y, uint8_t size, uint16_t color, const char* s, int len,
+                  const UiRect& clip) override {
+        tft.setViewport(clip.x, clip.y, clip.w, clip.h, false);
+        tft.setTextFont(1);
+        tft.setTextSize(size);
+        tft.setTextColor(color);             // Transparent: the fill is done
+        tft.setTextWrap(false);
+        tft.setCursor(x, y);
+        tft.write((const uint8_t*)s, len);
+        tft.resetViewport();
+    }
+
+    // VSCRDEF (0x33): fixed rows above, the scrolling rows, fixed
+    // rows below; then VSCRSADD (0x37): the row shown first
+    bool scrollRows(int16_t top, int16_t h, int16_t offset) override {
+        int16_t bottom = (int16_t)(tft.height() - top - h);
+        if (top < 0 || h <= 0 || bottom < 0) return false;
+        uint16_t first = (uint16_t)(top + offset % h);
+        tft.writecommand(0x33);
+        tft.writedata((uint8_t)(top >> 8));
+        tft.writedata((uint8_t)top);
+        tft.writedata((uint8_t)(h >> 8));
+        tft.writedata((uint8_t)h);
+        tft.writedata((uint8_t)(bottom >> 8));
+        tft.writedata((uint8_t)bottom);
+        tft.writecommand(0x37);
+        tft.writedata((uint8_t)(first >> 8));
+        tft.writedata((uint8_t)first);
+        return true;
+    }
+};
+#endif
+
+#endif // UI_SCENE_H
@@ -0,0 +1,329 @@
+/*
+ * ============================================
+ * UI Sprites - Off-Screen, Double-Buffered
+ * ============================================
+ *
+ * Handles:
+ * - UiCanvas: a scene region drawn into an
+ *   RGB565 buffer instead of onto the panel
+ *   (rectangles, circles, text from a glyph
+ *   table, packed icons and fonts decoded run
+ *   by run straight into the buffer),
+ *   optionally byte-swapped for SPI
+ * - Two sprite buffers from the memory pools
+ *   (mem_pools.h): DMA-capable internal RAM,
+ *   PSRAM if that is short
+ * - UiSpriteRenderer::flush(): each dirty region
+ *   of a UiScene in tiles that fit a buffer.
+ *   While one tile is on its way to the panel
+ *   (DMA), the next is drawn into the other
+ *   buffer; a buffer is reused only after its
+ *   push is done
+ * - Time spent waiting on the panel, tiles and
+ *   pixels pushed
+ *
+ * The panel sees each pixel once, finished: no
+ * background flash under text, and a growing
+ * circle never shows half drawn.
+ *
+ * Pushing goes through UiPanel: TFT_eSPI's DMA
+ * on the watch (TftUiPanel, below), a modeled
+ * SPI bus on the host (host/ui_framebuffer.h).
+ * Call from one task (ui).
+ *
+ * ============================================
+ */
+
+#ifndef UI_SPRITES_H
+#define UI_SPRITES_H
+
+#include <stdint.h>
+#include "volt_hal.h"
+#include "mem_pools.h"
+#include "ui_scene.h"
+
+// 5x8 glyph of a character: bit row * 5 + col, top left first
+typedef uint64_t (*UiGlyphFn)(char c);
+
+// ============================================
+// CANVAS
+// ============================================
+
+// Draws in screen coordinates into a buffer placed over part of
+// the screen; anything outside it is dropped
+class UiCanvas : public UiDisplay {
+private:
+    uint16_t* px;
+    uint32_t capacity;           // Pixels
+    UiRect area;
+    UiGlyphFn glyph;
+    bool swap;
+    uint32_t written;
+
+    uint16_t encode(uint16_t color) const {
+        return swap ? (uint16_t)((color >> 8) | (color << 8)) : color;
+    }
+
+    void span(int16_t x, int16_t y, int16_t w, uint16_t c) {
+        uint16_t* row = px + (size_t)(y - area.y) * area.w + (x - area.x);
+        for (int16_t i = 0; i < w; i++) row[i] = c;
+        written += (uint32_t)w;
+    }
+
+public:
+    UiCanvas() : px(nullptr), capacity(0), area{ 0, 0, 0, 0 }, glyph(nullptr), swap(false), written(0) {}
+
+    // Swapped bytes are what the panel expects over SPI
+    void attach(uint16_t* buffer, uint32_t capacityPx, UiGlyphFn glyphs, bool swapBytes) {
+        px = buffer;
+        capacity = capacityPx;
+        glyph = glyphs;
+        swap = swapBytes;
+        area = { 0, 0, 0, 0 };
+    }
+
+    // Moves the buffer over r (r.w * r.h pixels, packed); false if
+    // it does not fit
+    bool place(const UiRect& r) {
+        if (!px || r.empty() || (uint32_t)r.area() > capacity) return false;
+        area = r;
+        return true;
+    }
+
+    void fillRect(const UiRect& r, uint16_t color) override {
+        UiRect c = r.intersect(area);
+        if (c.empty()) return;
+        uint16_t v = encode(color);
+        for (int16_t y = c.y; y < c.y + c.h; y++) span(c.x, y, c.w, v);
+    }
+
+    void drawText(int16_t x, int16_t y, uint8_t size, uint16_t color, const char* s, int len,
+                  const UiRect& clip) override {
+        UiRect c = clip.intersect(area);
+        if (c.empty() || !glyph) return;
+        uint16_t v = encode(color);
+        for (int i = 0; i < len; i++) {
+            uint64_t g = glyph(s[i]);
+            int16_t gx = (int16_t)(x + i * UiScene::CHAR_W * size);
+            for (int row = 0; row < 8; row++) {
+                for (int col = 0; col < 5; col++) {
+                    if (!((g >> (row * 5 + col)) & 1)) continue;
+                    UiRect dot = UiRect{ (int16_t)(gx + col * size), (int16_t)(y + row * size),
+                                         size, size }.intersect(c);
+                    for (int16_t py = dot.y; py < dot.y + dot.h; py++) span(dot.x, py, dot.w, v);
+                }
+            }
+        }
+    }
+
+    void fillCircle(int16_t cx, int16_t cy, int16_t r, uint16_t color, const UiRect& clip) override {
+        UiRect c = clip.intersect(area);
+        if (c.empty()) return;
+        uint16_t v = encode(color);
+        for (int16_t y = c.y; y < c.y + c.h; y++) {
+            int16_t dx = uiCircleHalfWidth(r, (int16_t)(y - cy));
+            if (dx < 0) continue;
+            UiRect row = UiRect{ (int16_t)(cx - dx), y, (int16_t)(2 * dx + 1), 1 }.intersect(c);
+            if (!row.empty()) span(row.x, y, row.w, v);
+        }
+    }
+
+    void drawImage(int16_t x, int16_t y, const UiImage& img, const UiRect& clip) override {
+        UiRect c = clip.intersect(area);
+        if (c.empty()) return;
+        uiImageRuns(img, (int16_t)(c.y - y), (int16_t)(c.y + c.h - y),
+                    [&](int16_t rx, int16_t ry, int16_t n, uint16_t color) {
+            UiRect run = UiRect{ (int16_t)(x + rx), (int16_t)(y + ry), n, 1 }.intersect(c);
+            if (!run.empty()) span(run.x, run.y, run.w, encode(color));
+        });
+    }
+
+    void drawGlyph(int16_t x, int16_t y, const UiFont& font, const UiGlyph& g, uint16_t color,
+                   const UiRect& clip) override {
+        UiRect c = clip.intersect(area);
+        if (c.empty()) return;
+        uint16_t v = encode(color);
+        int16_t gx = (int16_t)(x + g.x), gy = (int16_t)(y + g.y);
+        uiGlyphRuns(font, g, (int16_t)(c.y - gy), (int16_t)(c.y + c.h - gy), [&](int16_t rx, int16_t ry, int16_t n) {
+            UiRect run = UiRect{ (int16_t)(gx + rx), (int16_t)(gy + ry), n, 1 }.intersect(c);
+            if (!run.empty()) span(run.x, run.y, run.w, v);
+        });
+    }
+
+    const uint16_t* getPixels() const { return px; }
+    const UiRect& getArea() const { return area; }
+    uint32_t getCapacity() const { return capacity; }
+    // Pixels stored since attach(), overdraw included
+    uint32_t getWritten() const { return written; }
+};
+
+// ============================================
+// PANEL
+// ============================================
+
+// Where finished tiles go
+class UiPanel {
+public:
+    virtual ~UiPanel() {}
+
+    virtual void beginFrame() {}
+    virtual void endFrame() {}
+    // Starts sending r.w * r.h pixels to r and may return before
+    // they are sent; px stays untouched until wait()
+    virtual void push(const UiRect& r, const uint16_t* px) = 0;
+    // Until the last push is sent
+    virtual void wait() {}
+};
+
+// ============================================
+// RENDERER
+// ============================================
+
+class UiSpriteRenderer {
+public:
+    static const int BUFFERS = 2;
+
+private:
+    UiCanvas canvas[BUFFERS];
+    int current;
+    bool ready;
+    uint8_t placedCaps;
+
+    uint32_t frames;
+    uint32_t tiles;
+    uint32_t pixels;
+    uint32_t waitUs;             // Blocked on the panel, all frames
+    uint32_t lastWaitUs;
+
+    void waitPanel(UiPanel& panel) {
+        uint32_t start = (uint32_t)halMicros();
+        panel.wait();
+        lastWaitUs += (uint32_t)halMicros() - start;
+    }
+
+public:
+    UiSpriteRenderer()
+        : current(0), ready(false), placedCaps(MEM_CAP_NONE), frames(0), tiles(0), pixels(0), waitUs(0),
+          lastWaitUs(0) {}
+
+    // Reserves the two buffers, capacityPx pixels each, as the
+    // pools' "sprite" bucket. glyphs draw text; swapBytes for a
+    // panel that takes RGB565 high byte first.
+    bool begin(MemPools& pools, uint32_t capacityPx, UiGlyphFn glyphs, bool swapBytes) {
+        PoolBucketConfig cfg = { "sprite", capacityPx * sizeof(uint16_t), BUFFERS, MEM_CAP_DMA, MEM_CAP_SPIRAM };
+        if (!pools.addBucket(cfg)) return false;
+        for (int i = 0; i < BUFFERS; i++) {
+            uint16_t* buffer = (uint16_t*)pools.allocFrom("sprite");
+            if (!buffer) return false;
+            canvas[i].attach(buffer, capacityPx, glyphs, swapBytes);
+        }
+        for (int i = 0; i < pools.getBucketCount(); i++) {
+            PoolBucketStats s = pools.getBucketStats(i);
+            if (strcmp(s.name, "sprite") == 0) placedCaps = s.placedCaps;
+        }
+        current = 0;
+        ready = true;
+        return true;
+    }
+
+    // Ends the scene's screen and sends what changed, tile by tile.
+    // Returns the pixels repainted, as UiScene::flush().
+    uint32_t flush(UiScene& scene, UiPanel& panel) {
+        int regions = scene.beginFlush();
+        uint32_t area = 0;
+        uint32_t cap = canvas[0].getCapacity();
+        lastWaitUs = 0;
+        panel.beginFrame();
+        for (int r = 0; r < regions; r++) {
+            const UiRect d = scene.getDirty(r);
+            int16_t tw = (uint32_t)d.w < cap ? d.w : (int16_t)cap;
+            int16_t th = (int16_t)(cap / (uint32_t)tw);
+            for (int16_t y = d.y; y < d.y + d.h; y += th) {
+                for (int16_t x = d.x; x < d.x + d.w; x += tw) {
+                    UiRect tile = UiRect{ x, y, tw, th }.intersect(d);
+                    UiCanvas& c = canvas[current];
+                    c.place(tile);
+                    area += scene.paint(c, tile);
+                    waitPanel(panel);            // The other buffer's push
+                    panel.push(tile, c.getPixels());
+                    current = (current + 1) % BUFFERS;
+                    tiles++;
+                    pixels += (uint32_t)tile.area();
+                }
+            }
+        }
+        waitPanel(panel);
+        panel.endFrame();
+        scene.endFlush(area);
+        frames++;
+        waitUs += lastWaitUs;
+        return area;
+    }
+
+    bool isReady() const { return ready; }
+    // Where the pools put the buffers (DMA needs internal RAM)
+    uint8_t getPlacedCaps() const { return placedCaps; }
+    bool isDmaCapable() const { return (placedCaps & MEM_CAP_DMA) != 0; }
+    uint32_t getCapacity() const { return canvas[0].getCapacity(); }
+    uint32_t getFrames() const { return frames; }
+    uint32_t getTiles() const { return tiles; }
+    uint32_t getPixels() const { return pixels; }
+    uint32_t getWaitUs() const { return waitUs; }
+    uint32_t getLastWaitUs() const { return lastWaitUs; }
+};
+
+// ============================================
+// TFT_eSPI
+// ============================================
+
+#ifdef ARDUINO
+#include <TFT_eSPI.h>
+
+// The TFT library's built-in font (font 1): 5 column bytes a
+// character, bit 0 at the top
+inline uint64_t tftGlyph(char c) {
+    uint64_t g = 0;
+    for (int col = 0; col < 5; col++) {
+        uint8_t bits = pgm_read_byte(&font[(uint8_t)c * 5 + col]);
+        for (int row = 0; row < 8; row++) {
+            if ((bits >> row) & 1) g |= 1ULL << (row * 5 + col);
+        }
+    }
+    return g;
+}
+
+// Tiles over DMA while the next one is drawn; the buffers are
+// already byte-swapped (UiCanvas), so the library's swap stays off
+class TftUiPanel : public UiPanel {
+private:
+    TFT_eSPI& tft;
+    bool dma;
+
+public:
+    explicit TftUiPanel(TFT_eSPI& t) : tft(t), dma(false) {}
+
+    // Only for buffers in internal RAM; otherwise pushes block
+    bool useDma(bool on) {
+        dma = on && tft.initDMA();
+        return dma;
+    }
+
+    void beginFrame() override { tft.startWrite(); }
+
+    void push(const UiRect& r, const uint16_t* px) override {
+        if (dma) tft.pushImageDMA(r.x, r.y, r.w, r.h, (uint16_t*)px);
+        else tft.pushImage(r.x, r.y, r.w, r.h, px);
+    }
+
+    void wait() override {
+        if (dma) tft.dmaWait();
+    }
+
+    void endFrame() override {
+        wait();
+        tft.endWrite();
+    }
+};
+#endif
+
+#endif // UI_SPRITES_H
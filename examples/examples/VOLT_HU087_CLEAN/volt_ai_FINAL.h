@@ -9,6 +9,11 @@
  * ✅ I2S buffer management - FIXED
  * ✅ Error handling - COMPREHENSIVE
  * ✅ Memory management - SAFE
+ * ✅ Per-turn arena - no String churn between turns
+ * ✅ Optional HTTP/2 - one connection, TTS prefetch
+ * ✅ Hardware through volt_hal.h - builds on Linux
+ * ✅ Turn spans for volt_trace.h
+ * ✅ Request, HTTP code and underrun metrics
  * 
  * This version is production-ready and tested.
  * 
@@ -19,21 +24,459 @@
 #define VOLT_AI_H
 
 #include <Arduino.h>
-#include <WiFi.h>
-#include <WiFiClientSecure.h>
-#include <HTTPClient.h>
 #include <ArduinoJson.h>
-#include <driver/i2s.h>
+#include "volt_hal.h"
 #include "config_stone.h"
 #include "pins_hu087.h"
+#include "turn_arena.h"
+#include "mem_pools.h"
+#include "h2_client.h"
+#include "dns_cache.h"
+#include "volt_trace.h"
+#include "metrics.h"
+#include "speech_text.h"
+
+// Buffer classes reserved once by begin() (n = 0: feature off)
+static const PoolBucketConfig VOLT_POOL_LAYOUT[] = {
+    // name       block size                     n  placement         fallback
+    { "capture", BUFFER_SIZE * sizeof(int16_t), 1, MEM_CAP_SPIRAM,   MEM_CAP_INTERNAL },
+    { "arena",   TURN_ARENA_SIZE,               1, MEM_CAP_SPIRAM,   MEM_CAP_INTERNAL },
+    { "tts",     TTS_JITTER_BUFFER,             2, MEM_CAP_DMA,      MEM_CAP_INTERNAL },
+    { "http",    HTTP_BUFFER_SIZE,              2, MEM_CAP_INTERNAL, MEM_CAP_NONE },
+    { "event",   REALTIME_EVENT_BUFFER,         USE_REALTIME_MODE ? 1 : 0,
+                                                   MEM_CAP_SPIRAM,   MEM_CAP_INTERNAL },
+    { "h2",      H2_STREAM_WINDOW,              USE_HTTP2 ? H2_MAX_STREAMS + 1 : 0,
+                                                   MEM_CAP_SPIRAM,   MEM_CAP_INTERNAL }
+};
+
+// Counters for GET /api/metrics, registered by VoltAI::begin().
+// Requests count attempts; responses count the status each one got
+// ("none": no connection or no status line).
+struct AiMetrics {
+    MetricCounter transcribeRequests;
+    MetricCounter chatRequests;
+    MetricCounter speechRequests;
+    MetricHttpCodes transcribeCodes;
+    MetricHttpCodes chatCodes;
+    MetricHttpCodes speechCodes;
+    MetricCounter ttsUnderruns;
+
+    AiMetrics()
+        : transcribeRequests("volt_ai_requests_total", "API requests started", "endpoint=\"transcribe\""),
+          chatRequests("volt_ai_requests_total", "API requests started", "endpoint=\"chat\""),
+          speechRequests("volt_ai_requests_total", "API requests started", "endpoint=\"speech\""),
+          transcribeCodes("volt_ai_responses_total", "API responses by HTTP status", "transcribe"),
+          chatCodes("volt_ai_responses_total", "API responses by HTTP status", "chat"),
+          speechCodes("volt_ai_responses_total", "API responses by HTTP status", "speech"),
+          ttsUnderruns("volt_tts_underruns_total",
+                       "Times the speaker ran out of audio in the middle of a reply") {}
+
+    void registerAll(MetricsRegistry& registry) {
+        registry.add(&transcribeRequests);
+        registry.add(&chatRequests);
+        registry.add(&speechRequests);
+        registry.add(transcribeCodes);
+        registry.add(chatCodes);
+        registry.add(speechCodes);
+        registry.add(&ttsUnderruns);
+    }
+};
+
+inline AiMetrics& aiMetrics() {
+    static AiMetrics metrics;
+    return metrics;
+}
+
+// Where playback of the PCM written so far ends. A write that comes
+// after that point found the I2S queue empty: the speaker went quiet
+// in the middle of the reply (an underrun).
+class PlaybackClock {
+private:
+    unsigned long endMs;
+    bool started;
+    int bytesPerSecond;
+
+public:
+    explicit PlaybackClock(int sampleRate = SAMPLE_RATE)
+        : endMs(0), started(false), bytesPerSecond(sampleRate * (int)sizeof(int16_t)) {}
+
+    // Call before each write of bytes; true if it is an underrun
+    bool write(size_t bytes, unsigned long now) {
+        bool dry = started && (long)(now - endMs) > 0;
+        if (!started || dry) endMs = now;
+        endMs += (unsigned long)((uint64_t)bytes * 1000 / bytesPerSecond);
+        started = true;
+        return dry;
+    }
+};
+
+// JSON documents that live in the current turn's arena
+typedef BasicJsonDocument<ArenaJsonAllocator> ArenaJsonDocument;
+
+// Response head fields the engine acts on
+struct HttpHead {
+    int status;           // -1 if no status line arrived
+    long contentLength;   // -1 if not sent
+    bool chunked;         // Transfer-Encoding: chunked
+};
+
+// Reads an HTTP/1.1 body, removing chunked framing when the head
+// says so. Never blocks: read() returns -1 while nothing has
+// arrived yet and 0 once the body is complete.
+// Without a head (HTTP/2 streams) the body ends when the stream does.
+class HttpBodyReader {
+private:
+    enum ChunkState { CHUNK_SIZE, CHUNK_DATA, CHUNK_CRLF, CHUNK_TRAILER };
+
+    Client& client;
+    bool chunked;
+    long remaining;       // Bytes left in the body or chunk, -1 unknown
+    bool done;
+    ChunkState state;
+    FixedString<32> line; // Chunk size or trailer line
+
+    int endOrWait() {
+        if (!client.connected()) {
+            done = true;
+            return 0;
+        }
+        return -1;
+    }
+
+public:
+    HttpBodyReader(Client& source, const HttpHead* head = nullptr)
+        : client(source),
+          chunked(head && head->chunked),
+          remaining(head && !head->chunked ? head->contentLength : -1),
+          done(false),
+          state(CHUNK_SIZE) {}
+
+    int read(uint8_t* buf, size_t len) {
+        if (done) return 0;
+
+        if (!chunked) {
+            if (remaining == 0) {
+                done = true;
+                return 0;
+            }
+            if (remaining > 0 && (long)len > remaining) {
+                len = (size_t)remaining;
+            }
+            int n = client.available() > 0 ? client.read(buf, len) : -1;
+            if (n > 0) {
+                if (remaining > 0) remaining -= n;
+                return n;
+            }
+            return endOrWait();
+        }
+
+        while (client.available() > 0) {
+            if (state == CHUNK_DATA) {
+                size_t want = (long)len < remaining ? len : (size_t)remaining;
+                int n = client.read(buf, want);
+                if (n <= 0) break;
+                remaining -= n;
+                if (remaining == 0) {
+                    state = CHUNK_CRLF;
+                }
+                return n;
+            }
+
+            int c = client.read();
+            if (c < 0) break;
+            if (c == '\r') continue;
+
+            if (state == CHUNK_CRLF) {
+                // CRLF after the chunk data
+                if (c == '\n') state = CHUNK_SIZE;
+            } else if (c != '\n') {
+                line.append((char)c);
+            } else if (state == CHUNK_SIZE) {
+                // "1a2b" or "1a2b;ext"; size 0 ends the body
+                remaining = strtol(line.c_str(), nullptr, 16);
+                line.clear();
+                state = remaining > 0 ? CHUNK_DATA : CHUNK_TRAILER;
+            } else {
+                // Trailer headers end with an empty line
+                bool last = line.isEmpty();
+                line.clear();
+                if (last) {
+                    done = true;
+                    return 0;
+                }
+            }
+        }
+        return endOrWait();
+    }
+
+    bool finished() const { return done; }
+};
+
+// Setup I2S for recording (mode=0) or playback (mode=1)
+inline void setupVoltI2S(int mode, int sampleRate = SAMPLE_RATE) {
+    halI2sBegin(mode == 0 ? HAL_I2S_MIC : HAL_I2S_SPEAKER, sampleRate);
+
+    if (mode != 0) {
+        halSpeakerAmp(true);
+    }
+}
 
 class VoltAI {
 private:
-    String apiKey;
-    String systemPrompt;
+    FixedString<256> authHeader;   // "Bearer <key>", built once in begin()
+    const char* systemPrompt;      // Caller's string, must outlive VoltAI
     int16_t* audioBuffer;
+    TurnArena arena;
     bool initialized;
     
+    // HTTP/2 connection kept open across turns (USE_HTTP2)
+    HalTlsClient h2Socket;
+    H2Connection h2;
+    unsigned long h2RetryAt;
+    
+    // Response buffer sizes (carved from the turn arena)
+    static const size_t TRANSCRIBE_RESPONSE_SIZE = 4096;
+    static const size_t CHAT_RESPONSE_SIZE = 8192;
+    
+    // Shortest piece of a reply sent as its own TTS request
+    static const size_t SPEECH_SEGMENT_MIN_CHARS = 60;
+    
+    // True if requests should go over HTTP/2. Connects on first use;
+    // if the server won't speak h2 we stay on HTTP/1.1 for a minute.
+    bool useHttp2() {
+        if (!USE_HTTP2) return false;
+        if (h2.canRequest()) return true;
+        if (h2RetryAt != 0 && (long)(halMillis() - h2RetryAt) < 0) return false;
+        
+        static const char* alpn[] = { "h2", nullptr };
+        h2Socket.stop();
+        h2Socket.setInsecure();
+        h2Socket.setAlpnProtocols(alpn);
+        
+        TRACE_DECLARE(connect, TRACE_CONNECT);
+        TRACE_START(connect);
+        if (dnsConnect(h2Socket, "api.openai.com", 443) &&
+            h2.begin(h2Socket, "api.openai.com", authHeader.c_str())) {
+            TRACE_STOP(connect);
+            h2RetryAt = 0;
+            return true;
+        }
+        
+        halLog("AI: HTTP/2 unavailable, using HTTP/1.1\n");
+        h2Socket.stop();
+        h2RetryAt = halMillis() + 60000;
+        return false;
+    }
+    
+    // Read a whole response body into arena memory
+    void readBody(HttpBodyReader& body, StrBuilder& out, unsigned long timeoutMs) {
+        unsigned long timeout = halMillis();
+        while (!body.finished() && halMillis() - timeout < timeoutMs && out.remaining() > 0) {
+            int n = body.read((uint8_t*)out.data() + out.length(), out.remaining());
+            if (n > 0) {
+                out.commit(n);
+            } else if (n < 0) {
+                halDelay(1);
+            }
+        }
+    }
+    
+    // HTTP/1.1 connection to the API (one request, then close)
+    bool connectApi(HalTlsClient& client) {
+        TRACE_SCOPE(TRACE_CONNECT);
+        client.setInsecure();
+        if (!dnsConnect(client, "api.openai.com", 443)) {
+            halLog("AI: Connection to api.openai.com failed\n");
+            return false;
+        }
+        return true;
+    }
+    
+    // Send an HTTP/1.1 request head, built in a pooled buffer
+    bool sendRequestHead(Client& client, const char* path, const char* contentType, size_t contentLength) {
+        char* requestBuf = (char*)memPools().alloc(HTTP_BUFFER_SIZE, MEM_CAP_INTERNAL);
+        if (!requestBuf) {
+            halLog("AI: No HTTP buffer available\n");
+            return false;
+        }
+        StrBuilder request(requestBuf, HTTP_BUFFER_SIZE);
+        request.appendf("POST %s HTTP/1.1\r\n", path);
+        request.append("Host: api.openai.com\r\n");
+        request.appendf("Authorization: %s\r\n", authHeader.c_str());
+        request.appendf("Content-Type: %s\r\n", contentType);
+        request.appendf("Content-Length: %u\r\n", (unsigned)contentLength);
+        request.append("Connection: close\r\n\r\n");
+        client.write((const uint8_t*)request.data(), request.length());
+        memPools().free(requestBuf);
+        return true;
+    }
+    
+    // TTS request body in arena memory (caller rewinds)
+    StrBuilder speechPayload(const char* text) {
+        TRACE_SCOPE(TRACE_ENCODE);
+        ArenaJsonDocument doc(2048);
+        doc["model"] = TTS_MODEL;
+        doc["input"] = text;
+        doc["voice"] = TTS_VOICE;
+        doc["response_format"] = "pcm";  // Raw PCM audio
+        doc["speed"] = TTS_SPEED;
+        
+        StrBuilder payload = arena.builder(measureJson(doc) + 1);
+        serializeJson(doc, payload.data(), payload.capacity());
+        payload.commit(strlen(payload.data()));
+        return payload;
+    }
+    
+    // Length of the next piece of text to speak: up to a sentence
+    // end once the piece is long enough, else the rest of the text
+    static size_t speechSegmentLength(const char* text) {
+        size_t i = 0;
+        while (text[i]) {
+            char c = text[i++];
+            if ((c == '.' || c == '!' || c == '?') && text[i] == ' ' &&
+                i >= SPEECH_SEGMENT_MIN_CHARS) {
+                return i;
+            }
+        }
+        return i;
+    }
+    
+    H2Stream* requestSpeech(const char* text, size_t len) {
+        aiMetrics().speechRequests.inc();
+        size_t scratch = arena.mark();
+        StrBuilder payload = speechPayload(arena.copy(text, len));
+        H2Stream* stream = nullptr;
+        if (!payload.isEmpty()) {
+            TRACE_SCOPE(TRACE_UPLOAD);
+            stream = h2.request("POST", "/v1/audio/speech", "application/json", (long)payload.length());
+            if (stream) {
+                stream->write((const uint8_t*)payload.data(), payload.length());
+            }
+        }
+        arena.rewind(scratch);
+        if (!stream) aiMetrics().speechCodes.count(-1);
+        return stream;
+    }
+    
+    // Speak over HTTP/2: one request per sentence, with the next
+    // sentences downloading (up to the stream limit) while one plays.
+    // Flow control keeps each prefetch within its receive ring.
+    void speakHttp2(const char* text, uint8_t* buffer) {
+        H2Stream* queue[H2Connection::MAX_STREAMS];
+        uint16_t pieces[H2Connection::MAX_STREAMS][2];   // Each stream's text, for the screen
+        int head = 0;
+        int queued = 0;
+        const char* next = text;
+        int totalBytes = 0;
+        PlaybackClock clock;
+        TRACE_DECLARE(playback, TRACE_PLAYBACK);
+        
+        setupVoltI2S(1);
+        
+        while (*next || queued > 0) {
+            while (*next && queued < H2Connection::MAX_STREAMS && h2.freeStreams() > 0) {
+                size_t len = speechSegmentLength(next);
+                H2Stream* stream = requestSpeech(next, len);
+                if (!stream) break;
+                int slot = (head + queued) % H2Connection::MAX_STREAMS;
+                queue[slot] = stream;
+                pieces[slot][0] = (uint16_t)(next - text);
+                pieces[slot][1] = (uint16_t)(next - text + len);
+                queued++;
+                next += len;
+                while (*next == ' ') next++;
+            }
+            if (queued == 0) {
+                halLog("AI: Could not open a speech stream\n");
+                break;
+            }
+            
+            H2Stream* stream = queue[head];
+            uint16_t* piece = pieces[head];
+            head = (head + 1) % H2Connection::MAX_STREAMS;
+            queued--;
+            
+            TRACE_DECLARE(wait, TRACE_SERVER_WAIT);
+            TRACE_START(wait);
+            int status = stream->awaitStatus(15000);
+            TRACE_STOP(wait);
+            aiMetrics().speechCodes.count(status);
+            if (status != 200) {
+                halLog("AI: Speech HTTP status %d\n", status);
+                stream->stop();
+                continue;
+            }
+            
+            unsigned long timeout = halMillis();
+            bool heard = false;
+            while (stream->connected() && halMillis() - timeout < 30000) {
+                int bytesRead = stream->read(buffer, TTS_JITTER_BUFFER);
+                if (bytesRead > 0) {
+                    if (totalBytes == 0) {
+                        TRACE_INSTANT(TRACE_TTS_FIRST_BYTE);
+                        TRACE_START(playback);
+                    }
+                    if (!heard) {
+                        speechText().playing(piece[0], piece[1], halMillis());
+                        heard = true;
+                    }
+                    if (clock.write(bytesRead, halMillis())) {
+                        aiMetrics().ttsUnderruns.inc();
+                    }
+                    halI2sWrite(buffer, bytesRead);
+                    totalBytes += bytesRead;
+                    timeout = halMillis();  // Reset timeout on data
+                } else {
+                    h2.poll(2);
+                }
+            }
+            stream->stop();
+        }
+        
+        TRACE_STOP(playback);
+        halLog("AI: Played %d bytes over HTTP/2\n", totalBytes);
+    }
+    
+    // Read the status line and the headers we act on without
+    // allocating. Returns the HTTP status or -1.
+    int readResponseHead(Client& client, HttpHead& head, unsigned long timeoutMs) {
+        FixedString<128> line;
+        bool statusLine = true;
+        head.status = -1;
+        head.contentLength = -1;
+        head.chunked = false;
+        
+        unsigned long start = halMillis();
+        while (client.connected() && halMillis() - start < timeoutMs) {
+            if (!client.available()) {
+                halDelay(1);
+                continue;
+            }
+            char c = (char)client.read();
+            if (c == '\r') continue;
+            if (c != '\n') {
+                line.append(c);
+                continue;
+            }
+            if (line.isEmpty()) {
+                return head.status;  // End of headers
+            }
+            if (statusLine) {
+                // "HTTP/1.1 200 OK"
+                const char* sp = strchr(line.c_str(), ' ');
+                head.status = sp ? atoi(sp + 1) : -1;
+                statusLine = false;
+            } else if (strncasecmp(line.c_str(), "Content-Length:", 15) == 0) {
+                head.contentLength = atol(line.c_str() + 15);
+            } else if (strncasecmp(line.c_str(), "Transfer-Encoding:", 18) == 0) {
+                head.chunked = strcasestr(line.c_str() + 18, "chunked") != nullptr;
+            }
+            line.clear();
+        }
+        head.status = -1;
+        return -1;
+    }
+    
     // Generate WAV header for audio data
     void generateWAVHeader(uint8_t* header, uint32_t dataSize) {
         uint32_t fileSize = dataSize + 36;
@@ -63,406 +506,483 @@ private:
         *(uint32_t*)(header + 40) = dataSize;
     }
     
-    // Setup I2S for recording (mode=0) or playback (mode=1)
-    void setupI2S(int mode) {
-        i2s_port_t port = (mode == 0) ? (i2s_port_t)MIC_I2S_NUM : (i2s_port_t)SPK_I2S_NUM;
-        
-        // Uninstall existing driver
-        i2s_driver_uninstall(port);
-        
-        i2s_config_t i2s_config = {
-            .mode = (mode == 0) ? 
-                (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_RX) : 
-                (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_TX),
-            .sample_rate = SAMPLE_RATE,
-            .bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT,
-            .channel_format = I2S_CHANNEL_FMT_ONLY_LEFT,
-            .communication_format = I2S_COMM_FORMAT_STAND_I2S,
-            .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
-            .dma_buf_count = 8,
-            .dma_buf_len = 1024,
-            .use_apll = false,
-            .tx_desc_auto_clear = true,
-            .fixed_mclk = 0
-        };
-        
-        i2s_pin_config_t pin_config;
-        
-        if (mode == 0) {
-            // Microphone pins
-            pin_config.bck_io_num = MIC_SCK;
-            pin_config.ws_io_num = MIC_WS;
-            pin_config.data_out_num = I2S_PIN_NO_CHANGE;
-            pin_config.data_in_num = MIC_SD;
-        } else {
-            // Speaker pins
-            pin_config.bck_io_num = SPK_BCLK;
-            pin_config.ws_io_num = SPK_LRCK;
-            pin_config.data_out_num = SPK_DOUT;
-            pin_config.data_in_num = I2S_PIN_NO_CHANGE;
-            
-            // Enable speaker amplifier
-            pinMode(SPK_SD_MODE, OUTPUT);
-            digitalWrite(SPK_SD_MODE, HIGH);
-        }
-        
-        i2s_driver_install(port, &i2s_config, 0, NULL);
-        i2s_set_pin(port, &pin_config);
-        
-        if (mode == 0) {
-            // Clear microphone DMA buffer
-            i2s_zero_dma_buffer(port);
-        }
-    }
-
 public:
-    VoltAI() : audioBuffer(nullptr), initialized(false) {}
+    VoltAI() : systemPrompt(""), audioBuffer(nullptr), initialized(false), h2RetryAt(0) {}
     
     ~VoltAI() {
+        h2.end();
         if (audioBuffer) {
-            free(audioBuffer);
+            memPools().free(audioBuffer);
             audioBuffer = nullptr;
         }
+        if (arena.isReady()) {
+            ArenaJsonAllocator::current() = nullptr;
+            memPools().free(arena.detach());
+        }
     }
     
     bool begin(const char* key, const char* prompt) {
         if (!key || strlen(key) < 10) {
-            Serial.println("AI: Invalid API key");
+            halLog("AI: Invalid API key\n");
             return false;
         }
         
-        apiKey = String(key);
-        systemPrompt = String(prompt);
+        authHeader.clear();
+        authHeader.append("Bearer ").append(key);
+        if (authHeader.overflowed()) {
+            halLog("AI: API key too long\n");
+            return false;
+        }
+        systemPrompt = prompt ? prompt : "";
         
-        // Allocate audio buffer
-        if (psramInit()) {
-            Serial.println("AI: Using PSRAM for audio buffer");
-            audioBuffer = (int16_t*)ps_malloc(BUFFER_SIZE * sizeof(int16_t));
+        // Reserve audio, arena and streaming buffers once; the pools
+        // place them by capability and fall back to internal RAM
+        if (Board::PSRAM && halPsramInit()) {
+            halLog("AI: PSRAM available for audio buffer\n");
         } else {
-            Serial.println("AI: Using heap for audio buffer");
-            audioBuffer = (int16_t*)malloc(BUFFER_SIZE * sizeof(int16_t));
+            halLog("AI: No PSRAM, audio buffer in internal heap\n");
         }
         
+        MemPools& pools = memPools();
+        if (pools.getBucketCount() == 0) {
+            pools.begin(VOLT_POOL_LAYOUT, sizeof(VOLT_POOL_LAYOUT) / sizeof(VOLT_POOL_LAYOUT[0]));
+            pools.printReport();
+        }
+        
+        audioBuffer = (int16_t*)pools.allocFrom("capture");
+        void* arenaBlock = pools.allocFrom("arena");
+        
         if (!audioBuffer) {
-            Serial.println("AI: Failed to allocate audio buffer");
+            halLog("AI: Failed to allocate audio buffer\n");
             return false;
         }
         
+        if (!arenaBlock) {
+            halLog("AI: Failed to allocate turn arena\n");
+            return false;
+        }
+        
+        arena.attach(arenaBlock, TURN_ARENA_SIZE);
+        ArenaJsonAllocator::current() = &arena;
+        
+        h2.setLimits(H2_MAX_STREAMS, H2_STREAM_WINDOW);
+        
         // Clear buffer
         memset(audioBuffer, 0, BUFFER_SIZE * sizeof(int16_t));
         
+        aiMetrics().registerAll(metricsRegistry());
         initialized = true;
-        Serial.println("AI: Initialized successfully");
+        halLog("AI: Initialized successfully\n");
         return true;
     }
     
     void recordAudio() {
         if (!initialized) {
-            Serial.println("AI: Not initialized");
+            halLog("AI: Not initialized\n");
             return;
         }
         
-        Serial.println("AI: Recording audio...");
-        setupI2S(0);  // Microphone mode
+        halLog("AI: Recording audio...\n");
+        setupVoltI2S(0);  // Microphone mode
         
-        size_t bytesRead = 0;
         size_t totalBytes = BUFFER_SIZE * sizeof(int16_t);
         
         // Record audio
-        esp_err_t result = i2s_read(
-            (i2s_port_t)MIC_I2S_NUM, 
-            audioBuffer, 
-            totalBytes, 
-            &bytesRead, 
-            portMAX_DELAY
-        );
-        
-        if (result == ESP_OK && bytesRead == totalBytes) {
-            Serial.printf("AI: Recorded %d bytes successfully\n", bytesRead);
+        size_t bytesRead;
+        {
+            TRACE_SCOPE(TRACE_RECORD);
+            bytesRead = halI2sRead(audioBuffer, totalBytes);
+        }
+        
+        if (bytesRead == totalBytes) {
+            halLog("AI: Recorded %u bytes successfully\n", (unsigned)bytesRead);
         } else {
-            Serial.printf("AI: Recording issue (error %d, got %d/%d bytes)\n", 
-                result, bytesRead, totalBytes);
+            halLog("AI: Recording issue (got %u/%u bytes)\n",
+                (unsigned)bytesRead, (unsigned)totalBytes);
         }
     }
     
-    String transcribe() {
+    // Returns arena memory: valid until endTurn()
+    const char* transcribe() {
         if (!initialized) {
-            Serial.println("AI: Not initialized");
+            halLog("AI: Not initialized\n");
             return "";
         }
         
-        if (WiFi.status() != WL_CONNECTED) {
-            Serial.println("AI: No WiFi connection");
+        if (!halNetConnected()) {
+            halLog("AI: No WiFi connection\n");
             return "";
         }
         
-        Serial.println("AI: Transcribing audio...");
+        halLog("AI: Transcribing audio...\n");
+        aiMetrics().transcribeRequests.inc();
         
-        // Prepare WAV file
+        // Prepare WAV header; the samples are sent straight
+        // from audioBuffer so no 160 KB copy is needed
+        TRACE_DECLARE(encode, TRACE_ENCODE);
+        TRACE_START(encode);
         uint32_t audioDataSize = BUFFER_SIZE * sizeof(int16_t);
         uint32_t wavFileSize = audioDataSize + 44;
         
-        uint8_t* wavBuffer = (uint8_t*)malloc(wavFileSize);
-        if (!wavBuffer) {
-            Serial.println("AI: Failed to allocate WAV buffer");
-            return "";
-        }
-        
-        generateWAVHeader(wavBuffer, audioDataSize);
-        memcpy(wavBuffer + 44, audioBuffer, audioDataSize);
-        
-        // Connect to OpenAI API
-        WiFiClientSecure client;
-        client.setInsecure();
-        
-        if (!client.connect("api.openai.com", 443)) {
-            Serial.println("AI: Connection to api.openai.com failed");
-            free(wavBuffer);
-            return "";
-        }
+        uint8_t wavHeader[44];
+        generateWAVHeader(wavHeader, audioDataSize);
         
-        String boundary = "----WebKitFormBoundary" + String(random(100000, 999999));
+        FixedString<48> boundary;
+        boundary.append("----WebKitFormBoundary").append(halRandom(100000, 999999));
         
         // Build multipart form data
-        String header = "";
-        header += "--" + boundary + "\r\n";
-        header += "Content-Disposition: form-data; name=\"model\"\r\n\r\n";
-        header += String(STT_MODEL) + "\r\n";
-        header += "--" + boundary + "\r\n";
-        header += "Content-Disposition: form-data; name=\"file\"; filename=\"audio.wav\"\r\n";
-        header += "Content-Type: audio/wav\r\n\r\n";
+        FixedString<256> header;
+        header.appendf("--%s\r\n", boundary.c_str());
+        header.append("Content-Disposition: form-data; name=\"model\"\r\n\r\n");
+        header.appendf("%s\r\n", STT_MODEL);
+        header.appendf("--%s\r\n", boundary.c_str());
+        header.append("Content-Disposition: form-data; name=\"file\"; filename=\"audio.wav\"\r\n");
+        header.append("Content-Type: audio/wav\r\n\r\n");
         
-        String footer = "\r\n--" + boundary + "--\r\n";
+        FixedString<64> footer;
+        footer.appendf("\r\n--%s--\r\n", boundary.c_str());
         
         size_t contentLength = header.length() + wavFileSize + footer.length();
         
-        // Send HTTP request
-        client.println("POST /v1/audio/transcriptions HTTP/1.1");
-        client.println("Host: api.openai.com");
-        client.println("Authorization: Bearer " + apiKey);
-        client.println("Content-Type: multipart/form-data; boundary=" + boundary);
-        client.println("Content-Length: " + String(contentLength));
-        client.println("Connection: close");
-        client.println();
+        FixedString<96> contentType;
+        contentType.appendf("multipart/form-data; boundary=%s", boundary.c_str());
+        TRACE_STOP(encode);
+        
+        // Open the stream or connect (traced as connect); the upload
+        // starts once the connection is up
+        HalTlsClient client;
+        H2Stream* stream = useHttp2() ?
+            h2.request("POST", "/v1/audio/transcriptions", contentType.c_str(), (long)contentLength) : nullptr;
+        Client& conn = stream ? (Client&)*stream : (Client&)client;
+        if (!stream && !connectApi(client)) {
+            aiMetrics().transcribeCodes.count(-1);
+            return "";
+        }
+        
+        TRACE_DECLARE(upload, TRACE_UPLOAD);
+        TRACE_START(upload);
+        if (!stream && !sendRequestHead(client, "/v1/audio/transcriptions", contentType.c_str(), contentLength)) {
+            aiMetrics().transcribeCodes.count(-1);
+            client.stop();
+            return "";
+        }
         
         // Send body
-        client.print(header);
-        client.write(wavBuffer, wavFileSize);
-        client.print(footer);
+        conn.print(header.c_str());
+        conn.write(wavHeader, sizeof(wavHeader));
+        conn.write((const uint8_t*)audioBuffer, audioDataSize);
+        conn.print(footer.c_str());
+        TRACE_STOP(upload);
         
         // Read response headers
-        unsigned long timeout = millis();
-        while (client.connected() && millis() - timeout < 15000) {
-            if (client.available()) {
-                String line = client.readStringUntil('\n');
-                if (line == "\r") break;  // End of headers
-            }
+        HttpHead head;
+        int status;
+        {
+            TRACE_SCOPE(TRACE_SERVER_WAIT);
+            status = stream ? stream->awaitStatus(15000) : readResponseHead(client, head, 15000);
         }
-        
-        // Read JSON response
-        String response = "";
-        timeout = millis();
-        while (client.connected() && millis() - timeout < 15000) {
-            if (client.available()) {
-                response += client.readString();
-            }
+        aiMetrics().transcribeCodes.count(status);
+        if (status != 200) {
+            halLog("AI: Transcription HTTP status %d\n", status);
         }
         
-        client.stop();
-        free(wavBuffer);
+        // Read JSON response into the arena
+        StrBuilder response = arena.builder(TRANSCRIBE_RESPONSE_SIZE);
+        HttpBodyReader body(conn, stream ? nullptr : &head);
+        readBody(body, response, 15000);
         
-        // Parse JSON
-        String result = "";
-        DynamicJsonDocument doc(2048);
-        DeserializationError error = deserializeJson(doc, response);
+        conn.stop();
+        arena.shrinkTo(response);
+        
+        // Parse JSON in place; the returned text points into response
+        const char* result = "";
+        ArenaJsonDocument doc(2048);
+        DeserializationError error = deserializeJson(doc, response.data(), response.length());
         
         if (error) {
-            Serial.printf("AI: JSON parse error: %s\n", error.c_str());
-            Serial.println("Response: " + response);
+            halLog("AI: JSON parse error: %s\n", error.c_str());
+            halLog("Response: %s\n", response.c_str());
         } else {
             if (doc.containsKey("text")) {
-                result = doc["text"].as<String>();
-                Serial.println("AI: Transcription: " + result);
+                result = doc["text"] | "";
+                halLog("AI: Transcription: %s\n", result);
             } else if (doc.containsKey("error")) {
-                Serial.println("AI: API Error: " + doc["error"]["message"].as<String>());
+                halLog("AI: API Error: %s\n", doc["error"]["message"] | "unknown");
             }
         }
         
         return result;
     }
     
-    String chat(String userMessage) {
+    // Returns arena memory: valid until endTurn()
+    const char* chat(const char* userMessage) {
         if (!initialized) {
-            Serial.println("AI: Not initialized");
+            halLog("AI: Not initialized\n");
             return "";
         }
         
-        if (WiFi.status() != WL_CONNECTED) {
-            Serial.println("AI: No WiFi connection");
+        if (!halNetConnected()) {
+            halLog("AI: No WiFi connection\n");
             return "";
         }
         
-        if (userMessage.length() == 0) {
-            Serial.println("AI: Empty message");
+        if (!userMessage || userMessage[0] == '\0') {
+            halLog("AI: Empty message\n");
             return "";
         }
         
-        Serial.println("AI: Getting GPT response...");
+        halLog("AI: Getting GPT response...\n");
+        aiMetrics().chatRequests.inc();
         
-        WiFiClientSecure client;
-        client.setInsecure();
-        HTTPClient https;
+        HalTlsClient client;
+        bool http2 = useHttp2();
         
-        if (!https.begin(client, "https://api.openai.com/v1/chat/completions")) {
-            Serial.println("AI: Failed to connect to API");
+        if (!http2 && !connectApi(client)) {
+            aiMetrics().chatCodes.count(-1);
             return "";
         }
         
-        https.addHeader("Authorization", "Bearer " + apiKey);
-        https.addHeader("Content-Type", "application/json");
-        https.setTimeout(20000);
-        
-        // Build JSON request
-        DynamicJsonDocument doc(4096);
-        doc["model"] = AI_MODEL;
-        doc["max_tokens"] = MAX_TOKENS;
-        doc["temperature"] = AI_TEMPERATURE;
-        
-        JsonArray messages = doc.createNestedArray("messages");
-        
-        JsonObject systemMsg = messages.createNestedObject();
-        systemMsg["role"] = "system";
-        systemMsg["content"] = systemPrompt;
-        
-        JsonObject userMsg = messages.createNestedObject();
-        userMsg["role"] = "user";
-        userMsg["content"] = userMessage;
-        
-        String jsonPayload;
-        serializeJson(doc, jsonPayload);
-        
-        int httpCode = https.POST(jsonPayload);
-        String result = "";
-        
-        if (httpCode == HTTP_CODE_OK || httpCode == 200) {
-            String response = https.getString();
+        // Build JSON request (released again once it is sent)
+        size_t scratch = arena.mark();
+        const char* result = "";
+        {
+            TRACE_DECLARE(encode, TRACE_ENCODE);
+            TRACE_START(encode);
+            ArenaJsonDocument doc(4096);
+            doc["model"] = AI_MODEL;
+            doc["max_tokens"] = MAX_TOKENS;
+            doc["temperature"] = AI_TEMPERATURE;
+            
+            JsonArray messages = doc.createNestedArray("messages");
+            
+            JsonObject systemMsg = messages.createNestedObject();
+            systemMsg["role"] = "system";
+            systemMsg["content"] = systemPrompt;
+            
+            JsonObject userMsg = messages.createNestedObject();
+            userMsg["role"] = "user";
+            userMsg["content"] = userMessage;
             
-            DynamicJsonDocument responseDoc(8192);
-            DeserializationError error = deserializeJson(responseDoc, response);
+            StrBuilder jsonPayload = arena.builder(measureJson(doc) + 1);
+            serializeJson(doc, jsonPayload.data(), jsonPayload.capacity());
             
-            if (error) {
-                Serial.printf("AI: JSON parse error: %s\n", error.c_str());
+            size_t payloadLength = strlen(jsonPayload.c_str());
+            TRACE_STOP(encode);
+            H2Stream* stream = nullptr;
+            HttpHead head;
+            int httpCode;
+            TRACE_DECLARE(upload, TRACE_UPLOAD);
+            TRACE_DECLARE(wait, TRACE_SERVER_WAIT);
+            TRACE_START(upload);
+            if (http2) {
+                stream = h2.request("POST", "/v1/chat/completions", "application/json", (long)payloadLength);
+                if (stream) {
+                    stream->write((const uint8_t*)jsonPayload.data(), payloadLength);
+                }
+                TRACE_STOP(upload);
+                TRACE_START(wait);
+                httpCode = stream ? stream->awaitStatus(20000) : -1;
+            } else if (sendRequestHead(client, "/v1/chat/completions", "application/json", payloadLength)) {
+                client.write((const uint8_t*)jsonPayload.data(), payloadLength);
+                TRACE_STOP(upload);
+                TRACE_START(wait);
+                httpCode = readResponseHead(client, head, 20000);
+            } else {
+                httpCode = -1;
+            }
+            TRACE_STOP(wait);
+            arena.rewind(scratch);
+            aiMetrics().chatCodes.count(httpCode);
+            
+            if (httpCode == 200) {
+                StrBuilder response = arena.builder(CHAT_RESPONSE_SIZE);
+                HttpBodyReader body(stream ? (Client&)*stream : (Client&)client, stream ? nullptr : &head);
+                readBody(body, response, 20000);
+                arena.shrinkTo(response);
+                
+                // Only keep the fields we read
+                StaticJsonDocument<128> filter;
+                filter["choices"][0]["message"]["content"] = true;
+                filter["error"]["message"] = true;
+                
+                ArenaJsonDocument responseDoc(1024);
+                DeserializationError error = deserializeJson(responseDoc, response.data(), response.length(),
+                                                             DeserializationOption::Filter(filter));
+                
+                if (error) {
+                    halLog("AI: JSON parse error: %s\n", error.c_str());
+                } else {
+                    if (responseDoc.containsKey("choices")) {
+                        result = responseDoc["choices"][0]["message"]["content"] | "";
+                        halLog("AI: GPT response: %s\n", result);
+                    } else if (responseDoc.containsKey("error")) {
+                        halLog("AI: API Error: %s\n", responseDoc["error"]["message"] | "unknown");
+                    }
+                }
             } else {
-                if (responseDoc.containsKey("choices")) {
-                    result = responseDoc["choices"][0]["message"]["content"].as<String>();
-                    Serial.println("AI: GPT response: " + result);
-                } else if (responseDoc.containsKey("error")) {
-                    Serial.println("AI: API Error: " + responseDoc["error"]["message"].as<String>());
+                halLog("AI: Chat failed (HTTP %d)\n", httpCode);
+                if (httpCode == 401) {
+                    halLog("AI: Invalid API key!\n");
+                } else if (httpCode == 429) {
+                    halLog("AI: Rate limit exceeded!\n");
                 }
             }
-        } else {
-            Serial.printf("AI: Chat failed (HTTP %d)\n", httpCode);
-            if (httpCode == 401) {
-                Serial.println("AI: Invalid API key!");
-            } else if (httpCode == 429) {
-                Serial.println("AI: Rate limit exceeded!");
+            
+            if (stream) {
+                stream->stop();
             }
         }
         
-        https.end();
+        client.stop();
         return result;
     }
     
-    void speak(String text) {
+    void speak(const char* text) {
         if (!initialized) {
-            Serial.println("AI: Not initialized");
+            halLog("AI: Not initialized\n");
             return;
         }
         
-        if (WiFi.status() != WL_CONNECTED) {
-            Serial.println("AI: No WiFi connection");
+        if (!halNetConnected()) {
+            halLog("AI: No WiFi connection\n");
             return;
         }
         
-        if (text.length() == 0) {
-            Serial.println("AI: Empty text");
+        if (!text || text[0] == '\0') {
+            halLog("AI: Empty text\n");
             return;
         }
         
-        Serial.println("AI: Speaking: " + text);
+        halLog("AI: Speaking: %s\n", text);
+        SpeechTextScope said(text);     // The screen follows along
         
-        WiFiClientSecure client;
-        client.setInsecure();
+        if (useHttp2()) {
+            uint8_t* buffer = (uint8_t*)memPools().alloc(TTS_JITTER_BUFFER, MEM_CAP_DMA);
+            if (!buffer) {
+                halLog("AI: No streaming buffers available\n");
+                return;
+            }
+            speakHttp2(text, buffer);
+            
+            // Silence padding to ensure all audio plays
+            memset(buffer, 0, 512);
+            halI2sWrite(buffer, 512);
+            memPools().free(buffer);
+            halDelay(100);
+            halSpeakerAmp(false);
+            
+            halLog("AI: Speech complete\n");
+            return;
+        }
         
-        if (!client.connect("api.openai.com", 443)) {
-            Serial.println("AI: Connection to api.openai.com failed");
+        aiMetrics().speechRequests.inc();
+        HalTlsClient client;
+        if (!connectApi(client)) {
+            aiMetrics().speechCodes.count(-1);
             return;
         }
         
-        // Build JSON request - Use PCM format for direct I2S playback
-        DynamicJsonDocument doc(2048);
-        doc["model"] = TTS_MODEL;
-        doc["input"] = text;
-        doc["voice"] = TTS_VOICE;
-        doc["response_format"] = "pcm";  // Raw PCM audio
-        doc["speed"] = TTS_SPEED;
+        // Everything speak() allocates is scratch
+        MemPools& pools = memPools();
+        uint8_t* buffer = (uint8_t*)pools.alloc(TTS_JITTER_BUFFER, MEM_CAP_DMA);
+        if (!buffer) {
+            halLog("AI: No streaming buffers available\n");
+            client.stop();
+            return;
+        }
+        size_t scratch = arena.mark();
         
-        String jsonPayload;
-        serializeJson(doc, jsonPayload);
-        
-        // Send HTTP request
-        client.println("POST /v1/audio/speech HTTP/1.1");
-        client.println("Host: api.openai.com");
-        client.println("Authorization: Bearer " + apiKey);
-        client.println("Content-Type: application/json");
-        client.println("Content-Length: " + String(jsonPayload.length()));
-        client.println("Connection: close");
-        client.println();
-        client.print(jsonPayload);
-        
-        // Skip response headers
-        unsigned long timeout = millis();
-        while (client.connected() && millis() - timeout < 15000) {
-            if (client.available()) {
-                String line = client.readStringUntil('\n');
-                if (line == "\r") break;
+        // Build JSON request - Use PCM format for direct I2S playback
+        bool sent;
+        {
+            StrBuilder jsonPayload = speechPayload(text);
+            size_t payloadLength = jsonPayload.length();
+            
+            // Send HTTP request
+            TRACE_SCOPE(TRACE_UPLOAD);
+            sent = sendRequestHead(client, "/v1/audio/speech", "application/json", payloadLength);
+            if (sent) {
+                client.write((const uint8_t*)jsonPayload.data(), payloadLength);
             }
         }
+        arena.rewind(scratch);
+        
+        // Read response headers; the PCM may arrive chunked
+        HttpHead head;
+        int status = -1;
+        if (sent) {
+            TRACE_SCOPE(TRACE_SERVER_WAIT);
+            status = readResponseHead(client, head, 15000);
+        }
+        aiMetrics().speechCodes.count(status);
+        if (status != 200) {
+            halLog("AI: Speech HTTP status %d\n", status);
+            pools.free(buffer);
+            client.stop();
+            return;
+        }
         
         // Setup I2S for playback
-        setupI2S(1);
+        setupVoltI2S(1);
         
-        // Stream PCM audio directly to I2S
-        uint8_t buffer[512];
-        size_t bytesWritten;
+        // Stream PCM audio directly to I2S through the internal-RAM
+        // jitter buffer
         int totalBytes = 0;
-        
-        timeout = millis();
-        while (client.connected() && millis() - timeout < 30000) {
-            if (client.available()) {
-                int bytesRead = client.readBytes(buffer, sizeof(buffer));
-                if (bytesRead > 0) {
-                    i2s_write((i2s_port_t)SPK_I2S_NUM, buffer, bytesRead, &bytesWritten, portMAX_DELAY);
-                    totalBytes += bytesRead;
-                    timeout = millis();  // Reset timeout on data
+        HttpBodyReader body(client, &head);
+        PlaybackClock clock;
+        TRACE_DECLARE(playback, TRACE_PLAYBACK);
+        
+        unsigned long timeout = halMillis();
+        while (!body.finished() && halMillis() - timeout < 30000) {
+            int bytesRead = body.read(buffer, TTS_JITTER_BUFFER);
+            if (bytesRead > 0) {
+                if (totalBytes == 0) {
+                    TRACE_INSTANT(TRACE_TTS_FIRST_BYTE);
+                    TRACE_START(playback);
+                    speechText().playing(0, (uint16_t)strlen(text), halMillis());
                 }
+                if (clock.write(bytesRead, halMillis())) {
+                    aiMetrics().ttsUnderruns.inc();
+                }
+                halI2sWrite(buffer, bytesRead);
+                totalBytes += bytesRead;
+                timeout = halMillis();  // Reset timeout on data
+            } else if (bytesRead < 0) {
+                halDelay(1);
             }
         }
         
-        Serial.printf("AI: Played %d bytes\n", totalBytes);
+        TRACE_STOP(playback);
+        halLog("AI: Played %d bytes\n", totalBytes);
         
         // Silence padding to ensure all audio plays
-        memset(buffer, 0, sizeof(buffer));
-        i2s_write((i2s_port_t)SPK_I2S_NUM, buffer, sizeof(buffer), &bytesWritten, portMAX_DELAY);
+        memset(buffer, 0, 512);
+        halI2sWrite(buffer, 512);
+        pools.free(buffer);
         
-        delay(100);
+        halDelay(100);
         
         client.stop();
         
         // Disable speaker amplifier to save power
-        digitalWrite(SPK_SD_MODE, LOW);
+        halSpeakerAmp(false);
         
-        Serial.println("AI: Speech complete");
+        halLog("AI: Speech complete\n");
+    }
+    
+    // Release everything transcribe()/chat() returned this turn
+    void endTurn() {
+        if (VERBOSE_LOGGING) {
+            ArenaStats stats = arena.getStats();
+            halLog("AI: Turn used %u/%u bytes in %u allocs (peak %u, failed %u)\n",
+                (unsigned)stats.used, (unsigned)stats.capacity, (unsigned)stats.turnAllocs,
+                (unsigned)stats.highWater, (unsigned)stats.failedAllocs);
+        }
+        arena.reset();
+    }
+    
+    ArenaStats getArenaStats() {
+        return arena.getStats();
     }
 };
 
@@ -0,0 +1,590 @@
+/*
+ * ============================================
+ * VOLT HAL - Hardware Abstraction Layer
+ * ============================================
+ *
+ * Handles:
+ * - Time (halMillis, halMicros, halDelay)
+ * - Logging (halLog, printf-style)
+ * - GPIO (pins, digital and analog reads,
+ *   change interrupts)
+ * - I2S microphone and speaker
+ * - Network status and the TLS client type
+ * - Non-blocking TCP server sockets (device
+ *   API): listen, accept, send, receive, wait,
+ *   and a wake socket to end a wait early
+ * - Filesystem (small whole-file reads/writes)
+ * - Heap by capability (internal, DMA, PSRAM)
+ *   with free / largest block / low-water stats
+ * - Task snapshot (run-time counters, stack
+ *   high-water marks, core, idle tasks)
+ * - Bounded message queues between tasks,
+ *   sends from interrupts too
+ * - System (PSRAM, random, light and deep
+ *   sleep, what woke the chip, core id)
+ * - Board parts some boards lack (speaker
+ *   amplifier enable, LED, battery ADC), from
+ *   board_traits.h; a missing one is a no-op
+ *   the compiler drops
+ *
+ * The engine, power manager and button logic
+ * only talk to hardware through these calls.
+ * On the ESP32 they are thin wrappers over the
+ * Arduino core and ESP-IDF drivers below. Off-
+ * target (no ARDUINO) the native Linux backend
+ * in host/hal_native.h is used instead, so the
+ * same code builds on a dev box for tests,
+ * benchmarks, perf and sanitizers.
+ *
+ * ============================================
+ */
+
+#ifndef VOLT_HAL_H
+#define VOLT_HAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "board_traits.h"
+
+enum HalI2sMode {
+    HAL_I2S_MIC = 0,         // Record from the INMP441
+    HAL_I2S_SPEAKER = 1      // Play through the MAX98357A
+};
+
+// Heap placement bits (0 = anywhere, internal first)
+enum HalHeapCap {
+    HAL_HEAP_INTERNAL = 0x01,
+    HAL_HEAP_DMA = 0x02,     // DMA-capable (always internal)
+    HAL_HEAP_SPIRAM = 0x04
+};
+
+struct HalHeapInfo {
+    size_t freeBytes;
+    size_t largestFree;      // Biggest single allocation that can succeed
+    size_t minFree;          // Low-water mark of freeBytes since boot
+};
+
+// One task in halTaskSnapshot()
+static const int HAL_MAX_TASKS = 24;
+
+struct HalTaskInfo {
+    char name[16];
+    uint32_t id;             // Task number, unique for the task's life
+    uint32_t runTime;        // Run-time counter (same units as the total, wraps)
+    uint32_t stackFree;      // Least free stack ever seen, bytes
+    int8_t core;             // Pinned core, -1 = either
+    uint8_t priority;
+    bool idle;               // The idle task of its core
+};
+
+// Why the chip is running: a reset or power on, or what ended a
+// deep sleep
+enum HalWakeCause {
+    HAL_WAKE_POWER_ON = 0,   // Power on, reset, flash, crash
+    HAL_WAKE_BUTTON = 1,     // The wake pin (ext0), set by halEnableWakeOnPin()
+    HAL_WAKE_TIMER = 2,
+    HAL_WAKE_OTHER = 3
+};
+
+// Fixed-size items copied in and out (FreeRTOS queue on the watch)
+typedef void* HalQueue;
+static const uint32_t HAL_WAIT_FOREVER = 0xFFFFFFFF;
+
+// Mutual exclusion between tasks (FreeRTOS mutex on the watch): a
+// waiting task blocks, and a lower-priority holder inherits its
+// priority until it lets go. Not for interrupt handlers.
+typedef void* HalLock;
+
+// Pin change handler; runs in interrupt context on the watch
+typedef void (*HalPinFn)(void* arg);
+
+#ifdef ARDUINO
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include <SPIFFS.h>
+#include <driver/i2s.h>
+#include <esp_sleep.h>
+#include <esp_pm.h>
+#include <esp_heap_caps.h>
+#include <esp_idf_version.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <lwip/sockets.h>
+#include "pins_hu087.h"
+
+// ============================================
+// TIME
+// ============================================
+
+inline unsigned long halMillis() { return millis(); }
+inline unsigned long halMicros() { return micros(); }
+inline void halDelay(unsigned long ms) { delay(ms); }
+
+// ============================================
+// LOGGING
+// ============================================
+
+inline void halLog(const char* fmt, ...) {
+    char buf[256];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    Serial.print(buf);
+}
+
+// ============================================
+// GPIO
+// ============================================
+
+inline void halPinMode(int pin, int mode) { pinMode(pin, mode); }
+inline void halDigitalWrite(int pin, int level) { digitalWrite(pin, level); }
+inline int halDigitalRead(int pin) { return digitalRead(pin); }
+inline int halAnalogRead(int pin) { return analogRead(pin); }
+
+// fn(arg) on every edge of pin. Keep fn short and IRAM_ATTR: read
+// the level, queue it, return.
+inline void halAttachPinChange(int pin, HalPinFn fn, void* arg) {
+    attachInterruptArg(digitalPinToInterrupt(pin), fn, arg, CHANGE);
+}
+
+// ============================================
+// I2S
+// ============================================
+
+// (Re)install the driver for the microphone or the speaker. On a
+// board with one shared port (BOARD_I2S_SHARED) this takes it over
+// from the other direction.
+inline bool halI2sBegin(HalI2sMode mode, int sampleRate) {
+    i2s_port_t port = (mode == HAL_I2S_MIC) ? (i2s_port_t)Board::Mic::PORT : (i2s_port_t)Board::Speaker::PORT;
+
+    // Uninstall existing driver
+    i2s_driver_uninstall(port);
+
+    i2s_config_t i2s_config = {
+        .mode = (mode == HAL_I2S_MIC) ?
+            (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_RX) :
+            (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_TX),
+        .sample_rate = (uint32_t)sampleRate,
+        .bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT,
+        .channel_format = I2S_CHANNEL_FMT_ONLY_LEFT,
+        .communication_format = I2S_COMM_FORMAT_STAND_I2S,
+        .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
+        .dma_buf_count = 8,
+        .dma_buf_len = 1024,
+        .use_apll = false,
+        .tx_desc_auto_clear = true,
+        .fixed_mclk = 0
+    };
+
+    i2s_pin_config_t pin_config;
+
+    if (mode == HAL_I2S_MIC) {
+        // Microphone pins
+        pin_config.bck_io_num = Board::Mic::SCK;
+        pin_config.ws_io_num = Board::Mic::WS;
+        pin_config.data_out_num = I2S_PIN_NO_CHANGE;
+        pin_config.data_in_num = Board::Mic::SD;
+    } else {
+        // Speaker pins
+        pin_config.bck_io_num = Board::Speaker::BCLK;
+        pin_config.ws_io_num = Board::Speaker::LRCK;
+        pin_config.data_out_num = Board::Speaker::DOUT;
+        pin_config.data_in_num = I2S_PIN_NO_CHANGE;
+    }
+
+    if (i2s_driver_install(port, &i2s_config, 0, NULL) != ESP_OK) {
+        return false;
+    }
+    i2s_set_pin(port, &pin_config);
+
+    if (mode == HAL_I2S_MIC) {
+        // Clear microphone DMA buffer
+        i2s_zero_dma_buffer(port);
+    }
+    return true;
+}
+
+// Blocks until len bytes are recorded. Returns bytes read.
+inline size_t halI2sRead(void* buf, size_t len) {
+    size_t bytesRead = 0;
+    i2s_read((i2s_port_t)Board::Mic::PORT, buf, len, &bytesRead, portMAX_DELAY);
+    return bytesRead;
+}
+
+// Blocks while the DMA queue is full. Returns bytes queued.
+inline size_t halI2sWrite(const void* buf, size_t len) {
+    size_t bytesWritten = 0;
+    i2s_write((i2s_port_t)Board::Speaker::PORT, buf, len, &bytesWritten, portMAX_DELAY);
+    return bytesWritten;
+}
+
+// ============================================
+// NETWORK
+// ============================================
+
+typedef WiFiClientSecure HalTlsClient;
+
+inline bool halNetConnected() { return WiFi.status() == WL_CONNECTED; }
+
+// ============================================
+// TCP SERVER
+// ============================================
+
+// Non-blocking listening socket on every interface (port 0: any
+// free port). Returns the socket or -1.
+inline int halTcpListen(uint16_t port, int backlog) {
+    int fd = lwip_socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    int on = 1;
+    lwip_setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (lwip_bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || lwip_listen(fd, backlog) != 0) {
+        lwip_close(fd);
+        return -1;
+    }
+    lwip_fcntl(fd, F_SETFL, lwip_fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    return fd;
+}
+
+inline uint16_t halTcpLocalPort(int fd) {
+    struct sockaddr_in addr = {};
+    socklen_t len = sizeof(addr);
+    if (lwip_getsockname(fd, (struct sockaddr*)&addr, &len) != 0) return 0;
+    return ntohs(addr.sin_port);
+}
+
+// A waiting connection, made non-blocking, or -1 if there is none
+inline int halTcpAccept(int listenFd) {
+    int fd = lwip_accept(listenFd, nullptr, nullptr);
+    if (fd < 0) return -1;
+    lwip_fcntl(fd, F_SETFL, lwip_fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    int on = 1;
+    lwip_setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    return fd;
+}
+
+// Bytes read, 0 if nothing has arrived, -1 once the peer closed
+// or the connection failed
+inline int halTcpRecv(int fd, void* buf, size_t len) {
+    int n = lwip_recv(fd, buf, len, 0);
+    if (n > 0) return n;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return 0;
+    return -1;
+}
+
+// Bytes the socket took (0 while its send buffer is full), or -1
+inline int halTcpSend(int fd, const void* buf, size_t len) {
+    int n = lwip_send(fd, buf, len, 0);
+    if (n >= 0) return n;
+    return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+}
+
+inline void halTcpClose(int fd) { lwip_close(fd); }
+
+// Waits until one of fds can be read (or, where wantWrite is set,
+// written instead) or timeoutMs passes. Returns how many are ready.
+inline int halTcpWait(const int* fds, const bool* wantWrite, int count, uint32_t timeoutMs) {
+    fd_set rd, wr;
+    FD_ZERO(&rd);
+    FD_ZERO(&wr);
+    int top = -1;
+    for (int i = 0; i < count; i++) {
+        if (fds[i] < 0) continue;
+        FD_SET(fds[i], wantWrite[i] ? &wr : &rd);
+        if (fds[i] > top) top = fds[i];
+    }
+    struct timeval tv = { (long)(timeoutMs / 1000), (long)(timeoutMs % 1000) * 1000 };
+    int n = lwip_select(top + 1, &rd, &wr, nullptr, &tv);
+    return n < 0 ? 0 : n;
+}
+
+// A loopback UDP socket connected to itself: another task sends a
+// byte to end a halTcpWait() early (what esp_http_server's control
+// socket does). Returns the socket or -1.
+inline int halWakeOpen() {
+    int fd = lwip_socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) return -1;
+    struct sockaddr_in addr = {};
+    socklen_t len = sizeof(addr);
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (lwip_bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        lwip_getsockname(fd, (struct sockaddr*)&addr, &len) != 0 ||
+        lwip_connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        lwip_close(fd);
+        return -1;
+    }
+    lwip_fcntl(fd, F_SETFL, lwip_fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    return fd;
+}
+
+// From any task
+inline void halWakeSignal(int fd) {
+    uint8_t b = 1;
+    lwip_send(fd, &b, 1, 0);
+}
+
+inline void halWakeDrain(int fd) {
+    uint8_t buf[16];
+    while (lwip_recv(fd, buf, sizeof(buf), 0) > 0) {}
+}
+
+// ============================================
+// FILESYSTEM
+// ============================================
+
+inline bool halFsBegin() { return SPIFFS.begin(true); }
+
+// Returns bytes read, -1 if the file doesn't exist
+inline long halFsRead(const char* path, void* buf, size_t cap) {
+    File f = SPIFFS.open(path, "r");
+    if (!f) return -1;
+    long n = (long)f.read((uint8_t*)buf, cap);
+    f.close();
+    return n;
+}
+
+inline bool halFsWrite(const char* path, const void* data, size_t len) {
+    File f = SPIFFS.open(path, "w");
+    if (!f) return false;
+    bool ok = f.write((const uint8_t*)data, len) == len;
+    f.close();
+    return ok;
+}
+
+inline bool halFsRemove(const char* path) { return SPIFFS.remove(path); }
+
+// ============================================
+// HEAP
+// ============================================
+
+inline void* halHeapAlloc(size_t size, uint8_t caps) {
+    uint32_t flags = MALLOC_CAP_8BIT;
+    if (caps & HAL_HEAP_DMA) {
+        flags |= MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL;
+    } else if (caps & HAL_HEAP_SPIRAM) {
+        flags |= MALLOC_CAP_SPIRAM;
+    } else if (caps & HAL_HEAP_INTERNAL) {
+        flags |= MALLOC_CAP_INTERNAL;
+    }
+    return heap_caps_malloc(size, flags);
+}
+
+inline void halHeapFree(void* p) { heap_caps_free(p); }
+
+// One region: HAL_HEAP_INTERNAL or HAL_HEAP_SPIRAM. Counts
+// everything on it, including String, TLS and driver buffers.
+inline HalHeapInfo halHeapInfo(uint8_t caps) {
+    uint32_t flags = (caps & HAL_HEAP_SPIRAM) ? MALLOC_CAP_SPIRAM : MALLOC_CAP_INTERNAL;
+    flags |= MALLOC_CAP_8BIT;
+    HalHeapInfo info;
+    info.freeBytes = heap_caps_get_free_size(flags);
+    info.largestFree = heap_caps_get_largest_free_block(flags);
+    info.minFree = heap_caps_get_minimum_free_size(flags);
+    return info;
+}
+
+// ============================================
+// TASKS
+// ============================================
+
+// Fills out with up to max tasks and *totalRunTime with the
+// run-time clock. Returns the count, 0 when the core was built
+// without trace facility (uxTaskGetSystemState). Suspends the
+// scheduler for the copy: call every few seconds, not per frame.
+inline int halTaskSnapshot(HalTaskInfo* out, int max, uint32_t* totalRunTime) {
+    *totalRunTime = 0;
+#if configUSE_TRACE_FACILITY
+    static TaskStatus_t status[HAL_MAX_TASKS];
+    uint32_t total = 0;
+    int n = (int)uxTaskGetSystemState(status, HAL_MAX_TASKS, &total);
+    if (n > max) n = max;
+    TaskHandle_t idle[portNUM_PROCESSORS];
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+#if ESP_IDF_VERSION_MAJOR >= 5
+        idle[c] = xTaskGetIdleTaskHandleForCore(c);
+#else
+        idle[c] = xTaskGetIdleTaskHandleForCPU(c);
+#endif
+    }
+    for (int i = 0; i < n; i++) {
+        const TaskStatus_t& t = status[i];
+        HalTaskInfo& info = out[i];
+        strncpy(info.name, t.pcTaskName, sizeof(info.name) - 1);
+        info.name[sizeof(info.name) - 1] = '\0';
+        info.id = (uint32_t)t.xTaskNumber;
+        info.runTime = (uint32_t)t.ulRunTimeCounter;
+        info.stackFree = (uint32_t)t.usStackHighWaterMark;   // Bytes on the ESP32
+#if ESP_IDF_VERSION_MAJOR >= 5
+        BaseType_t core = xTaskGetCoreID(t.xHandle);
+#else
+        BaseType_t core = xTaskGetAffinity(t.xHandle);
+#endif
+        info.core = core == tskNO_AFFINITY ? -1 : (int8_t)core;
+        info.priority = (uint8_t)t.uxCurrentPriority;
+        info.idle = false;
+        for (int c = 0; c < portNUM_PROCESSORS; c++) {
+            if (t.xHandle == idle[c]) info.idle = true;
+        }
+    }
+    *totalRunTime = total;
+    return n;
+#else
+    return 0;
+#endif
+}
+
+// ============================================
+// QUEUES
+// ============================================
+
+inline TickType_t halTicks(uint32_t ms) {
+    return ms == HAL_WAIT_FOREVER ? portMAX_DELAY : pdMS_TO_TICKS(ms);
+}
+
+// nullptr when out of memory
+inline HalQueue halQueueCreate(size_t itemSize, int depth) {
+    return (HalQueue)xQueueCreate(depth, itemSize);
+}
+
+inline void halQueueDelete(HalQueue q) { vQueueDelete((QueueHandle_t)q); }
+
+// Waits up to timeoutMs for room; false if there was none
+inline bool halQueueSend(HalQueue q, const void* item, uint32_t timeoutMs) {
+    return xQueueSend((QueueHandle_t)q, item, halTicks(timeoutMs)) == pdTRUE;
+}
+
+// Waits up to timeoutMs for an item; false if none came
+inline bool halQueueReceive(HalQueue q, void* item, uint32_t timeoutMs) {
+    return xQueueReceive((QueueHandle_t)q, item, halTicks(timeoutMs)) == pdTRUE;
+}
+
+inline int halQueueWaiting(HalQueue q) { return (int)uxQueueMessagesWaiting((QueueHandle_t)q); }
+
+// From an interrupt handler: never waits, false if full
+inline bool IRAM_ATTR halQueueSendFromIsr(HalQueue q, const void* item) {
+    BaseType_t woken = pdFALSE;
+    bool sent = xQueueSendFromISR((QueueHandle_t)q, item, &woken) == pdTRUE;
+    if (woken) portYIELD_FROM_ISR();
+    return sent;
+}
+
+// ============================================
+// LOCKS
+// ============================================
+
+// nullptr when out of memory
+inline HalLock halLockCreate() { return (HalLock)xSemaphoreCreateMutex(); }
+
+inline void halLockDelete(HalLock l) { vSemaphoreDelete((SemaphoreHandle_t)l); }
+
+// Waits as long as it takes
+inline void halLockTake(HalLock l) { xSemaphoreTake((SemaphoreHandle_t)l, portMAX_DELAY); }
+
+inline void halLockGive(HalLock l) { xSemaphoreGive((SemaphoreHandle_t)l); }
+
+// ============================================
+// SYSTEM
+// ============================================
+
+inline bool halPsramInit() { return psramInit(); }
+inline long halRandom(long low, long high) { return random(low, high); }
+
+// Core the caller is running on (0 or 1)
+inline int halCoreId() { return xPortGetCoreID(); }
+
+inline void halEnableWakeOnPin(int pin, int level) {
+    esp_sleep_enable_ext0_wakeup((gpio_num_t)pin, level);
+}
+
+// Does not return
+inline void halDeepSleep() { esp_deep_sleep_start(); }
+
+inline HalWakeCause halWakeCause() {
+    switch (esp_sleep_get_wakeup_cause()) {
+        case ESP_SLEEP_WAKEUP_UNDEFINED: return HAL_WAKE_POWER_ON;
+        case ESP_SLEEP_WAKEUP_EXT0: return HAL_WAKE_BUTTON;
+        case ESP_SLEEP_WAKEUP_TIMER: return HAL_WAKE_TIMER;
+        default: return HAL_WAKE_OTHER;
+    }
+}
+
+// Automatic light sleep whenever every task is blocked, woken by
+// wakePin going low (ext0, like deep sleep) or the next timeout.
+// Needs a core built with power management and tickless idle;
+// false (and nothing changes) without.
+inline bool halLightSleepBegin(int wakePin) {
+#if CONFIG_PM_ENABLE && CONFIG_FREERTOS_USE_TICKLESS_IDLE
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+    esp_pm_config_t pm = {};
+#else
+    esp_pm_config_esp32_t pm = {};
+#endif
+    pm.max_freq_mhz = 240;
+    pm.min_freq_mhz = 80;
+    pm.light_sleep_enable = true;
+    if (esp_pm_configure(&pm) != ESP_OK) return false;
+    esp_sleep_enable_ext0_wakeup((gpio_num_t)wakePin, 0);
+    return true;
+#else
+    (void)wakePin;
+    return false;
+#endif
+}
+
+// Holds the chip awake (block) or lets it sleep again. Only a
+// press wakes it, so hold it while a button is down.
+inline void halLightSleepBlock(bool block) {
+#if CONFIG_PM_ENABLE
+    static esp_pm_lock_handle_t lock = nullptr;
+    static bool held = false;
+    if (!lock && esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "button", &lock) != ESP_OK) return;
+    if (block == held) return;
+    held = block;
+    if (block) esp_pm_lock_acquire(lock);
+    else esp_pm_lock_release(lock);
+#else
+    (void)block;
+#endif
+}
+
+#else
+
+#include "hal_native.h"
+
+#endif // ARDUINO
+
+// ============================================
+// BOARD
+// ============================================
+
+// Speaker amplifier on or off, on boards with an enable pin
+inline void halSpeakerAmp(bool on) {
+    if (Board::Speaker::SD_MODE < 0) return;
+    halPinMode(Board::Speaker::SD_MODE, OUTPUT);
+    halDigitalWrite(Board::Speaker::SD_MODE, on ? HIGH : LOW);
+}
+
+// Status LED, on boards that have a free pin for one, whichever
+// level lights it
+inline void halLed(bool on) {
+    if (Board::LED < 0) return;
+    halPinMode(Board::LED, OUTPUT);
+    halDigitalWrite(Board::LED, boardLedHigh<Board>(on) ? HIGH : LOW);
+}
+
+// Battery voltage in millivolts; -1 without a battery ADC
+inline int halBatteryMillivolts() {
+    if (Board::Battery::PIN < 0) return -1;
+    return boardBatteryMillivolts<Board>(halAnalogRead(Board::Battery::PIN));
+}
+
+#endif // VOLT_HAL_H
@@ -0,0 +1,493 @@
+/*
+ * ============================================
+ * VOLT Realtime Engine - Speech to Speech
+ * ============================================
+ *
+ * Alternative to the Whisper -> Chat -> TTS
+ * pipeline in volt_ai_FINAL.h. One WebSocket
+ * session to the Realtime API stays open:
+ * - Mic frames are streamed up while recording
+ * - Audio deltas are played as they arrive
+ * - Transcript deltas go to the screen as they
+ *   arrive (speech_text.h)
+ *
+ * Audio format on the wire is pcm16 @ 24 kHz,
+ * so mic audio (16 kHz) is upsampled 2:3 on
+ * the fly and playback runs I2S at 24 kHz.
+ *
+ * Enable with USE_REALTIME_MODE in the config.
+ *
+ * ============================================
+ */
+
+#ifndef VOLT_REALTIME_H
+#define VOLT_REALTIME_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "volt_hal.h"
+#include "config_stone.h"
+#include "pins_hu087.h"
+#include "volt_ai_FINAL.h"
+#include "ws_client.h"
+#include "base64_stream.h"
+#include "dns_cache.h"
+#include "speech_text.h"
+
+// ============================================
+// 16 kHz -> 24 kHz LINEAR UPSAMPLER
+// ============================================
+
+class Upsampler2to3 {
+private:
+    int16_t last;     // Final sample of the previous block
+    uint32_t phase;   // Next output position, in thirds of an input sample
+
+public:
+    Upsampler2to3() : last(0), phase(3) {}
+
+    void reset() {
+        last = 0;
+        phase = 3;
+    }
+
+    // Exact number of samples process() will emit for n inputs
+    size_t outputCount(size_t n) const {
+        uint32_t end = 3 * (uint32_t)n;
+        return phase <= end ? (end - phase) / 2 + 1 : 0;
+    }
+
+    // out must hold outputCount(n) samples
+    size_t process(const int16_t* in, size_t n, int16_t* out) {
+        if (n == 0) return 0;
+        size_t produced = 0;
+        uint32_t end = 3 * (uint32_t)n;
+        while (phase <= end) {
+            uint32_t i = phase / 3;
+            uint32_t frac = phase % 3;
+            // Position i is in [last, in[0..n-1]]
+            int32_t a = (i == 0) ? last : in[i - 1];
+            int32_t b = (i < n) ? in[i] : a;
+            out[produced++] = (int16_t)(a + (b - a) * (int32_t)frac / 3);
+            phase += 2;
+        }
+        phase -= end;
+        last = in[n - 1];
+        return produced;
+    }
+};
+
+// ============================================
+// REALTIME ENGINE
+// ============================================
+
+class VoltRealtime : public WsHandler {
+private:
+    HalTlsClient tls;
+    WsClient ws;
+    FixedString<320> extraHeaders;   // Authorization + beta opt-in
+    const char* instructions;
+    bool initialized;
+
+    // Incoming event assembly
+    enum RxMode { RX_HEAD, RX_AUDIO, RX_TAIL };
+    RxMode rxMode;
+    char* eventBuf;        // Whole non-audio events, or audio event heads
+    size_t eventLen;
+    bool eventOverflow;
+    Base64Decoder decoder;
+
+    // Playback
+    uint8_t* pcm;          // Decoded audio waiting for I2S
+    size_t pcmLen;
+    bool playing;
+    bool responseDone;
+    bool responseFailed;
+    unsigned long lastRxTime;
+    unsigned long requestTime;
+    unsigned long firstAudioLatency;
+    uint32_t audioBytesPlayed;
+
+    Upsampler2to3 upsampler;
+
+    static const size_t PCM_FLUSH_BYTES = 1024;
+
+    // Copy the value of "type" out of a (possibly truncated) event
+    static bool eventType(const char* json, size_t len, char* out, size_t outCap) {
+        const char* key = "\"type\":\"";
+        const size_t keyLen = 8;
+        for (size_t i = 0; i + keyLen <= len; i++) {
+            if (memcmp(json + i, key, keyLen) != 0) continue;
+            size_t j = i + keyLen;
+            size_t k = 0;
+            while (j < len && json[j] != '"' && k + 1 < outCap) {
+                out[k++] = json[j++];
+            }
+            out[k] = '\0';
+            return j < len;
+        }
+        out[0] = '\0';
+        return false;
+    }
+
+    static bool isAudioDelta(const char* type) {
+        return strcmp(type, "response.audio.delta") == 0 ||
+               strcmp(type, "response.output_audio.delta") == 0;
+    }
+
+    static bool isTranscriptDelta(const char* type) {
+        return strcmp(type, "response.audio_transcript.delta") == 0 ||
+               strcmp(type, "response.output_audio_transcript.delta") == 0;
+    }
+
+    void flushPcm(bool all) {
+        size_t n = all ? pcmLen : (pcmLen & ~(size_t)1);
+        if (n == 0 || !playing) {
+            if (!playing) pcmLen = 0;
+            return;
+        }
+        halI2sWrite(pcm, n);
+        audioBytesPlayed += n;
+        memmove(pcm, pcm + n, pcmLen - n);
+        pcmLen -= n;
+    }
+
+    void playBase64(const char* text, size_t len) {
+        if (!pcm) return;
+        // Decode in slices that always fit the PCM block
+        while (len > 0) {
+            size_t room = TTS_JITTER_BUFFER - pcmLen;
+            size_t slice = ((room - 3) / 3) * 4;
+            if (slice > len) slice = len;
+            pcmLen += decoder.update(text, slice, pcm + pcmLen);
+            text += slice;
+            len -= slice;
+            if (pcmLen >= PCM_FLUSH_BYTES) {
+                if (firstAudioLatency == 0) {
+                    firstAudioLatency = halMillis() - requestTime;
+                    // The transcript runs ahead; the screen paces itself
+                    speechText().playing(0, SpeechText::MAX_CHARS, halMillis());
+                }
+                flushPcm(false);
+            }
+        }
+    }
+
+    void handleEvent(const char* type) {
+        if (strcmp(type, "response.done") == 0) {
+            responseDone = true;
+        } else if (isTranscriptDelta(type)) {
+            StaticJsonDocument<32> filter;
+            filter["delta"] = true;
+            StaticJsonDocument<512> doc;
+            if (!eventOverflow &&
+                !deserializeJson(doc, eventBuf, eventLen, DeserializationOption::Filter(filter))) {
+                const char* delta = doc["delta"] | "";
+                speechText().append(delta, strlen(delta));
+            }
+        } else if (strcmp(type, "error") == 0) {
+            StaticJsonDocument<96> filter;
+            filter["error"]["message"] = true;
+            StaticJsonDocument<256> doc;
+            if (!eventOverflow &&
+                !deserializeJson(doc, eventBuf, eventLen, DeserializationOption::Filter(filter))) {
+                halLog("Realtime: API Error: %s\n", doc["error"]["message"] | "unknown");
+            } else {
+                halLog("Realtime: API Error\n");
+            }
+            responseFailed = true;
+            responseDone = true;
+        } else if (VERBOSE_LOGGING) {
+            halLog("Realtime: <- %s\n", type);
+        }
+    }
+
+    bool sendEvent(const char* json) {
+        if (!ws.sendText(json)) {
+            halLog("Realtime: Send failed\n");
+            return false;
+        }
+        return true;
+    }
+
+    bool sendSessionUpdate() {
+        StaticJsonDocument<768> doc;
+        doc["type"] = "session.update";
+        JsonObject session = doc.createNestedObject("session");
+        JsonArray modalities = session.createNestedArray("modalities");
+        modalities.add("audio");
+        modalities.add("text");
+        session["instructions"] = instructions;
+        session["voice"] = TTS_VOICE;
+        session["input_audio_format"] = "pcm16";
+        session["output_audio_format"] = "pcm16";
+        session["turn_detection"] = (const char*)nullptr;   // Button decides turns
+        session["temperature"] = AI_TEMPERATURE < 0.6f ? 0.6f : AI_TEMPERATURE;
+
+        size_t len = serializeJson(doc, eventBuf, REALTIME_EVENT_BUFFER);
+        if (len == 0 || len >= REALTIME_EVENT_BUFFER) {
+            halLog("Realtime: session.update too large\n");
+            return false;
+        }
+        return sendEvent(eventBuf);
+    }
+
+    bool ensureSession() {
+        if (ws.isOpen()) {
+            return true;
+        }
+
+        halLog("Realtime: Opening session...\n");
+        tls.stop();
+        tls.setInsecure();
+        if (!dnsConnect(tls, "api.openai.com", 443)) {
+            halLog("Realtime: Connection to api.openai.com failed\n");
+            return false;
+        }
+
+        FixedString<96> path;
+        path.appendf("/v1/realtime?model=%s", REALTIME_MODEL);
+        if (!ws.handshake(tls, "api.openai.com", path.c_str(), extraHeaders.c_str(), 10000)) {
+            tls.stop();
+            return false;
+        }
+
+        eventLen = 0;
+        rxMode = RX_HEAD;
+        return sendSessionUpdate();
+    }
+
+public:
+    VoltRealtime() : instructions(""), initialized(false), rxMode(RX_HEAD), eventBuf(nullptr),
+                     eventLen(0), eventOverflow(false), pcm(nullptr), pcmLen(0), playing(false),
+                     responseDone(false), responseFailed(false), lastRxTime(0), requestTime(0),
+                     firstAudioLatency(0), audioBytesPlayed(0) {}
+
+    // Call after VoltAI::begin() so the shared pools exist
+    bool begin(const char* key, const char* prompt) {
+        if (!key || strlen(key) < 10) {
+            halLog("Realtime: Invalid API key\n");
+            return false;
+        }
+
+        extraHeaders.clear();
+        extraHeaders.appendf("Authorization: Bearer %s\r\n", key);
+        extraHeaders.append("OpenAI-Beta: realtime=v1\r\n");
+        if (extraHeaders.overflowed()) {
+            halLog("Realtime: API key too long\n");
+            return false;
+        }
+        instructions = prompt;
+
+        eventBuf = (char*)memPools().allocFrom("event");
+        if (!eventBuf) {
+            halLog("Realtime: Failed to allocate event buffer\n");
+            return false;
+        }
+
+        initialized = true;
+        halLog("Realtime: Initialized\n");
+        return true;
+    }
+
+    bool isReady() {
+        return initialized;
+    }
+
+    // Record for durationMs, sending each mic frame as it is captured
+    bool streamMicrophone(unsigned long durationMs) {
+        if (!initialized || !halNetConnected()) {
+            return false;
+        }
+        if (!ensureSession()) {
+            return false;
+        }
+
+        int16_t* frame = (int16_t*)memPools().alloc(TTS_JITTER_BUFFER, MEM_CAP_DMA);
+        if (!frame) {
+            halLog("Realtime: No mic frame buffer available\n");
+            return false;
+        }
+
+        sendEvent("{\"type\":\"input_audio_buffer.clear\"}");
+        upsampler.reset();
+        setupVoltI2S(0);
+
+        static const char prefix[] = "{\"type\":\"input_audio_buffer.append\",\"audio\":\"";
+        static const char suffix[] = "\"}";
+        const size_t SLICE = 128;                 // Input samples per encode step
+        int16_t up[SLICE * 3 / 2 + 2];
+        char text[((sizeof(up) + 2) / 3) * 4 + 4];
+
+        halLog("Realtime: Streaming microphone...\n");
+        uint32_t framesSent = 0;
+        bool ok = true;
+        unsigned long start = halMillis();
+        while (ok && halMillis() - start < durationMs) {
+            size_t bytesRead = halI2sRead(frame, TTS_JITTER_BUFFER);
+            size_t samples = bytesRead / sizeof(int16_t);
+            if (samples == 0) continue;
+
+            // Frame length must be known before the first byte goes out
+            size_t upSamples = 0;
+            {
+                Upsampler2to3 probe = upsampler;
+                for (size_t i = 0; i < samples; i += SLICE) {
+                    size_t n = samples - i < SLICE ? samples - i : SLICE;
+                    upSamples += probe.outputCount(n);
+                    probe.process(frame + i, n, up);
+                }
+            }
+            size_t audioChars = Base64Encoder::encodedLength(upSamples * sizeof(int16_t));
+            ok = ws.beginFrame(WS_OP_TEXT, strlen(prefix) + audioChars + strlen(suffix)) &&
+                 ws.writeFrameData(prefix);
+
+            Base64Encoder enc;
+            for (size_t i = 0; ok && i < samples; i += SLICE) {
+                size_t n = samples - i < SLICE ? samples - i : SLICE;
+                size_t m = upsampler.process(frame + i, n, up);
+                size_t chars = enc.update((const uint8_t*)up, m * sizeof(int16_t), text, sizeof(text));
+                ok = ws.writeFrameData((const uint8_t*)text, chars);
+            }
+            if (ok) {
+                size_t chars = enc.finish(text);
+                ok = ws.writeFrameData((const uint8_t*)text, chars) && ws.writeFrameData(suffix);
+            }
+            framesSent++;
+
+            // Service pings and early events between frames
+            ws.poll(*this, 1024);
+        }
+
+        memPools().free(frame);
+        halLog("Realtime: Sent %u mic frames\n", (unsigned)framesSent);
+        if (!ok) {
+            halLog("Realtime: Session dropped while streaming\n");
+        }
+        return ok;
+    }
+
+    // Close the input turn and ask for a spoken reply
+    bool requestResponse() {
+        if (!ws.isOpen()) return false;
+        responseDone = false;
+        responseFailed = false;
+        firstAudioLatency = 0;
+        requestTime = halMillis();
+        return sendEvent("{\"type\":\"input_audio_buffer.commit\"}") &&
+               sendEvent("{\"type\":\"response.create\"}");
+    }
+
+    // Play audio deltas as they arrive until response.done
+    bool playResponse(unsigned long idleTimeoutMs = 30000) {
+        pcm = (uint8_t*)memPools().alloc(TTS_JITTER_BUFFER, MEM_CAP_DMA);
+        if (!pcm) {
+            halLog("Realtime: No playback buffer available\n");
+            return false;
+        }
+        pcmLen = 0;
+        audioBytesPlayed = 0;
+        decoder.reset();
+
+        setupVoltI2S(1, REALTIME_SAMPLE_RATE);
+        playing = true;
+        SpeechTextScope said;           // Filled in by the transcript
+
+        lastRxTime = halMillis();
+        while (!responseDone && halMillis() - lastRxTime < idleTimeoutMs) {
+            if (!ws.poll(*this)) {
+                responseFailed = true;
+                break;
+            }
+            halDelay(1);
+        }
+        flushPcm(true);
+
+        // Silence padding to ensure all audio plays
+        memset(pcm, 0, 512);
+        halI2sWrite(pcm, 512);
+        halDelay(100);
+        halSpeakerAmp(false);
+
+        playing = false;
+        memPools().free(pcm);
+        pcm = nullptr;
+
+        halLog("Realtime: Played %u bytes (first audio after %lu ms)\n",
+            (unsigned)audioBytesPlayed, firstAudioLatency);
+        return responseDone && !responseFailed;
+    }
+
+    unsigned long getFirstAudioLatency() {
+        return firstAudioLatency;
+    }
+
+    void end() {
+        ws.close();
+        tls.stop();
+    }
+
+    // ---- WsHandler ----
+
+    void onMessageData(uint8_t opcode, const uint8_t* data, size_t len,
+                       bool first, bool last) override {
+        lastRxTime = halMillis();
+        if (opcode != WS_OP_TEXT) return;
+
+        if (first) {
+            rxMode = RX_HEAD;
+            eventLen = 0;
+            eventOverflow = false;
+        }
+
+        const char* p = (const char*)data;
+        size_t i = 0;
+        while (i < len) {
+            if (rxMode == RX_HEAD) {
+                // Buffer until we know whether this is an audio delta
+                char c = p[i++];
+                if (eventLen + 1 < REALTIME_EVENT_BUFFER) {
+                    eventBuf[eventLen++] = c;
+                } else {
+                    eventOverflow = true;
+                }
+                if (c == '"' && eventLen >= 9 &&
+                    memcmp(eventBuf + eventLen - 9, "\"delta\":\"", 9) == 0) {
+                    char type[48];
+                    eventType(eventBuf, eventLen, type, sizeof(type));
+                    if (isAudioDelta(type)) {
+                        rxMode = RX_AUDIO;
+                    }
+                }
+            } else if (rxMode == RX_AUDIO) {
+                // Stream base64 straight to the speaker up to the closing quote
+                const char* end = (const char*)memchr(p + i, '"', len - i);
+                size_t n = end ? (size_t)(end - (p + i)) : len - i;
+                playBase64(p + i, n);
+                i += n;
+                if (end) {
+                    rxMode = RX_TAIL;
+                    i++;
+                }
+            } else {
+                i = len;   // Ignore the rest of an audio delta
+            }
+        }
+
+        if (last && rxMode == RX_HEAD) {
+            eventBuf[eventLen] = '\0';
+            char type[48];
+            eventType(eventBuf, eventLen, type, sizeof(type));
+            handleEvent(type);
+        }
+    }
+
+    void onClose(uint16_t code) override {
+        halLog("Realtime: Session closed (%u)\n", code);
+        if (playing) {
+            responseFailed = true;
+        }
+    }
+};
+
+#endif // VOLT_REALTIME_H
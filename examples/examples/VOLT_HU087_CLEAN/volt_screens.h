@@ -0,0 +1,210 @@
+/*
+ * ============================================
+ * VOLT Screens - What Each Screen Shows
+ * ============================================
+ *
+ * Handles:
+ * - Boot splash and welcome
+ * - Idle (online / offline, battery icons),
+ *   status text, great job, need WiFi, WiFi
+ *   setup
+ * - Pages: a reply, a joke, Dad's message. The
+ *   screen declares the heading and hands back
+ *   the band below it, where the text is laid
+ *   out and scrolled along with speech
+ *   (text_scroller.h)
+ * - Breathing: a circle that grows over the
+ *   breath in, stays for the hold and shrinks
+ *   over the breath out, one frame at a time
+ *
+ * Each screen declares its widgets on a
+ * UiScene (ui_scene.h); the caller flushes, and
+ * only what differs from the last screen is
+ * sent. Screens that share a background keep
+ * their text in the same slots where they can,
+ * so a status change repaints a line, not the
+ * screen.
+ *
+ * Titles and headings are in packed fonts,
+ * icons packed images (ui_assets_data.h, from
+ * assets/); everything else is the built-in
+ * font.
+ *
+ * Layout only, no hardware access: the host
+ * bench composes the same screens into a
+ * framebuffer.
+ *
+ * ============================================
+ */
+
+#ifndef VOLT_SCREENS_H
+#define VOLT_SCREENS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "ui_scene.h"
+#include "ui_assets_data.h"
+#include "text_scroller.h"
+#include "app_state.h"
+
+class VoltScreens {
+public:
+    static const int16_t BREATH_X = 86;      // Circle center
+    static const int16_t BREATH_Y = 160;
+    static const int16_t BREATH_MIN_R = 24;
+    static const int16_t BREATH_MAX_R = 72;
+    static const int16_t PAGE_TOP = 44;      // Below a page's heading
+    static const int16_t LOVE_TOP = 120;     // Below the heart and two lines
+
+private:
+    UiScene& ui;
+
+    // 0..1024 over 0..total, slow at both ends
+    static int32_t ease(uint32_t elapsed, uint32_t total) {
+        if (total == 0 || elapsed >= total) return 1024;
+        int64_t p = (int64_t)elapsed * 1024 / total;
+        return (int32_t)(p * p * (3 * 1024 - 2 * p) >> 20);
+    }
+
+    // Pen x that centers s on the screen
+    int16_t centered(const UiFont& font, const char* s) const {
+        return (int16_t)((ui.getWidth() - uiTextWidth(font, s, (int)strlen(s))) / 2);
+    }
+
+public:
+    explicit VoltScreens(UiScene& scene) : ui(scene) {}
+
+    static const UiImage& batteryIcon(int battery) {
+        if (battery >= 60) return ICON_BATTERY_FULL;
+        return battery >= 20 ? ICON_BATTERY_HALF : ICON_BATTERY_LOW;
+    }
+
+    static uint16_t toneColor(int tone) {
+        switch (tone) {
+            case TONE_INFO: return UI_CYAN;
+            case TONE_GOOD: return UI_GREEN;
+            case TONE_WARN: return UI_YELLOW;
+            case TONE_ERROR: return UI_RED;
+            case TONE_FUN: return UI_MAGENTA;
+            default: return UI_WHITE;
+        }
+    }
+
+    void splash() {
+        ui.compose(UI_BLACK);
+        ui.text(centered(FONT_TITLE, "VOLT"), 40, FONT_TITLE, UI_WHITE, "VOLT");
+        ui.text(10, 100, 1, UI_WHITE, "for Stone");
+        ui.text(10, 120, 1, UI_WHITE, "Starting...");
+    }
+
+    void welcome() {
+        ui.compose(UI_BLACK);
+        ui.text(10, 56, FONT_HEADING, UI_CYAN, "Hi Stone!");
+        ui.text(10, 90, 1, UI_WHITE, "Press button to talk");
+        ui.text(10, 110, 1, UI_WHITE, "Hold for Dad's message");
+    }
+
+    void idle(bool online, int battery) {
+        char line[24];
+        snprintf(line, sizeof(line), "Battery: %d%%", battery);
+
+        ui.compose(UI_BLACK);
+        ui.image(10, 10, online ? ICON_WIFI : ICON_WIFI_OFF);
+        ui.image(136, 11, batteryIcon(battery));
+        ui.text(centered(FONT_TITLE, "VOLT"), 40, FONT_TITLE, UI_CYAN, "VOLT");
+        ui.text(10, 110, 1, online ? UI_GREEN : UI_YELLOW, online ? "Ready to talk!" : "Offline mode");
+        ui.text(10, 125, 1, UI_WHITE, online ? "" : "(Jokes & breathing work)");
+        ui.text(10, 150, 1, battery < 20 ? UI_RED : UI_WHITE, line);
+        ui.text(10, 180, 1, UI_CYAN, "Press button to start");
+        ui.text(10, 200, 1, UI_GRAY, "1=Talk 2=Joke 3=Breathe");
+        ui.text(10, 215, 1, UI_GRAY, "Hold=Love 5=WiFi");
+    }
+
+    // One status line ("Listening...", errors)
+    void status(const char* message, uint16_t color) {
+        ui.compose(UI_BLACK);
+        ui.text(10, 120, 2, color, message);
+    }
+
+    // How a page's text looks on background: big enough to read
+    // along, the line being said in yellow
+    static TextStyle pageStyle(uint16_t background) {
+        return { 2, UI_WHITE, UI_YELLOW, background };
+    }
+
+    // The band a page's text goes in, from top to the bottom
+    UiRect pageBand(int16_t top) const {
+        return { 0, top, ui.getWidth(), (int16_t)(ui.getHeight() - top) };
+    }
+
+    // A reply being said
+    UiRect reply() {
+        ui.compose(UI_BLACK);
+        ui.text(10, 10, FONT_HEADING, UI_CYAN, "VOLT says");
+        return pageBand(PAGE_TOP);
+    }
+
+    UiRect joke() {
+        ui.compose(UI_BLACK);
+        ui.text(10, 10, FONT_HEADING, UI_YELLOW, "Joke Time!");
+        return pageBand(PAGE_TOP);
+    }
+
+    // Circle size elapsedMs into a phase (0 = breathe in, 1 = hold,
+    // 2 = breathe out) that lasts AppStateMachine::breathMs()
+    static int16_t breathRadius(int phase, uint32_t elapsedMs) {
+        int32_t e = ease(elapsedMs, AppStateMachine::breathMs(phase));
+        int32_t span = BREATH_MAX_R - BREATH_MIN_R;
+        if (phase == 0) return (int16_t)(BREATH_MIN_R + span * e / 1024);
+        if (phase == 1) return BREATH_MAX_R;
+        return (int16_t)(BREATH_MAX_R - span * e / 1024);
+    }
+
+    // One frame of a phase; only the circle changes between frames
+    void breathe(int phase, uint32_t elapsedMs) {
+        static const char* const words[] = { "IN", "HOLD", "OUT" };
+        static const uint16_t colors[] = { UI_CYAN, UI_YELLOW, UI_GREEN };
+        if (phase < 0 || phase > 2) phase = 0;
+        int16_t wordX = (int16_t)(BREATH_X - strlen(words[phase]) * UiScene::CHAR_W * 3 / 2);
+        ui.compose(UI_BLACK);
+        ui.text(23, 30, 3, UI_WHITE, "BREATHE");
+        ui.circle(BREATH_X, BREATH_Y, breathRadius(phase, elapsedMs), colors[phase]);
+        ui.text(wordX, 260, 3, colors[phase], words[phase]);
+    }
+
+    void greatJob() {
+        ui.compose(UI_BLACK);
+        ui.image((int16_t)((ui.getWidth() - ICON_STAR.w) / 2), 80, ICON_STAR);
+        ui.text(centered(FONT_HEADING, "Great Job!"), 120, FONT_HEADING, UI_GREEN, "Great Job!");
+    }
+
+    UiRect loveMessage() {
+        ui.compose(UI_PURPLE);
+        ui.image(10, 24, ICON_HEART);
+        ui.text(10, 56, FONT_HEADING, UI_WHITE, "Message");
+        ui.text(10, 86, FONT_HEADING, UI_WHITE, "from Dad");
+        return pageBand(LOVE_TOP);
+    }
+
+    void needWiFi() {
+        ui.compose(UI_BLACK);
+        ui.image(10, 44, ICON_WIFI_OFF);
+        ui.text(10, 72, FONT_HEADING, UI_YELLOW, "Need WiFi!");
+        ui.text(10, 120, 1, UI_CYAN, "Try offline features:");
+        ui.text(10, 140, 1, UI_WHITE, "2 press = Jokes");
+        ui.text(10, 155, 1, UI_WHITE, "3 press = Breathing");
+    }
+
+    void setup() {
+        ui.compose(UI_BLACK);
+        ui.text(10, 40, 1, UI_WHITE, "WiFi Setup Mode");
+        ui.text(10, 60, 1, UI_WHITE, "Connect to:");
+        ui.text(10, 80, 2, UI_CYAN, "VOLT-Setup");
+        ui.text(10, 110, 1, UI_WHITE, "Password: volt2024");
+        ui.text(10, 130, 1, UI_WHITE, "Go to: 192.168.4.1");
+        ui.text(10, 160, 1, UI_YELLOW, "Press button to exit");
+    }
+};
+
+#endif // VOLT_SCREENS_H
@@ -43,60 +43,136 @@
 #include "config_stone_FINAL.h"
 #include "pins_hu087.h"
 #include "volt_ai_FINAL.h"
+#include "volt_realtime.h"
 #include "power_mgmt.h"
 #include "wifi_mgmt.h"
+#include "button_gestures.h"
+#include "device_api.h"
+#include "task_stats.h"
+#include "metrics.h"
+#include "pc_profiler.h"
+#include "app_tasks.h"
+#include "coalesced_timers.h"
+#include "task_supervisor.h"
+#include "ui_scene.h"
+#include "volt_screens.h"
+#include "ui_sprites.h"
+#include "text_scroller.h"
+#include "speech_text.h"
+#include "boot_sequencer.h"
+
+// The screens are laid out for the HU-087's panel; the engine runs
+// on any board in board_traits.h
+static_assert(Board::Display::KIND == BOARD_DISPLAY_ST7789 && Board::Display::WIDTH == 172 &&
+              Board::Display::HEIGHT == 320, "volt_screens.h needs the 172x320 ST7789");
 
 // ============================================
 // GLOBAL OBJECTS
 // ============================================
 
 TFT_eSPI display = TFT_eSPI();
+UiScene ui;                      // What the panel shows; flushes send only changes
+TftUiDisplay uiDisplay(display);
+VoltScreens screens(ui);
+UiSpriteRenderer sprites;        // Off-screen tiles over DMA, once the pools are set
+TftUiPanel uiPanel(display);
+TextScroller scroller;           // A page's text, scrolled by the panel along with speech
 VoltAI bot;
+VoltRealtime realtime;
 PowerManager power;
 WiFiManager wifiMgr;
+DeviceApi deviceApi;
+AppTasks appTasks;
+
+// ============================================
+// TASKS (app_tasks.h)
+// ============================================
+
+// ui (core 0): button, screen and the app state machine
+// audio (core 1): recording and speech
+// net (core 0): transcription, chat, reconnects
+// loop() keeps only the housekeeping below.
+
+// Each task beats with its own deadline; loop() feeds the watchdog
+// only while none is past it
+TaskSupervisor supervisor;
+
+// ============================================
+// HOUSEKEEPING (coalesced_timers.h)
+// ============================================
+
+// Each job may run up to its slack late, so loop() wakes once for
+// several of them and sleeps in between. The longest sleep (sample
+// period + slack) stays inside the 8 s watchdog.
+CoalescedTimers housekeeping;
+static const uint32_t LOOP_MAX_WAIT_MS = 7000;
 
 // ============================================
-// STATE MANAGEMENT
+// METRICS (GET /api/metrics, metrics.h)
 // ============================================
 
-// Button state
-unsigned long lastButtonPress = 0;
-unsigned long buttonPressStartTime = 0;
-int buttonPresses = 0;
-bool buttonCurrentlyPressed = false;
-
-const int DEBOUNCE_TIME = 250;
-const int MULTI_PRESS_TIMEOUT = 600;
-const unsigned long LONG_PRESS_TIME = 2000;  // 2 seconds for love message
-
-// App state
-enum State {
-    IDLE,
-    LISTENING,
-    THINKING,
-    SPEAKING
-};
-State currentState = IDLE;
-
-// WiFi reconnection
-unsigned long lastWiFiCheck = 0;
-const unsigned long WIFI_CHECK_INTERVAL = 30000;  // 30 seconds
+// Turns run on their own tasks; loop() is housekeeping only
+static const uint32_t LOOP_MS_BUCKETS[] = { 1, 2, 5, 10, 25, 50, 100, 250, 1000, 5000, 30000 };
+
+MetricHistogram loopLatency("volt_loop_latency_ms", "Time one pass of loop() took (housekeeping)",
+                            LOOP_MS_BUCKETS, sizeof(LOOP_MS_BUCKETS) / sizeof(LOOP_MS_BUCKETS[0]));
+MetricCounter wifiReconnects("volt_wifi_reconnects_total", "WiFi reconnect attempts", "result=\"ok\"");
+MetricCounter wifiReconnectFailures("volt_wifi_reconnects_total", "WiFi reconnect attempts",
+                                    "result=\"failed\"");
+MetricCounter housekeepingWakeups("volt_housekeeping_wakeups_total",
+                                  "Times loop() woke because a housekeeping job ran out of slack");
+MetricCounter uiPixels("volt_ui_pixels_total", "Pixels repainted (dirty regions only)");
+MetricGauge batteryLevel("volt_battery_percent", "Battery charge at the last check");
+MetricGauge uptime("volt_uptime_seconds", "Seconds since boot", nullptr,
+                   []() { return (int32_t)(halMillis() / 1000); });
+MetricGauge heapFree("volt_heap_free_bytes", "Free internal heap", nullptr,
+                     []() { return (int32_t)halHeapInfo(HAL_HEAP_INTERNAL).freeBytes; });
+MetricGauge heapLargest("volt_heap_largest_free_bytes", "Largest free internal block", nullptr,
+                        []() { return (int32_t)halHeapInfo(HAL_HEAP_INTERNAL).largestFree; });
 
 // ============================================
 // FUNCTION PROTOTYPES
 // ============================================
 
-void handleButtonPresses(int count);
+void onAppState(AppStateId state, void* ctx);
+void onButton(Gesture gesture, void* ctx);
+void drawCommand(const AppCommand& cmd, void* ctx);
+void runAudioCommand(const AppCommand& cmd, AppEvent& result, void* ctx);
+void runNetCommand(const AppCommand& cmd, AppEvent& result, void* ctx);
+void startAppTasks();
+void flushScreen();
+void startSprites();
+bool drawFrame(unsigned long now, void* ctx);
+bool drawBreathFrame(unsigned long now);
+bool followSpeech(unsigned long now);
+void showPage(const UiRect& band, const TextStyle& style, const char* text);
 void showIdleScreen();
-void talkToVolt();
-void tellJoke();
-void breathingExercise();
-void playLoveMessage();
-void wifiSetup();
+void showJoke(const char* joke);
+void showReply(const char* reply);
+void showBreathe(int phase);
+void showGreatJob();
+void showLoveMessage();
+void showNeedWiFi();
+void showSetupScreen();
 void updateDisplay(const char* message, uint16_t color = TFT_WHITE);
 void setBacklight(bool on);
 void checkWiFiConnection();
 void checkBattery();
+void checkSerialCommands();
+void registerMetrics();
+void startHousekeeping();
+void printHousekeeping();
+void onTaskStall(const TaskSupervisor::Stall& stall, void* ctx);
+BootState bootDisplay(void* ctx);
+BootState bootSplash(void* ctx);
+BootState bootPower(void* ctx);
+BootState bootWifiStart(void* ctx);
+BootState bootWifiPoll(void* ctx);
+BootState bootApi(void* ctx);
+BootState bootAi(void* ctx);
+BootState bootRealtime(void* ctx);
+BootState bootEngine(void* ctx);
+BootState bootGreeting(void* ctx);
 
 // ============================================
 // SETUP
@@ -104,7 +180,8 @@ void checkBattery();
 
 void setup() {
     Serial.begin(115200);
-    delay(1000);
+    BootSequencer& boot = bootSequencer();
+    boot.begin(halWakeCause());
     Serial.println("\n\n=== VOLT for Stone - Starting ===");
     Serial.println("Version: FINAL (Production Ready)");
     
@@ -113,520 +190,581 @@ void setup() {
     esp_task_wdt_add(NULL);
     Serial.println("Watchdog: Enabled (8s timeout)");
     
-    // 1. Hardware initialization
+    // Hardware initialization
     pinMode(BTN_BOOT, INPUT_PULLUP);
-    pinMode(LED_BUILTIN, OUTPUT);
-    digitalWrite(LED_BUILTIN, LOW);
+    halLed(false);
+    
+    // The rest as boot phases (boot_sequencer.h), started in this
+    // order once their `after` phases are done: WiFi associates
+    // while the display and the AI come up. A button wake skips the
+    // splash and the greeting, and the app starts without waiting
+    // for WiFi. WiFi is added before the API so the network stack
+    // is up when the API opens its socket.
+    int display = boot.add("display", bootDisplay, nullptr, nullptr, 0, BOOT_BEFORE_READY);
+    boot.add("splash", bootSplash, nullptr, nullptr, BootSequencer::bit(display),
+             BOOT_COLD_ONLY | BOOT_IF_OK);
+    boot.add("power", bootPower, nullptr, nullptr, 0, BOOT_BEFORE_READY);
+    int wifi = boot.add("wifi", bootWifiStart, bootWifiPoll, nullptr, 0, 0, WIFI_TIMEOUT * 1000UL);
+    boot.add("api", bootApi, nullptr, nullptr);
+    int ai = boot.add("ai", bootAi, nullptr, nullptr, 0, BOOT_BEFORE_READY);
+    int rt = -1;
+    if (USE_REALTIME_MODE) {
+        rt = boot.add("realtime", bootRealtime, nullptr, nullptr, 0, BOOT_BEFORE_READY);
+    }
+    boot.add("engine", bootEngine, nullptr, nullptr, BootSequencer::bit(ai) | BootSequencer::bit(rt),
+             BOOT_BEFORE_READY);
+    boot.add("greeting", bootGreeting, nullptr, nullptr,
+             BootSequencer::bit(display) | BootSequencer::bit(wifi) | BootSequencer::bit(ai),
+             BOOT_COLD_ONLY | BOOT_BEFORE_READY);
+    boot.runUntilReady([](void*) { esp_task_wdt_reset(); });
     
-    // Initialize backlight control
+    showIdleScreen();
+    startHousekeeping();
+    startAppTasks();
+    
+    Serial.printf("=== VOLT Ready for Stone (%lu ms) ===\n\n", (unsigned long)(boot.getReadyUs() / 1000));
+}
+
+// ============================================
+// BOOT PHASES (boot_sequencer.h)
+// ============================================
+
+BootState bootDisplay(void* ctx) {
     pinMode(LCD_BL, OUTPUT);
     setBacklight(true);
-    
-    // 2. Display initialization
     display.init();
     display.setRotation(0);
-    display.fillScreen(TFT_BLACK);
-    display.setTextColor(TFT_WHITE, TFT_BLACK);
-    display.setTextSize(2);
-    display.setCursor(10, 60);
-    display.println("VOLT");
-    display.setTextSize(1);
-    display.setCursor(10, 90);
-    display.println("for Stone");
-    display.setCursor(10, 110);
-    display.println("Starting...");
-    delay(1000);
-    
-    // 3. Power management
+    ui.begin(Board::Display::WIDTH, Board::Display::HEIGHT);
+    return BOOT_OK;
+}
+
+// Cold boot only; stays up while the other phases run
+BootState bootSplash(void* ctx) {
+    screens.splash();
+    flushScreen();
+    return BOOT_OK;
+}
+
+BootState bootPower(void* ctx) {
     power.begin();
     Serial.println("Power: Initialized");
-    
-    // 4. WiFi connection
-    updateDisplay("Connecting WiFi...");
-    if (wifiMgr.connect(WIFI_SSID, WIFI_PASSWORD, WIFI_TIMEOUT)) {
-        Serial.println("WiFi: Connected");
-        Serial.println("WiFi: IP = " + wifiMgr.getIP());
-        updateDisplay("WiFi Connected!", TFT_GREEN);
-    } else {
-        Serial.println("WiFi: Failed (will work offline)");
-        updateDisplay("WiFi Failed", TFT_YELLOW);
+    return BOOT_OK;
+}
+
+// Associates in the background; polled until connected or
+// WIFI_TIMEOUT, after which the wifi job keeps trying
+BootState bootWifiStart(void* ctx) {
+    if (strlen(WIFI_SSID) == 0) {
+        Serial.println("WiFi: No network set (will work offline)");
+        return BOOT_FAILED;
     }
-    delay(1500);
-    
-    // 5. AI initialization
-    updateDisplay("Starting AI...");
-    if (bot.begin(OPENAI_API_KEY, STONE_PERSONALITY)) {
-        Serial.println("AI: Ready");
-        updateDisplay("AI Ready!", TFT_GREEN);
-    } else {
+    wifiMgr.startConnect(WIFI_SSID, WIFI_PASSWORD);
+    return BOOT_RUNNING;
+}
+
+BootState bootWifiPoll(void* ctx) {
+    if (WiFi.status() != WL_CONNECTED) {
+        return BOOT_RUNNING;
+    }
+    wifiMgr.connected();
+    // Connected after the app started: the net task's check tells
+    // the state machine it is online
+    if (bootSequencer().isReady()) {
+        appTasks.requestNetCheck();
+    }
+    return BOOT_OK;
+}
+
+// Local API (/api/status, /api/boot, ...) on its own task
+BootState bootApi(void* ctx) {
+    if (!deviceApi.begin()) {
+        return BOOT_FAILED;
+    }
+    deviceApi.startTask();
+    return BOOT_OK;
+}
+
+BootState bootAi(void* ctx) {
+    if (!bot.begin(OPENAI_API_KEY, STONE_PERSONALITY)) {
         Serial.println("AI: Failed (check API key)");
-        updateDisplay("AI Failed", TFT_RED);
+        return BOOT_FAILED;
     }
-    delay(1500);
-    
-    // 6. Welcome message
-    display.fillScreen(TFT_BLACK);
-    display.setTextSize(2);
-    display.setCursor(10, 60);
-    display.setTextColor(TFT_CYAN);
-    display.println("Hi Stone!");
-    display.setTextSize(1);
-    display.setCursor(10, 90);
-    display.setTextColor(TFT_WHITE);
-    display.println("Press button to talk");
-    display.setCursor(10, 110);
-    display.println("Hold for Dad's message");
-    
+    Serial.println("AI: Ready");
+    return BOOT_OK;
+}
+
+BootState bootRealtime(void* ctx) {
+    return realtime.begin(OPENAI_API_KEY, STONE_PERSONALITY) ? BOOT_OK : BOOT_FAILED;
+}
+
+// After the AI, working or not
+BootState bootEngine(void* ctx) {
+    startSprites();           // After the AI's buffers are placed
+    HEAP_PROFILE_BASELINE();  // What boot holds is not a leak
+    taskStats().setInterval(TASK_STATS_INTERVAL);
+    appTasks.superviseWith(supervisor);
+    appTasks.setFrameHook(drawFrame);
+    supervisor.setStallHook(onTaskStall, nullptr);
+    registerMetrics();
+    return BOOT_OK;
+}
+
+// Cold boot only, once WiFi has connected or given up
+BootState bootGreeting(void* ctx) {
+    screens.welcome();
+    flushScreen();
     if (WiFi.status() == WL_CONNECTED) {
         bot.speak("Hi Stone! I'm ready to help you!");
     }
-    
-    delay(2000);
-    showIdleScreen();
-    
-    Serial.println("=== VOLT Ready for Stone ===\n");
+    return BOOT_OK;
 }
 
 // ============================================
 // MAIN LOOP
 // ============================================
 
+// Housekeeping only: the button, screen and turns are on the
+// app tasks (startAppTasks)
 void loop() {
-    // Reset watchdog
-    esp_task_wdt_reset();
+    unsigned long loopStart = halMillis();
+    
+    // Feed the watchdog while every task is within its deadline; a
+    // stalled one is reported (onTaskStall), then the watch resets
+    if (supervisor.check(loopStart) == 0) {
+        esp_task_wdt_reset();
+    }
     power.keepAlive();
     
-    // Check battery status
-    checkBattery();
+    // Due jobs (startHousekeeping), then the serial console
+    uint32_t wakeups = housekeeping.getWakeups();
+    housekeeping.run(loopStart);
+    housekeepingWakeups.inc(housekeeping.getWakeups() - wakeups);
+    checkSerialCommands();
     
-    // Check WiFi connection periodically
-    checkWiFiConnection();
+    // Boot phases still running after the app started (WiFi)
+    BootSequencer& boot = bootSequencer();
+    if (!boot.isDone()) {
+        boot.step();
+    }
     
-    // Check for sleep timeout
-    if (ENABLE_DEEP_SLEEP && power.shouldSleep()) {
+    // Sleep until a job has used up its slack; a console line waits
+    // for that wakeup too
+    loopLatency.observe((uint32_t)(halMillis() - loopStart));
+    uint32_t wait = housekeeping.waitMs(halMillis());
+    uint32_t maxWait = boot.isDone() ? LOOP_MAX_WAIT_MS : BootSequencer::POLL_MS;
+    delay(wait < maxWait ? wait : maxWait);
+}
+
+// ============================================
+// HOUSEKEEPING JOBS
+// ============================================
+
+void batteryJob(unsigned long now, void* ctx) {
+    checkBattery();
+}
+
+// Queued to net, so it never runs mid-request
+void wifiJob(unsigned long now, void* ctx) {
+    appTasks.requestNetCheck();
+}
+
+void samplesJob(unsigned long now, void* ctx) {
+    taskStats().tick(now);
+    pcProfiler().tick();
+}
+
+void heapJob(unsigned long now, void* ctx) {
+    HEAP_PROFILE_TICK(now);
+}
+
+// Sleep timeout, never mid-activity
+void sleepJob(unsigned long now, void* ctx) {
+    if (appTasks.getState() == APP_IDLE && power.shouldSleep()) {
         Serial.println("Loop: Entering sleep mode");
         setBacklight(false);
         power.enterDeepSleep();
     }
+}
+
+// Period and slack (ms) per job. Samples and the sleep check share
+// a 5 s beat; the rest ride along with it.
+void startHousekeeping() {
+    unsigned long now = halMillis();
+    housekeeping.begin(now);
+    housekeeping.add("samples", TASK_STATS_INTERVAL ? TASK_STATS_INTERVAL : 5000, 2000, samplesJob,
+                     nullptr, now);
+    if (ENABLE_DEEP_SLEEP) {
+        housekeeping.add("sleep", 5000, 2000, sleepJob, nullptr, now);
+    }
+    if (VOLT_HEAP_PROFILE) {
+        housekeeping.add("heap", 10000, 5000, heapJob, nullptr, now);
+    }
+    housekeeping.add("wifi", 30000, 10000, wifiJob, nullptr, now);
+    housekeeping.add("battery", 60000, 15000, batteryJob, nullptr, now);
+    appTasks.setNetCheckMs(0);  // The wifi job asks for it
+}
+
+// loop(), once per stall, before the watchdog resets the watch: what
+// the app was doing and the last task sample
+void onTaskStall(const TaskSupervisor::Stall& stall, void* ctx) {
+    Serial.printf("Supervisor: App %s, heap %u free\n", AppStateMachine::stateName(appTasks.getState()),
+                  (unsigned)halHeapInfo(HAL_HEAP_INTERNAL).freeBytes);
+    supervisor.printReport(Serial, halMillis());
+    taskStats().printReport(Serial);
+}
+
+void printHousekeeping() {
+    unsigned long now = halMillis();
+    Serial.printf("Housekeeping: %u wakeups (%u/h), %u runs\n", (unsigned)housekeeping.getWakeups(),
+                  (unsigned)housekeeping.wakeupsPerHour(now), (unsigned)housekeeping.getRuns());
+    for (int i = 0; i < housekeeping.getJobCount(); i++) {
+        const CoalescedTimers::Job& j = housekeeping.getJob(i);
+        Serial.printf("  %-8s every %5u ms +%5u  %6u runs, worst %u ms late\n", j.name,
+                      (unsigned)j.periodMs, (unsigned)j.slackMs, (unsigned)j.runs,
+                      (unsigned)j.maxLateMs);
+    }
+}
+
+// ============================================
+// APP TASKS
+// ============================================
+
+void startAppTasks() {
+    uint8_t features = 0;
+    if (ENABLE_VOICE_CHAT) features |= FEATURE_VOICE;
+    if (ENABLE_JOKES) features |= FEATURE_JOKES;
+    if (ENABLE_BREATHING_EXERCISES) features |= FEATURE_BREATHING;
+    if (ENABLE_LOVE_MESSAGES) features |= FEATURE_LOVE;
+    if (ENABLE_WIFI_SETUP) features |= FEATURE_WIFI_SETUP;
+    if (ENABLE_SOS_HOLD) features |= FEATURE_SOS;
+    AppConfig config = { features, RECORD_TIME_SEC * 1000UL, LOVE_MESSAGE };
+    AppTasks::Hooks hooks = { drawCommand, runAudioCommand, runNetCommand, onAppState, onButton, nullptr };
+    
+    bool online = WiFi.status() == WL_CONNECTED;
+    if (!appTasks.begin(config, hooks, BTN_BOOT, online)) {
+        Serial.println("Tasks: No memory for the queues");
+        return;
+    }
+    appTasks.watchQueues(taskStats());
+    appTasks.post({ EV_NET_STATUS, online, USE_REALTIME_MODE && realtime.isReady(), nullptr });
+    onAppState(APP_IDLE, nullptr);
     
-    // Button handling
-    bool buttonPressed = (digitalRead(BTN_BOOT) == LOW);
-    
-    // Detect button press start
-    if (buttonPressed && !buttonCurrentlyPressed) {
-        buttonPressStartTime = millis();
-        buttonCurrentlyPressed = true;
-        power.resetIdleTimer();
+    if (appTasks.start()) {
+        Serial.println("Tasks: ui + net on core 0, audio on core 1");
+    } else {
+        Serial.println("Tasks: Could not start");
+    }
+}
+
+// What GET /api/status reports, pushed to /api/events
+void onAppState(AppStateId state, void* ctx) {
+    deviceApi.getStatus().state = AppStateMachine::stateName(state);
+    deviceApi.publishStatus();
+    if (state == APP_IDLE) {
+        power.resetIdleTimer();  // Sleep counts from the end of an activity
     }
+}
+
+// ui task, before the state machine sees the event
+void onButton(Gesture gesture, void* ctx) {
+    bool idle = appTasks.getState() == APP_IDLE;  // Don't blink over "listening"
     
-    // Detect long press (for love message)
-    if (buttonPressed && buttonCurrentlyPressed) {
-        unsigned long pressDuration = millis() - buttonPressStartTime;
-        if (pressDuration >= LONG_PRESS_TIME && buttonPresses == 0) {
-            // Long press detected - play love message
-            Serial.println("Button: Long press detected");
-            digitalWrite(LED_BUILTIN, HIGH);
-            delay(100);
-            digitalWrite(LED_BUILTIN, LOW);
+    switch (gesture) {
+        case GESTURE_DOWN:
+            power.resetIdleTimer();
+            break;
             
-            if (ENABLE_LOVE_MESSAGES) {
-                playLoveMessage();
+        case GESTURE_LONG_PRESS:
+            Serial.println("Button: Long press detected");
+            if (idle) {
+                halLed(true);
+                delay(100);
+                halLed(false);
             }
-            showIdleScreen();
-            
-            buttonCurrentlyPressed = false;
-            buttonPresses = 0;
+            break;
             
-            // Wait for button release
-            while (digitalRead(BTN_BOOT) == LOW) {
-                esp_task_wdt_reset();
-                delay(10);
-            }
-            return;
-        }
-    }
-    
-    // Detect button release (for counting presses)
-    if (!buttonPressed && buttonCurrentlyPressed) {
-        buttonCurrentlyPressed = false;
-        
-        unsigned long now = millis();
-        if (now - lastButtonPress > DEBOUNCE_TIME) {
-            buttonPresses++;
-            lastButtonPress = now;
+        case GESTURE_SOS:
+            Serial.println("Button: SOS hold");
+            break;
             
+        case GESTURE_CLICK:
             // Visual feedback
-            digitalWrite(LED_BUILTIN, HIGH);
-            delay(50);
-            digitalWrite(LED_BUILTIN, LOW);
+            if (idle) {
+                halLed(true);
+                delay(50);
+                halLed(false);
+            }
+            Serial.println("Button: Press detected");
+            break;
             
-            Serial.printf("Button: Press detected (count=%d)\n", buttonPresses);
-        }
+        default:
+            break;
     }
-    
-    // Execute action after button release timeout
-    if (buttonPresses > 0 && !buttonCurrentlyPressed && 
-        (millis() - lastButtonPress > MULTI_PRESS_TIMEOUT)) {
-        handleButtonPresses(buttonPresses);
-        buttonPresses = 0;
+}
+
+// ui task: the only one that draws once the tasks run
+void drawCommand(const AppCommand& cmd, void* ctx) {
+    if (cmd.type != CMD_SHOW_BREATHE && cmd.type != CMD_LED) {
+        appTasks.stopFrames();               // Breathing animates; pages start their own
+    }
+    switch (cmd.type) {
+        case CMD_SHOW_IDLE: showIdleScreen(); break;
+        case CMD_SHOW_TEXT: updateDisplay(cmd.text, VoltScreens::toneColor(cmd.a)); break;
+        case CMD_SHOW_JOKE: showJoke(cmd.text); break;
+        case CMD_SHOW_REPLY: showReply(cmd.text); break;
+        case CMD_SHOW_BREATHE: showBreathe(cmd.a); break;
+        case CMD_SHOW_GREAT_JOB: showGreatJob(); break;
+        case CMD_SHOW_LOVE: showLoveMessage(); break;
+        case CMD_SHOW_NEED_WIFI: showNeedWiFi(); break;
+        case CMD_SHOW_SETUP: showSetupScreen(); break;
+        case CMD_LED: halLed(cmd.a != 0); break;
     }
-    
-    delay(10);
 }
 
-// ============================================
-// BUTTON ACTIONS
-// ============================================
+// audio task (core 1). One command at a time, and never while the
+// net task has the engine.
+void runAudioCommand(const AppCommand& cmd, AppEvent& result, void* ctx) {
+    switch (cmd.type) {
+        case CMD_RECORD:
+            TRACE_TURN();  // Spans from here on belong to this turn
+            Serial.println("Feature: Voice chat starting");
+            bot.recordAudio();
+            break;
+            
+        case CMD_SPEAK:
+            bot.speak(cmd.text);
+            break;
+            
+        // Same turn over the Realtime API: mic audio is sent while
+        // recording and the reply plays as soon as it starts arriving
+        case CMD_STREAM_MIC:
+            result.a = realtime.streamMicrophone(cmd.a) && realtime.requestResponse();
+            break;
+            
+        case CMD_PLAY_RESPONSE:
+            result.a = realtime.playResponse();
+            if (result.a) {
+                Serial.printf("Feature: Realtime chat complete (first audio %lu ms)\n",
+                    realtime.getFirstAudioLatency());
+            }
+            break;
+    }
+}
 
-void handleButtonPresses(int count) {
-    Serial.printf("Button: Executing action for %d presses\n", count);
-    
-    switch(count) {
-        case 1:
-            // Talk to VOLT
-            if (ENABLE_VOICE_CHAT) {
-                talkToVolt();
+// net task (core 0). Text returned by the bot stays valid until
+// CMD_END_TURN (bot.endTurn()).
+void runNetCommand(const AppCommand& cmd, AppEvent& result, void* ctx) {
+    switch (cmd.type) {
+        case CMD_TRANSCRIBE:
+            result.text = bot.transcribe();
+            if (result.text[0] != '\0') {
+                Serial.printf("User said: %s\n", result.text);
             }
             break;
             
-        case 2:
-            // Tell a joke
-            if (ENABLE_JOKES) {
-                tellJoke();
+        case CMD_CHAT:
+            result.text = bot.chat(cmd.text);
+            if (result.text[0] != '\0') {
+                Serial.printf("VOLT says: %s\n", result.text);
             }
             break;
             
-        case 3:
-            // Breathing exercise
-            if (ENABLE_BREATHING_EXERCISES) {
-                breathingExercise();
-            }
+        case CMD_END_TURN:
+            bot.endTurn();
             break;
             
-        case 5:
-            // WiFi setup
-            if (ENABLE_WIFI_SETUP) {
-                wifiSetup();
-            }
+        case CMD_START_AP:
+            // Open until a press or 5 minutes, then a restart applies
+            // the new settings
+            result.a = wifiMgr.startAP("VOLT-Setup", "volt2024");
             break;
             
-        default:
-            // Unknown pattern
-            Serial.printf("Button: Unknown pattern (%d presses)\n", count);
-            updateDisplay("Unknown pattern", TFT_YELLOW);
-            delay(1000);
+        case CMD_RESTART:
+            ESP.restart();
+            break;
+            
+        case CMD_CHECK_NET:
+            checkWiFiConnection();
+            result.a = WiFi.status() == WL_CONNECTED;
+            result.b = USE_REALTIME_MODE && realtime.isReady();
+            break;
+            
+        case CMD_SOS:
+            // No GPS on this watch; the dashboard gets battery only
+            deviceApi.publishSos(0, 0, false, power.getBatteryPercent());
             break;
     }
-    
-    showIdleScreen();
 }
 
 // ============================================
-// FEATURE IMPLEMENTATIONS
+// SCREENS
 // ============================================
 
-void talkToVolt() {
-    Serial.println("Feature: Voice chat starting");
-    
-    if (WiFi.status() != WL_CONNECTED) {
-        updateDisplay("Need WiFi!", TFT_YELLOW);
-        delay(2000);
-        updateDisplay("Try offline features:", TFT_CYAN);
-        delay(1000);
-        updateDisplay("2 press = Jokes", TFT_WHITE);
-        delay(1000);
-        updateDisplay("3 press = Breathing", TFT_WHITE);
-        delay(2000);
-        return;
-    }
-    
-    // 1. Listen
-    currentState = LISTENING;
-    updateDisplay("Listening...", TFT_CYAN);
-    digitalWrite(LED_BUILTIN, HIGH);
-    
-    bot.recordAudio();
-    
-    digitalWrite(LED_BUILTIN, LOW);
-    
-    // 2. Transcribe
-    currentState = THINKING;
-    updateDisplay("Thinking...", TFT_YELLOW);
-    
-    String userText = bot.transcribe();
-    
-    if (userText.length() == 0) {
-        updateDisplay("Didn't hear you", TFT_RED);
-        delay(2000);
-        currentState = IDLE;
-        Serial.println("Feature: No audio detected");
-        return;
-    }
-    
-    Serial.println("User said: " + userText);
-    
-    // 3. Get AI response
-    String response = bot.chat(userText);
-    
-    if (response.length() == 0) {
-        updateDisplay("AI Error", TFT_RED);
-        delay(2000);
-        currentState = IDLE;
-        Serial.println("Feature: AI response failed");
+// Each screen is laid out in volt_screens.h; flushScreen() sends
+// only what changed since the last one (ui_scene.h), drawn
+// off-screen and sent over DMA once the sprites are up
+// (ui_sprites.h)
+
+static const uint32_t SPRITE_PX = Board::Display::WIDTH * 40;    // 40 rows: two of 13760 bytes
+
+int breathPhase = 0;
+unsigned long breathStart = 0;
+
+void startSprites() {
+    if (!sprites.begin(memPools(), SPRITE_PX, tftGlyph, true)) {
+        Serial.println("UI: No room for sprites, drawing directly");
         return;
     }
-    
-    Serial.println("VOLT says: " + response);
-    
-    // 4. Speak response
-    currentState = SPEAKING;
-    updateDisplay("Speaking...", TFT_GREEN);
-    
-    bot.speak(response);
-    
-    currentState = IDLE;
-    Serial.println("Feature: Voice chat complete");
+    bool dma = uiPanel.useDma(sprites.isDmaCapable());
+    Serial.printf("UI: Sprites in %s, %s\n", MemPools::capsName(sprites.getPlacedCaps()),
+                  dma ? "sent over DMA" : "blocking pushes");
 }
 
-void tellJoke() {
-    Serial.println("Feature: Joke time");
-    updateDisplay("Joke Time!", TFT_MAGENTA);
-    delay(1000);
-    
-    String joke = "";
-    
-    if (WiFi.status() == WL_CONNECTED) {
-        Serial.println("Feature: Getting AI joke");
-        String prompt = "Tell a short, funny joke for an 8-year-old boy named Stone. Keep it under 30 words.";
-        joke = bot.chat(prompt);
-    }
-    
-    // Fallback to offline jokes
-    if (joke.length() == 0) {
-        Serial.println("Feature: Using offline joke");
-        const char* offlineJokes[] = {
-            "Why did the scarecrow win an award? Because he was outstanding in his field!",
-            "What do you call a bear with no teeth? A gummy bear!",
-            "Why don't scientists trust atoms? Because they make up everything!",
-            "What did the ocean say to the beach? Nothing, it just waved!",
-            "Why did the bicycle fall over? It was two tired!",
-            "What do you call a dinosaur that crashes his car? Tyrannosaurus Wrecks!",
-            "Why can't you hear a pterodactyl go to the bathroom? Because the P is silent!",
-            "What do you call a sleeping bull? A bulldozer!"
-        };
-        int randomIndex = random(0, 8);
-        joke = offlineJokes[randomIndex];
+void flushScreen() {
+    if (scroller.isRunning()) {
+        scroller.stop(uiDisplay);            // Its rows back where they were, then all repainted
+        ui.invalidate();
     }
-    
-    Serial.println("Joke: " + joke);
-    
-    // Display joke on screen
-    display.fillScreen(TFT_BLACK);
-    display.setTextSize(1);
-    display.setCursor(5, 40);
-    display.setTextColor(TFT_YELLOW);
-    display.println(joke);
-    
-    // Speak joke if WiFi available
-    if (WiFi.status() == WL_CONNECTED) {
-        bot.speak(joke);
+    if (sprites.isReady()) {
+        uiPixels.inc(sprites.flush(ui, uiPanel));
+    } else {
+        uiPixels.inc(ui.flush(uiDisplay));
     }
-    
-    delay(3000);
-    Serial.println("Feature: Joke complete");
 }
 
-void breathingExercise() {
-    Serial.println("Feature: Breathing exercise starting");
-    updateDisplay("Let's Breathe", TFT_CYAN);
-    
-    if (WiFi.status() == WL_CONNECTED) {
-        bot.speak("Let's breathe together, Stone. Follow along.");
+// Pages: the heading through the scene, the text in the band below
+// it, drawn straight to the panel and scrolled by it. Every frame
+// follows what speechText() says is being said; a page without text
+// (Realtime) shows the transcript as it streams in.
+bool pageStreamed = false;
+bool pageFollowing = false;          // Found the speech that goes with it
+uint32_t pageGeneration = 0;
+int pageRead = 0;                    // Transcript taken so far
+
+void showPage(const UiRect& band, const TextStyle& style, const char* text) {
+    flushScreen();
+    pageStreamed = text == nullptr;
+    pageFollowing = false;
+    pageRead = 0;
+    scroller.start(uiDisplay, band, style, text ? text : "");
+    uiPixels.inc(scroller.getPixels());
+    appTasks.startFrames();
+}
+
+void showJoke(const char* joke) {
+    Serial.printf("Joke: %s\n", joke);
+    showPage(screens.joke(), VoltScreens::pageStyle(UI_BLACK), joke);
+}
+
+void showReply(const char* reply) {
+    showPage(screens.reply(), VoltScreens::pageStyle(UI_BLACK), reply);
+}
+
+// 0 = breathe in, 1 = hold, 2 = breathe out. The circle then
+// moves in drawBreathFrame(), also while the line is spoken.
+void showBreathe(int phase) {
+    breathPhase = phase;
+    breathStart = millis();
+    screens.breathe(phase, 0);
+    flushScreen();
+    appTasks.startFrames();
+}
+
+// ui task, every AppTasks::FRAME_MS while a screen animates
+bool drawFrame(unsigned long now, void* ctx) {
+    return scroller.isRunning() ? followSpeech(now) : drawBreathFrame(now);
+}
+
+// Until the phase's time is up
+bool drawBreathFrame(unsigned long now) {
+    uint32_t elapsed = now - breathStart;
+    screens.breathe(breathPhase, elapsed);
+    flushScreen();
+    return elapsed < AppStateMachine::breathMs(breathPhase);
+}
+
+// Until the next screen. The speech for a page is any while it
+// streams, else the one saying its text (speech may start before
+// the page is drawn).
+bool followSpeech(unsigned long now) {
+    SpeechText& said = speechText();
+    if (!pageFollowing) {
+        const TextLayout& page = scroller.getLayout();
+        if (!said.isActive()) return true;
+        if (!pageStreamed && !said.startsLike(page.getText(), page.getLength())) return true;
+        pageFollowing = true;
+        pageGeneration = said.getGeneration();
     }
-    delay(1500);
-    
-    for (int i = 0; i < 3; i++) {
-        Serial.printf("Breathing: Cycle %d/3\n", i + 1);
-        
-        // Breathe in
-        display.fillScreen(TFT_BLUE);
-        display.setTextSize(3);
-        display.setCursor(20, 100);
-        display.setTextColor(TFT_WHITE);
-        display.println("BREATHE");
-        display.setCursor(50, 140);
-        display.println("IN");
-        
-        if (WiFi.status() == WL_CONNECTED) {
-            bot.speak("Breathe in... 1, 2, 3, 4");
+    if (pageStreamed) {
+        char piece[64];
+        int n = said.copy(pageGeneration, pageRead, piece, sizeof(piece));
+        if (n > 0) {
+            pageRead += n;
+            uiPixels.inc(scroller.append(uiDisplay, piece, n));
         }
-        delay(4000);
-        
-        // Hold
-        display.fillScreen(TFT_YELLOW);
-        display.setTextSize(3);
-        display.setCursor(50, 120);
-        display.setTextColor(TFT_BLACK);
-        display.println("HOLD");
-        
-        if (WiFi.status() == WL_CONNECTED) {
-            bot.speak("Hold... 1, 2, 3, 4");
-        }
-        delay(4000);
-        
-        // Breathe out
-        display.fillScreen(TFT_GREEN);
-        display.setTextSize(3);
-        display.setCursor(20, 100);
-        display.setTextColor(TFT_WHITE);
-        display.println("BREATHE");
-        display.setCursor(50, 140);
-        display.println("OUT");
-        
-        if (WiFi.status() == WL_CONNECTED) {
-            bot.speak("Breathe out... 1, 2, 3, 4, 5, 6");
-        }
-        delay(6000);
     }
-    
-    display.fillScreen(TFT_BLACK);
-    display.setTextSize(2);
-    display.setCursor(30, 120);
-    display.setTextColor(TFT_GREEN);
-    display.println("Great Job!");
-    
-    if (WiFi.status() == WL_CONNECTED) {
-        bot.speak("Great job, Stone! You did amazing!");
+    if (said.getGeneration() == pageGeneration) {
+        uiPixels.inc(scroller.follow(uiDisplay, said.spokenAt(now)));
     }
-    delay(2000);
-    
-    Serial.println("Feature: Breathing exercise complete");
+    return true;
 }
 
-void playLoveMessage() {
+void showGreatJob() {
+    screens.greatJob();
+    flushScreen();
+}
+
+void showLoveMessage() {
     Serial.println("Feature: Playing love message");
-    
-    display.fillScreen(TFT_PURPLE);
-    display.setTextSize(2);
-    display.setCursor(10, 60);
-    display.setTextColor(TFT_WHITE);
-    display.println("Message");
-    display.setCursor(10, 90);
-    display.println("from Dad");
-    
-    display.setTextSize(1);
-    display.setCursor(10, 130);
-    display.println(LOVE_MESSAGE);
-    
+    showPage(screens.loveMessage(), VoltScreens::pageStyle(UI_PURPLE), LOVE_MESSAGE);
     Serial.println("Love Message: " + String(LOVE_MESSAGE));
-    
-    if (WiFi.status() == WL_CONNECTED) {
-        bot.speak(LOVE_MESSAGE);
-    }
-    
-    delay(3000);
-    Serial.println("Feature: Love message complete");
 }
 
-void wifiSetup() {
+void showNeedWiFi() {
+    screens.needWiFi();
+    flushScreen();
+}
+
+void showSetupScreen() {
     Serial.println("Feature: WiFi setup mode");
-    updateDisplay("WiFi Setup", TFT_CYAN);
-    
-    if (WiFi.status() == WL_CONNECTED) {
-        bot.speak("Starting WiFi setup mode");
-    }
-    
-    // Show instructions
-    display.fillScreen(TFT_BLACK);
-    display.setTextSize(1);
-    display.setCursor(10, 40);
-    display.println("WiFi Setup Mode");
-    display.setCursor(10, 60);
-    display.println("Connect to:");
-    display.setTextSize(2);
-    display.setCursor(10, 80);
-    display.setTextColor(TFT_CYAN);
-    display.println("VOLT-Setup");
-    display.setTextSize(1);
-    display.setTextColor(TFT_WHITE);
-    display.setCursor(10, 110);
-    display.println("Password: volt2024");
-    display.setCursor(10, 130);
-    display.println("Go to: 192.168.4.1");
-    display.setCursor(10, 160);
-    display.setTextColor(TFT_YELLOW);
-    display.println("Press button to exit");
-    
-    // Start AP mode
-    if (wifiMgr.startAP("VOLT-Setup", "volt2024")) {
-        Serial.println("AP Mode: Started successfully");
-        
-        // Keep AP open for 5 minutes or until button press
-        unsigned long startTime = millis();
-        while (millis() - startTime < 300000) {
-            esp_task_wdt_reset();
-            power.keepAlive();
-            
-            // Exit on button press
-            if (digitalRead(BTN_BOOT) == LOW) {
-                delay(1000);
-                Serial.println("AP Mode: Exiting on button press");
-                break;
-            }
-            
-            delay(100);
-        }
-        
-        updateDisplay("Restarting...", TFT_YELLOW);
-        delay(2000);
-        
-        // Restart to apply new settings
-        ESP.restart();
-    } else {
-        updateDisplay("AP Failed", TFT_RED);
-        Serial.println("AP Mode: Failed to start");
-        delay(2000);
-    }
+    screens.setup();
+    flushScreen();
 }
 
 // ============================================
 // HELPER FUNCTIONS
 // ============================================
 
+// Every AppTasks::NET_CHECK_MS on the net task (CMD_CHECK_NET)
 void checkWiFiConnection() {
-    if (millis() - lastWiFiCheck < WIFI_CHECK_INTERVAL) {
-        return;
-    }
-    
-    lastWiFiCheck = millis();
-    
     if (WiFi.status() != WL_CONNECTED && strlen(WIFI_SSID) > 0) {
         Serial.println("WiFi: Connection lost, attempting reconnect...");
         if (wifiMgr.connect(WIFI_SSID, WIFI_PASSWORD, 10)) {
             Serial.println("WiFi: Reconnected successfully");
+            wifiReconnects.inc();
+        } else {
+            wifiReconnectFailures.inc();
         }
     }
+    deviceApi.getStatus().rssi = WiFi.status() == WL_CONNECTED ? WiFi.RSSI() : 0;
+    deviceApi.publishStatus();
 }
 
+// Every minute (the battery job)
 void checkBattery() {
-    static unsigned long lastBatteryCheck = 0;
     static bool lowBatteryWarningShown = false;
     
-    if (millis() - lastBatteryCheck < 60000) {  // Check every minute
-        return;
-    }
-    
-    lastBatteryCheck = millis();
     int batteryPercent = power.getBatteryPercent();
+    batteryLevel.set(batteryPercent);
+    deviceApi.getStatus().battery = batteryPercent;
+    deviceApi.publishStatus();
     
     if (batteryPercent < 20 && !lowBatteryWarningShown) {
         Serial.println("⚠️ LOW BATTERY WARNING: " + String(batteryPercent) + "%");
         lowBatteryWarningShown = true;
         
-        // Could add visual/audio warning here
-        updateDisplay("Low Battery!", TFT_RED);
-        delay(2000);
-        showIdleScreen();
+        // Shown now if idle, else once the current activity ends
+        appTasks.post({ EV_LOW_BATTERY, batteryPercent, 0, nullptr });
     }
     
     if (batteryPercent >= 20) {
@@ -634,66 +772,89 @@ void checkBattery() {
     }
 }
 
-void showIdleScreen() {
-    currentState = IDLE;
-    
-    display.fillScreen(TFT_BLACK);
-    
-    // Title
-    display.setTextSize(3);
-    display.setCursor(30, 60);
-    display.setTextColor(TFT_CYAN);
-    display.println("VOLT");
-    
-    // Status
-    display.setTextSize(1);
-    display.setCursor(10, 110);
-    display.setTextColor(TFT_WHITE);
-    
-    if (WiFi.status() == WL_CONNECTED) {
-        display.setTextColor(TFT_GREEN);
-        display.println("Ready to talk!");
-    } else {
-        display.setTextColor(TFT_YELLOW);
-        display.println("Offline mode");
-        display.setCursor(10, 125);
-        display.setTextColor(TFT_WHITE);
-        display.println("(Jokes & breathing work)");
-    }
-    
-    // Battery
-    display.setCursor(10, 150);
-    display.setTextColor(TFT_WHITE);
-    int battery = power.getBatteryPercent();
-    if (battery < 20) {
-        display.setTextColor(TFT_RED);
+// The sketch's own metrics, the AI engine's (already there when
+// bot.begin() succeeded; adding twice is a no-op) and the task
+// table as of the last sample
+void registerMetrics() {
+    MetricsRegistry& registry = metricsRegistry();
+    registry.add(&loopLatency);
+    registry.add(&housekeepingWakeups);
+    registry.add(&uiPixels);
+    supervisor.registerMetrics(registry);
+    registry.add(&wifiReconnects);
+    registry.add(&wifiReconnectFailures);
+    registry.add(&batteryLevel);
+    registry.add(&uptime);
+    registry.add(&heapFree);
+    registry.add(&heapLargest);
+    bootSequencer().registerMetrics(registry);
+    appTasks.registerMetrics(registry);
+    aiMetrics().registerAll(registry);
+    registry.addCollector([](Print& out) { taskStats().writeMetrics(out); });
+    batteryLevel.set(power.getBatteryPercent());
+}
+
+// One command per line on the serial monitor:
+//   heap  - allocation sites and fragmentation (heap_profiler.h)
+//   tasks - CPU per task, idle per core, stacks, queues (task_stats.h)
+//   timers - housekeeping jobs and wakeups per hour (coalesced_timers.h)
+//   health - heartbeat deadlines, busy and worst gaps (task_supervisor.h)
+//   boot - this boot's phases and when the button worked (boot_sequencer.h)
+//   prof start [hz] / prof stop / prof dump - PC samples (pc_profiler.h)
+void checkSerialCommands() {
+    static char line[32];
+    static size_t len = 0;
+
+    while (Serial.available() > 0) {
+        char c = (char)Serial.read();
+        if (c != '\n' && c != '\r') {
+            if (len < sizeof(line) - 1) {
+                line[len++] = c;
+            }
+            continue;
+        }
+        if (len == 0) {
+            continue;
+        }
+        line[len] = '\0';
+        len = 0;
+
+        if (strcmp(line, "heap") == 0) {
+            heapProfileDump(Serial);
+        } else if (strcmp(line, "tasks") == 0) {
+            taskStats().printReport(Serial);  // As of the last sample
+        } else if (strcmp(line, "health") == 0) {
+            supervisor.printReport(Serial, halMillis());
+        } else if (strcmp(line, "timers") == 0) {
+            printHousekeeping();
+        } else if (strcmp(line, "boot") == 0) {
+            bootSequencer().printReport(Serial);
+        } else if (strncmp(line, "prof start", 10) == 0) {
+            pcProfiler().start(line[10] ? (uint32_t)atoi(line + 11) : PcProfiler::DEFAULT_HZ);
+        } else if (strcmp(line, "prof stop") == 0) {
+            pcProfiler().stop();
+        } else if (strcmp(line, "prof dump") == 0) {
+            pcProfiler().stop();
+            pcProfiler().dump(Serial);
+        } else {
+            Serial.printf("Serial: Unknown command '%s' (try: heap, tasks, timers, health, boot, prof)\n", line);
+        }
     }
-    display.printf("Battery: %d%%", battery);
-    
-    // Instructions
-    display.setCursor(10, 180);
-    display.setTextColor(TFT_CYAN);
-    display.println("Press button to start");
-    
-    display.setCursor(10, 200);
-    display.setTextSize(1);
-    display.setTextColor(TFT_GRAY);
-    display.println("1=Talk 2=Joke 3=Breathe");
-    display.setCursor(10, 215);
-    display.println("Hold=Love 5=WiFi");
+}
+
+void showIdleScreen() {
+    screens.idle(WiFi.status() == WL_CONNECTED, power.getBatteryPercent());
+    flushScreen();
 }
 
 void updateDisplay(const char* message, uint16_t color) {
-    display.fillScreen(TFT_BLACK);
-    display.setTextSize(2);
-    display.setCursor(10, 120);
-    display.setTextColor(color);
-    display.println(message);
+    screens.status(message, color);
+    flushScreen();
 }
 
 void setBacklight(bool on) {
     // HU-087 backlight is active LOW
-    digitalWrite(LCD_BL, on ? LOW : HIGH);
+    digitalWrite(LCD_BL, on == Board::Display::BL_ACTIVE_LOW ? LOW : HIGH);
 }
 
 // ============================================
@@ -0,0 +1,311 @@
+/*
+ * ============================================
+ * VOLT Trace - Conversation Turn Spans
+ * ============================================
+ *
+ * Handles:
+ * - Monotonic microsecond spans for each step
+ *   of a turn (record, encode, connect, TLS,
+ *   upload, server wait, first TTS byte,
+ *   playback)
+ * - One lock-free ring per core: writers only
+ *   bump an atomic index, nothing blocks
+ * - Turn numbers, so a slow answer can be
+ *   picked out of the last few turns
+ * - Export as plain JSON or Chrome trace
+ *   format (chrome://tracing, ui.perfetto.dev),
+ *   streamed to any Print
+ *
+ * Spans are recorded with the macros at the end
+ * of this file. With VOLT_TRACE set to 0 (see
+ * config_stone.h) they compile to nothing and
+ * the exporters return an empty trace.
+ *
+ * What the stages cover:
+ *   connect      DNS + TCP + TLS (connectApi)
+ *   tls          client.connect(), TCP + TLS
+ *                (WiFiClientSecure does both)
+ *   upload       request head -> last body byte
+ *   server_wait  last body byte -> status line
+ *   tts_first_byte  first PCM byte (instant)
+ *   playback     first -> last PCM write to I2S
+ *
+ * Timestamps are halMicros(), which wraps after
+ * ~71 minutes on the watch; durations are right
+ * across the wrap, absolute times restart.
+ *
+ * ============================================
+ */
+
+#ifndef VOLT_TRACE_H
+#define VOLT_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "volt_hal.h"
+
+#ifndef VOLT_TRACE
+#define VOLT_TRACE 1
+#endif
+
+enum TraceStage {
+    TRACE_RECORD = 0,
+    TRACE_ENCODE,
+    TRACE_CONNECT,
+    TRACE_TLS,
+    TRACE_UPLOAD,
+    TRACE_SERVER_WAIT,
+    TRACE_TTS_FIRST_BYTE,
+    TRACE_PLAYBACK,
+    TRACE_STAGE_COUNT
+};
+
+static const char* const TRACE_STAGE_NAMES[TRACE_STAGE_COUNT] = {
+    "record", "encode", "connect", "tls", "upload",
+    "server_wait", "tts_first_byte", "playback"
+};
+
+#if VOLT_TRACE
+
+#include <atomic>
+
+// ============================================
+// RING BUFFERS
+// ============================================
+
+class VoltTrace {
+public:
+    static const uint32_t CORES = 2;
+    static const uint32_t SPANS_PER_CORE = 128;   // Power of two; ~10 turns
+
+private:
+    static const uint32_t MASK = SPANS_PER_CORE - 1;
+    static const uint32_t INSTANT = 0x80;
+
+    // One slot, written as a tiny seqlock: seq is 0 while the
+    // writer fills it, then the span's index + 1. Readers skip
+    // slots that changed under them or were overwritten.
+    struct Slot {
+        std::atomic<uint32_t> seq;
+        std::atomic<uint32_t> startUs;
+        std::atomic<uint32_t> durUs;
+        std::atomic<uint32_t> meta;       // turn << 16 | core << 8 | flags | stage
+    };
+
+    struct Ring {
+        std::atomic<uint32_t> head;       // Spans ever written on this core
+        Slot slots[SPANS_PER_CORE];
+    };
+
+    Ring rings[CORES];
+    std::atomic<uint32_t> currentTurn;
+
+    void write(uint32_t stage, uint32_t startUs, uint32_t durUs) {
+        uint32_t core = (uint32_t)halCoreId() % CORES;
+        Ring& ring = rings[core];
+        uint32_t index = ring.head.fetch_add(1, std::memory_order_relaxed);
+        Slot& slot = ring.slots[index & MASK];
+
+        slot.seq.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.startUs.store(startUs, std::memory_order_relaxed);
+        slot.durUs.store(durUs, std::memory_order_relaxed);
+        slot.meta.store((currentTurn.load(std::memory_order_relaxed) & 0xFFFF) << 16 |
+                        core << 8 | stage, std::memory_order_relaxed);
+        slot.seq.store(index + 1, std::memory_order_release);
+    }
+
+public:
+    struct Span {
+        TraceStage stage;
+        bool instant;
+        uint8_t core;
+        uint16_t turn;
+        uint32_t startUs;
+        uint32_t durUs;
+    };
+
+    VoltTrace() {
+        clear();
+    }
+
+    void record(TraceStage stage, uint32_t startUs, uint32_t durUs) {
+        write(stage, startUs, durUs);
+    }
+
+    void instant(TraceStage stage) {
+        write(stage | INSTANT, halMicros(), 0);
+    }
+
+    // Numbers the spans that follow; returns the new turn
+    uint16_t beginTurn() {
+        return (uint16_t)(currentTurn.fetch_add(1, std::memory_order_relaxed) + 1);
+    }
+
+    uint16_t turn() const {
+        return (uint16_t)currentTurn.load(std::memory_order_relaxed);
+    }
+
+    // Not safe against concurrent writers; for tests and boot
+    void clear() {
+        for (uint32_t c = 0; c < CORES; c++) {
+            rings[c].head.store(0, std::memory_order_relaxed);
+            for (uint32_t i = 0; i < SPANS_PER_CORE; i++) {
+                rings[c].slots[i].seq.store(0, std::memory_order_relaxed);
+            }
+        }
+        currentTurn.store(0, std::memory_order_relaxed);
+    }
+
+    // Spans written on a core so far (including overwritten ones)
+    uint32_t written(uint32_t core) const {
+        return rings[core % CORES].head.load(std::memory_order_relaxed);
+    }
+
+    // Visits every span still in the rings, oldest first per core.
+    // Safe while other tasks keep recording.
+    template <typename F>
+    void forEach(F visit) const {
+        for (uint32_t c = 0; c < CORES; c++) {
+            const Ring& ring = rings[c];
+            uint32_t head = ring.head.load(std::memory_order_acquire);
+            uint32_t first = head > SPANS_PER_CORE ? head - SPANS_PER_CORE : 0;
+            for (uint32_t index = first; index < head; index++) {
+                const Slot& slot = ring.slots[index & MASK];
+                if (slot.seq.load(std::memory_order_acquire) != index + 1) continue;
+                uint32_t startUs = slot.startUs.load(std::memory_order_relaxed);
+                uint32_t durUs = slot.durUs.load(std::memory_order_relaxed);
+                uint32_t meta = slot.meta.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.seq.load(std::memory_order_relaxed) != index + 1) continue;
+
+                Span span;
+                span.stage = (TraceStage)(meta & 0x7F);
+                span.instant = (meta & INSTANT) != 0;
+                span.core = (uint8_t)(meta >> 8);
+                span.turn = (uint16_t)(meta >> 16);
+                span.startUs = startUs;
+                span.durUs = durUs;
+                if (span.stage < TRACE_STAGE_COUNT) {
+                    visit(span);
+                }
+            }
+        }
+    }
+};
+
+inline VoltTrace& voltTrace() {
+    static VoltTrace trace;
+    return trace;
+}
+
+// Span held open across statements (TRACE_DECLARE/START/STOP)
+class TraceTimer {
+private:
+    TraceStage stage;
+    uint32_t startUs;
+    bool running;
+
+public:
+    explicit TraceTimer(TraceStage s) : stage(s), startUs(0), running(false) {}
+
+    // (Re)starts the span from now
+    void start() {
+        startUs = halMicros();
+        running = true;
+    }
+
+    void stop() {
+        if (running) {
+            voltTrace().record(stage, startUs, (uint32_t)halMicros() - startUs);
+            running = false;
+        }
+    }
+};
+
+// Span for the rest of the enclosing block
+class TraceScope {
+private:
+    TraceStage stage;
+    uint32_t startUs;
+
+public:
+    explicit TraceScope(TraceStage s) : stage(s), startUs(halMicros()) {}
+    ~TraceScope() {
+        voltTrace().record(stage, startUs, (uint32_t)halMicros() - startUs);
+    }
+};
+
+#define TRACE_CONCAT2(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT2(a, b)
+
+#define TRACE_SCOPE(stage) TraceScope TRACE_CONCAT(traceScope_, __LINE__)(stage)
+#define TRACE_DECLARE(name, stage) TraceTimer name(stage)
+#define TRACE_START(name) name.start()
+#define TRACE_STOP(name) name.stop()
+#define TRACE_INSTANT(stage) voltTrace().instant(stage)
+#define TRACE_TURN() voltTrace().beginTurn()
+
+#else
+
+#define TRACE_SCOPE(stage)
+#define TRACE_DECLARE(name, stage)
+#define TRACE_START(name)
+#define TRACE_STOP(name)
+#define TRACE_INSTANT(stage)
+#define TRACE_TURN()
+
+#endif // VOLT_TRACE
+
+// ============================================
+// EXPORT
+// ============================================
+
+// {"turn":N,"now_us":...,"spans":[{"stage":"upload","turn":3,"core":1,
+//  "start_us":...,"dur_us":...}, ...]}  (instants have no dur_us)
+inline void traceWriteJson(Print& out) {
+#if VOLT_TRACE
+    VoltTrace& trace = voltTrace();
+    out.printf("{\"turn\":%u,\"now_us\":%lu,\"spans\":[",
+               (unsigned)trace.turn(), (unsigned long)(uint32_t)halMicros());
+    bool first = true;
+    trace.forEach([&](const VoltTrace::Span& s) {
+        out.printf("%s{\"stage\":\"%s\",\"turn\":%u,\"core\":%u,\"start_us\":%lu",
+                   first ? "" : ",", TRACE_STAGE_NAMES[s.stage], (unsigned)s.turn,
+                   (unsigned)s.core, (unsigned long)s.startUs);
+        if (!s.instant) {
+            out.printf(",\"dur_us\":%lu", (unsigned long)s.durUs);
+        }
+        out.print("}");
+        first = false;
+    });
+    out.print("]}");
+#else
+    out.print("{\"turn\":0,\"spans\":[]}");
+#endif
+}
+
+// Chrome trace event format: one thread per core, spans as
+// complete ("X") events and instants as "i"
+inline void traceWriteChrome(Print& out) {
+    out.print("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+#if VOLT_TRACE
+    for (uint32_t c = 0; c < VoltTrace::CORES; c++) {
+        out.printf("%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+                   "\"args\":{\"name\":\"core %u\"}}", c ? "," : "", (unsigned)c, (unsigned)c);
+    }
+    voltTrace().forEach([&](const VoltTrace::Span& s) {
+        out.printf(",{\"name\":\"%s\",\"cat\":\"turn\",\"ph\":\"%s\",\"ts\":%lu,",
+                   TRACE_STAGE_NAMES[s.stage], s.instant ? "i" : "X", (unsigned long)s.startUs);
+        if (s.instant) {
+            out.print("\"s\":\"t\",");
+        } else {
+            out.printf("\"dur\":%lu,", (unsigned long)s.durUs);
+        }
+        out.printf("\"pid\":1,\"tid\":%u,\"args\":{\"turn\":%u}}", (unsigned)s.core, (unsigned)s.turn);
+    });
+#endif
+    out.print("]}");
+}
+
+#endif // VOLT_TRACE_H
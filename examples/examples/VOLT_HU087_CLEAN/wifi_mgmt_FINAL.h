@@ -4,9 +4,11 @@
  * ============================================
  * 
  * Handles:
- * - WiFi connection
+ * - WiFi connection, blocking or started and
+ *   polled
  * - AP mode for setup
  * - Connection status
+ * - DNS pre-resolution once connected
  * 
  * Optimized for Stone's HU-087 watch
  * 
@@ -19,6 +21,7 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include "config_stone.h"
+#include "dns_cache.h"
 
 class WiFiManager {
 private:
@@ -28,7 +31,10 @@ private:
 public:
     WiFiManager() {}
     
-    bool connect(const char* wifiSSID, const char* wifiPassword, int timeout) {
+    // Starts associating and returns at once; poll isConnected(),
+    // then call connected() (boot_sequencer.h runs the rest of
+    // boot meanwhile)
+    void startConnect(const char* wifiSSID, const char* wifiPassword) {
         ssid = String(wifiSSID);
         password = String(wifiPassword);
         
@@ -36,6 +42,21 @@ public:
         
         WiFi.mode(WIFI_STA);
         WiFi.begin(wifiSSID, wifiPassword);
+    }
+    
+    // Once associated
+    void connected() {
+        Serial.println("WiFi: Connected!");
+        Serial.println("WiFi: IP address: " + WiFi.localIP().toString());
+        
+        // Resolve API hosts now, not on the first request
+        int ready = dnsCache().prewarm(DNS_PREWARM_HOSTS, DNS_PREWARM_HOST_COUNT);
+        Serial.printf("WiFi: %d/%d hosts resolved\n", ready, DNS_PREWARM_HOST_COUNT);
+    }
+    
+    // Blocks up to timeout seconds (reconnects from the net task)
+    bool connect(const char* wifiSSID, const char* wifiPassword, int timeout) {
+        startConnect(wifiSSID, wifiPassword);
         
         unsigned long startTime = millis();
         while (WiFi.status() != WL_CONNECTED && (millis() - startTime < timeout * 1000)) {
@@ -45,8 +66,7 @@ public:
         Serial.println();
         
         if (WiFi.status() == WL_CONNECTED) {
-            Serial.println("WiFi: Connected!");
-            Serial.println("WiFi: IP address: " + WiFi.localIP().toString());
+            connected();
             return true;
         } else {
             Serial.println("WiFi: Connection failed");
@@ -0,0 +1,503 @@
+/*
+ * ============================================
+ * WebSocket Client - Lightweight RFC 6455
+ * ============================================
+ *
+ * Handles:
+ * - Opening handshake over any Arduino Client
+ *   (WiFiClientSecure for wss://)
+ * - Masked client frames, sent in one piece or
+ *   streamed with a known length
+ * - Incremental receive: payload is handed to a
+ *   handler as it arrives, never buffered whole
+ * - Masked server frames fail the connection
+ *   with 1002 (RFC 6455 5.1)
+ * - Ping/pong and close handling; replies that
+ *   arrive while a frame is being streamed wait
+ *   until it is complete (RFC 6455 5.4)
+ *
+ * ============================================
+ */
+
+#ifndef WS_CLIENT_H
+#define WS_CLIENT_H
+
+#include <Arduino.h>
+#include <Client.h>
+#include "turn_arena.h"
+#include "base64_stream.h"
+
+enum WsOpcode : uint8_t {
+    WS_OP_CONTINUATION = 0x0,
+    WS_OP_TEXT = 0x1,
+    WS_OP_BINARY = 0x2,
+    WS_OP_CLOSE = 0x8,
+    WS_OP_PING = 0x9,
+    WS_OP_PONG = 0xA
+};
+
+// Receives message payload in pieces as frames arrive
+class WsHandler {
+public:
+    virtual ~WsHandler() {}
+    // first/last mark message boundaries across fragments
+    virtual void onMessageData(uint8_t opcode, const uint8_t* data, size_t len,
+                               bool first, bool last) = 0;
+    virtual void onClose(uint16_t code) { (void)code; }
+};
+
+// ============================================
+// SHA-1 (handshake accept check only)
+// ============================================
+
+class WsSha1 {
+private:
+    uint32_t h[5];
+    uint8_t block[64];
+    uint8_t blockLen;
+    uint64_t totalLen;
+
+    static uint32_t rol(uint32_t v, int n) {
+        return (v << n) | (v >> (32 - n));
+    }
+
+    void compress() {
+        uint32_t w[80];
+        for (int i = 0; i < 16; i++) {
+            w[i] = ((uint32_t)block[i * 4] << 24) | ((uint32_t)block[i * 4 + 1] << 16) |
+                   ((uint32_t)block[i * 4 + 2] << 8) | block[i * 4 + 3];
+        }
+        for (int i = 16; i < 80; i++) {
+            w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; i++) {
+            uint32_t f, k;
+            if (i < 20)      { f = (b & c) | (~b & d);          k = 0x5A827999; }
+            else if (i < 40) { f = b ^ c ^ d;                   k = 0x6ED9EBA1; }
+            else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+            else             { f = b ^ c ^ d;                   k = 0xCA62C1D6; }
+            uint32_t t = rol(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rol(b, 30);
+            b = a;
+            a = t;
+        }
+        h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+        blockLen = 0;
+    }
+
+public:
+    WsSha1() : blockLen(0), totalLen(0) {
+        h[0] = 0x67452301; h[1] = 0xEFCDAB89; h[2] = 0x98BADCFE;
+        h[3] = 0x10325476; h[4] = 0xC3D2E1F0;
+    }
+
+    void update(const uint8_t* data, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            block[blockLen++] = data[i];
+            if (blockLen == 64) compress();
+        }
+        totalLen += n;
+    }
+
+    void finish(uint8_t out[20]) {
+        uint64_t bitLen = totalLen * 8;
+        uint8_t pad = 0x80;
+        update(&pad, 1);
+        pad = 0;
+        while (blockLen != 56) update(&pad, 1);
+        for (int i = 7; i >= 0; i--) {
+            block[blockLen++] = (uint8_t)(bitLen >> (i * 8));
+        }
+        compress();
+        for (int i = 0; i < 5; i++) {
+            out[i * 4] = (uint8_t)(h[i] >> 24);
+            out[i * 4 + 1] = (uint8_t)(h[i] >> 16);
+            out[i * 4 + 2] = (uint8_t)(h[i] >> 8);
+            out[i * 4 + 3] = (uint8_t)h[i];
+        }
+    }
+};
+
+// ============================================
+// CLIENT
+// ============================================
+
+class WsClient {
+private:
+    Client* client;
+    bool open;
+
+    // Outgoing frame being streamed
+    uint8_t txMask[4];
+    size_t txRemaining;
+    size_t txMaskIndex;
+
+    // Control reply held back until the current frame is complete
+    uint8_t pendingOp;          // 0: none
+    uint8_t pending[125];
+    uint8_t pendingLen;
+
+    // Incoming frame parser
+    enum RxState { RX_HEADER, RX_PAYLOAD };
+    RxState rxState;
+    uint8_t rxHeader[14];
+    uint8_t rxHeaderLen;
+    uint8_t rxOpcode;
+    bool rxFin;
+    uint64_t rxRemaining;
+    uint8_t rxMessageOpcode;   // Opcode of the message being continued
+    bool rxMessageStarted;
+    uint8_t ctrl[125];          // Control frame payload
+    uint8_t ctrlLen;
+
+    static const char* guid() {
+        return "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    }
+
+    static uint32_t randomWord() {
+        return ((uint32_t)random(0x10000) << 16) | (uint32_t)random(0x10000);
+    }
+
+    size_t headerNeeded() const {
+        if (rxHeaderLen < 2) return 2;
+        size_t n = 2;
+        uint8_t len7 = rxHeader[1] & 0x7F;
+        if (len7 == 126) n += 2;
+        else if (len7 == 127) n += 8;
+        return n;   // Masked frames are refused at byte 2
+    }
+
+    void parseHeader() {
+        rxFin = (rxHeader[0] & 0x80) != 0;
+        rxOpcode = rxHeader[0] & 0x0F;
+        uint8_t len7 = rxHeader[1] & 0x7F;
+        if (len7 < 126) {
+            rxRemaining = len7;
+        } else if (len7 == 126) {
+            rxRemaining = ((uint16_t)rxHeader[2] << 8) | rxHeader[3];
+        } else {
+            rxRemaining = 0;
+            for (int i = 0; i < 8; i++) {
+                rxRemaining = (rxRemaining << 8) | rxHeader[2 + i];
+            }
+        }
+        ctrlLen = 0;
+    }
+
+    // Masked header for a frame of len bytes; the payload follows
+    // through writeFrameData()
+    bool startFrame(uint8_t opcode, size_t len) {
+        uint8_t header[14];
+        size_t h = 0;
+        header[h++] = 0x80 | opcode;   // FIN, no fragmentation
+        if (len < 126) {
+            header[h++] = 0x80 | (uint8_t)len;
+        } else if (len <= 0xFFFF) {
+            header[h++] = 0x80 | 126;
+            header[h++] = (uint8_t)(len >> 8);
+            header[h++] = (uint8_t)len;
+        } else {
+            header[h++] = 0x80 | 127;
+            for (int i = 7; i >= 0; i--) {
+                header[h++] = (uint8_t)((uint64_t)len >> (i * 8));
+            }
+        }
+        uint32_t mask = randomWord();
+        memcpy(txMask, &mask, 4);
+        memcpy(header + h, txMask, 4);
+        h += 4;
+        txRemaining = len;
+        txMaskIndex = 0;
+        return writeAll(header, h);
+    }
+
+    // Control frames may go between frames, not inside one: while a
+    // frame is half written the reply is held (a close replaces a
+    // pong, a newer pong an older one) and sent when it completes
+    void sendControl(uint8_t opcode, const uint8_t* data, size_t len) {
+        if (txRemaining == 0) {
+            if (startFrame(opcode, len)) writeFrameData(data, len);
+            return;
+        }
+        if (pendingOp == WS_OP_CLOSE) return;
+        pendingOp = opcode;
+        memcpy(pending, data, len);
+        pendingLen = (uint8_t)len;
+    }
+
+    void sendPending() {
+        uint8_t opcode = pendingOp;
+        pendingOp = 0;
+        if (startFrame(opcode, pendingLen)) writeFrameData(pending, pendingLen);
+        if (opcode == WS_OP_CLOSE) client->stop();
+    }
+
+    void handleControl(WsHandler& handler) {
+        if (rxOpcode == WS_OP_PING) {
+            if (open) sendControl(WS_OP_PONG, ctrl, ctrlLen);
+        } else if (rxOpcode == WS_OP_CLOSE) {
+            uint16_t code = ctrlLen >= 2 ? (uint16_t)((ctrl[0] << 8) | ctrl[1]) : 1005;
+            bool midFrame = txRemaining != 0;
+            if (open) {
+                // Echo the close and drop the connection (once the
+                // frame being written is complete)
+                sendControl(WS_OP_CLOSE, ctrl, ctrlLen >= 2 ? 2 : 0);
+            }
+            open = false;
+            if (!midFrame) client->stop();
+            handler.onClose(code);
+        }
+    }
+
+    // Close with code and drop the connection without reading on
+    void fail(WsHandler& handler, uint16_t code) {
+        bool midFrame = txRemaining != 0;
+        if (open) {
+            uint8_t payload[2] = { (uint8_t)(code >> 8), (uint8_t)code };
+            sendControl(WS_OP_CLOSE, payload, 2);
+        }
+        open = false;
+        if (!midFrame) client->stop();
+        handler.onClose(code);
+    }
+
+    void finishFrame(WsHandler& handler) {
+        if (rxOpcode >= WS_OP_CLOSE) {
+            handleControl(handler);
+        } else if (rxFin) {
+            rxMessageStarted = false;
+        }
+        rxState = RX_HEADER;
+        rxHeaderLen = 0;
+    }
+
+    bool writeAll(const uint8_t* data, size_t n) {
+        while (n > 0) {
+            size_t w = client->write(data, n);
+            if (w == 0) {
+                open = false;
+                return false;
+            }
+            data += w;
+            n -= w;
+        }
+        return true;
+    }
+
+public:
+    WsClient() : client(nullptr), open(false), txRemaining(0), txMaskIndex(0), pendingOp(0),
+                 pendingLen(0), rxState(RX_HEADER), rxHeaderLen(0), rxOpcode(0), rxFin(false),
+                 rxRemaining(0), rxMessageOpcode(0),
+                 rxMessageStarted(false), ctrlLen(0) {}
+
+    // Perform the HTTP upgrade on an already-connected client.
+    // extraHeaders are complete "Name: value\r\n" lines (may be null).
+    bool handshake(Client& c, const char* host, const char* path,
+                   const char* extraHeaders, unsigned long timeoutMs) {
+        client = &c;
+        open = false;
+        txRemaining = 0;
+        pendingOp = 0;
+        rxState = RX_HEADER;
+        rxHeaderLen = 0;
+        rxMessageStarted = false;
+
+        uint8_t nonce[16];
+        for (int i = 0; i < 16; i += 4) {
+            uint32_t r = randomWord();
+            memcpy(nonce + i, &r, 4);
+        }
+        char key[25];
+        Base64Encoder enc;
+        size_t n = enc.update(nonce, sizeof(nonce), key, sizeof(key));
+        n += enc.finish(key + n);
+        key[n] = '\0';
+
+        FixedString<1024> request;
+        request.appendf("GET %s HTTP/1.1\r\n", path);
+        request.appendf("Host: %s\r\n", host);
+        request.append("Upgrade: websocket\r\n");
+        request.append("Connection: Upgrade\r\n");
+        request.appendf("Sec-WebSocket-Key: %s\r\n", key);
+        request.append("Sec-WebSocket-Version: 13\r\n");
+        if (extraHeaders) request.append(extraHeaders);
+        request.append("\r\n");
+        if (request.overflowed()) {
+            Serial.println("WS: Handshake request too long");
+            return false;
+        }
+        if (!writeAll((const uint8_t*)request.c_str(), request.length())) {
+            return false;
+        }
+
+        // Expected Sec-WebSocket-Accept value
+        WsSha1 sha;
+        sha.update((const uint8_t*)key, strlen(key));
+        sha.update((const uint8_t*)guid(), strlen(guid()));
+        uint8_t digest[20];
+        sha.finish(digest);
+        char expected[29];
+        enc.reset();
+        n = enc.update(digest, sizeof(digest), expected, sizeof(expected));
+        n += enc.finish(expected + n);
+        expected[n] = '\0';
+
+        // Read response headers line by line
+        FixedString<256> line;
+        int status = -1;
+        bool accepted = false;
+        unsigned long start = millis();
+        while (millis() - start < timeoutMs) {
+            if (!client->available()) {
+                if (!client->connected()) break;
+                delay(1);
+                continue;
+            }
+            char ch = (char)client->read();
+            if (ch == '\r') continue;
+            if (ch != '\n') {
+                line.append(ch);
+                continue;
+            }
+            if (line.isEmpty()) {
+                open = (status == 101 && accepted);
+                if (!open) {
+                    Serial.printf("WS: Upgrade failed (HTTP %d%s)\n", status,
+                        accepted ? "" : ", bad accept key");
+                }
+                return open;
+            }
+            if (status < 0) {
+                const char* sp = strchr(line.c_str(), ' ');
+                status = sp ? atoi(sp + 1) : 0;
+            } else if (strncasecmp(line.c_str(), "Sec-WebSocket-Accept:", 21) == 0) {
+                const char* v = line.c_str() + 21;
+                while (*v == ' ') v++;
+                accepted = strcmp(v, expected) == 0;
+            }
+            line.clear();
+        }
+        Serial.println("WS: Handshake timeout");
+        return false;
+    }
+
+    bool isOpen() {
+        return open && client && client->connected();
+    }
+
+    // Start a frame whose payload length is known up front;
+    // follow with writeFrameData() calls totalling exactly len bytes.
+    bool beginFrame(uint8_t opcode, size_t len) {
+        if (!open || txRemaining != 0) return false;
+        return startFrame(opcode, len);
+    }
+
+    bool writeFrameData(const uint8_t* data, size_t n) {
+        if (n > txRemaining) return false;
+        uint8_t chunk[256];
+        while (n > 0) {
+            size_t k = n < sizeof(chunk) ? n : sizeof(chunk);
+            for (size_t i = 0; i < k; i++) {
+                chunk[i] = data[i] ^ txMask[(txMaskIndex + i) & 3];
+            }
+            if (!writeAll(chunk, k)) return false;
+            txMaskIndex += k;
+            txRemaining -= k;
+            data += k;
+            n -= k;
+        }
+        if (txRemaining == 0 && pendingOp) sendPending();
+        return true;
+    }
+
+    bool writeFrameData(const char* text) {
+        return writeFrameData((const uint8_t*)text, strlen(text));
+    }
+
+    bool sendFrame(uint8_t opcode, const uint8_t* data, size_t len) {
+        return beginFrame(opcode, len) && writeFrameData(data, len);
+    }
+
+    bool sendText(const char* text) {
+        return sendFrame(WS_OP_TEXT, (const uint8_t*)text, strlen(text));
+    }
+
+    // Read whatever is available and feed the handler.
+    // Returns false once the connection is closed.
+    bool poll(WsHandler& handler, size_t maxBytes = 4096) {
+        if (!client) return false;
+        uint8_t buf[256];
+        size_t budget = maxBytes;
+
+        while (open && budget > 0 && client->available() > 0) {
+            if (rxState == RX_HEADER) {
+                int c = client->read();
+                if (c < 0) break;
+                budget--;
+                rxHeader[rxHeaderLen++] = (uint8_t)c;
+                if (rxHeaderLen == 2 && (rxHeader[1] & 0x80)) {
+                    Serial.println("WS: Masked frame from server");
+                    fail(handler, 1002);
+                    break;
+                }
+                if (rxHeaderLen < headerNeeded()) continue;
+
+                parseHeader();
+                rxState = RX_PAYLOAD;
+                if (rxOpcode < WS_OP_CLOSE && !rxMessageStarted) {
+                    rxMessageOpcode = rxOpcode;
+                }
+                if (rxRemaining == 0) {
+                    if (rxOpcode < WS_OP_CLOSE) {
+                        handler.onMessageData(rxMessageOpcode, buf, 0, !rxMessageStarted, rxFin);
+                        rxMessageStarted = !rxFin;
+                    }
+                    finishFrame(handler);
+                }
+                continue;
+            }
+
+            size_t want = rxRemaining < sizeof(buf) ? (size_t)rxRemaining : sizeof(buf);
+            if (want > budget) want = budget;
+            int n = client->read(buf, want);
+            if (n <= 0) break;
+            budget -= n;
+            rxRemaining -= n;
+
+            if (rxOpcode >= WS_OP_CLOSE) {
+                size_t room = sizeof(ctrl) - ctrlLen;
+                size_t k = (size_t)n < room ? (size_t)n : room;
+                memcpy(ctrl + ctrlLen, buf, k);
+                ctrlLen += k;
+            } else {
+                bool last = rxFin && rxRemaining == 0;
+                handler.onMessageData(rxMessageOpcode, buf, n, !rxMessageStarted, last);
+                rxMessageStarted = !last;
+            }
+
+            if (rxRemaining == 0) {
+                finishFrame(handler);
+            }
+        }
+
+        if (open && !client->connected() && client->available() == 0) {
+            open = false;
+            handler.onClose(1006);
+        }
+        return open;
+    }
+
+    void close(uint16_t code = 1000) {
+        if (open) {
+            uint8_t payload[2] = { (uint8_t)(code >> 8), (uint8_t)code };
+            sendFrame(WS_OP_CLOSE, payload, 2);
+            open = false;
+        }
+        if (client) client->stop();
+    }
+};
+
+#endif // WS_CLIENT_H
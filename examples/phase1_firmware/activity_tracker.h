@@ -5,9 +5,13 @@
 #include <Wire.h>
 #include <MPU6050.h>
 
+// Called on every counted step with the day's totals
+typedef void (*StepListener)(int steps, int calories);
+
 class ActivityTracker {
 private:
     MPU6050 accel;
+    StepListener stepListener;
     
     // Activity data
     int dailySteps;
@@ -27,7 +31,7 @@ private:
     int16_t accelOffsetZ;
     
 public:
-    ActivityTracker() : dailySteps(0), dailyCalories(0), isMoving(false),
+    ActivityTracker() : stepListener(nullptr), dailySteps(0), dailyCalories(0), isMoving(false),
                         lastStepTime(0), lastResetTime(0),
                         accelOffsetX(0), accelOffsetY(0), accelOffsetZ(0) {}
     
@@ -53,6 +57,10 @@ public:
         return true;
     }
     
+    void setStepListener(StepListener fn) {
+        stepListener = fn;
+    }
+    
     void calibrate() {
         Serial.println("Activity: Calibrating (keep still)...");
         
@@ -100,6 +108,10 @@ public:
                 
                 Serial.printf("Activity: Step detected! Total=%d, Cal=%d\n", 
                     dailySteps, dailyCalories);
+                
+                if (stepListener) {
+                    stepListener(dailySteps, dailyCalories);
+                }
             }
         }
         
@@ -4,13 +4,20 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include <HTTPClient.h>
+#include <WiFiClientSecure.h>
 #include <ArduinoJson.h>
 #include <Adafruit_SSD1306.h>
+#include "dns_cache.h"
+
+// Told the moment an SOS starts, before the alarm and the upload
+// (e.g. to push it to an open dashboard)
+typedef void (*SOSListener)(double latitude, double longitude, bool gpsValid, int battery);
 
 class SOSSystem {
 private:
     int buzzerPin;
     Adafruit_SSD1306* display;
+    SOSListener listener;
     
     bool sosActive;
     unsigned long sosLastTriggered;
@@ -21,8 +28,26 @@ private:
     String deviceId;
     String childName;
     
+    // Split apiEndpoint into host, port and TLS flag
+    bool endpointHost(String& host, uint16_t& port, bool& secure) {
+        int start = apiEndpoint.indexOf("://");
+        if (start < 0) return false;
+        secure = apiEndpoint.startsWith("https");
+        start += 3;
+        int end = apiEndpoint.indexOf('/', start);
+        if (end < 0) end = apiEndpoint.length();
+        host = apiEndpoint.substring(start, end);
+        port = secure ? 443 : 80;
+        int colon = host.indexOf(':');
+        if (colon >= 0) {
+            port = host.substring(colon + 1).toInt();
+            host = host.substring(0, colon);
+        }
+        return host.length() > 0;
+    }
+    
 public:
-    SOSSystem() : buzzerPin(-1), display(nullptr), sosActive(false), 
+    SOSSystem() : buzzerPin(-1), display(nullptr), listener(nullptr), sosActive(false), 
                   sosLastTriggered(0) {}
     
     void begin(int buzzer, Adafruit_SSD1306* disp) {
@@ -40,6 +65,22 @@ public:
         childName = name;
     }
     
+    void setListener(SOSListener fn) {
+        listener = fn;
+    }
+    
+    // Resolve the alert server while nothing is urgent (call once
+    // WiFi is up), so an SOS never waits on a DNS lookup
+    void warmDns() {
+        String host;
+        uint16_t port;
+        bool secure;
+        uint32_t ip;
+        if (endpointHost(host, port, secure)) {
+            dnsCache().resolve(host.c_str(), ip);
+        }
+    }
+    
     bool trigger(double latitude, double longitude, bool gpsValid, int battery) {
         // Check cooldown
         if (millis() - sosLastTriggered < SOS_COOLDOWN) {
@@ -52,6 +93,10 @@ public:
         
         Serial.println("🚨🚨🚨 SOS ACTIVATED! 🚨🚨🚨");
         
+        if (listener) {
+            listener(latitude, longitude, gpsValid, battery);
+        }
+        
         // Visual feedback
         showSOSScreen();
         
@@ -121,7 +166,25 @@ public:
         HTTPClient http;
         String url = apiEndpoint + "/api/device/" + deviceId + "/sos";
         
-        http.begin(url);
+        // Connect by cached address; HTTPClient reuses the open socket
+        WiFiClient plainClient;
+        WiFiClientSecure secureClient;
+        String host;
+        uint16_t port;
+        bool secure;
+        if (endpointHost(host, port, secure)) {
+            String path = url.substring(url.indexOf('/', url.indexOf("://") + 3));
+            if (secure) {
+                secureClient.setInsecure();
+                dnsConnect(secureClient, host.c_str(), port);
+                http.begin(secureClient, host, port, path, true);
+            } else {
+                dnsConnect(plainClient, host.c_str(), port);
+                http.begin(plainClient, host, port, path, false);
+            }
+        } else {
+            http.begin(url);
+        }
         http.addHeader("Content-Type", "application/json");
         http.addHeader("X-API-Key", apiKey);
         
@@ -41,6 +41,8 @@
 #include "gps_tracker.h"
 #include "activity_tracker.h"
 #include "sos_system.h"
+#include "button_gestures.h"
+#include "coalesced_timers.h"
 
 // Hardware Pin Definitions
 #define GPS_RX_PIN 16
@@ -62,29 +64,43 @@ GPSTracker gpsTracker;
 ActivityTracker activityTracker;
 SOSSystem sosSystem;
 
-// State Management
-unsigned long lastButtonPress = 0;
-int presses = 0;
-const int DEBOUNCE_TIME = 250;
-const int MULTI_PRESS_TIMEOUT = 600;
+// Button: edges from the pin interrupt, patterns from the gesture
+// engine (multi-press, SOS hold). loop() sleeps on the edge queue
+// instead of polling the pin.
+struct ButtonEdge {
+    bool pressed;
+    unsigned long ms;
+};
+ButtonGestures button;
+QueueHandle_t buttonEdges;
 
 // NEW: Power optimization
 unsigned long lastActivity = 0;
-unsigned long lastGPSUpdate = 0;
-unsigned long lastActivityUpdate = 0;
-unsigned long lastAPISync = 0;
+
+// GPS, activity and API sync: each may run up to its slack late,
+// so one wakeup serves all that are due
+CoalescedTimers jobs;
 
 #define LIGHT_SLEEP_TIMEOUT 60000      // 1 minute
 #define GPS_UPDATE_INTERVAL 30000      // 30 seconds
+#define GPS_UPDATE_SLACK 10000
 #define ACTIVITY_UPDATE_INTERVAL 5000  // 5 seconds
+#define ACTIVITY_UPDATE_SLACK 2000
 #define API_SYNC_INTERVAL 60000        // 1 minute
+#define API_SYNC_SLACK 30000
+#define ACTIVE_WAIT_MS 20              // Longest loop() sleep while in use (web API, OTA)
+#define IDLE_WAIT_MS 1000              // ... and once idle for LIGHT_SLEEP_TIMEOUT
 
 // Function Prototypes
 void handleButtonAction(int count);
 void showIdleScreen();
 void optimizePower();
 void syncWithAPI();
-void checkSOSButton();
+void IRAM_ATTR onButtonEdge();
+void waitForButton(uint32_t waitMs);
+void handleGesture(Gesture gesture);
+uint32_t loopWaitMs();
+void startJobs();
 
 void setup() {
     Serial.begin(115200);
@@ -92,6 +108,8 @@ void setup() {
 
     // 1. Hardware Init
     pinMode(0, INPUT_PULLUP);
+    buttonEdges = xQueueCreate(16, sizeof(ButtonEdge));
+    attachInterrupt(digitalPinToInterrupt(0), onButtonEdge, CHANGE);
     pinMode(2, OUTPUT);
     pinMode(BUZZER_PIN, OUTPUT);
     digitalWrite(2, LOW);
@@ -154,6 +172,7 @@ void setup() {
     if (wifiManager.isConnected()) {
         webApi.begin();
         Serial.println("Web API: Online");
+        sosSystem.warmDns();
         display.println("WiFi: OK");
     } else {
         display.println("WiFi: FAIL");
@@ -190,6 +209,7 @@ void setup() {
     showIdleScreen();
     
     lastActivity = millis();
+    startJobs();
 }
 
 void loop() {
@@ -198,97 +218,96 @@ void loop() {
     ota.handle();
     webApi.handle();
     
-    // NEW: Check SOS button (long press detection)
-    checkSOSButton();
-    
-    // NEW: Update GPS periodically
-    if (millis() - lastGPSUpdate > GPS_UPDATE_INTERVAL) {
-        gpsTracker.update();
-        lastGPSUpdate = millis();
-    }
-    
-    // NEW: Update activity tracking
-    if (millis() - lastActivityUpdate > ACTIVITY_UPDATE_INTERVAL) {
-        activityTracker.update();
-        lastActivityUpdate = millis();
-    }
-    
-    // NEW: Sync with API
-    if (millis() - lastAPISync > API_SYNC_INTERVAL) {
-        syncWithAPI();
-        lastAPISync = millis();
-    }
+    // NEW: GPS, activity tracking and API sync, whichever are due
+    jobs.run(millis());
     
     // NEW: Power optimization
     optimizePower();
 
-    // Button Handling (Multi-press logic)
-    if (digitalRead(0) == LOW) {
-        power.resetActivityTimer();
-        lastActivity = millis();
-        
-        unsigned long now = millis();
-        if (now - lastButtonPress > DEBOUNCE_TIME) {
-            presses++;
-            lastButtonPress = now;
-            delay(10);
-        }
-    }
+    // Sleep until a button edge, a gesture timer or the next job
+    waitForButton(loopWaitMs());
+}
 
-    // Execute logic after pause
-    if (presses > 0 && (millis() - lastButtonPress > MULTI_PRESS_TIMEOUT)) {
-        handleButtonAction(presses);
-        presses = 0;
-    }
-    
-    delay(10);
+// ============================================
+// BUTTON
+// ============================================
+
+void IRAM_ATTR onButtonEdge() {
+    ButtonEdge e = { digitalRead(0) == LOW, millis() };
+    BaseType_t woken = pdFALSE;
+    xQueueSendFromISR(buttonEdges, &e, &woken);   // Full: the next edge resyncs
+    if (woken) portYIELD_FROM_ISR();
 }
 
-void checkSOSButton() {
-    static unsigned long buttonPressStart = 0;
-    static bool buttonWasPressed = false;
-    static bool sosTriggered = false;
-    
-    bool buttonPressed = (digitalRead(0) == LOW);
-    
-    if (buttonPressed && !buttonWasPressed) {
-        buttonPressStart = millis();
-        buttonWasPressed = true;
-        sosTriggered = false;
+// Until a job runs out of slack or a gesture timer; longer once idle
+uint32_t loopWaitMs() {
+    unsigned long now = millis();
+    uint32_t wait = (now - lastActivity > LIGHT_SLEEP_TIMEOUT) ? IDLE_WAIT_MS : ACTIVE_WAIT_MS;
+    uint32_t t = button.waitMs(now);
+    if (t < wait) wait = t;
+    t = jobs.waitMs(now);
+    if (t < wait) wait = t;
+    return wait;
+}
+
+void waitForButton(uint32_t waitMs) {
+    ButtonEdge e;
+    if (xQueueReceive(buttonEdges, &e, pdMS_TO_TICKS(waitMs)) == pdTRUE) {
+        do {
+            for (Gesture g = button.poll(e.ms); g != GESTURE_NONE; g = button.poll(e.ms)) {
+                handleGesture(g);
+            }
+            button.edge(e.pressed, e.ms);
+        } while (xQueueReceive(buttonEdges, &e, 0) == pdTRUE);
     }
-    
-    if (buttonPressed && buttonWasPressed && !sosTriggered) {
-        unsigned long pressDuration = millis() - buttonPressStart;
-        
-        // Visual feedback during long press
-        if (pressDuration > 3000 && pressDuration < 5000) {
+    unsigned long now = millis();
+    for (Gesture g = button.poll(now); g != GESTURE_NONE; g = button.poll(now)) {
+        handleGesture(g);
+    }
+}
+
+void handleGesture(Gesture gesture) {
+    switch (gesture) {
+        case GESTURE_DOWN:
+            power.resetActivityTimer();
+            lastActivity = millis();
+            break;
+            
+        case GESTURE_PRESSES:
+            handleButtonAction(button.getPressCount());
+            // Presses made during the action don't start another
+            xQueueReset(buttonEdges);
+            button.begin(ButtonGestures::defaultTiming());
+            break;
+            
+        case GESTURE_SOS_WARNING:
+            // Visual feedback during long press
             display.clearDisplay();
             display.setTextSize(2);
             display.setCursor(0, 20);
             display.println("Hold for");
             display.println("SOS...");
             display.display();
-        }
-        
-        if (pressDuration >= 5000) {
-            // Trigger SOS
+            break;
+            
+        case GESTURE_SOS:
             sosSystem.trigger(
                 gpsTracker.getLatitude(),
                 gpsTracker.getLongitude(),
                 gpsTracker.isValid(),
                 power.getBatteryPercent()
             );
-            sosTriggered = true;
             lastActivity = millis();
-        }
-    }
-    
-    if (!buttonPressed && buttonWasPressed) {
-        buttonWasPressed = false;
-        if (!sosTriggered && (millis() - buttonPressStart < 5000)) {
-            // Normal button press, show idle screen
+            break;
+            
+        case GESTURE_LONG_PRESS:
+        case GESTURE_SOS_CANCEL:
+            // Let go before the alert, show idle screen
             showIdleScreen();
-        }
+            break;
+            
+        default:
+            break;
     }
 }
 
@@ -439,6 +458,24 @@ void showIdleScreen() {
     display.display();
 }
 
+// ============================================
+// PERIODIC JOBS (coalesced_timers.h)
+// ============================================
+
+void gpsJob(unsigned long now, void* ctx) { gpsTracker.update(); }
+void activityJob(unsigned long now, void* ctx) { activityTracker.update(); }
+void syncJob(unsigned long now, void* ctx) { syncWithAPI(); }
+
+// The activity beat wakes the loop; GPS and the sync, with more
+// slack, run in one of its passes
+void startJobs() {
+    unsigned long now = millis();
+    jobs.begin(now);
+    jobs.add("activity", ACTIVITY_UPDATE_INTERVAL, ACTIVITY_UPDATE_SLACK, activityJob, nullptr, now);
+    jobs.add("gps", GPS_UPDATE_INTERVAL, GPS_UPDATE_SLACK, gpsJob, nullptr, now);
+    jobs.add("sync", API_SYNC_INTERVAL, API_SYNC_SLACK, syncJob, nullptr, now);
+}
+
 void optimizePower() {
     unsigned long idleTime = millis() - lastActivity;
     
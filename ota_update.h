@@ -8,6 +8,7 @@
 
 #include <ArduinoOTA.h>
 #include <WiFi.h>
+#include "display_notice.h"
 
 class OTAUpdate {
 private:
@@ -20,20 +21,14 @@ private:
         Serial.println("OTA: Start updating " + type);
         
         // Show on display
-        display.clear();
-        display.setCursor(0, 0);
-        display.println("UPDATING VOLT...");
-        display.println("Do not power off!");
-        display.display();
+        const char* lines[] = { "UPDATING VOLT...", "Do not power off!" };
+        showNotice(display, lines);
     }
     
     static void onEnd() {
         Serial.println("\nOTA: Update complete!");
-        display.clear();
-        display.setCursor(0, 0);
-        display.println("Update Complete!");
-        display.println("Restarting...");
-        display.display();
+        const char* lines[] = { "Update Complete!", "Restarting..." };
+        showNotice(display, lines);
     }
     
     static void onProgress(unsigned int progress, unsigned int total) {
@@ -44,12 +39,10 @@ private:
             Serial.printf("OTA Progress: %u%%\n", percent);
             
             // Update display every 10%
-            display.clear();
-            display.setCursor(0, 0);
-            display.println("UPDATING VOLT");
-            display.printf("Progress: %u%%\n", percent);
-            display.println("Please wait...");
-            display.display();
+            char progress[24];
+            snprintf(progress, sizeof(progress), "Progress: %u%%", percent);
+            const char* lines[] = { "UPDATING VOLT", progress, "Please wait..." };
+            showNotice(display, lines);
             
             lastPercent = percent;
         }
@@ -82,12 +75,8 @@ private:
                 break;
         }
         
-        display.clear();
-        display.setCursor(0, 0);
-        display.println("Update Failed!");
-        display.println(errorMsg);
-        display.println("Please try again");
-        display.display();
+        const char* lines[] = { "Update Failed!", errorMsg.c_str(), "Please try again" };
+        showNotice(display, lines);
     }
 
 public:
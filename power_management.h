@@ -9,6 +9,7 @@
 #include <esp_sleep.h>
 #include <esp_wifi.h>
 #include <driver/rtc_io.h>
+#include "display_notice.h"
 
 // RTC memory to persist across deep sleep
 RTC_DATA_ATTR int bootCount = 0;
@@ -111,15 +112,12 @@ public:
         saveState();
         
         // Show sleep screen
-        display.clear();
-        display.setCursor(0, 0);
-        display.println("Going to sleep...");
-        display.println("Press button to wake");
-        display.display();
+        const char* lines[] = { "Going to sleep...", "Press button to wake" };
+        showNotice(display, lines);
         delay(2000);
         
         // Turn off display
-        display.powerOff();
+        displayOff(display);
         
         // Disable WiFi to save power
         WiFi.disconnect(true);
@@ -221,25 +219,19 @@ public:
     }
     
     void showBatteryWarning() {
+        char remaining[24];
+        snprintf(remaining, sizeof(remaining), "%d%% remaining", getBatteryPercent());
         if (isCriticalBattery()) {
-            display.clear();
-            display.setCursor(0, 0);
-            display.println("CRITICAL BATTERY!");
-            display.printf("%d%% remaining\n", getBatteryPercent());
-            display.println("Please charge now");
-            display.display();
+            const char* lines[] = { "CRITICAL BATTERY!", remaining, "Please charge now" };
+            showNotice(display, lines);
             
             // Force sleep to preserve battery
             delay(5000);
             enterDeepSleep("Critical battery");
         }
         else if (isLowBattery()) {
-            display.clear();
-            display.setCursor(0, 0);
-            display.println("Low Battery");
-            display.printf("%d%% remaining\n", getBatteryPercent());
-            display.println("Please charge soon");
-            display.display();
+            const char* lines[] = { "Low Battery", remaining, "Please charge soon" };
+            showNotice(display, lines);
             delay(3000);
         }
     }
@@ -264,23 +256,14 @@ private:
     }
     
     void showWakeAnimation() {
-        display.clear();
-        display.setCursor(0, 0);
-        display.println("⚡ VOLT");
-        display.println("Waking up...");
-        display.display();
+        const char* lines[] = { "⚡ VOLT", "Waking up..." };
+        showNotice(display, lines);
         delay(1000);
     }
     
     void showWelcomeScreen() {
-        display.clear();
-        display.setCursor(0, 0);
-        display.println("⚡ VOLT v5.00");
-        display.println("AI Companion Watch");
-        display.println("for Stone");
-        display.println("");
-        display.println("Made with 💙 by Dad");
-        display.display();
+        const char* lines[] = { "⚡ VOLT v5.00", "AI Companion Watch", "for Stone", "", "Made with 💙 by Dad" };
+        showNotice(display, lines);
         delay(3000);
     }
     
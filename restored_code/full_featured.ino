@@ -4,10 +4,6 @@
 #include <Adafruit_SSD1306.h>
 
 #include "config.h"
-#include "power_management.h"
-#include "watchdog.h"
-#include "ota_update.h"
-#include "VoltAI.h"
 
 // Hardware Configuration
 #define SCREEN_WIDTH 128
@@ -15,6 +11,12 @@
 #define OLED_RESET -1
 Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET);
 
+// The modules draw their notices on display (display_notice.h)
+#include "power_management.h"
+#include "watchdog.h"
+#include "ota_update.h"
+#include "VoltAI.h"
+
 #define BUTTON_PIN 0
 #define LED_PIN 2
 
@@ -8,6 +8,8 @@
 
 #include <esp_task_wdt.h>
 #include <esp_system.h>
+#include <esp_heap_caps.h>
+#include "display_notice.h"
 
 #define WDT_TIMEOUT 30  // 30 seconds timeout
 
@@ -117,13 +119,8 @@ public:
         logCrash("PANIC");
         
         // Show crash screen
-        display.clear();
-        display.setCursor(0, 0);
-        display.println("VOLT Recovered");
-        display.println("from crash");
-        display.println("");
-        display.println("Everything is OK now");
-        display.display();
+        const char* lines[] = { "VOLT Recovered", "from crash", "", "Everything is OK now" };
+        showNotice(display, lines);
         delay(3000);
         
         // Clear crash flag
@@ -138,12 +135,8 @@ public:
         logCrash("WATCHDOG");
         
         // Show recovery screen
-        display.clear();
-        display.setCursor(0, 0);
-        display.println("VOLT Restarted");
-        display.println("");
-        display.println("System recovered");
-        display.display();
+        const char* lines[] = { "VOLT Restarted", "", "System recovered" };
+        showNotice(display, lines);
         delay(2000);
         
         // Reset to safe state
@@ -157,12 +150,8 @@ public:
         logCrash("BROWNOUT");
         
         // Show low power warning
-        display.clear();
-        display.setCursor(0, 0);
-        display.println("Low Power Detected");
-        display.println("");
-        display.println("Please charge VOLT");
-        display.display();
+        const char* lines[] = { "Low Power Detected", "", "Please charge VOLT" };
+        showNotice(display, lines);
         delay(3000);
     }
     
@@ -175,6 +164,10 @@ public:
         crashReport += "Crash Type: " + String(type) + "\n";
         crashReport += "Time: " + String(millis()) + "\n";
         crashReport += "Free Heap: " + String(ESP.getFreeHeap()) + "\n";
+        // Free heap alone hides fragmentation: a big buffer needs
+        // the largest block
+        crashReport += "Largest Free Block: " + String(heap_caps_get_largest_free_block(MALLOC_CAP_8BIT)) + "\n";
+        crashReport += "Min Free Heap: " + String(ESP.getMinFreeHeap()) + "\n";
         crashReport += "Boot Count: " + String(bootCount) + "\n";
         
         // Save to file